@@ -0,0 +1,578 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * See TCPBenchmark.h.  The three tests use their own server port:
+ * - benchSINK_PORT: the server reads and discards all data.
+ * - benchECHO_PORT: the server sends back all data that it receives.
+ * - benchCLOSE_PORT: the server closes every connection as soon as it has been
+ *   accepted.
+ * All times are measured with the tick count of the device.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "TCPBenchmark.h"
+
+/* The total number of bytes sent in the throughput test. */
+#ifndef benchBULK_BYTES
+	#define benchBULK_BYTES			( 4u * 1024u * 1024u )
+#endif
+
+/* The number of request/response transactions, and the size of a request. */
+#ifndef benchTRANSACTIONS
+	#define benchTRANSACTIONS		( 1000u )
+#endif
+
+#ifndef benchREQUEST_SIZE
+	#define benchREQUEST_SIZE		( 64u )
+#endif
+
+/* The number of connections that are set up and closed. */
+#ifndef benchCONNECTIONS
+	#define benchCONNECTIONS		( 200u )
+#endif
+
+/* The backlog of the listening sockets.  A server handles one connection at a
+time, and when the last ACK of a close gets lost, it waits for the hang
+protection to close the connection.  The client meanwhile continues with new
+connections, which must fit in the backlog. */
+#ifndef benchBACKLOG
+	#define benchBACKLOG			( 4 )
+#endif
+
+/* When non-zero, the sink server checks the contents of the data that it
+receives in the throughput test, and counts a corrupted stream as an error. */
+#ifndef benchCHECK_DATA
+	#define benchCHECK_DATA			( 1 )
+#endif
+
+/* When non-zero, the sink server reads the data in place with
+FreeRTOS_recv_spans() and FreeRTOS_recv_consume(), in stead of copying it with
+FreeRTOS_recv(). */
+#ifndef benchRECV_SPANS
+	#define benchRECV_SPANS			( 0 )
+#endif
+
+/* The byte at offset 'n' of the bulk data is 'n % benchPATTERN_PERIOD'.  A
+prime number, so that data at a wrong offset is also detected. */
+#define benchPATTERN_PERIOD			( 251u )
+
+#define benchSINK_PORT				( 5001u )
+#define benchECHO_PORT				( 5002u )
+#define benchCLOSE_PORT				( 5003u )
+
+/* The size of the buffers passed to FreeRTOS_send() and FreeRTOS_recv(). */
+#define benchBUFFER_SIZE			( 4u * ipconfigTCP_MSS )
+
+/* The send and receive time-out of all sockets, in ms.  When it expires, the
+operation is counted as an error. */
+#ifndef benchTIME_OUT_MS
+	#define benchTIME_OUT_MS		( 10000u )
+#endif
+
+/* The time to wait for the peer to close a connection, in ms. */
+#ifndef benchSHUTDOWN_TIME_OUT_MS
+	#define benchSHUTDOWN_TIME_OUT_MS	( 5000u )
+#endif
+
+#define benchTIME_OUT				pdMS_TO_TICKS( benchTIME_OUT_MS )
+#define benchSHUTDOWN_TIME_OUT		pdMS_TO_TICKS( benchSHUTDOWN_TIME_OUT_MS )
+
+#define benchTICKS_TO_MS( xTicks )	( ( uint32_t ) ( xTicks ) * ( uint32_t ) portTICK_PERIOD_MS )
+
+typedef enum
+{
+	eBenchSink,
+	eBenchEcho,
+	eBenchClose
+} eBenchServerMode_t;
+
+typedef struct xBENCH_SERVER
+{
+	uint16_t usPort;
+	eBenchServerMode_t eMode;
+} BenchServer_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * A server task, pvParameters points to a BenchServer_t.
+ */
+static void prvServerTask( void *pvParameters );
+
+/*
+ * The task that runs the tests.
+ */
+static void prvClientTask( void *pvParameters );
+
+/*
+ * Create a socket with the time-outs of the benchmark, and connect it to
+ * 'usPort' on the device's own IP address.  Returns NULL on failure.
+ */
+static Socket_t prvConnect( uint16_t usPort );
+
+/*
+ * Shut down the connection, wait for the peer to close it as well, and close
+ * the socket.
+ */
+static void prvGracefulClose( Socket_t xSocket );
+
+/*
+ * Check received bulk data against the pattern, 'ulOffset' is the offset of
+ * the first byte within the stream.  Returns pdFALSE when the data is wrong.
+ */
+static BaseType_t prvCheckPattern( const char *pcData, BaseType_t xLength, uint32_t ulOffset );
+
+#if( benchRECV_SPANS != 0 )
+	/*
+	 * Receive the data of the sink server without copying it, check it when
+	 * '*pxCorrupted' is still pdFALSE, and consume it.  Returns the same as
+	 * FreeRTOS_recv().
+	 */
+	static BaseType_t prvReceiveSpans( Socket_t xSocket, uint32_t ulOffset, BaseType_t *pxCorrupted );
+#endif /* benchRECV_SPANS */
+
+/*
+ * The tests, each of them fills in its part of xResults.
+ */
+static void prvBulkTest( void );
+static void prvLatencyTest( void );
+static void prvConnectionTest( void );
+
+/*-----------------------------------------------------------*/
+
+static const BenchServer_t xServers[] =
+{
+	{ benchSINK_PORT, eBenchSink },
+	{ benchECHO_PORT, eBenchEcho },
+	{ benchCLOSE_PORT, eBenchClose }
+};
+
+static TCPBenchmarkResults_t xResults;
+
+/* Used by the client task only, the server tasks have their own buffer on the
+stack. */
+static char cClientBuffer[ benchBUFFER_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+void vStartTCPBenchmarkTasks( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority )
+{
+BaseType_t x;
+
+	for( x = 0; x < ( BaseType_t ) ( sizeof( xServers ) / sizeof( xServers[ 0 ] ) ); x++ )
+	{
+		xTaskCreate( prvServerTask, "BenchServer", usTaskStackSize, ( void * ) &( xServers[ x ] ), uxTaskPriority, NULL );
+	}
+
+	xTaskCreate( prvClientTask, "BenchClient", usTaskStackSize, NULL, uxTaskPriority, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvGracefulClose( Socket_t xSocket )
+{
+TimeOut_t xTimeOut;
+TickType_t xTicksToWait = benchSHUTDOWN_TIME_OUT;
+char cDummy[ 64 ];
+
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+	vTaskSetTimeOutState( &xTimeOut );
+
+	/* FreeRTOS_recv() returns a negative value once the peer has closed the
+	connection as well. */
+	while( FreeRTOS_recv( xSocket, cDummy, sizeof( cDummy ), 0 ) >= 0 )
+	{
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			xResults.ulErrors++;
+			break;
+		}
+	}
+
+	FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvServerTask( void *pvParameters )
+{
+const BenchServer_t *pxServer = ( const BenchServer_t * ) pvParameters;
+Socket_t xListeningSocket, xConnectedSocket;
+struct freertos_sockaddr xAddress;
+socklen_t xAddressLength = sizeof( xAddress );
+static const TickType_t xAcceptTimeOut = portMAX_DELAY;
+const TickType_t xTimeOut = benchTIME_OUT;
+char cBuffer[ benchBUFFER_SIZE ];
+BaseType_t xReceived, xSent, xOffset, xCorrupted;
+uint32_t ulReceived;
+
+	xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+	FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xAcceptTimeOut, sizeof( xAcceptTimeOut ) );
+
+	memset( &xAddress, '\0', sizeof( xAddress ) );
+	xAddress.sin_port = FreeRTOS_htons( pxServer->usPort );
+	FreeRTOS_bind( xListeningSocket, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListeningSocket, benchBACKLOG );
+
+	for( ;; )
+	{
+		xConnectedSocket = FreeRTOS_accept( xListeningSocket, &xAddress, &xAddressLength );
+
+		if( ( xConnectedSocket == NULL ) || ( xConnectedSocket == FREERTOS_INVALID_SOCKET ) )
+		{
+			continue;
+		}
+
+		FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		if( pxServer->eMode != eBenchClose )
+		{
+			ulReceived = 0u;
+			xCorrupted = pdFALSE;
+
+			/* Serve the client until it closes the connection. */
+			for( ;; )
+			{
+				#if( benchRECV_SPANS != 0 )
+				if( pxServer->eMode == eBenchSink )
+				{
+					xReceived = prvReceiveSpans( xConnectedSocket, ulReceived, &xCorrupted );
+				}
+				else
+				#endif /* benchRECV_SPANS */
+				{
+					xReceived = FreeRTOS_recv( xConnectedSocket, cBuffer, sizeof( cBuffer ), 0 );
+				}
+
+				if( xReceived < 0 )
+				{
+					break;
+				}
+
+				/* prvReceiveSpans() has checked the data in place. */
+				if( ( benchCHECK_DATA != 0 ) && ( benchRECV_SPANS == 0 ) && ( pxServer->eMode == eBenchSink ) && ( xCorrupted == pdFALSE ) )
+				{
+					if( prvCheckPattern( cBuffer, xReceived, ulReceived ) == pdFALSE )
+					{
+						/* Count it once. */
+						xCorrupted = pdTRUE;
+						xResults.ulErrors++;
+					}
+				}
+
+				ulReceived += ( uint32_t ) xReceived;
+
+				if( pxServer->eMode == eBenchEcho )
+				{
+					for( xOffset = 0; xOffset < xReceived; xOffset += xSent )
+					{
+						xSent = FreeRTOS_send( xConnectedSocket, &( cBuffer[ xOffset ] ), ( size_t ) ( xReceived - xOffset ), 0 );
+
+						if( xSent <= 0 )
+						{
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		prvGracefulClose( xConnectedSocket );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static Socket_t prvConnect( uint16_t usPort )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+const TickType_t xTimeOut = benchTIME_OUT;
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+	if( xSocket == FREERTOS_INVALID_SOCKET )
+	{
+		xSocket = NULL;
+	}
+	else
+	{
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		xAddress.sin_addr = FreeRTOS_GetIPAddress();
+		xAddress.sin_port = FreeRTOS_htons( usPort );
+
+		if( FreeRTOS_connect( xSocket, &xAddress, sizeof( xAddress ) ) != 0 )
+		{
+			FreeRTOS_closesocket( xSocket );
+			xSocket = NULL;
+		}
+	}
+
+	if( xSocket == NULL )
+	{
+		xResults.ulErrors++;
+	}
+
+	return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCheckPattern( const char *pcData, BaseType_t xLength, uint32_t ulOffset )
+{
+BaseType_t xIndex;
+uint32_t ulExpected = ulOffset % benchPATTERN_PERIOD;
+BaseType_t xReturn = pdTRUE;
+
+	for( xIndex = 0; xIndex < xLength; xIndex++ )
+	{
+		if( ( uint8_t ) pcData[ xIndex ] != ( uint8_t ) ulExpected )
+		{
+			xReturn = pdFALSE;
+			break;
+		}
+
+		ulExpected++;
+
+		if( ulExpected == benchPATTERN_PERIOD )
+		{
+			ulExpected = 0u;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( benchRECV_SPANS != 0 )
+
+	static BaseType_t prvReceiveSpans( Socket_t xSocket, uint32_t ulOffset, BaseType_t *pxCorrupted )
+	{
+	FreeRTOS_iovec_t xSpans[ 2 ];
+	BaseType_t xReceived;
+
+		xReceived = FreeRTOS_recv_spans( xSocket, xSpans, 0 );
+
+		if( xReceived > 0 )
+		{
+			if( ( benchCHECK_DATA != 0 ) && ( *pxCorrupted == pdFALSE ) )
+			{
+				/* The second span continues where the first one ends. */
+				if( ( ( BaseType_t ) ( xSpans[ 0 ].uxLength + xSpans[ 1 ].uxLength ) != xReceived ) ||
+					( prvCheckPattern( ( const char * ) xSpans[ 0 ].pvBase, ( BaseType_t ) xSpans[ 0 ].uxLength, ulOffset ) == pdFALSE ) ||
+					( prvCheckPattern( ( const char * ) xSpans[ 1 ].pvBase, ( BaseType_t ) xSpans[ 1 ].uxLength, ulOffset + ( uint32_t ) xSpans[ 0 ].uxLength ) == pdFALSE ) )
+				{
+					/* Count it once. */
+					*pxCorrupted = pdTRUE;
+					xResults.ulErrors++;
+				}
+			}
+
+			if( FreeRTOS_recv_consume( xSocket, ( size_t ) xReceived ) != xReceived )
+			{
+				xResults.ulErrors++;
+			}
+		}
+
+		return xReceived;
+	}
+
+#endif /* benchRECV_SPANS */
+/*-----------------------------------------------------------*/
+
+static void prvBulkTest( void )
+{
+Socket_t xSocket;
+TickType_t xStartTime;
+uint32_t ulRemaining = benchBULK_BYTES;
+uint32_t ulLength;
+BaseType_t xSent;
+const uint32_t ulMaxLength = sizeof( cClientBuffer ) - benchPATTERN_PERIOD;
+
+	xSocket = prvConnect( benchSINK_PORT );
+
+	if( xSocket != NULL )
+	{
+		xStartTime = xTaskGetTickCount();
+
+		while( ulRemaining != 0u )
+		{
+			/* cClientBuffer holds the pattern, start at the right phase. */
+			ulLength = ( ulRemaining < ulMaxLength ) ? ulRemaining : ulMaxLength;
+			xSent = FreeRTOS_send( xSocket, &( cClientBuffer[ ( benchBULK_BYTES - ulRemaining ) % benchPATTERN_PERIOD ] ), ulLength, 0 );
+
+			if( xSent <= 0 )
+			{
+				xResults.ulErrors++;
+				break;
+			}
+
+			ulRemaining -= ( uint32_t ) xSent;
+		}
+
+		/* The data has arrived when the server has seen the end of the
+		stream and closes its side. */
+		prvGracefulClose( xSocket );
+
+		xResults.ulBulkBytes = benchBULK_BYTES - ulRemaining;
+		xResults.ulBulkTimeMs = benchTICKS_TO_MS( xTaskGetTickCount() - xStartTime );
+
+		if( xResults.ulBulkTimeMs != 0u )
+		{
+			/* Bits per ms is kbit/s. */
+			xResults.ulBulkKbps = ( uint32_t ) ( ( ( uint64_t ) xResults.ulBulkBytes * 8u ) / xResults.ulBulkTimeMs );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvLatencyTest( void )
+{
+Socket_t xSocket;
+TickType_t xStartTime;
+uint32_t ulCount;
+BaseType_t xReceived, xTotal;
+
+	xSocket = prvConnect( benchECHO_PORT );
+
+	if( xSocket != NULL )
+	{
+		xStartTime = xTaskGetTickCount();
+
+		for( ulCount = 0u; ulCount < benchTRANSACTIONS; ulCount++ )
+		{
+			if( FreeRTOS_send( xSocket, cClientBuffer, benchREQUEST_SIZE, 0 ) != ( BaseType_t ) benchREQUEST_SIZE )
+			{
+				xResults.ulErrors++;
+				break;
+			}
+
+			for( xTotal = 0; xTotal < ( BaseType_t ) benchREQUEST_SIZE; xTotal += xReceived )
+			{
+				xReceived = FreeRTOS_recv( xSocket, &( cClientBuffer[ xTotal ] ), benchREQUEST_SIZE - ( size_t ) xTotal, 0 );
+
+				if( xReceived <= 0 )
+				{
+					break;
+				}
+			}
+
+			if( xTotal != ( BaseType_t ) benchREQUEST_SIZE )
+			{
+				xResults.ulErrors++;
+				break;
+			}
+		}
+
+		xResults.ulTransactions = ulCount;
+		xResults.ulTransactionTimeMs = benchTICKS_TO_MS( xTaskGetTickCount() - xStartTime );
+
+		if( ulCount != 0u )
+		{
+			xResults.ulLatencyUs = ( uint32_t ) ( ( ( uint64_t ) xResults.ulTransactionTimeMs * 1000u ) / ulCount );
+		}
+
+		prvGracefulClose( xSocket );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvConnectionTest( void )
+{
+Socket_t xSocket;
+TickType_t xStartTime;
+uint32_t ulCount;
+
+	xStartTime = xTaskGetTickCount();
+
+	for( ulCount = 0u; ulCount < benchCONNECTIONS; ulCount++ )
+	{
+		xSocket = prvConnect( benchCLOSE_PORT );
+
+		if( xSocket == NULL )
+		{
+			break;
+		}
+
+		prvGracefulClose( xSocket );
+	}
+
+	xResults.ulConnections = ulCount;
+	xResults.ulConnectionTimeMs = benchTICKS_TO_MS( xTaskGetTickCount() - xStartTime );
+
+	if( xResults.ulConnectionTimeMs != 0u )
+	{
+		xResults.ulConnectionsPerSecond = ( uint32_t ) ( ( ( uint64_t ) ulCount * 1000u ) / xResults.ulConnectionTimeMs );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void *pvParameters )
+{
+uint32_t ulIndex;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 100u ) );
+	}
+
+	for( ulIndex = 0u; ulIndex < sizeof( cClientBuffer ); ulIndex++ )
+	{
+		cClientBuffer[ ulIndex ] = ( char ) ( ulIndex % benchPATTERN_PERIOD );
+	}
+
+	prvBulkTest();
+	prvLatencyTest();
+	prvConnectionTest();
+
+	FreeRTOS_printf( ( "TCP benchmark: %lu bytes in %lu ms, %lu kbit/s\n",
+		( unsigned long ) xResults.ulBulkBytes, ( unsigned long ) xResults.ulBulkTimeMs, ( unsigned long ) xResults.ulBulkKbps ) );
+	FreeRTOS_printf( ( "TCP benchmark: %lu transactions in %lu ms, %lu us each\n",
+		( unsigned long ) xResults.ulTransactions, ( unsigned long ) xResults.ulTransactionTimeMs, ( unsigned long ) xResults.ulLatencyUs ) );
+	FreeRTOS_printf( ( "TCP benchmark: %lu connections in %lu ms, %lu per second, %lu errors\n",
+		( unsigned long ) xResults.ulConnections, ( unsigned long ) xResults.ulConnectionTimeMs,
+		( unsigned long ) xResults.ulConnectionsPerSecond, ( unsigned long ) xResults.ulErrors ) );
+
+	vApplicationTCPBenchmarkHook( &xResults );
+
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,71 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef TCP_BENCHMARK_H
+#define TCP_BENCHMARK_H
+
+/*
+ * A benchmark of the TCP stack itself.  A client task connects to server tasks
+ * on the same device, through the device's own IP address.  Together with the
+ * loopback network interface (portable/NetworkInterface/loopback) no other
+ * device and no network hardware are needed, and the results only depend on
+ * the stack and on the configuration of the simulated link.
+ *
+ * Three tests are run one after the other:
+ * - bulk throughput: benchBULK_BYTES are sent over one connection.  The
+ *   server checks their contents, unless benchCHECK_DATA is 0.
+ * - request/response latency: benchTRANSACTIONS times, a request of
+ *   benchREQUEST_SIZE bytes is sent and echoed back.
+ * - connection rate: benchCONNECTIONS connections are set up and closed.
+ */
+
+typedef struct xTCP_BENCHMARK_RESULTS
+{
+	uint32_t ulBulkBytes;				/* The number of bytes sent in the throughput test */
+	uint32_t ulBulkTimeMs;				/* The time it took to send them and to close the connection */
+	uint32_t ulBulkKbps;				/* The throughput in kbit/s */
+	uint32_t ulTransactions;			/* The number of request/response transactions */
+	uint32_t ulTransactionTimeMs;		/* The time it took to complete all transactions */
+	uint32_t ulLatencyUs;				/* The average time of a transaction in us */
+	uint32_t ulConnections;				/* The number of connections that were set up and closed */
+	uint32_t ulConnectionTimeMs;		/* The time it took to set up and close them */
+	uint32_t ulConnectionsPerSecond;
+	uint32_t ulErrors;					/* The number of operations that failed */
+} TCPBenchmarkResults_t;
+
+/*
+ * Create the server tasks and the client task.  The client waits until the
+ * network is up, runs the tests, and passes the results to
+ * vApplicationTCPBenchmarkHook().
+ */
+void vStartTCPBenchmarkTasks( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority );
+
+/*
+ * Must be provided by the application.  Called by the client task when all
+ * tests have finished.
+ */
+void vApplicationTCPBenchmarkHook( const TCPBenchmarkResults_t *pxResults );
+
+#endif /* TCP_BENCHMARK_H */
@@ -57,6 +57,12 @@ entry is still valid and can therefore be refreshed. */
 	#define arpGRATUITOUS_ARP_PERIOD					( pdMS_TO_TICKS( 20000 ) )
 #endif
 
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* The period of the timer that checks the age of the packets that wait
+	for an ARP reply. */
+	#define arpPENDING_TIMER_PERIOD_MS					( 500u )
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -64,11 +70,104 @@ entry is still valid and can therefore be refreshed. */
  */
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress );
 
+/*
+ * Send an ARP request for 'ulIPAddress'.  The request is broadcast, unless
+ * 'pxMACAddress' is given.
+ */
+static void prvOutputARPRequest( uint32_t ulIPAddress, const MACAddress_t *pxMACAddress );
+
+#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+	/*
+	 * Return the first slot that will be probed for an IP- or MAC-address.
+	 */
+	static BaseType_t prvARPHashIP( uint32_t ulIPAddress );
+	static BaseType_t prvARPHashMAC( const MACAddress_t * pxMACAddress );
+
+	/*
+	 * Return the first slot that will be probed for the IP- or MAC-address of
+	 * row 'xEntry'.
+	 */
+	static BaseType_t prvARPHomeSlot( BaseType_t xTable, BaseType_t xEntry );
+
+	/*
+	 * Find the row in xARPCache[] that holds 'ulIPAddress', or -1.
+	 */
+	static BaseType_t prvARPFindIP( uint32_t ulIPAddress );
+
+	/*
+	 * Find a valid row in xARPCache[] with the given MAC-address, or -1.  When
+	 * 'ulIPAddress' is non-zero, the row must belong to a different IP-address,
+	 * as is required by vARPRefreshCacheEntry().
+	 */
+	static BaseType_t prvARPFindMAC( const MACAddress_t * pxMACAddress, uint32_t ulIPAddress );
+
+	/*
+	 * Add a row to, or remove a row from the hash tables.  A row is indexed
+	 * on its IP-address when the address is non-zero, and also on its
+	 * MAC-address when it is valid.  A row must be removed before any of
+	 * these fields are changed, and inserted again afterwards.
+	 */
+	static void prvARPIndexInsert( BaseType_t xEntry );
+	static void prvARPIndexRemove( BaseType_t xEntry );
+	static void prvARPSlotInsert( BaseType_t xTable, BaseType_t xEntry );
+	static void prvARPSlotRemove( BaseType_t xTable, BaseType_t xEntry );
+
+	/*
+	 * Move a row to the front (most recently used) or to the back (the first
+	 * to be re-used) of the LRU list.
+	 */
+	static void prvARPMoveToFront( BaseType_t xEntry );
+	static void prvARPMoveToBack( BaseType_t xEntry );
+
+	/*
+	 * Get a row that can be used for a new entry: an unused row, or else the
+	 * least recently used one.  The caller must remove the row from the hash
+	 * tables before it is changed.
+	 */
+	static BaseType_t prvARPGetFreeEntry( void );
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/*
+	 * Send the waiting packets whose destination has just been resolved.
+	 * Called when an entry in the ARP cache becomes valid.
+	 */
+	static void prvARPPendingFlush( void );
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 /*-----------------------------------------------------------*/
 
 /* The ARP cache. */
 static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
 
+#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+	/* The hash tables that index xARPCache[] on IP-address and MAC-address.
+	Linear probing is used.  A slot contains the row number plus one, zero
+	means that the slot is empty. */
+	#define arpHASH_BY_IP		0
+	#define arpHASH_BY_MAC		1
+	static uint16_t usARPHashTable[ 2 ][ ipconfigARP_HASH_TABLE_SIZE ];
+
+	/* A doubly linked list of the rows in use, ordered from most to least
+	recently used.  Element 0 is the head of the list, the row numbers are
+	stored plus one. */
+	static uint16_t usARPNext[ ipconfigARP_CACHE_ENTRIES + 1 ];
+	static uint16_t usARPPrevious[ ipconfigARP_CACHE_ENTRIES + 1 ];
+
+	/* Rows with a lower index than this are linked in the LRU list. */
+	static BaseType_t xARPEntriesUsed = 0;
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* Network buffers that wait for an ARP reply, linked through their
+	'xBufferListItem' in the order in which they were sent.  The value of the
+	list item holds the time at which the packet was queued. */
+	static List_t xARPPendingList;
+
+	/* Statistics, see FreeRTOS_GetARPPendingStats(). */
+	static ARPPendingStats_t xARPPendingStats;
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 /* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
 to ensure ARP tables are up to date and to detect IP address conflicts. */
 static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
@@ -105,6 +204,322 @@ static const uint8_t xDefaultPartARPPacketHeader[] =
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+
+	static BaseType_t prvARPHashIP( uint32_t ulIPAddress )
+	{
+	uint32_t ulHash = ulIPAddress;
+
+		/* Mix the bits: depending on the byte order, the distinctive part of
+		the address is stored in the high or in the low bits. */
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x45d9f3bUL;
+		ulHash ^= ulHash >> 16;
+
+		return ( BaseType_t ) ( ulHash % ( uint32_t ) ipconfigARP_HASH_TABLE_SIZE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPHashMAC( const MACAddress_t * pxMACAddress )
+	{
+	uint32_t ulHash;
+
+		/* The last 4 bytes of a MAC-address are the most distinctive, the
+		first 3 bytes identify the manufacturer. */
+		ulHash = ( ( ( uint32_t ) pxMACAddress->ucBytes[ 2 ] ) << 24 ) |
+				 ( ( ( uint32_t ) pxMACAddress->ucBytes[ 3 ] ) << 16 ) |
+				 ( ( ( uint32_t ) pxMACAddress->ucBytes[ 4 ] ) << 8 ) |
+				   ( ( uint32_t ) pxMACAddress->ucBytes[ 5 ] );
+		ulHash ^= ( ( ( uint32_t ) pxMACAddress->ucBytes[ 0 ] ) << 8 ) | ( ( uint32_t ) pxMACAddress->ucBytes[ 1 ] );
+
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x45d9f3bUL;
+		ulHash ^= ulHash >> 16;
+
+		return ( BaseType_t ) ( ulHash % ( uint32_t ) ipconfigARP_HASH_TABLE_SIZE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPHomeSlot( BaseType_t xTable, BaseType_t xEntry )
+	{
+	BaseType_t xSlot;
+
+		if( xTable == arpHASH_BY_IP )
+		{
+			xSlot = prvARPHashIP( xARPCache[ xEntry ].ulIPAddress );
+		}
+		else
+		{
+			xSlot = prvARPHashMAC( &( xARPCache[ xEntry ].xMACAddress ) );
+		}
+
+		return xSlot;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPFindIP( uint32_t ulIPAddress )
+	{
+	BaseType_t xSlot = prvARPHashIP( ulIPAddress );
+	BaseType_t xCount, xReturn = -1;
+	uint16_t usItem;
+
+		for( xCount = 0; xCount < ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE; xCount++ )
+		{
+			usItem = usARPHashTable[ arpHASH_BY_IP ][ xSlot ];
+
+			if( usItem == 0u )
+			{
+				/* An empty slot ends the search. */
+				break;
+			}
+
+			if( xARPCache[ usItem - 1u ].ulIPAddress == ulIPAddress )
+			{
+				xReturn = ( BaseType_t ) usItem - 1;
+				break;
+			}
+
+			if( ++xSlot == ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE )
+			{
+				xSlot = 0;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPFindMAC( const MACAddress_t * pxMACAddress, uint32_t ulIPAddress )
+	{
+	BaseType_t xSlot = prvARPHashMAC( pxMACAddress );
+	BaseType_t xCount, xEntry, xReturn = -1;
+	uint16_t usItem;
+
+		for( xCount = 0; xCount < ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE; xCount++ )
+		{
+			usItem = usARPHashTable[ arpHASH_BY_MAC ][ xSlot ];
+
+			if( usItem == 0u )
+			{
+				/* An empty slot ends the search. */
+				break;
+			}
+
+			xEntry = ( BaseType_t ) usItem - 1;
+
+			/* Several rows may have the same MAC-address, e.g. the address of
+			a gateway. */
+			if( ( xARPCache[ xEntry ].ulIPAddress != ulIPAddress ) &&
+				( memcmp( xARPCache[ xEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			{
+				#if( ipconfigARP_STORES_REMOTE_ADDRESSES != 0 )
+				/* If ARP stores the MAC address of IP addresses outside the
+				network, than the MAC address of the gateway should not be
+				overwritten. */
+				if( ( ulIPAddress != 0UL ) &&
+					( ( ( xARPCache[ xEntry ].ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) ) !=
+					  ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) ) ) )
+				{
+					/* One address is local and the other is not, look further. */
+				}
+				else
+				#endif /* ipconfigARP_STORES_REMOTE_ADDRESSES */
+				{
+					xReturn = xEntry;
+					break;
+				}
+			}
+
+			if( ++xSlot == ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE )
+			{
+				xSlot = 0;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPSlotInsert( BaseType_t xTable, BaseType_t xEntry )
+	{
+	BaseType_t xSlot = prvARPHomeSlot( xTable, xEntry );
+
+		/* The table is larger than the cache, so there is always a free
+		slot. */
+		while( usARPHashTable[ xTable ][ xSlot ] != 0u )
+		{
+			if( ++xSlot == ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE )
+			{
+				xSlot = 0;
+			}
+		}
+
+		usARPHashTable[ xTable ][ xSlot ] = ( uint16_t ) ( xEntry + 1 );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPSlotRemove( BaseType_t xTable, BaseType_t xEntry )
+	{
+	BaseType_t xSlot = prvARPHomeSlot( xTable, xEntry );
+	BaseType_t xNext, xHome;
+	uint16_t usItem;
+
+		/* Find the slot that refers to the row. */
+		for( ;; )
+		{
+			usItem = usARPHashTable[ xTable ][ xSlot ];
+
+			if( usItem == 0u )
+			{
+				/* The row is not in this table. */
+				return;
+			}
+
+			if( usItem == ( uint16_t ) ( xEntry + 1 ) )
+			{
+				break;
+			}
+
+			if( ++xSlot == ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE )
+			{
+				xSlot = 0;
+			}
+		}
+
+		/* Empty the slot, and move back the rows that follow it, as long as
+		they would not end up in front of their home slot.  This keeps the
+		searches correct without the need for 'deleted' markers. */
+		usARPHashTable[ xTable ][ xSlot ] = 0u;
+		xNext = xSlot;
+
+		for( ;; )
+		{
+			if( ++xNext == ( BaseType_t ) ipconfigARP_HASH_TABLE_SIZE )
+			{
+				xNext = 0;
+			}
+
+			usItem = usARPHashTable[ xTable ][ xNext ];
+
+			if( usItem == 0u )
+			{
+				break;
+			}
+
+			xHome = prvARPHomeSlot( xTable, ( BaseType_t ) usItem - 1 );
+
+			/* Can the row stay where it is?  That is when its home slot lies
+			cyclically in ( xSlot, xNext ]. */
+			if( xSlot <= xNext )
+			{
+				if( ( xHome > xSlot ) && ( xHome <= xNext ) )
+				{
+					continue;
+				}
+			}
+			else
+			{
+				if( ( xHome > xSlot ) || ( xHome <= xNext ) )
+				{
+					continue;
+				}
+			}
+
+			usARPHashTable[ xTable ][ xSlot ] = usItem;
+			usARPHashTable[ xTable ][ xNext ] = 0u;
+			xSlot = xNext;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPIndexInsert( BaseType_t xEntry )
+	{
+		if( xARPCache[ xEntry ].ulIPAddress != 0UL )
+		{
+			prvARPSlotInsert( arpHASH_BY_IP, xEntry );
+
+			if( xARPCache[ xEntry ].ucValid != ( uint8_t ) pdFALSE )
+			{
+				prvARPSlotInsert( arpHASH_BY_MAC, xEntry );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPIndexRemove( BaseType_t xEntry )
+	{
+		if( xARPCache[ xEntry ].ulIPAddress != 0UL )
+		{
+			prvARPSlotRemove( arpHASH_BY_IP, xEntry );
+
+			if( xARPCache[ xEntry ].ucValid != ( uint8_t ) pdFALSE )
+			{
+				prvARPSlotRemove( arpHASH_BY_MAC, xEntry );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPMoveToFront( BaseType_t xEntry )
+	{
+	uint16_t usItem = ( uint16_t ) ( xEntry + 1 );
+
+		/* Take the row out of the list. */
+		usARPNext[ usARPPrevious[ usItem ] ] = usARPNext[ usItem ];
+		usARPPrevious[ usARPNext[ usItem ] ] = usARPPrevious[ usItem ];
+
+		/* And insert it right after the head. */
+		usARPNext[ usItem ] = usARPNext[ 0 ];
+		usARPPrevious[ usItem ] = 0u;
+		usARPPrevious[ usARPNext[ 0 ] ] = usItem;
+		usARPNext[ 0 ] = usItem;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPMoveToBack( BaseType_t xEntry )
+	{
+	uint16_t usItem = ( uint16_t ) ( xEntry + 1 );
+
+		/* Take the row out of the list. */
+		usARPNext[ usARPPrevious[ usItem ] ] = usARPNext[ usItem ];
+		usARPPrevious[ usARPNext[ usItem ] ] = usARPPrevious[ usItem ];
+
+		/* And insert it right before the head, at the end of the list. */
+		usARPPrevious[ usItem ] = usARPPrevious[ 0 ];
+		usARPNext[ usItem ] = 0u;
+		usARPNext[ usARPPrevious[ 0 ] ] = usItem;
+		usARPPrevious[ 0 ] = usItem;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvARPGetFreeEntry( void )
+	{
+	BaseType_t xEntry;
+	uint16_t usItem;
+
+		if( xARPEntriesUsed < ( BaseType_t ) ipconfigARP_CACHE_ENTRIES )
+		{
+			/* There are rows that have never been used.  Link the next one
+			into the list, it will be moved to the front by the caller. */
+			xEntry = xARPEntriesUsed++;
+			usItem = ( uint16_t ) ( xEntry + 1 );
+			usARPNext[ usItem ] = usARPNext[ 0 ];
+			usARPPrevious[ usItem ] = 0u;
+			usARPPrevious[ usARPNext[ 0 ] ] = usItem;
+			usARPNext[ 0 ] = usItem;
+		}
+		else
+		{
+			/* Re-use the least recently used row.  Rows that were cleared
+			have been moved to the end of the list, so they come first. */
+			xEntry = ( BaseType_t ) usARPPrevious[ 0 ] - 1;
+		}
+
+		return xEntry;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
 eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
 {
 eFrameProcessingResult_t eReturn = eReleaseBuffer;
@@ -192,16 +607,32 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 	BaseType_t x;
 	uint32_t lResult = 0;
 
-		/* For each entry in the ARP cache table. */
-		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+		#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
 		{
-			if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			x = prvARPFindMAC( pxMACAddress, 0UL );
+
+			if( x >= 0 )
 			{
 				lResult = xARPCache[ x ].ulIPAddress;
+				prvARPIndexRemove( x );
 				memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
-				break;
+				prvARPMoveToBack( x );
+			}
+		}
+		#else
+		{
+			/* For each entry in the ARP cache table. */
+			for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+			{
+				if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+				{
+					lResult = xARPCache[ x ].ulIPAddress;
+					memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
+					break;
+				}
 			}
 		}
+		#endif /* ipconfigUSE_ARP_HASH_TABLE */
 
 		return lResult;
 	}
@@ -209,6 +640,8 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 #endif	/* ipconfigUSE_ARP_REMOVE_ENTRY != 0 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_ARP_HASH_TABLE == 0 )
+
 void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress )
 {
 BaseType_t x = 0;
@@ -260,6 +693,17 @@ uint8_t ucMinAgeFound = 0U;
 					is relaxed in this case and a return is permitted as an
 					optimisation. */
 					xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+
+					#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+					if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+					{
+						xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
+
+						/* Packets might be waiting for this reply. */
+						prvARPPendingFlush();
+					}
+					#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 					xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
 					return;
 				}
@@ -325,6 +769,12 @@ uint8_t ucMinAgeFound = 0U;
 		/* If the entry was not found, we use the oldest entry and set the IPaddress */
 		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
 
+		#if( ipconfigARP_REFRESH_AGE != 0 )
+		{
+			xARPCache[ xUseEntry ].ucUsed = ( uint8_t ) pdFALSE;
+		}
+		#endif
+
 		if( pxMACAddress != NULL )
 		{
 			memcpy( xARPCache[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
@@ -339,8 +789,143 @@ uint8_t ucMinAgeFound = 0U;
 			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
 			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
 		}
+
+		#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+		{
+			if( pxMACAddress != NULL )
+			{
+				/* Packets might be waiting for this entry. */
+				prvARPPendingFlush();
+			}
+		}
+		#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
 	}
 }
+
+#else /* ipconfigUSE_ARP_HASH_TABLE */
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress )
+{
+BaseType_t xIpEntry;
+BaseType_t xMacEntry = -1;
+BaseType_t xUseEntry;
+
+	#if( ipconfigARP_STORES_REMOTE_ADDRESSES == 0 )
+		/* Only process the IP address if it is on the local network.
+		Unless: when '*ipLOCAL_IP_ADDRESS_POINTER' equals zero, the IP-address
+		and netmask are still unknown. */
+		if( ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) ) ||
+			( *ipLOCAL_IP_ADDRESS_POINTER == 0ul ) )
+	#else
+		/* See the comment in the version above. */
+		if( pdTRUE )
+	#endif
+	{
+		/* Does the cache hold an entry for the IP address being queried? */
+		xIpEntry = prvARPFindIP( ulIPAddress );
+
+		if( pxMACAddress != NULL )
+		{
+			if( ( xIpEntry >= 0 ) &&
+				( memcmp( xARPCache[ xIpEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			{
+				/* This function will be called for each received packet
+				As this is by far the most common path the coding standard
+				is relaxed in this case and a return is permitted as an
+				optimisation. */
+				if( xARPCache[ xIpEntry ].ucValid == ( uint8_t ) pdFALSE )
+				{
+					/* The entry becomes valid, and will now also be indexed on
+					its MAC-address. */
+					prvARPIndexRemove( xIpEntry );
+					xARPCache[ xIpEntry ].ucValid = ( uint8_t ) pdTRUE;
+					prvARPIndexInsert( xIpEntry );
+
+					#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+					{
+						/* Packets might be waiting for this reply. */
+						prvARPPendingFlush();
+					}
+					#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+				}
+				xARPCache[ xIpEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+				prvARPMoveToFront( xIpEntry );
+				return;
+			}
+
+			/* Look for an entry with the given MAC-address, but a different
+			IP-address. */
+			xMacEntry = prvARPFindMAC( pxMACAddress, ulIPAddress );
+		}
+
+		if( xMacEntry >= 0 )
+		{
+			xUseEntry = xMacEntry;
+
+			if( xIpEntry >= 0 )
+			{
+				/* Both the MAC address as well as the IP address were found in
+				different locations: clear the entry which matches the
+				IP-address */
+				prvARPIndexRemove( xIpEntry );
+				memset( &xARPCache[ xIpEntry ], '\0', sizeof( xARPCache[ xIpEntry ] ) );
+				prvARPMoveToBack( xIpEntry );
+			}
+		}
+		else if( xIpEntry >= 0 )
+		{
+			/* An entry containing the IP-address was found, but it had a different MAC address */
+			xUseEntry = xIpEntry;
+		}
+		else
+		{
+			/* The entry was not found, use an unused entry, or else the least
+			recently used one. */
+			xUseEntry = prvARPGetFreeEntry();
+		}
+
+		/* The entry is about to change, it will be indexed again below. */
+		prvARPIndexRemove( xUseEntry );
+
+		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+
+		#if( ipconfigARP_REFRESH_AGE != 0 )
+		{
+			xARPCache[ xUseEntry ].ucUsed = ( uint8_t ) pdFALSE;
+		}
+		#endif
+
+		if( pxMACAddress != NULL )
+		{
+			memcpy( xARPCache[ xUseEntry ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
+
+			iptraceARP_TABLE_ENTRY_CREATED( ulIPAddress, (*pxMACAddress) );
+			/* And this entry does not need immediate attention */
+			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdTRUE;
+		}
+		else if( xIpEntry < 0 )
+		{
+			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_RETRANSMISSIONS;
+			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdFALSE;
+		}
+
+		prvARPIndexInsert( xUseEntry );
+		prvARPMoveToFront( xUseEntry );
+
+		#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+		{
+			if( pxMACAddress != NULL )
+			{
+				/* Packets might be waiting for this entry. */
+				prvARPPendingFlush();
+			}
+		}
+		#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+	}
+}
+
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_ARP_REVERSED_LOOKUP == 1 )
@@ -349,18 +934,32 @@ uint8_t ucMinAgeFound = 0U;
 	BaseType_t x;
 	eARPLookupResult_t eReturn = eARPCacheMiss;
 
-		/* Loop through each entry in the ARP cache. */
-		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+		#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
 		{
-			/* Does this row in the ARP cache table hold an entry for the MAC
-			address being searched? */
-			if( memcmp( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+			x = prvARPFindMAC( pxMACAddress, 0UL );
+
+			if( x >= 0 )
 			{
 				*pulIPAddress = xARPCache[ x ].ulIPAddress;
 				eReturn = eARPCacheHit;
-				break;
 			}
 		}
+		#else
+		{
+			/* Loop through each entry in the ARP cache. */
+			for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+			{
+				/* Does this row in the ARP cache table hold an entry for the MAC
+				address being searched? */
+				if( memcmp( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+				{
+					*pulIPAddress = xARPCache[ x ].ulIPAddress;
+					eReturn = eARPCacheHit;
+					break;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_ARP_HASH_TABLE */
 
 		return eReturn;
 	}
@@ -444,7 +1043,14 @@ uint32_t ulAddressToLookup;
 			{
 				eReturn = prvCacheLookup( ulAddressToLookup, pxMACAddress );
 
-				if( eReturn == eARPCacheMiss )
+				#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+					/* When an ARP request is outstanding already, the packet
+					may be held by xARPPendingAdd(), which must know the address
+					that is being resolved. */
+					if( eReturn != eARPCacheHit )
+				#else
+					if( eReturn == eARPCacheMiss )
+				#endif
 				{
 					/* It might be that the ARP has to go to the gateway. */
 					*pulIPAddress = ulAddressToLookup;
@@ -458,6 +1064,43 @@ uint32_t ulAddressToLookup;
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+
+static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress )
+{
+BaseType_t x;
+eARPLookupResult_t eReturn = eARPCacheMiss;
+
+	x = prvARPFindIP( ulAddressToLookup );
+
+	if( x >= 0 )
+	{
+		if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+		{
+			/* This entry is waiting an ARP reply, so is not valid. */
+			eReturn = eCantSendPacket;
+		}
+		else
+		{
+			/* A valid entry was found. */
+			memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+			eReturn = eARPCacheHit;
+			prvARPMoveToFront( x );
+
+			#if( ipconfigARP_REFRESH_AGE != 0 )
+			{
+				/* The entry is being used, it is worth refreshing. */
+				xARPCache[ x ].ucUsed = ( uint8_t ) pdTRUE;
+			}
+			#endif
+		}
+	}
+
+	return eReturn;
+}
+
+#else /* ipconfigUSE_ARP_HASH_TABLE */
+
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress )
 {
 BaseType_t x;
@@ -481,6 +1124,13 @@ eARPLookupResult_t eReturn = eARPCacheMiss;
 				/* A valid entry was found. */
 				memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
 				eReturn = eARPCacheHit;
+
+				#if( ipconfigARP_REFRESH_AGE != 0 )
+				{
+					/* The entry is being used, it is worth refreshing. */
+					xARPCache[ x ].ucUsed = ( uint8_t ) pdTRUE;
+				}
+				#endif
 			}
 			break;
 		}
@@ -488,12 +1138,21 @@ eARPLookupResult_t eReturn = eARPCacheMiss;
 
 	return eReturn;
 }
+
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
 /*-----------------------------------------------------------*/
 
 void vARPAgeCache( void )
 {
 BaseType_t x;
 TickType_t xTimeNow;
+#if( ipconfigARP_REFRESH_AGE != 0 )
+	/* The number of requests that may still be sent in this period to
+	refresh entries, so that entries which get old at the same time do not
+	cause a burst of ARP requests.  The last requests for entries that are
+	about to expire are never held back. */
+	UBaseType_t uxRequestsLeft = ( UBaseType_t ) ipconfigARP_MAX_REQUESTS_PER_PERIOD;
+#endif
 
 	/* Loop through each entry in the ARP cache. */
 	for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
@@ -516,8 +1175,25 @@ TickType_t xTimeNow;
 				/* This entry will get removed soon.  See if the MAC address is
 				still valid to prevent this happening. */
 				iptraceARP_TABLE_ENTRY_WILL_EXPIRE( xARPCache[ x ].ulIPAddress );
+
 				FreeRTOS_OutputARPRequest( xARPCache[ x ].ulIPAddress );
 			}
+		#if( ipconfigARP_REFRESH_AGE != 0 )
+			else if( ( xARPCache[ x ].ucUsed != ( uint8_t ) pdFALSE ) &&
+					 ( xARPCache[ x ].ucAge <= ( uint8_t ) ipconfigARP_REFRESH_AGE ) &&
+					 ( uxRequestsLeft != 0u ) )
+			{
+				/* Packets are being sent to this address.  Ask the owner to
+				confirm its MAC-address while the entry is still valid, so
+				that the traffic is never held up by an expired entry.  The
+				request is sent directly to the known MAC-address.  The reply
+				will reset the age, and the entry will only be refreshed again
+				when it has been used in the mean time. */
+				xARPCache[ x ].ucUsed = ( uint8_t ) pdFALSE;
+				uxRequestsLeft--;
+				prvOutputARPRequest( xARPCache[ x ].ulIPAddress, &( xARPCache[ x ].xMACAddress ) );
+			}
+		#endif /* ipconfigARP_REFRESH_AGE */
 			else
 			{
 				/* The age has just ticked down, with nothing to do. */
@@ -527,6 +1203,16 @@ TickType_t xTimeNow;
 			{
 				/* The entry is no longer valid.  Wipe it out. */
 				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
+
+				#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+				{
+					/* Remove it from the index before the IP-address is
+					cleared, and let it be the first to be re-used. */
+					prvARPIndexRemove( x );
+					prvARPMoveToBack( x );
+				}
+				#endif /* ipconfigUSE_ARP_HASH_TABLE */
+
 				xARPCache[ x ].ulIPAddress = 0UL;
 			}
 		}
@@ -554,6 +1240,12 @@ void vARPSendGratuitous( void )
 
 /*-----------------------------------------------------------*/
 void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+	prvOutputARPRequest( ulIPAddress, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvOutputARPRequest( uint32_t ulIPAddress, const MACAddress_t *pxMACAddress )
 {
 NetworkBufferDescriptor_t *pxNetworkBuffer;
 
@@ -566,6 +1258,12 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		pxNetworkBuffer->ulIPAddress = ulIPAddress;
 		vARPGenerateRequestPacket( pxNetworkBuffer );
 
+		if( pxMACAddress != NULL )
+		{
+			/* Send the request to a single host, in stead of broadcasting it. */
+			memcpy( ( ( ARPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xEthernetHeader.xDestinationAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) );
+		}
+
 		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
 		{
 			if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
@@ -640,9 +1338,175 @@ ARPPacket_t *pxARPPacket;
 void FreeRTOS_ClearARP( void )
 {
 	memset( xARPCache, '\0', sizeof( xARPCache ) );
+
+	#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+	{
+		/* All rows become unused again. */
+		memset( usARPHashTable, '\0', sizeof( usARPHashTable ) );
+		memset( usARPNext, '\0', sizeof( usARPNext ) );
+		memset( usARPPrevious, '\0', sizeof( usARPPrevious ) );
+		xARPEntriesUsed = 0;
+	}
+	#endif /* ipconfigUSE_ARP_HASH_TABLE */
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	void vARPPendingInit( void )
+	{
+		vListInitialise( &xARPPendingList );
+	}
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	BaseType_t xARPPendingAdd( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulLookupAddress )
+	{
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t * ) listGET_END_MARKER( &xARPPendingList );
+	const ListItem_t *pxIterator;
+	const NetworkBufferDescriptor_t *pxWaiting;
+	UBaseType_t uxCount = 0u;
+	MACAddress_t xMACAddress;
+	BaseType_t xReturn = pdFALSE;
+
+		/* Only hold the packet while an ARP request for 'ulLookupAddress' is
+		outstanding: the reply to that request will release it. */
+		if( prvCacheLookup( ulLookupAddress, &xMACAddress ) == eCantSendPacket )
+		{
+			/* Make space by dropping the packets that are too old. */
+			( void ) xARPPendingAgeing();
+
+			/* Count the packets that wait for the same destination. */
+			for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( const ListItem_t * ) pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				pxWaiting = ( const NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				if( pxWaiting->ulIPAddress == pxNetworkBuffer->ulIPAddress )
+				{
+					uxCount++;
+				}
+			}
+
+			if( ( listCURRENT_LIST_LENGTH( &xARPPendingList ) >= ( UBaseType_t ) ipconfigARP_PENDING_QUEUE_LENGTH ) ||
+				( uxCount >= ( UBaseType_t ) ipconfigARP_PENDING_PER_DESTINATION ) )
+			{
+				/* The caller will drop the packet. */
+				xARPPendingStats.ulPacketsDropped++;
+			}
+			else
+			{
+				if( listCURRENT_LIST_LENGTH( &xARPPendingList ) == 0u )
+				{
+					vIPReloadARPPendingTimer( pdMS_TO_TICKS( arpPENDING_TIMER_PERIOD_MS ) );
+				}
+
+				listSET_LIST_ITEM_OWNER( &( pxNetworkBuffer->xBufferListItem ), ( void * ) pxNetworkBuffer );
+				listSET_LIST_ITEM_VALUE( &( pxNetworkBuffer->xBufferListItem ), xTaskGetTickCount() );
+				vListInsertEnd( &xARPPendingList, &( pxNetworkBuffer->xBufferListItem ) );
+
+				xARPPendingStats.ulPacketsQueued++;
+				if( xARPPendingStats.uxPacketsWaitingMax < listCURRENT_LIST_LENGTH( &xARPPendingList ) )
+				{
+					xARPPendingStats.uxPacketsWaitingMax = listCURRENT_LIST_LENGTH( &xARPPendingList );
+				}
+
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	static void prvARPPendingFlush( void )
+	{
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t * ) listGET_END_MARKER( &xARPPendingList );
+	ListItem_t *pxIterator, *pxNext;
+	NetworkBufferDescriptor_t *pxWaiting;
+	uint32_t ulIPAddress;
+	MACAddress_t xMACAddress;
+
+		/* The list is walked in the order in which the packets were sent, so
+		the packets for one destination keep their order. */
+		for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = pxNext )
+		{
+			pxNext = ( ListItem_t * ) listGET_NEXT( pxIterator );
+			pxWaiting = ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			ulIPAddress = pxWaiting->ulIPAddress;
+
+			if( eARPGetCacheEntry( &ulIPAddress, &xMACAddress ) == eARPCacheHit )
+			{
+				( void ) uxListRemove( pxIterator );
+				xARPPendingStats.ulPacketsSent++;
+
+				/* The ARP lookup will succeed this time, and the packet will
+				be sent. */
+				vProcessGeneratedUDPPacket( pxWaiting );
+			}
+		}
+	}
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	BaseType_t xARPPendingAgeing( void )
+	{
+	NetworkBufferDescriptor_t *pxWaiting;
+	TickType_t xNow = xTaskGetTickCount();
+
+		/* The oldest packet is at the head of the list. */
+		while( listCURRENT_LIST_LENGTH( &xARPPendingList ) != 0u )
+		{
+			pxWaiting = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xARPPendingList );
+
+			if( ( xNow - listGET_LIST_ITEM_VALUE( &( pxWaiting->xBufferListItem ) ) ) < pdMS_TO_TICKS( ipconfigARP_PENDING_TIMEOUT_MS ) )
+			{
+				break;
+			}
+
+			( void ) uxListRemove( &( pxWaiting->xBufferListItem ) );
+			iptracePACKET_DROPPED_TO_GENERATE_ARP( pxWaiting->ulIPAddress );
+			xARPPendingStats.ulPacketsTimedOut++;
+			vReleaseNetworkBufferAndDescriptor( pxWaiting );
+		}
+
+		return ( listCURRENT_LIST_LENGTH( &xARPPendingList ) != 0u ) ? pdTRUE : pdFALSE;
+	}
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	void FreeRTOS_GetARPPendingStats( ARPPendingStats_t *pxStats )
+	{
+		configASSERT( pxStats != NULL );
+
+		/* The statistics are updated by the IP-task. */
+		vTaskSuspendAll();
+		{
+			memcpy( ( void * ) pxStats, ( const void * ) &xARPPendingStats, sizeof( *pxStats ) );
+			pxStats->uxPacketsWaiting = listCURRENT_LIST_LENGTH( &xARPPendingList );
+		}
+		( void ) xTaskResumeAll();
+	}
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigHAS_PRINTF != 0 ) || ( ipconfigHAS_DEBUG_PRINTF != 0 )
 
 	void FreeRTOS_PrintARPCache( void )
@@ -52,12 +52,14 @@
 	#define dnsOUTGOING_FLAGS		0x0001u     /* Standard query. */
 	#define dnsRX_FLAGS_MASK		0x0f80u     /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS	0x0080u     /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS	0x0380u     /* A response: the name does not exist. */
 #else
 	#define dnsDNS_PORT				0x0035u
 	#define dnsONE_QUESTION			0x0001u
 	#define dnsOUTGOING_FLAGS		0x0100u     /* Standard query. */
 	#define dnsRX_FLAGS_MASK		0x800fu     /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS	0x8000u     /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS	0x8003u     /* A response: the name does not exist. */
 
 #endif /* ipconfigBYTE_ORDER */
 
@@ -159,24 +161,119 @@ static uint32_t prvGetHostByName( const char *pcHostName,
 #endif /* ipconfigUSE_DNS_CACHE || ipconfigDNS_USE_CALLBACKS */
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
-	static void prvProcessDNSCache( const char *pcName,
-									uint32_t *pulIP,
-									uint32_t ulTTL,
-									BaseType_t xLookUp );
+	/*
+	 * Look-up or store the address(es) of a host name.  When storing,
+	 * 'uxAddressCount' is the number of addresses in 'pulIP'.  A count of zero
+	 * stores the fact that the name does not exist.  Returns pdTRUE if the name
+	 * was found in the cache, also when it was a negative entry.
+	 */
+	static BaseType_t prvProcessDNSCache( const char *pcName,
+										  uint32_t *pulIP,
+										  size_t uxAddressCount,
+										  uint32_t ulTTL,
+										  BaseType_t xLookUp );
+
+	/*
+	 * Calculate a case-insensitive hash of a host name.
+	 */
+	static uint32_t prvDNSHashName( const char *pcName );
+
+	/*
+	 * Compare two host names, ignoring the case of the characters.
+	 */
+	static BaseType_t prvDNSNamesMatch( const char *pcName1, const char *pcName2 );
+
+	/*
+	 * Return the row that holds 'pcName', or -1 if it is not in the cache.
+	 */
+	static BaseType_t prvDNSCacheFind( const char *pcName, uint32_t ulHash );
+
+	/*
+	 * Obtain an unused row.  If all rows are in use, the entry that will
+	 * expire first is removed.
+	 */
+	static BaseType_t prvDNSCacheNewEntry( void );
+
+	/*
+	 * Remove a row from the hash chains and from the expiry heap.
+	 */
+	static void prvDNSCacheRemove( BaseType_t xEntry );
+
+	/*
+	 * Remove all entries of which the TTL has ended.
+	 */
+	static void prvDNSCacheExpire( uint32_t ulCurrentTimeSeconds );
+
+	/*
+	 * Return the number of seconds since the cache was first used.  The value
+	 * only wraps after 2^32 seconds, not when the tick count wraps.
+	 */
+	static uint32_t prvDNSCacheSeconds( void );
+
+	/*
+	 * Maintenance of the min-heap, which is ordered by expiry time.
+	 */
+	static void prvDNSHeapInsert( BaseType_t xEntry );
+	static void prvDNSHeapRemove( BaseType_t xEntry );
+	static void prvDNSHeapMoveUp( UBaseType_t uxPosition );
+	static void prvDNSHeapMoveDown( UBaseType_t uxPosition );
+	static void prvDNSHeapSwap( UBaseType_t uxPosition1, UBaseType_t uxPosition2 );
 
 	typedef struct xDNS_CACHE_TABLE_ROW
 	{
-		uint32_t ulIPAddress;                         /* The IP address of an ARP cache entry. */
+		uint32_t ulIPAddresses[ ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY ]; /* The IP addresses of the host, in network byte order. */
 		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ]; /* The name of the host */
-		uint32_t ulTTL;                               /* Time-to-Live (in seconds) from the DNS server. */
-		uint32_t ulTimeWhenAddedInSeconds;
+		uint32_t ulHash;                              /* The hash of pcName, see prvDNSHashName(). */
+		uint32_t ulTimeWhenExpiresInSeconds;          /* Time of adding plus the Time-to-Live from the DNS server. */
+		uint16_t usNext;                              /* Next row in the same hash chain ( or free list ) plus 1, or 0. */
+		uint16_t usHeapPosition;                      /* Position of this row in usDNSExpiryHeap[]. */
+		uint8_t ucAddressCount;                       /* Number of valid addresses, zero for a negative entry. */
+		uint8_t ucNextAddress;                        /* The address that will be returned by the next look-up. */
 	} DNSCacheRow_t;
 
 	static DNSCacheRow_t xDNSCache[ ipconfigDNS_CACHE_ENTRIES ];
 
+	/* The first row of each hash chain, plus 1.  Zero means empty. */
+	static uint16_t usDNSHashChains[ ipconfigDNS_CACHE_ENTRIES ];
+
+	/* All rows in use, ordered as a min-heap on ulTimeWhenExpiresInSeconds. */
+	static uint16_t usDNSExpiryHeap[ ipconfigDNS_CACHE_ENTRIES ];
+	static UBaseType_t uxDNSHeapCount = 0u;
+
+	/* The first unused row plus 1, the rows are linked through usNext. */
+	static uint16_t usDNSFreeList = 0u;
+	static BaseType_t xDNSCacheInitialised = pdFALSE;
+
+	/* The clock of the cache, see prvDNSCacheSeconds(). */
+	static uint32_t ulDNSCacheSeconds = 0u;
+	static TickType_t xDNSCacheLastTick = 0u;
+	static TickType_t xDNSCacheTicks = 0u;
+
+	static DNSCacheStatistics_t xDNSCacheStatistics;
+
 	void FreeRTOS_dnsclear()
 	{
-		memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
+		vTaskSuspendAll();
+		{
+			memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
+			memset( usDNSHashChains, 0x0, sizeof( usDNSHashChains ) );
+			uxDNSHeapCount = 0u;
+			usDNSFreeList = 0u;
+
+			/* The free list will be rebuilt when the cache is used again. */
+			xDNSCacheInitialised = pdFALSE;
+		}
+		( void ) xTaskResumeAll();
+	}
+	/*-----------------------------------------------------------*/
+
+	void FreeRTOS_dnsGetCacheStatistics( DNSCacheStatistics_t *pxStatistics )
+	{
+		vTaskSuspendAll();
+		{
+			*pxStatistics = xDNSCacheStatistics;
+		}
+		( void ) xTaskResumeAll();
 	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
 
@@ -284,7 +381,7 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	{
 	uint32_t ulIPAddress = 0uL;
 
-		prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE );
+		( void ) prvProcessDNSCache( pcHostName, &ulIPAddress, 0, 0, pdTRUE );
 		return ulIPAddress;
 	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
@@ -472,6 +569,7 @@ uint32_t ulIPAddress = 0uL;
 TickType_t uxReadTimeOut_ticks = ipconfigDNS_RECEIVE_BLOCK_TIME_TICKS;
 TickType_t uxIdentifier = 0u;
 BaseType_t xHasRandom = pdFALSE;
+BaseType_t xNegativeEntry = pdFALSE;
 
 	if( pcHostName != NULL )
 	{
@@ -489,11 +587,19 @@ BaseType_t xHasRandom = pdFALSE;
 		{
 			if( ulIPAddress == 0uL )
 			{
-				ulIPAddress = FreeRTOS_dnslookup( pcHostName );
-
-				if( ulIPAddress != 0 )
+				if( prvProcessDNSCache( pcHostName, &ulIPAddress, 0, 0, pdTRUE ) != pdFALSE )
 				{
-					FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: found '%s' in cache: %lxip\n", pcHostName, ulIPAddress ) );
+					if( ulIPAddress != 0 )
+					{
+						FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: found '%s' in cache: %lxip\n", pcHostName, ulIPAddress ) );
+					}
+					else
+					{
+						/* The DNS server has recently replied that this name
+						does not exist, do not ask again. */
+						FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: '%s' does not exist ( cached )\n", pcHostName ) );
+						xNegativeEntry = pdTRUE;
+					}
 				}
 				else
 				{
@@ -504,7 +610,7 @@ BaseType_t xHasRandom = pdFALSE;
 		#endif /* ipconfigUSE_DNS_CACHE == 1 */
 
 		/* Generate a unique identifier. */
-		if( ulIPAddress == 0uL )
+		if( ( ulIPAddress == 0uL ) && ( xNegativeEntry == pdFALSE ) )
 		{
 		uint32_t ulNumber;
 
@@ -518,7 +624,12 @@ BaseType_t xHasRandom = pdFALSE;
 		{
 			if( pCallback != NULL )
 			{
-				if( ulIPAddress == 0uL )
+				if( xNegativeEntry != pdFALSE )
+				{
+					/* The name is known not to exist, report it now. */
+					pCallback( pcHostName, pvSearchID, 0uL );
+				}
+				else if( ulIPAddress == 0uL )
 				{
 					/* The user has provided a callback function, so do not block on recvfrom() */
 					if( xHasRandom != pdFALSE )
@@ -635,6 +746,7 @@ TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
 					if( lBytes > 0 )
 					{
 					BaseType_t xExpected;
+					BaseType_t xNameUnknown = pdFALSE;
 					DNSMessage_t *pxDNSMessageHeader = ( DNSMessage_t * ) pucUDPPayloadBuffer;
 
 						/* See if the identifiers match. */
@@ -658,12 +770,20 @@ TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
 							ulIPAddress = prvParseDNSReply( pucUDPPayloadBuffer, ( size_t ) lBytes, xExpected );
 						}
 
+						if( ( xExpected != pdFALSE ) &&
+							( ( pxDNSMessageHeader->usFlags & dnsRX_FLAGS_MASK ) == dnsNXDOMAIN_RX_FLAGS ) )
+						{
+							/* The name does not exist, there is no point in
+							asking again. */
+							xNameUnknown = pdTRUE;
+						}
+
 						/* Finished with the buffer.  The zero copy interface
 						is being used, so the buffer must be freed by the
 						task. */
 						FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucUDPPayloadBuffer );
 
-						if( ulIPAddress != 0uL )
+						if( ( ulIPAddress != 0uL ) || ( xNameUnknown != pdFALSE ) )
 						{
 							/* All done. */
 							break;
@@ -982,6 +1102,11 @@ BaseType_t xDoStore = xExpected;
 #if( ipconfigUSE_DNS_CACHE == 1 ) || ( ipconfigDNS_USE_CALLBACKS == 1 )
 	char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ] = "";
 #endif
+#if( ipconfigUSE_DNS_CACHE == 1 )
+	uint32_t ulAddresses[ ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY ];
+	size_t uxAddressCount = 0u;
+	uint32_t ulTTL = 0uL;
+#endif
 
 	/* Ensure that the buffer is of at least minimal DNS message length. */
 	if( uxBufferLength < sizeof( DNSMessage_t ) )
@@ -1100,43 +1225,57 @@ BaseType_t xDoStore = xExpected;
 					/* Sanity check the data length of an IPv4 answer. */
 					if( FreeRTOS_ntohs( pxDNSAnswerRecord->usDataLength ) == sizeof( uint32_t ) )
 					{
+					uint32_t ulAddress;
+
 						/* Copy the IP address out of the record. */
-						memcpy( &ulIPAddress,
+						memcpy( &ulAddress,
 								pucByte + sizeof( DNSAnswerRecord_t ),
 								sizeof( uint32_t ) );
 
-						#if( ipconfigDNS_USE_CALLBACKS == 1 )
+						if( ulIPAddress == 0uL )
 						{
-							/* See if any asynchronous call was made to FreeRTOS_gethostbyname_a() */
-							if( xDNSDoCallback( ( TickType_t ) pxDNSMessageHeader->usIdentifier, pcName, ulIPAddress ) != pdFALSE )
+							/* The first address found will be returned. */
+							ulIPAddress = ulAddress;
+
+							#if( ipconfigDNS_USE_CALLBACKS == 1 )
 							{
-								/* This device has requested this DNS look-up.
-								The result may be stored in the DNS cache. */
-								xDoStore = pdTRUE;
+								/* See if any asynchronous call was made to FreeRTOS_gethostbyname_a() */
+								if( xDNSDoCallback( ( TickType_t ) pxDNSMessageHeader->usIdentifier, pcName, ulIPAddress ) != pdFALSE )
+								{
+									/* This device has requested this DNS look-up.
+									The result may be stored in the DNS cache. */
+									xDoStore = pdTRUE;
+								}
 							}
+							#endif /* ipconfigDNS_USE_CALLBACKS == 1 */
 						}
-						#endif /* ipconfigDNS_USE_CALLBACKS == 1 */
+
 						#if( ipconfigUSE_DNS_CACHE == 1 )
 						{
-							/* The reply will only be stored in the DNS cache when the
-							request was issued by this device. */
-							if( xDoStore != pdFALSE )
+							if( uxAddressCount == 0u )
 							{
-								prvProcessDNSCache( pcName, &ulIPAddress, pxDNSAnswerRecord->ulTTL, pdFALSE );
+								/* All records of a set have the same TTL. */
+								ulTTL = pxDNSAnswerRecord->ulTTL;
 							}
-
-							/* Show what has happened. */
-							FreeRTOS_printf( ( "DNS[0x%04X]: The answer to '%s' (%xip) will%s be stored\n",
-											   ( unsigned ) pxDNSMessageHeader->usIdentifier,
-											   pcName,
-											   ( unsigned ) FreeRTOS_ntohl( ulIPAddress ),
-											   ( xDoStore != 0 ) ? "" : " NOT" ) );
+							ulAddresses[ uxAddressCount ] = ulAddress;
+							uxAddressCount++;
 						}
 						#endif /* ipconfigUSE_DNS_CACHE */
 					}
 
 					pucByte += sizeof( DNSAnswerRecord_t ) + sizeof( uint32_t );
 					uxSourceBytesRemaining -= ( sizeof( DNSAnswerRecord_t ) + sizeof( uint32_t ) );
+
+					#if( ipconfigUSE_DNS_CACHE == 1 )
+					{
+						if( uxAddressCount < ( size_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY )
+						{
+							/* There is place for more addresses of this host. */
+							continue;
+						}
+					}
+					#endif /* ipconfigUSE_DNS_CACHE */
+
 					break;
 				}
 				else if( uxSourceBytesRemaining >= sizeof( DNSAnswerRecord_t ) )
@@ -1163,7 +1302,51 @@ BaseType_t xDoStore = xExpected;
 					}
 				}
 			}
+
+			#if( ipconfigUSE_DNS_CACHE == 1 )
+			{
+				if( uxAddressCount != 0u )
+				{
+					/* The reply will only be stored in the DNS cache when the
+					request was issued by this device. */
+					if( xDoStore != pdFALSE )
+					{
+						( void ) prvProcessDNSCache( pcName, ulAddresses, uxAddressCount, ulTTL, pdFALSE );
+					}
+
+					/* Show what has happened. */
+					FreeRTOS_printf( ( "DNS[0x%04X]: The answer to '%s' (%xip, %u address%s) will%s be stored\n",
+									   ( unsigned ) pxDNSMessageHeader->usIdentifier,
+									   pcName,
+									   ( unsigned ) FreeRTOS_ntohl( ulIPAddress ),
+									   ( unsigned ) uxAddressCount,
+									   ( uxAddressCount == 1u ) ? "" : "es",
+									   ( xDoStore != 0 ) ? "" : " NOT" ) );
+				}
+			}
+			#endif /* ipconfigUSE_DNS_CACHE */
+		}
+#if( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+		else if( ( ( pxDNSMessageHeader->usFlags & dnsRX_FLAGS_MASK ) == dnsNXDOMAIN_RX_FLAGS ) && ( usQuestions != 0u ) )
+		{
+			/* The server says that the name does not exist. */
+			#if( ipconfigDNS_USE_CALLBACKS == 1 )
+			{
+				/* Let an asynchronous look-up fail now, in stead of waiting
+				for its time-out. */
+				if( xDNSDoCallback( ( TickType_t ) pxDNSMessageHeader->usIdentifier, pcName, 0uL ) != pdFALSE )
+				{
+					xDoStore = pdTRUE;
+				}
+			}
+			#endif /* ipconfigDNS_USE_CALLBACKS == 1 */
+
+			if( xDoStore != pdFALSE )
+			{
+				( void ) prvProcessDNSCache( pcName, NULL, 0u, FreeRTOS_htonl( ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL ), pdFALSE );
+			}
 		}
+#endif /* ipconfigUSE_DNS_CACHE && ipconfigDNS_CACHE_NEGATIVE_TTL */
 
 #if( ipconfigUSE_LLMNR == 1 )
 		else if( usQuestions && ( usType == dnsTYPE_A_HOST ) && ( usClass == dnsCLASS_IN ) )
@@ -1312,7 +1495,7 @@ BaseType_t xDoStore = xExpected;
 				{
 					/* If this is a response from another device,
 					add the name to the DNS cache */
-					prvProcessDNSCache( ( char * ) ucNBNSName, &ulIPAddress, 0, pdFALSE );
+					( void ) prvProcessDNSCache( ( char * ) ucNBNSName, &ulIPAddress, 1u, 0uL, pdFALSE );
 				}
 			}
 			#else
@@ -1463,84 +1646,383 @@ BaseType_t xReturn;
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
 
-	static void prvProcessDNSCache( const char *pcName,
-									uint32_t *pulIP,
-									uint32_t ulTTL,
-									BaseType_t xLookUp )
+	static uint32_t prvDNSHashName( const char *pcName )
 	{
-	BaseType_t x;
-	BaseType_t xFound = pdFALSE;
-	uint32_t ulCurrentTimeSeconds = ( xTaskGetTickCount() / portTICK_PERIOD_MS ) / 1000;
-	static BaseType_t xFreeEntry = 0;
-		configASSERT(pcName);
+	uint32_t ulHash = 2166136261uL;
+	uint8_t ucChar;
 
-		/* For each entry in the DNS cache table. */
-		for( x = 0; x < ipconfigDNS_CACHE_ENTRIES; x++ )
+		/* FNV-1a, applied to the lower-case version of the name. */
+		for( ; *pcName != '\0'; pcName++ )
 		{
-			if( xDNSCache[ x ].pcName[ 0 ] == 0 )
+			ucChar = ( uint8_t ) *pcName;
+
+			if( ( ucChar >= ( uint8_t ) 'A' ) && ( ucChar <= ( uint8_t ) 'Z' ) )
 			{
-				continue;
+				ucChar += ( uint8_t ) ( 'a' - 'A' );
 			}
 
-			if( 0 == strcmp( xDNSCache[ x ].pcName, pcName ) )
+			ulHash = ( ulHash ^ ucChar ) * 16777619uL;
+		}
+
+		return ulHash;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvDNSNamesMatch( const char *pcName1, const char *pcName2 )
+	{
+	uint8_t ucChar1, ucChar2;
+	BaseType_t xResult = pdFALSE;
+
+		for( ;; )
+		{
+			ucChar1 = ( uint8_t ) *( pcName1++ );
+			ucChar2 = ( uint8_t ) *( pcName2++ );
+
+			if( ( ucChar1 >= ( uint8_t ) 'A' ) && ( ucChar1 <= ( uint8_t ) 'Z' ) )
 			{
-				/* Is this function called for a lookup or to add/update an IP address? */
-				if( xLookUp != pdFALSE )
-				{
-					/* Confirm that the record is still fresh. */
-					if( ulCurrentTimeSeconds < ( xDNSCache[ x ].ulTimeWhenAddedInSeconds + FreeRTOS_ntohl( xDNSCache[ x ].ulTTL ) ) )
-					{
-						*pulIP = xDNSCache[ x ].ulIPAddress;
-					}
-					else
-					{
-						/* Age out the old cached record. */
-						xDNSCache[ x ].pcName[ 0 ] = 0;
-					}
-				}
-				else
-				{
-					xDNSCache[ x ].ulIPAddress = *pulIP;
-					xDNSCache[ x ].ulTTL = ulTTL;
-					xDNSCache[ x ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
-				}
+				ucChar1 += ( uint8_t ) ( 'a' - 'A' );
+			}
+
+			if( ( ucChar2 >= ( uint8_t ) 'A' ) && ( ucChar2 <= ( uint8_t ) 'Z' ) )
+			{
+				ucChar2 += ( uint8_t ) ( 'a' - 'A' );
+			}
+
+			if( ucChar1 != ucChar2 )
+			{
+				break;
+			}
 
-				xFound = pdTRUE;
+			if( ucChar1 == 0u )
+			{
+				xResult = pdTRUE;
 				break;
 			}
 		}
 
-		if( xFound == pdFALSE )
+		return xResult;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvDNSCacheFind( const char *pcName, uint32_t ulHash )
+	{
+	BaseType_t xEntry;
+	uint16_t usItem;
+
+		usItem = usDNSHashChains[ ulHash % ( uint32_t ) ipconfigDNS_CACHE_ENTRIES ];
+
+		while( usItem != 0u )
 		{
-			if( xLookUp != pdFALSE )
+			xEntry = ( BaseType_t ) usItem - 1;
+
+			/* Only compare the strings when the hash values are equal. */
+			if( ( xDNSCache[ xEntry ].ulHash == ulHash ) &&
+				( prvDNSNamesMatch( xDNSCache[ xEntry ].pcName, pcName ) != pdFALSE ) )
 			{
-				*pulIP = 0;
+				return xEntry;
 			}
-			else
+
+			usItem = xDNSCache[ xEntry ].usNext;
+		}
+
+		return -1;
+	}
+	/*-----------------------------------------------------------*/
+
+	/* Returns true if the row at 'uxLeft' expires before the row at 'uxRight'.
+	The clock wraps after 2^32 seconds, and a TTL is less than 2^31 seconds, so
+	the signed difference gives the right order. */
+	#define dnsHEAP_EXPIRES_BEFORE( uxLeft, uxRight ) \
+		( ( int32_t ) ( xDNSCache[ usDNSExpiryHeap[ ( uxLeft ) ] ].ulTimeWhenExpiresInSeconds - \
+						xDNSCache[ usDNSExpiryHeap[ ( uxRight ) ] ].ulTimeWhenExpiresInSeconds ) < 0 )
+
+	static void prvDNSHeapSwap( UBaseType_t uxPosition1, UBaseType_t uxPosition2 )
+	{
+	uint16_t usEntry;
+
+		usEntry = usDNSExpiryHeap[ uxPosition1 ];
+		usDNSExpiryHeap[ uxPosition1 ] = usDNSExpiryHeap[ uxPosition2 ];
+		usDNSExpiryHeap[ uxPosition2 ] = usEntry;
+
+		xDNSCache[ usDNSExpiryHeap[ uxPosition1 ] ].usHeapPosition = ( uint16_t ) uxPosition1;
+		xDNSCache[ usDNSExpiryHeap[ uxPosition2 ] ].usHeapPosition = ( uint16_t ) uxPosition2;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSHeapMoveUp( UBaseType_t uxPosition )
+	{
+	UBaseType_t uxParent;
+
+		while( uxPosition > 0u )
+		{
+			uxParent = ( uxPosition - 1u ) / 2u;
+
+			if( !dnsHEAP_EXPIRES_BEFORE( uxPosition, uxParent ) )
 			{
-				/* Add or update the item. */
-				if( strlen( pcName ) < ipconfigDNS_CACHE_NAME_LENGTH )
+				break;
+			}
+
+			prvDNSHeapSwap( uxPosition, uxParent );
+			uxPosition = uxParent;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSHeapMoveDown( UBaseType_t uxPosition )
+	{
+	UBaseType_t uxChild;
+
+		for( ;; )
+		{
+			uxChild = ( 2u * uxPosition ) + 1u;
+
+			if( uxChild >= uxDNSHeapCount )
+			{
+				break;
+			}
+
+			/* Take the child that expires first. */
+			if( ( ( uxChild + 1u ) < uxDNSHeapCount ) && dnsHEAP_EXPIRES_BEFORE( uxChild + 1u, uxChild ) )
+			{
+				uxChild++;
+			}
+
+			if( !dnsHEAP_EXPIRES_BEFORE( uxChild, uxPosition ) )
+			{
+				break;
+			}
+
+			prvDNSHeapSwap( uxPosition, uxChild );
+			uxPosition = uxChild;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSHeapInsert( BaseType_t xEntry )
+	{
+		usDNSExpiryHeap[ uxDNSHeapCount ] = ( uint16_t ) xEntry;
+		xDNSCache[ xEntry ].usHeapPosition = ( uint16_t ) uxDNSHeapCount;
+		uxDNSHeapCount++;
+		prvDNSHeapMoveUp( uxDNSHeapCount - 1u );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSHeapRemove( BaseType_t xEntry )
+	{
+	UBaseType_t uxPosition = ( UBaseType_t ) xDNSCache[ xEntry ].usHeapPosition;
+	uint16_t usLast;
+
+		uxDNSHeapCount--;
+
+		if( uxPosition != uxDNSHeapCount )
+		{
+			/* Fill the hole with the last element, and restore the order. */
+			usLast = usDNSExpiryHeap[ uxDNSHeapCount ];
+			prvDNSHeapSwap( uxPosition, uxDNSHeapCount );
+			prvDNSHeapMoveUp( uxPosition );
+			prvDNSHeapMoveDown( ( UBaseType_t ) xDNSCache[ usLast ].usHeapPosition );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSCacheRemove( BaseType_t xEntry )
+	{
+	uint16_t *pusLink;
+
+		/* Unlink the row from its hash chain. */
+		pusLink = &( usDNSHashChains[ xDNSCache[ xEntry ].ulHash % ( uint32_t ) ipconfigDNS_CACHE_ENTRIES ] );
+
+		while( *pusLink != ( uint16_t ) ( xEntry + 1 ) )
+		{
+			pusLink = &( xDNSCache[ *pusLink - 1u ].usNext );
+		}
+
+		*pusLink = xDNSCache[ xEntry ].usNext;
+
+		prvDNSHeapRemove( xEntry );
+
+		/* Give the row back to the free list. */
+		xDNSCache[ xEntry ].pcName[ 0 ] = '\0';
+		xDNSCache[ xEntry ].usNext = usDNSFreeList;
+		usDNSFreeList = ( uint16_t ) ( xEntry + 1 );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSCacheExpire( uint32_t ulCurrentTimeSeconds )
+	{
+	BaseType_t xEntry;
+
+		/* The entry that expires first is always at the top of the heap. */
+		while( uxDNSHeapCount != 0u )
+		{
+			xEntry = ( BaseType_t ) usDNSExpiryHeap[ 0 ];
+
+			if( ( int32_t ) ( ulCurrentTimeSeconds - xDNSCache[ xEntry ].ulTimeWhenExpiresInSeconds ) < 0 )
+			{
+				break;
+			}
+
+			prvDNSCacheRemove( xEntry );
+			xDNSCacheStatistics.ulExpirations++;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvDNSCacheSeconds( void )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xElapsed = xNow - xDNSCacheLastTick;
+
+		/* Dividing the tick count itself would give a clock that wraps when
+		the tick count wraps, e.g. after 4294967 seconds with a 1 ms tick.  The
+		elapsed ticks are added up in stead.  The cache must therefore be used
+		at least once per wrap of the tick count. */
+		xDNSCacheLastTick = xNow;
+		ulDNSCacheSeconds += ( uint32_t ) ( xElapsed / ( TickType_t ) configTICK_RATE_HZ );
+		xDNSCacheTicks += xElapsed % ( TickType_t ) configTICK_RATE_HZ;
+
+		if( xDNSCacheTicks >= ( TickType_t ) configTICK_RATE_HZ )
+		{
+			xDNSCacheTicks -= ( TickType_t ) configTICK_RATE_HZ;
+			ulDNSCacheSeconds++;
+		}
+
+		return ulDNSCacheSeconds;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvDNSCacheNewEntry( void )
+	{
+	BaseType_t xEntry;
+
+		if( usDNSFreeList == 0u )
+		{
+			/* The cache is full, drop the entry that would expire first. */
+			prvDNSCacheRemove( ( BaseType_t ) usDNSExpiryHeap[ 0 ] );
+			xDNSCacheStatistics.ulEvictions++;
+		}
+
+		xEntry = ( BaseType_t ) usDNSFreeList - 1;
+		usDNSFreeList = xDNSCache[ xEntry ].usNext;
+
+		return xEntry;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvProcessDNSCache( const char *pcName,
+										  uint32_t *pulIP,
+										  size_t uxAddressCount,
+										  uint32_t ulTTL,
+										  BaseType_t xLookUp )
+	{
+	BaseType_t x;
+	BaseType_t xFound;
+	uint32_t ulHash;
+	uint32_t ulCurrentTimeSeconds;
+		configASSERT(pcName);
+
+		ulHash = prvDNSHashName( pcName );
+
+		/* The cache is accessed by the IP-task and by user tasks that call
+		FreeRTOS_gethostbyname(). */
+		vTaskSuspendAll();
+		{
+			if( xDNSCacheInitialised == pdFALSE )
+			{
+				/* Put all rows in the free list. */
+				for( x = 0; x < ipconfigDNS_CACHE_ENTRIES; x++ )
 				{
-					strcpy( xDNSCache[ xFreeEntry ].pcName, pcName );
+					xDNSCache[ x ].usNext = ( uint16_t ) ( x + 2 );
+				}
+				xDNSCache[ ipconfigDNS_CACHE_ENTRIES - 1 ].usNext = 0u;
+				usDNSFreeList = 1u;
+				xDNSCacheInitialised = pdTRUE;
+			}
+
+			/* First remove the entries that have aged out. */
+			ulCurrentTimeSeconds = prvDNSCacheSeconds();
+			prvDNSCacheExpire( ulCurrentTimeSeconds );
 
-					xDNSCache[ xFreeEntry ].ulIPAddress = *pulIP;
-					xDNSCache[ xFreeEntry ].ulTTL = ulTTL;
-					xDNSCache[ xFreeEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+			x = prvDNSCacheFind( pcName, ulHash );
+			xFound = ( x >= 0 ) ? pdTRUE : pdFALSE;
 
-					xFreeEntry++;
+			/* Is this function called for a lookup or to add/update an IP address? */
+			if( xLookUp != pdFALSE )
+			{
+				if( x < 0 )
+				{
+					*pulIP = 0;
+					xDNSCacheStatistics.ulMisses++;
+				}
+				else if( xDNSCache[ x ].ucAddressCount == 0u )
+				{
+					/* The name is known not to exist. */
+					*pulIP = 0;
+					xDNSCacheStatistics.ulNegativeHits++;
+				}
+				else
+				{
+					/* Return the addresses in turn. */
+					*pulIP = xDNSCache[ x ].ulIPAddresses[ xDNSCache[ x ].ucNextAddress ];
+					xDNSCache[ x ].ucNextAddress++;
 
-					if( xFreeEntry == ipconfigDNS_CACHE_ENTRIES )
+					if( xDNSCache[ x ].ucNextAddress >= xDNSCache[ x ].ucAddressCount )
 					{
-						xFreeEntry = 0;
+						xDNSCache[ x ].ucNextAddress = 0u;
 					}
+					xDNSCacheStatistics.ulHits++;
 				}
 			}
+			else if( ( x >= 0 ) || ( strlen( pcName ) < ipconfigDNS_CACHE_NAME_LENGTH ) )
+			{
+				if( x >= 0 )
+				{
+					/* Update the item, its position in the heap will change. */
+					prvDNSHeapRemove( x );
+				}
+				else
+				{
+					/* Add the item. */
+					x = prvDNSCacheNewEntry();
+
+					strcpy( xDNSCache[ x ].pcName, pcName );
+					xDNSCache[ x ].ulHash = ulHash;
+					xDNSCache[ x ].usNext = usDNSHashChains[ ulHash % ( uint32_t ) ipconfigDNS_CACHE_ENTRIES ];
+					usDNSHashChains[ ulHash % ( uint32_t ) ipconfigDNS_CACHE_ENTRIES ] = ( uint16_t ) ( x + 1 );
+				}
+
+				if( uxAddressCount > ( size_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY )
+				{
+					uxAddressCount = ( size_t ) ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY;
+				}
+
+				if( uxAddressCount != 0u )
+				{
+					memcpy( xDNSCache[ x ].ulIPAddresses, pulIP, uxAddressCount * sizeof( uint32_t ) );
+				}
+
+				xDNSCache[ x ].ucAddressCount = ( uint8_t ) uxAddressCount;
+				xDNSCache[ x ].ucNextAddress = 0u;
+
+				/* The TTL is a 31-bit value, in network byte order. */
+				xDNSCache[ x ].ulTimeWhenExpiresInSeconds = ulCurrentTimeSeconds + ( FreeRTOS_ntohl( ulTTL ) & 0x7fffffffuL );
+				prvDNSHeapInsert( x );
+
+				xDNSCacheStatistics.ulInsertions++;
+			}
+			else
+			{
+				/* The name is too long to be stored. */
+			}
 		}
+		( void ) xTaskResumeAll();
 
 		if( ( xLookUp == 0 ) || ( *pulIP != 0 ) )
 		{
-			FreeRTOS_debug_printf( ( "prvProcessDNSCache: %s: '%s' @ %lxip\n", xLookUp ? "look-up" : "add", pcName, FreeRTOS_ntohl( *pulIP ) ) );
+			FreeRTOS_debug_printf( ( "prvProcessDNSCache: %s: '%s' @ %lxip\n", xLookUp ? "look-up" : "add", pcName, ( uxAddressCount != 0u ) ? FreeRTOS_ntohl( *pulIP ) : 0uL ) );
 		}
+
+		return xFound;
 	}
 
 #endif /* ipconfigUSE_DNS_CACHE */
@@ -46,6 +46,25 @@
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_DNS.h"
 
+/* The vector extensions used by usGenerateChecksum(), if any. */
+#if( ipconfigUSE_SIMD_CHECKSUM != 0 )
+	#if defined( __SSE2__ )
+		#include <emmintrin.h>
+		#define ipCHECKSUM_USE_SSE2		1
+	#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+		#include <arm_neon.h>
+		#define ipCHECKSUM_USE_NEON		1
+	#endif
+#endif /* ipconfigUSE_SIMD_CHECKSUM */
+
+#ifndef ipCHECKSUM_USE_SSE2
+	#define ipCHECKSUM_USE_SSE2			0
+#endif
+
+#ifndef ipCHECKSUM_USE_NEON
+	#define ipCHECKSUM_USE_NEON			0
+#endif
+
 
 /* Used to ensure the structure packing is having the desired effect.  The
 'volatile' is used to prevent compiler warnings about comparing a constant with
@@ -114,6 +133,18 @@ character expected to fill ICMP echo replies. */
 	#define ipFRAGMENT_OFFSET_BIT_MASK				( ( uint16_t ) 0x0fff )
 #endif /* ipconfigBYTE_ORDER */
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* True if the packet is a fragment of a larger datagram: either the
+	more-fragments flag is set, or the fragment offset is non-zero. */
+	#define ipIS_FRAGMENT( pxIPHeader ) \
+		( ( FreeRTOS_ntohs( ( pxIPHeader )->usFragmentOffset ) & ( ipFRAGMENT_OFFSET_MASK | ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) ) != 0u )
+
+	/* The period of the timer that checks the age of incomplete datagrams. */
+	#define ipIP_REASSEMBLY_TIMER_PERIOD_MS			( 500u )
+#else
+	#define ipIS_FRAGMENT( pxIPHeader )				( pdFALSE )
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 /* The maximum time the IP task is allowed to remain in the Blocked state if no
 events are posted to the network event queue. */
 #ifndef	ipconfigMAX_IP_TASK_SLEEP_TIME
@@ -153,6 +184,22 @@ typedef struct xIP_TIMER
 	TickType_t ulReloadTime;
 } IPTimer_t;
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* A datagram that is being reassembled.  The slot is free when
+	'xFragmentList' is empty. */
+	typedef struct xIP_REASSEMBLY
+	{
+		List_t xFragmentList;			/* Network buffers holding the fragments, sorted on their offset */
+		TickType_t xStartTime;			/* The time at which the first fragment was received */
+		uint32_t ulSourceAddress;		/* The fields below identify the datagram, see RFC 791 */
+		uint32_t ulDestinationAddress;
+		uint16_t usIdentification;
+		uint8_t ucProtocol;
+		size_t uxTotalLength;			/* Length of the IP payload, zero until the last fragment has been received */
+		size_t uxReceivedLength;		/* Number of payload bytes received so far */
+	} IPReassembly_t;
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 /* Used in checksum calculation. */
 typedef union _xUnion32
 {
@@ -244,6 +291,69 @@ static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime );
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 	NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
 
+/*
+ * Add 'uxWordCount' 32-bit words to a 64-bit checksum accumulator.  When
+ * 'pulDestination' is not NULL, the words will also be copied to it.
+ */
+static uint64_t prvChecksumAddWords( uint64_t ullSum, const uint32_t *pulSource, uint32_t *pulDestination, size_t uxWordCount );
+
+/*
+ * The common part of usGenerateChecksum() and usGenerateChecksumCopy().  When
+ * 'pucSource' is not NULL, the data will be copied from it to 'pucNextData'
+ * while it is being summed.
+ */
+static uint16_t prvGenerateChecksum( uint32_t ulSum, uint8_t * pucNextData, const uint8_t * pucSource, size_t uxDataLengthBytes );
+
+/*
+ * The implementation of usGenerateProtocolChecksum().  If 'uxPayloadLength' is
+ * non-zero, 'usPayloadChecksum' contains the checksum of the last
+ * 'uxPayloadLength' bytes of the packet, which will not be summed again.
+ */
+static uint16_t prvGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength, BaseType_t xOutgoingPacket,
+	uint16_t usPayloadChecksum, size_t uxPayloadLength );
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/*
+	 * Store a received fragment in the reassembly cache.  The network buffer
+	 * will either be stored or released.  When the fragment completes a
+	 * datagram, a new network buffer is returned which contains the whole
+	 * datagram.  'uxHeaderLength' is the length of the IP header as received,
+	 * before IP options were removed.
+	 */
+	static NetworkBufferDescriptor_t *prvIPReassemble( NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
+
+	/*
+	 * Copy the fragments of a complete datagram into a new network buffer.
+	 */
+	static NetworkBufferDescriptor_t *prvIPReassemblyJoin( IPReassembly_t *pxDatagram );
+
+	/*
+	 * Release all fragments of a datagram and make its slot available.
+	 */
+	static void prvIPReassemblyRelease( IPReassembly_t *pxDatagram );
+
+	/*
+	 * Drop the incomplete datagrams that are older than
+	 * ipconfigIP_REASSEMBLY_TIMEOUT_MS.  Returns pdTRUE if any datagram is
+	 * still incomplete.
+	 */
+	static BaseType_t prvIPReassemblyAgeing( void );
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	/*
+	 * Add a packet to a ring, or take the oldest packet from a ring.  Each
+	 * ring must have exactly one producer and one consumer.
+	 */
+	static BaseType_t prvNetworkRingPush( NetworkRing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer );
+	static NetworkBufferDescriptor_t *prvNetworkRingPop( NetworkRing_t *pxRing );
+
+	/*
+	 * Called by the IP-task to process all packets in the RX ring.
+	 */
+	static void prvProcessNetworkRxRing( void );
+#endif /* ipconfigUSE_NETWORK_RINGS */
+
 /*-----------------------------------------------------------*/
 
 /* The queue used to pass events into the IP-task for processing. */
@@ -291,6 +401,8 @@ regular basis:
 	2. DPHC, to send requests and to renew a reservation
 	3. TCP, to check for timeouts, resends
 	4. DNS, to check for timeouts when looking-up a domain.
+	5. IP reassembly, to drop incomplete datagrams.
+	6. ARP, to drop packets that have waited too long for an ARP reply.
  */
 static IPTimer_t xARPTimer;
 #if( ipconfigUSE_DHCP != 0 )
@@ -302,6 +414,24 @@ static IPTimer_t xARPTimer;
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
 	static IPTimer_t xDNSTimer;
 #endif
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* Only active while datagrams are being reassembled. */
+	static IPTimer_t xReassemblyTimer;
+
+	/* The datagrams that are being reassembled. */
+	static IPReassembly_t xReassemblyList[ ipconfigIP_REASSEMBLY_MAX_DATAGRAMS ];
+
+	/* Statistics, see FreeRTOS_GetIPFragmentStats(). */
+	IPFragmentStats_t xIPFragmentStats;
+#endif
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* Only active while packets wait for an ARP reply. */
+	static IPTimer_t xARPPendingTimer;
+#endif
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	/* Statistics, see FreeRTOS_GetNetworkRxPollStats(). */
+	static NetworkRxPollStats_t xNetworkRxPollStats;
+#endif
 
 /* Set to pdTRUE when the IP task is ready to start processing packets. */
 static BaseType_t xIPTaskInitialised = pdFALSE;
@@ -311,6 +441,29 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	/* Received packets: the network interface is the producer, the IP-task is
+	the consumer. */
+	static NetworkBufferDescriptor_t *pxRxRingItems[ ipconfigNETWORK_RX_RING_LENGTH ];
+	static NetworkRing_t xNetworkRxRing =
+	{
+		pxRxRingItems, ( UBaseType_t ) ipconfigNETWORK_RX_RING_LENGTH - 1u, 0u, 0u, ( UBaseType_t ) ipconfigNETWORK_RX_RING_LENGTH
+	};
+
+	/* Outgoing packets: the IP-task is the producer, the transmit task of the
+	network interface is the consumer. */
+	static NetworkBufferDescriptor_t *pxTxRingItems[ ipconfigNETWORK_TX_RING_LENGTH ];
+	static NetworkRing_t xNetworkTxRing =
+	{
+		pxTxRingItems, ( UBaseType_t ) ipconfigNETWORK_TX_RING_LENGTH - 1u, 0u, 0u, ( UBaseType_t ) ipconfigNETWORK_TX_RING_LENGTH
+	};
+
+	/* Set by the producer of the RX ring when it has sent an eNetworkRxEvent
+	to wake up the IP-task, cleared by the IP-task before it empties the ring.
+	This way at most one wake-up message is in the event queue at any time. */
+	static volatile BaseType_t xRxRingSignalled = pdFALSE;
+#endif
+
 /*-----------------------------------------------------------*/
 
 static void prvIPTask( void *pvParameters )
@@ -349,6 +502,26 @@ struct freertos_sockaddr xAddress;
 	{
 		ipconfigWATCHDOG_TIMER();
 
+		#if( ipconfigUSE_NETWORK_RINGS != 0 )
+		{
+			/* Packets stay in the RX ring when the wake-up message could not
+			be queued.  Any event will wake up the IP-task, look at the ring
+			every time. */
+			prvProcessNetworkRxRing();
+		}
+		#endif /* ipconfigUSE_NETWORK_RINGS */
+
+		#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+		{
+			/* Sockets that user tasks have asked attention for.  Also here,
+			the wake-up message may not have been queued. */
+			if( xTCPTimerProcessKicks() != pdFALSE )
+			{
+				xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 		/* Check the ARP, DHCP and TCP timers to see if there is any periodic
 		or timeout processing to perform. */
 		prvCheckNetworkTimers();
@@ -390,10 +563,25 @@ struct freertos_sockaddr xAddress;
 				break;
 
 			case eNetworkRxEvent:
-				/* The network hardware driver has received a new packet.  A
-				pointer to the received buffer is located in the pvData member
-				of the received event structure. */
-				prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				#if( ipconfigUSE_NETWORK_RINGS != 0 )
+				if( xReceivedEvent.pvData == NULL )
+				{
+					/* The network hardware driver has put one or more packets
+					in the RX ring.  Clear the flag before looking at the ring:
+					a packet that is added after this point will cause a new
+					wake-up message. */
+					xRxRingSignalled = pdFALSE;
+					ipconfigMEMORY_BARRIER();
+					prvProcessNetworkRxRing();
+				}
+				else
+				#endif /* ipconfigUSE_NETWORK_RINGS */
+				{
+					/* The network hardware driver has received a new packet.  A
+					pointer to the received buffer is located in the pvData member
+					of the received event structure. */
+					prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				}
 				break;
 
 			case eNetworkTxEvent:
@@ -441,6 +629,25 @@ struct freertos_sockaddr xAddress;
 				vProcessGeneratedUDPPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
 				break;
 
+			case eStackTxBatchEvent :
+				/* FreeRTOS_sendmmsg() has generated a chain of packets, linked
+				through their pxNextBuffer member. */
+				#if( ipconfigSUPPORT_UDP_BATCH != 0 )
+				{
+				NetworkBufferDescriptor_t *pxBuffer = ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData );
+				NetworkBufferDescriptor_t *pxNextBuffer;
+
+					while( pxBuffer != NULL )
+					{
+						pxNextBuffer = pxBuffer->pxNextBuffer;
+						pxBuffer->pxNextBuffer = NULL;
+						vProcessGeneratedUDPPacket( pxBuffer );
+						pxBuffer = pxNextBuffer;
+					}
+				}
+				#endif /* ipconfigSUPPORT_UDP_BATCH */
+				break;
+
 			case eDHCPEvent:
 				/* The DHCP state machine needs processing. */
 				#if( ipconfigUSE_DHCP == 1 )
@@ -567,6 +774,13 @@ static void prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer )
 			/* Make it NULL to avoid using it later on. */
 			pxBuffer->pxNextBuffer = NULL;
 
+			/* Start loading the headers of the next packet while this one is
+			being processed. */
+			if( pxNextBuffer != NULL )
+			{
+				ipconfigPREFETCH( pxNextBuffer->pucEthernetBuffer );
+			}
+
 			prvProcessEthernetPacket( pxBuffer );
 			pxBuffer = pxNextBuffer;
 
@@ -626,6 +840,30 @@ TickType_t xMaximumSleepTime;
 	}
 	#endif
 
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		if( xReassemblyTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( xReassemblyTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = xReassemblyTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
+	#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	{
+		if( xARPPendingTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( xARPPendingTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = xARPPendingTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
 	return xMaximumSleepTime;
 }
 /*-----------------------------------------------------------*/
@@ -660,6 +898,36 @@ static void prvCheckNetworkTimers( void )
 	}
 	#endif /* ipconfigDNS_USE_CALLBACKS */
 
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		/* Is it time to check the age of incomplete datagrams? */
+		if( prvIPTimerCheck( &xReassemblyTimer ) != pdFALSE )
+		{
+			if( prvIPReassemblyAgeing() == pdFALSE )
+			{
+				/* Nothing left to reassemble, the timer will be started again
+				when a new fragment arrives. */
+				xReassemblyTimer.bActive = pdFALSE_UNSIGNED;
+			}
+		}
+	}
+	#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
+	#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	{
+		/* Is it time to drop packets that wait too long for an ARP reply? */
+		if( prvIPTimerCheck( &xARPPendingTimer ) != pdFALSE )
+		{
+			if( xARPPendingAgeing() == pdFALSE )
+			{
+				/* No packets are waiting, the timer will be started again
+				when a new packet is held. */
+				xARPPendingTimer.bActive = pdFALSE_UNSIGNED;
+			}
+		}
+	}
+	#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 	BaseType_t xWillSleep;
@@ -1005,6 +1273,13 @@ BaseType_t xReturn = pdFALSE;
 			header fragment, which is used when sending UDP packets. */
 			memcpy( ( void * ) ipLOCAL_MAC_ADDRESS, ( void * ) ucMACAddress, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
+			#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+			{
+				/* Prepare the list of packets that wait for an ARP reply. */
+				vARPPendingInit();
+			}
+			#endif
+
 			/* Prepare the sockets interface. */
 			xReturn = vNetworkSocketsInit();
 
@@ -1131,7 +1406,7 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress, const uint3
 				if( xSendEventStructToIPTask( &xStackTxEvent, xBlockTimeTicks) != pdPASS )
 				{
 					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
-					iptraceSTACK_TX_EVENT_LOST( ipSTACK_TX_EVENT );
+					iptraceSTACK_TX_EVENT_LOST( eStackTxEvent );
 				}
 				else
 				{
@@ -1226,143 +1501,435 @@ BaseType_t xReturn, xSendMessage;
 }
 /*-----------------------------------------------------------*/
 
-eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
-{
-eFrameProcessingResult_t eReturn;
-const EthernetHeader_t *pxEthernetHeader;
-
-	pxEthernetHeader = ( const EthernetHeader_t * ) pucEthernetBuffer;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 
-	if( memcmp( ( void * ) ipLOCAL_MAC_ADDRESS, ( void * ) &( pxEthernetHeader->xDestinationAddress ), sizeof( MACAddress_t ) ) == 0 )
-	{
-		/* The packet was directed to this node directly - process it. */
-		eReturn = eProcessBuffer;
-	}
-	else if( memcmp( ( void * ) xBroadcastMACAddress.ucBytes, ( void * ) pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
-	{
-		/* The packet was a broadcast - process it. */
-		eReturn = eProcessBuffer;
-	}
-	else
-#if( ipconfigUSE_LLMNR == 1 )
-	if( memcmp( ( void * ) xLLMNR_MacAdress.ucBytes, ( void * ) pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
-	{
-		/* The packet is a request for LLMNR - process it. */
-		eReturn = eProcessBuffer;
-	}
-	else
-#endif /* ipconfigUSE_LLMNR */
+	void vNetworkRxBatchInit( NetworkRxBatch_t *pxBatch )
 	{
-		/* The packet was not a broadcast, or for this node, just release
-		the buffer without taking any other action. */
-		eReturn = eReleaseBuffer;
+		pxBatch->pxHead = NULL;
+		pxBatch->pxTail = NULL;
+		pxBatch->uxCount = 0u;
 	}
 
-	#if( ipconfigFILTER_OUT_NON_ETHERNET_II_FRAMES == 1 )
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	BaseType_t xNetworkRxBatchAdd( NetworkRxBatch_t *pxBatch, NetworkBufferDescriptor_t *pxNetworkBuffer, TickType_t xBlockTimeTicks )
 	{
-	uint16_t usFrameType;
+	BaseType_t xReturn = pdPASS;
 
-		if( eReturn == eProcessBuffer )
+		pxNetworkBuffer->pxNextBuffer = NULL;
+
+		if( pxBatch->pxHead == NULL )
 		{
-			usFrameType = pxEthernetHeader->usFrameType;
-			usFrameType = FreeRTOS_ntohs( usFrameType );
+			pxBatch->pxHead = pxNetworkBuffer;
+		}
+		else
+		{
+			pxBatch->pxTail->pxNextBuffer = pxNetworkBuffer;
+		}
 
-			if( usFrameType <= 0x600U )
-			{
-				/* Not an Ethernet II frame. */
-				eReturn = eReleaseBuffer;
-			}
+		pxBatch->pxTail = pxNetworkBuffer;
+		pxBatch->uxCount++;
+
+		if( pxBatch->uxCount >= ( UBaseType_t ) ipconfigNETWORK_RX_BATCH_SIZE )
+		{
+			xReturn = xNetworkRxBatchSend( pxBatch, xBlockTimeTicks );
 		}
+
+		return xReturn;
 	}
-	#endif /* ipconfigFILTER_OUT_NON_ETHERNET_II_FRAMES == 1  */
 
-	return eReturn;
-}
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 /*-----------------------------------------------------------*/
 
-static void prvProcessNetworkDownEvent( void )
-{
-	/* Stop the ARP timer while there is no network. */
-	xARPTimer.bActive = pdFALSE_UNSIGNED;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 
-	#if ipconfigUSE_NETWORK_EVENT_HOOK == 1
+	BaseType_t xNetworkRxBatchSend( NetworkRxBatch_t *pxBatch, TickType_t xBlockTimeTicks )
 	{
-		static BaseType_t xCallEventHook = pdFALSE;
+	IPStackEvent_t xRxEvent;
+	NetworkBufferDescriptor_t *pxNetworkBuffer, *pxNextBuffer;
+	BaseType_t xReturn = pdPASS;
 
-		/* The first network down event is generated by the IP stack itself to
-		initialise the network hardware, so do not call the network down event
-		the first time through. */
-		if( xCallEventHook == pdTRUE )
+		if( pxBatch->pxHead != NULL )
 		{
-			vApplicationIPNetworkEventHook( eNetworkDown );
+			/* The whole chain is passed in a single message, the IP-task will
+			walk through it in prvHandleEthernetPacket(). */
+			#if( ipconfigUSE_NETWORK_RINGS != 0 )
+			{
+				/* The ring never blocks. */
+				( void ) xRxEvent;
+				( void ) xBlockTimeTicks;
+				xReturn = xNetworkRxRingPush( pxBatch->pxHead );
+			}
+			#else
+			{
+				xRxEvent.eEventType = eNetworkRxEvent;
+				xRxEvent.pvData = ( void * ) pxBatch->pxHead;
+
+				xReturn = xSendEventStructToIPTask( &xRxEvent, xBlockTimeTicks );
+			}
+			#endif /* ipconfigUSE_NETWORK_RINGS */
+
+			if( xReturn == pdFAIL )
+			{
+				FreeRTOS_debug_printf( ( "xNetworkRxBatchSend: Can not queue %lu packets\n", ( unsigned long ) pxBatch->uxCount ) );
+
+				/* The buffers could not be sent to the IP-task, release all of
+				them. */
+				for( pxNetworkBuffer = pxBatch->pxHead; pxNetworkBuffer != NULL; pxNetworkBuffer = pxNextBuffer )
+				{
+					pxNextBuffer = pxNetworkBuffer->pxNextBuffer;
+					pxNetworkBuffer->pxNextBuffer = NULL;
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+			else
+			{
+				iptraceNETWORK_INTERFACE_RX_BATCH( pxBatch->uxCount );
+			}
+
+			vNetworkRxBatchInit( pxBatch );
 		}
-		xCallEventHook = pdTRUE;
+
+		return xReturn;
 	}
-	#endif
 
-	/* Per the ARP Cache Validation section of https://tools.ietf.org/html/rfc1122, 
-	treat network down as a "delivery problem" and flush the ARP cache for this
-	interface. */
-	FreeRTOS_ClearARP( );
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+/*-----------------------------------------------------------*/
 
-	/* The network has been disconnected (or is being initialised for the first
-	time).  Perform whatever hardware processing is necessary to bring it up
-	again, or wait for it to be available again.  This is hardware dependent. */
-	if( xNetworkInterfaceInitialise() != pdPASS )
-	{
-		/* Ideally the network interface initialisation function will only
-		return when the network is available.  In case this is not the case,
-		wait a while before retrying the initialisation. */
-		vTaskDelay( ipINITIALISATION_RETRY_DELAY );
-		FreeRTOS_NetworkDown();
-	}
-	else
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+
+	static BaseType_t prvNetworkRingPush( NetworkRing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer )
 	{
-		/* Set remaining time to 0 so it will become active immediately. */
-		#if ipconfigUSE_DHCP == 1
+	UBaseType_t uxHead = pxRing->uxHead;
+	UBaseType_t uxSpace;
+	BaseType_t xReturn;
+
+		/* Both counters are free-running, the difference is the number of
+		packets in the ring, also when the counters wrap around. */
+		uxSpace = ( pxRing->uxMask + 1u ) - ( uxHead - pxRing->uxTail );
+
+		if( uxSpace == 0u )
 		{
-			/* The network is not up until DHCP has completed. */
-			vDHCPProcess( pdTRUE );
-			xSendEventToIPTask( eDHCPEvent );
+			xReturn = pdFAIL;
 		}
-		#else
+		else
 		{
-			/* Perform any necessary 'network up' processing. */
-			vIPNetworkUpCalls();
+			pxRing->ppxItems[ uxHead & pxRing->uxMask ] = pxNetworkBuffer;
+
+			/* The slot must be written before the consumer can see it. */
+			ipconfigMEMORY_BARRIER();
+			pxRing->uxHead = uxHead + 1u;
+
+			if( pxRing->uxMinimumSpace > ( uxSpace - 1u ) )
+			{
+				pxRing->uxMinimumSpace = uxSpace - 1u;
+			}
+			xReturn = pdPASS;
 		}
-		#endif
+
+		return xReturn;
 	}
-}
+
+#endif /* ipconfigUSE_NETWORK_RINGS */
 /*-----------------------------------------------------------*/
 
-void vIPNetworkUpCalls( void )
-{
-	xNetworkUp = pdTRUE;
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
 
-	#if( ipconfigUSE_NETWORK_EVENT_HOOK == 1 )
+	static NetworkBufferDescriptor_t *prvNetworkRingPop( NetworkRing_t *pxRing )
 	{
-		vApplicationIPNetworkEventHook( eNetworkUp );
-	}
-	#endif /* ipconfigUSE_NETWORK_EVENT_HOOK */
+	UBaseType_t uxTail = pxRing->uxTail;
+	NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
 
-	#if( ipconfigDNS_USE_CALLBACKS != 0 )
-	{
-		/* The following function is declared in FreeRTOS_DNS.c	and 'private' to
-		this library */
-		extern void vDNSInitialise( void );
-		vDNSInitialise();
+		if( uxTail != pxRing->uxHead )
+		{
+			/* Don't read the slot before the new head was seen. */
+			ipconfigMEMORY_BARRIER();
+			pxNetworkBuffer = pxRing->ppxItems[ uxTail & pxRing->uxMask ];
+
+			/* The slot must be read before the producer may overwrite it. */
+			ipconfigMEMORY_BARRIER();
+			pxRing->uxTail = uxTail + 1u;
+		}
+
+		return pxNetworkBuffer;
 	}
-	#endif /* ipconfigDNS_USE_CALLBACKS != 0 */
 
-	/* Set remaining time to 0 so it will become active immediately. */
-	prvIPTimerReload( &xARPTimer, pdMS_TO_TICKS( ipARP_TIMER_PERIOD_MS ) );
-}
+#endif /* ipconfigUSE_NETWORK_RINGS */
 /*-----------------------------------------------------------*/
 
-static void prvProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
-{
-EthernetHeader_t *pxEthernetHeader;
-eFrameProcessingResult_t eReturned = eReleaseBuffer;
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+
+	BaseType_t xNetworkRxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	BaseType_t xReturn;
+
+		if( xIPIsNetworkTaskReady() == pdFALSE )
+		{
+			/* The IP-task would never empty the ring. */
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			xReturn = prvNetworkRingPush( &xNetworkRxRing, pxNetworkBuffer );
+
+			if( xReturn == pdFAIL )
+			{
+				FreeRTOS_debug_printf( ( "xNetworkRxRingPush: RX ring is full\n" ) );
+			}
+			else
+			{
+				/* The IP-task clears the flag before it looks at the ring.  The
+				new head must be visible before the flag is read, or both
+				sides could miss the packet. */
+				ipconfigMEMORY_BARRIER();
+
+				if( xRxRingSignalled == pdFALSE )
+				{
+					/* The IP-task is not aware yet of packets in the ring.
+					Send a single message without a buffer to wake it up. */
+					xRxRingSignalled = pdTRUE;
+
+					if( xSendEventToIPTask( eNetworkRxEvent ) == pdFAIL )
+					{
+						/* The event queue is full, so the IP-task will wake up
+						for the queued events, and it checks the ring on every
+						iteration of its loop.  Let the next packet try
+						again. */
+						xRxRingSignalled = pdFALSE;
+					}
+				}
+				else
+				{
+					/* A wake-up message is already on its way. */
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_NETWORK_RINGS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+
+	static void prvProcessNetworkRxRing( void )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+		for( ;; )
+		{
+			pxNetworkBuffer = prvNetworkRingPop( &xNetworkRxRing );
+
+			if( pxNetworkBuffer == NULL )
+			{
+				break;
+			}
+
+			prvHandleEthernetPacket( pxNetworkBuffer );
+		}
+	}
+
+#endif /* ipconfigUSE_NETWORK_RINGS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+
+	BaseType_t xNetworkTxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+		return prvNetworkRingPush( &xNetworkTxRing, pxNetworkBuffer );
+	}
+
+#endif /* ipconfigUSE_NETWORK_RINGS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+
+	NetworkBufferDescriptor_t *pxNetworkTxRingPop( void )
+	{
+		return prvNetworkRingPop( &xNetworkTxRing );
+	}
+
+#endif /* ipconfigUSE_NETWORK_RINGS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+
+	void vNetworkRxPollStartFromISR( void )
+	{
+		/* Only this field is written from an interrupt. */
+		xNetworkRxPollStats.ulInterrupts++;
+	}
+
+#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+
+	BaseType_t xNetworkRxPollComplete( UBaseType_t uxPacketCount )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		xNetworkRxPollStats.ulPolls++;
+		xNetworkRxPollStats.ulPackets += ( uint32_t ) uxPacketCount;
+
+		if( uxPacketCount >= ( UBaseType_t ) ipconfigNETWORK_RX_POLL_BUDGET )
+		{
+			/* There may be more packets in the DMA ring.  The EMAC task
+			normally has the highest priority: sleep for a clock tick, so that
+			the IP-task and the application can process what was received. */
+			xNetworkRxPollStats.ulBudgetExhausted++;
+			vTaskDelay( 1u );
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+/*-----------------------------------------------------------*/
+
+eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
+{
+eFrameProcessingResult_t eReturn;
+const EthernetHeader_t *pxEthernetHeader;
+
+	pxEthernetHeader = ( const EthernetHeader_t * ) pucEthernetBuffer;
+
+	if( memcmp( ( void * ) ipLOCAL_MAC_ADDRESS, ( void * ) &( pxEthernetHeader->xDestinationAddress ), sizeof( MACAddress_t ) ) == 0 )
+	{
+		/* The packet was directed to this node directly - process it. */
+		eReturn = eProcessBuffer;
+	}
+	else if( memcmp( ( void * ) xBroadcastMACAddress.ucBytes, ( void * ) pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+	{
+		/* The packet was a broadcast - process it. */
+		eReturn = eProcessBuffer;
+	}
+	else
+#if( ipconfigUSE_LLMNR == 1 )
+	if( memcmp( ( void * ) xLLMNR_MacAdress.ucBytes, ( void * ) pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+	{
+		/* The packet is a request for LLMNR - process it. */
+		eReturn = eProcessBuffer;
+	}
+	else
+#endif /* ipconfigUSE_LLMNR */
+	{
+		/* The packet was not a broadcast, or for this node, just release
+		the buffer without taking any other action. */
+		eReturn = eReleaseBuffer;
+	}
+
+	#if( ipconfigFILTER_OUT_NON_ETHERNET_II_FRAMES == 1 )
+	{
+	uint16_t usFrameType;
+
+		if( eReturn == eProcessBuffer )
+		{
+			usFrameType = pxEthernetHeader->usFrameType;
+			usFrameType = FreeRTOS_ntohs( usFrameType );
+
+			if( usFrameType <= 0x600U )
+			{
+				/* Not an Ethernet II frame. */
+				eReturn = eReleaseBuffer;
+			}
+		}
+	}
+	#endif /* ipconfigFILTER_OUT_NON_ETHERNET_II_FRAMES == 1  */
+
+	return eReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessNetworkDownEvent( void )
+{
+	/* Stop the ARP timer while there is no network. */
+	xARPTimer.bActive = pdFALSE_UNSIGNED;
+
+	#if ipconfigUSE_NETWORK_EVENT_HOOK == 1
+	{
+		static BaseType_t xCallEventHook = pdFALSE;
+
+		/* The first network down event is generated by the IP stack itself to
+		initialise the network hardware, so do not call the network down event
+		the first time through. */
+		if( xCallEventHook == pdTRUE )
+		{
+			vApplicationIPNetworkEventHook( eNetworkDown );
+		}
+		xCallEventHook = pdTRUE;
+	}
+	#endif
+
+	/* Per the ARP Cache Validation section of https://tools.ietf.org/html/rfc1122, 
+	treat network down as a "delivery problem" and flush the ARP cache for this
+	interface. */
+	FreeRTOS_ClearARP( );
+
+	/* The network has been disconnected (or is being initialised for the first
+	time).  Perform whatever hardware processing is necessary to bring it up
+	again, or wait for it to be available again.  This is hardware dependent. */
+	if( xNetworkInterfaceInitialise() != pdPASS )
+	{
+		/* Ideally the network interface initialisation function will only
+		return when the network is available.  In case this is not the case,
+		wait a while before retrying the initialisation. */
+		vTaskDelay( ipINITIALISATION_RETRY_DELAY );
+		FreeRTOS_NetworkDown();
+	}
+	else
+	{
+		/* Set remaining time to 0 so it will become active immediately. */
+		#if ipconfigUSE_DHCP == 1
+		{
+			/* The network is not up until DHCP has completed. */
+			vDHCPProcess( pdTRUE );
+			xSendEventToIPTask( eDHCPEvent );
+		}
+		#else
+		{
+			/* Perform any necessary 'network up' processing. */
+			vIPNetworkUpCalls();
+		}
+		#endif
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vIPNetworkUpCalls( void )
+{
+	xNetworkUp = pdTRUE;
+
+	#if( ipconfigUSE_NETWORK_EVENT_HOOK == 1 )
+	{
+		vApplicationIPNetworkEventHook( eNetworkUp );
+	}
+	#endif /* ipconfigUSE_NETWORK_EVENT_HOOK */
+
+	#if( ipconfigDNS_USE_CALLBACKS != 0 )
+	{
+		/* The following function is declared in FreeRTOS_DNS.c	and 'private' to
+		this library */
+		extern void vDNSInitialise( void );
+		vDNSInitialise();
+	}
+	#endif /* ipconfigDNS_USE_CALLBACKS != 0 */
+
+	/* Set remaining time to 0 so it will become active immediately. */
+	prvIPTimerReload( &xARPTimer, pdMS_TO_TICKS( ipARP_TIMER_PERIOD_MS ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+EthernetHeader_t *pxEthernetHeader;
+eFrameProcessingResult_t eReturned = eReleaseBuffer;
 
 	configASSERT( pxNetworkBuffer );
 
@@ -1456,6 +2023,7 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 		This method may decrease the usage of sparse network buffers. */
 		uint32_t ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
 
+		#if( ipconfigUSE_IP_FRAGMENTATION == 0 )
 			/* Ensure that the incoming packet is not fragmented (only outgoing
 			packets can be fragmented) as these are the only handled IP frames
 			currently. */
@@ -1464,9 +2032,11 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				/* Can not handle, fragmented packet. */
 				eReturn = eReleaseBuffer;
 			}
+			else
+		#endif /* ipconfigUSE_IP_FRAGMENTATION */
 			/* 0x45 means: IPv4 with an IP header of 5 x 4 = 20 bytes
 			 * 0x47 means: IPv4 with an IP header of 7 x 4 = 28 bytes */
-			else if( ( pxIPHeader->ucVersionHeaderLength < 0x45u ) || ( pxIPHeader->ucVersionHeaderLength > 0x4Fu ) )
+			if( ( pxIPHeader->ucVersionHeaderLength < 0x45u ) || ( pxIPHeader->ucVersionHeaderLength > 0x4Fu ) )
 			{
 				/* Can not handle, unknown or invalid header version. */
 				eReturn = eReleaseBuffer;
@@ -1503,8 +2073,10 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				/* Check sum in IP-header not correct. */
 				eReturn = eReleaseBuffer;
 			}
-			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct? */
-			else if( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct?  For a
+			fragment, it will be checked once the datagram is complete. */
+			else if( ( ipIS_FRAGMENT( pxIPHeader ) == pdFALSE ) &&
+				( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC ) )
 			{
 				/* Protocol checksum not accepted. */
 				eReturn = eReleaseBuffer;
@@ -1566,6 +2138,27 @@ uint8_t ucProtocol;
 												( ( ipSIZE_OF_IPv4_HEADER >> 2 ) & 0x0F ); /* Low nibble is the header size, in bytes, divided by four. */
 		}
 
+		#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+		{
+			if( ipIS_FRAGMENT( pxIPHeader ) )
+			{
+			NetworkBufferDescriptor_t *pxDatagram;
+
+				/* The fragment is either stored or released.  When it completes
+				a datagram, the datagram is processed as if it was received in a
+				single packet. */
+				pxDatagram = prvIPReassemble( pxNetworkBuffer, uxHeaderLength );
+
+				if( pxDatagram != NULL )
+				{
+					prvProcessEthernetPacket( pxDatagram );
+				}
+
+				return eFrameConsumed;
+			}
+		}
+		#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 		/* Add the IP and MAC addresses to the ARP table if they are not
 		already there - otherwise refresh the age of the existing
 		entry. */
@@ -1679,6 +2272,353 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+
+	static NetworkBufferDescriptor_t *prvIPReassemble( NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength )
+	{
+	IPHeader_t *pxIPHeader = &( ( ( IPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xIPHeader );
+	IPReassembly_t *pxDatagram = NULL, *pxFree = NULL, *pxOldest = NULL, *pxSlot;
+	NetworkBufferDescriptor_t *pxFragment, *pxReturn = NULL;
+	const ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd;
+	size_t uxIPLength, uxLength, uxOffset, uxFragmentOffset, uxFragmentLength;
+	uint16_t usFlags;
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex, xDrop = pdFALSE, xDropDatagram = pdFALSE;
+
+		xIPFragmentStats.ulFragmentsReceived++;
+
+		usFlags = FreeRTOS_ntohs( pxIPHeader->usFragmentOffset );
+		uxOffset = ( ( size_t ) ( usFlags & ipFRAGMENT_OFFSET_MASK ) ) << 3;
+		uxIPLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+
+		iptraceIP_FRAGMENT_RECEIVED( pxIPHeader->ulSourceIPAddress, FreeRTOS_ntohs( pxIPHeader->usIdentification ), uxOffset );
+
+		/* IP options have been removed already, but the length field still
+		includes them. */
+		if( uxIPLength > ( size_t ) uxHeaderLength )
+		{
+			uxLength = uxIPLength - ( size_t ) uxHeaderLength;
+		}
+		else
+		{
+			uxLength = 0u;
+		}
+
+		if( ( uxLength == 0u ) || ( uxLength > ( pxNetworkBuffer->xDataLength - ipIP_PAYLOAD_OFFSET ) ) )
+		{
+			/* The packet is shorter than its length field claims. */
+			xDrop = pdTRUE;
+		}
+		else if( ( ( usFlags & ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) != 0u ) && ( ( uxLength & 0x07u ) != 0u ) )
+		{
+			/* Only the last fragment may have a length which is not a
+			multiple of 8 bytes. */
+			xDrop = pdTRUE;
+		}
+		else if( ( ( size_t ) ipSIZE_OF_IPv4_HEADER + uxOffset + uxLength ) > ( size_t ) ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE )
+		{
+			/* The datagram would become too big. */
+			xDrop = pdTRUE;
+		}
+		else if( ( xBufferAllocFixedSize != pdFALSE ) && ( ( ipIP_PAYLOAD_OFFSET + uxOffset + uxLength ) > ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE ) )
+		{
+			/* The datagram would not fit in a network buffer of fixed size. */
+			xDrop = pdTRUE;
+		}
+		else if( xIPFragmentStats.uxBuffersInUse >= ( UBaseType_t ) ipconfigIP_REASSEMBLY_MAX_BUFFERS )
+		{
+			/* The fragment cache is full, incomplete datagrams will be dropped
+			by prvIPReassemblyAgeing(). */
+			xDrop = pdTRUE;
+		}
+		else
+		{
+			/* Find the datagram to which this fragment belongs, or else a free
+			slot. */
+			for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_DATAGRAMS; xIndex++ )
+			{
+				pxSlot = &( xReassemblyList[ xIndex ] );
+
+				if( listCURRENT_LIST_LENGTH( &( pxSlot->xFragmentList ) ) == 0u )
+				{
+					if( pxFree == NULL )
+					{
+						pxFree = pxSlot;
+					}
+				}
+				else if( ( pxSlot->usIdentification == pxIPHeader->usIdentification ) &&
+						 ( pxSlot->ulSourceAddress == pxIPHeader->ulSourceIPAddress ) &&
+						 ( pxSlot->ulDestinationAddress == pxIPHeader->ulDestinationIPAddress ) &&
+						 ( pxSlot->ucProtocol == pxIPHeader->ucProtocol ) )
+				{
+					pxDatagram = pxSlot;
+					break;
+				}
+				else if( ( pxOldest == NULL ) || ( ( xNow - pxSlot->xStartTime ) > ( xNow - pxOldest->xStartTime ) ) )
+				{
+					pxOldest = pxSlot;
+				}
+				else
+				{
+					/* This slot is in use by a younger datagram. */
+				}
+			}
+
+			if( pxDatagram == NULL )
+			{
+				if( pxFree == NULL )
+				{
+					/* All slots are in use, make space by dropping the oldest
+					incomplete datagram. */
+					prvIPReassemblyRelease( pxOldest );
+					xIPFragmentStats.ulDatagramsDropped++;
+					pxFree = pxOldest;
+				}
+
+				pxDatagram = pxFree;
+				vListInitialise( &( pxDatagram->xFragmentList ) );
+				pxDatagram->xStartTime = xNow;
+				pxDatagram->ulSourceAddress = pxIPHeader->ulSourceIPAddress;
+				pxDatagram->ulDestinationAddress = pxIPHeader->ulDestinationIPAddress;
+				pxDatagram->usIdentification = pxIPHeader->usIdentification;
+				pxDatagram->ucProtocol = pxIPHeader->ucProtocol;
+				pxDatagram->uxTotalLength = 0u;
+				pxDatagram->uxReceivedLength = 0u;
+
+				if( xReassemblyTimer.bActive == pdFALSE_UNSIGNED )
+				{
+					prvIPTimerReload( &xReassemblyTimer, pdMS_TO_TICKS( ipIP_REASSEMBLY_TIMER_PERIOD_MS ) );
+				}
+			}
+
+			/* Compare the new fragment with the fragments already received. */
+			pxEnd = ( const MiniListItem_t * ) listGET_END_MARKER( &( pxDatagram->xFragmentList ) );
+
+			for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( const ListItem_t * ) pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				pxFragment = ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+				uxFragmentOffset = ( size_t ) listGET_LIST_ITEM_VALUE( pxIterator );
+				uxFragmentLength = pxFragment->xDataLength - ipIP_PAYLOAD_OFFSET;
+
+				if( ( uxFragmentOffset == uxOffset ) && ( uxFragmentLength == uxLength ) )
+				{
+					/* A duplicate, the fragment was retransmitted. */
+					xDrop = pdTRUE;
+					break;
+				}
+
+				if( ( uxOffset < ( uxFragmentOffset + uxFragmentLength ) ) && ( uxFragmentOffset < ( uxOffset + uxLength ) ) )
+				{
+					/* Overlapping fragments are not accepted, they might be used
+					to hide data from a packet filter. */
+					xDropDatagram = pdTRUE;
+					break;
+				}
+
+				if( ( ( usFlags & ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) == 0u ) && ( ( uxFragmentOffset + uxFragmentLength ) > ( uxOffset + uxLength ) ) )
+				{
+					/* This is the last fragment, but data was received beyond
+					its end. */
+					xDropDatagram = pdTRUE;
+					break;
+				}
+			}
+
+			if( ( xDrop == pdFALSE ) && ( xDropDatagram == pdFALSE ) && ( pxDatagram->uxTotalLength != 0u ) )
+			{
+				if( ( ( usFlags & ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) == 0u ) || ( ( uxOffset + uxLength ) > pxDatagram->uxTotalLength ) )
+				{
+					/* A second last fragment, or data beyond the last fragment. */
+					xDropDatagram = pdTRUE;
+				}
+			}
+
+			if( xDropDatagram != pdFALSE )
+			{
+				prvIPReassemblyRelease( pxDatagram );
+				xIPFragmentStats.ulDatagramsDropped++;
+				xDrop = pdTRUE;
+			}
+			else if( xDrop == pdFALSE )
+			{
+				if( ( usFlags & ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) == 0u )
+				{
+					pxDatagram->uxTotalLength = uxOffset + uxLength;
+				}
+
+				/* Remove any Ethernet padding, and store the fragment, sorted on
+				its offset. */
+				pxNetworkBuffer->xDataLength = ipIP_PAYLOAD_OFFSET + uxLength;
+				listSET_LIST_ITEM_OWNER( &( pxNetworkBuffer->xBufferListItem ), ( void * ) pxNetworkBuffer );
+				listSET_LIST_ITEM_VALUE( &( pxNetworkBuffer->xBufferListItem ), ( TickType_t ) uxOffset );
+				vListInsert( &( pxDatagram->xFragmentList ), &( pxNetworkBuffer->xBufferListItem ) );
+				pxDatagram->uxReceivedLength += uxLength;
+
+				xIPFragmentStats.uxBuffersInUse++;
+				xIPFragmentStats.uxBytesInUse += uxLength;
+
+				if( xIPFragmentStats.uxBuffersInUseMax < xIPFragmentStats.uxBuffersInUse )
+				{
+					xIPFragmentStats.uxBuffersInUseMax = xIPFragmentStats.uxBuffersInUse;
+				}
+
+				if( xIPFragmentStats.uxBytesInUseMax < xIPFragmentStats.uxBytesInUse )
+				{
+					xIPFragmentStats.uxBytesInUseMax = xIPFragmentStats.uxBytesInUse;
+				}
+
+				/* As fragments do not overlap, the datagram is complete when
+				the number of bytes received equals its length. */
+				if( ( pxDatagram->uxTotalLength != 0u ) && ( pxDatagram->uxReceivedLength == pxDatagram->uxTotalLength ) )
+				{
+					pxReturn = prvIPReassemblyJoin( pxDatagram );
+
+					if( pxReturn != NULL )
+					{
+						iptraceIP_REASSEMBLY_COMPLETE( pxDatagram->ulSourceAddress, FreeRTOS_ntohs( pxDatagram->usIdentification ), pxDatagram->uxTotalLength );
+						xIPFragmentStats.ulDatagramsReassembled++;
+					}
+					else
+					{
+						xIPFragmentStats.ulDatagramsDropped++;
+					}
+
+					/* This also releases 'pxNetworkBuffer'. */
+					prvIPReassemblyRelease( pxDatagram );
+				}
+			}
+			else
+			{
+				/* The duplicate will be released below. */
+			}
+		}
+
+		if( xDrop != pdFALSE )
+		{
+			iptraceIP_FRAGMENT_DROPPED( pxIPHeader->ulSourceIPAddress, FreeRTOS_ntohs( pxIPHeader->usIdentification ) );
+			xIPFragmentStats.ulFragmentsDropped++;
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static NetworkBufferDescriptor_t *prvIPReassemblyJoin( IPReassembly_t *pxDatagram )
+	{
+	NetworkBufferDescriptor_t *pxReturn, *pxFragment;
+	const ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t * ) listGET_END_MARKER( &( pxDatagram->xFragmentList ) );
+	IPHeader_t *pxIPHeader;
+	size_t uxOffset;
+
+		pxReturn = pxGetNetworkBufferWithDescriptor( ipIP_PAYLOAD_OFFSET + pxDatagram->uxTotalLength, ( TickType_t ) 0u );
+
+		if( pxReturn != NULL )
+		{
+			pxReturn->xDataLength = ipIP_PAYLOAD_OFFSET + pxDatagram->uxTotalLength;
+
+			for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( const ListItem_t * ) pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				pxFragment = ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+				uxOffset = ( size_t ) listGET_LIST_ITEM_VALUE( pxIterator );
+
+				if( uxOffset == 0u )
+				{
+					/* The Ethernet and IP headers are taken from the first
+					fragment. */
+					memcpy( pxReturn->pucEthernetBuffer, pxFragment->pucEthernetBuffer, pxFragment->xDataLength );
+				}
+				else
+				{
+					memcpy( &( pxReturn->pucEthernetBuffer[ ipIP_PAYLOAD_OFFSET + uxOffset ] ),
+						&( pxFragment->pucEthernetBuffer[ ipIP_PAYLOAD_OFFSET ] ), pxFragment->xDataLength - ipIP_PAYLOAD_OFFSET );
+				}
+			}
+
+			pxIPHeader = &( ( ( IPPacket_t * ) pxReturn->pucEthernetBuffer )->xIPHeader );
+			pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + pxDatagram->uxTotalLength ) );
+			pxIPHeader->usFragmentOffset = 0u;
+
+			#if( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM == 0 )
+			{
+				/* The new IP header will be checked by prvAllowIPPacket(), just
+				like the protocol checksum. */
+				pxIPHeader->usHeaderChecksum = 0x00u;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+			}
+			#else
+			{
+				/* The driver has only seen the fragments, so it could not check
+				the protocol checksum. */
+				if( usGenerateProtocolChecksum( pxReturn->pucEthernetBuffer, pxReturn->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxReturn );
+					pxReturn = NULL;
+				}
+			}
+			#endif /* ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM */
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyRelease( IPReassembly_t *pxDatagram )
+	{
+	NetworkBufferDescriptor_t *pxFragment;
+
+		while( listCURRENT_LIST_LENGTH( &( pxDatagram->xFragmentList ) ) != 0u )
+		{
+			pxFragment = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxDatagram->xFragmentList ) );
+			( void ) uxListRemove( &( pxFragment->xBufferListItem ) );
+
+			xIPFragmentStats.uxBuffersInUse--;
+			xIPFragmentStats.uxBytesInUse -= pxFragment->xDataLength - ipIP_PAYLOAD_OFFSET;
+
+			vReleaseNetworkBufferAndDescriptor( pxFragment );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvIPReassemblyAgeing( void )
+	{
+	IPReassembly_t *pxDatagram;
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex, xPending = pdFALSE;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_DATAGRAMS; xIndex++ )
+		{
+			pxDatagram = &( xReassemblyList[ xIndex ] );
+
+			if( listCURRENT_LIST_LENGTH( &( pxDatagram->xFragmentList ) ) != 0u )
+			{
+				if( ( xNow - pxDatagram->xStartTime ) >= pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS ) )
+				{
+					/* The missing fragments did not arrive in time. */
+					iptraceIP_REASSEMBLY_TIMEOUT( pxDatagram->ulSourceAddress, FreeRTOS_ntohs( pxDatagram->usIdentification ) );
+					xIPFragmentStats.ulReassemblyTimeouts++;
+					prvIPReassemblyRelease( pxDatagram );
+				}
+				else
+				{
+					xPending = pdTRUE;
+				}
+			}
+		}
+
+		return xPending;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 #if ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
 
 	static void prvProcessICMPEchoReply( ICMPPacket_t * const pxICMPPacket )
@@ -1808,6 +2748,26 @@ uint8_t ucProtocol;
 /*-----------------------------------------------------------*/
 
 uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength, BaseType_t xOutgoingPacket )
+{
+	return prvGenerateProtocolChecksum( pucEthernetBuffer, uxBufferLength, xOutgoingPacket, 0u, ( size_t ) 0u );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+
+	uint16_t usGenerateProtocolChecksumWithPayload( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength,
+		uint16_t usPayloadChecksum, size_t uxPayloadLength )
+	{
+		/* Only used for outgoing packets, the checksum of the payload was
+		calculated by usGenerateChecksumCopy() while copying it. */
+		return prvGenerateProtocolChecksum( pucEthernetBuffer, uxBufferLength, pdTRUE, usPayloadChecksum, uxPayloadLength );
+	}
+
+#endif /* ipconfigUSE_CHECKSUM_COPY */
+/*-----------------------------------------------------------*/
+
+static uint16_t prvGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength, BaseType_t xOutgoingPacket,
+	uint16_t usPayloadChecksum, size_t uxPayloadLength )
 {
 uint32_t ulLength;
 uint16_t usChecksum, *pusChecksum;
@@ -1955,9 +2915,25 @@ uint8_t ucProtocol;
 		usChecksum = ( uint16_t ) ( ulLength + ( ( uint16_t ) ucProtocol ) );
 
 		/* And then continue at the IPv4 source and destination addresses. */
-		usChecksum = ( uint16_t )
-			( ~usGenerateChecksum( ( uint32_t ) usChecksum, ( uint8_t * )&( pxIPPacket->xIPHeader.ulSourceIPAddress ),
-				( 2u * sizeof( pxIPPacket->xIPHeader.ulSourceIPAddress ) + ulLength ) ) );
+		if( ( uxPayloadLength != 0u ) && ( uxPayloadLength <= ulLength ) && ( ( ( ulLength - uxPayloadLength ) & 1u ) == 0u ) )
+		{
+		uint32_t ulSum;
+
+			/* The payload has been summed already, only sum the addresses and
+			the protocol header.  The payload starts at an even offset, so both
+			sums can be added. */
+			ulSum = ( uint32_t ) usGenerateChecksum( ( uint32_t ) usChecksum, ( uint8_t * )&( pxIPPacket->xIPHeader.ulSourceIPAddress ),
+				( 2u * sizeof( pxIPPacket->xIPHeader.ulSourceIPAddress ) + ( ulLength - uxPayloadLength ) ) );
+			ulSum += ( uint32_t ) usPayloadChecksum;
+			ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+			usChecksum = ( uint16_t ) ~ulSum;
+		}
+		else
+		{
+			usChecksum = ( uint16_t )
+				( ~usGenerateChecksum( ( uint32_t ) usChecksum, ( uint8_t * )&( pxIPPacket->xIPHeader.ulSourceIPAddress ),
+					( 2u * sizeof( pxIPPacket->xIPHeader.ulSourceIPAddress ) + ulLength ) ) );
+		}
 
 		/* Sum TCP header and data. */
 	}
@@ -2010,6 +2986,132 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes )
+{
+	return prvGenerateChecksum( ulSum, ( uint8_t * ) pucNextData, NULL, uxDataLengthBytes );
+}
+/*-----------------------------------------------------------*/
+
+uint16_t usGenerateChecksumCopy( uint32_t ulSum, uint8_t * pucDestination, const uint8_t * pucSource, size_t uxDataLengthBytes )
+{
+	/* Copy the data and return the same value as usGenerateChecksum() would
+	return for the data at 'pucDestination'. */
+	return prvGenerateChecksum( ulSum, pucDestination, pucSource, uxDataLengthBytes );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvChecksumAddWords( uint64_t ullSum, const uint32_t *pulSource, uint32_t *pulDestination, size_t uxWordCount )
+{
+	/* The 32-bit words are added to a 64-bit accumulator.  The carries will
+	simply be counted in the upper 32 bits, they are added to the lower bits
+	afterwards.  This accumulator can not overflow for any packet size. */
+
+	#if( ipCHECKSUM_USE_SSE2 == 1 )
+	{
+	__m128i xData, xSumLow, xSumHigh;
+	const __m128i xZero = _mm_setzero_si128();
+	uint64_t ullLanes[ 2 ];
+
+		/* Four words at a time, each word is zero-extended to a 64-bit
+		lane. */
+		xSumLow = xZero;
+		xSumHigh = xZero;
+
+		while( uxWordCount >= 4u )
+		{
+			xData = _mm_loadu_si128( ( const __m128i * ) pulSource );
+
+			if( pulDestination != NULL )
+			{
+				_mm_storeu_si128( ( __m128i * ) pulDestination, xData );
+				pulDestination += 4;
+			}
+
+			xSumLow = _mm_add_epi64( xSumLow, _mm_unpacklo_epi32( xData, xZero ) );
+			xSumHigh = _mm_add_epi64( xSumHigh, _mm_unpackhi_epi32( xData, xZero ) );
+			pulSource += 4;
+			uxWordCount -= 4u;
+		}
+
+		_mm_storeu_si128( ( __m128i * ) ullLanes, _mm_add_epi64( xSumLow, xSumHigh ) );
+		ullSum += ullLanes[ 0 ];
+		ullSum += ullLanes[ 1 ];
+	}
+	#elif( ipCHECKSUM_USE_NEON == 1 )
+	{
+	uint32x4_t xData;
+	uint64x2_t xSum = vdupq_n_u64( 0u );
+
+		/* Four words at a time, added pairwise to two 64-bit lanes. */
+		while( uxWordCount >= 4u )
+		{
+			xData = vld1q_u32( pulSource );
+
+			if( pulDestination != NULL )
+			{
+				vst1q_u32( pulDestination, xData );
+				pulDestination += 4;
+			}
+
+			xSum = vpadalq_u32( xSum, xData );
+			pulSource += 4;
+			uxWordCount -= 4u;
+		}
+
+		ullSum += vgetq_lane_u64( xSum, 0 );
+		ullSum += vgetq_lane_u64( xSum, 1 );
+	}
+	#endif /* ipCHECKSUM_USE_SSE2 / ipCHECKSUM_USE_NEON */
+
+	if( pulDestination == NULL )
+	{
+		/* Indexing with constants gives faster code than using
+		post-increments. */
+		while( uxWordCount >= 4u )
+		{
+			ullSum += pulSource[ 0 ];
+			ullSum += pulSource[ 1 ];
+			ullSum += pulSource[ 2 ];
+			ullSum += pulSource[ 3 ];
+			pulSource += 4;
+			uxWordCount -= 4u;
+		}
+	}
+	else
+	{
+	uint32_t ulWord0, ulWord1;
+
+		while( uxWordCount >= 2u )
+		{
+			ulWord0 = pulSource[ 0 ];
+			ulWord1 = pulSource[ 1 ];
+			pulDestination[ 0 ] = ulWord0;
+			pulDestination[ 1 ] = ulWord1;
+			ullSum += ulWord0;
+			ullSum += ulWord1;
+			pulSource += 2;
+			pulDestination += 2;
+			uxWordCount -= 2u;
+		}
+	}
+
+	while( uxWordCount > 0u )
+	{
+		if( pulDestination != NULL )
+		{
+			*pulDestination = *pulSource;
+			pulDestination++;
+		}
+
+		ullSum += *pulSource;
+		pulSource++;
+		uxWordCount--;
+	}
+
+	return ullSum;
+}
+/*-----------------------------------------------------------*/
+
 /**
  * This method generates a checksum for a given IPv4 header, per RFC791 (page 14).
  * The checksum algorithm is decribed as:
@@ -2025,13 +3127,14 @@ uint8_t ucProtocol;
  * ((received & calculated) == 0) without applying a bitwise 'not' to the 'calculated' checksum.
  *
  * This logic is optimized for microcontrollers which have limited resources, so the logic looks odd.
- * It iterates over the full range of 16-bit words, but it does so by processing several 32-bit
- * words at once whenever possible. Its first step is to align the memory pointer to a 32-bit boundary,
- * after which it runs a fast loop to process multiple 32-bit words at once and adding their 'carries'.
- * Finally, it finishes up by processing any remaining 16-bit words, and adding up all of the 'carries'.
- * With 32-bit arithmetic, the number of 16-bit 'carries' produced by sequential additions can be found
- * by looking at the 16 most-significant bits of the 32-bit integer, since a 32-bit int will continue
- * counting up instead of overflowing after 16 bits. That is why the actual checksum calculations look like:
+ * It iterates over the full range of 16-bit words, but it does so by processing 32-bit words
+ * whenever possible. Its first step is to align the memory pointer to a 32-bit boundary,
+ * after which prvChecksumAddWords() adds all 32-bit words to a 64-bit accumulator, optionally
+ * using SSE2 or NEON instructions. Finally, it finishes up by processing any remaining 16-bit
+ * words, and adding up all of the 'carries'.
+ * With 64-bit arithmetic, the number of 32-bit 'carries' produced by sequential additions can be found
+ * in the 32 most-significant bits of the accumulator.  The sum is then folded into 32 bits, and
+ * twice into 16 bits, like:
  *   union.u32 = ( uint32_t ) union.u16[ 0 ] + union.u16[ 1 ];
  *
  * Arguments:
@@ -2040,30 +3143,33 @@ uint8_t ucProtocol;
  *	 can have pseudo-header fields which need to be included in the checksum.
  *   pucNextData: This argument contains the address of the first byte which this
  *	 method should process. The method's memory iterator is initialized to this value.
+ *   pucSource: If not NULL, the data is copied from this address to pucNextData
+ *	 while it is being summed.
  *   uxDataLengthBytes: This argument contains the number of bytes that this method
  *	 should process.
  */
-uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes )
+static uint16_t prvGenerateChecksum( uint32_t ulSum, uint8_t * pucNextData, const uint8_t * pucSource, size_t uxDataLengthBytes )
 {
-xUnion32 xSum2, xSum, xTerm;
+xUnion32 xSum, xTerm;
 xUnionPtr xSource;		/* Points to first byte */
-xUnionPtr xLastSource;	/* Points to last byte plus one */
-uint32_t ulAlignBits, ulCarry = 0ul;
-
-	/* Small MCUs often spend up to 30% of the time doing checksum calculations
-	This function is optimised for 32-bit CPUs; Each time it will try to fetch
-	32-bits, sums it with an accumulator and counts the number of carries. */
+uint64_t ullSum;
+size_t uxWordCount;
+uint32_t ulAlignBits;
 
 	/* Swap the input (little endian platform only). */
-	xSum.u32 = FreeRTOS_ntohs( ulSum );
+	ullSum = ( uint64_t ) FreeRTOS_ntohs( ulSum );
 	xTerm.u32 = 0ul;
 
-	xSource.u8ptr = ( uint8_t * ) pucNextData;
+	xSource.u8ptr = pucNextData;
 	ulAlignBits = ( ( ( uint32_t ) pucNextData ) & 0x03u ); /* gives 0, 1, 2, or 3 */
 
 	/* If byte (8-bit) aligned... */
 	if( ( ( ulAlignBits & 1ul ) != 0ul ) && ( uxDataLengthBytes >= ( size_t ) 1 ) )
 	{
+		if( pucSource != NULL )
+		{
+			*( xSource.u8ptr ) = *( pucSource++ );
+		}
 		xTerm.u8[ 1 ] = *( xSource.u8ptr );
 		( xSource.u8ptr )++;
 		uxDataLengthBytes--;
@@ -2073,75 +3179,73 @@ uint32_t ulAlignBits, ulCarry = 0ul;
 	/* If half-word (16-bit) aligned... */
 	if( ( ( ulAlignBits == 1u ) || ( ulAlignBits == 2u ) ) && ( uxDataLengthBytes >= 2u ) )
 	{
-		xSum.u32 += *(xSource.u16ptr);
+		if( pucSource != NULL )
+		{
+			xSource.u8ptr[ 0 ] = pucSource[ 0 ];
+			xSource.u8ptr[ 1 ] = pucSource[ 1 ];
+			pucSource += 2;
+		}
+		ullSum += *( xSource.u16ptr );
 		( xSource.u16ptr )++;
 		uxDataLengthBytes -= 2u;
 		/* Now xSource is word (32-bit) aligned. */
 	}
 
 	/* Word (32-bit) aligned, do the most part. */
-	xLastSource.u32ptr = ( xSource.u32ptr + ( uxDataLengthBytes / 4u ) ) - 3u;
+	uxWordCount = uxDataLengthBytes / 4u;
 
-	/* In this loop, four 32-bit additions will be done, in total 16 bytes.
-	Indexing with constants (0,1,2,3) gives faster code than using
-	post-increments. */
-	while( xSource.u32ptr < xLastSource.u32ptr )
+	if( pucSource == NULL )
 	{
-		/* Use a secondary Sum2, just to see if the addition produced an
-		overflow. */
-		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 0 ];
-		if( xSum2.u32 < xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* Now add the secondary sum to the major sum, and remember if there was
-		a carry. */
-		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 1 ];
-		if( xSum2.u32 > xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* And do the same trick once again for indexes 2 and 3 */
-		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 2 ];
-		if( xSum2.u32 < xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 3 ];
-
-		if( xSum2.u32 > xSum.u32 )
-		{
-			ulCarry++;
-		}
-
-		/* And finally advance the pointer 4 * 4 = 16 bytes. */
-		xSource.u32ptr += 4;
+		ullSum = prvChecksumAddWords( ullSum, xSource.u32ptr, NULL, uxWordCount );
+	}
+	else if( ( ( ( uint32_t ) pucSource ) & 0x03u ) == 0u )
+	{
+		/* The source has the same alignment: copy and sum in one go. */
+		ullSum = prvChecksumAddWords( ullSum, ( const uint32_t * ) pucSource, xSource.u32ptr, uxWordCount );
+		pucSource += uxWordCount * 4u;
+	}
+	else
+	{
+		/* The source is not word-aligned, copy it first and sum it while it
+		is still in the cache. */
+		memcpy( xSource.u8ptr, pucSource, uxWordCount * 4u );
+		ullSum = prvChecksumAddWords( ullSum, xSource.u32ptr, NULL, uxWordCount );
+		pucSource += uxWordCount * 4u;
 	}
 
-	/* Now add all carries. */
-	xSum.u32 = ( uint32_t )xSum.u16[ 0 ] + xSum.u16[ 1 ] + ulCarry;
-
-	uxDataLengthBytes %= 16u;
-	xLastSource.u8ptr = ( uint8_t * ) ( xSource.u8ptr + ( uxDataLengthBytes & ~( ( size_t ) 1 ) ) );
+	xSource.u32ptr += uxWordCount;
+	uxDataLengthBytes %= 4u;
 
 	/* Half-word aligned. */
-	while( xSource.u16ptr < xLastSource.u16ptr )
+	if( uxDataLengthBytes >= 2u )
 	{
+		if( pucSource != NULL )
+		{
+			xSource.u8ptr[ 0 ] = pucSource[ 0 ];
+			xSource.u8ptr[ 1 ] = pucSource[ 1 ];
+			pucSource += 2;
+		}
 		/* At least one more short. */
-		xSum.u32 += xSource.u16ptr[ 0 ];
+		ullSum += xSource.u16ptr[ 0 ];
 		xSource.u16ptr++;
 	}
 
 	if( ( uxDataLengthBytes & ( size_t ) 1 ) != 0u )	/* Maybe one more ? */
 	{
+		if( pucSource != NULL )
+		{
+			xSource.u8ptr[ 0 ] = pucSource[ 0 ];
+		}
 		xTerm.u8[ 0 ] = xSource.u8ptr[ 0 ];
 	}
-	xSum.u32 += xTerm.u32;
+	ullSum += xTerm.u32;
+
+	/* Now add all carries: fold the 64-bit sum into 32 bits... */
+	ullSum = ( ullSum & 0xffffffffULL ) + ( ullSum >> 32 );
+	ullSum = ( ullSum & 0xffffffffULL ) + ( ullSum >> 32 );
+	xSum.u32 = ( uint32_t ) ullSum;
 
-	/* Now add all carries again. */
+	/* ... and into 16 bits. */
 	xSum.u32 = ( uint32_t ) xSum.u16[ 0 ] + xSum.u16[ 1 ];
 
 	/* The previous summation might have given a 16-bit carry. */
@@ -2310,6 +3414,29 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 #endif /* ipconfigDNS_USE_CALLBACKS != 0 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	void vIPSetARPPendingTimerEnableState( BaseType_t xEnableState )
+	{
+		if( xEnableState != pdFALSE )
+		{
+			xARPPendingTimer.bActive = pdTRUE_UNSIGNED;
+		}
+		else
+		{
+			xARPPendingTimer.bActive = pdFALSE_UNSIGNED;
+		}
+	}
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	void vIPReloadARPPendingTimer( uint32_t ulCheckTime )
+	{
+		prvIPTimerReload( &xARPPendingTimer, ulCheckTime );
+	}
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+/*-----------------------------------------------------------*/
+
 BaseType_t xIPIsNetworkTaskReady( void )
 {
 	return xIPTaskInitialised;
@@ -2330,6 +3457,52 @@ BaseType_t FreeRTOS_IsNetworkUp( void )
 #endif
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	UBaseType_t uxGetMinimumRxRingSpace( void )
+	{
+		return xNetworkRxRing.uxMinimumSpace;
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	UBaseType_t uxGetMinimumTxRingSpace( void )
+	{
+		return xNetworkTxRing.uxMinimumSpace;
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	void FreeRTOS_GetIPFragmentStats( IPFragmentStats_t *pxStats )
+	{
+		configASSERT( pxStats != NULL );
+
+		/* The statistics are updated by the IP-task. */
+		vTaskSuspendAll();
+		{
+			memcpy( ( void * ) pxStats, ( const void * ) &xIPFragmentStats, sizeof( *pxStats ) );
+		}
+		( void ) xTaskResumeAll();
+	}
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	void FreeRTOS_GetNetworkRxPollStats( NetworkRxPollStats_t *pxStats )
+	{
+		configASSERT( pxStats != NULL );
+
+		/* 'ulInterrupts' is updated from an interrupt. */
+		taskENTER_CRITICAL();
+		{
+			memcpy( ( void * ) pxStats, ( const void * ) &xNetworkRxPollStats, sizeof( *pxStats ) );
+		}
+		taskEXIT_CRITICAL();
+	}
+#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+/*-----------------------------------------------------------*/
+
 /* Provide access to private members for verification. */
 #ifdef FREERTOS_TCP_ENABLE_VERIFICATION
 	#include "aws_freertos_ip_verification_access_ip_define.h"
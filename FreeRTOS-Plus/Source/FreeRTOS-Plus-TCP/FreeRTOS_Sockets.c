@@ -50,6 +50,12 @@ port number. */
 xBoundUDPSocketsList or xBoundTCPSocketsList */
 #define socketSOCKET_IS_BOUND( pxSocket )	  ( listLIST_ITEM_CONTAINER( & ( pxSocket )->xBoundSocketListItem ) != NULL )
 
+#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+	/* The bucket in xUDPHashTable[] for a port number in network-byte-order. */
+	#define socketUDP_HASH_BUCKET( xPort ) \
+		( &( xUDPHashTable[ ( ( UBaseType_t ) FreeRTOS_ntohs( ( uint16_t ) ( xPort ) ) ) % ( UBaseType_t ) ipconfigUDP_HASH_TABLE_SIZE ] ) )
+#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
 /* If FreeRTOS_sendto() is called on a socket that is not bound to a port
 number then, depending on the FreeRTOSIPConfig.h settings, it might be that a
 port number is automatically generated for the socket.  Automatically generated
@@ -122,11 +128,41 @@ static BaseType_t prvValidSocket( FreeRTOS_Socket_t *pxSocket, BaseType_t xProto
  */
 static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol, size_t *pxSocketSize );
 
+/*
+ * Wait until a UDP socket has received packets, the block time expires, or
+ * the socket is signalled.  Returns the number of packets waiting.
+ */
+static BaseType_t prvUDPWaitForData( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits );
+
+/*
+ * The largest payload that FreeRTOS_sendto() can send in a single datagram.
+ */
+static size_t prvUDPMaxPayloadLength( void );
+
+/*
+ * Copy the payload of an outgoing UDP packet into a network buffer, and
+ * calculate its checksum on the way when that is possible.
+ */
+static void prvUDPCopyPayload( const FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, const void *pvBuffer, size_t xTotalDataLength );
+
+/*
+ * Fill in the fields of a network buffer that vProcessGeneratedUDPPacket()
+ * needs to send a UDP packet.
+ */
+static void prvUDPSetDestination( const FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, size_t xTotalDataLength,
+	const struct freertos_sockaddr *pxDestinationAddress );
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Create a txStream or a rxStream, depending on the parameter 'xIsInputStream'
 	 */
 	static StreamBuffer_t *prvTCPCreateStream (FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
+
+	/*
+	 * Allocate a stream that can hold at least 'uxLength' bytes, or free one.
+	 */
+	static StreamBuffer_t *prvTCPStreamAllocate( size_t uxLength );
+	static void prvTCPStreamFree( StreamBuffer_t *pxBuffer );
 #endif /* ipconfigUSE_TCP == 1 */
 
 #if( ipconfigUSE_TCP == 1 )
@@ -137,6 +173,15 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_REFERENCES != 0 )
+	/*
+	 * Called from FreeRTOS_sendv(): let 'uxCount' bytes of the TX stream refer
+	 * to a buffer of the application in stead of copying them.  Returns pdFALSE
+	 * when all reference entries are in use.
+	 */
+	static BaseType_t prvTCPAddTxReference( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucData, size_t uxCount );
+#endif /* ipconfigUSE_TCP */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * When a child socket gets closed, make sure to update the child-count of the parent
@@ -152,6 +197,96 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static BaseType_t prvTCPConnectStart( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr *pxAddress );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+	/*
+	 * Calculate the bucket in xTCPHashTable[] for a combination of a local
+	 * port, a remote IP address and a remote port.
+	 */
+	static UBaseType_t prvTCPHashIndex( UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort );
+
+	/*
+	 * Move a bound TCP socket to the bucket that belongs to its current state
+	 * and remote address.  Only to be called from the IP-task.
+	 */
+	static void prvTCPHashInsert( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Re-hash all bound TCP sockets, after one or more of them have changed
+	 * outside the IP-task.
+	 */
+	static void prvTCPHashRebuild( void );
+#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * A user API has set 'usTimeout' to 1 and asks the IP-task to attend to
+	 * the socket.
+	 */
+	static BaseType_t prvTCPSendTimerEvent( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Called after data has been taken from the RX stream: when the low-water
+	 * mark had been reached and enough space has become available, the IP-task
+	 * will be asked to send a window update.
+	 */
+	static void prvTCPCheckLowWater( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_TCP */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	/*
+	 * Store a socket in the timer wheel, or in xTCPTimerDueList when the
+	 * time of expiry has been reached already.
+	 */
+	static void prvTCPTimerInsert( FreeRTOS_Socket_t *pxSocket, TickType_t xExpiryTime );
+
+	/*
+	 * Take a socket out of the timer wheel, if it is stored in it.
+	 */
+	static void prvTCPTimerUnlink( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Move the sockets from the next slot of the higher levels to the lower
+	 * levels of the wheel.
+	 */
+	static void prvTCPTimerCascade( void );
+
+	/*
+	 * Returns the number of sockets stored in the wheel.
+	 */
+	static UBaseType_t prvTCPTimerCount( void );
+
+	/*
+	 * Call xTCPSocketCheck() for all sockets in a list of expired sockets.
+	 */
+	static void prvTCPTimerAttend( List_t *pxList );
+
+	/*
+	 * Find the time until the next slot of the wheel that must be visited.
+	 */
+	static TickType_t prvTCPTimerNextExpiry( TickType_t xNow, TickType_t xShortest );
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	/*
+	 * Calculate the new size of a stream, based on the number of bytes that
+	 * were transferred per RTT and on the memory that is still available.
+	 */
+	static size_t prvTCPAutoTuneTarget( size_t uxCurrent, size_t uxBase, size_t uxLimit, uint32_t ulBytesPerRTT, size_t uxMSS );
+
+	/*
+	 * Copy 'uxCount' bytes, starting at the tail, of a stream to a new stream,
+	 * starting at position 0.  Returns pdFALSE if the new stream is too small.
+	 */
+	static BaseType_t prvTCPStreamCopy( const StreamBuffer_t *pxOld, StreamBuffer_t *pxNew, size_t uxCount );
+
+	/*
+	 * Replace the RX or TX stream of a socket with a stream of a different
+	 * size, if it is not in use, and adapt the window.
+	 */
+	static void prvTCPResizeRxStream( FreeRTOS_Socket_t *pxSocket, size_t uxNewSize );
+	static void prvTCPResizeTxStream( FreeRTOS_Socket_t *pxSocket, size_t uxNewSize );
+#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 #if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 
 	/* Executed by the IP-task, it will check all sockets belonging to a set */
@@ -164,10 +299,90 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 to this list must be protected by critical sections of one kind or another. */
 List_t xBoundUDPSocketsList;
 
+#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+	/* Every socket in xBoundUDPSocketsList is also stored in the bucket of its
+	port number.  The ItemValue of 'xHashListItem' holds the port number, just
+	like the ItemValue of 'xBoundSocketListItem'.  Accessed under the same
+	conditions as xBoundUDPSocketsList. */
+	static List_t xUDPHashTable[ ipconfigUDP_HASH_TABLE_SIZE ];
+#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
 #if ipconfigUSE_TCP == 1
 	List_t xBoundTCPSocketsList;
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+	/* Every bound TCP socket is also stored in this table.  A listening socket
+	is found in the bucket of its local port, any other socket in the bucket of
+	its local port, remote IP address and remote port.  Only the IP-task may
+	access the table. */
+	static List_t xTCPHashTable[ ipconfigTCP_HASH_TABLE_SIZE ];
+
+	/* Becomes true when a socket changes its state or its remote address
+	outside the IP-task, e.g. in FreeRTOS_connect() or FreeRTOS_listen().  The
+	IP-task will re-hash all TCP sockets before the next lookup. */
+	static volatile BaseType_t xTCPHashRebuild = pdFALSE;
+#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	/* The timer wheel has 4 levels of 16 slots.  A slot at level 'n' covers
+	16^n clock ticks, so the wheel covers 65536 ticks, which is the maximum of
+	'usTimeout'. */
+	#define socketTIMER_WHEEL_BITS		4u
+	#define socketTIMER_WHEEL_SLOTS		( 1u << socketTIMER_WHEEL_BITS )
+	#define socketTIMER_WHEEL_MASK		( socketTIMER_WHEEL_SLOTS - 1u )
+	#define socketTIMER_WHEEL_LEVELS	4u
+
+	/* True when the tick count 'xNow' has reached 'xTime', also when the tick
+	count has wrapped around. */
+	#define socketTIME_REACHED( xNow, xTime )	( ( TickType_t ) ( ( xNow ) - ( xTime ) ) <= ( portMAX_DELAY >> 1 ) )
+
+	/* Every TCP socket with a non-zero 'usTimeout' is stored in one of the
+	slots of the wheel, or in xTCPTimerDueList when it must be attended to as
+	soon as possible.  Only the IP-task may access these lists. */
+	static List_t xTCPTimerWheel[ socketTIMER_WHEEL_LEVELS ][ socketTIMER_WHEEL_SLOTS ];
+	static List_t xTCPTimerDueList;
+
+	/* The number of sockets stored in each level of the wheel. */
+	static UBaseType_t uxTCPTimerLevelCount[ socketTIMER_WHEEL_LEVELS ];
+
+	/* The first clock tick of which the slot has not been visited yet. */
+	static TickType_t xTCPTimerWheelTime;
+
+	/* The TCP sockets of which the field 'xEventBits' is non-zero.  Their
+	owners will be woken up before the IP-task goes asleep. */
+	static List_t xTCPEventSocketsList;
+
+	/* The TCP sockets that user tasks have asked attention for.  This is the
+	only list that is also accessed by user tasks, always with the scheduler
+	suspended.  The IP-task empties it on every loop. */
+	static List_t xTCPTimerKickList;
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	/* The total number of bytes occupied by the streams of all TCP sockets.
+	Streams are created by the IP-task and by the owners of sockets, so it is
+	changed while the scheduler is suspended. */
+	static size_t uxTCPStreamMemory = 0u;
+
+	/* The shortest period, in ms, over which the traffic of a socket will be
+	measured. */
+	#define socketAUTO_TUNE_MIN_PERIOD_MS	( 10u )
+
+	/* The owner of a socket marks the stream that it is accessing, so that the
+	IP-task will not replace it in the mean time.  The IP-task itself doesn't
+	need to, because it is the one that replaces streams. */
+	#define socketRX_STREAM_ENTER( pxSocket )	do { if( xIsCallingFromIPTask() == pdFALSE ) { ( pxSocket )->u.xTCP.xAutoTune.ucRxBusy++; } } while( 0 )
+	#define socketRX_STREAM_LEAVE( pxSocket )	do { if( xIsCallingFromIPTask() == pdFALSE ) { ( pxSocket )->u.xTCP.xAutoTune.ucRxBusy--; } } while( 0 )
+	#define socketTX_STREAM_ENTER( pxSocket )	do { if( xIsCallingFromIPTask() == pdFALSE ) { ( pxSocket )->u.xTCP.xAutoTune.ucTxBusy++; } } while( 0 )
+	#define socketTX_STREAM_LEAVE( pxSocket )	do { if( xIsCallingFromIPTask() == pdFALSE ) { ( pxSocket )->u.xTCP.xAutoTune.ucTxBusy--; } } while( 0 )
+#else
+	#define socketRX_STREAM_ENTER( pxSocket )	do {} while( 0 )
+	#define socketRX_STREAM_LEAVE( pxSocket )	do {} while( 0 )
+	#define socketTX_STREAM_ENTER( pxSocket )	do {} while( 0 )
+	#define socketTX_STREAM_LEAVE( pxSocket )	do {} while( 0 )
+#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 /*-----------------------------------------------------------*/
 
 static BaseType_t prvValidSocket( FreeRTOS_Socket_t *pxSocket, BaseType_t xProtocol, BaseType_t xIsBound )
@@ -197,9 +412,49 @@ BaseType_t vNetworkSocketsInit( void )
 {
 	vListInitialise( &xBoundUDPSocketsList );
 
+	#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+	{
+	UBaseType_t uxIndex;
+
+		for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigUDP_HASH_TABLE_SIZE; uxIndex++ )
+		{
+			vListInitialise( &( xUDPHashTable[ uxIndex ] ) );
+		}
+	}
+	#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 		vListInitialise( &xBoundTCPSocketsList );
+
+		#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+		{
+		UBaseType_t uxIndex;
+
+			for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigTCP_HASH_TABLE_SIZE; uxIndex++ )
+			{
+				vListInitialise( &( xTCPHashTable[ uxIndex ] ) );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+		{
+		UBaseType_t uxLevel, uxSlot;
+
+			for( uxLevel = 0u; uxLevel < socketTIMER_WHEEL_LEVELS; uxLevel++ )
+			{
+				for( uxSlot = 0u; uxSlot < socketTIMER_WHEEL_SLOTS; uxSlot++ )
+				{
+					vListInitialise( &( xTCPTimerWheel[ uxLevel ][ uxSlot ] ) );
+				}
+				uxTCPTimerLevelCount[ uxLevel ] = 0u;
+			}
+			vListInitialise( &xTCPTimerDueList );
+			vListInitialise( &xTCPEventSocketsList );
+			vListInitialise( &xTCPTimerKickList );
+		}
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
 
@@ -311,6 +566,13 @@ Socket_t xReturn;
 			{
 				vListInitialise( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
 
+				#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+				{
+					vListInitialiseItem( &( pxSocket->u.xUDP.xHashListItem ) );
+					listSET_LIST_ITEM_OWNER( &( pxSocket->u.xUDP.xHashListItem ), ( void * ) pxSocket );
+				}
+				#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
 				#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
 				{
 					pxSocket->u.xUDP.uxMaxPackets = ( UBaseType_t ) ipconfigUDP_MAX_RX_PACKETS;
@@ -330,6 +592,24 @@ Socket_t xReturn;
 			{
 				if( xProtocol == FREERTOS_IPPROTO_TCP )
 				{
+					#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+					{
+						vListInitialiseItem( &( pxSocket->u.xTCP.xHashListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xHashListItem ), ( void * ) pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
+					#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+					{
+						vListInitialiseItem( &( pxSocket->u.xTCP.xTimerListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xTimerListItem ), ( void * ) pxSocket );
+						vListInitialiseItem( &( pxSocket->u.xTCP.xEventListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xEventListItem ), ( void * ) pxSocket );
+						vListInitialiseItem( &( pxSocket->u.xTCP.xKickListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xKickListItem ), ( void * ) pxSocket );
+					}
+					#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 					/* StreamSize is expressed in number of bytes */
 					/* Round up buffer sizes to nearest multiple of MSS */
 					pxSocket->u.xTCP.usInitMSS	= pxSocket->u.xTCP.usCurMSS = ipconfigTCP_MSS;
@@ -347,6 +627,13 @@ Socket_t xReturn;
 						pxSocket->u.xTCP.uxTxWinSize  = 1u;
 					}
 					#endif
+					#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+					{
+						/* Auto-tuning will not shrink the streams below these sizes. */
+						pxSocket->u.xTCP.xAutoTune.uxRxBaseSize = pxSocket->u.xTCP.uxRxStreamSize;
+						pxSocket->u.xTCP.xAutoTune.uxTxBaseSize = pxSocket->u.xTCP.uxTxStreamSize;
+					}
+					#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
 					/* The above values are just defaults, and can be overridden by
 					calling FreeRTOS_setsockopt().  No buffers will be allocated until a
 					socket is connected and data is exchanged. */
@@ -589,33 +876,15 @@ Socket_t xReturn;
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
-/*
- * FreeRTOS_recvfrom: receive data from a bound socket
- * In this library, the function can only be used with connectionsless sockets
- * (UDP)
- */
-int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+static BaseType_t prvUDPWaitForData( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits )
 {
-BaseType_t lPacketCount = 0;
-NetworkBufferDescriptor_t *pxNetworkBuffer;
-FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+BaseType_t lPacketCount;
 TickType_t xRemainingTime = ( TickType_t ) 0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 BaseType_t xTimed = pdFALSE;
 TimeOut_t xTimeOut;
-int32_t lReturn;
-EventBits_t xEventBits = ( EventBits_t ) 0;
-
-	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
-	{
-		return -pdFREERTOS_ERRNO_EINVAL;
-	}
 
 	lPacketCount = ( BaseType_t ) listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
 
-	/* The function prototype is designed to maintain the expected Berkeley
-	sockets standard, but this implementation does not use all the parameters. */
-	( void ) pxSourceAddressLength;
-
 	while( lPacketCount == 0 )
 	{
 		if( xTimed == pdFALSE )
@@ -629,7 +898,7 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 				#if( ipconfigSUPPORT_SIGNALS != 0 )
 				{
 					/* Just check for the interrupt flag. */
-					xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_INTR,
+					*pxEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_INTR,
 						pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, socketDONT_BLOCK );
 				}
 				#endif /* ipconfigSUPPORT_SIGNALS */
@@ -651,14 +920,14 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		/* Wait for arrival of data.  While waiting, the IP-task may set the
 		'eSOCKET_RECEIVE' bit in 'xEventGroup', if it receives data for this
 		socket, thus unblocking this API call. */
-		xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_RECEIVE | eSOCKET_INTR,
+		*pxEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_RECEIVE | eSOCKET_INTR,
 			pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
 
 		#if( ipconfigSUPPORT_SIGNALS != 0 )
 		{
-			if( ( xEventBits & eSOCKET_INTR ) != 0 )
+			if( ( *pxEventBits & eSOCKET_INTR ) != 0 )
 			{
-				if( ( xEventBits & eSOCKET_RECEIVE ) != 0 )
+				if( ( *pxEventBits & eSOCKET_RECEIVE ) != 0 )
 				{
 					/* Shouldn't have cleared the eSOCKET_RECEIVE flag. */
 					xEventGroupSetBits( pxSocket->xEventGroup, eSOCKET_RECEIVE );
@@ -668,7 +937,7 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		}
 		#else
 		{
-			( void ) xEventBits;
+			( void ) pxEventBits;
 		}
 		#endif /* ipconfigSUPPORT_SIGNALS */
 
@@ -686,6 +955,34 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		}
 	} /* while( lPacketCount == 0 ) */
 
+	return lPacketCount;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * FreeRTOS_recvfrom: receive data from a bound socket
+ * In this library, the function can only be used with connectionsless sockets
+ * (UDP)
+ */
+int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+{
+BaseType_t lPacketCount = 0;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+int32_t lReturn;
+EventBits_t xEventBits = ( EventBits_t ) 0;
+
+	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
+	{
+		return -pdFREERTOS_ERRNO_EINVAL;
+	}
+
+	/* The function prototype is designed to maintain the expected Berkeley
+	sockets standard, but this implementation does not use all the parameters. */
+	( void ) pxSourceAddressLength;
+
+	lPacketCount = prvUDPWaitForData( pxSocket, xFlags, &xEventBits );
+
 	if( lPacketCount != 0 )
 	{
 		taskENTER_CRITICAL();
@@ -777,7 +1074,7 @@ FreeRTOS_Socket_t *pxSocket;
 	( void ) xDestinationAddressLength;
 	configASSERT( pvBuffer );
 
-	if( xTotalDataLength <= ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH )
+	if( xTotalDataLength <= prvUDPMaxPayloadLength() )
 	{
 		/* If the socket is not already bound to an address, bind it now.
 		Passing NULL as the address parameter tells FreeRTOS_bind() to select
@@ -816,7 +1113,7 @@ FreeRTOS_Socket_t *pxSocket;
 
 				if( pxNetworkBuffer != NULL )
 				{
-					memcpy( ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), ( void * ) pvBuffer, xTotalDataLength );
+					prvUDPCopyPayload( pxSocket, pxNetworkBuffer, pvBuffer, xTotalDataLength );
 
 					if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdTRUE )
 					{
@@ -835,15 +1132,7 @@ FreeRTOS_Socket_t *pxSocket;
 
 			if( pxNetworkBuffer != NULL )
 			{
-				/* xDataLength is the size of the total packet, including the Ethernet header. */
-				pxNetworkBuffer->xDataLength = xTotalDataLength + sizeof( UDPPacket_t );
-				pxNetworkBuffer->usPort = pxDestinationAddress->sin_port;
-				pxNetworkBuffer->usBoundPort = ( uint16_t ) socketGET_SOCKET_PORT( pxSocket );
-				pxNetworkBuffer->ulIPAddress = pxDestinationAddress->sin_addr;
-
-				/* The socket options are passed to the IP layer in the
-				space that will eventually get used by the Ethernet header. */
-				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+				prvUDPSetDestination( pxSocket, pxNetworkBuffer, xTotalDataLength, pxDestinationAddress );
 
 				/* Tell the networking task that the packet needs sending. */
 				xStackTxEvent.pvData = pxNetworkBuffer;
@@ -870,7 +1159,7 @@ FreeRTOS_Socket_t *pxSocket;
 					{
 						vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
 					}
-					iptraceSTACK_TX_EVENT_LOST( ipSTACK_TX_EVENT );
+					iptraceSTACK_TX_EVENT_LOST( eStackTxEvent );
 				}
 			}
 			else
@@ -897,1062 +1186,1976 @@ FreeRTOS_Socket_t *pxSocket;
 } /* Tested */
 /*-----------------------------------------------------------*/
 
-/*
- * FreeRTOS_bind() : binds a sockt to a local port number.  If port 0 is
- * provided, a system provided port number will be assigned.  This function can
- * be used for both UDP and TCP sockets.  The actual binding will be performed
- * by the IP-task to avoid mutual access to the bound-socket-lists
- * (xBoundUDPSocketsList or xBoundTCPSocketsList).
- */
-BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr * pxAddress, socklen_t xAddressLength )
+static size_t prvUDPMaxPayloadLength( void )
 {
-IPStackEvent_t xBindEvent;
-FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-BaseType_t xReturn = 0;
-
-	( void ) xAddressLength;
+size_t uxMaxPayloadLength = ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH;
 
-	if( ( pxSocket == NULL ) || ( pxSocket == FREERTOS_INVALID_SOCKET ) )
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
 	{
-		xReturn = -pdFREERTOS_ERRNO_EINVAL;
-	}
-	/* Once a socket is bound to a port, it can not be bound to a different
-	port number */
-	else if( socketSOCKET_IS_BOUND( pxSocket) != pdFALSE )
-	{
-		/* The socket is already bound. */
-		FreeRTOS_debug_printf( ( "vSocketBind: Socket already bound to %d\n", pxSocket->usLocalPort ) );
-		xReturn = -pdFREERTOS_ERRNO_EINVAL;
-	}
-	else
-	{
-		/* Prepare a messages to the IP-task in order to perform the binding.
-		The desired port number will be passed in usLocalPort. */
-		xBindEvent.eEventType = eSocketBindEvent;
-		xBindEvent.pvData = ( void * ) xSocket;
-		if( pxAddress != NULL )
-		{
-			pxSocket->usLocalPort = FreeRTOS_ntohs( pxAddress->sin_port );
-		}
-		else
-		{
-			/* Caller wants to bind to a random port number. */
-			pxSocket->usLocalPort = 0u;
-		}
-
-		/* portMAX_DELAY is used as a the time-out parameter, as binding *must*
-		succeed before the socket can be used.  _RB_ The use of an infinite
-		block time needs be changed as it could result in the task hanging. */
-		if( xSendEventStructToIPTask( &xBindEvent, ( TickType_t ) portMAX_DELAY ) == pdFAIL )
-		{
-			/* Failed to wake-up the IP-task, no use to wait for it */
-			FreeRTOS_debug_printf( ( "FreeRTOS_bind: send event failed\n" ) );
-			xReturn = -pdFREERTOS_ERRNO_ECANCELED;
-		}
-		else
+		/* Larger datagrams will be sent in fragments, provided that they fit
+		in a single network buffer. */
+		if( xBufferAllocFixedSize == pdFALSE )
 		{
-			/* The IP-task will set the 'eSOCKET_BOUND' bit when it has done its
-			job. */
-			xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_BOUND, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, portMAX_DELAY );
-			if( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE )
-			{
-				xReturn = -pdFREERTOS_ERRNO_EINVAL;
-			}
+			uxMaxPayloadLength = ( size_t ) ipMAX_FRAGMENTED_UDP_PAYLOAD_LENGTH;
 		}
 	}
+	#endif
 
-	return xReturn;
+	return uxMaxPayloadLength;
 }
+/*-----------------------------------------------------------*/
 
-/*
- * vSocketBind(): internal version of bind() that should not be called directly.
- * 'xInternal' is used for TCP sockets only: it allows to have several
- * (connected) child sockets bound to the same server port.
- */
-BaseType_t vSocketBind( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr * pxAddress, size_t uxAddressLength, BaseType_t xInternal )
+static void prvUDPCopyPayload( const FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, const void *pvBuffer, size_t xTotalDataLength )
 {
-BaseType_t xReturn = 0; /* In Berkeley sockets, 0 means pass for bind(). */
-List_t *pxSocketList;
-#if( ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 )
-	struct freertos_sockaddr xAddress;
-#endif /* ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND */
-
-#if( ipconfigUSE_TCP == 1 )
-	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+	#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+	if( ( pxSocket->ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
 	{
-		pxSocketList = &xBoundTCPSocketsList;
+		/* Calculate the checksum of the payload while copying it,
+		vProcessGeneratedUDPPacket() will use it. */
+		pxNetworkBuffer->usPayloadChecksum = usGenerateChecksumCopy( 0UL, &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ),
+			( const uint8_t * ) pvBuffer, xTotalDataLength );
+		pxNetworkBuffer->usPayloadLength = ( uint16_t ) xTotalDataLength;
 	}
 	else
-#endif  /* ipconfigUSE_TCP == 1 */
+	#else
 	{
-		pxSocketList = &xBoundUDPSocketsList;
+		( void ) pxSocket;
 	}
+	#endif /* ipconfigUSE_CHECKSUM_COPY */
+	{
+		memcpy( ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), ( void * ) pvBuffer, xTotalDataLength );
+	}
+}
+/*-----------------------------------------------------------*/
 
-	/* The function prototype is designed to maintain the expected Berkeley
-	sockets standard, but this implementation does not use all the parameters. */
-	( void ) uxAddressLength;
+static void prvUDPSetDestination( const FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, size_t xTotalDataLength,
+	const struct freertos_sockaddr *pxDestinationAddress )
+{
+	/* xDataLength is the size of the total packet, including the Ethernet header. */
+	pxNetworkBuffer->xDataLength = xTotalDataLength + sizeof( UDPPacket_t );
+	pxNetworkBuffer->usPort = pxDestinationAddress->sin_port;
+	pxNetworkBuffer->usBoundPort = ( uint16_t ) socketGET_SOCKET_PORT( pxSocket );
+	pxNetworkBuffer->ulIPAddress = pxDestinationAddress->sin_addr;
+
+	/* The socket options are passed to the IP layer in the
+	space that will eventually get used by the Ethernet header. */
+	pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+}
+/*-----------------------------------------------------------*/
 
-	configASSERT( pxSocket );
-	configASSERT( pxSocket != FREERTOS_INVALID_SOCKET );
+#if( ipconfigSUPPORT_UDP_BATCH != 0 )
 
-	#if( ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 )
+	BaseType_t FreeRTOS_sendmmsg( Socket_t xSocket, const FreeRTOS_mmsg_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags )
 	{
-		/* pxAddress will be NULL if sendto() was called on a socket without the
-		socket being bound to an address. In this case, automatically allocate
-		an address and port to the socket. */
-		if( pxAddress == NULL )
-		{
-			pxAddress = &xAddress;
-			/* Put the port to zero to be assigned later. */
-			pxAddress->sin_port = 0u;
-		}
-	}
-	#endif /* ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 */
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	NetworkBufferDescriptor_t *pxFirst = NULL, *pxLast = NULL;
+	IPStackEvent_t xStackTxEvent = { eStackTxBatchEvent, NULL };
+	TimeOut_t xTimeOut;
+	TickType_t xTicksToWait;
+	size_t uxMaxPayloadLength = prvUDPMaxPayloadLength();
+	BaseType_t xIndex = 0;
+	BaseType_t xReturn = 0;
 
-	/* Sockets must be bound before calling FreeRTOS_sendto() if
-	ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND is not set to 1. */
-	configASSERT( pxAddress );
+		configASSERT( ( pxMessages != NULL ) || ( xMessageCount == 0 ) );
 
-	if( pxAddress != NULL )
-	{
-		if( pxAddress->sin_port == 0u )
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE ) == pdFALSE )
 		{
-			pxAddress->sin_port = prvGetPrivatePortNumber( ( BaseType_t )pxSocket->ucProtocol );
-			if( 0 == pxAddress->sin_port )
-			{
-				return -pdFREERTOS_ERRNO_EADDRNOTAVAIL;
-			}
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
 		}
-
-		/* If vSocketBind() is called from the API FreeRTOS_bind() it has been
-		confirmed that the socket was not yet bound to a port.  If it is called
-		from the IP-task, no such check is necessary. */
-
-		/* Check to ensure the port is not already in use.  If the bind is
-		called internally, a port MAY be used by more than one socket. */
-		if( ( ( xInternal == pdFALSE ) || ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP ) ) &&
-			( pxListFindListItemWithValue( pxSocketList, ( TickType_t ) pxAddress->sin_port ) != NULL ) )
+		else if( ( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE ) &&
+				 ( FreeRTOS_bind( xSocket, NULL, 0u ) != 0 ) )
 		{
-			FreeRTOS_debug_printf( ( "vSocketBind: %sP port %d in use\n",
-				pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ? "TC" : "UD",
-				FreeRTOS_ntohs( pxAddress->sin_port ) ) );
-			xReturn = -pdFREERTOS_ERRNO_EADDRINUSE;
+			iptraceSENDTO_SOCKET_NOT_BOUND();
 		}
 		else
 		{
-			/* Allocate the port number to the socket.
-			This macro will set 'xBoundSocketListItem->xItemValue' */
-			socketSET_SOCKET_PORT( pxSocket, pxAddress->sin_port );
+			xTicksToWait = pxSocket->xSendBlockTime;
 
-			/* And also store it in a socket field 'usLocalPort' in host-byte-order,
-			mostly used for logging and debugging purposes */
-			pxSocket->usLocalPort = FreeRTOS_ntohs( pxAddress->sin_port );
+			#if( ipconfigUSE_CALLBACKS != 0 )
+			{
+				if( xIsCallingFromIPTask() != pdFALSE )
+				{
+					/* See the comment in FreeRTOS_sendto(). */
+					xTicksToWait = ( TickType_t )0;
+				}
+			}
+			#endif /* ipconfigUSE_CALLBACKS */
 
-			/* Add the socket to the list of bound ports. */
+			if( ( xFlags & FREERTOS_MSG_DONTWAIT ) != 0 )
 			{
-				/* If the network driver can iterate through 'xBoundUDPSocketsList',
-				by calling xPortHasUDPSocket() then the IP-task must temporarily
-				suspend the scheduler to keep the list in a consistent state. */
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				xTicksToWait = ( TickType_t ) 0;
+			}
+
+			/* The block time applies to the batch as a whole. */
+			vTaskSetTimeOutState( &xTimeOut );
+
+			/* Prepare a network buffer for each datagram, and link them into
+			a chain that is passed to the IP-task in one go. */
+			for( xIndex = 0; xIndex < xMessageCount; xIndex++ )
+			{
+				if( pxMessages[ xIndex ].uxLength > uxMaxPayloadLength )
 				{
-					vTaskSuspendAll();
+					iptraceSENDTO_DATA_TOO_LONG();
+					break;
 				}
-				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 
-				/* Add the socket to 'xBoundUDPSocketsList' or 'xBoundTCPSocketsList' */
-				vListInsertEnd( pxSocketList, &( pxSocket->xBoundSocketListItem ) );
+				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+				{
+					pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( pxMessages[ xIndex ].uxLength + sizeof( UDPPacket_t ), xTicksToWait );
 
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+					if( pxNetworkBuffer == NULL )
+					{
+						iptraceNO_BUFFER_FOR_SENDTO();
+						break;
+					}
+
+					prvUDPCopyPayload( pxSocket, pxNetworkBuffer, pxMessages[ xIndex ].pvBuffer, pxMessages[ xIndex ].uxLength );
+
+					if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdTRUE )
+					{
+						/* The entire block time has been used up. */
+						xTicksToWait = ( TickType_t ) 0;
+					}
+				}
+				else
 				{
-					xTaskResumeAll();
+					pxNetworkBuffer = pxUDPPayloadBuffer_to_NetworkBuffer( pxMessages[ xIndex ].pvBuffer );
+				}
+
+				prvUDPSetDestination( pxSocket, pxNetworkBuffer, pxMessages[ xIndex ].uxLength, &( pxMessages[ xIndex ].xAddress ) );
+
+				pxNetworkBuffer->pxNextBuffer = NULL;
+				if( pxLast == NULL )
+				{
+					pxFirst = pxNetworkBuffer;
+				}
+				else
+				{
+					pxLast->pxNextBuffer = pxNetworkBuffer;
+				}
+				pxLast = pxNetworkBuffer;
+			}
+
+			if( pxFirst != NULL )
+			{
+				/* Ask the IP-task to send all packets, with a single message. */
+				xStackTxEvent.pvData = pxFirst;
+
+				if( xSendEventStructToIPTask( &xStackTxEvent, xTicksToWait ) == pdPASS )
+				{
+					xReturn = xIndex;
+
+					#if( ipconfigUSE_CALLBACKS == 1 )
+					{
+						if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xUDP.pxHandleSent ) )
+						{
+							for( xIndex = 0; xIndex < xReturn; xIndex++ )
+							{
+								pxSocket->u.xUDP.pxHandleSent( ( Socket_t )pxSocket, pxMessages[ xIndex ].uxLength );
+							}
+						}
+					}
+					#endif /* ipconfigUSE_CALLBACKS */
+				}
+				else
+				{
+					/* If the buffers were allocated in this function, release
+					them. */
+					if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+					{
+						while( pxFirst != NULL )
+						{
+							pxNetworkBuffer = pxFirst;
+							pxFirst = pxFirst->pxNextBuffer;
+							vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+						}
+					}
+					iptraceSTACK_TX_EVENT_LOST( eStackTxEvent );
 				}
-				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 			}
 		}
-	}
-	else
-	{
-		xReturn = -pdFREERTOS_ERRNO_EADDRNOTAVAIL;
-		FreeRTOS_debug_printf( ( "vSocketBind: Socket no addr\n" ) );
-	}
 
-	if( xReturn != 0 )
-	{
-		iptraceBIND_FAILED( xSocket, ( FreeRTOS_ntohs( pxAddress->sin_port ) ) );
+		return xReturn;
 	}
 
-	return xReturn;
-} /* Tested */
+#endif /* ipconfigSUPPORT_UDP_BATCH */
 /*-----------------------------------------------------------*/
 
-/*
- * Close a socket and free the allocated space
- * In case of a TCP socket: the connection will not be closed automatically
- * Subsequent messages for the closed socket will be responded to with a RST
- * The IP-task will actually close the socket, after receiving a 'eSocketCloseEvent' message
- */
-BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
-{
-BaseType_t xResult;
-#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 )
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * )xSocket;
-#endif
-IPStackEvent_t xCloseEvent;
-xCloseEvent.eEventType = eSocketCloseEvent;
-xCloseEvent.pvData = ( void * ) xSocket;
+#if( ipconfigSUPPORT_UDP_BATCH != 0 )
 
-	if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
-	{
-		xResult = 0;
-	}
-	else
+	BaseType_t FreeRTOS_recvmmsg( Socket_t xSocket, FreeRTOS_mmsg_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags )
 	{
-		#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 ) )
-		{
-			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
-			{
-				/* Make sure that IP-task won't call the user callback's anymore */
-				pxSocket->u.xTCP.pxHandleConnected = NULL;
-				pxSocket->u.xTCP.pxHandleReceive = NULL;
-				pxSocket->u.xTCP.pxHandleSent = NULL;
-			}
-		}
-		#endif  /* ( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 ) ) */
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	List_t xReceivedList;
+	BaseType_t lPacketCount;
+	BaseType_t xIndex;
+	BaseType_t xReturn;
+	EventBits_t xEventBits = ( EventBits_t ) 0;
+	size_t uxLength;
 
-		/* Let the IP task close the socket to keep it synchronised	with the
-		packet handling. */
+		configASSERT( ( pxMessages != NULL ) || ( xMessageCount == 0 ) );
 
-		/* Note when changing the time-out value below, it must be checked who is calling
-		this function. If it is called by the IP-task, a deadlock could occur.
-		The IP-task would only call it in case of a user call-back */
-		if( xSendEventStructToIPTask( &xCloseEvent, ( TickType_t ) 0 ) == pdFAIL )
-		{
-			FreeRTOS_debug_printf( ( "FreeRTOS_closesocket: failed\n" ) );
-			xResult = -1;
-		}
-		else
+		if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE ) ||
+			( ( xFlags & FREERTOS_MSG_PEEK ) != 0 ) )
 		{
-			xResult = 1;
+			return -pdFREERTOS_ERRNO_EINVAL;
 		}
-	}
-
-	return xResult;
-}
 
-/* This is the internal version of FreeRTOS_closesocket()
- * It will be called by the IPtask only to avoid problems with synchronicity
- */
-void *vSocketClose( FreeRTOS_Socket_t *pxSocket )
-{
-NetworkBufferDescriptor_t *pxNetworkBuffer;
+		lPacketCount = prvUDPWaitForData( pxSocket, xFlags, &xEventBits );
 
-	#if( ipconfigUSE_TCP == 1 )
-	{
-		/* For TCP: clean up a little more. */
-		if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		if( lPacketCount != 0 )
 		{
-			#if( ipconfigUSE_TCP_WIN == 1 )
+			vListInitialise( &xReceivedList );
+
+			/* Take as many packets as will fit in 'pxMessages' within a single
+			critical section. */
+			taskENTER_CRITICAL();
 			{
-				if( pxSocket->u.xTCP.pxAckMessage != NULL )
+				while( ( listCURRENT_LIST_LENGTH( &xReceivedList ) < ( UBaseType_t ) xMessageCount ) &&
+					   ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) != 0u ) )
 				{
-					vReleaseNetworkBufferAndDescriptor( pxSocket->u.xTCP.pxAckMessage );
+					pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+					( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+					vListInsertEnd( &xReceivedList, &( pxNetworkBuffer->xBufferListItem ) );
 				}
-				/* Free the resources which were claimed by the tcpWin member */
-				vTCPWindowDestroy( &pxSocket->u.xTCP.xTCPWindow );
 			}
-			#endif /* ipconfigUSE_TCP_WIN */
+			taskEXIT_CRITICAL();
 
-			/* Free the input and output streams */
-			if( pxSocket->u.xTCP.rxStream != NULL )
-			{
-				vPortFreeLarge( pxSocket->u.xTCP.rxStream );
-			}
+			xReturn = ( BaseType_t ) listCURRENT_LIST_LENGTH( &xReceivedList );
 
-			if( pxSocket->u.xTCP.txStream != NULL )
+			for( xIndex = 0; xIndex < xReturn; xIndex++ )
 			{
-				vPortFreeLarge( pxSocket->u.xTCP.txStream );
-			}
+				pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xReceivedList );
+				( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
 
-			/* In case this is a child socket, make sure the child-count of the
-			parent socket is decreased. */
-			prvTCPSetSocketCount( pxSocket );
-		}
-	}
-	#endif  /* ipconfigUSE_TCP == 1 */
+				uxLength = pxNetworkBuffer->xDataLength - sizeof( UDPPacket_t );
+				pxMessages[ xIndex ].xAddress.sin_port = pxNetworkBuffer->usPort;
+				pxMessages[ xIndex ].xAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
 
-	/* Socket must be unbound first, to ensure no more packets are queued on
-	it. */
-	if( socketSOCKET_IS_BOUND( pxSocket ) != pdFALSE )
-	{
-		/* If the network driver can iterate through 'xBoundUDPSocketsList',
-		by calling xPortHasUDPSocket(), then the IP-task must temporarily
-		suspend the scheduler to keep the list in a consistent state. */
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
-		{
-			vTaskSuspendAll();
-		}
-		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+				{
+					/* Truncate the datagram if it doesn't fit in the provided
+					buffer. */
+					if( uxLength > pxMessages[ xIndex ].uxLength )
+					{
+						iptraceRECVFROM_DISCARDING_BYTES( ( uxLength - pxMessages[ xIndex ].uxLength ) );
+						uxLength = pxMessages[ xIndex ].uxLength;
+					}
 
-		uxListRemove( &( pxSocket->xBoundSocketListItem ) );
+					memcpy( pxMessages[ xIndex ].pvBuffer, ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), uxLength );
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+				else
+				{
+					/* The caller will release the buffer. */
+					pxMessages[ xIndex ].pvBuffer = ( void * ) ( &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ) );
+				}
 
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
-		{
-			xTaskResumeAll();
+				pxMessages[ xIndex ].uxLength = uxLength;
+			}
 		}
-		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
-	}
-
-	/* Now the socket is not bound the list of waiting packets can be
-	drained. */
-	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
-	{
-		while( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U )
+	#if( ipconfigSUPPORT_SIGNALS != 0 )
+		else if( ( xEventBits & eSOCKET_INTR ) != 0 )
 		{
-			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
-			uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
-			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			xReturn = -pdFREERTOS_ERRNO_EINTR;
+			iptraceRECVFROM_INTERRUPTED();
 		}
-	}
-
-	if( pxSocket->xEventGroup )
-	{
-		vEventGroupDelete( pxSocket->xEventGroup );
-	}
-
-	#if( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 )
-	{
-		if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+	#endif /* ipconfigSUPPORT_SIGNALS */
+		else
 		{
-			FreeRTOS_debug_printf( ( "FreeRTOS_closesocket[%u to %lxip:%u]: buffers %lu socks %lu\n",
-				pxSocket->usLocalPort,
-				pxSocket->u.xTCP.ulRemoteIP,
-				pxSocket->u.xTCP.usRemotePort,
-				uxGetNumberOfFreeNetworkBuffers(),
-				listCURRENT_LIST_LENGTH( &xBoundTCPSocketsList ) ) );
+			xReturn = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+			iptraceRECVFROM_TIMEOUT();
 		}
-	}
-	#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 ) */
-
-	/* Anf finally, after all resources have been freed, free the socket space */
-	vPortFreeSocket( pxSocket );
 
-	return 0;
-} /* Tested */
+		return xReturn;
+	}
 
+#endif /* ipconfigSUPPORT_UDP_BATCH */
 /*-----------------------------------------------------------*/
 
-#if ipconfigUSE_TCP == 1
+/*
+ * FreeRTOS_bind() : binds a sockt to a local port number.  If port 0 is
+ * provided, a system provided port number will be assigned.  This function can
+ * be used for both UDP and TCP sockets.  The actual binding will be performed
+ * by the IP-task to avoid mutual access to the bound-socket-lists
+ * (xBoundUDPSocketsList or xBoundTCPSocketsList).
+ */
+BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr * pxAddress, socklen_t xAddressLength )
+{
+IPStackEvent_t xBindEvent;
+FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+BaseType_t xReturn = 0;
 
-	/*
-	 * When a child socket gets closed, make sure to update the child-count of the
-	 * parent.  When a listening parent socket is closed, make sure no child-sockets
-	 * keep a pointer to it.
-	 */
-	static void prvTCPSetSocketCount( FreeRTOS_Socket_t *pxSocketToDelete )
+	( void ) xAddressLength;
+
+	if( ( pxSocket == NULL ) || ( pxSocket == FREERTOS_INVALID_SOCKET ) )
 	{
-	const ListItem_t *pxIterator;
-	const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
-	FreeRTOS_Socket_t *pxOtherSocket;
-	uint16_t usLocalPort = pxSocketToDelete->usLocalPort;
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	/* Once a socket is bound to a port, it can not be bound to a different
+	port number */
+	else if( socketSOCKET_IS_BOUND( pxSocket) != pdFALSE )
+	{
+		/* The socket is already bound. */
+		FreeRTOS_debug_printf( ( "vSocketBind: Socket already bound to %d\n", pxSocket->usLocalPort ) );
+		xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	}
+	else
+	{
+		/* Prepare a messages to the IP-task in order to perform the binding.
+		The desired port number will be passed in usLocalPort. */
+		xBindEvent.eEventType = eSocketBindEvent;
+		xBindEvent.pvData = ( void * ) xSocket;
+		if( pxAddress != NULL )
+		{
+			pxSocket->usLocalPort = FreeRTOS_ntohs( pxAddress->sin_port );
+		}
+		else
+		{
+			/* Caller wants to bind to a random port number. */
+			pxSocket->usLocalPort = 0u;
+		}
 
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		/* portMAX_DELAY is used as a the time-out parameter, as binding *must*
+		succeed before the socket can be used.  _RB_ The use of an infinite
+		block time needs be changed as it could result in the task hanging. */
+		if( xSendEventStructToIPTask( &xBindEvent, ( TickType_t ) portMAX_DELAY ) == pdFAIL )
 		{
-			pxOtherSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
-			if( ( pxOtherSocket->u.xTCP.ucTCPState == eTCP_LISTEN ) &&
-				( pxOtherSocket->usLocalPort == usLocalPort ) &&
-				( pxOtherSocket->u.xTCP.usChildCount ) )
+			/* Failed to wake-up the IP-task, no use to wait for it */
+			FreeRTOS_debug_printf( ( "FreeRTOS_bind: send event failed\n" ) );
+			xReturn = -pdFREERTOS_ERRNO_ECANCELED;
+		}
+		else
+		{
+			/* The IP-task will set the 'eSOCKET_BOUND' bit when it has done its
+			job. */
+			xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_BOUND, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, portMAX_DELAY );
+			if( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE )
 			{
-				pxOtherSocket->u.xTCP.usChildCount--;
-				FreeRTOS_debug_printf( ( "Lost: Socket %u now has %u / %u child%s\n",
-					pxOtherSocket->usLocalPort,
-					pxOtherSocket->u.xTCP.usChildCount,
-					pxOtherSocket->u.xTCP.usBacklog,
-					pxOtherSocket->u.xTCP.usChildCount == 1u ? "" : "ren" ) );
-				break;
+				xReturn = -pdFREERTOS_ERRNO_EINVAL;
 			}
 		}
 	}
 
-#endif /* ipconfigUSE_TCP == 1 */
-
-/*-----------------------------------------------------------*/
+	return xReturn;
+}
 
-BaseType_t FreeRTOS_setsockopt( Socket_t xSocket, int32_t lLevel, int32_t lOptionName, const void *pvOptionValue, size_t xOptionLength )
+/*
+ * vSocketBind(): internal version of bind() that should not be called directly.
+ * 'xInternal' is used for TCP sockets only: it allows to have several
+ * (connected) child sockets bound to the same server port.
+ */
+BaseType_t vSocketBind( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr * pxAddress, size_t uxAddressLength, BaseType_t xInternal )
 {
-/* The standard Berkeley function returns 0 for success. */
-BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
-BaseType_t lOptionValue;
-FreeRTOS_Socket_t *pxSocket;
+BaseType_t xReturn = 0; /* In Berkeley sockets, 0 means pass for bind(). */
+List_t *pxSocketList;
+#if( ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 )
+	struct freertos_sockaddr xAddress;
+#endif /* ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND */
 
-	pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+#if( ipconfigUSE_TCP == 1 )
+	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+	{
+		pxSocketList = &xBoundTCPSocketsList;
+	}
+	else
+#endif  /* ipconfigUSE_TCP == 1 */
+	{
+		pxSocketList = &xBoundUDPSocketsList;
+	}
 
 	/* The function prototype is designed to maintain the expected Berkeley
 	sockets standard, but this implementation does not use all the parameters. */
-	( void ) lLevel;
-	( void ) xOptionLength;
+	( void ) uxAddressLength;
 
-	configASSERT( xSocket );
+	configASSERT( pxSocket );
+	configASSERT( pxSocket != FREERTOS_INVALID_SOCKET );
 
-	switch( lOptionName )
+	#if( ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 )
 	{
-		case FREERTOS_SO_RCVTIMEO	:
-			/* Receive time out. */
-			pxSocket->xReceiveBlockTime = *( ( TickType_t * ) pvOptionValue );
-			xReturn = 0;
-			break;
+		/* pxAddress will be NULL if sendto() was called on a socket without the
+		socket being bound to an address. In this case, automatically allocate
+		an address and port to the socket. */
+		if( pxAddress == NULL )
+		{
+			pxAddress = &xAddress;
+			/* Put the port to zero to be assigned later. */
+			pxAddress->sin_port = 0u;
+		}
+	}
+	#endif /* ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND == 1 */
 
-		case FREERTOS_SO_SNDTIMEO	:
-			pxSocket->xSendBlockTime = *( ( TickType_t * ) pvOptionValue );
-			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+	/* Sockets must be bound before calling FreeRTOS_sendto() if
+	ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND is not set to 1. */
+	configASSERT( pxAddress );
+
+	if( pxAddress != NULL )
+	{
+		if( pxAddress->sin_port == 0u )
+		{
+			pxAddress->sin_port = prvGetPrivatePortNumber( ( BaseType_t )pxSocket->ucProtocol );
+			if( 0 == pxAddress->sin_port )
 			{
-				/* The send time out is capped for the reason stated in the
-				comments where ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS is defined
-				in FreeRTOSIPConfig.h (assuming an official configuration file
-				is being used. */
-				if( pxSocket->xSendBlockTime > ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS )
-				{
-					pxSocket->xSendBlockTime = ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS;
-				}
+				return -pdFREERTOS_ERRNO_EADDRNOTAVAIL;
 			}
-			else
+		}
+
+		/* If vSocketBind() is called from the API FreeRTOS_bind() it has been
+		confirmed that the socket was not yet bound to a port.  If it is called
+		from the IP-task, no such check is necessary. */
+
+		/* Check to ensure the port is not already in use.  If the bind is
+		called internally, a port MAY be used by more than one socket. */
+		if( ( ( xInternal == pdFALSE ) || ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP ) ) &&
+			( pxListFindListItemWithValue( pxSocketList, ( TickType_t ) pxAddress->sin_port ) != NULL ) )
+		{
+			FreeRTOS_debug_printf( ( "vSocketBind: %sP port %d in use\n",
+				pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP ? "TC" : "UD",
+				FreeRTOS_ntohs( pxAddress->sin_port ) ) );
+			xReturn = -pdFREERTOS_ERRNO_EADDRINUSE;
+		}
+		else
+		{
+			/* Allocate the port number to the socket.
+			This macro will set 'xBoundSocketListItem->xItemValue' */
+			socketSET_SOCKET_PORT( pxSocket, pxAddress->sin_port );
+
+			/* And also store it in a socket field 'usLocalPort' in host-byte-order,
+			mostly used for logging and debugging purposes */
+			pxSocket->usLocalPort = FreeRTOS_ntohs( pxAddress->sin_port );
+
+			/* Add the socket to the list of bound ports. */
 			{
-				/* For TCP socket, it isn't necessary to limit the blocking time
-				because	the FreeRTOS_send() function does not wait for a network
-				buffer to become available. */
-			}
-			xReturn = 0;
-			break;
-		#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
-			case FREERTOS_SO_UDP_MAX_RX_PACKETS:
-				if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP )
+				/* If the network driver can iterate through 'xBoundUDPSocketsList',
+				by calling xPortHasUDPSocket() then the IP-task must temporarily
+				suspend the scheduler to keep the list in a consistent state. */
+				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
 				{
-					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					vTaskSuspendAll();
 				}
-				pxSocket->u.xUDP.uxMaxPackets = *( ( UBaseType_t * ) pvOptionValue );
-				xReturn = 0;
-				break;
-		#endif /* ipconfigUDP_MAX_RX_PACKETS */
+				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 
-		case FREERTOS_SO_UDPCKSUM_OUT :
-			/* Turn calculating of the UDP checksum on/off for this socket. */
-			lOptionValue = ( BaseType_t ) pvOptionValue;
+				/* Add the socket to 'xBoundUDPSocketsList' or 'xBoundTCPSocketsList' */
+				vListInsertEnd( pxSocketList, &( pxSocket->xBoundSocketListItem ) );
 
-			if( lOptionValue == 0 )
-			{
-				pxSocket->ucSocketOptions &= ( uint8_t ) ~FREERTOS_SO_UDPCKSUM_OUT;
+				#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+				{
+					if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+					{
+						listSET_LIST_ITEM_VALUE( &( pxSocket->u.xUDP.xHashListItem ), ( TickType_t ) pxAddress->sin_port );
+						vListInsertEnd( socketUDP_HASH_BUCKET( pxAddress->sin_port ), &( pxSocket->u.xUDP.xHashListItem ) );
+					}
+				}
+				#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
+				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				{
+					xTaskResumeAll();
+				}
+				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 			}
-			else
+
+			#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
 			{
-				pxSocket->ucSocketOptions |= ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
+				if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+				{
+					prvTCPHashInsert( pxSocket );
+				}
 			}
-			xReturn = 0;
-			break;
+			#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+		}
+	}
+	else
+	{
+		xReturn = -pdFREERTOS_ERRNO_EADDRNOTAVAIL;
+		FreeRTOS_debug_printf( ( "vSocketBind: Socket no addr\n" ) );
+	}
 
-		#if( ipconfigUSE_CALLBACKS == 1 )
-			#if( ipconfigUSE_TCP == 1 )
-				case FREERTOS_SO_TCP_CONN_HANDLER:	/* Set a callback for (dis)connection events */
-				case FREERTOS_SO_TCP_RECV_HANDLER:	/* Install a callback for receiving TCP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
-				case FREERTOS_SO_TCP_SENT_HANDLER:	/* Install a callback for sending TCP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
-			#endif /* ipconfigUSE_TCP */
-				case FREERTOS_SO_UDP_RECV_HANDLER:	/* Install a callback for receiving UDP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
-				case FREERTOS_SO_UDP_SENT_HANDLER:	/* Install a callback for sending UDP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
-					{
-						#if( ipconfigUSE_TCP == 1 )
-						{
-							UBaseType_t uxProtocol;
-							if( ( lOptionName == FREERTOS_SO_UDP_RECV_HANDLER ) ||
-								( lOptionName == FREERTOS_SO_UDP_SENT_HANDLER ) )
-							{
-								uxProtocol = ( UBaseType_t ) FREERTOS_IPPROTO_UDP;
-							}
-							else
-							{
-								uxProtocol = ( UBaseType_t ) FREERTOS_IPPROTO_TCP;
-							}
+	if( xReturn != 0 )
+	{
+		iptraceBIND_FAILED( xSocket, ( FreeRTOS_ntohs( pxAddress->sin_port ) ) );
+	}
 
-							if( pxSocket->ucProtocol != ( uint8_t ) uxProtocol )
-							{
-								break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-							}
-						}
-						#else
-						{
-							/* No need to check if the socket has the right
-							protocol, because only UDP socket can be created. */
-						}
-						#endif /* ipconfigUSE_TCP */
+	return xReturn;
+} /* Tested */
+/*-----------------------------------------------------------*/
 
-						switch( lOptionName )
-						{
-						#if ipconfigUSE_TCP == 1
-							case FREERTOS_SO_TCP_CONN_HANDLER:
-								pxSocket->u.xTCP.pxHandleConnected = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPConnected;
-								break;
-							case FREERTOS_SO_TCP_RECV_HANDLER:
-								pxSocket->u.xTCP.pxHandleReceive = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPReceive;
-								break;
-							case FREERTOS_SO_TCP_SENT_HANDLER:
-								pxSocket->u.xTCP.pxHandleSent = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPSent;
-								break;
-						#endif /* ipconfigUSE_TCP */
-						case FREERTOS_SO_UDP_RECV_HANDLER:
-							pxSocket->u.xUDP.pxHandleReceive = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnUDPReceive;
-							break;
-						case FREERTOS_SO_UDP_SENT_HANDLER:
-							pxSocket->u.xUDP.pxHandleSent = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnUDPSent;
-							break;
-						default:
-							break;
-						}
-					}
+/*
+ * Close a socket and free the allocated space
+ * In case of a TCP socket: the connection will not be closed automatically
+ * Subsequent messages for the closed socket will be responded to with a RST
+ * The IP-task will actually close the socket, after receiving a 'eSocketCloseEvent' message
+ */
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+BaseType_t xResult;
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 )
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * )xSocket;
+#endif
+IPStackEvent_t xCloseEvent;
+xCloseEvent.eEventType = eSocketCloseEvent;
+xCloseEvent.pvData = ( void * ) xSocket;
 
-					xReturn = 0;
-					break;
-		#endif /* ipconfigUSE_CALLBACKS */
+	if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+	{
+		xResult = 0;
+	}
+	else
+	{
+		#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 ) )
+		{
+			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+			{
+				/* Make sure that IP-task won't call the user callback's anymore */
+				pxSocket->u.xTCP.pxHandleConnected = NULL;
+				pxSocket->u.xTCP.pxHandleReceive = NULL;
+				pxSocket->u.xTCP.pxHandleSent = NULL;
+			}
+		}
+		#endif  /* ( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_CALLBACKS == 1 ) ) */
 
-		#if( ipconfigUSE_TCP != 0 )
-			#if( ipconfigSOCKET_HAS_USER_SEMAPHORE != 0 )
-				/* Each socket has a semaphore on which the using task normally
-				sleeps. */
-				case FREERTOS_SO_SET_SEMAPHORE:
-					{
-						pxSocket->pxUserSemaphore = *( ( SemaphoreHandle_t * ) pvOptionValue );
-						xReturn = 0;
-					}
-					break;
-			#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
+		/* Let the IP task close the socket to keep it synchronised	with the
+		packet handling. */
 
-			#if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK != 0 )
-				case FREERTOS_SO_WAKEUP_CALLBACK:
-				{
-					/* Each socket can have a callback function that is executed
-					when there is an event the socket's owner might want to
-					process. */
-					pxSocket->pxUserWakeCallback = ( SocketWakeupCallback_t ) pvOptionValue;
-					xReturn = 0;
-				}
-				break;
-			#endif /* ipconfigSOCKET_HAS_USER_WAKE_CALLBACK */
+		/* Note when changing the time-out value below, it must be checked who is calling
+		this function. If it is called by the IP-task, a deadlock could occur.
+		The IP-task would only call it in case of a user call-back */
+		if( xSendEventStructToIPTask( &xCloseEvent, ( TickType_t ) 0 ) == pdFAIL )
+		{
+			FreeRTOS_debug_printf( ( "FreeRTOS_closesocket: failed\n" ) );
+			xResult = -1;
+		}
+		else
+		{
+			xResult = 1;
+		}
+	}
 
-			case FREERTOS_SO_SET_LOW_HIGH_WATER:
-				{
-				LowHighWater_t *pxLowHighWater = ( LowHighWater_t * ) pvOptionValue;
+	return xResult;
+}
 
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						/* It is not allowed to access 'pxSocket->u.xTCP'. */
-						FreeRTOS_debug_printf( ( "FREERTOS_SO_SET_LOW_HIGH_WATER: wrong socket type\n" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
-					if( ( pxLowHighWater->uxLittleSpace >= pxLowHighWater->uxEnoughSpace ) ||
-						( pxLowHighWater->uxEnoughSpace > pxSocket->u.xTCP.uxRxStreamSize ) )
-					{
-						/* Impossible values. */
-						FreeRTOS_debug_printf( ( "FREERTOS_SO_SET_LOW_HIGH_WATER: bad values\n" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
-					/* Send a STOP when buffer space drops below 'uxLittleSpace' bytes. */
-					pxSocket->u.xTCP.uxLittleSpace = pxLowHighWater->uxLittleSpace;
-					/* Send a GO when buffer space grows above 'uxEnoughSpace' bytes. */
-					pxSocket->u.xTCP.uxEnoughSpace = pxLowHighWater->uxEnoughSpace;
-					xReturn = 0;
-				}
-				break;
+/* This is the internal version of FreeRTOS_closesocket()
+ * It will be called by the IPtask only to avoid problems with synchronicity
+ */
+void *vSocketClose( FreeRTOS_Socket_t *pxSocket )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
 
-			case FREERTOS_SO_SNDBUF:	/* Set the size of the send buffer, in units of MSS (TCP only) */
-			case FREERTOS_SO_RCVBUF:	/* Set the size of the receive buffer, in units of MSS (TCP only) */
+	#if( ipconfigUSE_TCP == 1 )
+	{
+		/* For TCP: clean up a little more. */
+		if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		{
+			#if( ipconfigUSE_TCP_WIN == 1 )
+			{
+				if( pxSocket->u.xTCP.pxAckMessage != NULL )
 				{
-					uint32_t ulNewValue;
+					vReleaseNetworkBufferAndDescriptor( pxSocket->u.xTCP.pxAckMessage );
+				}
+				/* Free the resources which were claimed by the tcpWin member */
+				vTCPWindowDestroy( &pxSocket->u.xTCP.xTCPWindow );
+			}
+			#endif /* ipconfigUSE_TCP_WIN */
 
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						FreeRTOS_debug_printf( ( "Set SO_%sBUF: wrong socket type\n",
-							( lOptionName == FREERTOS_SO_SNDBUF ) ? "SND" : "RCV" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+			/* Free the input and output streams */
+			if( pxSocket->u.xTCP.rxStream != NULL )
+			{
+				prvTCPStreamFree( pxSocket->u.xTCP.rxStream );
+			}
 
-					if( ( ( lOptionName == FREERTOS_SO_SNDBUF ) && ( pxSocket->u.xTCP.txStream != NULL ) ) ||
-						( ( lOptionName == FREERTOS_SO_RCVBUF ) && ( pxSocket->u.xTCP.rxStream != NULL ) ) )
-					{
-						FreeRTOS_debug_printf( ( "Set SO_%sBUF: buffer already created\n",
-							( lOptionName == FREERTOS_SO_SNDBUF ) ? "SND" : "RCV" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+			if( pxSocket->u.xTCP.txStream != NULL )
+			{
+				#if( ipconfigTCP_TX_REFERENCES != 0 )
+				{
+					/* Hand back the buffers that were sent by reference. */
+					vTCPTxReferencesRelease( pxSocket );
+				}
+				#endif /* ipconfigTCP_TX_REFERENCES */
 
-					ulNewValue = *( ( uint32_t * ) pvOptionValue );
+				prvTCPStreamFree( pxSocket->u.xTCP.txStream );
+			}
 
-					if( lOptionName == FREERTOS_SO_SNDBUF )
-					{
-						/* Round up to nearest MSS size */
-						ulNewValue = FreeRTOS_round_up( ulNewValue, ( uint32_t ) pxSocket->u.xTCP.usInitMSS );
-						pxSocket->u.xTCP.uxTxStreamSize = ulNewValue;
-					}
-					else
-					{
-						pxSocket->u.xTCP.uxRxStreamSize = ulNewValue;
-					}
-				}
-				xReturn = 0;
-				break;
+			/* In case this is a child socket, make sure the child-count of the
+			parent socket is decreased. */
+			prvTCPSetSocketCount( pxSocket );
 
-			case FREERTOS_SO_WIN_PROPERTIES:	/* Set all buffer and window properties in one call, parameter is pointer to WinProperties_t */
+			#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+			{
+				if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xHashListItem ) ) != NULL )
 				{
-					WinProperties_t* pxProps;
+					uxListRemove( &( pxSocket->u.xTCP.xHashListItem ) );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
 
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						FreeRTOS_debug_printf( ( "Set SO_WIN_PROP: wrong socket type\n" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+			#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+			{
+				vTCPTimerRemove( pxSocket );
+			}
+			#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+		}
+	}
+	#endif  /* ipconfigUSE_TCP == 1 */
 
-					if( ( pxSocket->u.xTCP.txStream != NULL ) || ( pxSocket->u.xTCP.rxStream != NULL ) )
-					{
-						FreeRTOS_debug_printf( ( "Set SO_WIN_PROP: buffer already created\n" ) );
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+	/* Socket must be unbound first, to ensure no more packets are queued on
+	it. */
+	if( socketSOCKET_IS_BOUND( pxSocket ) != pdFALSE )
+	{
+		/* If the network driver can iterate through 'xBoundUDPSocketsList',
+		by calling xPortHasUDPSocket(), then the IP-task must temporarily
+		suspend the scheduler to keep the list in a consistent state. */
+		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		{
+			vTaskSuspendAll();
+		}
+		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
 
-					pxProps = ( ( WinProperties_t * ) pvOptionValue );
+		uxListRemove( &( pxSocket->xBoundSocketListItem ) );
 
-					if ( FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDBUF, &( pxProps->lTxBufSize ), sizeof( pxProps->lTxBufSize ) ) != 0 )
-					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+		#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+		{
+			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+			{
+				uxListRemove( &( pxSocket->u.xUDP.xHashListItem ) );
+			}
+		}
+		#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
 
-					if ( FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVBUF, &( pxProps->lRxBufSize ), sizeof( pxProps->lRxBufSize ) ) != 0 )
-					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		{
+			xTaskResumeAll();
+		}
+		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+	}
 
-					#if( ipconfigUSE_TCP_WIN == 1 )
+	/* Now the socket is not bound the list of waiting packets can be
+	drained. */
+	if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+	{
+		while( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U )
+		{
+			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+			uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+	}
+
+	if( pxSocket->xEventGroup )
+	{
+		vEventGroupDelete( pxSocket->xEventGroup );
+	}
+
+	#if( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 )
+	{
+		if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		{
+			FreeRTOS_debug_printf( ( "FreeRTOS_closesocket[%u to %lxip:%u]: buffers %lu socks %lu\n",
+				pxSocket->usLocalPort,
+				pxSocket->u.xTCP.ulRemoteIP,
+				pxSocket->u.xTCP.usRemotePort,
+				uxGetNumberOfFreeNetworkBuffers(),
+				listCURRENT_LIST_LENGTH( &xBoundTCPSocketsList ) ) );
+		}
+	}
+	#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 ) */
+
+	/* Anf finally, after all resources have been freed, free the socket space */
+	vPortFreeSocket( pxSocket );
+
+	return 0;
+} /* Tested */
+
+/*-----------------------------------------------------------*/
+
+#if ipconfigUSE_TCP == 1
+
+	/*
+	 * When a child socket gets closed, make sure to update the child-count of the
+	 * parent.  When a listening parent socket is closed, make sure no child-sockets
+	 * keep a pointer to it.
+	 */
+	static void prvTCPSetSocketCount( FreeRTOS_Socket_t *pxSocketToDelete )
+	{
+	const ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
+	FreeRTOS_Socket_t *pxOtherSocket;
+	uint16_t usLocalPort = pxSocketToDelete->usLocalPort;
+
+		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			pxOtherSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			if( ( pxOtherSocket->u.xTCP.ucTCPState == eTCP_LISTEN ) &&
+				( pxOtherSocket->usLocalPort == usLocalPort ) &&
+				( pxOtherSocket->u.xTCP.usChildCount ) )
+			{
+				pxOtherSocket->u.xTCP.usChildCount--;
+				FreeRTOS_debug_printf( ( "Lost: Socket %u now has %u / %u child%s\n",
+					pxOtherSocket->usLocalPort,
+					pxOtherSocket->u.xTCP.usChildCount,
+					pxOtherSocket->u.xTCP.usBacklog,
+					pxOtherSocket->u.xTCP.usChildCount == 1u ? "" : "ren" ) );
+				break;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP == 1 */
+
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket, int32_t lLevel, int32_t lOptionName, const void *pvOptionValue, size_t xOptionLength )
+{
+/* The standard Berkeley function returns 0 for success. */
+BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
+BaseType_t lOptionValue;
+FreeRTOS_Socket_t *pxSocket;
+
+	pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+	/* The function prototype is designed to maintain the expected Berkeley
+	sockets standard, but this implementation does not use all the parameters. */
+	( void ) lLevel;
+	( void ) xOptionLength;
+
+	configASSERT( xSocket );
+
+	switch( lOptionName )
+	{
+		case FREERTOS_SO_RCVTIMEO	:
+			/* Receive time out. */
+			pxSocket->xReceiveBlockTime = *( ( TickType_t * ) pvOptionValue );
+			xReturn = 0;
+			break;
+
+		case FREERTOS_SO_SNDTIMEO	:
+			pxSocket->xSendBlockTime = *( ( TickType_t * ) pvOptionValue );
+			if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_UDP )
+			{
+				/* The send time out is capped for the reason stated in the
+				comments where ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS is defined
+				in FreeRTOSIPConfig.h (assuming an official configuration file
+				is being used. */
+				if( pxSocket->xSendBlockTime > ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS )
+				{
+					pxSocket->xSendBlockTime = ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS;
+				}
+			}
+			else
+			{
+				/* For TCP socket, it isn't necessary to limit the blocking time
+				because	the FreeRTOS_send() function does not wait for a network
+				buffer to become available. */
+			}
+			xReturn = 0;
+			break;
+		#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
+			case FREERTOS_SO_UDP_MAX_RX_PACKETS:
+				if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+				pxSocket->u.xUDP.uxMaxPackets = *( ( UBaseType_t * ) pvOptionValue );
+				xReturn = 0;
+				break;
+		#endif /* ipconfigUDP_MAX_RX_PACKETS */
+
+		case FREERTOS_SO_UDPCKSUM_OUT :
+			/* Turn calculating of the UDP checksum on/off for this socket. */
+			lOptionValue = ( BaseType_t ) pvOptionValue;
+
+			if( lOptionValue == 0 )
+			{
+				pxSocket->ucSocketOptions &= ( uint8_t ) ~FREERTOS_SO_UDPCKSUM_OUT;
+			}
+			else
+			{
+				pxSocket->ucSocketOptions |= ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT;
+			}
+			xReturn = 0;
+			break;
+
+		#if( ipconfigUSE_CALLBACKS == 1 )
+			#if( ipconfigUSE_TCP == 1 )
+				case FREERTOS_SO_TCP_CONN_HANDLER:	/* Set a callback for (dis)connection events */
+				case FREERTOS_SO_TCP_RECV_HANDLER:	/* Install a callback for receiving TCP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
+				case FREERTOS_SO_TCP_SENT_HANDLER:	/* Install a callback for sending TCP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
+			#endif /* ipconfigUSE_TCP */
+				case FREERTOS_SO_UDP_RECV_HANDLER:	/* Install a callback for receiving UDP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
+				case FREERTOS_SO_UDP_SENT_HANDLER:	/* Install a callback for sending UDP data. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
 					{
-						pxSocket->u.xTCP.uxRxWinSize = ( uint32_t )pxProps->lRxWinSize;	/* Fixed value: size of the TCP reception window */
-						pxSocket->u.xTCP.uxTxWinSize = ( uint32_t )pxProps->lTxWinSize;	/* Fixed value: size of the TCP transmit window */
+						#if( ipconfigUSE_TCP == 1 )
+						{
+							UBaseType_t uxProtocol;
+							if( ( lOptionName == FREERTOS_SO_UDP_RECV_HANDLER ) ||
+								( lOptionName == FREERTOS_SO_UDP_SENT_HANDLER ) )
+							{
+								uxProtocol = ( UBaseType_t ) FREERTOS_IPPROTO_UDP;
+							}
+							else
+							{
+								uxProtocol = ( UBaseType_t ) FREERTOS_IPPROTO_TCP;
+							}
+
+							if( pxSocket->ucProtocol != ( uint8_t ) uxProtocol )
+							{
+								break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+							}
+						}
+						#else
+						{
+							/* No need to check if the socket has the right
+							protocol, because only UDP socket can be created. */
+						}
+						#endif /* ipconfigUSE_TCP */
+
+						switch( lOptionName )
+						{
+						#if ipconfigUSE_TCP == 1
+							case FREERTOS_SO_TCP_CONN_HANDLER:
+								pxSocket->u.xTCP.pxHandleConnected = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPConnected;
+								break;
+							case FREERTOS_SO_TCP_RECV_HANDLER:
+								pxSocket->u.xTCP.pxHandleReceive = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPReceive;
+								break;
+							case FREERTOS_SO_TCP_SENT_HANDLER:
+								pxSocket->u.xTCP.pxHandleSent = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnTCPSent;
+								break;
+						#endif /* ipconfigUSE_TCP */
+						case FREERTOS_SO_UDP_RECV_HANDLER:
+							pxSocket->u.xUDP.pxHandleReceive = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnUDPReceive;
+							break;
+						case FREERTOS_SO_UDP_SENT_HANDLER:
+							pxSocket->u.xUDP.pxHandleSent = ((F_TCP_UDP_Handler_t *)pvOptionValue)->pxOnUDPSent;
+							break;
+						default:
+							break;
+						}
 					}
-					#else
+
+					xReturn = 0;
+					break;
+		#endif /* ipconfigUSE_CALLBACKS */
+
+		#if( ipconfigUSE_TCP != 0 )
+			#if( ipconfigSOCKET_HAS_USER_SEMAPHORE != 0 )
+				/* Each socket has a semaphore on which the using task normally
+				sleeps. */
+				case FREERTOS_SO_SET_SEMAPHORE:
 					{
-						pxSocket->u.xTCP.uxRxWinSize = 1u;
-						pxSocket->u.xTCP.uxTxWinSize = 1u;
+						pxSocket->pxUserSemaphore = *( ( SemaphoreHandle_t * ) pvOptionValue );
+						xReturn = 0;
 					}
-					#endif
+					break;
+			#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
 
-					/* In case the socket has already initialised its tcpWin,
-					adapt the window size parameters */
-					if( pxSocket->u.xTCP.xTCPWindow.u.bits.bHasInit != pdFALSE_UNSIGNED )
+			#if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK != 0 )
+				case FREERTOS_SO_WAKEUP_CALLBACK:
+				{
+					/* Each socket can have a callback function that is executed
+					when there is an event the socket's owner might want to
+					process. */
+					pxSocket->pxUserWakeCallback = ( SocketWakeupCallback_t ) pvOptionValue;
+					xReturn = 0;
+				}
+				break;
+			#endif /* ipconfigSOCKET_HAS_USER_WAKE_CALLBACK */
+
+			#if( ipconfigTCP_TX_REFERENCES != 0 )
+				case FREERTOS_SO_TCP_TX_REF_HANDLER:	/* Install a callback that returns the buffers sent by reference. */
 					{
-						pxSocket->u.xTCP.xTCPWindow.xSize.ulRxWindowLength = pxSocket->u.xTCP.uxRxWinSize * pxSocket->u.xTCP.usInitMSS;
-						pxSocket->u.xTCP.xTCPWindow.xSize.ulTxWindowLength = pxSocket->u.xTCP.uxTxWinSize * pxSocket->u.xTCP.usInitMSS;
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+						pxSocket->u.xTCP.pxHandleTxReference = ( ( F_TCP_UDP_Handler_t * ) pvOptionValue )->pxOnTCPTxReference;
+						xReturn = 0;
 					}
-				}
+					break;
+			#endif /* ipconfigTCP_TX_REFERENCES */
+
+			case FREERTOS_SO_SET_LOW_HIGH_WATER:
+				{
+				LowHighWater_t *pxLowHighWater = ( LowHighWater_t * ) pvOptionValue;
+
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						/* It is not allowed to access 'pxSocket->u.xTCP'. */
+						FreeRTOS_debug_printf( ( "FREERTOS_SO_SET_LOW_HIGH_WATER: wrong socket type\n" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					if( ( pxLowHighWater->uxLittleSpace >= pxLowHighWater->uxEnoughSpace ) ||
+						( pxLowHighWater->uxEnoughSpace > pxSocket->u.xTCP.uxRxStreamSize ) )
+					{
+						/* Impossible values. */
+						FreeRTOS_debug_printf( ( "FREERTOS_SO_SET_LOW_HIGH_WATER: bad values\n" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					/* Send a STOP when buffer space drops below 'uxLittleSpace' bytes. */
+					pxSocket->u.xTCP.uxLittleSpace = pxLowHighWater->uxLittleSpace;
+					/* Send a GO when buffer space grows above 'uxEnoughSpace' bytes. */
+					pxSocket->u.xTCP.uxEnoughSpace = pxLowHighWater->uxEnoughSpace;
+					xReturn = 0;
+				}
+				break;
+
+			case FREERTOS_SO_SNDBUF:	/* Set the size of the send buffer, in units of MSS (TCP only) */
+			case FREERTOS_SO_RCVBUF:	/* Set the size of the receive buffer, in units of MSS (TCP only) */
+				{
+					uint32_t ulNewValue;
+
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						FreeRTOS_debug_printf( ( "Set SO_%sBUF: wrong socket type\n",
+							( lOptionName == FREERTOS_SO_SNDBUF ) ? "SND" : "RCV" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( ( ( lOptionName == FREERTOS_SO_SNDBUF ) && ( pxSocket->u.xTCP.txStream != NULL ) ) ||
+						( ( lOptionName == FREERTOS_SO_RCVBUF ) && ( pxSocket->u.xTCP.rxStream != NULL ) ) )
+					{
+						FreeRTOS_debug_printf( ( "Set SO_%sBUF: buffer already created\n",
+							( lOptionName == FREERTOS_SO_SNDBUF ) ? "SND" : "RCV" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					ulNewValue = *( ( uint32_t * ) pvOptionValue );
+
+					if( lOptionName == FREERTOS_SO_SNDBUF )
+					{
+						/* Round up to nearest MSS size */
+						ulNewValue = FreeRTOS_round_up( ulNewValue, ( uint32_t ) pxSocket->u.xTCP.usInitMSS );
+						pxSocket->u.xTCP.uxTxStreamSize = ulNewValue;
+						#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+						{
+							/* The owner has chosen a size, it will not be tuned. */
+							pxSocket->u.xTCP.xAutoTune.uxTxBaseSize = ulNewValue;
+							pxSocket->u.xTCP.xAutoTune.ucTxFixed = pdTRUE_UNSIGNED;
+						}
+						#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+					}
+					else
+					{
+						pxSocket->u.xTCP.uxRxStreamSize = ulNewValue;
+						#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+						{
+							pxSocket->u.xTCP.xAutoTune.uxRxBaseSize = ulNewValue;
+							pxSocket->u.xTCP.xAutoTune.ucRxFixed = pdTRUE_UNSIGNED;
+						}
+						#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+					}
+				}
+				xReturn = 0;
+				break;
+
+			case FREERTOS_SO_WIN_PROPERTIES:	/* Set all buffer and window properties in one call, parameter is pointer to WinProperties_t */
+				{
+					WinProperties_t* pxProps;
+
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						FreeRTOS_debug_printf( ( "Set SO_WIN_PROP: wrong socket type\n" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( ( pxSocket->u.xTCP.txStream != NULL ) || ( pxSocket->u.xTCP.rxStream != NULL ) )
+					{
+						FreeRTOS_debug_printf( ( "Set SO_WIN_PROP: buffer already created\n" ) );
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					pxProps = ( ( WinProperties_t * ) pvOptionValue );
+
+					if ( FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDBUF, &( pxProps->lTxBufSize ), sizeof( pxProps->lTxBufSize ) ) != 0 )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if ( FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVBUF, &( pxProps->lRxBufSize ), sizeof( pxProps->lRxBufSize ) ) != 0 )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					#if( ipconfigUSE_TCP_WIN == 1 )
+					{
+						pxSocket->u.xTCP.uxRxWinSize = ( uint32_t )pxProps->lRxWinSize;	/* Fixed value: size of the TCP reception window */
+						pxSocket->u.xTCP.uxTxWinSize = ( uint32_t )pxProps->lTxWinSize;	/* Fixed value: size of the TCP transmit window */
+					}
+					#else
+					{
+						pxSocket->u.xTCP.uxRxWinSize = 1u;
+						pxSocket->u.xTCP.uxTxWinSize = 1u;
+					}
+					#endif
+
+					/* In case the socket has already initialised its tcpWin,
+					adapt the window size parameters */
+					if( pxSocket->u.xTCP.xTCPWindow.u.bits.bHasInit != pdFALSE_UNSIGNED )
+					{
+						pxSocket->u.xTCP.xTCPWindow.xSize.ulRxWindowLength = pxSocket->u.xTCP.uxRxWinSize * pxSocket->u.xTCP.usInitMSS;
+						pxSocket->u.xTCP.xTCPWindow.xSize.ulTxWindowLength = pxSocket->u.xTCP.uxTxWinSize * pxSocket->u.xTCP.usInitMSS;
+					}
+				}
+
+				xReturn = 0;
+				break;
+
+			case FREERTOS_SO_REUSE_LISTEN_SOCKET:	/* If true, the server-socket will turn into a connected socket */
+				{
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bReuseSocket = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bReuseSocket = pdFALSE_UNSIGNED;
+					}
+				}
+				xReturn = 0;
+				break;
+
+			case FREERTOS_SO_CLOSE_AFTER_SEND:		/* As soon as the last byte has been transmitted, finalise the connection */
+				{
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bCloseAfterSend = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bCloseAfterSend = pdFALSE_UNSIGNED;
+					}
+				}
+				xReturn = 0;
+				break;
+
+			case FREERTOS_SO_SET_FULL_SIZE:		/* Refuse to send packets smaller than MSS  */
+				{
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+					{
+						pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize = pdFALSE_UNSIGNED;
+					}
+
+					if( ( pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize == pdFALSE_UNSIGNED ) &&
+						( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) &&
+						( FreeRTOS_outstanding( pxSocket ) != 0 ) )
+					{
+						pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bSendFullSize */
+						prvTCPSendTimerEvent( pxSocket );
+					}
+				}
+				xReturn = 0;
+				break;
+
+			case FREERTOS_SO_STOP_RX:		/* Refuse to receive more packts */
+				{
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+
+					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bRxStopped = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bRxStopped = pdFALSE_UNSIGNED;
+					}
+
+					pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
+					pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bRxStopped */
+					prvTCPSendTimerEvent( pxSocket );
+				}
+				xReturn = 0;
+				break;
+
+		#endif  /* ipconfigUSE_TCP == 1 */
+
+		default :
+			/* No other options are handled. */
+			xReturn = -pdFREERTOS_ERRNO_ENOPROTOOPT;
+			break;
+	}
+
+	return xReturn;
+} /* Tested */
+
+/*-----------------------------------------------------------*/
+
+/* Find an available port number per https://tools.ietf.org/html/rfc6056. */
+static uint16_t prvGetPrivatePortNumber( BaseType_t xProtocol )
+{
+const uint16_t usEphemeralPortCount =
+	socketAUTO_PORT_ALLOCATION_MAX_NUMBER - socketAUTO_PORT_ALLOCATION_START_NUMBER + 1;
+uint16_t usIterations = usEphemeralPortCount;
+uint32_t ulRandomSeed = 0;
+uint16_t usResult = 0;
+const List_t *pxList;
+
+#if ipconfigUSE_TCP == 1
+	if( xProtocol == ( BaseType_t ) FREERTOS_IPPROTO_TCP )
+	{
+		pxList = &xBoundTCPSocketsList;
+	}
+	else
+#endif
+	{
+		pxList = &xBoundUDPSocketsList;
+	}
+
+	/* Avoid compiler warnings if ipconfigUSE_TCP is not defined. */
+	( void ) xProtocol;
+
+	/* Find the next available port using the random seed as a starting
+	point. */
+	do
+	{
+		/* Only proceed if the random number generator succeeded. */
+		if( xApplicationGetRandomNumber( &( ulRandomSeed ) ) == pdFALSE )
+		{
+			break;
+		}
+
+		/* Map the random to a candidate port. */
+		usResult =
+			socketAUTO_PORT_ALLOCATION_START_NUMBER +
+			( ( ( uint16_t )ulRandomSeed ) % usEphemeralPortCount );
+
+		/* Check if there's already an open socket with the same protocol
+		and port. */
+		if( NULL == pxListFindListItemWithValue(
+			pxList,
+			( TickType_t )FreeRTOS_htons( usResult ) ) )
+		{
+			usResult = FreeRTOS_htons( usResult );
+			break;
+		}
+		else
+		{
+			usResult = 0;
+		}
+
+		usIterations--;
+	}
+	while( usIterations > 0 );
+
+	return usResult;
+}
+/*-----------------------------------------------------------*/
+
+/* pxListFindListItemWithValue: find a list item in a bound socket list
+'xWantedItemValue' refers to a port number */
+static const ListItem_t * pxListFindListItemWithValue( const List_t *pxList, TickType_t xWantedItemValue )
+{
+const ListItem_t * pxResult = NULL;
+
+	#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+	{
+		/* All bound UDP sockets with this port number are also found in a
+		single bucket of the hash table, which is a lot shorter to search. */
+		if( pxList == &xBoundUDPSocketsList )
+		{
+			pxList = socketUDP_HASH_BUCKET( xWantedItemValue );
+		}
+	}
+	#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
+
+	if( ( xIPIsNetworkTaskReady() != pdFALSE ) && ( pxList != NULL ) )
+	{
+		const ListItem_t *pxIterator;
+		const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( pxList );
+		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			if( listGET_LIST_ITEM_VALUE( pxIterator ) == xWantedItemValue )
+			{
+				pxResult = pxIterator;
+				break;
+			}
+		}
+	}
+
+	return pxResult;
+} /* Tested */
+
+/*-----------------------------------------------------------*/
+
+FreeRTOS_Socket_t *pxUDPSocketLookup( UBaseType_t uxLocalPort )
+{
+const ListItem_t *pxListItem;
+FreeRTOS_Socket_t *pxSocket = NULL;
+
+	/* Looking up a socket is quite simple, find a match with the local port.
+
+	See if there is a list item associated with the port number on the
+	list of bound sockets. */
+	pxListItem = pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
+
+	if( pxListItem != NULL )
+	{
+		/* The owner of the list item is the socket itself. */
+		pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxListItem );
+		configASSERT( pxSocket != NULL );
+	}
+	return pxSocket;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ipconfigINCLUDE_FULL_INET_ADDR == 1
+
+	uint32_t FreeRTOS_inet_addr( const char * pcIPAddress )
+	{
+	const uint32_t ulDecimalBase = 10u;
+	uint8_t ucOctet[ socketMAX_IP_ADDRESS_OCTETS ];
+	const char *pcPointerOnEntering;
+	uint32_t ulReturn = 0UL, ulValue;
+	UBaseType_t uxOctetNumber;
+	BaseType_t xResult = pdPASS;
+
+		for( uxOctetNumber = 0u; uxOctetNumber < socketMAX_IP_ADDRESS_OCTETS; uxOctetNumber++ )
+		{
+			ulValue = 0ul;
+			pcPointerOnEntering = pcIPAddress;
+
+			while( ( *pcIPAddress >= '0' ) && ( *pcIPAddress <= '9' ) )
+			{
+				/* Move previous read characters into the next decimal
+				position. */
+				ulValue *= ulDecimalBase;
+
+				/* Add the binary value of the ascii character. */
+				ulValue += ( ( uint32_t ) ( *pcIPAddress ) - ( uint32_t ) '0' );
+
+				/* Move to next character in the string. */
+				pcIPAddress++;
+			}
+
+			/* Check characters were read. */
+			if( pcIPAddress == pcPointerOnEntering )
+			{
+				xResult = pdFAIL;
+			}
+
+			/* Check the value fits in an 8-bit number. */
+			if( ulValue > 0xffUL )
+			{
+				xResult = pdFAIL;
+			}
+			else
+			{
+				ucOctet[ uxOctetNumber ] = ( uint8_t ) ulValue;
+
+				/* Check the next character is as expected. */
+				if( uxOctetNumber < ( socketMAX_IP_ADDRESS_OCTETS - 1u ) )
+				{
+					if( *pcIPAddress != '.' )
+					{
+						xResult = pdFAIL;
+					}
+					else
+					{
+						/* Move past the dot. */
+						pcIPAddress++;
+					}
+				}
+			}
+
+			if( xResult == pdFAIL )
+			{
+				/* No point going on. */
+				break;
+			}
+		}
+
+		if( *pcIPAddress != ( char ) 0 )
+		{
+			/* Expected the end of the string. */
+			xResult = pdFAIL;
+		}
+
+		if( uxOctetNumber != socketMAX_IP_ADDRESS_OCTETS )
+		{
+			/* Didn't read enough octets. */
+			xResult = pdFAIL;
+		}
+
+		if( xResult == pdPASS )
+		{
+			ulReturn = FreeRTOS_inet_addr_quick( ucOctet[ 0 ], ucOctet[ 1 ], ucOctet[ 2 ], ucOctet[ 3 ] );
+		}
+
+		return ulReturn;
+	}
+
+#endif /* ipconfigINCLUDE_FULL_INET_ADDR */
+
+/*-----------------------------------------------------------*/
+
+/* Function to get the local address and IP port */
+size_t FreeRTOS_GetLocalAddress( Socket_t xSocket, struct freertos_sockaddr *pxAddress )
+{
+FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+	/* IP address of local machine. */
+	pxAddress->sin_addr = *ipLOCAL_IP_ADDRESS_POINTER;
+
+	/* Local port on this machine. */
+	pxAddress->sin_port = FreeRTOS_htons( pxSocket->usLocalPort );
+
+	return sizeof( *pxAddress );
+}
+
+/*-----------------------------------------------------------*/
+
+void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
+{
+/* _HT_ must work this out, now vSocketWakeUpUser will be called for any important
+ * event or transition */
+	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
+	{
+		if( pxSocket->pxUserSemaphore != NULL )
+		{
+			xSemaphoreGive( pxSocket->pxUserSemaphore );
+		}
+	}
+	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
+
+	#if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK == 1 )
+	{
+		if( pxSocket->pxUserWakeCallback != NULL )
+		{
+			pxSocket->pxUserWakeCallback( pxSocket );
+		}
+	}
+	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
+
+	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+	{
+		if( pxSocket->pxSocketSet != NULL )
+		{
+			EventBits_t xSelectBits = ( pxSocket->xEventBits >> SOCKET_EVENT_BIT_COUNT ) & eSELECT_ALL;
+			if( xSelectBits != 0ul )
+			{
+				pxSocket->xSocketBits |= xSelectBits;
+				xEventGroupSetBits( pxSocket->pxSocketSet->xSelectGroup, xSelectBits );
+			}
+		}
+
+		pxSocket->xEventBits &= eSOCKET_ALL;
+	}
+	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+
+	if( ( pxSocket->xEventGroup != NULL ) && ( pxSocket->xEventBits != 0u ) )
+	{
+		xEventGroupSetBits( pxSocket->xEventGroup, pxSocket->xEventBits );
+	}
+
+	pxSocket->xEventBits = 0ul;
+}
+
+/*-----------------------------------------------------------*/
+
+#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+
+	/* This define makes it possible for network-card drivers to inspect
+	 * UDP message and see if there is any UDP socket bound to a given port
+	 * number.
+	 * This is probably only usefull in systems with a minimum of RAM and
+	 * when lots of anonymous broadcast messages come in
+	 */
+	BaseType_t xPortHasUDPSocket( uint16_t usPortNr )
+	{
+	BaseType_t xFound = pdFALSE;
+
+		vTaskSuspendAll();
+		{
+			if( ( pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) usPortNr ) != NULL ) )
+			{
+				xFound = pdTRUE;
+			}
+		}
+		xTaskResumeAll();
+
+		return xFound;
+	}
+
+#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static BaseType_t bMayConnect( FreeRTOS_Socket_t *pxSocket );
+	static BaseType_t bMayConnect( FreeRTOS_Socket_t *pxSocket )
+	{
+		switch( pxSocket->u.xTCP.ucTCPState )
+		{
+			case eCLOSED:
+			case eCLOSE_WAIT:	return 0;
+			case eCONNECT_SYN:	return -pdFREERTOS_ERRNO_EINPROGRESS;
+			default:			return -pdFREERTOS_ERRNO_EAGAIN;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static BaseType_t prvTCPConnectStart( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr *pxAddress )
+	{
+	BaseType_t xResult = 0;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdFALSE )
+		{
+			/* Not a valid socket or wrong type */
+			xResult = -pdFREERTOS_ERRNO_EBADF;
+		}
+		else if( FreeRTOS_issocketconnected( pxSocket ) > 0 )
+		{
+			/* The socket is already connected. */
+			xResult = -pdFREERTOS_ERRNO_EISCONN;
+		}
+		else if( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE )
+		{
+			/* Bind the socket to the port that the client task will send from.
+			Non-standard, so the error returned is that returned by bind(). */
+			xResult = FreeRTOS_bind( ( Socket_t ) pxSocket, NULL, 0u );
+		}
+
+		if( xResult == 0 )
+		{
+			/* Check if it makes any sense to wait for a connect event, this condition
+			might change while sleeping, so it must be checked within each loop */
+			xResult = bMayConnect( pxSocket ); /* -EINPROGRESS, -EAGAIN, or 0 for OK */
+
+			/* Start the connect procedure, kernel will start working on it */
+			if( xResult == 0 )
+			{
+				pxSocket->u.xTCP.bits.bConnPrepared = pdFALSE_UNSIGNED;
+				pxSocket->u.xTCP.ucRepCount = 0u;
+
+				FreeRTOS_debug_printf( ( "FreeRTOS_connect: %u to %lxip:%u\n",
+					pxSocket->usLocalPort, FreeRTOS_ntohl( pxAddress->sin_addr ), FreeRTOS_ntohs( pxAddress->sin_port ) ) );
 
-				xReturn = 0;
-				break;
+				/* Port on remote machine. */
+				pxSocket->u.xTCP.usRemotePort = FreeRTOS_ntohs( pxAddress->sin_port );
 
-			case FREERTOS_SO_REUSE_LISTEN_SOCKET:	/* If true, the server-socket will turn into a connected socket */
+				/* IP address of remote machine. */
+				pxSocket->u.xTCP.ulRemoteIP = FreeRTOS_ntohl( pxAddress->sin_addr );
+
+				/* (client) internal state: socket wants to send a connect. */
+				vTCPStateChange( pxSocket, eCONNECT_SYN );
+
+				/* To start an active connect. */
+				pxSocket->u.xTCP.usTimeout = 1u;
+
+				if( prvTCPSendTimerEvent( pxSocket ) != pdPASS )
 				{
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
-					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
-					{
-						pxSocket->u.xTCP.bits.bReuseSocket = pdTRUE_UNSIGNED;
-					}
-					else
-					{
-						pxSocket->u.xTCP.bits.bReuseSocket = pdFALSE_UNSIGNED;
-					}
+					xResult = -pdFREERTOS_ERRNO_ECANCELED;
 				}
-				xReturn = 0;
-				break;
+			}
+		}
 
-			case FREERTOS_SO_CLOSE_AFTER_SEND:		/* As soon as the last byte has been transmitted, finalise the connection */
-				{
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+		return xResult;
+	}
 
-					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
-					{
-						pxSocket->u.xTCP.bits.bCloseAfterSend = pdTRUE_UNSIGNED;
-					}
-					else
-					{
-						pxSocket->u.xTCP.bits.bCloseAfterSend = pdFALSE_UNSIGNED;
-					}
-				}
-				xReturn = 0;
-				break;
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
 
-			case FREERTOS_SO_SET_FULL_SIZE:		/* Refuse to send packets smaller than MSS  */
-				{
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
-					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
-					}
+#if( ipconfigUSE_TCP == 1 )
 
-					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
-					{
-						pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize = pdTRUE_UNSIGNED;
-					}
-					else
-					{
-						pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize = pdFALSE_UNSIGNED;
-					}
+	/*
+	 * FreeRTOS_connect: socket wants to connect to a remote port
+	 */
+	BaseType_t FreeRTOS_connect( Socket_t xClientSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t* ) xClientSocket;
+	TickType_t xRemainingTime;
+	BaseType_t xTimed = pdFALSE;
+	BaseType_t xResult;
+	TimeOut_t xTimeOut;
 
-					if( ( pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize == pdFALSE_UNSIGNED ) &&
-						( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) &&
-						( FreeRTOS_outstanding( pxSocket ) != 0 ) )
-					{
-						pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bSendFullSize */
-						xSendEventToIPTask( eTCPTimerEvent );
-					}
-				}
-				xReturn = 0;
-				break;
+		( void ) xAddressLength;
 
-			case FREERTOS_SO_STOP_RX:		/* Refuse to receive more packts */
+		xResult = prvTCPConnectStart( pxSocket, pxAddress );
+
+		if( xResult == 0 )
+		{
+			/* And wait for the result */
+			for( ;; )
+			{
+				if( xTimed == pdFALSE )
 				{
-					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					/* Only in the first round, check for non-blocking */
+					xRemainingTime = pxSocket->xReceiveBlockTime;
+					if( xRemainingTime == ( TickType_t )0 )
 					{
-						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						/* Not yet connected, correct state, non-blocking. */
+						xResult = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+						break;
 					}
 
-					if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
-					{
-						pxSocket->u.xTCP.bits.bRxStopped = pdTRUE_UNSIGNED;
-					}
-					else
-					{
-						pxSocket->u.xTCP.bits.bRxStopped = pdFALSE_UNSIGNED;
-					}
+					/* Don't get here a second time. */
+					xTimed = pdTRUE;
 
-					pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
-					pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bRxStopped */
-					xSendEventToIPTask( eTCPTimerEvent );
+					/* Fetch the current time */
+					vTaskSetTimeOutState( &xTimeOut );
 				}
-				xReturn = 0;
-				break;
 
-		#endif  /* ipconfigUSE_TCP == 1 */
+				/* Did it get connected while sleeping ? */
+				xResult = FreeRTOS_issocketconnected( pxSocket );
 
-		default :
-			/* No other options are handled. */
-			xReturn = -pdFREERTOS_ERRNO_ENOPROTOOPT;
-			break;
-	}
+				/* Returns positive when connected, negative means an error */
+				if( xResult < 0 )
+				{
+					/* Return the error */
+					break;
+				}
 
-	return xReturn;
-} /* Tested */
+				if( xResult > 0 )
+				{
+					/* Socket now connected, return a zero */
+					xResult = 0;
+					break;
+				}
 
-/*-----------------------------------------------------------*/
+				/* Is it allowed to sleep more? */
+				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) )
+				{
+					xResult = -pdFREERTOS_ERRNO_ETIMEDOUT;
+					break;
+				}
 
-/* Find an available port number per https://tools.ietf.org/html/rfc6056. */
-static uint16_t prvGetPrivatePortNumber( BaseType_t xProtocol )
-{
-const uint16_t usEphemeralPortCount =
-	socketAUTO_PORT_ALLOCATION_MAX_NUMBER - socketAUTO_PORT_ALLOCATION_START_NUMBER + 1;
-uint16_t usIterations = usEphemeralPortCount;
-uint32_t ulRandomSeed = 0;
-uint16_t usResult = 0;
-const List_t *pxList;
+				/* Go sleeping until we get any down-stream event */
+				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_CONNECT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+			}
+		}
 
-#if ipconfigUSE_TCP == 1
-	if( xProtocol == ( BaseType_t ) FREERTOS_IPPROTO_TCP )
-	{
-		pxList = &xBoundTCPSocketsList;
-	}
-	else
-#endif
-	{
-		pxList = &xBoundUDPSocketsList;
+		return xResult;
 	}
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
 
-	/* Avoid compiler warnings if ipconfigUSE_TCP is not defined. */
-	( void ) xProtocol;
+#if( ipconfigUSE_TCP == 1 )
 
-	/* Find the next available port using the random seed as a starting
-	point. */
-	do
+	/*
+	 * FreeRTOS_accept: can return a new connected socket
+	 * if the server socket is in listen mode and receives a connection request
+	 * The new socket will be bound already to the same port number as the listing
+	 * socket.
+	 */
+	Socket_t FreeRTOS_accept( Socket_t xServerSocket, struct freertos_sockaddr *pxAddress, socklen_t *pxAddressLength )
 	{
-		/* Only proceed if the random number generator succeeded. */
-		if( xApplicationGetRandomNumber( &( ulRandomSeed ) ) == pdFALSE )
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xServerSocket;
+	FreeRTOS_Socket_t *pxClientSocket = NULL;
+	TickType_t xRemainingTime;
+	BaseType_t xTimed = pdFALSE, xAsk = pdFALSE;
+	TimeOut_t xTimeOut;
+	IPStackEvent_t xAskEvent;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
 		{
-			break;
+			/* Not a valid socket or wrong type */
+			pxClientSocket = ( FreeRTOS_Socket_t * ) FREERTOS_INVALID_SOCKET;
 		}
-
-		/* Map the random to a candidate port. */
-		usResult =
-			socketAUTO_PORT_ALLOCATION_START_NUMBER +
-			( ( ( uint16_t )ulRandomSeed ) % usEphemeralPortCount );
-
-		/* Check if there's already an open socket with the same protocol
-		and port. */
-		if( NULL == pxListFindListItemWithValue(
-			pxList,
-			( TickType_t )FreeRTOS_htons( usResult ) ) )
+		else if( ( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED ) &&
+				 ( pxSocket->u.xTCP.ucTCPState != eTCP_LISTEN ) )
 		{
-			usResult = FreeRTOS_htons( usResult );
-			break;
+			/* Parent socket is not in listening mode */
+			pxClientSocket = ( FreeRTOS_Socket_t * ) FREERTOS_INVALID_SOCKET;
 		}
 		else
 		{
-			usResult = 0;
-		}
+			/* Loop will stop with breaks. */
+			for( ; ; )
+			{
+				/* Is there a new client? */
+				vTaskSuspendAll();
+				{
+					if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
+					{
+						pxClientSocket = pxSocket->u.xTCP.pxPeerSocket;
+					}
+					else
+					{
+						pxClientSocket = pxSocket;
+					}
+					if( pxClientSocket != NULL )
+					{
+						pxSocket->u.xTCP.pxPeerSocket = NULL;
+
+						/* Is it still not taken ? */
+						if( pxClientSocket->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED )
+						{
+							pxClientSocket->u.xTCP.bits.bPassAccept = pdFALSE_UNSIGNED;
+						}
+						else
+						{
+							pxClientSocket = NULL;
+						}
+					}
+				}
+				xTaskResumeAll();
+
+				if( pxClientSocket != NULL )
+				{
+					if( pxAddress != NULL )
+					{
+						/* IP address of remote machine. */
+						pxAddress->sin_addr = FreeRTOS_ntohl( pxClientSocket->u.xTCP.ulRemoteIP );
 
-		usIterations--;
-	}
-	while( usIterations > 0 );
+						/* Port on remote machine. */
+						pxAddress->sin_port = FreeRTOS_ntohs( pxClientSocket->u.xTCP.usRemotePort );
+					}
+					if( pxAddressLength != NULL )
+					{
+						*pxAddressLength = sizeof( *pxAddress );
+					}
 
-	return usResult;
-}
-/*-----------------------------------------------------------*/
+					if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
+					{
+						xAsk = pdTRUE;
+					}
+				}
 
-/* pxListFindListItemWithValue: find a list item in a bound socket list
-'xWantedItemValue' refers to a port number */
-static const ListItem_t * pxListFindListItemWithValue( const List_t *pxList, TickType_t xWantedItemValue )
-{
-const ListItem_t * pxResult = NULL;
+				if( xAsk != pdFALSE )
+				{
+					/* Ask to set an event in 'xEventGroup' as soon as a new
+					client gets connected for this listening socket. */
+					xAskEvent.eEventType = eTCPAcceptEvent;
+					xAskEvent.pvData = ( void * ) pxSocket;
+					xSendEventStructToIPTask( &xAskEvent, portMAX_DELAY );
+				}
 
-	if( ( xIPIsNetworkTaskReady() != pdFALSE ) && ( pxList != NULL ) )
-	{
-		const ListItem_t *pxIterator;
-		const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( pxList );
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
-		{
-			if( listGET_LIST_ITEM_VALUE( pxIterator ) == xWantedItemValue )
-			{
-				pxResult = pxIterator;
-				break;
-			}
-		}
-	}
+				if( pxClientSocket != NULL )
+				{
+					break;
+				}
 
-	return pxResult;
-} /* Tested */
+				if( xTimed == pdFALSE )
+				{
+					/* Only in the first round, check for non-blocking */
+					xRemainingTime = pxSocket->xReceiveBlockTime;
+					if( xRemainingTime == ( TickType_t ) 0 )
+					{
+						break;
+					}
 
-/*-----------------------------------------------------------*/
+					/* Don't get here a second time */
+					xTimed = pdTRUE;
 
-FreeRTOS_Socket_t *pxUDPSocketLookup( UBaseType_t uxLocalPort )
-{
-const ListItem_t *pxListItem;
-FreeRTOS_Socket_t *pxSocket = NULL;
+					/* Fetch the current time */
+					vTaskSetTimeOutState( &xTimeOut );
+				}
 
-	/* Looking up a socket is quite simple, find a match with the local port.
+				/* Has the timeout been reached? */
+				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+				{
+					break;
+				}
 
-	See if there is a list item associated with the port number on the
-	list of bound sockets. */
-	pxListItem = pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) uxLocalPort );
+				/* Go sleeping until we get any down-stream event */
+				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_ACCEPT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+			}
+		}
 
-	if( pxListItem != NULL )
-	{
-		/* The owner of the list item is the socket itself. */
-		pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxListItem );
-		configASSERT( pxSocket != NULL );
+		return ( Socket_t ) pxClientSocket;
 	}
-	return pxSocket;
-}
-
+#endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
-#if ipconfigINCLUDE_FULL_INET_ADDR == 1
+#if( ipconfigUSE_TCP == 1 )
 
-	uint32_t FreeRTOS_inet_addr( const char * pcIPAddress )
+	/*
+	 * Read incoming data from a TCP socket
+	 * Only after the last byte has been read, a close error might be returned
+	 */
+	BaseType_t FreeRTOS_recv( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags )
 	{
-	const uint32_t ulDecimalBase = 10u;
-	uint8_t ucOctet[ socketMAX_IP_ADDRESS_OCTETS ];
-	const char *pcPointerOnEntering;
-	uint32_t ulReturn = 0UL, ulValue;
-	UBaseType_t uxOctetNumber;
-	BaseType_t xResult = pdPASS;
+	BaseType_t xByteCount;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	TickType_t xRemainingTime;
+	BaseType_t xTimed = pdFALSE;
+	TimeOut_t xTimeOut;
+	EventBits_t xEventBits = ( EventBits_t ) 0;
 
-		for( uxOctetNumber = 0u; uxOctetNumber < socketMAX_IP_ADDRESS_OCTETS; uxOctetNumber++ )
+		/* Check if the socket is valid, has type TCP and if it is bound to a
+		port. */
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
 		{
-			ulValue = 0ul;
-			pcPointerOnEntering = pcIPAddress;
+			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			socketRX_STREAM_ENTER( pxSocket );
 
-			while( ( *pcIPAddress >= '0' ) && ( *pcIPAddress <= '9' ) )
+			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
-				/* Move previous read characters into the next decimal
-				position. */
-				ulValue *= ulDecimalBase;
-
-				/* Add the binary value of the ascii character. */
-				ulValue += ( ( uint32_t ) ( *pcIPAddress ) - ( uint32_t ) '0' );
-
-				/* Move to next character in the string. */
-				pcIPAddress++;
+				xByteCount = ( BaseType_t )uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
 			}
-
-			/* Check characters were read. */
-			if( pcIPAddress == pcPointerOnEntering )
+			else
 			{
-				xResult = pdFAIL;
+				xByteCount = 0;
 			}
 
-			/* Check the value fits in an 8-bit number. */
-			if( ulValue > 0xffUL )
-			{
-				xResult = pdFAIL;
-			}
-			else
+			while( xByteCount == 0 )
 			{
-				ucOctet[ uxOctetNumber ] = ( uint8_t ) ulValue;
-
-				/* Check the next character is as expected. */
-				if( uxOctetNumber < ( socketMAX_IP_ADDRESS_OCTETS - 1u ) )
+				switch( pxSocket->u.xTCP.ucTCPState )
 				{
-					if( *pcIPAddress != '.' )
+				case eCLOSED:
+				case eCLOSE_WAIT:	/* (server + client) waiting for a connection termination request from the local user. */
+				case eCLOSING:		/* (server + client) waiting for a connection termination request acknowledgement from the remote TCP. */
+					if( pxSocket->u.xTCP.bits.bMallocError != pdFALSE_UNSIGNED )
 					{
-						xResult = pdFAIL;
+						/* The no-memory error has priority above the non-connected error.
+						Both are fatal and will elad to closing the socket. */
+						xByteCount = -pdFREERTOS_ERRNO_ENOMEM;
 					}
 					else
 					{
-						/* Move past the dot. */
-						pcIPAddress++;
+						xByteCount = -pdFREERTOS_ERRNO_ENOTCONN;
+					}
+					/* Call continue to break out of the switch and also the while
+					loop. */
+					continue;
+				default:
+					break;
+				}
+
+				if( xTimed == pdFALSE )
+				{
+					/* Only in the first round, check for non-blocking. */
+					xRemainingTime = pxSocket->xReceiveBlockTime;
+
+					if( xRemainingTime == ( TickType_t ) 0 )
+					{
+						#if( ipconfigSUPPORT_SIGNALS != 0 )
+						{
+							/* Just check for the interrupt flag. */
+							xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_INTR,
+								pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, socketDONT_BLOCK );
+						}
+						#endif /* ipconfigSUPPORT_SIGNALS */
+						break;
+					}
+
+					if( ( xFlags & FREERTOS_MSG_DONTWAIT ) != 0 )
+					{
+						break;
+					}
+
+					/* Don't get here a second time. */
+					xTimed = pdTRUE;
+
+					/* Fetch the current time. */
+					vTaskSetTimeOutState( &xTimeOut );
+				}
+
+				/* Has the timeout been reached? */
+				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+				{
+					break;
+				}
+
+				/* Block until there is a down-stream event.  The IP-task may
+				replace the stream in the mean time. */
+				socketRX_STREAM_LEAVE( pxSocket );
+				xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup,
+					eSOCKET_RECEIVE | eSOCKET_CLOSED | eSOCKET_INTR,
+					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+				socketRX_STREAM_ENTER( pxSocket );
+				#if( ipconfigSUPPORT_SIGNALS != 0 )
+				{
+					if( ( xEventBits & eSOCKET_INTR ) != 0u )
+					{
+						break;
 					}
 				}
+				#else
+				{
+					( void ) xEventBits;
+				}
+				#endif /* ipconfigSUPPORT_SIGNALS */
+
+				if( pxSocket->u.xTCP.rxStream != NULL )
+				{
+					xByteCount = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
+				}
+				else
+				{
+					xByteCount = 0;
+				}
+			}
+
+		#if( ipconfigSUPPORT_SIGNALS != 0 )
+			if( ( xEventBits & eSOCKET_INTR ) != 0 )
+			{
+				if( ( xEventBits & ( eSOCKET_RECEIVE | eSOCKET_CLOSED ) ) != 0 )
+				{
+					/* Shouldn't have cleared other flags. */
+					xEventBits &= ~eSOCKET_INTR;
+					xEventGroupSetBits( pxSocket->xEventGroup, xEventBits );
+				}
+				xByteCount = -pdFREERTOS_ERRNO_EINTR;
+			}
+			else
+		#endif /* ipconfigSUPPORT_SIGNALS */
+			if( xByteCount > 0 )
+			{
+				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+				{
+					xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, ( uint8_t * ) pvBuffer, ( size_t ) xBufferLength, ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
+					prvTCPCheckLowWater( pxSocket );
+				}
+				else
+				{
+					/* Zero-copy reception of data: pvBuffer is a pointer to a pointer. */
+					xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
+				}
 			}
 
-			if( xResult == pdFAIL )
-			{
-				/* No point going on. */
-				break;
-			}
-		}
-
-		if( *pcIPAddress != ( char ) 0 )
-		{
-			/* Expected the end of the string. */
-			xResult = pdFAIL;
-		}
-
-		if( uxOctetNumber != socketMAX_IP_ADDRESS_OCTETS )
-		{
-			/* Didn't read enough octets. */
-			xResult = pdFAIL;
-		}
-
-		if( xResult == pdPASS )
-		{
-			ulReturn = FreeRTOS_inet_addr_quick( ucOctet[ 0 ], ucOctet[ 1 ], ucOctet[ 2 ], ucOctet[ 3 ] );
-		}
+			socketRX_STREAM_LEAVE( pxSocket );
+		} /* prvValidSocket() */
 
-		return ulReturn;
+		return xByteCount;
 	}
 
-#endif /* ipconfigINCLUDE_FULL_INET_ADDR */
-
-/*-----------------------------------------------------------*/
-
-/* Function to get the local address and IP port */
-size_t FreeRTOS_GetLocalAddress( Socket_t xSocket, struct freertos_sockaddr *pxAddress )
-{
-FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-
-	/* IP address of local machine. */
-	pxAddress->sin_addr = *ipLOCAL_IP_ADDRESS_POINTER;
-
-	/* Local port on this machine. */
-	pxAddress->sin_port = FreeRTOS_htons( pxSocket->usLocalPort );
-
-	return sizeof( *pxAddress );
-}
-
+#endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
-void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
-{
-/* _HT_ must work this out, now vSocketWakeUpUser will be called for any important
- * event or transition */
-	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
-	{
-		if( pxSocket->pxUserSemaphore != NULL )
-		{
-			xSemaphoreGive( pxSocket->pxUserSemaphore );
-		}
-	}
-	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
+#if( ipconfigUSE_TCP == 1 )
 
-	#if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK == 1 )
+	static void prvTCPCheckLowWater( FreeRTOS_Socket_t *pxSocket )
 	{
-		if( pxSocket->pxUserWakeCallback != NULL )
+		if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
 		{
-			pxSocket->pxUserWakeCallback( pxSocket );
-		}
-	}
-	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
+			/* We had reached the low-water mark, now see if the flag
+			can be cleared */
+			size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
 
-	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
-	{
-		if( pxSocket->pxSocketSet != NULL )
-		{
-			EventBits_t xSelectBits = ( pxSocket->xEventBits >> SOCKET_EVENT_BIT_COUNT ) & eSELECT_ALL;
-			if( xSelectBits != 0ul )
+			if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
 			{
-				pxSocket->xSocketBits |= xSelectBits;
-				xEventGroupSetBits( pxSocket->pxSocketSet->xSelectGroup, xSelectBits );
+				pxSocket->u.xTCP.bits.bLowWater = pdFALSE_UNSIGNED;
+				pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
+				pxSocket->u.xTCP.usTimeout = 1u; /* because bLowWater is cleared. */
+				prvTCPSendTimerEvent( pxSocket );
 			}
 		}
-
-		pxSocket->xEventBits &= eSOCKET_ALL;
-	}
-	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
-
-	if( ( pxSocket->xEventGroup != NULL ) && ( pxSocket->xEventBits != 0u ) )
-	{
-		xEventGroupSetBits( pxSocket->xEventGroup, pxSocket->xEventBits );
 	}
 
-	pxSocket->xEventBits = 0ul;
-}
-
+#endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
-#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+#if( ipconfigUSE_TCP == 1 )
 
-	/* This define makes it possible for network-card drivers to inspect
-	 * UDP message and see if there is any UDP socket bound to a given port
-	 * number.
-	 * This is probably only usefull in systems with a minimum of RAM and
-	 * when lots of anonymous broadcast messages come in
-	 */
-	BaseType_t xPortHasUDPSocket( uint16_t usPortNr )
+	BaseType_t FreeRTOS_recv_spans( Socket_t xSocket, FreeRTOS_iovec_t *pxSpans, BaseType_t xFlags )
 	{
-	BaseType_t xFound = pdFALSE;
+	BaseType_t xByteCount;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	uint8_t *pucFirst;
+	StreamBuffer_t *pxStream;
+	size_t uxSize, uxFirst;
 
-		vTaskSuspendAll();
+		pxSpans[ 0 ].pvBase = NULL;
+		pxSpans[ 0 ].uxLength = 0u;
+		pxSpans[ 1 ].pvBase = NULL;
+		pxSpans[ 1 ].uxLength = 0u;
+
+		/* Let FreeRTOS_recv() do the checking and the blocking.  Data will not
+		be consumed in zero-copy mode. */
+		xFlags &= ~FREERTOS_MSG_PEEK;
+		xByteCount = FreeRTOS_recv( xSocket, ( void * ) &pucFirst, 0u, xFlags | FREERTOS_ZERO_COPY );
+
+		if( xByteCount > 0 )
 		{
-			if( ( pxListFindListItemWithValue( &xBoundUDPSocketsList, ( TickType_t ) usPortNr ) != NULL ) )
+			socketRX_STREAM_ENTER( pxSocket );
+
+			/* The IP-task may have added data in the mean time, so take a new
+			snapshot of the size.  Only the owner of the socket moves uxTail,
+			so the spans will stay valid until FreeRTOS_recv_consume() is
+			called. */
+			pxStream = pxSocket->u.xTCP.rxStream;
+			uxSize = uxStreamBufferDistance( pxStream, pxStream->uxTail, pxStream->uxHead );
+			uxFirst = FreeRTOS_min_uint32( uxSize, pxStream->LENGTH - pxStream->uxTail );
+
+			pxSpans[ 0 ].pvBase = ( const void * ) ( pxStream->ucArray + pxStream->uxTail );
+			pxSpans[ 0 ].uxLength = uxFirst;
+
+			if( uxSize > uxFirst )
 			{
-				xFound = pdTRUE;
+				/* The data wraps around the end of the buffer, the remainder is
+				found at the start of ucArray[]. */
+				pxSpans[ 1 ].pvBase = ( const void * ) pxStream->ucArray;
+				pxSpans[ 1 ].uxLength = uxSize - uxFirst;
 			}
+
+			xByteCount = ( BaseType_t ) uxSize;
+
+			socketRX_STREAM_LEAVE( pxSocket );
 		}
-		xTaskResumeAll();
 
-		return xFound;
+		return xByteCount;
 	}
 
-#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
-
+#endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP == 1 )
 
-	static BaseType_t bMayConnect( FreeRTOS_Socket_t *pxSocket );
-	static BaseType_t bMayConnect( FreeRTOS_Socket_t *pxSocket )
+	BaseType_t FreeRTOS_recv_consume( Socket_t xSocket, size_t uxCount )
 	{
-		switch( pxSocket->u.xTCP.ucTCPState )
+	BaseType_t xByteCount;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
 		{
-			case eCLOSED:
-			case eCLOSE_WAIT:	return 0;
-			case eCONNECT_SYN:	return -pdFREERTOS_ERRNO_EINPROGRESS;
-			default:			return -pdFREERTOS_ERRNO_EAGAIN;
+			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			socketRX_STREAM_ENTER( pxSocket );
+
+			if( pxSocket->u.xTCP.rxStream == NULL )
+			{
+				xByteCount = 0;
+			}
+			else
+			{
+				/* Passing NULL as a target makes uxStreamBufferGet() move uxTail
+				without copying anything.  It will never consume more than the
+				number of bytes stored. */
+				xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0u, NULL, uxCount, pdFALSE );
+				prvTCPCheckLowWater( pxSocket );
+			}
+
+			socketRX_STREAM_LEAVE( pxSocket );
 		}
+
+		return xByteCount;
 	}
 
 #endif /* ipconfigUSE_TCP */
@@ -1960,58 +3163,45 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 #if( ipconfigUSE_TCP == 1 )
 
-	static BaseType_t prvTCPConnectStart( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr *pxAddress )
+	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength )
 	{
-	BaseType_t xResult = 0;
+	int32_t xResult = 1;
 
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdFALSE )
+		/* Is this a socket of type TCP and is it already bound to a port number ? */
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
 		{
-			/* Not a valid socket or wrong type */
-			xResult = -pdFREERTOS_ERRNO_EBADF;
+			xResult = -pdFREERTOS_ERRNO_EINVAL;
 		}
-		else if( FreeRTOS_issocketconnected( pxSocket ) > 0 )
+		else if( pxSocket->u.xTCP.bits.bMallocError != pdFALSE_UNSIGNED )
 		{
-			/* The socket is already connected. */
-			xResult = -pdFREERTOS_ERRNO_EISCONN;
+			xResult = -pdFREERTOS_ERRNO_ENOMEM;
 		}
-		else if( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE )
+		else if( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
+                 pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
+                 pxSocket->u.xTCP.ucTCPState == eCLOSING )
 		{
-			/* Bind the socket to the port that the client task will send from.
-			Non-standard, so the error returned is that returned by bind(). */
-			xResult = FreeRTOS_bind( ( Socket_t ) pxSocket, NULL, 0u );
+			xResult = -pdFREERTOS_ERRNO_ENOTCONN;
 		}
-
-		if( xResult == 0 )
+		else if( pxSocket->u.xTCP.bits.bFinSent != pdFALSE_UNSIGNED )
 		{
-			/* Check if it makes any sense to wait for a connect event, this condition
-			might change while sleeping, so it must be checked within each loop */
-			xResult = bMayConnect( pxSocket ); /* -EINPROGRESS, -EAGAIN, or 0 for OK */
+			/* This TCP connection is closing already, the FIN flag has been sent.
+			Maybe it is still delivering or receiving data.
+			Return OK in order not to get closed/deleted too quickly */
+			xResult = 0;
+		}
+		else if( xDataLength == 0ul )
+		{
+			/* send() is being called to send zero bytes */
+			xResult = 0;
+		}
+		else if( pxSocket->u.xTCP.txStream == NULL )
+		{
+			/* Create the outgoing stream only when it is needed */
+			prvTCPCreateStream( pxSocket, pdFALSE );
 
-			/* Start the connect procedure, kernel will start working on it */
-			if( xResult == 0 )
+			if( pxSocket->u.xTCP.txStream == NULL )
 			{
-				pxSocket->u.xTCP.bits.bConnPrepared = pdFALSE_UNSIGNED;
-				pxSocket->u.xTCP.ucRepCount = 0u;
-
-				FreeRTOS_debug_printf( ( "FreeRTOS_connect: %u to %lxip:%u\n",
-					pxSocket->usLocalPort, FreeRTOS_ntohl( pxAddress->sin_addr ), FreeRTOS_ntohs( pxAddress->sin_port ) ) );
-
-				/* Port on remote machine. */
-				pxSocket->u.xTCP.usRemotePort = FreeRTOS_ntohs( pxAddress->sin_port );
-
-				/* IP address of remote machine. */
-				pxSocket->u.xTCP.ulRemoteIP = FreeRTOS_ntohl( pxAddress->sin_addr );
-
-				/* (client) internal state: socket wants to send a connect. */
-				vTCPStateChange( pxSocket, eCONNECT_SYN );
-
-				/* To start an active connect. */
-				pxSocket->u.xTCP.usTimeout = 1u;
-
-				if( xSendEventToIPTask( eTCPTimerEvent ) != pdPASS )
-				{
-					xResult = -pdFREERTOS_ERRNO_ECANCELED;
-				}
+				xResult = -pdFREERTOS_ERRNO_ENOMEM;
 			}
 		}
 
@@ -2023,276 +3213,304 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 #if( ipconfigUSE_TCP == 1 )
 
-	/*
-	 * FreeRTOS_connect: socket wants to connect to a remote port
-	 */
-	BaseType_t FreeRTOS_connect( Socket_t xClientSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength )
+	/* Get a direct pointer to the circular transmit buffer.
+	'*pxLength' will contain the number of bytes that may be written. */
+	uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength )
 	{
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t* ) xClientSocket;
-	TickType_t xRemainingTime;
-	BaseType_t xTimed = pdFALSE;
-	BaseType_t xResult;
-	TimeOut_t xTimeOut;
+    uint8_t *pucReturn = NULL;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	StreamBuffer_t *pxBuffer = NULL;
 
-		( void ) xAddressLength;
+        *pxLength = 0;
 
-		xResult = prvTCPConnectStart( pxSocket, pxAddress );
+        /* Confirm that this is a TCP socket before dereferencing structure
+        member pointers. */
+        if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
+        {
+			socketTX_STREAM_ENTER( pxSocket );
 
-		if( xResult == 0 )
-		{
-			/* And wait for the result */
-			for( ;; )
-			{
-				if( xTimed == pdFALSE )
+            pxBuffer = pxSocket->u.xTCP.txStream;
+            if( pxBuffer != NULL )
+            {
+				#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
 				{
-					/* Only in the first round, check for non-blocking */
-					xRemainingTime = pxSocket->xReceiveBlockTime;
-					if( xRemainingTime == ( TickType_t )0 )
-					{
-						/* Not yet connected, correct state, non-blocking. */
-						xResult = -pdFREERTOS_ERRNO_EWOULDBLOCK;
-						break;
-					}
+					/* The application will write to the stream directly, it
+					can not be replaced any more. */
+					pxSocket->u.xTCP.xAutoTune.ucTxPinned = pdTRUE_UNSIGNED;
+				}
+				#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+            BaseType_t xSpace = ( BaseType_t )uxStreamBufferGetSpace( pxBuffer );
+            BaseType_t xRemain = ( BaseType_t )( pxBuffer->LENGTH - pxBuffer->uxHead );
+
+                *pxLength = FreeRTOS_min_BaseType( xSpace, xRemain );
+                pucReturn = pxBuffer->ucArray + pxBuffer->uxHead;
+            }
+
+			socketTX_STREAM_LEAVE( pxSocket );
+		}
+
+		return pucReturn;
+	}
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
 
-					/* Don't get here a second time. */
-					xTimed = pdTRUE;
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * Send data using a TCP socket.  It is not necessary to have the socket
+	 * connected already.  Outgoing data will be stored and delivered as soon as
+	 * the socket gets connected.
+	 */
+	BaseType_t FreeRTOS_send( Socket_t xSocket, const void *pvBuffer, size_t uxDataLength, BaseType_t xFlags )
+	{
+	FreeRTOS_iovec_t xVector;
 
-					/* Fetch the current time */
-					vTaskSetTimeOutState( &xTimeOut );
-				}
+		/* This is a vectored send with a single element. */
+		xVector.pvBase = pvBuffer;
+		xVector.uxLength = uxDataLength;
 
-				/* Did it get connected while sleeping ? */
-				xResult = FreeRTOS_issocketconnected( pxSocket );
+		return FreeRTOS_sendv( xSocket, &xVector, 1, xFlags );
+	}
 
-				/* Returns positive when connected, negative means an error */
-				if( xResult < 0 )
-				{
-					/* Return the error */
-					break;
-				}
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
 
-				if( xResult > 0 )
-				{
-					/* Socket now connected, return a zero */
-					xResult = 0;
-					break;
-				}
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_REFERENCES != 0 )
 
-				/* Is it allowed to sleep more? */
-				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) )
-				{
-					xResult = -pdFREERTOS_ERRNO_ETIMEDOUT;
-					break;
-				}
+	static BaseType_t prvTCPAddTxReference( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucData, size_t uxCount )
+	{
+	TCPTxReference_t *pxReference;
+	UBaseType_t uxHead = pxSocket->u.xTCP.uxTxRefHead;
+	UBaseType_t uxNext = uxHead + 1u;
+	BaseType_t xResult = pdFALSE;
 
-				/* Go sleeping until we get any down-stream event */
-				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_CONNECT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
-			}
+		if( uxNext >= ipTCP_TX_REFERENCE_SLOTS )
+		{
+			uxNext = 0u;
+		}
+
+		if( uxNext != pxSocket->u.xTCP.uxTxRefTail )
+		{
+			/* The entry must be complete before the IP-task can see it, and
+			the IP-task must see it before the stream grows. */
+			pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxHead ] );
+			pxReference->pucData = pucData;
+			pxReference->uxStart = pxSocket->u.xTCP.txStream->uxHead;
+			pxReference->uxLength = uxCount;
+			pxReference->uxAcked = 0u;
+			pxSocket->u.xTCP.uxTxRefHead = uxNext;
+
+			/* Occupy the space in the stream without copying any data. */
+			( void ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0u, NULL, uxCount );
+			xResult = pdTRUE;
 		}
 
 		return xResult;
 	}
-#endif /* ipconfigUSE_TCP */
+
+#endif /* ipconfigUSE_TCP && ipconfigTCP_TX_REFERENCES */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP == 1 )
-
 	/*
-	 * FreeRTOS_accept: can return a new connected socket
-	 * if the server socket is in listen mode and receives a connection request
-	 * The new socket will be bound already to the same port number as the listing
-	 * socket.
+	 * Send the data of 'xVectorCount' buffers using a TCP socket.  The data will
+	 * be added to the TX stream in one go, or, when FREERTOS_MSG_REFERENCE is
+	 * used, attached to it by reference.
 	 */
-	Socket_t FreeRTOS_accept( Socket_t xServerSocket, struct freertos_sockaddr *pxAddress, socklen_t *pxAddressLength )
+	BaseType_t FreeRTOS_sendv( Socket_t xSocket, const FreeRTOS_iovec_t *pxVector, BaseType_t xVectorCount, BaseType_t xFlags )
 	{
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xServerSocket;
-	FreeRTOS_Socket_t *pxClientSocket = NULL;
+	BaseType_t xByteCount;
+	BaseType_t xBytesLeft;
+	BaseType_t xBytesAdded;
+	BaseType_t xIndex;
+	size_t uxDataLength = 0u;
+	size_t uxElementLeft = 0u;
+	size_t uxCount;
+	const uint8_t *pucData = NULL;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 	TickType_t xRemainingTime;
-	BaseType_t xTimed = pdFALSE, xAsk = pdFALSE;
+	BaseType_t xTimed = pdFALSE;
 	TimeOut_t xTimeOut;
-	IPStackEvent_t xAskEvent;
+	BaseType_t xCloseAfterSend;
 
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		for( xIndex = 0; xIndex < xVectorCount; xIndex++ )
 		{
-			/* Not a valid socket or wrong type */
-			pxClientSocket = ( FreeRTOS_Socket_t * ) FREERTOS_INVALID_SOCKET;
+			uxDataLength += pxVector[ xIndex ].uxLength;
 		}
-		else if( ( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED ) &&
-				 ( pxSocket->u.xTCP.ucTCPState != eTCP_LISTEN ) )
+		xIndex = 0;
+
+		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
+
+		#if( ipconfigTCP_TX_REFERENCES != 0 )
 		{
-			/* Parent socket is not in listening mode */
-			pxClientSocket = ( FreeRTOS_Socket_t * ) FREERTOS_INVALID_SOCKET;
+			if( ( xByteCount > 0 ) && ( ( xFlags & FREERTOS_MSG_REFERENCE ) != 0 ) && ( pxSocket->u.xTCP.pxHandleTxReference == NULL ) )
+			{
+				/* Without a handler the buffers can never be returned. */
+				xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+			}
 		}
-		else
+		#endif /* ipconfigTCP_TX_REFERENCES */
+
+		if( xByteCount > 0 )
 		{
-			/* Loop will stop with breaks. */
-			for( ; ; )
+			/* xBytesLeft is number of bytes to send, will count to zero. */
+			xBytesLeft = ( BaseType_t ) uxDataLength;
+
+			socketTX_STREAM_ENTER( pxSocket );
+
+			/* xByteCount is number of bytes that can be sent now. */
+			xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+
+			/* While there are still bytes to be sent. */
+			while( xBytesLeft > 0 )
 			{
-				/* Is there a new client? */
-				vTaskSuspendAll();
+				/* If txStream has space. */
+				if( xByteCount > 0 )
 				{
-					if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
+					/* Don't send more than necessary. */
+					if( xByteCount > xBytesLeft )
 					{
-						pxClientSocket = pxSocket->u.xTCP.pxPeerSocket;
+						xByteCount = xBytesLeft;
+					}
+
+					/* Is the close-after-send flag set and could this be the
+					last transmission? */
+					if( ( pxSocket->u.xTCP.bits.bCloseAfterSend != pdFALSE_UNSIGNED ) && ( xByteCount == xBytesLeft ) )
+					{
+						xCloseAfterSend = pdTRUE;
 					}
 					else
 					{
-						pxClientSocket = pxSocket;
+						xCloseAfterSend = pdFALSE;
 					}
-					if( pxClientSocket != NULL )
+
+					/* The flag 'bCloseAfterSend' can be set before sending data
+					using setsockopt()
+
+					When the last data packet is being sent out, a FIN flag will
+					be included to let the peer know that no more data is to be
+					expected.  The use of 'bCloseAfterSend' is not mandatory, it
+					is just a faster way of transferring files (e.g. when using
+					FTP). */
+					if( xCloseAfterSend != pdFALSE )
 					{
-						pxSocket->u.xTCP.pxPeerSocket = NULL;
+						/* Now suspend the scheduler: sending the last data	and
+						setting bCloseRequested must be done together */
+						vTaskSuspendAll();
+					}
 
-						/* Is it still not taken ? */
-						if( pxClientSocket->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED )
+					/* Add the data element by element. */
+					xBytesAdded = 0;
+					while( xBytesAdded < xByteCount )
+					{
+						if( uxElementLeft == 0u )
 						{
-							pxClientSocket->u.xTCP.bits.bPassAccept = pdFALSE_UNSIGNED;
+							/* Continue with the next element, empty elements
+							are skipped. */
+							pucData = ( const uint8_t * ) pxVector[ xIndex ].pvBase;
+							uxElementLeft = pxVector[ xIndex ].uxLength;
+							xIndex++;
+							continue;
+						}
+
+						uxCount = ( size_t ) ( xByteCount - xBytesAdded );
+						if( uxCount > uxElementLeft )
+						{
+							uxCount = uxElementLeft;
+						}
+
+						#if( ipconfigTCP_TX_REFERENCES != 0 )
+						if( ( xFlags & FREERTOS_MSG_REFERENCE ) != 0 )
+						{
+							if( prvTCPAddTxReference( pxSocket, pucData, uxCount ) == pdFALSE )
+							{
+								/* All references are in use, wait until the
+								IP-task returns one. */
+								break;
+							}
 						}
 						else
+						#endif /* ipconfigTCP_TX_REFERENCES */
 						{
-							pxClientSocket = NULL;
+							uxCount = uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, pucData, uxCount );
 						}
+
+						pucData += uxCount;
+						uxElementLeft -= uxCount;
+						xBytesAdded += ( BaseType_t ) uxCount;
 					}
-				}
-				xTaskResumeAll();
 
-				if( pxClientSocket != NULL )
-				{
-					if( pxAddress != NULL )
+					if( xCloseAfterSend != pdFALSE )
 					{
-						/* IP address of remote machine. */
-						pxAddress->sin_addr = FreeRTOS_ntohl( pxClientSocket->u.xTCP.ulRemoteIP );
+						if( xBytesAdded == xBytesLeft )
+						{
+							pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
+						}
 
-						/* Port on remote machine. */
-						pxAddress->sin_port = FreeRTOS_ntohs( pxClientSocket->u.xTCP.usRemotePort );
-					}
-					if( pxAddressLength != NULL )
-					{
-						*pxAddressLength = sizeof( *pxAddress );
+						/* Now when the IP-task transmits the data, it will also
+						see	that bCloseRequested is true and include the FIN
+						flag to start closure of the connection. */
+						xTaskResumeAll();
 					}
 
-					if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
-					{
-						xAsk = pdTRUE;
-					}
-				}
+					xByteCount = xBytesAdded;
 
-				if( xAsk != pdFALSE )
-				{
-					/* Ask to set an event in 'xEventGroup' as soon as a new
-					client gets connected for this listening socket. */
-					xAskEvent.eEventType = eTCPAcceptEvent;
-					xAskEvent.pvData = ( void * ) pxSocket;
-					xSendEventStructToIPTask( &xAskEvent, portMAX_DELAY );
-				}
+					/* Send a message to the IP-task so it can work on this
+					socket.  Data is sent, let the IP-task work on it. */
+					pxSocket->u.xTCP.usTimeout = 1u;
 
-				if( pxClientSocket != NULL )
-				{
-					break;
-				}
+					/* The IP-task will probably run before this function
+					continues.  It may replace the stream in the mean time. */
+					socketTX_STREAM_LEAVE( pxSocket );
 
-				if( xTimed == pdFALSE )
-				{
-					/* Only in the first round, check for non-blocking */
-					xRemainingTime = pxSocket->xReceiveBlockTime;
-					if( xRemainingTime == ( TickType_t ) 0 )
+					#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
 					{
-						break;
+						/* The socket must be moved in the timer wheel, also
+						when called from the IP-task. */
+						prvTCPSendTimerEvent( pxSocket );
 					}
-
-					/* Don't get here a second time */
-					xTimed = pdTRUE;
-
-					/* Fetch the current time */
-					vTaskSetTimeOutState( &xTimeOut );
-				}
-
-				/* Has the timeout been reached? */
-				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
-				{
-					break;
-				}
-
-				/* Go sleeping until we get any down-stream event */
-				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_ACCEPT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
-			}
-		}
-
-		return ( Socket_t ) pxClientSocket;
-	}
-#endif /* ipconfigUSE_TCP */
-/*-----------------------------------------------------------*/
-
-#if( ipconfigUSE_TCP == 1 )
-
-	/*
-	 * Read incoming data from a TCP socket
-	 * Only after the last byte has been read, a close error might be returned
-	 */
-	BaseType_t FreeRTOS_recv( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags )
-	{
-	BaseType_t xByteCount;
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-	TickType_t xRemainingTime;
-	BaseType_t xTimed = pdFALSE;
-	TimeOut_t xTimeOut;
-	EventBits_t xEventBits = ( EventBits_t ) 0;
-
-		/* Check if the socket is valid, has type TCP and if it is bound to a
-		port. */
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
-		{
-			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
-		}
-		else
-		{
-			if( pxSocket->u.xTCP.rxStream != NULL )
-			{
-				xByteCount = ( BaseType_t )uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
-			}
-			else
-			{
-				xByteCount = 0;
-			}
-
-			while( xByteCount == 0 )
-			{
-				switch( pxSocket->u.xTCP.ucTCPState )
-				{
-				case eCLOSED:
-				case eCLOSE_WAIT:	/* (server + client) waiting for a connection termination request from the local user. */
-				case eCLOSING:		/* (server + client) waiting for a connection termination request acknowledgement from the remote TCP. */
-					if( pxSocket->u.xTCP.bits.bMallocError != pdFALSE_UNSIGNED )
+					#else
 					{
-						/* The no-memory error has priority above the non-connected error.
-						Both are fatal and will elad to closing the socket. */
-						xByteCount = -pdFREERTOS_ERRNO_ENOMEM;
+						if( xIsCallingFromIPTask() == pdFALSE )
+						{
+							/* Only send a TCP timer event when not called from the
+							IP-task. */
+							xSendEventToIPTask( eTCPTimerEvent );
+						}
 					}
-					else
+					#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
+					socketTX_STREAM_ENTER( pxSocket );
+
+					xBytesLeft -= xByteCount;
+
+					if( xBytesLeft == 0 )
 					{
-						xByteCount = -pdFREERTOS_ERRNO_ENOTCONN;
+						break;
 					}
-					/* Call continue to break out of the switch and also the while
-					loop. */
-					continue;
-				default:
-					break;
 				}
 
+				/* Not all bytes have been sent. In case the socket is marked as
+				blocking sleep for a while. */
 				if( xTimed == pdFALSE )
 				{
 					/* Only in the first round, check for non-blocking. */
-					xRemainingTime = pxSocket->xReceiveBlockTime;
+					xRemainingTime = pxSocket->xSendBlockTime;
 
-					if( xRemainingTime == ( TickType_t ) 0 )
+					#if( ipconfigUSE_CALLBACKS != 0 )
 					{
-						#if( ipconfigSUPPORT_SIGNALS != 0 )
+						if( xIsCallingFromIPTask() != pdFALSE )
 						{
-							/* Just check for the interrupt flag. */
-							xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_INTR,
-								pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, socketDONT_BLOCK );
+							/* If this send function is called from within a
+							call-back handler it may not block, otherwise
+							chances would be big to get a deadlock: the IP-task
+							waiting for	itself. */
+							xRemainingTime = ( TickType_t ) 0;
 						}
-						#endif /* ipconfigSUPPORT_SIGNALS */
+					}
+					#endif /* ipconfigUSE_CALLBACKS */
+
+					if( xRemainingTime == ( TickType_t ) 0 )
+					{
 						break;
 					}
 
@@ -2307,537 +3525,755 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					/* Fetch the current time. */
 					vTaskSetTimeOutState( &xTimeOut );
 				}
-
-				/* Has the timeout been reached? */
-				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+				else
 				{
-					break;
+					/* Has the timeout been reached? */
+					if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+					{
+						break;
+					}
 				}
 
-				/* Block until there is a down-stream event. */
-				xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup,
-					eSOCKET_RECEIVE | eSOCKET_CLOSED | eSOCKET_INTR,
+				/* Go sleeping until down-stream events are received.  The
+				IP-task may replace the stream in the mean time. */
+				socketTX_STREAM_LEAVE( pxSocket );
+				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_SEND | eSOCKET_CLOSED,
 					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
-				#if( ipconfigSUPPORT_SIGNALS != 0 )
+				socketTX_STREAM_ENTER( pxSocket );
+
+				xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			}
+
+			socketTX_STREAM_LEAVE( pxSocket );
+
+			/* How much was actually sent? */
+			xByteCount = ( ( BaseType_t ) uxDataLength ) - xBytesLeft;
+
+			if( xByteCount == 0 )
+			{
+				if( pxSocket->u.xTCP.ucTCPState > eESTABLISHED )
 				{
-					if( ( xEventBits & eSOCKET_INTR ) != 0u )
-					{
-						break;
-					}
+					xByteCount = ( BaseType_t ) -pdFREERTOS_ERRNO_ENOTCONN;
 				}
-				#else
+				else
 				{
-					( void ) xEventBits;
+					if( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE )
+					{
+						FreeRTOS_debug_printf( ( "FreeRTOS_send: %u -> %lxip:%d: no space\n",
+							pxSocket->usLocalPort,
+							pxSocket->u.xTCP.ulRemoteIP,
+							pxSocket->u.xTCP.usRemotePort ) );
+					}
+
+					xByteCount = ( BaseType_t ) -pdFREERTOS_ERRNO_ENOSPC;
 				}
-				#endif /* ipconfigSUPPORT_SIGNALS */
+			}
+		}
+
+		return xByteCount;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	/*
+	 * Request to put a socket in listen mode
+	 */
+	BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	BaseType_t xResult = 0;
+
+		pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+		/* listen() is allowed for a valid TCP socket in Closed state and already
+		bound. */
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		{
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else if( ( pxSocket->u.xTCP.ucTCPState != eCLOSED ) && ( pxSocket->u.xTCP.ucTCPState != eCLOSE_WAIT ) )
+		{
+			/* Socket is in a wrong state. */
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else
+		{
+			/* Backlog is interpreted here as "the maximum number of child
+			sockets. */
+			pxSocket->u.xTCP.usBacklog = ( uint16_t )FreeRTOS_min_int32( ( int32_t ) 0xffff, ( int32_t ) xBacklog );
 
+			/* This cleaning is necessary only if a listening socket is being
+			reused as it might have had a previous connection. */
+			if( pxSocket->u.xTCP.bits.bReuseSocket )
+			{
 				if( pxSocket->u.xTCP.rxStream != NULL )
 				{
-					xByteCount = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
+					vStreamBufferClear( pxSocket->u.xTCP.rxStream );
 				}
-				else
+
+				if( pxSocket->u.xTCP.txStream != NULL )
 				{
-					xByteCount = 0;
+					vStreamBufferClear( pxSocket->u.xTCP.txStream );
 				}
+
+				memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, '\0', sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
+				memset( &pxSocket->u.xTCP.xTCPWindow, '\0', sizeof( pxSocket->u.xTCP.xTCPWindow ) );
+				memset( &pxSocket->u.xTCP.bits, '\0', sizeof( pxSocket->u.xTCP.bits ) );
+
+				/* Now set the bReuseSocket flag again, because the bits have
+				just been cleared. */
+				pxSocket->u.xTCP.bits.bReuseSocket = pdTRUE_UNSIGNED;
 			}
 
-		#if( ipconfigSUPPORT_SIGNALS != 0 )
-			if( ( xEventBits & eSOCKET_INTR ) != 0 )
+			vTCPStateChange( pxSocket, eTCP_LISTEN );
+		}
+
+		return xResult;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	/* shutdown - shut down part of a full-duplex connection */
+	BaseType_t FreeRTOS_shutdown( Socket_t xSocket, BaseType_t xHow )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xResult;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		{
+			/*_RB_ Is this comment correct?  The socket is not of a type that
+			supports the listen() operation. */
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else if ( pxSocket->u.xTCP.ucTCPState != eESTABLISHED )
+		{
+			/*_RB_ Is this comment correct?  The socket is not of a type that
+			supports the listen() operation. */
+			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+		}
+		else
+		{
+			pxSocket->u.xTCP.bits.bUserShutdown = pdTRUE_UNSIGNED;
+
+			/* Let the IP-task perform the shutdown of the connection. */
+			pxSocket->u.xTCP.usTimeout = 1u;
+			prvTCPSendTimerEvent( pxSocket );
+			xResult = 0;
+		}
+		(void) xHow;
+
+		return xResult;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_TIMER_WHEEL == 0 )
+
+	/*
+	 * A TCP timer has expired, now check all TCP sockets for:
+	 * - Active connect
+	 * - Send a delayed ACK
+	 * - Send new data
+	 * - Send a keep-alive packet
+	 * - Check for timeout (in non-connected states only)
+	 */
+	TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	TickType_t xShortest = pdMS_TO_TICKS( ( TickType_t ) ipTCP_TIMER_PERIOD_MS );
+	TickType_t xNow = xTaskGetTickCount();
+	static TickType_t xLastTime = 0u;
+	TickType_t xDelta = xNow - xLastTime;
+	ListItem_t* pxEnd = ( ListItem_t * ) listGET_END_MARKER( &xBoundTCPSocketsList );
+	ListItem_t *pxIterator = ( ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+
+		xLastTime = xNow;
+
+		if( xDelta == 0u )
+		{
+			xDelta = 1u;
+		}
+
+		while( pxIterator != pxEnd )
+		{
+			pxSocket = ( FreeRTOS_Socket_t * )listGET_LIST_ITEM_OWNER( pxIterator );
+			pxIterator = ( ListItem_t * ) listGET_NEXT( pxIterator );
+
+			/* Sockets with 'tmout == 0' do not need any regular attention. */
+			if( pxSocket->u.xTCP.usTimeout == 0u )
 			{
-				if( ( xEventBits & ( eSOCKET_RECEIVE | eSOCKET_CLOSED ) ) != 0 )
-				{
-					/* Shouldn't have cleared other flags. */
-					xEventBits &= ~eSOCKET_INTR;
-					xEventGroupSetBits( pxSocket->xEventGroup, xEventBits );
-				}
-				xByteCount = -pdFREERTOS_ERRNO_EINTR;
+				continue;
+			}
+
+			if( xDelta < ( TickType_t ) pxSocket->u.xTCP.usTimeout )
+			{
+				pxSocket->u.xTCP.usTimeout = ( uint16_t ) ( ( ( TickType_t ) pxSocket->u.xTCP.usTimeout ) - xDelta );
 			}
 			else
-		#endif /* ipconfigSUPPORT_SIGNALS */
-			if( xByteCount > 0 )
 			{
-				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+			int rc ;
+				pxSocket->u.xTCP.usTimeout = 0u;
+				rc = xTCPSocketCheck( pxSocket );
+
+				/* Within this function, the socket might want to send a delayed
+				ack or send out data or whatever it needs to do. */
+				if( rc < 0 )
 				{
-					xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, ( uint8_t * ) pvBuffer, ( size_t ) xBufferLength, ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
-					if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
-					{
-						/* We had reached the low-water mark, now see if the flag
-						can be cleared */
-						size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
+					/* Continue because the socket was deleted. */
+					continue;
+				}
+			}
 
-						if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
-						{
-							pxSocket->u.xTCP.bits.bLowWater = pdFALSE_UNSIGNED;
-							pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
-							pxSocket->u.xTCP.usTimeout = 1u; /* because bLowWater is cleared. */
-							xSendEventToIPTask( eTCPTimerEvent );
-						}
-					}
+			/* In xEventBits the driver may indicate that the socket has
+			important events for the user.  These are only done just before the
+			IP-task goes to sleep. */
+			if( pxSocket->xEventBits != 0u )
+			{
+				if( xWillSleep != pdFALSE )
+				{
+					/* The IP-task is about to go to sleep, so messages can be
+					sent to the socket owners. */
+					vSocketWakeUpUser( pxSocket );
 				}
 				else
 				{
-					/* Zero-copy reception of data: pvBuffer is a pointer to a pointer. */
-					xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
+					/* Or else make sure this will be called again to wake-up
+					the sockets' owner. */
+					xShortest = ( TickType_t ) 0;
 				}
 			}
-		} /* prvValidSocket() */
 
-		return xByteCount;
+			if( ( pxSocket->u.xTCP.usTimeout != 0u ) && ( xShortest > ( TickType_t ) pxSocket->u.xTCP.usTimeout ) )
+			{
+				xShortest = ( TickType_t ) pxSocket->u.xTCP.usTimeout;
+			}
+		}
+
+		return xShortest;
 	}
 
-#endif /* ipconfigUSE_TCP */
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL == 0 */
 /*-----------------------------------------------------------*/
 
-#if( ipconfigUSE_TCP == 1 )
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
 
-	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength )
+	static void prvTCPTimerInsert( FreeRTOS_Socket_t *pxSocket, TickType_t xExpiryTime )
 	{
-	int32_t xResult = 1;
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xDelta;
+	UBaseType_t uxLevel;
+	List_t *pxList;
 
-		/* Is this a socket of type TCP and is it already bound to a port number ? */
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
-		{
-			xResult = -pdFREERTOS_ERRNO_EINVAL;
-		}
-		else if( pxSocket->u.xTCP.bits.bMallocError != pdFALSE_UNSIGNED )
-		{
-			xResult = -pdFREERTOS_ERRNO_ENOMEM;
-		}
-		else if( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSING )
-		{
-			xResult = -pdFREERTOS_ERRNO_ENOTCONN;
-		}
-		else if( pxSocket->u.xTCP.bits.bFinSent != pdFALSE_UNSIGNED )
+		if( prvTCPTimerCount() == 0u )
 		{
-			/* This TCP connection is closing already, the FIN flag has been sent.
-			Maybe it is still delivering or receiving data.
-			Return OK in order not to get closed/deleted too quickly */
-			xResult = 0;
+			/* The wheel is empty, let it start at the current time. */
+			xTCPTimerWheelTime = xNow;
 		}
-		else if( xDataLength == 0ul )
+
+		listSET_LIST_ITEM_VALUE( &( pxSocket->u.xTCP.xTimerListItem ), xExpiryTime );
+
+		if( socketTIME_REACHED( xNow, xExpiryTime ) )
 		{
-			/* send() is being called to send zero bytes */
-			xResult = 0;
+			/* The socket must be attended to during the next check. */
+			pxList = &xTCPTimerDueList;
 		}
-		else if( pxSocket->u.xTCP.txStream == NULL )
+		else
 		{
-			/* Create the outgoing stream only when it is needed */
-			prvTCPCreateStream( pxSocket, pdFALSE );
+			xDelta = xExpiryTime - xTCPTimerWheelTime;
 
-			if( pxSocket->u.xTCP.txStream == NULL )
+			if( xDelta > ( TickType_t ) 0xffffu )
 			{
-				xResult = -pdFREERTOS_ERRNO_ENOMEM;
+				/* Too far away, store it at the end of the wheel.  It will be
+				re-inserted when that part of the wheel is cascaded. */
+				xExpiryTime = xTCPTimerWheelTime + ( TickType_t ) 0xffffu;
+				xDelta = ( TickType_t ) 0xffffu;
+			}
+
+			/* Find the lowest level that covers the time of expiry. */
+			for( uxLevel = 0u; uxLevel < ( socketTIMER_WHEEL_LEVELS - 1u ); uxLevel++ )
+			{
+				if( xDelta < ( ( TickType_t ) socketTIMER_WHEEL_SLOTS << ( uxLevel * socketTIMER_WHEEL_BITS ) ) )
+				{
+					break;
+				}
 			}
+
+			pxList = &( xTCPTimerWheel[ uxLevel ][ ( xExpiryTime >> ( uxLevel * socketTIMER_WHEEL_BITS ) ) & socketTIMER_WHEEL_MASK ] );
+			uxTCPTimerLevelCount[ uxLevel ]++;
 		}
 
-		return xResult;
+		vListInsertEnd( pxList, &( pxSocket->u.xTCP.xTimerListItem ) );
 	}
+	/*-----------------------------------------------------------*/
 
-#endif /* ipconfigUSE_TCP */
-/*-----------------------------------------------------------*/
+	static void prvTCPTimerUnlink( FreeRTOS_Socket_t *pxSocket )
+	{
+	List_t *pxList = ( List_t * ) listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xTimerListItem ) );
+	UBaseType_t uxLevel;
 
-#if( ipconfigUSE_TCP == 1 )
+		if( pxList != NULL )
+		{
+			if( pxList != &xTCPTimerDueList )
+			{
+				/* Find out which level of the wheel contains the socket. */
+				uxLevel = ( UBaseType_t ) ( pxList - &( xTCPTimerWheel[ 0 ][ 0 ] ) ) / socketTIMER_WHEEL_SLOTS;
+				uxTCPTimerLevelCount[ uxLevel ]--;
+			}
+			( void ) uxListRemove( &( pxSocket->u.xTCP.xTimerListItem ) );
+		}
+	}
+	/*-----------------------------------------------------------*/
 
-	/* Get a direct pointer to the circular transmit buffer.
-	'*pxLength' will contain the number of bytes that may be written. */
-	uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength )
+	static void prvTCPTimerCascade( void )
 	{
-    uint8_t *pucReturn = NULL;
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-	StreamBuffer_t *pxBuffer = NULL;
+	UBaseType_t uxLevel, uxIndex, uxCount;
+	List_t *pxList;
+	FreeRTOS_Socket_t *pxSocket;
 
-        *pxLength = 0;
+		/* Called when the lowest level of the wheel starts a new round: move
+		the sockets of the next slot of the higher level(s) down. */
+		for( uxLevel = 1u; uxLevel < socketTIMER_WHEEL_LEVELS; uxLevel++ )
+		{
+			uxIndex = ( UBaseType_t ) ( xTCPTimerWheelTime >> ( uxLevel * socketTIMER_WHEEL_BITS ) ) & socketTIMER_WHEEL_MASK;
+			pxList = &( xTCPTimerWheel[ uxLevel ][ uxIndex ] );
 
-        /* Confirm that this is a TCP socket before dereferencing structure
-        member pointers. */
-        if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
-        {
-            pxBuffer = pxSocket->u.xTCP.txStream;
-            if( pxBuffer != NULL )
-            {
-            BaseType_t xSpace = ( BaseType_t )uxStreamBufferGetSpace( pxBuffer );
-            BaseType_t xRemain = ( BaseType_t )( pxBuffer->LENGTH - pxBuffer->uxHead );
+			for( uxCount = listCURRENT_LIST_LENGTH( pxList ); uxCount > 0u; uxCount-- )
+			{
+				pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxList );
+				prvTCPTimerUnlink( pxSocket );
+				prvTCPTimerInsert( pxSocket, listGET_LIST_ITEM_VALUE( &( pxSocket->u.xTCP.xTimerListItem ) ) );
+			}
 
-                *pxLength = FreeRTOS_min_BaseType( xSpace, xRemain );
-                pucReturn = pxBuffer->ucArray + pxBuffer->uxHead;
-            }
+			if( uxIndex != 0u )
+			{
+				/* The next level doesn't start a new round yet. */
+				break;
+			}
 		}
-
-		return pucReturn;
 	}
-#endif /* ipconfigUSE_TCP */
-/*-----------------------------------------------------------*/
+	/*-----------------------------------------------------------*/
 
-#if( ipconfigUSE_TCP == 1 )
-	/*
-	 * Send data using a TCP socket.  It is not necessary to have the socket
-	 * connected already.  Outgoing data will be stored and delivered as soon as
-	 * the socket gets connected.
-	 */
-	BaseType_t FreeRTOS_send( Socket_t xSocket, const void *pvBuffer, size_t uxDataLength, BaseType_t xFlags )
+	static UBaseType_t prvTCPTimerCount( void )
 	{
-	BaseType_t xByteCount;
-	BaseType_t xBytesLeft;
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-	TickType_t xRemainingTime;
-	BaseType_t xTimed = pdFALSE;
-	TimeOut_t xTimeOut;
-	BaseType_t xCloseAfterSend;
+	UBaseType_t uxLevel, uxCount = 0u;
+
+		for( uxLevel = 0u; uxLevel < socketTIMER_WHEEL_LEVELS; uxLevel++ )
+		{
+			uxCount += uxTCPTimerLevelCount[ uxLevel ];
+		}
 
-		/* Prevent compiler warnings about unused parameters.  The parameter
-		may be used in future versions. */
-		( void ) xFlags;
+		return uxCount;
+	}
+	/*-----------------------------------------------------------*/
 
-		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
+	static void prvTCPTimerAttend( List_t *pxList )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	UBaseType_t uxCount;
 
-		if( xByteCount > 0 )
+		/* Only visit the sockets that are in the list now.  Note that closing a
+		socket may also close other sockets in the same list. */
+		for( uxCount = listCURRENT_LIST_LENGTH( pxList ); uxCount > 0u; uxCount-- )
 		{
-			/* xBytesLeft is number of bytes to send, will count to zero. */
-			xBytesLeft = ( BaseType_t ) uxDataLength;
+			if( listLIST_IS_EMPTY( pxList ) != pdFALSE )
+			{
+				break;
+			}
 
-			/* xByteCount is number of bytes that can be sent now. */
-			xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxList );
+			prvTCPTimerUnlink( pxSocket );
 
-			/* While there are still bytes to be sent. */
-			while( xBytesLeft > 0 )
+			pxSocket->u.xTCP.usTimeout = 0u;
+
+			/* Within this function, the socket might want to send a delayed
+			ack or send out data or whatever it needs to do. */
+			if( xTCPSocketCheck( pxSocket ) >= 0 )
 			{
-				/* If txStream has space. */
-				if( xByteCount > 0 )
+				/* A time-out that was set by the check counts from the next
+				clock tick, as it does without a timer wheel.  A socket that
+				waits for space in the window asks for a time-out of 1 after
+				every check, and would otherwise keep the IP-task busy within
+				the same clock tick. */
+				prvTCPTimerUnlink( pxSocket );
+
+				if( pxSocket->u.xTCP.usTimeout != 0u )
 				{
-					/* Don't send more than necessary. */
-					if( xByteCount > xBytesLeft )
-					{
-						xByteCount = xBytesLeft;
-					}
+					prvTCPTimerInsert( pxSocket, xTaskGetTickCount() + ( TickType_t ) pxSocket->u.xTCP.usTimeout );
+				}
 
-					/* Is the close-after-send flag set and is this really the
-					last transmission? */
-					if( ( pxSocket->u.xTCP.bits.bCloseAfterSend != pdFALSE_UNSIGNED ) && ( xByteCount == xBytesLeft ) )
-					{
-						xCloseAfterSend = pdTRUE;
-					}
-					else
-					{
-						xCloseAfterSend = pdFALSE;
-					}
+				vTCPTimerEventPending( pxSocket );
+			}
+			else
+			{
+				/* The socket was deleted. */
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
 
-					/* The flag 'bCloseAfterSend' can be set before sending data
-					using setsockopt()
+	static TickType_t prvTCPTimerNextExpiry( TickType_t xNow, TickType_t xShortest )
+	{
+	UBaseType_t uxLevel, uxIndex, uxStep;
+	TickType_t xTime, xBlock, xWait;
 
-					When the last data packet is being sent out, a FIN flag will
-					be included to let the peer know that no more data is to be
-					expected.  The use of 'bCloseAfterSend' is not mandatory, it
-					is just a faster way of transferring files (e.g. when using
-					FTP). */
-					if( xCloseAfterSend != pdFALSE )
-					{
-						/* Now suspend the scheduler: sending the last data	and
-						setting bCloseRequested must be done together */
-						vTaskSuspendAll();
-						pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
-					}
+		/* Look for the first slot that is not empty.  On the higher levels,
+		that is the moment when the slot will be cascaded, which is not later
+		than the earliest time of expiry that it contains. */
+		for( uxLevel = 0u; uxLevel < socketTIMER_WHEEL_LEVELS; uxLevel++ )
+		{
+			xBlock = xTCPTimerWheelTime >> ( uxLevel * socketTIMER_WHEEL_BITS );
 
-					xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, ( const uint8_t * ) pvBuffer, ( size_t ) xByteCount );
+			/* The current slot of a higher level has been cascaded already,
+			unless the wheel is exactly at its start. */
+			if( ( uxLevel == 0u ) || ( ( xBlock << ( uxLevel * socketTIMER_WHEEL_BITS ) ) == xTCPTimerWheelTime ) )
+			{
+				uxStep = 0u;
+			}
+			else
+			{
+				uxStep = 1u;
+			}
 
-					if( xCloseAfterSend != pdFALSE )
-					{
-						/* Now when the IP-task transmits the data, it will also
-						see	that bCloseRequested is true and include the FIN
-						flag to start closure of the connection. */
-						xTaskResumeAll();
-					}
+			for( ; uxStep <= socketTIMER_WHEEL_SLOTS; uxStep++ )
+			{
+				uxIndex = ( UBaseType_t ) ( xBlock + uxStep ) & socketTIMER_WHEEL_MASK;
 
-					/* Send a message to the IP-task so it can work on this
-					socket.  Data is sent, let the IP-task work on it. */
-					pxSocket->u.xTCP.usTimeout = 1u;
+				if( listLIST_IS_EMPTY( &( xTCPTimerWheel[ uxLevel ][ uxIndex ] ) ) == pdFALSE )
+				{
+					xTime = ( xBlock + uxStep ) << ( uxLevel * socketTIMER_WHEEL_BITS );
+					xWait = socketTIME_REACHED( xNow, xTime ) ? ( TickType_t ) 0u : ( TickType_t ) ( xTime - xNow );
 
-					if( xIsCallingFromIPTask() == pdFALSE )
+					if( xShortest > xWait )
 					{
-						/* Only send a TCP timer event when not called from the
-						IP-task. */
-						xSendEventToIPTask( eTCPTimerEvent );
+						xShortest = xWait;
 					}
+					break;
+				}
+			}
+		}
 
-					xBytesLeft -= xByteCount;
+		return xShortest;
+	}
+	/*-----------------------------------------------------------*/
 
-					if( xBytesLeft == 0 )
-					{
-						break;
-					}
+	void vTCPTimerSync( FreeRTOS_Socket_t *pxSocket )
+	{
+	TickType_t xNow, xExpiryTime;
 
-					/* As there are still bytes left to be sent, increase the
-					data pointer. */
-					pvBuffer = ( void * ) ( ( ( const uint8_t * ) pvBuffer) + xByteCount );
-				}
+		if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xTimerListItem ) ) != NULL )
+		{
+			xNow = xTaskGetTickCount();
+			xExpiryTime = listGET_LIST_ITEM_VALUE( &( pxSocket->u.xTCP.xTimerListItem ) );
+			prvTCPTimerUnlink( pxSocket );
 
-				/* Not all bytes have been sent. In case the socket is marked as
-				blocking sleep for a while. */
-				if( xTimed == pdFALSE )
-				{
-					/* Only in the first round, check for non-blocking. */
-					xRemainingTime = pxSocket->xSendBlockTime;
+			/* Give 'usTimeout' the meaning it has without a timer wheel:
+			the number of ticks that remain. */
+			if( socketTIME_REACHED( xNow, xExpiryTime ) )
+			{
+				pxSocket->u.xTCP.usTimeout = 1u;
+			}
+			else
+			{
+				pxSocket->u.xTCP.usTimeout = ( uint16_t ) ( ( xExpiryTime - xNow ) + 1u );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
 
-					#if( ipconfigUSE_CALLBACKS != 0 )
-					{
-						if( xIsCallingFromIPTask() != pdFALSE )
-						{
-							/* If this send function is called from within a
-							call-back handler it may not block, otherwise
-							chances would be big to get a deadlock: the IP-task
-							waiting for	itself. */
-							xRemainingTime = ( TickType_t ) 0;
-						}
-					}
-					#endif /* ipconfigUSE_CALLBACKS */
+	void vTCPTimerUpdate( FreeRTOS_Socket_t *pxSocket )
+	{
+		prvTCPTimerUnlink( pxSocket );
 
-					if( xRemainingTime == ( TickType_t ) 0 )
-					{
-						break;
-					}
+		if( pxSocket->u.xTCP.usTimeout != 0u )
+		{
+			/* A time-out of 1 means: as soon as possible. */
+			prvTCPTimerInsert( pxSocket, xTaskGetTickCount() + ( TickType_t ) pxSocket->u.xTCP.usTimeout - 1u );
+		}
 
-					if( ( xFlags & FREERTOS_MSG_DONTWAIT ) != 0 )
-					{
-						break;
-					}
+		vTCPTimerEventPending( pxSocket );
+	}
+	/*-----------------------------------------------------------*/
 
-					/* Don't get here a second time. */
-					xTimed = pdTRUE;
+	void vTCPTimerEventPending( FreeRTOS_Socket_t *pxSocket )
+	{
+		if( ( pxSocket->xEventBits != 0u ) &&
+			( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xEventListItem ) ) == NULL ) )
+		{
+			/* The owner will be woken up just before the IP-task goes to
+			sleep. */
+			vListInsertEnd( &xTCPEventSocketsList, &( pxSocket->u.xTCP.xEventListItem ) );
+		}
+	}
+	/*-----------------------------------------------------------*/
 
-					/* Fetch the current time. */
-					vTaskSetTimeOutState( &xTimeOut );
-				}
-				else
-				{
-					/* Has the timeout been reached? */
-					if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
-					{
-						break;
-					}
-				}
+	void vTCPTimerKick( FreeRTOS_Socket_t *pxSocket )
+	{
+		vTCPTimerSync( pxSocket );
+		pxSocket->u.xTCP.usTimeout = 1u;
+		vTCPTimerUpdate( pxSocket );
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPTimerRemove( FreeRTOS_Socket_t *pxSocket )
+	{
+		prvTCPTimerUnlink( pxSocket );
 
-				/* Go sleeping until down-stream events are received. */
-				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_SEND | eSOCKET_CLOSED,
-					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+		if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xEventListItem ) ) != NULL )
+		{
+			( void ) uxListRemove( &( pxSocket->u.xTCP.xEventListItem ) );
+		}
 
-				xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+		vTaskSuspendAll();
+		{
+			if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xKickListItem ) ) != NULL )
+			{
+				( void ) uxListRemove( &( pxSocket->u.xTCP.xKickListItem ) );
 			}
+		}
+		( void ) xTaskResumeAll();
+	}
+	/*-----------------------------------------------------------*/
 
-			/* How much was actually sent? */
-			xByteCount = ( ( BaseType_t ) uxDataLength ) - xBytesLeft;
+	BaseType_t xTCPTimerProcessKicks( void )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	BaseType_t xReturn = pdFALSE;
 
-			if( xByteCount == 0 )
+		if( listLIST_IS_EMPTY( &xTCPTimerKickList ) == pdFALSE )
+		{
+			vTaskSuspendAll();
 			{
-				if( pxSocket->u.xTCP.ucTCPState > eESTABLISHED )
-				{
-					xByteCount = ( BaseType_t ) -pdFREERTOS_ERRNO_ENOTCONN;
-				}
-				else
+				while( listLIST_IS_EMPTY( &xTCPTimerKickList ) == pdFALSE )
 				{
-					if( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE )
-					{
-						FreeRTOS_debug_printf( ( "FreeRTOS_send: %u -> %lxip:%d: no space\n",
-							pxSocket->usLocalPort,
-							pxSocket->u.xTCP.ulRemoteIP,
-							pxSocket->u.xTCP.usRemotePort ) );
-					}
+					pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xTCPTimerKickList );
+					( void ) uxListRemove( &( pxSocket->u.xTCP.xKickListItem ) );
 
-					xByteCount = ( BaseType_t ) -pdFREERTOS_ERRNO_ENOSPC;
+					/* Only the lists of the IP-task are touched. */
+					vTCPTimerKick( pxSocket );
 				}
 			}
+			( void ) xTaskResumeAll();
+
+			xReturn = pdTRUE;
 		}
 
-		return xByteCount;
+		return xReturn;
 	}
-
-#endif /* ipconfigUSE_TCP */
-/*-----------------------------------------------------------*/
-
-#if( ipconfigUSE_TCP == 1 )
+	/*-----------------------------------------------------------*/
 
 	/*
-	 * Request to put a socket in listen mode
+	 * A TCP timer has expired, now check the TCP sockets of which the time-out
+	 * has been reached, see the version above.
 	 */
-	BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog )
+	TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
 	{
 	FreeRTOS_Socket_t *pxSocket;
-	BaseType_t xResult = 0;
+	TickType_t xShortest = pdMS_TO_TICKS( ( TickType_t ) ipTCP_TIMER_PERIOD_MS );
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xNextTime;
+	UBaseType_t uxIndex;
 
-		pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+		/* First the sockets that asked for attention. */
+		prvTCPTimerAttend( &xTCPTimerDueList );
 
-		/* listen() is allowed for a valid TCP socket in Closed state and already
-		bound. */
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		/* Turn the wheel until the current time.  Only sockets in a slot of the
+		lowest level can be due. */
+		while( ( prvTCPTimerCount() != 0u ) && socketTIME_REACHED( xNow, xTCPTimerWheelTime ) )
 		{
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+			uxIndex = ( UBaseType_t ) xTCPTimerWheelTime & socketTIMER_WHEEL_MASK;
+
+			if( uxIndex == 0u )
+			{
+				prvTCPTimerCascade();
+			}
+
+			prvTCPTimerAttend( &( xTCPTimerWheel[ 0 ][ uxIndex ] ) );
+			xTCPTimerWheelTime++;
+
+			if( ( uxTCPTimerLevelCount[ 0 ] == 0u ) && ( ( xTCPTimerWheelTime & socketTIMER_WHEEL_MASK ) != 0u ) )
+			{
+				/* The lowest level is empty, skip to the next cascade. */
+				xNextTime = ( xTCPTimerWheelTime | socketTIMER_WHEEL_MASK ) + 1u;
+
+				if( socketTIME_REACHED( xNow, xNextTime ) )
+				{
+					xTCPTimerWheelTime = xNextTime;
+				}
+				else
+				{
+					xTCPTimerWheelTime = xNow + 1u;
+				}
+			}
 		}
-		else if( ( pxSocket->u.xTCP.ucTCPState != eCLOSED ) && ( pxSocket->u.xTCP.ucTCPState != eCLOSE_WAIT ) )
+
+		if( listLIST_IS_EMPTY( &xTCPTimerDueList ) == pdFALSE )
 		{
-			/* Socket is in a wrong state. */
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+			/* Some sockets want attention as soon as possible. */
+			xShortest = ( TickType_t ) 0u;
 		}
-		else
+		else if( prvTCPTimerCount() != 0u )
 		{
-			/* Backlog is interpreted here as "the maximum number of child
-			sockets. */
-			pxSocket->u.xTCP.usBacklog = ( uint16_t )FreeRTOS_min_int32( ( int32_t ) 0xffff, ( int32_t ) xBacklog );
+			xShortest = prvTCPTimerNextExpiry( xNow, xShortest );
+		}
 
-			/* This cleaning is necessary only if a listening socket is being
-			reused as it might have had a previous connection. */
-			if( pxSocket->u.xTCP.bits.bReuseSocket )
+		/* In xEventBits the driver may indicate that the socket has important
+		events for the user.  These are only done just before the IP-task goes
+		to sleep. */
+		if( listLIST_IS_EMPTY( &xTCPEventSocketsList ) == pdFALSE )
+		{
+			if( xWillSleep != pdFALSE )
 			{
-				if( pxSocket->u.xTCP.rxStream != NULL )
+				while( listLIST_IS_EMPTY( &xTCPEventSocketsList ) == pdFALSE )
 				{
-					vStreamBufferClear( pxSocket->u.xTCP.rxStream );
-				}
+					pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xTCPEventSocketsList );
+					( void ) uxListRemove( &( pxSocket->u.xTCP.xEventListItem ) );
 
-				if( pxSocket->u.xTCP.txStream != NULL )
-				{
-					vStreamBufferClear( pxSocket->u.xTCP.txStream );
+					if( pxSocket->xEventBits != 0u )
+					{
+						vSocketWakeUpUser( pxSocket );
+					}
 				}
-
-				memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, '\0', sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
-				memset( &pxSocket->u.xTCP.xTCPWindow, '\0', sizeof( pxSocket->u.xTCP.xTCPWindow ) );
-				memset( &pxSocket->u.xTCP.bits, '\0', sizeof( pxSocket->u.xTCP.bits ) );
-
-				/* Now set the bReuseSocket flag again, because the bits have
-				just been cleared. */
-				pxSocket->u.xTCP.bits.bReuseSocket = pdTRUE_UNSIGNED;
 			}
-
-			vTCPStateChange( pxSocket, eTCP_LISTEN );
+			else
+			{
+				/* Or else make sure this will be called again to wake-up
+				the sockets' owner. */
+				xShortest = ( TickType_t ) 0;
+			}
 		}
 
-		return xResult;
+		return xShortest;
 	}
 
-#endif /* ipconfigUSE_TCP */
+#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP == 1 )
 
-	/* shutdown - shut down part of a full-duplex connection */
-	BaseType_t FreeRTOS_shutdown( Socket_t xSocket, BaseType_t xHow )
+	static BaseType_t prvTCPSendTimerEvent( FreeRTOS_Socket_t *pxSocket )
 	{
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-	BaseType_t xResult;
+	BaseType_t xReturn;
 
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
-		{
-			/*_RB_ Is this comment correct?  The socket is not of a type that
-			supports the listen() operation. */
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
-		}
-		else if ( pxSocket->u.xTCP.ucTCPState != eESTABLISHED )
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
 		{
-			/*_RB_ Is this comment correct?  The socket is not of a type that
-			supports the listen() operation. */
-			xResult = -pdFREERTOS_ERRNO_EOPNOTSUPP;
+			if( xIsCallingFromIPTask() != pdFALSE )
+			{
+				/* The wheel may be accessed directly. */
+				vTCPTimerKick( pxSocket );
+				xReturn = xSendEventToIPTask( eTCPTimerEvent );
+			}
+			else
+			{
+				/* Remember the socket before the IP-task is woken up.  The
+				message may not fit in the queue, but then the IP-task is busy
+				and will find the socket at the start of its next loop. */
+				vTaskSuspendAll();
+				{
+					if( listLIST_ITEM_CONTAINER( &( pxSocket->u.xTCP.xKickListItem ) ) == NULL )
+					{
+						vListInsertEnd( &xTCPTimerKickList, &( pxSocket->u.xTCP.xKickListItem ) );
+					}
+				}
+				( void ) xTaskResumeAll();
+
+				xReturn = xSendEventToIPTask( eTCPTimerEvent );
+			}
 		}
-		else
+		#else
 		{
-			pxSocket->u.xTCP.bits.bUserShutdown = pdTRUE_UNSIGNED;
-
-			/* Let the IP-task perform the shutdown of the connection. */
-			pxSocket->u.xTCP.usTimeout = 1u;
-			xSendEventToIPTask( eTCPTimerEvent );
-			xResult = 0;
+			( void ) pxSocket;
+			xReturn = xSendEventToIPTask( eTCPTimerEvent );
 		}
-		(void) xHow;
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 
-		return xResult;
+		return xReturn;
 	}
 
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
-#if( ipconfigUSE_TCP == 1 )
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
 
-	/*
-	 * A TCP timer has expired, now check all TCP sockets for:
-	 * - Active connect
-	 * - Send a delayed ACK
-	 * - Send new data
-	 * - Send a keep-alive packet
-	 * - Check for timeout (in non-connected states only)
-	 */
-	TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
+	static UBaseType_t prvTCPHashIndex( UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort )
 	{
-	FreeRTOS_Socket_t *pxSocket;
-	TickType_t xShortest = pdMS_TO_TICKS( ( TickType_t ) ipTCP_TIMER_PERIOD_MS );
-	TickType_t xNow = xTaskGetTickCount();
-	static TickType_t xLastTime = 0u;
-	TickType_t xDelta = xNow - xLastTime;
-	ListItem_t* pxEnd = ( ListItem_t * ) listGET_END_MARKER( &xBoundTCPSocketsList );
-	ListItem_t *pxIterator = ( ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+	uint32_t ulHash;
 
-		xLastTime = xNow;
+		/* Fold the three fields into 32 bits and mix them, so that connections
+		which only differ in the remote port still spread over the buckets. */
+		ulHash = ulRemoteIP ^ ( ( ( uint32_t ) uxRemotePort ) << 16 ) ^ ( ( uint32_t ) uxLocalPort );
+		ulHash ^= ulHash >> 16;
+		ulHash *= 0x45d9f3bUL;
+		ulHash ^= ulHash >> 16;
 
-		if( xDelta == 0u )
+		return ( UBaseType_t ) ( ulHash % ( uint32_t ) ipconfigTCP_HASH_TABLE_SIZE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPHashInsert( FreeRTOS_Socket_t *pxSocket )
+	{
+	UBaseType_t uxIndex;
+	List_t *pxBucket;
+	ListItem_t *pxHashItem = &( pxSocket->u.xTCP.xHashListItem );
+
+		if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eTCP_LISTEN )
 		{
-			xDelta = 1u;
+			/* A listening socket accepts packets from any remote address. */
+			uxIndex = prvTCPHashIndex( ( UBaseType_t ) pxSocket->usLocalPort, 0ul, 0u );
 		}
-
-		while( pxIterator != pxEnd )
+		else
 		{
-			pxSocket = ( FreeRTOS_Socket_t * )listGET_LIST_ITEM_OWNER( pxIterator );
-			pxIterator = ( ListItem_t * ) listGET_NEXT( pxIterator );
+			uxIndex = prvTCPHashIndex( ( UBaseType_t ) pxSocket->usLocalPort, pxSocket->u.xTCP.ulRemoteIP, ( UBaseType_t ) pxSocket->u.xTCP.usRemotePort );
+		}
 
-			/* Sockets with 'tmout == 0' do not need any regular attention. */
-			if( pxSocket->u.xTCP.usTimeout == 0u )
-			{
-				continue;
-			}
+		pxBucket = &( xTCPHashTable[ uxIndex ] );
 
-			if( xDelta < ( TickType_t ) pxSocket->u.xTCP.usTimeout )
-			{
-				pxSocket->u.xTCP.usTimeout = ( uint16_t ) ( ( ( TickType_t ) pxSocket->u.xTCP.usTimeout ) - xDelta );
-			}
-			else
+		if( listLIST_ITEM_CONTAINER( pxHashItem ) != pxBucket )
+		{
+			if( listLIST_ITEM_CONTAINER( pxHashItem ) != NULL )
 			{
-			int rc ;
-				pxSocket->u.xTCP.usTimeout = 0u;
-				rc = xTCPSocketCheck( pxSocket );
-
-				/* Within this function, the socket might want to send a delayed
-				ack or send out data or whatever it needs to do. */
-				if( rc < 0 )
-				{
-					/* Continue because the socket was deleted. */
-					continue;
-				}
+				uxListRemove( pxHashItem );
 			}
+			vListInsertEnd( pxBucket, pxHashItem );
+		}
+	}
+	/*-----------------------------------------------------------*/
 
-			/* In xEventBits the driver may indicate that the socket has
-			important events for the user.  These are only done just before the
-			IP-task goes to sleep. */
-			if( pxSocket->xEventBits != 0u )
-			{
-				if( xWillSleep != pdFALSE )
-				{
-					/* The IP-task is about to go to sleep, so messages can be
-					sent to the socket owners. */
-					vSocketWakeUpUser( pxSocket );
-				}
-				else
-				{
-					/* Or else make sure this will be called again to wake-up
-					the sockets' owner. */
-					xShortest = ( TickType_t ) 0;
-				}
-			}
+	static void prvTCPHashRebuild( void )
+	{
+	ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
 
-			if( ( pxSocket->u.xTCP.usTimeout != 0u ) && ( xShortest > ( TickType_t ) pxSocket->u.xTCP.usTimeout ) )
-			{
-				xShortest = ( TickType_t ) pxSocket->u.xTCP.usTimeout;
-			}
+		for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			prvTCPHashInsert( ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator ) );
 		}
+	}
+	/*-----------------------------------------------------------*/
 
-		return xShortest;
+	void vTCPSocketHashUpdate( FreeRTOS_Socket_t *pxSocket )
+	{
+		if( xIsCallingFromIPTask() == pdFALSE )
+		{
+			/* The lookup table belongs to the IP-task.  Let it re-hash the
+			sockets before it looks up the next packet. */
+			xTCPHashRebuild = pdTRUE;
+		}
+		else if( socketSOCKET_IS_BOUND( pxSocket ) != pdFALSE )
+		{
+			prvTCPHashInsert( pxSocket );
+		}
 	}
 
-#endif /* ipconfigUSE_TCP */
+#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigUSE_TCP == 1 )
@@ -2852,34 +4288,94 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	{
 	ListItem_t *pxIterator;
 	FreeRTOS_Socket_t *pxResult = NULL, *pxListenSocket = NULL;
-	MiniListItem_t *pxEnd = ( MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
+	MiniListItem_t *pxEnd;
 
 		/* Parameter not yet supported. */
 		( void ) ulLocalIP;
 
-		for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( ListItem_t * ) pxEnd;
-			 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
+		#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
 		{
-			FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+		List_t *pxBucket;
+
+			if( xTCPHashRebuild != pdFALSE )
+			{
+				xTCPHashRebuild = pdFALSE;
+				prvTCPHashRebuild();
+			}
+
+			/* Look for a match with uxLocalPort, ulRemoteIP AND uxRemotePort
+			in the bucket of the connection. */
+			pxBucket = &( xTCPHashTable[ prvTCPHashIndex( uxLocalPort, ulRemoteIP, uxRemotePort ) ] );
+			pxEnd = ( MiniListItem_t* )listGET_END_MARKER( pxBucket );
+
+			for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( ListItem_t * ) pxEnd;
+				 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				if( ( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort ) &&
+					( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eTCP_LISTEN ) &&
+					( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) &&
+					( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
+				{
+					pxResult = pxSocket;
+					break;
+				}
+			}
 
-			if( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort )
+			if( pxResult == NULL )
 			{
-				if( pxSocket->u.xTCP.ucTCPState == eTCP_LISTEN )
+				/* An exact match was not found, look for a socket listening to
+				uxLocalPort. */
+				pxBucket = &( xTCPHashTable[ prvTCPHashIndex( uxLocalPort, 0ul, 0u ) ] );
+				pxEnd = ( MiniListItem_t* )listGET_END_MARKER( pxBucket );
+
+				for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+					 pxIterator != ( ListItem_t * ) pxEnd;
+					 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
 				{
-					/* If this is a socket listening to uxLocalPort, remember it
-					in case there is no perfect match. */
-					pxListenSocket = pxSocket;
+					FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+					if( ( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort ) &&
+						( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eTCP_LISTEN ) )
+					{
+						pxListenSocket = pxSocket;
+						break;
+					}
 				}
-				else if( ( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) && ( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
+			}
+		}
+		#else
+		{
+			pxEnd = ( MiniListItem_t* )listGET_END_MARKER( &xBoundTCPSocketsList );
+
+			for( pxIterator  = ( ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( ListItem_t * ) pxEnd;
+				 pxIterator  = ( ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				if( pxSocket->usLocalPort == ( uint16_t ) uxLocalPort )
 				{
-					/* For sockets not in listening mode, find a match with
-					xLocalPort, ulRemoteIP AND xRemotePort. */
-					pxResult = pxSocket;
-					break;
+					if( pxSocket->u.xTCP.ucTCPState == eTCP_LISTEN )
+					{
+						/* If this is a socket listening to uxLocalPort, remember it
+						in case there is no perfect match. */
+						pxListenSocket = pxSocket;
+					}
+					else if( ( pxSocket->u.xTCP.usRemotePort == ( uint16_t ) uxRemotePort ) && ( pxSocket->u.xTCP.ulRemoteIP == ulRemoteIP ) )
+					{
+						/* For sockets not in listening mode, find a match with
+						xLocalPort, ulRemoteIP AND xRemotePort. */
+						pxResult = pxSocket;
+						break;
+					}
 				}
 			}
 		}
+		#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
 		if( pxResult == NULL )
 		{
 			/* An exact match was not found, maybe a listening socket was
@@ -2904,7 +4400,19 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
         member pointers. */
         if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
         {
+			socketRX_STREAM_ENTER( pxSocket );
+
             pxReturn = pxSocket->u.xTCP.rxStream;
+
+			#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			{
+				/* The application will read from the stream directly, it can
+				not be replaced any more. */
+				pxSocket->u.xTCP.xAutoTune.ucRxPinned = pdTRUE_UNSIGNED;
+			}
+			#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
+			socketRX_STREAM_LEAVE( pxSocket );
         }
 
         return pxReturn;
@@ -2919,7 +4427,6 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	{
 	StreamBuffer_t *pxBuffer;
 	size_t uxLength;
-	size_t uxSize;
 
 		/* Now that a stream is created, the maximum size is fixed before
 		creation, it could still be changed with setsockopt(). */
@@ -2942,15 +4449,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			uxLength = pxSocket->u.xTCP.uxTxStreamSize;
 		}
 
-		/* Add an extra 4 (or 8) bytes. */
-		uxLength += sizeof( size_t );
-
-		/* And make the length a multiple of sizeof( size_t ). */
-		uxLength &= ~( sizeof( size_t ) - 1u );
-
-		uxSize = sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) + uxLength;
-
-		pxBuffer = ( StreamBuffer_t * )pvPortMallocLarge( uxSize );
+		pxBuffer = prvTCPStreamAllocate( uxLength );
 
 		if( pxBuffer == NULL )
 		{
@@ -2960,13 +4459,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
-			/* Clear the markers of the stream */
-			memset( pxBuffer, '\0', sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) );
-			pxBuffer->LENGTH = ( size_t ) uxLength ;
-
 			if( xTCPWindowLoggingLevel != 0 )
 			{
-				FreeRTOS_debug_printf( ( "prvTCPCreateStream: %cxStream created %lu bytes (total %lu)\n", xIsInputStream ? 'R' : 'T', uxLength, uxSize ) );
+				FreeRTOS_debug_printf( ( "prvTCPCreateStream: %cxStream created %lu bytes (total %lu)\n", xIsInputStream ? 'R' : 'T', pxBuffer->LENGTH,
+					sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) + pxBuffer->LENGTH ) );
 			}
 
 			if( xIsInputStream != 0 )
@@ -2985,6 +4481,402 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	static StreamBuffer_t *prvTCPStreamAllocate( size_t uxLength )
+	{
+	StreamBuffer_t *pxBuffer;
+	size_t uxSize;
+
+		/* Add an extra 4 (or 8) bytes. */
+		uxLength += sizeof( size_t );
+
+		/* And make the length a multiple of sizeof( size_t ). */
+		uxLength &= ~( sizeof( size_t ) - 1u );
+
+		uxSize = sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) + uxLength;
+
+		pxBuffer = ( StreamBuffer_t * )pvPortMallocLarge( uxSize );
+
+		if( pxBuffer != NULL )
+		{
+			/* Clear the markers of the stream */
+			memset( pxBuffer, '\0', sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) );
+			pxBuffer->LENGTH = ( size_t ) uxLength ;
+
+			#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			{
+				vTaskSuspendAll();
+				uxTCPStreamMemory += uxLength;
+				( void ) xTaskResumeAll();
+			}
+			#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+		}
+
+		return pxBuffer;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static void prvTCPStreamFree( StreamBuffer_t *pxBuffer )
+	{
+		#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+		{
+			vTaskSuspendAll();
+			uxTCPStreamMemory -= pxBuffer->LENGTH;
+			( void ) xTaskResumeAll();
+		}
+		#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
+		vPortFreeLarge( pxBuffer );
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+
+	static size_t prvTCPAutoTuneTarget( size_t uxCurrent, size_t uxBase, size_t uxLimit, uint32_t ulBytesPerRTT, size_t uxMSS )
+	{
+	size_t uxTarget = uxCurrent;
+	size_t uxWanted, uxAvailable;
+
+		if( uxTCPStreamMemory > ( size_t ) ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET )
+		{
+			/* Memory pressure: give back half of the stream, but never go below
+			the size that it was created with. */
+			if( uxCurrent > uxBase )
+			{
+				uxTarget = FreeRTOS_max_uint32( uxBase, FreeRTOS_round_up( uxCurrent / 2u, uxMSS ) );
+			}
+		}
+		else
+		{
+			/* The window is half the size of the stream.  When more than half
+			of the window was used during an RTT, the window may be the
+			bottleneck: aim at a window of twice the bytes per RTT, but don't
+			grow more than a factor 2 at a time. */
+			ulBytesPerRTT = FreeRTOS_min_uint32( ulBytesPerRTT, uxLimit );
+			uxWanted = FreeRTOS_round_up( 4u * ulBytesPerRTT, uxMSS );
+			uxWanted = FreeRTOS_min_uint32( uxWanted, 2u * uxCurrent );
+			uxWanted = FreeRTOS_min_uint32( uxWanted, uxLimit );
+
+			if( uxWanted > uxCurrent )
+			{
+				/* Grow in multiples of the MSS, within the memory budget. */
+				uxAvailable = ( size_t ) ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET - uxTCPStreamMemory;
+				uxTarget = uxCurrent + ( ( FreeRTOS_min_uint32( uxWanted - uxCurrent, uxAvailable ) / uxMSS ) * uxMSS );
+			}
+		}
+
+		return uxTarget;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPStreamCopy( const StreamBuffer_t *pxOld, StreamBuffer_t *pxNew, size_t uxCount )
+	{
+	size_t uxTail = pxOld->uxTail;
+	size_t uxFirst;
+	BaseType_t xResult = pdFALSE;
+
+		/* One byte of a stream always remains unused. */
+		if( uxCount < pxNew->LENGTH )
+		{
+			/* The data may wrap around the end of the old stream. */
+			uxFirst = FreeRTOS_min_uint32( uxCount, pxOld->LENGTH - uxTail );
+			memcpy( pxNew->ucArray, pxOld->ucArray + uxTail, uxFirst );
+			memcpy( pxNew->ucArray + uxFirst, pxOld->ucArray, uxCount - uxFirst );
+
+			/* The tail of the new stream is at 0.  Only a TX stream uses
+			uxMid, which never passes uxHead. */
+			pxNew->uxTail = 0u;
+			pxNew->uxHead = uxStreamBufferDistance( pxOld, uxTail, pxOld->uxHead );
+			pxNew->uxMid = FreeRTOS_min_uint32( uxStreamBufferDistance( pxOld, uxTail, pxOld->uxMid ), pxNew->uxHead );
+			pxNew->uxFront = FreeRTOS_min_uint32( uxStreamBufferDistance( pxOld, uxTail, pxOld->uxFront ), uxCount );
+			xResult = pdTRUE;
+		}
+
+		return xResult;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPResizeRxStream( FreeRTOS_Socket_t *pxSocket, size_t uxNewSize )
+	{
+	StreamBuffer_t *pxOld = pxSocket->u.xTCP.rxStream;
+	StreamBuffer_t *pxNew;
+	size_t uxOldSize = pxSocket->u.xTCP.uxRxStreamSize;
+	size_t uxMSS = ( size_t ) pxSocket->u.xTCP.usCurMSS;
+	size_t uxCount, uxHead, uxTail;
+	BaseType_t xReplaced = pdFALSE;
+
+		if( pxOld == NULL )
+		{
+			/* The stream has not been created yet, it will get the new size. */
+			xReplaced = pdTRUE;
+		}
+		else
+		{
+			/* Out-of-order data is stored beyond uxHead, and uxFront does not
+			cover it completely.  When the window holds such data, copy the
+			complete old stream, which is only possible when it grows. */
+			if( listLIST_IS_EMPTY( &( pxSocket->u.xTCP.xTCPWindow.xRxSegments ) ) != pdFALSE )
+			{
+				uxCount = 0u;
+			}
+			else
+			{
+				uxCount = pxOld->LENGTH - 1u;
+			}
+
+			/* The owner may not be accessing the stream.  It may also hold
+			zero-copy pointers to the data that it hasn't consumed yet, so
+			only out-of-order data may be present. */
+			uxHead = pxOld->uxHead;
+			uxTail = pxOld->uxTail;
+
+			if( ( pxSocket->u.xTCP.xAutoTune.ucRxBusy == 0u ) &&
+				( pxSocket->u.xTCP.xAutoTune.ucRxPinned == pdFALSE_UNSIGNED ) &&
+				( uxHead == uxTail ) )
+			{
+				pxNew = prvTCPStreamAllocate( uxNewSize );
+
+				if( pxNew != NULL )
+				{
+					/* Copy the data while the scheduler is running.  Only the
+					IP-task adds data, the owner can only have read from the
+					stream in the mean time, which would change uxTail.  The
+					pointer is swapped when that didn't happen, and the owner
+					is not accessing the stream now. */
+					if( prvTCPStreamCopy( pxOld, pxNew, uxCount ) != pdFALSE )
+					{
+						vTaskSuspendAll();
+						{
+							if( ( pxSocket->u.xTCP.xAutoTune.ucRxBusy == 0u ) &&
+								( pxOld->uxHead == uxHead ) &&
+								( pxOld->uxTail == uxTail ) )
+							{
+								pxSocket->u.xTCP.rxStream = pxNew;
+								xReplaced = pdTRUE;
+							}
+						}
+						( void ) xTaskResumeAll();
+					}
+
+					/* Free the stream that is not in use. */
+					prvTCPStreamFree( ( xReplaced != pdFALSE ) ? pxOld : pxNew );
+				}
+			}
+		}
+
+		if( xReplaced != pdFALSE )
+		{
+			pxSocket->u.xTCP.uxRxStreamSize = uxNewSize;
+
+			/* Keep the low- and high-water marks at the same percentage. */
+			pxSocket->u.xTCP.uxLittleSpace = ( ( ( pxSocket->u.xTCP.uxLittleSpace * sock100_PERCENT ) / uxOldSize ) * uxNewSize ) / sock100_PERCENT;
+			pxSocket->u.xTCP.uxEnoughSpace = ( ( ( pxSocket->u.xTCP.uxEnoughSpace * sock100_PERCENT ) / uxOldSize ) * uxNewSize ) / sock100_PERCENT;
+
+			/* Use half of the stream for the reception window, like
+			FreeRTOS_socket() does. */
+			pxSocket->u.xTCP.uxRxWinSize = FreeRTOS_max_uint32( 1UL, ( uint32_t ) ( uxNewSize / 2u ) / uxMSS );
+			pxSocket->u.xTCP.xTCPWindow.xSize.ulRxWindowLength = ( uint32_t ) ( pxSocket->u.xTCP.uxRxWinSize * uxMSS );
+
+			if( uxNewSize > uxOldSize )
+			{
+				/* Let the peer know about the larger window. */
+				pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
+			}
+
+			if( xTCPWindowLoggingLevel != 0 )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPResizeRxStream: %u: %lu -> %lu bytes (total %lu)\n",
+					pxSocket->usLocalPort, uxOldSize, uxNewSize, uxTCPStreamMemory ) );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPResizeTxStream( FreeRTOS_Socket_t *pxSocket, size_t uxNewSize )
+	{
+	StreamBuffer_t *pxOld = pxSocket->u.xTCP.txStream;
+	StreamBuffer_t *pxNew;
+	size_t uxOldSize = pxSocket->u.xTCP.uxTxStreamSize;
+	size_t uxMSS = ( size_t ) pxSocket->u.xTCP.usCurMSS;
+	uint32_t ulWindow;
+	size_t uxHead, uxFront;
+	BaseType_t xReplaced = pdFALSE;
+	#if( ipconfigTCP_TX_REFERENCES != 0 )
+		UBaseType_t uxIndex;
+		TCPTxReference_t *pxReference;
+		size_t uxPosition;
+	#endif
+
+		if( pxOld == NULL )
+		{
+			/* The stream has not been created yet, it will get the new size. */
+			xReplaced = pdTRUE;
+		}
+		else
+		{
+			/* The TX stream can be moved along with its contents, as long as
+			the owner is not adding data to it, and it does not hold a pointer
+			into it.  Only the IP-task uses the positions within the stream,
+			and they are translated here. */
+			uxHead = pxOld->uxHead;
+			uxFront = pxOld->uxFront;
+
+			if( ( pxSocket->u.xTCP.xAutoTune.ucTxBusy == 0u ) &&
+				( pxSocket->u.xTCP.xAutoTune.ucTxPinned == pdFALSE_UNSIGNED ) )
+			{
+				pxNew = prvTCPStreamAllocate( uxNewSize );
+
+				if( pxNew != NULL )
+				{
+					/* Copy the data while the scheduler is running.  The owner
+					only writes beyond uxHead, and it moves uxHead and uxFront
+					when it adds data.  The pointer is swapped when they did
+					not change, and the owner is not accessing the stream
+					now. */
+					if( prvTCPStreamCopy( pxOld, pxNew, uxStreamBufferDistance( pxOld, pxOld->uxTail, uxFront ) ) != pdFALSE )
+					{
+						vTaskSuspendAll();
+						{
+							if( ( pxSocket->u.xTCP.xAutoTune.ucTxBusy == 0u ) &&
+								( pxSocket->u.xTCP.xAutoTune.ucTxPinned == pdFALSE_UNSIGNED ) &&
+								( pxOld->uxHead == uxHead ) &&
+								( pxOld->uxFront == uxFront ) )
+							{
+								vTCPWindowTxRebase( &( pxSocket->u.xTCP.xTCPWindow ), ( int32_t ) pxOld->uxTail, ( int32_t ) pxOld->LENGTH );
+
+								#if( ipconfigTCP_TX_REFERENCES != 0 )
+								{
+									for( uxIndex = pxSocket->u.xTCP.uxTxRefTail; uxIndex != pxSocket->u.xTCP.uxTxRefHead; )
+									{
+										/* Translate the position of the first byte that
+										has not been acknowledged yet. */
+										pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxIndex ] );
+										uxPosition = pxReference->uxStart + pxReference->uxAcked;
+
+										if( uxPosition >= pxOld->LENGTH )
+										{
+											uxPosition -= pxOld->LENGTH;
+										}
+
+										uxPosition = uxStreamBufferDistance( pxOld, pxOld->uxTail, uxPosition );
+
+										if( uxPosition < pxReference->uxAcked )
+										{
+											uxPosition += pxNew->LENGTH;
+										}
+
+										pxReference->uxStart = uxPosition - pxReference->uxAcked;
+
+										uxIndex++;
+										if( uxIndex >= ipTCP_TX_REFERENCE_SLOTS )
+										{
+											uxIndex = 0u;
+										}
+									}
+								}
+								#endif /* ipconfigTCP_TX_REFERENCES */
+
+								pxSocket->u.xTCP.txStream = pxNew;
+								xReplaced = pdTRUE;
+							}
+						}
+						( void ) xTaskResumeAll();
+					}
+
+					/* Free the stream that is not in use. */
+					prvTCPStreamFree( ( xReplaced != pdFALSE ) ? pxOld : pxNew );
+				}
+			}
+		}
+
+		if( xReplaced != pdFALSE )
+		{
+			pxSocket->u.xTCP.uxTxStreamSize = uxNewSize;
+			pxSocket->u.xTCP.uxTxWinSize = FreeRTOS_max_uint32( 1UL, ( uint32_t ) ( uxNewSize / 2u ) / uxMSS );
+			ulWindow = ( uint32_t ) ( pxSocket->u.xTCP.uxTxWinSize * uxMSS );
+
+			/* The transmission window may have been reduced after time-outs,
+			don't let a smaller stream enlarge it. */
+			if( ( uxNewSize > uxOldSize ) || ( ulWindow < pxSocket->u.xTCP.xTCPWindow.xSize.ulTxWindowLength ) )
+			{
+				pxSocket->u.xTCP.xTCPWindow.xSize.ulTxWindowLength = ulWindow;
+			}
+
+			if( xTCPWindowLoggingLevel != 0 )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPResizeTxStream: %u: %lu -> %lu bytes (total %lu)\n",
+					pxSocket->usLocalPort, uxOldSize, uxNewSize, uxTCPStreamMemory ) );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPAutoTuneStreams( FreeRTOS_Socket_t *pxSocket )
+	{
+	TCPAutoTune_t *pxTune = &( pxSocket->u.xTCP.xAutoTune );
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xPeriod;
+	uint32_t ulPeriods;
+	size_t uxMSS = ( size_t ) pxSocket->u.xTCP.usCurMSS;
+	size_t uxLimit, uxSize;
+
+		/* The traffic is measured over a period of at least one smoothed RTT. */
+		xPeriod = ( TickType_t ) ( FreeRTOS_max_uint32( ( uint32_t ) pxSocket->u.xTCP.xTCPWindow.lSRTT, socketAUTO_TUNE_MIN_PERIOD_MS ) / portTICK_PERIOD_MS );
+
+		if( xPeriod == ( TickType_t ) 0u )
+		{
+			xPeriod = ( TickType_t ) 1u;
+		}
+
+		ulPeriods = ( uint32_t ) ( ( xNow - pxTune->xPeriodStart ) / xPeriod );
+
+		if( ulPeriods != 0u )
+		{
+			if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eESTABLISHED )
+			{
+				if( pxTune->ucRxFixed == pdFALSE_UNSIGNED )
+				{
+					/* Don't make the stream larger than twice the window that
+					can be advertised. */
+					uxLimit = FreeRTOS_min_uint32( ipconfigTCP_AUTO_TUNE_MAX_LENGTH, 2UL * ( 0xfffcUL << pxSocket->u.xTCP.ucMyWinScaleFactor ) );
+					uxSize = prvTCPAutoTuneTarget( pxSocket->u.xTCP.uxRxStreamSize, pxTune->uxRxBaseSize, uxLimit, pxTune->ulRxBytes / ulPeriods, uxMSS );
+
+					if( uxSize != pxSocket->u.xTCP.uxRxStreamSize )
+					{
+						prvTCPResizeRxStream( pxSocket, uxSize );
+					}
+				}
+
+				if( pxTune->ucTxFixed == pdFALSE_UNSIGNED )
+				{
+					/* The peer can not accept more than its maximum window. */
+					uxLimit = FreeRTOS_min_uint32( ipconfigTCP_AUTO_TUNE_MAX_LENGTH, 2UL * ( 0xffffUL << pxSocket->u.xTCP.ucPeerWinScaleFactor ) );
+					uxSize = prvTCPAutoTuneTarget( pxSocket->u.xTCP.uxTxStreamSize, pxTune->uxTxBaseSize, uxLimit, pxTune->ulTxBytes / ulPeriods, uxMSS );
+
+					if( uxSize != pxSocket->u.xTCP.uxTxStreamSize )
+					{
+						prvTCPResizeTxStream( pxSocket, uxSize );
+					}
+				}
+			}
+
+			/* Start a new period. */
+			pxTune->xPeriodStart = xNow;
+			pxTune->ulRxBytes = 0u;
+			pxTune->ulTxBytes = 0u;
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 ) */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3047,6 +4939,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		if( uxOffset == 0u )
 		{
 			/* Data is being added to rxStream at the head (offs = 0) */
+			#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			{
+				pxSocket->u.xTCP.xAutoTune.ulRxBytes += ( uint32_t ) xResult;
+			}
+			#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 			#if( ipconfigUSE_CALLBACKS == 1 )
 				if( bHasHandler != pdFALSE )
 				{
@@ -3089,7 +4987,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 						/* bLowWater was reached, send the changed window size. */
 						pxSocket->u.xTCP.usTimeout = 1u;
-						xSendEventToIPTask( eTCPTimerEvent );
+						prvTCPSendTimerEvent( pxSocket );
 					}
 				}
 
@@ -3170,13 +5068,20 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				xResult = 0;
 			}
 		}
-		else if( pxSocket->u.xTCP.txStream == NULL )
-		{
-			xResult = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
-		}
 		else
 		{
-			xResult = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			socketTX_STREAM_ENTER( pxSocket );
+
+			if( pxSocket->u.xTCP.txStream == NULL )
+			{
+				xResult = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
+			}
+			else
+			{
+				xResult = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			}
+
+			socketTX_STREAM_LEAVE( pxSocket );
 		}
 
 		return xResult;
@@ -3198,6 +5103,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			socketTX_STREAM_ENTER( pxSocket );
+
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
 				xReturn = ( BaseType_t ) uxStreamBufferGetSpace ( pxSocket->u.xTCP.txStream );
@@ -3206,6 +5113,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				xReturn = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
 			}
+
+			socketTX_STREAM_LEAVE( pxSocket );
 		}
 
 		return xReturn;
@@ -3227,6 +5136,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			socketTX_STREAM_ENTER( pxSocket );
+
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
 				xReturn = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.txStream );
@@ -3235,6 +5146,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				xReturn = 0;
 			}
+
+			socketTX_STREAM_LEAVE( pxSocket );
 		}
 
 		return xReturn;
@@ -3298,6 +5211,37 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+
+	BaseType_t FreeRTOS_GetTCPCongestionStats( Socket_t xSocket, TCPCongestionStats_t *pxStats )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	const TCPCongestion_t *pxCongestion;
+	BaseType_t xReturn;
+
+		if( ( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP ) || ( pxStats == NULL ) )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			/* The values are updated by the IP-task, they are read here
+			without locking, as a snapshot. */
+			pxCongestion = &( pxSocket->u.xTCP.xTCPWindow.xCongestion );
+			pxStats->ulCongestionWindow = pxCongestion->ulCongestionWindow;
+			pxStats->ulSlowStartThreshold = pxCongestion->ulSlowStartThreshold;
+			pxStats->ulMaxCongestionWindow = pxCongestion->ulMaxCongestionWindow;
+			pxStats->ulFastRecoveryCount = pxCongestion->ulFastRecoveryCount;
+			pxStats->ulTimeoutCount = pxCongestion->ulTimeoutCount;
+			xReturn = 0;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP == 1 && ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/* HT: for internal use only: return the connection status */
@@ -3336,13 +5280,20 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		{
 			xReturn = -pdFREERTOS_ERRNO_EINVAL;
 		}
-		else if( pxSocket->u.xTCP.rxStream != NULL )
-		{
-			xReturn = ( BaseType_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream );
-		}
 		else
 		{
-			xReturn = 0;
+			socketRX_STREAM_ENTER( pxSocket );
+
+			if( pxSocket->u.xTCP.rxStream != NULL )
+			{
+				xReturn = ( BaseType_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream );
+			}
+			else
+			{
+				xReturn = 0;
+			}
+
+			socketRX_STREAM_LEAVE( pxSocket );
 		}
 
 		return xReturn;
@@ -3420,6 +5371,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					ucChildText ) );
 					/* Remove compiler warnings if FreeRTOS_debug_printf() is not defined. */
 					( void ) pxHandleReceive;
+				#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+				{
+					/* The current sizes of the streams, which may have been
+					tuned, and the number of bytes stored in them. */
+					FreeRTOS_printf( ( "          Stream RX %lu/%lu TX %lu/%lu%s\n",
+						pxSocket->u.xTCP.rxStream != NULL ? uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) : 0ul,
+						pxSocket->u.xTCP.uxRxStreamSize,
+						pxSocket->u.xTCP.txStream != NULL ? uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ) : 0ul,
+						pxSocket->u.xTCP.uxTxStreamSize,
+						( pxSocket->u.xTCP.xAutoTune.ucRxFixed || pxSocket->u.xTCP.xAutoTune.ucTxFixed ) ? " fixed" : "" ) );
+				}
+				#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
 				count++;
 			}
 
@@ -3438,6 +5401,34 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				uxGetMinimumFreeNetworkBuffers( ),
 				uxGetNumberOfFreeNetworkBuffers( ),
 				ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ) );
+
+			#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			{
+				FreeRTOS_printf( ( "FreeRTOS_netstat: TCP streams use %lu of %lu bytes\n",
+					uxTCPStreamMemory,
+					( size_t ) ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET ) );
+			}
+			#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
+			#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+			{
+			TCPListenStatistics_t xStatistics;
+
+				FreeRTOS_GetTCPListenStatistics( &xStatistics );
+				FreeRTOS_printf( ( "FreeRTOS_netstat: SYN %lu (rep %lu drop %lu evict %lu) cookies %lu/%lu bad ACK %lu full %lu/%lu fail %lu conn %lu\n",
+					xStatistics.ulSynReceived,
+					xStatistics.ulSynRepeated,
+					xStatistics.ulSynDropped,
+					xStatistics.ulSynEvictions,
+					xStatistics.ulCookiesAccepted,
+					xStatistics.ulCookiesSent,
+					xStatistics.ulBadAcks,
+					xStatistics.ulBacklogFull,
+					xStatistics.ulAcceptQueueFull,
+					xStatistics.ulChildFailed,
+					xStatistics.ulConnections ) );
+			}
+			#endif /* ipconfigTCP_SYN_CACHE_SIZE */
 		}
 	}
 
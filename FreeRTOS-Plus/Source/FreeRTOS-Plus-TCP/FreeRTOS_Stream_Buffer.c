@@ -196,4 +196,73 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 
 	return uxCount;
 }
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+
+	/*
+	 * uxStreamBufferGetChecksum( )
+	 * Peek at the data located at 'uxOffset' from 'uxTail' and copy it to
+	 * 'pucData', while calculating its checksum.  'uxTail' is not advanced.
+	 */
+	size_t uxStreamBufferGetChecksum( StreamBuffer_t *pxBuffer, size_t uxOffset, uint8_t *pucData, size_t uxMaxCount, uint16_t *pusChecksum )
+	{
+	size_t uxSize, uxCount, uxFirst, uxNextTail;
+	uint32_t ulSum = 0UL;
+
+		/* How much data is available? */
+		uxSize = uxStreamBufferGetSize( pxBuffer );
+
+		if( uxSize > uxOffset )
+		{
+			uxSize -= uxOffset;
+		}
+		else
+		{
+			uxSize = 0u;
+		}
+
+		/* Use the minimum of the wanted bytes and the available bytes. */
+		uxCount = FreeRTOS_min_uint32( uxSize, uxMaxCount );
+
+		if( uxCount > 0u )
+		{
+			uxNextTail = pxBuffer->uxTail + uxOffset;
+
+			if( uxNextTail >= pxBuffer->LENGTH )
+			{
+				uxNextTail -= pxBuffer->LENGTH;
+			}
+
+			/* The data may wrap around to the start of the buffer, in which
+			case it is copied in two parts. */
+			uxFirst = FreeRTOS_min_uint32( pxBuffer->LENGTH - uxNextTail, uxCount );
+			ulSum = ( uint32_t ) usGenerateChecksumCopy( 0UL, pucData, pxBuffer->ucArray + uxNextTail, uxFirst );
+
+			if( uxCount > uxFirst )
+			{
+			uint32_t ulSecond;
+
+				ulSecond = ( uint32_t ) usGenerateChecksumCopy( 0UL, pucData + uxFirst, pxBuffer->ucArray, uxCount - uxFirst );
+
+				/* Each checksum is relative to its own first byte.  When the
+				second part starts at an odd position in 'pucData', its bytes
+				must be swapped before the two can be added. */
+				if( ( uxFirst & 1u ) != 0u )
+				{
+					ulSecond = ( ( ulSecond & 0xffUL ) << 8 ) | ( ( ulSecond & 0xff00UL ) >> 8 );
+				}
+
+				ulSum += ulSecond;
+				ulSum = ( ulSum & 0xffffUL ) + ( ulSum >> 16 );
+			}
+		}
+
+		*pusChecksum = ( uint16_t ) ulSum;
+
+		return uxCount;
+	}
+
+#endif /* ipconfigUSE_CHECKSUM_COPY */
+/*-----------------------------------------------------------*/
 
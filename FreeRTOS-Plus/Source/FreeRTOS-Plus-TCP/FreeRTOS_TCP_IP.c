@@ -100,6 +100,15 @@ the defined MTU size can contain at least a complete TCP packet. */
 
 #define TCP_OPT_TIMESTAMP_LEN	10	/* fixed length of the time-stamp option */
 
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	/* The time-stamp option as it is sent: 2 NOP's followed by the 10-byte
+	option, so the 32-bit fields remain aligned. */
+	#define TCP_OPT_TIMESTAMP_SIZE	12u
+
+	/* The clock used for the time-stamps, it ticks in milliseconds. */
+	#define tcpTIME_STAMP_NOW()		( ( uint32_t ) ( xTaskGetTickCount() * portTICK_PERIOD_MS ) )
+#endif
+
 #ifndef ipconfigTCP_ACK_EARLIER_PACKET
 	#define ipconfigTCP_ACK_EARLIER_PACKET		1
 #endif
@@ -161,6 +170,44 @@ the defined MTU size can contain at least a complete TCP packet. */
 	#define	tcpMAXIMUM_TCP_WAKEUP_TIME_MS		20000u
 #endif
 
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	/* A half-open connection of a listening socket: a SYN was received and
+	answered with a SYN+ACK, but the final ACK has not arrived yet.  The child
+	socket will be created when it does. */
+	typedef struct xTCP_SYN_ENTRY
+	{
+		uint32_t ulRemoteIP;			/* IP address of the peer, host-endian. */
+		uint32_t ulPeerSequenceNumber;	/* The initial sequence number of the peer. */
+		uint32_t ulOurSequenceNumber;	/* The initial sequence number sent in the SYN+ACK. */
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+			uint32_t ulTSRecent;		/* The time-stamp that the peer sent along with its SYN. */
+		#endif
+		TickType_t xCreationTime;		/* The time at which the first SYN was received. */
+		uint16_t usLocalPort;			/* Port number of the listening socket, zero when the entry is free. */
+		uint16_t usRemotePort;			/* Port number of the peer, host-endian. */
+		uint16_t usMSS;					/* The MSS that was advertised in the SYN+ACK. */
+		uint8_t ucPeerWinScaleFactor;	/* The window scale factor offered by the peer. */
+		uint8_t ucMyWinScaleFactor;		/* The window scale factor advertised in the SYN+ACK. */
+		uint8_t
+			bWinScaling : 1,			/* Both parties will use window scaling. */
+			bTimeStamps : 1;			/* Both parties will use time-stamps. */
+	} TCPSynEntry_t;
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/* A SYN cookie is the initial sequence number of a SYN+ACK for which
+	nothing is stored.  Its highest 5 bits hold a counter that increases every
+	64 seconds, the next 3 bits hold an index in usSynCookieMSS[], and the
+	lowest 24 bits hold a hash of the connection and the counter.  A cookie is
+	accepted during one to two periods. */
+	#define tcpSYN_COOKIE_PERIOD_MS		( 64000u )
+	#define tcpSYN_COOKIE_COUNT_SHIFT	( 27u )
+	#define tcpSYN_COOKIE_COUNT_MASK	( 0x1fUL )
+	#define tcpSYN_COOKIE_MSS_SHIFT		( 24u )
+	#define tcpSYN_COOKIE_MSS_MASK		( 0x07UL )
+	#define tcpSYN_COOKIE_HASH_MASK		( 0x00ffffffUL )
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*
  * The names of the different TCP states may be useful in logging.
  */
@@ -270,10 +317,32 @@ static TickType_t prvTCPNextTimeout( FreeRTOS_Socket_t *pxSocket );
  */
 static void prvTCPAddTxData( FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigTCP_TX_REFERENCES != 0 )
+	/*
+	 * Return the offset from the tail of the TX stream to the first byte of a
+	 * reference that has not been acknowledged yet.
+	 */
+	static size_t prvTCPTxReferenceOffset( const StreamBuffer_t *pxStream, const TCPTxReference_t *pxReference );
+
+	/*
+	 * 'uxCount' bytes at the tail of the TX stream have been acknowledged.
+	 * Return the application buffers that are now completely acknowledged.
+	 * Must be called before the tail of the stream is advanced.
+	 */
+	static void prvTCPTxReferencesAck( FreeRTOS_Socket_t *pxSocket, size_t uxCount );
+
+	/*
+	 * Copy 'uxCount' bytes, starting 'uxOffset' bytes after the tail of the TX
+	 * stream, taking the data of references from the application buffers.
+	 * Returns pdFALSE without copying anything if no reference is involved.
+	 */
+	static BaseType_t prvTCPTxReferencesGet( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucTarget, size_t uxCount );
+#endif /* ipconfigTCP_TX_REFERENCES */
+
 /*
  *  Called to handle the closure of a TCP connection.
  */
-static BaseType_t prvTCPHandleFin( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+static BaseType_t prvTCPHandleFin( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, UBaseType_t uxOptionsLength );
 
 /*
  * Called from prvTCPHandleState().  Find the TCP payload data and check and
@@ -293,6 +362,22 @@ static BaseType_t prvStoreRxData( FreeRTOS_Socket_t *pxSocket, uint8_t *pucRecvD
  */
 static UBaseType_t prvSetOptions( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
 
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	/*
+	 * Write the NOP, NOP, time-stamp option at 'pucOptions': our own clock as
+	 * TSval, and 'ulTSRecent', the most recent time-stamp of the peer, as TSecr.
+	 */
+	static void prvTCPSetTimeStampOption( uint8_t *pucOptions, uint32_t ulTSRecent );
+
+	/*
+	 * Called for every packet received by a connected socket.  Agree on the use
+	 * of time-stamps while in the SYN phase, update TS.Recent, and check the
+	 * time-stamp against PAWS (RFC 7323).  Returns pdFAIL when the packet is an
+	 * old duplicate that must not be processed.
+	 */
+	static BaseType_t prvTCPCheckTimeStamp( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 /*
  * Called from prvTCPHandleState() as long as the TCP status is eSYN_RECEIVED to
  * eCONNECT_SYN.
@@ -344,6 +429,12 @@ static BaseType_t prvTCPSendReset( NetworkBufferDescriptor_t *pxNetworkBuffer );
  */
 static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket );
 
+/*
+ * Return the MSS that this host will use for a peer, before the MSS option of
+ * the peer is taken into account.
+ */
+static uint16_t prvTCPLocalMSS( uint32_t ulRemoteIP );
+
 /*
  * Return either a newly created socket, or the current socket in a connected
  * state (depends on the 'bReuseSocket' flag).
@@ -356,6 +447,59 @@ static FreeRTOS_Socket_t *prvHandleListen( FreeRTOS_Socket_t *pxSocket, NetworkB
  */
 static BaseType_t prvTCPSocketCopy( FreeRTOS_Socket_t *pxNewSocket, FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	/*
+	 * Called for a SYN that arrives at a listening socket.  The half-open
+	 * connection is stored in the SYN cache, or encoded in a SYN cookie, and
+	 * answered with a SYN+ACK.  No socket is created yet.
+	 */
+	static void prvTCPSynCacheAdd( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber );
+
+	/*
+	 * Called for an ACK that arrives at a listening socket.  When it completes
+	 * a handshake that is found in the SYN cache or that carries a valid SYN
+	 * cookie, a child socket is created and returned in the eSYN_RECEIVED
+	 * state.
+	 */
+	static FreeRTOS_Socket_t *prvHandleListenAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Return the entry of a half-open connection, or NULL if it is not found.
+	 */
+	static TCPSynEntry_t *prvTCPSynCacheFind( uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort );
+
+	/*
+	 * Read the MSS, window scale and time-stamp options of a SYN.
+	 */
+	static void prvTCPSynReadOptions( const NetworkBufferDescriptor_t *pxNetworkBuffer, TCPSynEntry_t *pxEntry );
+
+	/*
+	 * Turn the received SYN into a SYN+ACK for a half-open connection and send
+	 * it.
+	 */
+	static void prvTCPSynCacheReply( const FreeRTOS_Socket_t *pxSocket, const TCPSynEntry_t *pxEntry, NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/*
+	 * Return the hash that a SYN cookie contains.  'ulTopBits' are the
+	 * counter and MSS bits of the cookie.
+	 */
+	static uint32_t prvTCPSynCookieHash( const TCPSynEntry_t *pxEntry, uint32_t ulTopBits );
+
+	/*
+	 * Encode a connection in a SYN cookie, which becomes our initial sequence
+	 * number.  Returns pdFALSE if no secret is available.
+	 */
+	static BaseType_t prvTCPSynCookieCreate( TCPSynEntry_t *pxEntry );
+
+	/*
+	 * Check if 'ulCookie' is a recent SYN cookie for the connection, and if
+	 * so, decode the MSS.
+	 */
+	static BaseType_t prvTCPSynCookieCheck( TCPSynEntry_t *pxEntry, uint32_t ulCookie );
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*
  * prvTCPStatusAgeCheck() will see if the socket has been in a non-connected
  * state for too long.  If so, the socket will be closed, and -1 will be
@@ -373,7 +517,7 @@ static NetworkBufferDescriptor_t *prvTCPBufferResize( FreeRTOS_Socket_t *pxSocke
 #endif
 
 #if( ipconfigUSE_TCP_WIN != 0 )
-	static uint8_t prvWinScaleFactor( FreeRTOS_Socket_t *pxSocket );
+	static uint8_t prvWinScaleFactor( const FreeRTOS_Socket_t *pxSocket, size_t uxMSS );
 #endif
 
 /*
@@ -384,6 +528,24 @@ extern uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
 													uint32_t ulDestinationAddress,
 													uint16_t usDestinationPort );
 
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	/* The half-open connections of all listening sockets.  Only the IP-task
+	has access to it. */
+	static TCPSynEntry_t xTCPSynCache[ ipconfigTCP_SYN_CACHE_SIZE ];
+
+	static TCPListenStatistics_t xTCPListenStatistics;
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/* The MSS values that can be encoded in a SYN cookie. */
+	static const uint16_t usSynCookieMSS[ tcpSYN_COOKIE_MSS_MASK + 1u ] = { 536u, 1024u, 1200u, 1300u, 1360u, 1400u, 1440u, 1460u };
+
+	/* A random secret that makes SYN cookies unpredictable, obtained when the
+	first cookie is made. */
+	static uint32_t ulSynCookieSecret[ 2 ];
+	static BaseType_t xSynCookieSecretValid = pdFALSE;
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*-----------------------------------------------------------*/
 
 /* prvTCPSocketIsActive() returns true if the socket must be checked.
@@ -420,8 +582,20 @@ static BaseType_t prvTCPSocketIsActive( UBaseType_t uxStatus )
 		case eCLOSED:
 		case eTCP_LISTEN:
 		case eCLOSE_WAIT:
-			/* These 3 states may last for ever, up to the owner. */
-			xResult = pdFALSE;
+			/* These 3 states may last for ever, up to the owner.  A child
+			socket that got closed before it was connected, e.g. by a FIN in
+			stead of the last ACK of the handshake, has no owner and can not be
+			accepted anymore.  It would keep its place in the backlog of the
+			listening socket. */
+			if( ( pxSocket->u.xTCP.bits.bPassQueued != pdFALSE_UNSIGNED ) &&
+				( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED ) )
+			{
+				xResult = pdTRUE;
+			}
+			else
+			{
+				xResult = pdFALSE;
+			}
 			break;
 		default:
 			/* All other (non-connected) states will get anti-hanging
@@ -494,6 +668,13 @@ BaseType_t xTCPSocketCheck( FreeRTOS_Socket_t *pxSocket )
 BaseType_t xResult = 0;
 BaseType_t xReady = pdFALSE;
 
+	#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	{
+		/* See if the streams should be resized, before they are used. */
+		vTCPAutoTuneStreams( pxSocket );
+	}
+	#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 	if( ( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) && ( pxSocket->u.xTCP.txStream != NULL ) )
 	{
 		/* The API FreeRTOS_send() might have added data to the TX stream.  Add
@@ -721,6 +902,11 @@ NetworkBufferDescriptor_t xTempBuffer;
 		#endif
 		xTempBuffer.pucEthernetBuffer = pxSocket->u.xTCP.xPacket.u.ucLastPacket;
 		xTempBuffer.xDataLength = sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket );
+		#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+		{
+			xTempBuffer.usPayloadLength = 0u;
+		}
+		#endif
 		xReleaseAfterSend = pdFALSE;
 	}
 
@@ -857,8 +1043,10 @@ NetworkBufferDescriptor_t xTempBuffer;
 				if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( uint8_t ) ipTCP_FLAG_FIN ) != 0u )
 				{
 					/* Suppress FIN in case this packet carries earlier data to be
-					retransmitted. */
-					uint32_t ulDataLen = ( uint32_t ) ( ulLen - ( ipSIZE_OF_TCP_HEADER + ipSIZE_OF_IPv4_HEADER ) );
+					retransmitted.  The TCP header may include options, e.g. a
+					time-stamp. */
+					uint32_t ulTCPHeaderLength = ( uint32_t ) ( ( pxTCPPacket->xTCPHeader.ucTCPOffset & VALID_BITS_IN_TCP_OFFSET_BYTE ) >> 2 );
+					uint32_t ulDataLen = ( uint32_t ) ( ulLen - ( ulTCPHeaderLength + ipSIZE_OF_IPv4_HEADER ) );
 					if( ( pxTCPWindow->ulOurSequenceNumber + ulDataLen ) != pxTCPWindow->tx.ulFINSequenceNumber )
 					{
 						pxTCPPacket->xTCPHeader.ucTCPFlags &= ( ( uint8_t ) ~ipTCP_FLAG_FIN );
@@ -911,7 +1099,19 @@ NetworkBufferDescriptor_t xTempBuffer;
 			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
 
 			/* calculate the TCP checksum for an outgoing packet. */
-			usGenerateProtocolChecksum( (uint8_t*)pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+			#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+			{
+				/* The checksum of the payload may have been calculated while
+				it was copied from the txStream. */
+				usGenerateProtocolChecksumWithPayload( (uint8_t*)pxTCPPacket, pxNetworkBuffer->xDataLength,
+					pxNetworkBuffer->usPayloadChecksum, ( size_t ) pxNetworkBuffer->usPayloadLength );
+				pxNetworkBuffer->usPayloadLength = 0u;
+			}
+			#else
+			{
+				usGenerateProtocolChecksum( (uint8_t*)pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+			}
+			#endif
 
 			/* A calculated checksum of 0 must be inverted as 0 means the checksum
 			is disabled. */
@@ -1119,6 +1319,15 @@ uint32_t ulInitialSequenceNumber = 0;
 		/* Set the values of usInitMSS / usCurMSS for this socket. */
 		prvSocketSetMSS( pxSocket );
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			/* Time-stamps will only be used if the peer includes them in its
+			SYN+ACK.  Until then, there is no time-stamp to echo. */
+			pxSocket->u.xTCP.bits.bTimeStamps = pdFALSE_UNSIGNED;
+			pxSocket->u.xTCP.ulTSRecent = 0ul;
+		}
+		#endif
+
 		/* The initial sequence numbers at our side are known.  Later
 		vTCPWindowInit() will be called to fill in the peer's sequence numbers, but
 		first wait for a SYN+ACK reply. */
@@ -1229,6 +1438,23 @@ static BaseType_t prvSingleStepTCPHeaderOptions( const unsigned char ** const pp
 		( *ppucPtr ) += TCP_OPT_WSOPT_LEN;
 	}
 #endif	/* ipconfigUSE_TCP_WIN */
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	else if( ( *ppucPtr )[ 0 ] == TCP_OPT_TIMESTAMP )
+	{
+		/* Confirm that the option fits in the remaining buffer space. */
+		if( ( xRemainingOptionsBytes < ( UBaseType_t ) TCP_OPT_TIMESTAMP_LEN ) || ( ( *ppucPtr )[ 1 ] != TCP_OPT_TIMESTAMP_LEN ) )
+		{
+			return pdFALSE;
+		}
+
+		/* Only store the values here, prvTCPCheckTimeStamp() will decide
+		what to do with them once all options have been parsed. */
+		( *ppxSocket )->u.xTCP.ulTSValue = ulChar2u32( ( *ppucPtr ) + 2 );
+		( *ppxSocket )->u.xTCP.ulTSEcho = ulChar2u32( ( *ppucPtr ) + 6 );
+		( *ppxSocket )->u.xTCP.bits.bTSReceived = pdTRUE_UNSIGNED;
+		( *ppucPtr ) += TCP_OPT_TIMESTAMP_LEN;
+	}
+#endif	/* ipconfigUSE_TCP_TIMESTAMPS */
 	else if( ( *ppucPtr )[ 0 ] == TCP_OPT_MSS )
 	{
 		/* Confirm that the option fits in the remaining buffer space. */
@@ -1308,6 +1534,10 @@ static BaseType_t prvSingleStepTCPHeaderOptions( const unsigned char ** const pp
 					prvSkipPastRemainingOptions( ppucPtr, ppxSocket, &ucLen );
 				}
 				/* ucLen should be 0 by now. */
+
+				/* Now that all blocks are known, retransmit every hole that
+				is considered lost, in a single pass. */
+				( void ) ulTCPWindowTxSackComplete( &( ( *ppxSocket )->u.xTCP.xTCPWindow ) );
 			}
 		}
 		#endif	/* ipconfigUSE_TCP_WIN == 1 */
@@ -1329,6 +1559,18 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 	 */
 	if( ( ( *ppxSocket )->u.xTCP.txStream  != NULL ) && ( ulCount > 0 ) )
 	{
+		#if( ipconfigTCP_TX_REFERENCES != 0 )
+		{
+			prvTCPTxReferencesAck( *ppxSocket, ( size_t ) ulCount );
+		}
+		#endif
+
+		#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+		{
+			( *ppxSocket )->u.xTCP.xAutoTune.ulTxBytes += ulCount;
+		}
+		#endif
+
 		/* Just advancing the tail index, 'ulCount' bytes have been confirmed. */
 		uxStreamBufferGet( ( *ppxSocket )->u.xTCP.txStream, 0, NULL, ( size_t ) ulCount, pdFALSE );
 		( *ppxSocket )->xEventBits |= eSOCKET_SEND;
@@ -1364,13 +1606,25 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 
 #if( ipconfigUSE_TCP_WIN != 0 )
 
-	static uint8_t prvWinScaleFactor( FreeRTOS_Socket_t *pxSocket )
+	static uint8_t prvWinScaleFactor( const FreeRTOS_Socket_t *pxSocket, size_t uxMSS )
 	{
 	size_t uxWinSize;
 	uint8_t ucFactor;
 
 		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
-		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
+		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * uxMSS;
+
+		#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+		{
+			if( pxSocket->u.xTCP.xAutoTune.ucRxFixed == pdFALSE_UNSIGNED )
+			{
+				/* The scale factor can not be changed later on, make sure that
+				the largest window that auto-tuning may need can be advertised. */
+				uxWinSize = FreeRTOS_max_uint32( uxWinSize, ipconfigTCP_AUTO_TUNE_MAX_LENGTH / 2u );
+			}
+		}
+		#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 		ucFactor = 0u;
 		while( uxWinSize > 0xfffful )
 		{
@@ -1381,7 +1635,7 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 
 		FreeRTOS_debug_printf( ( "prvWinScaleFactor: uxRxWinSize %lu MSS %lu Factor %u\n",
 			pxSocket->u.xTCP.uxRxWinSize,
-			pxSocket->u.xTCP.usInitMSS,
+			uxMSS,
 			ucFactor ) );
 
 		return ucFactor;
@@ -1410,7 +1664,7 @@ UBaseType_t uxOptionsLength;
 
 	#if( ipconfigUSE_TCP_WIN != 0 )
 	{
-		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
+		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket, ( size_t ) pxSocket->u.xTCP.usInitMSS );
 
 		pxTCPHeader->ucOptdata[ 4 ] = TCP_OPT_NOOP;
 		pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( TCP_OPT_WSOPT );
@@ -1436,6 +1690,18 @@ UBaseType_t uxOptionsLength;
 		pxTCPHeader->ucOptdata[ uxOptionsLength + 3 ] = 2;	/* 2: length of this option. */
 		uxOptionsLength += 4u;
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			/* Time-stamps are offered in a SYN, and only confirmed in a
+			SYN+ACK when the peer has offered them. */
+			if( ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) || ( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED ) )
+			{
+				prvTCPSetTimeStampOption( &( pxTCPHeader->ucOptdata[ uxOptionsLength ] ), pxSocket->u.xTCP.ulTSRecent );
+				uxOptionsLength += TCP_OPT_TIMESTAMP_SIZE;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 		return uxOptionsLength; /* bytes, not words. */
 	}
 	#endif	/* ipconfigUSE_TCP_WIN == 0 */
@@ -1536,6 +1802,14 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 						}
 					}
 					#endif
+
+					#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+					{
+						/* The owner of the parent socket will be woken up
+						before the IP-task goes asleep. */
+						vTCPTimerEventPending( xParent );
+					}
+					#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 				}
 
 				/* Don't need to access the parent socket anymore, so the
@@ -1614,6 +1888,13 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 	/* Fill in the new state. */
 	pxSocket->u.xTCP.ucTCPState = ( uint8_t ) eTCPState;
 
+	#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+	{
+		/* The state, and maybe also the remote address, have changed. */
+		vTCPSocketHashUpdate( pxSocket );
+	}
+	#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
 	/* touch the alive timers because moving to another state. */
 	prvTCPTouchSocket( pxSocket );
 
@@ -1687,8 +1968,10 @@ BaseType_t xResize;
 			/* Copy the existing data to the new created buffer. */
 			if( pxNetworkBuffer )
 			{
-				/* Either from the previous buffer... */
-				memcpy( pxReturn->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+				/* Either from the previous buffer, including the TCP options
+				that might have been written in its header already... */
+				memcpy( pxReturn->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer,
+					FreeRTOS_max_uint32( ( uint32_t ) pxNetworkBuffer->xDataLength, ( uint32_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ) ) );
 
 				/* ...and release it. */
 				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
@@ -1745,6 +2028,19 @@ int32_t lStreamPos;
 	lStreamPos = 0;
 	pxTCPPacket->xTCPHeader.ucTCPFlags |= ipTCP_FLAG_ACK;
 
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		/* Once agreed upon, every segment must carry a time-stamp, also the
+		ones sent from a timer or from prvTCPSendRepeated(), which do not set
+		any options themselves. */
+		if( ( uxOptionsLength == 0u ) && ( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED ) )
+		{
+			prvTCPSetTimeStampOption( pxTCPPacket->xTCPHeader.ucOptdata, pxSocket->u.xTCP.ulTSRecent );
+			uxOptionsLength = TCP_OPT_TIMESTAMP_SIZE;
+		}
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 	if( pxSocket->u.xTCP.txStream != NULL )
 	{
 		/* ulTCPWindowTxGet will return the amount of data which may be sent
@@ -1776,7 +2072,36 @@ int32_t lStreamPos;
 
 				/* Here data is copied from the txStream in 'peek' mode.  Only
 				when the packets are acked, the tail marker will be updated. */
-				ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				#if( ipconfigTCP_TX_REFERENCES != 0 )
+				if( prvTCPTxReferencesGet( pxSocket, uxOffset, pucSendData, ( size_t ) lDataLen ) != pdFALSE )
+				{
+					/* (Part of) the data was taken from the buffers of the
+					application. */
+					ulDataGot = ( uint32_t ) lDataLen;
+
+					#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+					{
+						/* The checksum will be calculated over the complete
+						packet, see prvTCPReturnPacket(). */
+						pxNewBuffer->usPayloadLength = 0u;
+					}
+					#endif
+				}
+				else
+				#endif /* ipconfigTCP_TX_REFERENCES */
+				#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+				{
+					/* Calculate the checksum of the payload while copying it,
+					see prvTCPReturnPacket(). */
+					ulDataGot = ( uint32_t ) uxStreamBufferGetChecksum( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen,
+						&( pxNewBuffer->usPayloadChecksum ) );
+					pxNewBuffer->usPayloadLength = ( uint16_t ) ulDataGot;
+				}
+				#else
+				{
+					ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				}
+				#endif
 
 				#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 				{
@@ -1999,6 +2324,155 @@ int32_t lCount, lLength;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_TX_REFERENCES != 0 )
+
+	/* Return the distance between the tail of the TX stream and the first byte
+	of a reference that has not been acknowledged yet. */
+	static size_t prvTCPTxReferenceOffset( const StreamBuffer_t *pxStream, const TCPTxReference_t *pxReference )
+	{
+	size_t uxPosition = pxReference->uxStart + pxReference->uxAcked;
+
+		if( uxPosition >= pxStream->LENGTH )
+		{
+			uxPosition -= pxStream->LENGTH;
+		}
+
+		return uxStreamBufferDistance( pxStream, pxStream->uxTail, uxPosition );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPTxReferencesAck( FreeRTOS_Socket_t *pxSocket, size_t uxCount )
+	{
+	const StreamBuffer_t *pxStream = pxSocket->u.xTCP.txStream;
+	TCPTxReference_t *pxReference;
+	UBaseType_t uxTail = pxSocket->u.xTCP.uxTxRefTail;
+	size_t uxFirst, uxAcked;
+
+		while( uxTail != pxSocket->u.xTCP.uxTxRefHead )
+		{
+			pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxTail ] );
+			uxFirst = prvTCPTxReferenceOffset( pxStream, pxReference );
+
+			if( uxFirst >= uxCount )
+			{
+				/* The acknowledged bytes end before this reference. */
+				break;
+			}
+
+			uxAcked = FreeRTOS_min_uint32( uxCount - uxFirst, pxReference->uxLength - pxReference->uxAcked );
+			pxReference->uxAcked += uxAcked;
+
+			if( pxReference->uxAcked < pxReference->uxLength )
+			{
+				/* Only the first part of this buffer has been acknowledged. */
+				break;
+			}
+
+			/* Release the entry before calling the handler, which might want
+			to send a new buffer. */
+			uxTail++;
+			if( uxTail >= ipTCP_TX_REFERENCE_SLOTS )
+			{
+				uxTail = 0u;
+			}
+			pxSocket->u.xTCP.uxTxRefTail = uxTail;
+
+			if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleTxReference ) )
+			{
+				pxSocket->u.xTCP.pxHandleTxReference( ( Socket_t ) pxSocket, pxReference->pucData, pxReference->uxLength, pdTRUE );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPTxReferencesGet( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucTarget, size_t uxCount )
+	{
+	StreamBuffer_t *pxStream = pxSocket->u.xTCP.txStream;
+	const TCPTxReference_t *pxReference;
+	UBaseType_t uxIndex = pxSocket->u.xTCP.uxTxRefTail;
+	UBaseType_t uxHead = pxSocket->u.xTCP.uxTxRefHead;
+	size_t uxDone = 0u, uxFirst, uxLast, uxCopy;
+	BaseType_t xFound = pdFALSE;
+
+		/* The references are sorted by their position in the stream.  The
+		bytes between them were copied into the stream by FreeRTOS_send(). */
+		while( ( uxIndex != uxHead ) && ( uxDone < uxCount ) )
+		{
+			pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxIndex ] );
+
+			/* The bytes of this reference which have not been acknowledged
+			yet, expressed as offsets from the tail of the stream. */
+			uxFirst = prvTCPTxReferenceOffset( pxStream, pxReference );
+			uxLast = uxFirst + ( pxReference->uxLength - pxReference->uxAcked );
+
+			if( uxFirst >= ( uxOffset + uxCount ) )
+			{
+				/* This reference and the ones after it are not needed. */
+				break;
+			}
+
+			if( uxLast > ( uxOffset + uxDone ) )
+			{
+				if( uxFirst > ( uxOffset + uxDone ) )
+				{
+					/* The bytes in front of the reference come from the stream. */
+					uxCopy = uxFirst - ( uxOffset + uxDone );
+					( void ) uxStreamBufferGet( pxStream, uxOffset + uxDone, pucTarget + uxDone, uxCopy, pdTRUE );
+					uxDone += uxCopy;
+				}
+
+				uxCopy = FreeRTOS_min_uint32( uxLast, uxOffset + uxCount ) - ( uxOffset + uxDone );
+				memcpy( pucTarget + uxDone,
+					pxReference->pucData + pxReference->uxAcked + ( ( uxOffset + uxDone ) - uxFirst ),
+					uxCopy );
+				uxDone += uxCopy;
+				xFound = pdTRUE;
+			}
+
+			uxIndex++;
+			if( uxIndex >= ipTCP_TX_REFERENCE_SLOTS )
+			{
+				uxIndex = 0u;
+			}
+		}
+
+		if( ( xFound != pdFALSE ) && ( uxDone < uxCount ) )
+		{
+			/* The remaining bytes come from the stream. */
+			( void ) uxStreamBufferGet( pxStream, uxOffset + uxDone, pucTarget + uxDone, uxCount - uxDone, pdTRUE );
+		}
+
+		return xFound;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPTxReferencesRelease( FreeRTOS_Socket_t *pxSocket )
+	{
+	const TCPTxReference_t *pxReference;
+	UBaseType_t uxTail = pxSocket->u.xTCP.uxTxRefTail;
+
+		while( uxTail != pxSocket->u.xTCP.uxTxRefHead )
+		{
+			pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxTail ] );
+
+			uxTail++;
+			if( uxTail >= ipTCP_TX_REFERENCE_SLOTS )
+			{
+				uxTail = 0u;
+			}
+			pxSocket->u.xTCP.uxTxRefTail = uxTail;
+
+			if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleTxReference ) )
+			{
+				/* Not all data has been acknowledged by the peer. */
+				pxSocket->u.xTCP.pxHandleTxReference( ( Socket_t ) pxSocket, pxReference->pucData, pxReference->uxLength, pdFALSE );
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_TX_REFERENCES */
+/*-----------------------------------------------------------*/
+
 /*
  * prvTCPHandleFin() will be called to handle socket closure
  * The Closure starts when either a FIN has been received and accepted,
@@ -2006,7 +2480,7 @@ int32_t lCount, lLength;
  * Before being called, it has been checked that both reception and transmission
  * are complete.
  */
-static BaseType_t prvTCPHandleFin( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+static BaseType_t prvTCPHandleFin( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, UBaseType_t uxOptionsLength )
 {
 TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
 TCPHeader_t *pxTCPHeader = &pxTCPPacket->xTCPHeader;
@@ -2076,10 +2550,10 @@ uint32_t ulAckNr = FreeRTOS_ntohl( pxTCPHeader->ulAckNr );
 
 	if( pxTCPHeader->ucTCPFlags != 0u )
 	{
-		xSendLength = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + pxTCPWindow->ucOptionLength );
+		xSendLength = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
 	}
 
-	pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + pxTCPWindow->ucOptionLength ) << 2 );
+	pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 
 	if( xTCPWindowLoggingLevel != 0 )
 	{
@@ -2249,6 +2723,18 @@ TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffe
 TCPHeader_t *pxTCPHeader = &pxTCPPacket->xTCPHeader;
 TCPWindow_t *pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
 UBaseType_t uxOptionsLength = pxTCPWindow->ucOptionLength;
+uint8_t *pucOptions = pxTCPHeader->ucOptdata;
+
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+		{
+			/* The time-stamp goes in front, the other options follow it. */
+			prvTCPSetTimeStampOption( pucOptions, pxSocket->u.xTCP.ulTSRecent );
+			pucOptions += TCP_OPT_TIMESTAMP_SIZE;
+		}
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 
 	#if(	ipconfigUSE_TCP_WIN == 1 )
 		if( uxOptionsLength != 0u )
@@ -2262,7 +2748,7 @@ UBaseType_t uxOptionsLength = pxTCPWindow->ucOptionLength;
 					uxOptionsLength,
 					FreeRTOS_ntohl( pxTCPWindow->ulOptionsData[ 1 ] ) - pxSocket->u.xTCP.xTCPWindow.rx.ulFirstSequenceNumber,
 					FreeRTOS_ntohl( pxTCPWindow->ulOptionsData[ 2 ] ) - pxSocket->u.xTCP.xTCPWindow.rx.ulFirstSequenceNumber ) );
-			memcpy( pxTCPHeader->ucOptdata, pxTCPWindow->ulOptionsData, ( size_t ) uxOptionsLength );
+			memcpy( pucOptions, pxTCPWindow->ulOptionsData, ( size_t ) uxOptionsLength );
 
 			/* The header length divided by 4, goes into the higher nibble,
 			effectively a shift-left 2. */
@@ -2279,14 +2765,24 @@ UBaseType_t uxOptionsLength = pxTCPWindow->ucOptionLength;
 			FreeRTOS_debug_printf( ( "MSS: sending %d\n", pxSocket->u.xTCP.usCurMSS ) );
 		}
 
-		pxTCPHeader->ucOptdata[ 0 ] = TCP_OPT_MSS;
-		pxTCPHeader->ucOptdata[ 1 ] = TCP_OPT_MSS_LEN;
-		pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( ( pxSocket->u.xTCP.usCurMSS ) >> 8 );
-		pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( ( pxSocket->u.xTCP.usCurMSS ) & 0xffu );
+		pucOptions[ 0 ] = TCP_OPT_MSS;
+		pucOptions[ 1 ] = TCP_OPT_MSS_LEN;
+		pucOptions[ 2 ] = ( uint8_t ) ( ( pxSocket->u.xTCP.usCurMSS ) >> 8 );
+		pucOptions[ 3 ] = ( uint8_t ) ( ( pxSocket->u.xTCP.usCurMSS ) & 0xffu );
 		uxOptionsLength = 4u;
 		pxTCPHeader->ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 	}
 
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		if( pucOptions != pxTCPHeader->ucOptdata )
+		{
+			uxOptionsLength += TCP_OPT_TIMESTAMP_SIZE;
+			pxTCPHeader->ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+		}
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 	return uxOptionsLength;
 }
 /*-----------------------------------------------------------*/
@@ -2309,12 +2805,19 @@ BaseType_t xSendLength = 0;
 
 	/* Either expect a ACK or a SYN+ACK. */
 	uint16_t usExpect = ( uint16_t ) ipTCP_FLAG_ACK;
+	uint8_t ucMask = 0x17u;
 	if( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN )
 	{
 		usExpect |= ( uint16_t ) ipTCP_FLAG_SYN;
 	}
+	else
+	{
+		/* When the last ACK of the handshake got lost, the peer may have sent
+		a FIN already.  A FIN+ACK also establishes the connection. */
+		ucMask &= ( uint8_t ) ~ipTCP_FLAG_FIN;
+	}
 
-	if( ( ucTCPFlags & 0x17u ) != usExpect )
+	if( ( ucTCPFlags & ucMask ) != usExpect )
 	{
 		/* eSYN_RECEIVED: flags 0010 expected, not 0002. */
 		/* eSYN_RECEIVED: flags ACK  expected, not SYN. */
@@ -2383,9 +2886,31 @@ BaseType_t xSendLength = 0;
 			}
 		}
 		#endif /* ipconfigUSE_TCP_WIN */
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+			{
+				/* Both parties agreed on time-stamps.  From now on every
+				segment carries 12 bytes of options, which are taken from the
+				payload.  The TCP window will measure the RTT from the echoed
+				time-stamps in stead of timing a single segment. */
+				pxTCPWindow->u.bits.bTimeStamps = pdTRUE_UNSIGNED;
+				pxSocket->u.xTCP.usCurMSS = ( uint16_t ) ( pxSocket->u.xTCP.usCurMSS - TCP_OPT_TIMESTAMP_SIZE );
+				pxTCPWindow->usMSS = ( uint16_t ) FreeRTOS_min_uint32( ( uint32_t ) pxTCPWindow->usMSS, ( uint32_t ) pxSocket->u.xTCP.usCurMSS );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 		/* This was the third step of connecting: SYN, SYN+ACK, ACK	so now the
 		connection is established. */
 		vTCPStateChange( pxSocket, eESTABLISHED );
+
+		if( ( ucTCPFlags & ipTCP_FLAG_FIN ) != 0u )
+		{
+			/* Handle the FIN as in eESTABLISHED, with the flags as they were
+			received. */
+			pxTCPHeader->ucTCPFlags = ucTCPFlags;
+			xSendLength = prvHandleEstablished( pxSocket, ppxNetworkBuffer, ulReceiveLength, uxOptionsLength );
+		}
 	}
 
 	return xSendLength;
@@ -2433,6 +2958,18 @@ int32_t lDistance, lSendResult;
 			confirmed, and because there is new space in the txStream, the
 			user/owner should be woken up. */
 			/* _HT_ : only in case the socket's waiting? */
+			#if( ipconfigTCP_TX_REFERENCES != 0 )
+			{
+				prvTCPTxReferencesAck( pxSocket, ( size_t ) ulCount );
+			}
+			#endif
+
+			#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			{
+				pxSocket->u.xTCP.xAutoTune.ulTxBytes += ulCount;
+			}
+			#endif
+
 			if( uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, NULL, ( size_t ) ulCount, pdFALSE ) != 0u )
 			{
 				pxSocket->xEventBits |= eSOCKET_SEND;
@@ -2457,6 +2994,17 @@ int32_t lDistance, lSendResult;
 				#endif /* ipconfigUSE_CALLBACKS == 1  */
 			}
 		}
+
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			/* An ACK that confirms new data and echoes one of our time-stamps
+			gives a new RTT sample, also when segments were retransmitted. */
+			if( ( ulCount > 0u ) && ( pxTCPWindow->u.bits.bTimeStamps != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.ulTSEcho != 0u ) )
+			{
+				vTCPWindowRTTSample( pxTCPWindow, tcpTIME_STAMP_NOW() - pxSocket->u.xTCP.ulTSEcho );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 	}
 
 	/* If this socket has a stream for transmission, add the data to the
@@ -2514,7 +3062,7 @@ int32_t lDistance, lSendResult;
 		if( xMayClose != pdFALSE )
 		{
 			pxSocket->u.xTCP.bits.bFinAccepted = pdTRUE_UNSIGNED;
-			xSendLength = prvTCPHandleFin( pxSocket, *ppxNetworkBuffer );
+			xSendLength = prvTCPHandleFin( pxSocket, *ppxNetworkBuffer, uxOptionsLength );
 		}
 	}
 
@@ -2834,7 +3382,7 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 							 * or an acknowledgement of the connection termination request previously sent. */
 			/* Fall through */
 		case eFIN_WAIT_2:	/* (server + client) waiting for a connection termination request from the remote TCP. */
-			xSendLength = prvTCPHandleFin( pxSocket, *ppxNetworkBuffer );
+			xSendLength = prvTCPHandleFin( pxSocket, *ppxNetworkBuffer, uxOptionsLength );
 			break;
 
 		case eCLOSE_WAIT:	/* (server + client) waiting for a connection
@@ -2909,39 +3457,134 @@ static BaseType_t prvTCPSendReset( NetworkBufferDescriptor_t *pxNetworkBuffer )
 }
 /*-----------------------------------------------------------*/
 
-static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket )
-{
-uint32_t ulMSS = ipconfigTCP_MSS;
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
 
-	if( ( ( FreeRTOS_ntohl( pxSocket->u.xTCP.ulRemoteIP ) ^ *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) != 0ul )
+	static void prvTCPSetTimeStampOption( uint8_t *pucOptions, uint32_t ulTSRecent )
 	{
-		/* Data for this peer will pass through a router, and maybe through
-		the internet.  Limit the MSS to 1400 bytes or less. */
-		ulMSS = FreeRTOS_min_uint32( ( uint32_t ) REDUCED_MSS_THROUGH_INTERNET, ulMSS );
+	uint32_t ulValue;
+
+		pucOptions[ 0 ] = TCP_OPT_NOOP;
+		pucOptions[ 1 ] = TCP_OPT_NOOP;
+		pucOptions[ 2 ] = ( uint8_t ) TCP_OPT_TIMESTAMP;
+		pucOptions[ 3 ] = ( uint8_t ) TCP_OPT_TIMESTAMP_LEN;
+
+		/* The options are not 32-bit aligned within the packet, so memcpy()
+		is used to store the values. */
+		ulValue = FreeRTOS_htonl( tcpTIME_STAMP_NOW() );
+		memcpy( pucOptions + 4, &ulValue, sizeof( ulValue ) );
+		ulValue = FreeRTOS_htonl( ulTSRecent );
+		memcpy( pucOptions + 8, &ulValue, sizeof( ulValue ) );
 	}
 
-	FreeRTOS_debug_printf( ( "prvSocketSetMSS: %lu bytes for %lxip:%u\n", ulMSS, pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort ) );
-
-	pxSocket->u.xTCP.usInitMSS = pxSocket->u.xTCP.usCurMSS = ( uint16_t ) ulMSS;
-}
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 /*-----------------------------------------------------------*/
 
-/*
- *	FreeRTOS_TCP_IP has only 2 public functions, this is the second one:
- *	xProcessReceivedTCPPacket()
- *		prvTCPHandleState()
- *			prvTCPPrepareSend()
- *				prvTCPReturnPacket()
- *				xNetworkInterfaceOutput()	// Sends data to the NIC
- *		prvTCPSendRepeated()
- *			prvTCPReturnPacket()		// Prepare for returning
- *			xNetworkInterfaceOutput()	// Sends data to the NIC
-*/
-BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer )
-{
-FreeRTOS_Socket_t *pxSocket;
-TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
-uint16_t ucTCPFlags;
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+
+	static BaseType_t prvTCPCheckTimeStamp( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const TCPPacket_t *pxTCPPacket = ( const TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	uint32_t ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	BaseType_t xResult = pdPASS;
+
+		if( pxSocket->u.xTCP.bits.bTSReceived == pdFALSE_UNSIGNED )
+		{
+			/* This packet has no time-stamp.  It will be accepted, but it
+			can not be used to measure the RTT. */
+			pxSocket->u.xTCP.ulTSEcho = 0ul;
+		}
+		else
+		{
+			pxSocket->u.xTCP.bits.bTSReceived = pdFALSE_UNSIGNED;
+
+			if( ( pxSocket->u.xTCP.ucTCPState == eSYN_FIRST ) || ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) )
+			{
+				if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ipTCP_FLAG_SYN ) != 0u )
+				{
+					/* The peer offers time-stamps in its SYN, or confirms them
+					in its SYN+ACK. */
+					pxSocket->u.xTCP.bits.bTimeStamps = pdTRUE_UNSIGNED;
+					pxSocket->u.xTCP.ulTSRecent = pxSocket->u.xTCP.ulTSValue;
+				}
+				pxSocket->u.xTCP.ulTSEcho = 0ul;
+			}
+			else if( pxSocket->u.xTCP.bits.bTimeStamps == pdFALSE_UNSIGNED )
+			{
+				/* Time-stamps were not negotiated, ignore the option. */
+				pxSocket->u.xTCP.ulTSEcho = 0ul;
+			}
+			else if( ( int32_t ) ( pxSocket->u.xTCP.ulTSValue - pxSocket->u.xTCP.ulTSRecent ) < 0 )
+			{
+				/* PAWS: the time-stamp is older than the most recent one,
+				this must be an old duplicate from an earlier incarnation or
+				from before a sequence number wrap-around. */
+				FreeRTOS_debug_printf( ( "PAWS: %lxip:%u: TSval %lu < %lu, drop\n",
+					pxSocket->u.xTCP.ulRemoteIP,
+					pxSocket->u.xTCP.usRemotePort,
+					pxSocket->u.xTCP.ulTSValue,
+					pxSocket->u.xTCP.ulTSRecent ) );
+				pxSocket->u.xTCP.ulTSEcho = 0ul;
+				xResult = pdFAIL;
+			}
+			else if( ( int32_t ) ( ulSequenceNumber - pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber ) <= 0 )
+			{
+				/* The segment does not start beyond the last byte that was
+				acknowledged: its time-stamp becomes the one to echo. */
+				pxSocket->u.xTCP.ulTSRecent = pxSocket->u.xTCP.ulTSValue;
+			}
+			else
+			{
+				/* An out-of-order segment, TS.Recent remains unchanged. */
+			}
+		}
+
+		return xResult;
+	}
+
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+/*-----------------------------------------------------------*/
+
+static uint16_t prvTCPLocalMSS( uint32_t ulRemoteIP )
+{
+uint32_t ulMSS = ipconfigTCP_MSS;
+
+	if( ( ( FreeRTOS_ntohl( ulRemoteIP ) ^ *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) != 0ul )
+	{
+		/* Data for this peer will pass through a router, and maybe through
+		the internet.  Limit the MSS to 1400 bytes or less. */
+		ulMSS = FreeRTOS_min_uint32( ( uint32_t ) REDUCED_MSS_THROUGH_INTERNET, ulMSS );
+	}
+
+	return ( uint16_t ) ulMSS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket )
+{
+uint32_t ulMSS = ( uint32_t ) prvTCPLocalMSS( pxSocket->u.xTCP.ulRemoteIP );
+
+	FreeRTOS_debug_printf( ( "prvSocketSetMSS: %lu bytes for %lxip:%u\n", ulMSS, pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort ) );
+
+	pxSocket->u.xTCP.usInitMSS = pxSocket->u.xTCP.usCurMSS = ( uint16_t ) ulMSS;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ *	FreeRTOS_TCP_IP has only 2 public functions, this is the second one:
+ *	xProcessReceivedTCPPacket()
+ *		prvTCPHandleState()
+ *			prvTCPPrepareSend()
+ *				prvTCPReturnPacket()
+ *				xNetworkInterfaceOutput()	// Sends data to the NIC
+ *		prvTCPSendRepeated()
+ *			prvTCPReturnPacket()		// Prepare for returning
+ *			xNetworkInterfaceOutput()	// Sends data to the NIC
+*/
+BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+FreeRTOS_Socket_t *pxSocket;
+TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+uint16_t ucTCPFlags;
 uint32_t ulLocalIP;
 uint16_t xLocalPort;
 uint32_t ulRemoteIP;
@@ -2949,6 +3592,9 @@ uint16_t xRemotePort;
 uint32_t ulSequenceNumber;
 uint32_t ulAckNumber;
 BaseType_t xResult = pdPASS;
+#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	FreeRTOS_Socket_t *pxTimerSocket = NULL;
+#endif
 configASSERT(pxNetworkBuffer);
 configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 
@@ -2998,12 +3644,36 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 	}
 	else
 	{
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+		{
+			/* The field 'usTimeout' may be changed while handling the
+			packet, take the socket out of the timer wheel. */
+			vTCPTimerSync( pxSocket );
+			pxTimerSocket = pxSocket;
+		}
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 		pxSocket->u.xTCP.ucRepCount = 0u;
 
 		if( pxSocket->u.xTCP.ucTCPState == eTCP_LISTEN )
 		{
 			/* The matching socket is in a listening state.  Test if the peer
 			has set the SYN flag. */
+			#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+			if( ( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED ) &&
+				( ( ucTCPFlags & ( ipTCP_FLAG_SYN | ipTCP_FLAG_RST | ipTCP_FLAG_ACK ) ) == ipTCP_FLAG_ACK ) )
+			{
+				/* This ACK may complete a handshake for which no socket has
+				been created yet. */
+				pxSocket = prvHandleListenAck( pxSocket, pxNetworkBuffer );
+
+				if( pxSocket == NULL )
+				{
+					xResult = pdFAIL;
+				}
+			}
+			else
+			#endif /* ipconfigTCP_SYN_CACHE_SIZE */
 			if( ( ucTCPFlags & ipTCP_FLAG_CTRL ) != ipTCP_FLAG_SYN )
 			{
 				/* What happens: maybe after a reboot, a client doesn't know the
@@ -3118,6 +3788,16 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 		}
 		#endif
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		if( prvTCPCheckTimeStamp( pxSocket, pxNetworkBuffer ) == pdFAIL )
+		{
+			/* PAWS: the packet is an old duplicate.  Do not process it, but
+			send an ACK so the peer learns where the connection stands. */
+			( void ) prvTCPSendChallengeAck( pxNetworkBuffer );
+		}
+		else
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 		/* In prvTCPHandleState() the incoming messages will be handled
 		depending on the current state of the connection. */
 		if( prvTCPHandleState( pxSocket, &pxNetworkBuffer ) > 0 )
@@ -3146,6 +3826,22 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 		xResult = pdPASS;
 	}
 
+	#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+	{
+		/* Store the socket(s) in the timer wheel again.  A listening socket
+		may have created a new child socket. */
+		if( pxTimerSocket != NULL )
+		{
+			vTCPTimerUpdate( pxTimerSocket );
+		}
+
+		if( ( xResult != pdFAIL ) && ( pxSocket != pxTimerSocket ) )
+		{
+			vTCPTimerUpdate( pxSocket );
+		}
+	}
+	#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 	/* pdPASS being returned means the buffer has been consumed. */
 	return xResult;
 }
@@ -3164,6 +3860,12 @@ uint32_t ulInitialSequenceNumber;
 																  pxTCPPacket->xIPHeader.ulSourceIPAddress,
 																  pxTCPPacket->xTCPHeader.usSourcePort );
 
+	#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	{
+		xTCPListenStatistics.ulSynReceived++;
+	}
+	#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
 	/* A pure SYN (without ACK) has come in, create a new socket to answer
 	it. */
 	if( 0 != ulInitialSequenceNumber )
@@ -3190,8 +3892,21 @@ uint32_t ulInitialSequenceNumber;
 					pxSocket->u.xTCP.usBacklog,
 					pxSocket->u.xTCP.usChildCount == 1 ? "" : "ren" ) );
 				prvTCPSendReset( pxNetworkBuffer );
+
+				#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+				{
+					xTCPListenStatistics.ulBacklogFull++;
+				}
+				#endif /* ipconfigTCP_SYN_CACHE_SIZE */
 			}
 			else
+			#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+			{
+				/* Answer the SYN without creating a socket, that will be
+				done by prvHandleListenAck(). */
+				prvTCPSynCacheAdd( pxSocket, pxNetworkBuffer, ulInitialSequenceNumber );
+			}
+			#else
 			{
 				FreeRTOS_Socket_t *pxNewSocket = ( FreeRTOS_Socket_t * )
 					FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
@@ -3210,6 +3925,7 @@ uint32_t ulInitialSequenceNumber;
 					pxReturn = pxNewSocket;
 				}
 			}
+			#endif /* ipconfigTCP_SYN_CACHE_SIZE */
 		}
 	}
 
@@ -3252,6 +3968,15 @@ struct freertos_sockaddr xAddress;
 	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
 	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
 
+	#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	{
+		pxNewSocket->u.xTCP.xAutoTune.uxRxBaseSize = pxSocket->u.xTCP.xAutoTune.uxRxBaseSize;
+		pxNewSocket->u.xTCP.xAutoTune.uxTxBaseSize = pxSocket->u.xTCP.xAutoTune.uxTxBaseSize;
+		pxNewSocket->u.xTCP.xAutoTune.ucRxFixed = pxSocket->u.xTCP.xAutoTune.ucRxFixed;
+		pxNewSocket->u.xTCP.xAutoTune.ucTxFixed = pxSocket->u.xTCP.xAutoTune.ucTxFixed;
+	}
+	#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 	{
 		pxNewSocket->pxUserSemaphore = pxSocket->pxUserSemaphore;
@@ -3267,6 +3992,12 @@ struct freertos_sockaddr xAddress;
 	}
 	#endif /* ipconfigUSE_CALLBACKS */
 
+	#if( ipconfigTCP_TX_REFERENCES != 0 )
+	{
+		pxNewSocket->u.xTCP.pxHandleTxReference = pxSocket->u.xTCP.pxHandleTxReference;
+	}
+	#endif /* ipconfigTCP_TX_REFERENCES */
+
 	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 	{
 		/* Child socket of listening sockets will inherit the Socket Set
@@ -3329,6 +4060,618 @@ struct freertos_sockaddr xAddress;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	static TCPSynEntry_t *prvTCPSynCacheFind( uint16_t usLocalPort, uint32_t ulRemoteIP, uint16_t usRemotePort )
+	{
+	TCPSynEntry_t *pxReturn = NULL;
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ARRAY_SIZE( xTCPSynCache ); xIndex++ )
+		{
+			if( ( xTCPSynCache[ xIndex ].usLocalPort == usLocalPort ) &&
+				( xTCPSynCache[ xIndex ].ulRemoteIP == ulRemoteIP ) &&
+				( xTCPSynCache[ xIndex ].usRemotePort == usRemotePort ) )
+			{
+				pxReturn = &( xTCPSynCache[ xIndex ] );
+				break;
+			}
+		}
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	static void prvTCPSynReadOptions( const NetworkBufferDescriptor_t *pxNetworkBuffer, TCPSynEntry_t *pxEntry )
+	{
+	const TCPPacket_t *pxTCPPacket = ( const TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	const uint8_t *pucPtr = pxTCPPacket->xTCPHeader.ucOptdata;
+	const uint8_t *pucLast = pucPtr;
+	UBaseType_t uxRemaining;
+	uint8_t ucLen;
+	uint16_t usPeerMSS = 0u;
+
+		pxEntry->usMSS = prvTCPLocalMSS( pxEntry->ulRemoteIP );
+
+		if( ( pxTCPPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
+		{
+			pucLast = pucPtr + ( ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) - 5 ) << 2 );
+
+			if( pucLast > ( pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->xDataLength ) )
+			{
+				/* The options are not complete, ignore them. */
+				pucLast = pucPtr;
+			}
+		}
+
+		while( pucPtr < pucLast )
+		{
+			uxRemaining = ( UBaseType_t ) ( pucLast - pucPtr );
+
+			if( pucPtr[ 0 ] == TCP_OPT_NOOP )
+			{
+				pucPtr++;
+			}
+			else if( ( pucPtr[ 0 ] == TCP_OPT_END ) || ( uxRemaining < 2u ) )
+			{
+				break;
+			}
+			else
+			{
+				ucLen = pucPtr[ 1 ];
+				if( ( ucLen < 2u ) || ( ucLen > uxRemaining ) )
+				{
+					/* The options are malformed, stop parsing them. */
+					break;
+				}
+
+				if( ( pucPtr[ 0 ] == TCP_OPT_MSS ) && ( ucLen == TCP_OPT_MSS_LEN ) )
+				{
+					usPeerMSS = usChar2u16( pucPtr + 2 );
+				}
+				#if( ipconfigUSE_TCP_WIN != 0 )
+				else if( ( pucPtr[ 0 ] == TCP_OPT_WSOPT ) && ( ucLen == TCP_OPT_WSOPT_LEN ) )
+				{
+					pxEntry->ucPeerWinScaleFactor = pucPtr[ 2 ];
+					pxEntry->bWinScaling = pdTRUE_UNSIGNED;
+				}
+				#endif /* ipconfigUSE_TCP_WIN */
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+				else if( ( pucPtr[ 0 ] == TCP_OPT_TIMESTAMP ) && ( ucLen == TCP_OPT_TIMESTAMP_LEN ) )
+				{
+					pxEntry->ulTSRecent = ulChar2u32( pucPtr + 2 );
+					pxEntry->bTimeStamps = pdTRUE_UNSIGNED;
+				}
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+				else
+				{
+					/* SACK-permitted is always answered, other options are
+					not used in a SYN. */
+				}
+
+				pucPtr += ucLen;
+			}
+		}
+
+		if( ( usPeerMSS != 0u ) && ( usPeerMSS < pxEntry->usMSS ) )
+		{
+			pxEntry->usMSS = usPeerMSS;
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	static void prvTCPSynCacheReply( const FreeRTOS_Socket_t *pxSocket, const TCPSynEntry_t *pxEntry, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	NetworkBufferDescriptor_t *pxReplyBuffer = pxNetworkBuffer;
+	BaseType_t xReleaseAfterSend = pdFALSE;
+	TCPPacket_t *pxTCPPacket;
+	TCPHeader_t *pxTCPHeader;
+	UBaseType_t uxOptionsLength = 4u;
+	uint32_t ulWinSize;
+	size_t uxNeeded;
+
+		/* Calculate the length of the options before writing them. */
+		#if( ipconfigUSE_TCP_WIN != 0 )
+		{
+			uxOptionsLength += ( pxEntry->bWinScaling != pdFALSE_UNSIGNED ) ? 8u : 4u;
+		}
+		#endif
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			if( pxEntry->bTimeStamps != pdFALSE_UNSIGNED )
+			{
+				uxOptionsLength += TCP_OPT_TIMESTAMP_SIZE;
+			}
+		}
+		#endif
+
+		uxNeeded = ( size_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
+
+		if( pxNetworkBuffer->xDataLength < uxNeeded )
+		{
+			if( xBufferAllocFixedSize != pdFALSE )
+			{
+				/* Network buffers can hold the largest MTU. */
+				pxNetworkBuffer->xDataLength = uxNeeded;
+			}
+			else
+			{
+				/* The SYN+ACK is longer than the SYN, a bigger buffer is
+				needed.  The SYN remains owned by the caller. */
+				pxReplyBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, uxNeeded );
+				xReleaseAfterSend = pdTRUE;
+			}
+		}
+
+		if( pxReplyBuffer != NULL )
+		{
+			pxTCPPacket = ( TCPPacket_t * ) ( pxReplyBuffer->pucEthernetBuffer );
+			pxTCPHeader = &( pxTCPPacket->xTCPHeader );
+
+			pxTCPHeader->ucOptdata[ 0 ] = ( uint8_t ) TCP_OPT_MSS;
+			pxTCPHeader->ucOptdata[ 1 ] = ( uint8_t ) TCP_OPT_MSS_LEN;
+			pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( pxEntry->usMSS >> 8 );
+			pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( pxEntry->usMSS & 0xffu );
+			uxOptionsLength = 4u;
+
+			#if( ipconfigUSE_TCP_WIN != 0 )
+			{
+				/* Window scaling is only confirmed when the peer has offered
+				it. */
+				if( pxEntry->bWinScaling != pdFALSE_UNSIGNED )
+				{
+					pxTCPHeader->ucOptdata[ uxOptionsLength + 0 ] = TCP_OPT_NOOP;
+					pxTCPHeader->ucOptdata[ uxOptionsLength + 1 ] = ( uint8_t ) ( TCP_OPT_WSOPT );
+					pxTCPHeader->ucOptdata[ uxOptionsLength + 2 ] = ( uint8_t ) ( TCP_OPT_WSOPT_LEN );
+					pxTCPHeader->ucOptdata[ uxOptionsLength + 3 ] = pxEntry->ucMyWinScaleFactor;
+					uxOptionsLength += 4u;
+				}
+
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 0 ] = TCP_OPT_NOOP;
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 1 ] = TCP_OPT_NOOP;
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 2 ] = TCP_OPT_SACK_P;	/* 4: Sack-Permitted Option. */
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 3 ] = 2;	/* 2: length of this option. */
+				uxOptionsLength += 4u;
+			}
+			#endif /* ipconfigUSE_TCP_WIN */
+
+			#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+			{
+				if( pxEntry->bTimeStamps != pdFALSE_UNSIGNED )
+				{
+					prvTCPSetTimeStampOption( &( pxTCPHeader->ucOptdata[ uxOptionsLength ] ), pxEntry->ulTSRecent );
+					uxOptionsLength += TCP_OPT_TIMESTAMP_SIZE;
+				}
+			}
+			#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+			/* The window field of a SYN+ACK is never scaled. */
+			ulWinSize = FreeRTOS_min_uint32( ( uint32_t ) ( ipconfigTCP_MSS * pxSocket->u.xTCP.uxRxWinSize ), ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize );
+			ulWinSize = FreeRTOS_min_uint32( ulWinSize, 0xfffcUL );
+			pxTCPHeader->usWindow = FreeRTOS_htons( ( uint16_t ) ulWinSize );
+
+			pxTCPHeader->ucTCPFlags = ipTCP_FLAG_SYN | ipTCP_FLAG_ACK;
+			pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+			/* prvTCPReturnPacket() will swap the two sequence numbers, as it
+			does for a packet without a socket. */
+			pxTCPHeader->ulAckNr = FreeRTOS_htonl( pxEntry->ulOurSequenceNumber );
+			pxTCPHeader->ulSequenceNumber = FreeRTOS_htonl( pxEntry->ulPeerSequenceNumber + 1u );
+
+			prvTCPReturnPacket( NULL, pxReplyBuffer, ( uint32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ), xReleaseAfterSend );
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	static void prvTCPSynCacheAdd( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber )
+	{
+	const TCPPacket_t *pxTCPPacket = ( const TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	const TickType_t xNow = xTaskGetTickCount();
+	const TickType_t xMaxAge = pdMS_TO_TICKS( ipconfigTCP_SYN_CACHE_TIMEOUT_MS );
+	TCPSynEntry_t xEntry;
+	TCPSynEntry_t *pxEntry;
+	TCPSynEntry_t *pxItem;
+	TCPSynEntry_t *pxFree = NULL;
+	TCPSynEntry_t *pxOldest = NULL;
+	TCPSynEntry_t *pxOldestOwn = NULL;
+	UBaseType_t uxHalfOpen = 0u;
+	BaseType_t xIndex;
+
+		memset( &xEntry, '\0', sizeof( xEntry ) );
+		xEntry.ulRemoteIP = FreeRTOS_ntohl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+		xEntry.usRemotePort = FreeRTOS_ntohs( pxTCPPacket->xTCPHeader.usSourcePort );
+		xEntry.usLocalPort = pxSocket->usLocalPort;
+		xEntry.ulPeerSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+		xEntry.ulOurSequenceNumber = ulInitialSequenceNumber;
+		xEntry.xCreationTime = xNow;
+
+		prvTCPSynReadOptions( pxNetworkBuffer, &xEntry );
+
+		#if( ipconfigUSE_TCP_WIN != 0 )
+		{
+			if( xEntry.bWinScaling != pdFALSE_UNSIGNED )
+			{
+				xEntry.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket, ( size_t ) xEntry.usMSS );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_WIN */
+
+		pxEntry = prvTCPSynCacheFind( xEntry.usLocalPort, xEntry.ulRemoteIP, xEntry.usRemotePort );
+
+		if( pxEntry != NULL )
+		{
+			/* The peer repeats its SYN, probably because the SYN+ACK got
+			lost.  Answer it again, unless it is a new attempt with a different
+			sequence number. */
+			xTCPListenStatistics.ulSynRepeated++;
+
+			if( pxEntry->ulPeerSequenceNumber != xEntry.ulPeerSequenceNumber )
+			{
+				*pxEntry = xEntry;
+			}
+		}
+		else
+		{
+			for( xIndex = 0; xIndex < ( BaseType_t ) ARRAY_SIZE( xTCPSynCache ); xIndex++ )
+			{
+				pxItem = &( xTCPSynCache[ xIndex ] );
+
+				if( ( pxItem->usLocalPort != 0u ) && ( ( xNow - pxItem->xCreationTime ) >= xMaxAge ) )
+				{
+					/* The handshake was never completed, forget about it. */
+					pxItem->usLocalPort = 0u;
+				}
+
+				if( pxItem->usLocalPort == 0u )
+				{
+					if( pxFree == NULL )
+					{
+						pxFree = pxItem;
+					}
+				}
+				else
+				{
+					if( ( pxOldest == NULL ) || ( ( xNow - pxItem->xCreationTime ) > ( xNow - pxOldest->xCreationTime ) ) )
+					{
+						pxOldest = pxItem;
+					}
+
+					if( pxItem->usLocalPort == pxSocket->usLocalPort )
+					{
+						uxHalfOpen++;
+						if( ( pxOldestOwn == NULL ) || ( ( xNow - pxItem->xCreationTime ) > ( xNow - pxOldestOwn->xCreationTime ) ) )
+						{
+							pxOldestOwn = pxItem;
+						}
+					}
+				}
+			}
+
+			if( ( uxHalfOpen + pxSocket->u.xTCP.usChildCount ) >= pxSocket->u.xTCP.usBacklog )
+			{
+				/* The half-open and established connections together would
+				exceed the backlog of this socket. */
+				#if( ipconfigTCP_SYN_COOKIES == 0 )
+				{
+					pxEntry = pxOldestOwn;
+				}
+				#endif
+			}
+			else if( pxFree != NULL )
+			{
+				pxEntry = pxFree;
+			}
+			else
+			{
+				/* The SYN cache is full. */
+				#if( ipconfigTCP_SYN_COOKIES == 0 )
+				{
+					pxEntry = pxOldest;
+				}
+				#endif
+			}
+
+			if( pxEntry != NULL )
+			{
+				if( pxEntry->usLocalPort != 0u )
+				{
+					/* Without SYN cookies, the oldest half-open connection
+					makes room for the newest one. */
+					xTCPListenStatistics.ulSynEvictions++;
+				}
+				*pxEntry = xEntry;
+			}
+		}
+
+		if( pxEntry != NULL )
+		{
+			prvTCPSynCacheReply( pxSocket, pxEntry, pxNetworkBuffer );
+		}
+		else
+		#if( ipconfigTCP_SYN_COOKIES != 0 )
+		if( prvTCPSynCookieCreate( &xEntry ) != pdFALSE )
+		{
+			/* There is no room to store the connection, it is encoded in
+			the sequence number of the SYN+ACK. */
+			xTCPListenStatistics.ulCookiesSent++;
+			prvTCPSynCacheReply( pxSocket, &xEntry, pxNetworkBuffer );
+		}
+		else
+		#endif /* ipconfigTCP_SYN_COOKIES */
+		{
+			xTCPListenStatistics.ulSynDropped++;
+			FreeRTOS_debug_printf( ( "TCP: Listen: SYN from %lxip:%u dropped, %u half-open for port %u\n",
+				xEntry.ulRemoteIP,
+				xEntry.usRemotePort,
+				( unsigned ) uxHalfOpen,
+				pxSocket->usLocalPort ) );
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	static FreeRTOS_Socket_t *prvHandleListenAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const TCPPacket_t *pxTCPPacket = ( const TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	uint32_t ulRemoteIP = FreeRTOS_ntohl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+	uint16_t usRemotePort = FreeRTOS_ntohs( pxTCPPacket->xTCPHeader.usSourcePort );
+	uint32_t ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	uint32_t ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+	FreeRTOS_Socket_t *pxNewSocket;
+	FreeRTOS_Socket_t *pxReturn = NULL;
+	TCPSynEntry_t *pxEntry;
+	#if( ipconfigTCP_SYN_COOKIES != 0 )
+		TCPSynEntry_t xEntry;
+	#endif
+
+		pxEntry = prvTCPSynCacheFind( pxSocket->usLocalPort, ulRemoteIP, usRemotePort );
+
+		if( ( pxEntry != NULL ) &&
+			( ( ulAckNumber != ( pxEntry->ulOurSequenceNumber + 1u ) ) || ( ulSequenceNumber != ( pxEntry->ulPeerSequenceNumber + 1u ) ) ) )
+		{
+			/* The ACK does not confirm the SYN+ACK that was sent. */
+			pxEntry = NULL;
+		}
+
+		#if( ipconfigTCP_SYN_COOKIES != 0 )
+		{
+			if( pxEntry == NULL )
+			{
+				/* The connection may have been encoded in a SYN cookie. */
+				memset( &xEntry, '\0', sizeof( xEntry ) );
+				xEntry.ulRemoteIP = ulRemoteIP;
+				xEntry.usRemotePort = usRemotePort;
+				xEntry.usLocalPort = pxSocket->usLocalPort;
+				xEntry.ulPeerSequenceNumber = ulSequenceNumber - 1u;
+
+				if( prvTCPSynCookieCheck( &xEntry, ulAckNumber - 1u ) != pdFALSE )
+				{
+					xTCPListenStatistics.ulCookiesAccepted++;
+					pxEntry = &xEntry;
+				}
+			}
+		}
+		#endif /* ipconfigTCP_SYN_COOKIES */
+
+		if( pxEntry == NULL )
+		{
+			/* Not the last step of a handshake.  Maybe after a reboot, a
+			client doesn't know the connection had gone.  Send a RST in order
+			to get a new connect request. */
+			xTCPListenStatistics.ulBadAcks++;
+			FreeRTOS_debug_printf( ( "TCP: Listen: unexpected ACK from %lxip:%u to port %u\n",
+				ulRemoteIP, usRemotePort, pxSocket->usLocalPort ) );
+			prvTCPSendReset( pxNetworkBuffer );
+		}
+		else if( pxSocket->u.xTCP.usChildCount >= pxSocket->u.xTCP.usBacklog )
+		{
+			/* The owner has not accepted enough connections yet.  Leave the
+			entry in the cache, the connection can be completed by the next
+			packet that the peer sends. */
+			xTCPListenStatistics.ulAcceptQueueFull++;
+		}
+		else
+		{
+			pxNewSocket = ( FreeRTOS_Socket_t * ) FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+			if( ( pxNewSocket == NULL ) || ( pxNewSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				FreeRTOS_debug_printf( ( "TCP: Listen: new socket failed\n" ) );
+				xTCPListenStatistics.ulChildFailed++;
+				prvTCPSendReset( pxNetworkBuffer );
+			}
+			else if( prvTCPSocketCopy( pxNewSocket, pxSocket ) == pdFALSE )
+			{
+				xTCPListenStatistics.ulChildFailed++;
+			}
+			else
+			{
+				pxNewSocket->u.xTCP.usRemotePort = pxEntry->usRemotePort;
+				pxNewSocket->u.xTCP.ulRemoteIP = pxEntry->ulRemoteIP;
+				pxNewSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber = pxEntry->ulOurSequenceNumber;
+				pxNewSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = pxEntry->ulPeerSequenceNumber;
+				pxNewSocket->u.xTCP.usInitMSS = pxNewSocket->u.xTCP.usCurMSS = pxEntry->usMSS;
+
+				#if( ipconfigUSE_TCP_WIN != 0 )
+				{
+					pxNewSocket->u.xTCP.bits.bWinScaling = pxEntry->bWinScaling;
+					pxNewSocket->u.xTCP.ucPeerWinScaleFactor = pxEntry->ucPeerWinScaleFactor;
+					pxNewSocket->u.xTCP.ucMyWinScaleFactor = pxEntry->ucMyWinScaleFactor;
+				}
+				#endif /* ipconfigUSE_TCP_WIN */
+
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+				{
+					pxNewSocket->u.xTCP.bits.bTimeStamps = pxEntry->bTimeStamps;
+					pxNewSocket->u.xTCP.ulTSRecent = pxEntry->ulTSRecent;
+				}
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+				prvTCPCreateWindow( pxNewSocket );
+
+				/* The SYN+ACK has been sent already, the socket continues as if
+				it had sent it itself.  prvHandleSynReceived() will process the
+				ACK. */
+				vTCPStateChange( pxNewSocket, eSYN_RECEIVED );
+
+				pxNewSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = pxNewSocket->u.xTCP.xTCPWindow.rx.ulHighestSequenceNumber = pxEntry->ulPeerSequenceNumber + 1u;
+				pxNewSocket->u.xTCP.xTCPWindow.tx.ulCurrentSequenceNumber = pxNewSocket->u.xTCP.xTCPWindow.ulNextTxSequenceNumber = pxNewSocket->u.xTCP.xTCPWindow.tx.ulFirstSequenceNumber + 1u;
+
+				/* Make a copy of the header up to the TCP header.  It is needed
+				later on, whenever data must be sent to the peer. */
+				memcpy( pxNewSocket->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxNewSocket->u.xTCP.xPacket.u.ucLastPacket ) );
+
+				xTCPListenStatistics.ulConnections++;
+				pxReturn = pxNewSocket;
+			}
+
+			/* The half-open connection has been dealt with. */
+			pxEntry->usLocalPort = 0u;
+		}
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static uint32_t prvTCPSynCookieHash( const TCPSynEntry_t *pxEntry, uint32_t ulTopBits )
+	{
+	uint32_t ulWords[ 4 ];
+	uint32_t ulHash = ulSynCookieSecret[ 0 ];
+	BaseType_t xIndex;
+
+		ulWords[ 0 ] = pxEntry->ulRemoteIP;
+		ulWords[ 1 ] = ( ( ( uint32_t ) pxEntry->usRemotePort ) << 16 ) | ( uint32_t ) pxEntry->usLocalPort;
+		ulWords[ 2 ] = pxEntry->ulPeerSequenceNumber;
+		ulWords[ 3 ] = ulTopBits ^ ulSynCookieSecret[ 1 ];
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ARRAY_SIZE( ulWords ); xIndex++ )
+		{
+			/* Mix each word into the hash, so that every input bit affects
+			every output bit. */
+			ulHash ^= ulWords[ xIndex ];
+			ulHash ^= ulHash >> 16;
+			ulHash *= 0x045d9f3bUL;
+			ulHash ^= ulHash >> 16;
+		}
+
+		return ulHash & tcpSYN_COOKIE_HASH_MASK;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static BaseType_t prvTCPSynCookieCreate( TCPSynEntry_t *pxEntry )
+	{
+	uint32_t ulCount;
+	uint32_t ulIndex;
+	uint32_t ulTopBits;
+	BaseType_t xReturn = pdFALSE;
+
+		if( xSynCookieSecretValid == pdFALSE )
+		{
+			if( ( xApplicationGetRandomNumber( &( ulSynCookieSecret[ 0 ] ) ) != pdFALSE ) &&
+				( xApplicationGetRandomNumber( &( ulSynCookieSecret[ 1 ] ) ) != pdFALSE ) )
+			{
+				xSynCookieSecretValid = pdTRUE;
+			}
+		}
+
+		if( xSynCookieSecretValid != pdFALSE )
+		{
+			ulCount = ( ( uint32_t ) xTaskGetTickCount() / ( uint32_t ) pdMS_TO_TICKS( tcpSYN_COOKIE_PERIOD_MS ) ) & tcpSYN_COOKIE_COUNT_MASK;
+
+			/* Look up the largest MSS that does not exceed the MSS of the
+			connection. */
+			ulIndex = 0u;
+			while( ( ulIndex < tcpSYN_COOKIE_MSS_MASK ) && ( usSynCookieMSS[ ulIndex + 1u ] <= pxEntry->usMSS ) )
+			{
+				ulIndex++;
+			}
+
+			pxEntry->usMSS = ( uint16_t ) FreeRTOS_min_uint32( ( uint32_t ) usSynCookieMSS[ ulIndex ], ( uint32_t ) pxEntry->usMSS );
+			ulTopBits = ( ulCount << tcpSYN_COOKIE_COUNT_SHIFT ) | ( ulIndex << tcpSYN_COOKIE_MSS_SHIFT );
+			pxEntry->ulOurSequenceNumber = ulTopBits | prvTCPSynCookieHash( pxEntry, ulTopBits );
+
+			/* A cookie has no room for the other options, the connection will
+			use neither window scaling nor time-stamps. */
+			pxEntry->bWinScaling = pdFALSE_UNSIGNED;
+			pxEntry->bTimeStamps = pdFALSE_UNSIGNED;
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static BaseType_t prvTCPSynCookieCheck( TCPSynEntry_t *pxEntry, uint32_t ulCookie )
+	{
+	uint32_t ulCount;
+	uint32_t ulAge;
+	uint32_t ulIndex;
+	uint32_t ulTopBits = ulCookie & ~tcpSYN_COOKIE_HASH_MASK;
+	BaseType_t xReturn = pdFALSE;
+
+		if( xSynCookieSecretValid != pdFALSE )
+		{
+			ulCount = ( ( uint32_t ) xTaskGetTickCount() / ( uint32_t ) pdMS_TO_TICKS( tcpSYN_COOKIE_PERIOD_MS ) ) & tcpSYN_COOKIE_COUNT_MASK;
+			ulAge = ( ulCount - ( ulCookie >> tcpSYN_COOKIE_COUNT_SHIFT ) ) & tcpSYN_COOKIE_COUNT_MASK;
+
+			if( ( ulAge <= 1u ) && ( ( ulCookie & tcpSYN_COOKIE_HASH_MASK ) == prvTCPSynCookieHash( pxEntry, ulTopBits ) ) )
+			{
+				ulIndex = ( ulCookie >> tcpSYN_COOKIE_MSS_SHIFT ) & tcpSYN_COOKIE_MSS_MASK;
+				pxEntry->usMSS = ( uint16_t ) FreeRTOS_min_uint32( ( uint32_t ) usSynCookieMSS[ ulIndex ], ( uint32_t ) prvTCPLocalMSS( pxEntry->ulRemoteIP ) );
+				pxEntry->ulOurSequenceNumber = ulCookie;
+				pxEntry->bWinScaling = pdFALSE_UNSIGNED;
+				pxEntry->bTimeStamps = pdFALSE_UNSIGNED;
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	void FreeRTOS_GetTCPListenStatistics( TCPListenStatistics_t *pxStatistics )
+	{
+		vTaskSuspendAll();
+		{
+			*pxStatistics = xTCPListenStatistics;
+		}
+		( void ) xTaskResumeAll();
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
 #if( ( ipconfigHAS_DEBUG_PRINTF != 0 ) || ( ipconfigHAS_PRINTF != 0 ) )
 
 	const char *FreeRTOS_GetTCPStateName( UBaseType_t ulState )
@@ -57,22 +57,33 @@
 #define winSRTT_DECREMENT_CURRENT 	7
 #define winSRTT_CAP_mS				50
 
+/* Constants used for the Retransmission Time-Out (RTO) of RFC 6298, which is
+used together with TCP time-stamps. */
+#define winRTO_INITIAL_mS			1000
+#define winRTO_MIN_mS				200
+#define winRTO_MAX_mS				60000
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	#define xTCPWindowRxNew( pxWindow, ulSequenceNumber, lCount ) xTCPWindowNew( pxWindow, ulSequenceNumber, lCount, pdTRUE )
 
 	#define xTCPWindowTxNew( pxWindow, ulSequenceNumber, lCount ) xTCPWindowNew( pxWindow, ulSequenceNumber, lCount, pdFALSE )
 
-	/* The code to send a single Selective ACK (SACK):
-	 * NOP (0x01), NOP (0x01), SACK (0x05), LEN (0x0a),
-	 * followed by a lower and a higher sequence number,
-	 * where LEN is 2 + 2*4 = 10 bytes. */
+	/* The code to send a Selective ACK (SACK) with 'uxBlocks' blocks:
+	 * NOP (0x01), NOP (0x01), SACK (0x05), LEN,
+	 * followed by pairs of a lower and a higher sequence number,
+	 * where LEN is 2 + uxBlocks * 2*4 bytes, e.g. 0x0a for a single SACK. */
+	#define OPTION_SACK_LENGTH( uxBlocks )	( 2UL + ( 8UL * ( uint32_t ) ( uxBlocks ) ) )
 	#if( ipconfigBYTE_ORDER == pdFREERTOS_BIG_ENDIAN )
-		#define OPTION_CODE_SINGLE_SACK		( 0x0101050aUL )
+		#define OPTION_CODE_SACK( uxBlocks )	( 0x01010500UL | OPTION_SACK_LENGTH( uxBlocks ) )
 	#else
-		#define OPTION_CODE_SINGLE_SACK		( 0x0a050101UL )
+		#define OPTION_CODE_SACK( uxBlocks )	( 0x00050101UL | ( OPTION_SACK_LENGTH( uxBlocks ) << 24 ) )
 	#endif
 
+	/* When TCP time-stamps are used, one SACK block less fits in the options. */
+	#define winSACK_MAX_BLOCKS( pxWindow ) \
+		( ( ( pxWindow )->u.bits.bTimeStamps != pdFALSE_UNSIGNED ) ? ( ipTCP_MAX_SACK_BLOCKS - 1u ) : ipTCP_MAX_SACK_BLOCKS )
+
 	/* Normal retransmission:
 	 * A packet will be retransmitted after a Retransmit Time-Out (RTO).
 	 * Fast retransmission:
@@ -87,6 +98,28 @@
 	 */
 	#define MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW		( 4u )
 
+	/* CUBIC: the window is multiplied by beta = 0.7 after a loss, and it grows
+	 * with C = 0.4 segments per second^3.  Both are expressed as integers.
+	 */
+	#define winCUBIC_BETA_TENTHS						( 7u )
+	#define winCUBIC_C_TENTHS							( 4u )
+
+	/* The time in ms that a segment waits for an ACK before it is sent again.
+	 * Normally it is 2 * lSRTT after the first transmission, doubling with
+	 * every retransmission.  With time-stamps, the RTO of RFC 6298 is used
+	 * in stead, which also doubles with every retransmission.
+	 */
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		#define winRETRANSMIT_TIME( pxWindow, ucCount )		prvTCPWindowRetransmitTime( ( pxWindow ), ( uint32_t ) ( ucCount ) )
+	#else
+		#define winRETRANSMIT_TIME( pxWindow, ucCount )		( ( ( uint32_t ) 1u << ( ucCount ) ) * ( ( uint32_t ) ( pxWindow )->lSRTT ) )
+	#endif
+
+	/* The maximum depth of the AVL tree of received segments.  An AVL tree
+	 * of height 32 holds at least 3.5 million segments.
+	 */
+	#define winRX_TREE_MAX_DEPTH						( 32u )
+
 #endif /* configUSE_TCP_WIN */
 /*-----------------------------------------------------------*/
 
@@ -165,6 +198,30 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static TCPSegment_t *xTCPWindowRxConfirm( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, uint32_t ulLength );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Free a segment that is owned by 'pxWindow->xRxSegments'.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void vTCPWindowRxFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * The received segments are also stored in an AVL tree, sorted on sequence
+ * number, so they can be found in O(log n) time.  The sequence numbers of the
+ * segments in 'xRxSegments' are unique.
+ */
+#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+	static void prvTCPWindowRxTreeInsert( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
+	static void prvTCPWindowRxTreeRemove( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
+	static void prvTCPWindowRxTreeSetHeight( TCPSegment_t *pxNode );
+	static void prvTCPWindowRxTreeRotate( TCPSegment_t **ppxNode, BaseType_t xToTheRight );
+	static void prvTCPWindowRxTreeBalance( TCPSegment_t **ppxNode );
+
+	/* Returns the segment with the lowest sequence number that is equal to
+	or higher than 'ulSequenceNumber'. */
+	static TCPSegment_t *prvTCPWindowRxTreeLowerBound( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
+#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+
 /*
  * FreeRTOS+TCP stores data in circular buffers.  Calculate the next position to
  * store.
@@ -190,13 +247,58 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
 /*
- * A higher Tx block has been acknowledged.  Now iterate through the xWaitQueue
- * to find a possible condition for a FAST retransmission.
+ * All blocks of a SACK option have been processed.  Walk through the TX
+ * scoreboard and queue every segment that is considered lost for a FAST
+ * retransmission.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Out-of-order data was received and stored in [ulFirst, ulLast>.  Merge this
+ * block with the blocks that were reported earlier and prepare a SACK option.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void prvTCPWindowRxSackAdd( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Prepare a SACK option from the blocks that were reported earlier, leaving
+ * out the blocks that have been passed to the user in the mean time.
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst );
+	static void prvTCPWindowRxSackOptions( TCPWindow_t *pxWindow );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Congestion control: set the initial congestion window, let it grow when new
+ * data has been acknowledged, and shrink it when a loss has been detected,
+ * either by a fast retransmission or by a retransmission time-out.
+ */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow );
+	static void prvTCPCongestionOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static void prvTCPCongestionOnLoss( TCPWindow_t *pxWindow, BaseType_t xIsTimeout );
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+
+/*
+ * Return the RTO for a segment that has been sent 'ulTransmitCount' times,
+ * using exponential back-off.
+ */
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	static uint32_t prvTCPWindowRetransmitTime( const TCPWindow_t *pxWindow, uint32_t ulTransmitCount );
+#endif
+
+/*
+ * CUBIC: return the new congestion window, based on the time elapsed since the
+ * last reduction.
+ */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 ) && ( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+	static uint32_t prvTCPCubicAvoidance( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static uint32_t prvCubeRoot( uint64_t ullValue );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* TCP segment pool. */
@@ -351,24 +453,269 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 		/* Find a segment with a given sequence number in the list of received
 		segments. */
+		#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		{
+			( void ) pxIterator;
+			( void ) pxEnd;
 
-		pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &pxWindow->xRxSegments );
+			pxSegment = prvTCPWindowRxTreeLowerBound( pxWindow, ulSequenceNumber );
 
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			if( ( pxSegment != NULL ) && ( pxSegment->ulSequenceNumber == ulSequenceNumber ) )
+			{
+				pxReturn = pxSegment;
+			}
+		}
+		#else
 		{
-			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &pxWindow->xRxSegments );
 
-			if( pxSegment->ulSequenceNumber == ulSequenceNumber )
+			for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( const ListItem_t * ) pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
 			{
-				pxReturn = pxSegment;
-				break;
+				pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+
+				if( pxSegment->ulSequenceNumber == ulSequenceNumber )
+				{
+					pxReturn = pxSegment;
+					break;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+
+	static TCPSegment_t *prvTCPWindowRxTreeLowerBound( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber )
+	{
+	TCPSegment_t *pxNode = pxWindow->pxRxTree;
+	TCPSegment_t *pxReturn = NULL;
+
+		while( pxNode != NULL )
+		{
+			if( xSequenceGreaterThanOrEqual( pxNode->ulSequenceNumber, ulSequenceNumber ) != pdFALSE )
+			{
+				/* A candidate, but there may be a lower one on the left. */
+				pxReturn = pxNode;
+				pxNode = pxNode->pxRxLeft;
+			}
+			else
+			{
+				pxNode = pxNode->pxRxRight;
 			}
 		}
 
 		return pxReturn;
 	}
+	/*-----------------------------------------------------------*/
+
+	static portINLINE BaseType_t xTCPWindowRxTreeHeight( const TCPSegment_t *pxNode )
+	{
+		return ( pxNode != NULL ) ? pxNode->xRxHeight : 0;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowRxTreeSetHeight( TCPSegment_t *pxNode )
+	{
+	BaseType_t xLeft = xTCPWindowRxTreeHeight( pxNode->pxRxLeft );
+	BaseType_t xRight = xTCPWindowRxTreeHeight( pxNode->pxRxRight );
+
+		pxNode->xRxHeight = ( ( xLeft > xRight ) ? xLeft : xRight ) + 1;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowRxTreeRotate( TCPSegment_t **ppxNode, BaseType_t xToTheRight )
+	{
+	TCPSegment_t *pxNode = *ppxNode;
+	TCPSegment_t *pxChild;
+
+		/* The child on the opposite side takes the place of 'pxNode'. */
+		if( xToTheRight != pdFALSE )
+		{
+			pxChild = pxNode->pxRxLeft;
+			pxNode->pxRxLeft = pxChild->pxRxRight;
+			pxChild->pxRxRight = pxNode;
+		}
+		else
+		{
+			pxChild = pxNode->pxRxRight;
+			pxNode->pxRxRight = pxChild->pxRxLeft;
+			pxChild->pxRxLeft = pxNode;
+		}
+
+		prvTCPWindowRxTreeSetHeight( pxNode );
+		prvTCPWindowRxTreeSetHeight( pxChild );
+		*ppxNode = pxChild;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowRxTreeBalance( TCPSegment_t **ppxNode )
+	{
+	TCPSegment_t *pxNode = *ppxNode;
+	BaseType_t xLeft = xTCPWindowRxTreeHeight( pxNode->pxRxLeft );
+	BaseType_t xRight = xTCPWindowRxTreeHeight( pxNode->pxRxRight );
+
+		/* A subtree of this node has changed.  If the heights of its
+		subtrees differ by more than 1, do one or two rotations. */
+		if( xLeft > ( xRight + 1 ) )
+		{
+			if( xTCPWindowRxTreeHeight( pxNode->pxRxLeft->pxRxLeft ) < xTCPWindowRxTreeHeight( pxNode->pxRxLeft->pxRxRight ) )
+			{
+				prvTCPWindowRxTreeRotate( &( pxNode->pxRxLeft ), pdFALSE );
+			}
+			prvTCPWindowRxTreeRotate( ppxNode, pdTRUE );
+		}
+		else if( xRight > ( xLeft + 1 ) )
+		{
+			if( xTCPWindowRxTreeHeight( pxNode->pxRxRight->pxRxRight ) < xTCPWindowRxTreeHeight( pxNode->pxRxRight->pxRxLeft ) )
+			{
+				prvTCPWindowRxTreeRotate( &( pxNode->pxRxRight ), pdTRUE );
+			}
+			prvTCPWindowRxTreeRotate( ppxNode, pdFALSE );
+		}
+		else
+		{
+			prvTCPWindowRxTreeSetHeight( pxNode );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowRxTreeInsert( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
+	{
+	TCPSegment_t **ppxPath[ winRX_TREE_MAX_DEPTH ];
+	TCPSegment_t **ppxNode = &( pxWindow->pxRxTree );
+	UBaseType_t uxDepth = 0u;
+
+		/* Descend to the place where the segment must be stored, and remember
+		the path so it can be re-balanced bottom-up. */
+		while( *ppxNode != NULL )
+		{
+			configASSERT( uxDepth < winRX_TREE_MAX_DEPTH );
+			ppxPath[ uxDepth++ ] = ppxNode;
+
+			if( xSequenceLessThan( pxSegment->ulSequenceNumber, ( *ppxNode )->ulSequenceNumber ) != pdFALSE )
+			{
+				ppxNode = &( ( *ppxNode )->pxRxLeft );
+			}
+			else
+			{
+				ppxNode = &( ( *ppxNode )->pxRxRight );
+			}
+		}
+
+		pxSegment->pxRxLeft = NULL;
+		pxSegment->pxRxRight = NULL;
+		pxSegment->xRxHeight = 1;
+		*ppxNode = pxSegment;
+
+		while( uxDepth > 0u )
+		{
+			uxDepth--;
+			prvTCPWindowRxTreeBalance( ppxPath[ uxDepth ] );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowRxTreeRemove( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
+	{
+	TCPSegment_t **ppxPath[ winRX_TREE_MAX_DEPTH ];
+	TCPSegment_t **ppxNode = &( pxWindow->pxRxTree );
+	TCPSegment_t **ppxNext;
+	TCPSegment_t *pxNext;
+	UBaseType_t uxDepth = 0u, uxReplaced;
+
+		while( ( *ppxNode != NULL ) && ( *ppxNode != pxSegment ) )
+		{
+			configASSERT( uxDepth < winRX_TREE_MAX_DEPTH );
+			ppxPath[ uxDepth++ ] = ppxNode;
+
+			if( xSequenceLessThan( pxSegment->ulSequenceNumber, ( *ppxNode )->ulSequenceNumber ) != pdFALSE )
+			{
+				ppxNode = &( ( *ppxNode )->pxRxLeft );
+			}
+			else
+			{
+				ppxNode = &( ( *ppxNode )->pxRxRight );
+			}
+		}
+
+		if( *ppxNode != NULL )
+		{
+			if( pxSegment->pxRxLeft == NULL )
+			{
+				*ppxNode = pxSegment->pxRxRight;
+			}
+			else if( pxSegment->pxRxRight == NULL )
+			{
+				*ppxNode = pxSegment->pxRxLeft;
+			}
+			else
+			{
+				/* The segment has two children: it will be replaced by the
+				segment that follows it, the left-most node of its right
+				subtree. */
+				ppxPath[ uxDepth++ ] = ppxNode;
+				uxReplaced = uxDepth;
+
+				ppxNext = &( pxSegment->pxRxRight );
+				while( ( *ppxNext )->pxRxLeft != NULL )
+				{
+					configASSERT( uxDepth < winRX_TREE_MAX_DEPTH );
+					ppxPath[ uxDepth++ ] = ppxNext;
+					ppxNext = &( ( *ppxNext )->pxRxLeft );
+				}
+
+				pxNext = *ppxNext;
+				*ppxNext = pxNext->pxRxRight;
+				pxNext->pxRxLeft = pxSegment->pxRxLeft;
+				pxNext->pxRxRight = pxSegment->pxRxRight;
+				pxNext->xRxHeight = pxSegment->xRxHeight;
+				*ppxNode = pxNext;
+
+				if( uxDepth > uxReplaced )
+				{
+					/* The path went through the right child of the removed
+					segment, which now belongs to its replacement. */
+					ppxPath[ uxReplaced ] = &( pxNext->pxRxRight );
+				}
+			}
+
+			pxSegment->pxRxLeft = NULL;
+			pxSegment->pxRxRight = NULL;
+
+			while( uxDepth > 0u )
+			{
+				uxDepth--;
+				prvTCPWindowRxTreeBalance( ppxPath[ uxDepth ] );
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void vTCPWindowRxFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
+	{
+		#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		{
+			prvTCPWindowRxTreeRemove( pxWindow, pxSegment );
+		}
+		#else
+		{
+			( void ) pxWindow;
+		}
+		#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+
+		vTCPWindowFree( pxSegment );
+	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
@@ -405,6 +752,16 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			/* Add it to either the connections' Rx or Tx queue. */
 			vListInsertFifo( xIsForRx ? &pxWindow->xRxSegments : &pxWindow->xTxSegments, pxItem );
 
+			#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+			{
+				if( xIsForRx != pdFALSE )
+				{
+					pxSegment->ulSequenceNumber = ulSequenceNumber;
+					prvTCPWindowRxTreeInsert( pxWindow, pxSegment );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+
 			/* And set the segment's timer to zero */
 			vTCPTimerSet( &pxSegment->xTransmitTimer );
 
@@ -580,6 +937,13 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 				}
 			}
 		}
+
+		#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		{
+			/* All Rx segments have been returned to the pool. */
+			pxWindow->pxRxTree = NULL;
+		}
+		#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
 	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -599,6 +963,11 @@ void vTCPWindowCreate( TCPWindow_t *pxWindow, uint32_t ulRxWindowLength,
 
 		vListInitialise( &pxWindow->xTxSegments );
 		vListInitialise( &pxWindow->xRxSegments );
+		#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		{
+			pxWindow->pxRxTree = NULL;
+		}
+		#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
 
 		vListInitialise( &pxWindow->xPriorityQueue );			/* Priority queue: segments which must be sent immediately */
 		vListInitialise( &pxWindow->xTxQueue   );			/* Transmit queue: segments queued for transmission */
@@ -644,11 +1013,24 @@ const int32_t l500ms = 500;
 	{
 		pxWindow->xTxSegment.lMaxLength = ( int32_t ) pxWindow->usMSS;
 	}
+	#else
+	{
+		/* No SACK blocks have been reported yet. */
+		pxWindow->ucSackBlockCount = 0u;
+	}
 	#endif /* ipconfigUSE_TCP_WIN == 1 */
 
 	/*Start with a timeout of 2 * 500 ms (1 sec). */
 	pxWindow->lSRTT = l500ms;
 
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		/* Until the first RTT has been measured, the RTO is 1 second. */
+		pxWindow->lRTTVAR = 0;
+		pxWindow->lRTO = winRTO_INITIAL_mS;
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 	/* Just for logging, to print relative sequence numbers. */
 	pxWindow->rx.ulFirstSequenceNumber = ulAckNumber;
 
@@ -670,6 +1052,12 @@ const int32_t l500ms = 500;
 	/* The right-hand side of the transmit window. */
 	pxWindow->tx.ulHighestSequenceNumber = ulSequenceNumber;
 	pxWindow->ulOurSequenceNumber = ulSequenceNumber;
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+	{
+		prvTCPCongestionInit( pxWindow );
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
 }
 /*-----------------------------------------------------------*/
 
@@ -723,25 +1111,43 @@ const int32_t l500ms = 500;
 		the next RX segment should have a sequence number equal to
 		'(ulSequenceNumber+ulLength)'. */
 
-		/* Iterate through all RX segments that are stored: */
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
 		{
-			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
-			/* And see if there is a segment for which:
-			'ulSequenceNumber' <= 'pxSegment->ulSequenceNumber' < 'ulNextSequenceNumber'
-			If there are more matching segments, the one with the lowest sequence number
-			shall be taken */
-			if( ( xSequenceGreaterThanOrEqual( pxSegment->ulSequenceNumber, ulSequenceNumber ) != 0 ) &&
-				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulNextSequenceNumber ) != 0 ) )
-			{
-				if( ( pxBest == NULL ) || ( xSequenceLessThan( pxSegment->ulSequenceNumber, pxBest->ulSequenceNumber ) != 0 ) )
+			( void ) pxIterator;
+			( void ) pxEnd;
+
+			/* The tree gives the lowest sequence number that is equal to or
+			higher than 'ulSequenceNumber'. */
+			pxSegment = prvTCPWindowRxTreeLowerBound( pxWindow, ulSequenceNumber );
+
+			if( ( pxSegment != NULL ) && ( xSequenceLessThan( pxSegment->ulSequenceNumber, ulNextSequenceNumber ) != 0 ) )
+			{
+				pxBest = pxSegment;
+			}
+		}
+		#else
+		{
+			/* Iterate through all RX segments that are stored: */
+			for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+				 pxIterator != ( const ListItem_t * ) pxEnd;
+				 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+			{
+				pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+				/* And see if there is a segment for which:
+				'ulSequenceNumber' <= 'pxSegment->ulSequenceNumber' < 'ulNextSequenceNumber'
+				If there are more matching segments, the one with the lowest sequence number
+				shall be taken */
+				if( ( xSequenceGreaterThanOrEqual( pxSegment->ulSequenceNumber, ulSequenceNumber ) != 0 ) &&
+					( xSequenceLessThan( pxSegment->ulSequenceNumber, ulNextSequenceNumber ) != 0 ) )
 				{
-					pxBest = pxSegment;
+					if( ( pxBest == NULL ) || ( xSequenceLessThan( pxSegment->ulSequenceNumber, pxBest->ulSequenceNumber ) != 0 ) )
+					{
+						pxBest = pxSegment;
+					}
 				}
 			}
 		}
+		#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
 
 		if( ( pxBest != NULL ) &&
 			( ( pxBest->ulSequenceNumber != ulSequenceNumber ) || ( pxBest->lDataLength != ( int32_t ) ulLength ) ) )
@@ -816,7 +1222,7 @@ const int32_t l500ms = 500;
                         if ( pxFound != NULL )
                         {
                             /* Remove it because it will be passed to user directly. */
-                            vTCPWindowFree( pxFound );
+                            vTCPWindowRxFree( pxWindow, pxFound );
                         }
                     } while ( pxFound );
 
@@ -828,7 +1234,7 @@ const int32_t l500ms = 500;
 
 						/* As all packet below this one have been passed to the
 						user it can be discarded. */
-						vTCPWindowFree( pxFound );
+						vTCPWindowRxFree( pxWindow, pxFound );
 					}
 
 					if( ulSavedSequenceNumber != ulCurrentSequenceNumber )
@@ -851,6 +1257,13 @@ const int32_t l500ms = 500;
 
 				pxWindow->rx.ulCurrentSequenceNumber = ulCurrentSequenceNumber;
 
+				if( pxWindow->ucSackBlockCount != 0u )
+				{
+					/* As long as data is missing, every ACK must repeat the
+					blocks of out-of-order data which are still stored. */
+					prvTCPWindowRxSackOptions( pxWindow );
+				}
+
 				/* Packet was expected, may be passed directly to the socket
 				buffer or application.  Store the packet at offset 0. */
 				lReturn = 0;
@@ -888,41 +1301,6 @@ const int32_t l500ms = 500;
 			}
 			else
 			{
-				/* See if there is more data in a contiguous block to make the
-				SACK describe a longer range of data. */
-
-				/* TODO: SACK's may also be delayed for a short period
-				 * This is useful because subsequent packets will be SACK'd with
-				 * single one message
-				 */
-				while( ( pxFound = xTCPWindowRxFind( pxWindow, ulLast ) ) != NULL )
-				{
-					ulLast += ( uint32_t ) pxFound->lDataLength;
-				}
-
-				if( xTCPWindowLoggingLevel >= 1 )
-				{
-					FreeRTOS_debug_printf( ( "lTCPWindowRxCheck[%d,%d]: seqnr %lu exp %lu (dist %ld) SACK to %lu\n",
-						pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
-						ulSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
-						ulCurrentSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
-						( BaseType_t ) ( ulSequenceNumber - ulCurrentSequenceNumber ),	/* want this signed */
-						ulLast - pxWindow->rx.ulFirstSequenceNumber ) );
-				}
-
-				/* Now prepare the SACK message.
-				Code OPTION_CODE_SINGLE_SACK already in network byte order. */
-				pxWindow->ulOptionsData[0] = OPTION_CODE_SINGLE_SACK;
-
-				/* First sequence number that we received. */
-				pxWindow->ulOptionsData[1] = FreeRTOS_htonl( ulSequenceNumber );
-
-				/* Last + 1 */
-				pxWindow->ulOptionsData[2] = FreeRTOS_htonl( ulLast );
-
-				/* Which make 12 (3*4) option bytes. */
-				pxWindow->ucOptionLength = 3 * sizeof( pxWindow->ulOptionsData[ 0 ] );
-
 				pxFound = xTCPWindowRxFind( pxWindow, ulSequenceNumber );
 
 				if( pxFound != NULL )
@@ -930,6 +1308,7 @@ const int32_t l500ms = 500;
 					/* This out-of-sequence packet has been received for a
 					second time.  It is already stored but do send a SACK
 					again. */
+					ulLast = ulSequenceNumber + ( uint32_t ) pxFound->lDataLength;
 					lReturn = -1;
 				}
 				else
@@ -938,10 +1317,6 @@ const int32_t l500ms = 500;
 
 					if( pxFound == NULL )
 					{
-						/* Can not send a SACK, because the segment cannot be
-						stored. */
-						pxWindow->ucOptionLength = 0u;
-
 						/* Needs to be stored but there is no segment
 						available. */
 						lReturn = -1;
@@ -961,6 +1336,41 @@ const int32_t l500ms = 500;
 						lReturn = ( int32_t ) ( ulSequenceNumber - ulCurrentSequenceNumber );
 					}
 				}
+
+				if( pxFound != NULL )
+				{
+					/* See if there is more data in a contiguous block to make
+					the SACK describe a longer range of data. */
+
+					/* TODO: SACK's may also be delayed for a short period
+					 * This is useful because subsequent packets will be SACK'd with
+					 * single one message
+					 */
+					while( ( pxFound = xTCPWindowRxFind( pxWindow, ulLast ) ) != NULL )
+					{
+						ulLast += ( uint32_t ) pxFound->lDataLength;
+					}
+
+					if( xTCPWindowLoggingLevel >= 1 )
+					{
+						FreeRTOS_debug_printf( ( "lTCPWindowRxCheck[%d,%d]: seqnr %lu exp %lu (dist %ld) SACK to %lu\n",
+							pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
+							ulSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
+							ulCurrentSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
+							( BaseType_t ) ( ulSequenceNumber - ulCurrentSequenceNumber ),	/* want this signed */
+							ulLast - pxWindow->rx.ulFirstSequenceNumber ) );
+					}
+
+					/* Now prepare the SACK message, the new block comes
+					first. */
+					prvTCPWindowRxSackAdd( pxWindow, ulSequenceNumber, ulLast );
+				}
+				else
+				{
+					/* This segment can not be reported because it was not
+					stored, but the blocks received earlier can. */
+					prvTCPWindowRxSackOptions( pxWindow );
+				}
 			}
 		}
 
@@ -970,41 +1380,153 @@ const int32_t l500ms = 500;
 #endif /* ipconfgiUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
-/*=============================================================================
- *
- *                    #########   #    #
- *                    #   #   #   #    #
- *                        #       #    #
- *                        #        ####
- *                        #         ##
- *                        #        ####
- *                        #       #    #
- *                        #       #    #
- *                      #####     #    #
- *
- * Tx functions
- *
- *=============================================================================*/
-
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static int32_t lTCPIncrementTxPosition( int32_t lPosition, int32_t lMax, int32_t lCount )
+	static void prvTCPWindowRxSackAdd( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast )
 	{
-		/* +TCP stores data in circular buffers.  Calculate the next position to
-		store. */
-		lPosition += lCount;
-		if( lPosition >= lMax )
+	uint32_t ulKept[ 2u * ( ipTCP_MAX_SACK_BLOCKS - 1u ) ];
+	uint32_t ulBlockFirst, ulBlockLast;
+	UBaseType_t uxIndex, uxCount = 0u;
+
+		/* The first block of a SACK must describe the data that triggered it
+		(RFC 2018).  Earlier blocks which touch or overlap the new block are
+		merged into it, the others are repeated after it, most recent first. */
+		for( uxIndex = 0u; uxIndex < ( UBaseType_t ) pxWindow->ucSackBlockCount; uxIndex++ )
 		{
-			lPosition -= lMax;
-		}
-
-		return lPosition;
-	}
-
-#endif /* ipconfigUSE_TCP_WIN == 1 */
-/*-----------------------------------------------------------*/
+			ulBlockFirst = pxWindow->ulSackBlocks[ 2u * uxIndex ];
+			ulBlockLast = pxWindow->ulSackBlocks[ ( 2u * uxIndex ) + 1u ];
 
-#if( ipconfigUSE_TCP_WIN == 1 )
+			if( ( xSequenceLessThanOrEqual( ulBlockFirst, ulLast ) != pdFALSE ) &&
+				( xSequenceLessThanOrEqual( ulFirst, ulBlockLast ) != pdFALSE ) )
+			{
+				if( xSequenceLessThan( ulBlockFirst, ulFirst ) != pdFALSE )
+				{
+					ulFirst = ulBlockFirst;
+				}
+
+				if( xSequenceGreaterThan( ulBlockLast, ulLast ) != pdFALSE )
+				{
+					ulLast = ulBlockLast;
+				}
+			}
+			else if( uxCount < ( ipTCP_MAX_SACK_BLOCKS - 1u ) )
+			{
+				ulKept[ 2u * uxCount ] = ulBlockFirst;
+				ulKept[ ( 2u * uxCount ) + 1u ] = ulBlockLast;
+				uxCount++;
+			}
+			else
+			{
+				/* The oldest block will not be reported anymore. */
+			}
+		}
+
+		pxWindow->ulSackBlocks[ 0 ] = ulFirst;
+		pxWindow->ulSackBlocks[ 1 ] = ulLast;
+		memcpy( &( pxWindow->ulSackBlocks[ 2 ] ), ulKept, 2u * uxCount * sizeof( ulKept[ 0 ] ) );
+		pxWindow->ucSackBlockCount = ( uint8_t ) ( uxCount + 1u );
+
+		prvTCPWindowRxSackOptions( pxWindow );
+	}
+
+#endif /* ipconfgiUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvTCPWindowRxSackOptions( TCPWindow_t *pxWindow )
+	{
+	uint32_t ulCurrentSequenceNumber = pxWindow->rx.ulCurrentSequenceNumber;
+	uint32_t ulFirst, ulLast;
+	UBaseType_t uxIndex, uxCount = 0u;
+	UBaseType_t uxMaxBlocks = ( UBaseType_t ) winSACK_MAX_BLOCKS( pxWindow );
+
+		for( uxIndex = 0u; uxIndex < ( UBaseType_t ) pxWindow->ucSackBlockCount; uxIndex++ )
+		{
+			ulFirst = pxWindow->ulSackBlocks[ 2u * uxIndex ];
+			ulLast = pxWindow->ulSackBlocks[ ( 2u * uxIndex ) + 1u ];
+
+			/* Drop the blocks that have been passed to the user in the mean
+			time. */
+			if( xSequenceGreaterThan( ulLast, ulCurrentSequenceNumber ) != pdFALSE )
+			{
+				if( xSequenceLessThan( ulFirst, ulCurrentSequenceNumber ) != pdFALSE )
+				{
+					ulFirst = ulCurrentSequenceNumber;
+				}
+
+				pxWindow->ulSackBlocks[ 2u * uxCount ] = ulFirst;
+				pxWindow->ulSackBlocks[ ( 2u * uxCount ) + 1u ] = ulLast;
+				uxCount++;
+			}
+		}
+
+		pxWindow->ucSackBlockCount = ( uint8_t ) uxCount;
+
+		if( uxCount > uxMaxBlocks )
+		{
+			uxCount = uxMaxBlocks;
+		}
+
+		if( uxCount == 0u )
+		{
+			pxWindow->ucOptionLength = 0u;
+		}
+		else
+		{
+			/* Code OPTION_CODE_SACK() is already in network byte order. */
+			pxWindow->ulOptionsData[ 0 ] = OPTION_CODE_SACK( uxCount );
+
+			for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+			{
+				/* First sequence number that we received, and last + 1. */
+				pxWindow->ulOptionsData[ ( 2u * uxIndex ) + 1u ] = FreeRTOS_htonl( pxWindow->ulSackBlocks[ 2u * uxIndex ] );
+				pxWindow->ulOptionsData[ ( 2u * uxIndex ) + 2u ] = FreeRTOS_htonl( pxWindow->ulSackBlocks[ ( 2u * uxIndex ) + 1u ] );
+			}
+
+			/* Which makes 4 option bytes plus 8 for each block. */
+			pxWindow->ucOptionLength = ( uint8_t ) ( ( 1u + ( 2u * uxCount ) ) * sizeof( pxWindow->ulOptionsData[ 0 ] ) );
+		}
+	}
+
+#endif /* ipconfgiUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+/*=============================================================================
+ *
+ *                    #########   #    #
+ *                    #   #   #   #    #
+ *                        #       #    #
+ *                        #        ####
+ *                        #         ##
+ *                        #        ####
+ *                        #       #    #
+ *                        #       #    #
+ *                      #####     #    #
+ *
+ * Tx functions
+ *
+ *=============================================================================*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static int32_t lTCPIncrementTxPosition( int32_t lPosition, int32_t lMax, int32_t lCount )
+	{
+		/* +TCP stores data in circular buffers.  Calculate the next position to
+		store. */
+		lPosition += lCount;
+		if( lPosition >= lMax )
+		{
+			lPosition -= lMax;
+		}
+
+		return lPosition;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
 
 	int32_t lTCPWindowTxAdd( TCPWindow_t *pxWindow, uint32_t ulLength, int32_t lPosition, int32_t lMax )
 	{
@@ -1187,6 +1709,17 @@ const int32_t l500ms = 500;
 			{
 				xHasSpace = pdFALSE;
 			}
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+			{
+				/* The congestion window limits the outstanding data in the
+				same way, but it is adapted to the losses that occurred. */
+				if( ( ulTxOutstanding != 0UL ) && ( pxWindow->xCongestion.ulCongestionWindow < ulTxOutstanding + ( ( uint32_t ) pxSegment->lDataLength ) ) )
+				{
+					xHasSpace = pdFALSE;
+				}
+			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
 		}
 
 		return xHasSpace;
@@ -1225,7 +1758,7 @@ const int32_t l500ms = 500;
 				/* After a packet has been sent for the first time, it will wait
 				'1 * lSRTT' ms for an ACK. A second time it will wait '2 * lSRTT' ms,
 				each time doubling the time-out */
-				ulMaxAge = ( 1u << pxSegment->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+				ulMaxAge = winRETRANSMIT_TIME( pxWindow, pxSegment->u.bits.ucTransmitCount );
 
 				if( ulMaxAge > ulAge )
 				{
@@ -1297,7 +1830,7 @@ const int32_t l500ms = 500;
 			if( pxSegment != NULL )
 			{
 				/* Do check the timing. */
-				ulMaxTime = ( 1u << pxSegment->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+				ulMaxTime = winRETRANSMIT_TIME( pxWindow, pxSegment->u.bits.ucTransmitCount );
 
 				if( ulTimerGetAge( &pxSegment->xTransmitTimer ) > ulMaxTime )
 				{
@@ -1306,6 +1839,12 @@ const int32_t l500ms = 500;
 					pxSegment = xTCPWindowGetHead( &( pxWindow->xWaitQueue ) );
 					pxSegment->u.bits.ucDupAckCount = pdFALSE_UNSIGNED;
 
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+					{
+						prvTCPCongestionOnLoss( pxWindow, pdTRUE );
+					}
+					#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+
 					/* Some detailed logging. */
 					if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != 0 ) )
 					{
@@ -1409,17 +1948,23 @@ const int32_t l500ms = 500;
 			( pxSegment->u.bits.ucTransmitCount )++;
 
 			/* If there have been several retransmissions (4), decrease the
-			size of the transmission window to at most 2 times MSS. */
-			if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
+			size of the transmission window to at most 2 times MSS.  When
+			congestion control is used, the congestion window has already
+			been reduced, and it will be able to grow again. */
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 0 )
 			{
-				if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
+				if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
 				{
-					FreeRTOS_debug_printf( ( "ulTCPWindowTxGet[%u - %d]: Change Tx window: %lu -> %u\n",
-						pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
-						pxWindow->xSize.ulTxWindowLength, 2 * pxWindow->usMSS ) );
-					pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
+					if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
+					{
+						FreeRTOS_debug_printf( ( "ulTCPWindowTxGet[%u - %d]: Change Tx window: %lu -> %u\n",
+							pxWindow->usPeerPortNumber, pxWindow->usOurPortNumber,
+							pxWindow->xSize.ulTxWindowLength, 2 * pxWindow->usMSS ) );
+						pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
+					}
 				}
 			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 0 */
 
 			/* Clear the transmit timer. */
 			vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
@@ -1528,26 +2073,51 @@ const int32_t l500ms = 500;
 				{
 					int32_t mS = ( int32_t ) ulTimerGetAge( &( pxSegment->xTransmitTimer ) );
 
-					if( pxWindow->lSRTT >= mS )
+					#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
 					{
-						/* RTT becomes smaller: adapt slowly. */
-						pxWindow->lSRTT = ( ( winSRTT_DECREMENT_NEW * mS ) + ( winSRTT_DECREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_DECREMENT_NEW + winSRTT_DECREMENT_CURRENT );
+						/* When the peer echoes time-stamps, every ACK gives
+						an RTT sample, see vTCPWindowRTTSample(). */
+						if( pxWindow->u.bits.bTimeStamps == pdFALSE_UNSIGNED )
+						{
+							vTCPWindowRTTSample( pxWindow, ( uint32_t ) mS );
+						}
 					}
-					else
+					#else
 					{
-						/* RTT becomes larger: adapt quicker */
-						pxWindow->lSRTT = ( ( winSRTT_INCREMENT_NEW * mS ) + ( winSRTT_INCREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_INCREMENT_NEW + winSRTT_INCREMENT_CURRENT );
-					}
+						if( pxWindow->lSRTT >= mS )
+						{
+							/* RTT becomes smaller: adapt slowly. */
+							pxWindow->lSRTT = ( ( winSRTT_DECREMENT_NEW * mS ) + ( winSRTT_DECREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_DECREMENT_NEW + winSRTT_DECREMENT_CURRENT );
+						}
+						else
+						{
+							/* RTT becomes larger: adapt quicker */
+							pxWindow->lSRTT = ( ( winSRTT_INCREMENT_NEW * mS ) + ( winSRTT_INCREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_INCREMENT_NEW + winSRTT_INCREMENT_CURRENT );
+						}
 
-					/* Cap to the minimum of 50ms. */
-					if( pxWindow->lSRTT < winSRTT_CAP_mS )
-					{
-						pxWindow->lSRTT = winSRTT_CAP_mS;
+						/* Cap to the minimum of 50ms. */
+						if( pxWindow->lSRTT < winSRTT_CAP_mS )
+						{
+							pxWindow->lSRTT = winSRTT_CAP_mS;
+						}
 					}
+					#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 				}
 
 				/* Unlink it from the 3 queues, but do not destroy it (yet). */
 				xDoUnlink = pdTRUE;
+
+				#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+				{
+					/* During fast recovery, every segment that is selectively
+					acknowledged has left the network: inflate the congestion
+					window so that new data may be sent. */
+					if( ( pxWindow->xCongestion.xInRecovery != pdFALSE ) && ( ulSequenceNumber != pxWindow->tx.ulCurrentSequenceNumber ) )
+					{
+						pxWindow->xCongestion.ulCongestionWindow += ulDataLength;
+					}
+				}
+				#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
 			}
 
 			/* pxSegment->u.bits.bAcked is now true.  Is it located at the left
@@ -1592,44 +2162,89 @@ const int32_t l500ms = 500;
 
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst )
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow )
 	{
 	const ListItem_t *pxIterator;
 	const MiniListItem_t* pxEnd;
 	TCPSegment_t *pxSegment;
 	uint32_t ulCount = 0UL;
+	uint32_t ulSackedBytes = 0UL;
+	UBaseType_t uxSackedSegments = 0u;
+	const uint32_t ulLostThreshold = ( DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT - 1u ) * ( uint32_t ) pxWindow->usMSS;
+
+		/* All blocks of a SACK have been processed.  xTxSegments is a
+		scoreboard of the outstanding data: it is sorted on sequence number
+		and segments that were selectively acknowledged have 'bAcked' set.
+		First count the data that has been SACK'd. */
+		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xTxSegments ) );
 
-		/* A higher Tx block has been acknowledged.  Now iterate through the
-		 xWaitQueue to find a possible condition for a FAST retransmission. */
+		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
 
-		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xWaitQueue ) );
+			if( pxSegment->u.bits.bAcked != pdFALSE_UNSIGNED )
+			{
+				ulSackedBytes += ( uint32_t ) pxSegment->lDataLength;
+				uxSackedSegments++;
+			}
+		}
 
+		/* Now visit every hole below the highest SACK'd segment, in a single
+		pass, while keeping track of the amount of SACK'd data above it. */
 		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd; )
+			 ( pxIterator != ( const ListItem_t * ) pxEnd ) && ( uxSackedSegments != 0u ); )
 		{
 			/* Get the owner, which is a TCP segment. */
 			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
 
-			/* Hop to the next item before the current gets unlinked. */
+			/* Hop to the next item before the current gets re-queued. */
 			pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator );
 
+			if( pxSegment->u.bits.bAcked != pdFALSE_UNSIGNED )
+			{
+				ulSackedBytes -= ( uint32_t ) pxSegment->lDataLength;
+				uxSackedSegments--;
+				continue;
+			}
+
+			/* Only look at segments that were sent and are waiting for an
+			ACK.  A 'ucDupAckCount' of DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT
+			means that it has been fast-retransmitted already, it will be
+			cleared when the segment is retransmitted after a time-out. */
+			if( ( listLIST_ITEM_CONTAINER( &( pxSegment->xQueueItem ) ) != &( pxWindow->xWaitQueue ) ) ||
+				( pxSegment->u.bits.ucDupAckCount >= DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
+			{
+				continue;
+			}
+
 			/* Fast retransmission:
-			When 3 packets with a higher sequence number have been acknowledged
-			by the peer, it is very unlikely a current packet will ever arrive.
-			It will be retransmitted far before the RTO. */
-			if( ( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED ) &&
-				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE ) &&
-				( ++( pxSegment->u.bits.ucDupAckCount ) == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
+			A hole is considered lost when 3 SACK's reported data beyond it, or
+			when 3 segments, or more than 2 * MSS bytes above it have been
+			SACK'd (RFC 6675).  It is very unlikely that the hole will still
+			be filled, so it will be retransmitted far before the RTO. */
+			pxSegment->u.bits.ucDupAckCount++;
+
+			if( ( pxSegment->u.bits.ucDupAckCount >= DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) ||
+				( uxSackedSegments >= ( UBaseType_t ) DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) ||
+				( ulSackedBytes > ulLostThreshold ) )
 			{
 				pxSegment->u.bits.ucTransmitCount = pdFALSE_UNSIGNED;
+				pxSegment->u.bits.ucDupAckCount = DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT;
+
+				if( ulCount == 0UL )
+				{
+					/* A new round of SACK-based recovery. */
+					pxWindow->ulSackRecoveryCount++;
+				}
 
-				/* Not clearing 'ucDupAckCount' yet as more SACK's might come in
-				which might lead to a second fast rexmit. */
 				if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
 				{
-					FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu < %lu\n",
+					FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu (%lu bytes SACK'd above, recovery %lu)\n",
 						pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber,
-						ulFirst - pxWindow->tx.ulFirstSequenceNumber ) );
+						ulSackedBytes,
+						pxWindow->ulSackRecoveryCount ) );
 					FreeRTOS_flush_logging( );
 				}
 
@@ -1665,6 +2280,15 @@ const int32_t l500ms = 500;
 		else
 		{
 			ulReturn = prvTCPWindowTxCheckAck( pxWindow, ulFirstSequence, ulSequenceNumber );
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+			{
+				if( ulReturn != 0UL )
+				{
+					prvTCPCongestionOnAck( pxWindow, ulReturn );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
 		}
 
 		return ulReturn;
@@ -1680,9 +2304,18 @@ const int32_t l500ms = 500;
 	uint32_t ulAckCount = 0UL;
 	uint32_t ulCurrentSequenceNumber = pxWindow->tx.ulCurrentSequenceNumber;
 
-		/* Receive a SACK option. */
+		/* Receive a single block of a SACK option.  The holes will be looked
+		for in ulTCPWindowTxSackComplete(), once all blocks are known. */
 		ulAckCount = prvTCPWindowTxCheckAck( pxWindow, ulFirst, ulLast );
-		prvTCPWindowFastRetransmit( pxWindow, ulFirst );
+
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+		{
+			if( ulAckCount != 0UL )
+			{
+				prvTCPCongestionOnAck( pxWindow, ulAckCount );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
 
 		if( ( xTCPWindowLoggingLevel >= 1 ) && ( xSequenceGreaterThan( ulFirst, ulCurrentSequenceNumber ) != pdFALSE ) )
 		{
@@ -1701,6 +2334,448 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	uint32_t ulTCPWindowTxSackComplete( TCPWindow_t *pxWindow )
+	{
+	uint32_t ulRetransmitCount;
+
+		ulRetransmitCount = prvTCPWindowFastRetransmit( pxWindow );
+
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+		{
+			if( ulRetransmitCount != 0UL )
+			{
+				prvTCPCongestionOnLoss( pxWindow, pdFALSE );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+
+		return ulRetransmitCount;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+
+	void vTCPWindowTxRebase( TCPWindow_t *pxWindow, int32_t lOldTail, int32_t lOldLength )
+	{
+	const ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &pxWindow->xTxSegments );
+	TCPSegment_t *pxSegment;
+
+		/* The contents of the TX stream have been copied to a new stream, where
+		the byte at 'lOldTail' is now stored at position 0.  All segments are
+		found in xTxSegments, including the ones that are being filled. */
+		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		{
+			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			pxSegment->lStreamPos -= lOldTail;
+
+			if( pxSegment->lStreamPos < 0 )
+			{
+				pxSegment->lStreamPos += lOldLength;
+			}
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+
+	void vTCPWindowRTTSample( TCPWindow_t *pxWindow, uint32_t ulRTT )
+	{
+	int32_t lRTT, lDelta;
+
+		/* Samples that are larger than the maximum RTO can not be right. */
+		if( ulRTT <= ( uint32_t ) winRTO_MAX_mS )
+		{
+			lRTT = ( int32_t ) ulRTT;
+
+			if( pxWindow->u.bits.bRTTMeasured == pdFALSE_UNSIGNED )
+			{
+				/* The first measurement. */
+				pxWindow->lSRTT = lRTT;
+				pxWindow->lRTTVAR = lRTT / 2;
+				pxWindow->u.bits.bRTTMeasured = pdTRUE_UNSIGNED;
+			}
+			else
+			{
+				/* RTTVAR = 3/4 * RTTVAR + 1/4 * | SRTT - R |
+				SRTT = 7/8 * SRTT + 1/8 * R */
+				lDelta = pxWindow->lSRTT - lRTT;
+
+				if( lDelta < 0 )
+				{
+					lDelta = -lDelta;
+				}
+
+				pxWindow->lRTTVAR = ( ( 3 * pxWindow->lRTTVAR ) + lDelta ) / 4;
+				pxWindow->lSRTT = ( ( 7 * pxWindow->lSRTT ) + lRTT ) / 8;
+			}
+
+			/* RTO = SRTT + max( G, 4 * RTTVAR ), where the clock granularity G
+			is one clock tick. */
+			pxWindow->lRTO = pxWindow->lSRTT + FreeRTOS_max_int32( ( int32_t ) portTICK_PERIOD_MS, 4 * pxWindow->lRTTVAR );
+
+			if( pxWindow->lRTO < winRTO_MIN_mS )
+			{
+				pxWindow->lRTO = winRTO_MIN_mS;
+			}
+			else if( pxWindow->lRTO > winRTO_MAX_mS )
+			{
+				pxWindow->lRTO = winRTO_MAX_mS;
+			}
+			else
+			{
+				/* The RTO is within its limits. */
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+
+	static uint32_t prvTCPWindowRetransmitTime( const TCPWindow_t *pxWindow, uint32_t ulTransmitCount )
+	{
+	uint32_t ulTime = ( uint32_t ) pxWindow->lRTO;
+	uint32_t ulCount;
+
+		/* The first transmission waits one RTO, every retransmission doubles
+		the time-out, up to the maximum of winRTO_MAX_mS. */
+		for( ulCount = 1u; ( ulCount < ulTransmitCount ) && ( ulTime < ( uint32_t ) winRTO_MAX_mS ); ulCount++ )
+		{
+			ulTime <<= 1;
+		}
+
+		return FreeRTOS_min_uint32( ulTime, ( uint32_t ) winRTO_MAX_mS );
+	}
+
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		memset( pxCongestion, '\0', sizeof( *pxCongestion ) );
+
+		/* The initial window as proposed in RFC 3390:
+		min( 4 * MSS, max( 2 * MSS, 4380 ) ). */
+		pxCongestion->ulCongestionWindow = FreeRTOS_min_uint32( 4UL * ulMSS, FreeRTOS_max_uint32( 2UL * ulMSS, 4380UL ) );
+		pxCongestion->ulMaxCongestionWindow = pxCongestion->ulCongestionWindow;
+
+		/* Start in slow start until the first loss is detected. */
+		pxCongestion->ulSlowStartThreshold = 0xFFFFFFFFUL;
+		pxCongestion->ulRecoverSequenceNumber = pxWindow->tx.ulCurrentSequenceNumber;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+
+	static void prvTCPCongestionOnAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+	TCPSegment_t *pxSegment;
+
+		/* 'ulBytesAcked' bytes at the left side of the transmission window
+		have been acknowledged. */
+		if( pxCongestion->xInRecovery != pdFALSE )
+		{
+			if( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxCongestion->ulRecoverSequenceNumber ) != pdFALSE )
+			{
+				/* A full acknowledgement: all data that was outstanding when
+				the loss was detected has arrived.  Deflate the window and leave
+				fast recovery. */
+				pxCongestion->ulCongestionWindow = pxCongestion->ulSlowStartThreshold;
+				pxCongestion->xInRecovery = pdFALSE;
+			}
+			else
+			{
+				/* A partial acknowledgement (RFC 6582): the segment which is now
+				at the left side of the window got lost as well.  Retransmit it
+				immediately and deflate the window by the amount of data that
+				was acknowledged. */
+				if( listLIST_IS_EMPTY( &( pxWindow->xTxSegments ) ) == pdFALSE )
+				{
+					pxSegment = ( TCPSegment_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxWindow->xTxSegments ) );
+
+					if( ( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED ) &&
+						( listLIST_ITEM_CONTAINER( &( pxSegment->xQueueItem ) ) == &( pxWindow->xWaitQueue ) ) )
+					{
+						uxListRemove( &( pxSegment->xQueueItem ) );
+						vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxSegment->xQueueItem ) );
+					}
+				}
+
+				pxCongestion->ulCongestionWindow -= FreeRTOS_min_uint32( pxCongestion->ulCongestionWindow, ulBytesAcked );
+
+				if( ulBytesAcked >= ulMSS )
+				{
+					pxCongestion->ulCongestionWindow += ulMSS;
+				}
+
+				pxCongestion->ulCongestionWindow = FreeRTOS_max_uint32( pxCongestion->ulCongestionWindow, ulMSS );
+			}
+		}
+		else
+		{
+			if( pxCongestion->ulCongestionWindow < pxCongestion->ulSlowStartThreshold )
+			{
+				/* Slow start: grow with the number of bytes acknowledged
+				(RFC 3465).  The limit of 2 MSS per ACK is not used, because
+				this stack, like many other peers, sends one ACK for several
+				segments while it is receiving continuously. */
+				pxCongestion->ulCongestionWindow += ulBytesAcked;
+			}
+			else
+			{
+				/* Congestion avoidance. */
+				#if( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+				{
+					pxCongestion->ulCongestionWindow = prvTCPCubicAvoidance( pxWindow, ulBytesAcked );
+				}
+				#else
+				{
+					/* NewReno: grow with one MSS per round-trip, i.e. every time
+					a full window has been acknowledged. */
+					pxCongestion->ulBytesAcked += ulBytesAcked;
+
+					if( pxCongestion->ulBytesAcked >= pxCongestion->ulCongestionWindow )
+					{
+						pxCongestion->ulBytesAcked -= pxCongestion->ulCongestionWindow;
+						pxCongestion->ulCongestionWindow += ulMSS;
+					}
+				}
+				#endif /* ipconfigTCP_CONGESTION_ALGORITHM */
+			}
+
+			/* It is useless to let the window grow beyond the self-imposed
+			limit of the transmission window. */
+			if( ( pxCongestion->ulCongestionWindow > pxWindow->xSize.ulTxWindowLength ) &&
+				( pxWindow->xSize.ulTxWindowLength >= ulMSS ) )
+			{
+				pxCongestion->ulCongestionWindow = pxWindow->xSize.ulTxWindowLength;
+			}
+		}
+
+		if( pxCongestion->ulMaxCongestionWindow < pxCongestion->ulCongestionWindow )
+		{
+			pxCongestion->ulMaxCongestionWindow = pxCongestion->ulCongestionWindow;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+
+	static void prvTCPCongestionOnLoss( TCPWindow_t *pxWindow, BaseType_t xIsTimeout )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+	BaseType_t xNewLoss = pdFALSE;
+
+		/* A segment is being retransmitted, either because the peer reported
+		it missing (fast retransmission) or because its timer expired.  The
+		window will only be reduced once for all data that was outstanding when
+		the loss was detected. */
+		if( ( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxCongestion->ulRecoverSequenceNumber ) != pdFALSE ) &&
+			( ( xIsTimeout != pdFALSE ) || ( pxCongestion->xInRecovery == pdFALSE ) ) )
+		{
+			xNewLoss = pdTRUE;
+
+			#if( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+			{
+				/* CUBIC: remember the window at which the loss occurred.  If
+				it is lower than the previous maximum, another flow is probably
+				competing: release some bandwidth (fast convergence). */
+				if( pxCongestion->ulCongestionWindow < pxCongestion->ulLastMaxWindow )
+				{
+					pxCongestion->ulLastMaxWindow = ( pxCongestion->ulCongestionWindow * ( 10u + winCUBIC_BETA_TENTHS ) ) / 20u;
+				}
+				else
+				{
+					pxCongestion->ulLastMaxWindow = pxCongestion->ulCongestionWindow;
+				}
+
+				pxCongestion->xEpochStarted = pdFALSE;
+				pxCongestion->ulSlowStartThreshold = FreeRTOS_max_uint32( ( pxCongestion->ulCongestionWindow / 10u ) * winCUBIC_BETA_TENTHS, 2UL * ulMSS );
+			}
+			#else
+			{
+			uint32_t ulTxOutstanding;
+
+				/* NewReno: half of the data in flight (RFC 5681). */
+				if( pxWindow->tx.ulHighestSequenceNumber >= pxWindow->tx.ulCurrentSequenceNumber )
+				{
+					ulTxOutstanding = pxWindow->tx.ulHighestSequenceNumber - pxWindow->tx.ulCurrentSequenceNumber;
+				}
+				else
+				{
+					ulTxOutstanding = 0UL;
+				}
+
+				pxCongestion->ulSlowStartThreshold = FreeRTOS_max_uint32( ulTxOutstanding / 2UL, 2UL * ulMSS );
+			}
+			#endif /* ipconfigTCP_CONGESTION_ALGORITHM */
+
+			pxCongestion->ulRecoverSequenceNumber = pxWindow->tx.ulHighestSequenceNumber;
+
+			if( xIsTimeout == pdFALSE )
+			{
+				/* Enter fast recovery.  The segments which caused the fast
+				retransmission have left the network already. */
+				pxCongestion->ulCongestionWindow = pxCongestion->ulSlowStartThreshold + ( DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT * ulMSS );
+				pxCongestion->xInRecovery = pdTRUE;
+				pxCongestion->ulFastRecoveryCount++;
+			}
+
+			if( ( xTCPWindowLoggingLevel >= 1 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPCongestionOnLoss[%u,%u]: %s ssthresh %lu\n",
+					pxWindow->usPeerPortNumber,
+					pxWindow->usOurPortNumber,
+					( xIsTimeout != pdFALSE ) ? "RTO" : "Fast",
+					pxCongestion->ulSlowStartThreshold ) );
+			}
+		}
+
+		/* The other segments that were sent together with the first one that
+		timed out will time out as well, they should not reduce the window once
+		more.  A time-out during fast recovery does end the recovery. */
+		if( ( xIsTimeout != pdFALSE ) &&
+			( ( xNewLoss != pdFALSE ) || ( pxCongestion->xInRecovery != pdFALSE ) ) )
+		{
+			/* After a time-out, start all over with a window of one segment
+			(the loss window). */
+			pxCongestion->ulCongestionWindow = ulMSS;
+			pxCongestion->xInRecovery = pdFALSE;
+			pxCongestion->ulTimeoutCount++;
+		}
+
+		pxCongestion->ulBytesAcked = 0UL;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 ) && ( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+
+	static uint32_t prvCubeRoot( uint64_t ullValue )
+	{
+	uint64_t ullRoot = 0ULL, ullBit;
+	BaseType_t xShift;
+
+		/* Integer cube root, calculated bit by bit. */
+		for( xShift = 63; xShift >= 0; xShift -= 3 )
+		{
+			ullRoot <<= 1;
+			ullBit = ( 3ULL * ullRoot * ( ullRoot + 1ULL ) ) + 1ULL;
+
+			if( ( ullValue >> xShift ) >= ullBit )
+			{
+				ullValue -= ullBit << xShift;
+				ullRoot++;
+			}
+		}
+
+		return ( uint32_t ) ullRoot;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 && ipconfigTCP_CONGESTION_ALGORITHM == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 ) && ( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+
+	static uint32_t prvTCPCubicAvoidance( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+	uint32_t ulWindow = pxCongestion->ulCongestionWindow;
+	int64_t llOffset, llTarget;
+	/* Limit 't - K' to 100 seconds, so the cube will not overflow. */
+	const int64_t llMaxOffset = 100000;
+
+		if( pxCongestion->xEpochStarted == pdFALSE )
+		{
+			/* The first ACK in congestion avoidance after a reduction. */
+			pxCongestion->xEpochStarted = pdTRUE;
+			vTCPTimerSet( &( pxCongestion->xEpochTimer ) );
+			pxCongestion->ulRenoWindow = ulWindow;
+
+			if( ulWindow < pxCongestion->ulLastMaxWindow )
+			{
+				/* K = cbrt( ( W_max - cwnd ) / C ), where the windows are
+				expressed in segments and K in msec. */
+				pxCongestion->ulCubicK = prvCubeRoot( ( ( uint64_t ) ( pxCongestion->ulLastMaxWindow - ulWindow ) *
+					( 10000000000ULL / winCUBIC_C_TENTHS ) ) / ulMSS );
+				pxCongestion->ulOriginPoint = pxCongestion->ulLastMaxWindow;
+			}
+			else
+			{
+				pxCongestion->ulCubicK = 0UL;
+				pxCongestion->ulOriginPoint = ulWindow;
+			}
+		}
+
+		/* W_cubic( t + RTT ) = C * ( t + RTT - K )^3 + W_max, with the time in
+		msec and the window in bytes. */
+		llOffset = ( int64_t ) ulTimerGetAge( &( pxCongestion->xEpochTimer ) ) + ( int64_t ) pxWindow->lSRTT - ( int64_t ) pxCongestion->ulCubicK;
+
+		if( llOffset > llMaxOffset )
+		{
+			llOffset = llMaxOffset;
+		}
+		else if( llOffset < -llMaxOffset )
+		{
+			llOffset = -llMaxOffset;
+		}
+
+		llTarget = ( int64_t ) pxCongestion->ulOriginPoint +
+			( ( ( ( llOffset * llOffset * llOffset ) / 1000 ) * ( int64_t ) ulMSS * ( int64_t ) winCUBIC_C_TENTHS ) / 10000000 );
+
+		/* The window that standard TCP would have reached, growing with
+		3 * ( 1 - beta ) / ( 1 + beta ) segments per round-trip.  CUBIC will
+		never be slower than that (the TCP-friendly region). */
+		pxCongestion->ulRenoWindow += ( uint32_t ) ( ( ( uint64_t ) ulMSS * 3u * ( 10u - winCUBIC_BETA_TENTHS ) * ulBytesAcked ) /
+			( ( uint64_t ) ( 10u + winCUBIC_BETA_TENTHS ) * FreeRTOS_max_uint32( pxCongestion->ulRenoWindow, ulMSS ) ) );
+
+		if( llTarget < ( int64_t ) pxCongestion->ulRenoWindow )
+		{
+			llTarget = ( int64_t ) pxCongestion->ulRenoWindow;
+		}
+
+		/* Do not grow with more than 50% per round-trip. */
+		if( llTarget > ( int64_t ) ulWindow + ( int64_t ) ( ulWindow / 2u ) )
+		{
+			llTarget = ( int64_t ) ulWindow + ( int64_t ) ( ulWindow / 2u );
+		}
+
+		if( llTarget > ( int64_t ) ulWindow )
+		{
+			/* Grow with ( target - cwnd ) / cwnd for every byte acknowledged. */
+			ulWindow += ( uint32_t ) ( ( ( uint64_t ) ( llTarget - ( int64_t ) ulWindow ) * ulBytesAcked ) / FreeRTOS_max_uint32( ulWindow, 1UL ) );
+		}
+
+		return ulWindow;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL == 1 && ipconfigTCP_CONGESTION_ALGORITHM == 1 */
+/*-----------------------------------------------------------*/
+
 /*
 #####   #                      #####   ####  ######
 # # #   #                      # # #  #    #  #    #
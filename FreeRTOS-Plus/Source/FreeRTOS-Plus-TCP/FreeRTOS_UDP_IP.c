@@ -50,6 +50,18 @@
 /* The expected IP version and header length coded into the IP header itself. */
 #define ipIP_VERSION_AND_HEADER_LENGTH_BYTE ( ( uint8_t ) 0x45 )
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* The number of IP payload bytes in each fragment, except the last one.
+	Fragment offsets are expressed in units of 8 bytes. */
+	#define ipFRAGMENT_PAYLOAD_LENGTH	( ( ( size_t ) ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) ) & ~( ( size_t ) 0x07u ) )
+
+	/*
+	 * Send a datagram that is larger than the MTU in several fragments, and
+	 * release the network buffer that contains it.
+	 */
+	static void prvSendFragmentedPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 /* Part of the Ethernet and IP headers are always constant when sending an IPv4
 UDP packet.  This array defines the constant parts, allowing this part of the
 packet to be filled in using a simple memcpy() instead of individual writes. */
@@ -79,6 +91,10 @@ IPHeader_t *pxIPHeader;
 eARPLookupResult_t eReturned;
 uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 size_t uxPayloadSize;
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* Becomes pdTRUE when the packet is held until an ARP reply arrives. */
+	BaseType_t xIsWaiting = pdFALSE;
+#endif
 
 	/* Map the UDP packet onto the start of the frame. */
 	pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
@@ -186,7 +202,19 @@ size_t uxPayloadSize;
 
 				if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
 				{
-					usGenerateProtocolChecksum( (uint8_t*)pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+					{
+						/* The payload may have been summed already by
+						FreeRTOS_sendto(). */
+						usGenerateProtocolChecksumWithPayload( (uint8_t*)pxUDPPacket, pxNetworkBuffer->xDataLength,
+							pxNetworkBuffer->usPayloadChecksum, ( size_t ) pxNetworkBuffer->usPayloadLength );
+						pxNetworkBuffer->usPayloadLength = 0u;
+					}
+					#else
+					{
+						usGenerateProtocolChecksum( (uint8_t*)pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					}
+					#endif /* ipconfigUSE_CHECKSUM_COPY */
 				}
 				else
 				{
@@ -202,10 +230,24 @@ size_t uxPayloadSize;
 			outstanding, and perform retransmissions if necessary. */
 			vARPRefreshCacheEntry( NULL, ulIPAddress );
 
-			/* Generate an ARP for the required IP address. */
-			iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
-			pxNetworkBuffer->ulIPAddress = ulIPAddress;
-			vARPGenerateRequestPacket( pxNetworkBuffer );
+			#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+			/* Let the packet wait for the ARP reply, the request will be sent
+			in a new network buffer. */
+			xIsWaiting = xARPPendingAdd( pxNetworkBuffer, ulIPAddress );
+
+			if( xIsWaiting != pdFALSE )
+			{
+				FreeRTOS_OutputARPRequest( ulIPAddress );
+				eReturned = eCantSendPacket;
+			}
+			else
+			#endif
+			{
+				/* Generate an ARP for the required IP address. */
+				iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
+				pxNetworkBuffer->ulIPAddress = ulIPAddress;
+				vARPGenerateRequestPacket( pxNetworkBuffer );
+			}
 		}
 		else
 		{
@@ -214,29 +256,54 @@ size_t uxPayloadSize;
 			eReturned = eCantSendPacket;
 		}
 	}
+	#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	else
+	{
+		/* Either an ARP request is outstanding already and the packet can
+		wait for its reply, or there is no IP-address or gateway at all. */
+		xIsWaiting = xARPPendingAdd( pxNetworkBuffer, ulIPAddress );
+	}
+	#endif
 
 	if( eReturned != eCantSendPacket )
 	{
 		/* The network driver is responsible for freeing the network buffer
 		after the packet has been sent. */
 
-		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+		if( pxNetworkBuffer->xDataLength > ( size_t ) ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) )
+		{
+			/* The datagram does not fit in a single packet. */
+			prvSendFragmentedPacket( pxNetworkBuffer );
+		}
+		else
+	#endif /* ipconfigUSE_IP_FRAGMENTATION */
 		{
-			if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+			#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
 			{
-			BaseType_t xIndex;
-
-				for( xIndex = ( BaseType_t ) pxNetworkBuffer->xDataLength; xIndex < ( BaseType_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES; xIndex++ )
+				if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
 				{
-					pxNetworkBuffer->pucEthernetBuffer[ xIndex ] = 0u;
+				BaseType_t xIndex;
+
+					for( xIndex = ( BaseType_t ) pxNetworkBuffer->xDataLength; xIndex < ( BaseType_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES; xIndex++ )
+					{
+						pxNetworkBuffer->pucEthernetBuffer[ xIndex ] = 0u;
+					}
+					pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
 				}
-				pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
 			}
-		}
-		#endif
+			#endif
 
-		xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+			xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		}
 	}
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	else if( xIsWaiting != pdFALSE )
+	{
+		/* The network buffer is owned by the ARP module now, it will be
+		passed to this function again when the ARP reply arrives. */
+	}
+#endif
 	else
 	{
 		/* The packet can't be sent (DHCP not completed?).  Just drop the
@@ -246,6 +313,91 @@ size_t uxPayloadSize;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+
+	static void prvSendFragmentedPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+	NetworkBufferDescriptor_t *pxFragment;
+	IPHeader_t *pxIPHeader;
+	size_t uxPayloadLength, uxOffset, uxLength, uxBufferLength;
+	uint16_t usIdentification, usFlags;
+
+		/* The UDP header and checksum have been filled in already, they are
+		sent as part of the first fragment. */
+		uxPayloadLength = pxNetworkBuffer->xDataLength - ipIP_PAYLOAD_OFFSET;
+
+		/* All fragments carry the same identification. */
+		usIdentification = FreeRTOS_htons( usPacketIdentifier );
+		usPacketIdentifier++;
+
+		iptraceSENDING_FRAGMENTED_UDP_PACKET( pxNetworkBuffer->ulIPAddress, uxPayloadLength );
+
+		for( uxOffset = 0u; uxOffset < uxPayloadLength; uxOffset += uxLength )
+		{
+			uxLength = FreeRTOS_min_uint32( uxPayloadLength - uxOffset, ipFRAGMENT_PAYLOAD_LENGTH );
+			uxBufferLength = ipIP_PAYLOAD_OFFSET + uxLength;
+
+			#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+			{
+				/* The last fragment might be a short one. */
+				if( uxBufferLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+				{
+					uxBufferLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+				}
+			}
+			#endif
+
+			pxFragment = pxGetNetworkBufferWithDescriptor( uxBufferLength, ( TickType_t ) 0u );
+
+			if( pxFragment == NULL )
+			{
+				/* The remaining fragments are useless without this one. */
+				iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER();
+				break;
+			}
+
+			/* Copy the Ethernet and IP headers, followed by a part of the IP
+			payload. */
+			memcpy( pxFragment->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, ipIP_PAYLOAD_OFFSET );
+			memcpy( &( pxFragment->pucEthernetBuffer[ ipIP_PAYLOAD_OFFSET ] ), &( pxNetworkBuffer->pucEthernetBuffer[ ipIP_PAYLOAD_OFFSET + uxOffset ] ), uxLength );
+			memset( &( pxFragment->pucEthernetBuffer[ ipIP_PAYLOAD_OFFSET + uxLength ] ), 0, uxBufferLength - ( ipIP_PAYLOAD_OFFSET + uxLength ) );
+			pxFragment->xDataLength = uxBufferLength;
+
+			usFlags = ( uint16_t ) ( uxOffset >> 3 );
+
+			if( ( uxOffset + uxLength ) < uxPayloadLength )
+			{
+				usFlags |= ipFRAGMENT_FLAGS_MORE_FRAGMENTS;
+			}
+
+			pxIPHeader = &( ( ( IPPacket_t * ) pxFragment->pucEthernetBuffer )->xIPHeader );
+			pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + uxLength ) );
+			pxIPHeader->usIdentification = usIdentification;
+			pxIPHeader->usFragmentOffset = FreeRTOS_htons( usFlags );
+
+			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+			{
+				pxIPHeader->usHeaderChecksum = 0u;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+			}
+			#endif
+
+			xNetworkInterfaceOutput( pxFragment, pdTRUE );
+			xIPFragmentStats.ulFragmentsSent++;
+		}
+
+		if( uxOffset >= uxPayloadLength )
+		{
+			xIPFragmentStats.ulDatagramsFragmented++;
+		}
+
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+/*-----------------------------------------------------------*/
+
 BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
 {
 BaseType_t xReturn = pdPASS;
@@ -143,11 +143,148 @@ from the FreeRTOSIPConfig.h configuration header file. */
 		#define	ipconfigTCP_WIN_SEG_COUNT		( 256 )
 	#endif
 
+	#ifndef ipconfigUSE_TCP_RX_SEGMENT_TREE
+		/* When non-zero, the out-of-order segments of a TCP connection are
+		also stored in a balanced (AVL) tree, sorted on sequence number.  The
+		reception of a segment then costs O(log n) in stead of O(n), which
+		matters when ipconfigTCP_WIN_SEG_COUNT is large.  Costs two pointers
+		and a height per segment.  Requires ipconfigUSE_TCP_WIN. */
+		#define ipconfigUSE_TCP_RX_SEGMENT_TREE	( 0 )
+	#endif
+
 	#ifndef ipconfigIGNORE_UNKNOWN_PACKETS
 		/* When non-zero, TCP will not send RST packets in reply to
 		TCP packets which are unknown, or out-of-order. */
 		#define ipconfigIGNORE_UNKNOWN_PACKETS	( 0 )
 	#endif
+
+	#ifndef ipconfigUSE_TCP_HASH_LOOKUP
+		/* When non-zero, received TCP packets are matched with their socket
+		through a hash table indexed by the local port, the remote IP address
+		and the remote port, in stead of walking through all bound TCP
+		sockets.  Costs one ListItem_t per TCP socket and one List_t per
+		hash bucket. */
+		#define ipconfigUSE_TCP_HASH_LOOKUP		( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_HASH_TABLE_SIZE
+		/* Number of buckets in the TCP lookup table, preferably a power
+		of 2. */
+		#define ipconfigTCP_HASH_TABLE_SIZE		( 64 )
+	#endif
+
+	#ifndef ipconfigUSE_TCP_TIMER_WHEEL
+		/* When non-zero, the TCP sockets that have a pending time-out are
+		stored in a hierarchical timer wheel.  xTCPTimerCheck() will then only
+		visit the sockets that are due, in stead of checking all bound TCP
+		sockets.  Costs three ListItem_t's per TCP socket and 66 List_t's. */
+		#define ipconfigUSE_TCP_TIMER_WHEEL		( 0 )
+	#endif
+
+	#ifndef ipconfigUSE_TCP_CONGESTION_CONTROL
+		/* When non-zero, the amount of unacknowledged data of a TCP
+		connection is also limited by a congestion window (slow start,
+		congestion avoidance and fast recovery).  Requires
+		ipconfigUSE_TCP_WIN. */
+		#define ipconfigUSE_TCP_CONGESTION_CONTROL	( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_CONGESTION_ALGORITHM
+		/* The algorithm which grows and shrinks the congestion window:
+		0 = NewReno (RFC 5681 / RFC 6582), 1 = CUBIC (RFC 8312). */
+		#define ipconfigTCP_CONGESTION_ALGORITHM	( 0 )
+	#endif
+
+	#ifndef ipconfigUSE_TCP_TIMESTAMPS
+		/* When non-zero, the TCP time-stamp option (RFC 7323) is offered in
+		the SYN phase.  If the peer agrees, every packet carries a time-stamp,
+		which is used to measure the RTT with each ACK and to reject old
+		duplicate packets (PAWS).  The retransmission time-out is then
+		calculated from the smoothed RTT and its variance (RFC 6298).  Costs
+		12 bytes of every segment.  Requires ipconfigUSE_TCP_WIN. */
+		#define ipconfigUSE_TCP_TIMESTAMPS		( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_TX_REFERENCES
+		/* The maximum number of application buffers that a TCP socket can
+		hold by reference, see FREERTOS_MSG_REFERENCE in FreeRTOS_sendv().
+		Such data is not copied into the TX stream, but directly from the
+		application buffer into the outgoing packets.  The buffer is handed
+		back through the FREERTOS_SO_TCP_TX_REF_HANDLER call-back once the
+		peer has acknowledged it.  Zero disables the feature. */
+		#define ipconfigTCP_TX_REFERENCES		( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_AUTO_TUNE_BUFFERS
+		/* When non-zero, the RX and TX streams of a TCP socket, and the
+		windows that are derived from them, are resized while the connection
+		is in use.  A stream grows when the number of bytes transferred per
+		round-trip asks for it, and it shrinks back towards its configured size
+		when all TCP streams together come close to
+		ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET.  Sockets whose sizes were set with
+		FREERTOS_SO_RCVBUF, FREERTOS_SO_SNDBUF or FREERTOS_SO_WIN_PROPERTIES
+		are left alone.  Requires ipconfigUSE_TCP_WIN. */
+		#define ipconfigTCP_AUTO_TUNE_BUFFERS	( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_AUTO_TUNE_MAX_LENGTH
+		/* The maximum size in bytes to which auto-tuning lets a single stream
+		grow. */
+		#define ipconfigTCP_AUTO_TUNE_MAX_LENGTH	( 32u * ipconfigTCP_MSS )
+	#endif
+
+	#ifndef ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET
+		/* The number of bytes that the streams of all TCP sockets together may
+		occupy before streams stop growing.  The creation of a stream at its
+		configured size is always allowed, and may cause the budget to be
+		exceeded, in which case grown streams will be shrunk. */
+		#define ipconfigTCP_AUTO_TUNE_MEMORY_BUDGET	( 4u * ipconfigTCP_AUTO_TUNE_MAX_LENGTH )
+	#endif
+
+	#ifndef ipconfigTCP_SYN_CACHE_SIZE
+		/* When non-zero, a listening socket does not create a child socket for
+		every SYN that it receives.  The half-open connection is stored in a
+		compact cache with this number of entries, which is shared by all
+		listening sockets.  The child socket is created when the final ACK of
+		the three-way handshake arrives.  Listening sockets that use
+		FREERTOS_SO_REUSE_LISTEN_SOCKET are not affected. */
+		#define ipconfigTCP_SYN_CACHE_SIZE		( 0 )
+	#endif
+
+	#ifndef ipconfigTCP_SYN_CACHE_TIMEOUT_MS
+		/* The time after which an entry of the SYN cache that did not get its
+		final ACK may be re-used. */
+		#define ipconfigTCP_SYN_CACHE_TIMEOUT_MS	( 20000u )
+	#endif
+
+	#ifndef ipconfigTCP_SYN_COOKIES
+		/* When the SYN cache has no room for a new connection, answer the SYN
+		with a SYN cookie: an initial sequence number that encodes the
+		connection, so nothing needs to be stored.  Such a SYN+ACK does not
+		offer window scaling or time-stamps.  Without SYN cookies, the oldest
+		entry of the cache is overwritten. */
+		#define ipconfigTCP_SYN_COOKIES			( 0 )
+	#endif
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigUSE_TCP_WIN == 0 )
+		#error ipconfigUSE_TCP_CONGESTION_CONTROL can only be used together with ipconfigUSE_TCP_WIN
+	#endif
+
+	#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 ) && ( ipconfigUSE_TCP_WIN == 0 )
+		#error ipconfigUSE_TCP_RX_SEGMENT_TREE can only be used together with ipconfigUSE_TCP_WIN
+	#endif
+
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 ) && ( ipconfigUSE_TCP_WIN == 0 )
+		#error ipconfigUSE_TCP_TIMESTAMPS can only be used together with ipconfigUSE_TCP_WIN
+	#endif
+
+	#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 ) && ( ipconfigUSE_TCP_WIN == 0 )
+		#error ipconfigTCP_AUTO_TUNE_BUFFERS can only be used together with ipconfigUSE_TCP_WIN
+	#endif
+
+	#if( ipconfigTCP_SYN_COOKIES != 0 ) && ( ipconfigTCP_SYN_CACHE_SIZE == 0 )
+		#error ipconfigTCP_SYN_COOKIES can only be used together with ipconfigTCP_SYN_CACHE_SIZE
+	#endif
 #endif
 
 /*
@@ -297,6 +434,82 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define	ipconfigUSE_ARP_REMOVE_ENTRY		0
 #endif
 
+#ifndef ipconfigUSE_ARP_HASH_TABLE
+	/* When non-zero, the ARP cache is indexed by two open-addressed hash tables,
+	one on the IP address and one on the MAC address, so looking up an entry
+	doesn't need a scan of the whole cache.  When a new entry is needed, the
+	least recently used entry will be replaced. Useful when
+	ipconfigARP_CACHE_ENTRIES is large. */
+	#define ipconfigUSE_ARP_HASH_TABLE			0
+#endif
+
+#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+	#ifndef ipconfigARP_HASH_TABLE_SIZE
+		/* The number of slots in each hash table.  Must be larger than
+		ipconfigARP_CACHE_ENTRIES, the more free slots, the shorter the
+		searches. */
+		#define ipconfigARP_HASH_TABLE_SIZE		( 2 * ipconfigARP_CACHE_ENTRIES )
+	#endif
+
+	#if( ipconfigARP_HASH_TABLE_SIZE <= ipconfigARP_CACHE_ENTRIES )
+		#error ipconfigARP_HASH_TABLE_SIZE must be larger than ipconfigARP_CACHE_ENTRIES
+	#endif
+
+	#if( ipconfigARP_CACHE_ENTRIES > 32767 )
+		#error ipconfigARP_CACHE_ENTRIES is too large for ipconfigUSE_ARP_HASH_TABLE
+	#endif
+#endif /* ipconfigUSE_ARP_HASH_TABLE */
+
+#ifndef ipconfigARP_REFRESH_AGE
+	/* When non-zero, an ARP cache entry that has been used to send packets
+	will be refreshed with a unicast ARP request as soon as its age drops to
+	this value, long before it would expire.  Like ipconfigMAX_ARP_AGE, the
+	age is expressed in periods of the ARP timer. */
+	#define ipconfigARP_REFRESH_AGE				0
+#endif
+
+#if( ipconfigARP_REFRESH_AGE != 0 )
+	#ifndef ipconfigARP_MAX_REQUESTS_PER_PERIOD
+		/* The maximum number of ARP requests that will be sent to refresh
+		entries in one period of the ARP timer.  Entries that are due later
+		will be handled in the next periods.  The requests for entries that
+		are about to expire are not limited. */
+		#define ipconfigARP_MAX_REQUESTS_PER_PERIOD	2
+	#endif
+
+	#if( ipconfigARP_REFRESH_AGE >= ipconfigMAX_ARP_AGE )
+		#error ipconfigARP_REFRESH_AGE must be less than ipconfigMAX_ARP_AGE
+	#endif
+
+	#if( ipconfigARP_MAX_REQUESTS_PER_PERIOD < 1 )
+		#error ipconfigARP_MAX_REQUESTS_PER_PERIOD must be at least 1
+	#endif
+#endif /* ipconfigARP_REFRESH_AGE */
+
+#ifndef ipconfigARP_PENDING_QUEUE_LENGTH
+	/* When non-zero, a UDP or ICMP packet that is sent to an address that has
+	not been resolved yet will be held until the ARP reply arrives, in stead
+	of being dropped.  This is the maximum number of network buffers that can
+	be held in total. */
+	#define ipconfigARP_PENDING_QUEUE_LENGTH	0
+#endif
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	#ifndef ipconfigARP_PENDING_PER_DESTINATION
+		/* The maximum number of packets held for a single destination. */
+		#define ipconfigARP_PENDING_PER_DESTINATION		3
+	#endif
+
+	#ifndef ipconfigARP_PENDING_TIMEOUT_MS
+		/* Packets that are still waiting after this time will be dropped. */
+		#define ipconfigARP_PENDING_TIMEOUT_MS			( 3000u )
+	#endif
+
+	#if( ipconfigARP_PENDING_PER_DESTINATION < 1 )
+		#error ipconfigARP_PENDING_PER_DESTINATION must be at least 1
+	#endif
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 #ifndef ipconfigINCLUDE_FULL_INET_ADDR
 	#define ipconfigINCLUDE_FULL_INET_ADDR	1
 #endif
@@ -309,6 +522,50 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 #endif
 
+#ifndef ipconfigUSE_NETWORK_RINGS
+	/* When enabled, received packets are passed from the network interface to
+	the IP-task through a lock-free single-producer/single-consumer ring, in
+	stead of through xNetworkEventQueue.  A second ring is made available for
+	network interfaces that want to pass outgoing packets from the IP-task to
+	their own transmit task.  The event queue remains in use for all other
+	events. */
+	#define ipconfigUSE_NETWORK_RINGS		( 0 )
+#endif
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	#ifndef ipconfigNETWORK_RX_RING_LENGTH
+		/* The number of packets (or chains of packets) that the RX ring can
+		hold.  Must be a power of 2. */
+		#define ipconfigNETWORK_RX_RING_LENGTH	( 32 )
+	#endif
+
+	#ifndef ipconfigNETWORK_TX_RING_LENGTH
+		/* The number of packets that the TX ring can hold.  Must be a power
+		of 2. */
+		#define ipconfigNETWORK_TX_RING_LENGTH	( 16 )
+	#endif
+
+	#if( ( ipconfigNETWORK_RX_RING_LENGTH < 2 ) || ( ( ipconfigNETWORK_RX_RING_LENGTH & ( ipconfigNETWORK_RX_RING_LENGTH - 1 ) ) != 0 ) )
+		#error ipconfigNETWORK_RX_RING_LENGTH must be a power of 2
+	#endif
+
+	#if( ( ipconfigNETWORK_TX_RING_LENGTH < 2 ) || ( ( ipconfigNETWORK_TX_RING_LENGTH & ( ipconfigNETWORK_TX_RING_LENGTH - 1 ) ) != 0 ) )
+		#error ipconfigNETWORK_TX_RING_LENGTH must be a power of 2
+	#endif
+
+	#ifndef ipconfigMEMORY_BARRIER
+		/* Makes sure that the contents of a ring slot are visible to the other
+		side before the index is updated.  A compiler barrier is sufficient on
+		single core CPU's without a write buffer, a port can define it that
+		way in FreeRTOSIPConfig.h. */
+		#if defined( __GNUC__ )
+			#define ipconfigMEMORY_BARRIER()	__sync_synchronize()
+		#else
+			#error Please define ipconfigMEMORY_BARRIER() in FreeRTOSIPConfig.h
+		#endif
+	#endif
+#endif /* ipconfigUSE_NETWORK_RINGS */
+
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
 	#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND 1
 #endif
@@ -329,6 +586,20 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUDP_MAX_RX_PACKETS		0u
 #endif
 
+#ifndef ipconfigUSE_UDP_HASH_LOOKUP
+	/* When non-zero, bound UDP sockets are also stored in a hash table indexed
+	 * by their port number, so that looking up the socket for a received
+	 * packet, or checking if a port is in use, does not have to walk through
+	 * all bound UDP sockets.
+	 */
+	#define ipconfigUSE_UDP_HASH_LOOKUP		0
+#endif
+
+#ifndef ipconfigUDP_HASH_TABLE_SIZE
+	/* Number of buckets in the UDP port hash table. */
+	#define ipconfigUDP_HASH_TABLE_SIZE		32
+#endif
+
 #ifndef ipconfigUSE_DHCP
 	#define ipconfigUSE_DHCP				1
 #endif
@@ -362,6 +633,48 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigTCP_MSS		( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_TCP_HEADER )
 #endif
 
+/* When non-zero, incoming fragmented IPv4 datagrams will be reassembled, and
+outgoing UDP datagrams that are larger than the MTU will be sent in fragments.
+A reassembled datagram is stored in a single network buffer, so large
+datagrams can only be handled when BufferAllocation_2.c or BufferAllocation_3.c
+is used. */
+#ifndef ipconfigUSE_IP_FRAGMENTATION
+	#define ipconfigUSE_IP_FRAGMENTATION		0
+#endif
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* The maximum size of a datagram, including its IP header, that will be
+	reassembled or sent in fragments. */
+	#ifndef ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE
+		#define ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE	( 4u * ipconfigNETWORK_MTU )
+	#endif
+
+	/* The number of datagrams that can be reassembled at the same time.  When
+	all are in use, the oldest incomplete datagram will be dropped. */
+	#ifndef ipconfigIP_REASSEMBLY_MAX_DATAGRAMS
+		#define ipconfigIP_REASSEMBLY_MAX_DATAGRAMS			4
+	#endif
+
+	/* The maximum number of network buffers that may be held by the fragment
+	cache, so that fragments can not exhaust the pool of network buffers. */
+	#ifndef ipconfigIP_REASSEMBLY_MAX_BUFFERS
+		#define ipconfigIP_REASSEMBLY_MAX_BUFFERS			( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+	#endif
+
+	/* An incomplete datagram will be dropped when it is older than this. */
+	#ifndef ipconfigIP_REASSEMBLY_TIMEOUT_MS
+		#define ipconfigIP_REASSEMBLY_TIMEOUT_MS			( 3000u )
+	#endif
+
+	#if( ( ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE < ipconfigNETWORK_MTU ) || ( ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE > 65535 ) )
+		#error ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE must be between ipconfigNETWORK_MTU and 65535
+	#endif
+
+	#if( ipconfigIP_REASSEMBLY_MAX_BUFFERS < 2 )
+		#error ipconfigIP_REASSEMBLY_MAX_BUFFERS must be at least 2
+	#endif
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 /* Each TCP socket has circular stream buffers for Rx and Tx, which
  * have a fixed maximum size.
  * The defaults for these size are defined here, although
@@ -413,6 +726,29 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#ifndef ipconfigDNS_CACHE_ENTRIES
 		#define ipconfigDNS_CACHE_ENTRIES			1
 	#endif
+
+	#if( ipconfigDNS_CACHE_ENTRIES > 0xfffe )
+		#error ipconfigDNS_CACHE_ENTRIES is too large
+	#endif
+
+	#ifndef ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY
+		/* The number of IPv4 addresses ( A records ) that will be remembered
+		for each host name.  FreeRTOS_dnslookup() will return them in a
+		round-robin fashion. */
+		#define ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY	1
+	#endif
+
+	#if( ( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY < 1 ) || ( ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY > 255 ) )
+		#error ipconfigDNS_CACHE_ADDRESSES_PER_ENTRY must be between 1 and 255
+	#endif
+
+	#ifndef ipconfigDNS_CACHE_NEGATIVE_TTL
+		/* When non-zero, a name for which the DNS server replied that it does
+		not exist (NXDOMAIN) will be remembered for this number of seconds.
+		FreeRTOS_gethostbyname() will fail immediately for that name during
+		that time, in stead of sending new requests. */
+		#define ipconfigDNS_CACHE_NEGATIVE_TTL		0
+	#endif
 #endif /* ipconfigUSE_DNS_CACHE != 0 */
 
 #ifndef ipconfigCHECK_IP_QUEUE_SPACE
@@ -454,6 +790,44 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define	ipconfigETHERNET_DRIVER_FILTERS_PACKETS	( 0 )
 #endif
 
+#ifndef ipconfigUSE_LINKED_RX_MESSAGES
+	/* When enabled, a network interface may chain received packets through
+	'pxNextBuffer' and pass the whole chain to the IP-task in a single event. */
+	#define ipconfigUSE_LINKED_RX_MESSAGES	( 0 )
+#endif
+
+#ifndef ipconfigNETWORK_RX_BATCH_SIZE
+	/* The maximum number of packets that xNetworkRxBatchAdd() will chain
+	before the batch is sent to the IP-task.  Only used when
+	ipconfigUSE_LINKED_RX_MESSAGES is enabled. */
+	#define ipconfigNETWORK_RX_BATCH_SIZE	( 8 )
+#endif
+
+#if( ipconfigNETWORK_RX_BATCH_SIZE < 1 )
+	#error ipconfigNETWORK_RX_BATCH_SIZE must be at least 1
+#endif
+
+#ifndef ipconfigNETWORK_RX_POLL_BUDGET
+	/* When non-zero, network interfaces that support it will mask their RX
+	interrupt as soon as a packet has been received.  The EMAC task then polls
+	the DMA ring, reading at most this number of packets per pass, and sleeps
+	for one clock tick between passes while the budget is used up.  The RX
+	interrupt is enabled again when the ring is empty.  This avoids interrupt
+	storms under heavy load.  When zero, every packet may cause an interrupt
+	and a task notification. */
+	#define ipconfigNETWORK_RX_POLL_BUDGET	( 0 )
+#endif
+
+#ifndef ipconfigPREFETCH
+	/* Hint to the CPU that the data at 'pvAddress' will be read soon.  Used
+	while walking a chain of received packets. */
+	#if defined( __GNUC__ )
+		#define ipconfigPREFETCH( pvAddress )	__builtin_prefetch( ( pvAddress ) )
+	#else
+		#define ipconfigPREFETCH( pvAddress )
+	#endif
+#endif
+
 #ifndef ipconfigWATCHDOG_TIMER
 	/* This macro will be called in every loop the IP-task makes.  It may be
 	replaced by user-code that triggers a watchdog */
@@ -464,7 +838,7 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUSE_CALLBACKS			( 0 )
 #endif
 
-#if( ipconfigUSE_CALLBACKS != 0 )
+#if( ipconfigUSE_CALLBACKS != 0 ) || ( ipconfigTCP_TX_REFERENCES != 0 )
 	#ifndef ipconfigIS_VALID_PROG_ADDRESS
 		/* Replace this macro with a test returning non-zero if the memory pointer to by x
 		 * is valid memory which can contain executable code
@@ -504,6 +878,23 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM 0
 #endif
 
+#ifndef ipconfigUSE_SIMD_CHECKSUM
+	/* When non-zero, usGenerateChecksum() will use SSE2 or NEON instructions
+	if the compiler targets a CPU that has them (__SSE2__ or __ARM_NEON).
+	Other CPUs will use the portable code. */
+	#define ipconfigUSE_SIMD_CHECKSUM 0
+#endif
+
+#ifndef ipconfigUSE_CHECKSUM_COPY
+	/* When non-zero, the payload of outgoing UDP and TCP packets will be
+	checksummed while it is copied into the network buffer, so it does not
+	have to be read a second time.  Only useful when
+	ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM is 0.  On a CPU with a vectorised
+	memcpy(), the portable copy loop can be slower than a memcpy() followed by
+	a checksum, combine it with ipconfigUSE_SIMD_CHECKSUM there. */
+	#define ipconfigUSE_CHECKSUM_COPY 0
+#endif
+
 #ifndef ipconfigDHCP_REGISTER_HOSTNAME
 	#define ipconfigDHCP_REGISTER_HOSTNAME 0
 #endif
@@ -532,6 +923,13 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigSUPPORT_SIGNALS				0
 #endif
 
+#ifndef ipconfigSUPPORT_UDP_BATCH
+	/* When non-zero, FreeRTOS_sendmmsg() and FreeRTOS_recvmmsg() are
+	available.  They send or receive several UDP datagrams with a single
+	message to the IP-task, or a single wait for the socket. */
+	#define ipconfigSUPPORT_UDP_BATCH			0
+#endif
+
 #ifndef ipconfigUSE_NBNS
 	#define ipconfigUSE_NBNS 0
 #endif
@@ -45,6 +45,9 @@ typedef struct xARP_CACHE_TABLE_ROW
 	MACAddress_t xMACAddress;  /* The MAC address of an ARP cache entry. */
 	uint8_t ucAge;				/* A value that is periodically decremented but can also be refreshed by active communication.  The ARP cache entry is removed if the value reaches zero. */
     uint8_t ucValid;			/* pdTRUE: xMACAddress is valid, pdFALSE: waiting for ARP reply */
+#if( ipconfigARP_REFRESH_AGE != 0 )
+	uint8_t ucUsed;				/* pdTRUE when the entry has been used to send a packet since it was last refreshed. */
+#endif
 } ARPCacheRow_t;
 
 typedef enum
@@ -121,6 +124,32 @@ void vARPGenerateRequestPacket( NetworkBufferDescriptor_t * const pxNetworkBuffe
  */
 void vARPSendGratuitous( void );
 
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	/*
+	 * Initialise the list of packets that wait for an ARP reply.  Called once
+	 * from FreeRTOS_IPInit().
+	 */
+	void vARPPendingInit( void );
+
+	/*
+	 * Hold a packet that can not be sent because the MAC-address of
+	 * 'ulLookupAddress' (the destination or the gateway) is not known yet.
+	 * The packet will be passed to vProcessGeneratedUDPPacket() again as soon
+	 * as the ARP reply arrives.  Returns pdTRUE when the network buffer is now
+	 * owned by the ARP module, or pdFALSE when the packet could not be held.
+	 */
+	BaseType_t xARPPendingAdd( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulLookupAddress );
+
+	/*
+	 * Drop the packets that have been waiting longer than
+	 * ipconfigARP_PENDING_TIMEOUT_MS.  Called from the IP-task, returns pdTRUE
+	 * while there are packets left waiting.
+	 */
+	BaseType_t xARPPendingAgeing( void );
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -84,12 +84,28 @@ uint32_t ulDNSHandlePacket( NetworkBufferDescriptor_t *pxNetworkBuffer );
 
 #if( ipconfigUSE_DNS_CACHE != 0 )
 
-    /* Look for the indicated host name in the DNS cache. Returns the IPv4 
-    address if present, or 0x0 otherwise. */
+	/* Counters that describe the use of the DNS cache. */
+	typedef struct xDNS_CACHE_STATISTICS
+	{
+		uint32_t ulHits;			/* Look-ups that returned an IP-address. */
+		uint32_t ulNegativeHits;	/* Look-ups of a name that is known not to exist. */
+		uint32_t ulMisses;			/* Look-ups of a name that was not in the cache. */
+		uint32_t ulInsertions;		/* Names that were added or updated. */
+		uint32_t ulExpirations;		/* Entries that were removed because their TTL ended. */
+		uint32_t ulEvictions;		/* Entries that were removed to make place for a new name. */
+	} DNSCacheStatistics_t;
+
+    /* Look for the indicated host name in the DNS cache. Returns the IPv4
+    address if present, or 0x0 otherwise.  The comparison of names is
+	case-insensitive.  When a name has more than one address, the addresses
+	will be returned in turn. */
 	uint32_t FreeRTOS_dnslookup( const char *pcHostName );
 
     /* Remove all entries from the DNS cache. */
     void FreeRTOS_dnsclear();
+
+	/* Obtain a copy of the DNS cache counters. */
+	void FreeRTOS_dnsGetCacheStatistics( DNSCacheStatistics_t *pxStatistics );
 #endif /* ipconfigUSE_DNS_CACHE != 0 */
 
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
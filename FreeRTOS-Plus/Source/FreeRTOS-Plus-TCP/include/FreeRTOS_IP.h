@@ -94,8 +94,12 @@ typedef struct xNETWORK_BUFFER
 	size_t xDataLength; 			/* Starts by holding the total Ethernet frame length, then the UDP/TCP payload length. */
 	uint16_t usPort;				/* Source or destination port, depending on usage scenario. */
 	uint16_t usBoundPort;			/* The port to which a transmitting socket is bound. */
-	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
-		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 ) || ( ipconfigSUPPORT_UDP_BATCH != 0 )
+		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support.  Also links the packets sent by FreeRTOS_sendmmsg(). */
+	#endif
+	#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+		uint16_t usPayloadChecksum;		/* Checksum of the UDP/TCP payload, calculated while it was copied into the buffer. */
+		uint16_t usPayloadLength;		/* Number of payload bytes covered by usPayloadChecksum, zero if not calculated. */
 	#endif
 } NetworkBufferDescriptor_t;
 
@@ -251,6 +255,63 @@ BaseType_t FreeRTOS_IsNetworkUp( void );
 	UBaseType_t uxGetMinimumIPQueueSpace( void );
 #endif
 
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	/* The lowest number of free slots ever seen in the RX and TX rings. */
+	UBaseType_t uxGetMinimumRxRingSpace( void );
+	UBaseType_t uxGetMinimumTxRingSpace( void );
+#endif
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* Statistics of the IP fragmentation and reassembly, see
+	FreeRTOS_GetIPFragmentStats(). */
+	typedef struct xIP_FRAGMENT_STATS
+	{
+		uint32_t ulFragmentsReceived;		/* Number of fragments received */
+		uint32_t ulFragmentsDropped;		/* Fragments that were invalid, duplicated, or could not be stored */
+		uint32_t ulDatagramsReassembled;	/* Number of datagrams that were reassembled successfully */
+		uint32_t ulDatagramsDropped;		/* Incomplete datagrams that were dropped, time-outs excluded */
+		uint32_t ulReassemblyTimeouts;		/* Incomplete datagrams that were dropped because they were too old */
+		uint32_t ulDatagramsFragmented;		/* Number of outgoing datagrams that were sent in fragments */
+		uint32_t ulFragmentsSent;			/* Number of fragments sent */
+		UBaseType_t uxBuffersInUse;			/* Network buffers currently held by the fragment cache */
+		UBaseType_t uxBuffersInUseMax;		/* The highest value of uxBuffersInUse */
+		size_t uxBytesInUse;				/* Payload bytes currently held by the fragment cache */
+		size_t uxBytesInUseMax;				/* The highest value of uxBytesInUse */
+	} IPFragmentStats_t;
+
+	void FreeRTOS_GetIPFragmentStats( IPFragmentStats_t *pxStats );
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* Statistics of the packets that wait for an ARP resolution, see
+	FreeRTOS_GetARPPendingStats(). */
+	typedef struct xARP_PENDING_STATS
+	{
+		uint32_t ulPacketsQueued;			/* Number of packets that were held while waiting for an ARP reply */
+		uint32_t ulPacketsSent;				/* Held packets that were sent after the address was resolved */
+		uint32_t ulPacketsDropped;			/* Packets that could not be held because the queue was full */
+		uint32_t ulPacketsTimedOut;			/* Held packets that were dropped because no ARP reply arrived in time */
+		UBaseType_t uxPacketsWaiting;		/* Network buffers currently held */
+		UBaseType_t uxPacketsWaitingMax;	/* The highest value of uxPacketsWaiting */
+	} ARPPendingStats_t;
+
+	void FreeRTOS_GetARPPendingStats( ARPPendingStats_t *pxStats );
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	/* Statistics of the RX interrupt moderation of the network interface, see
+	FreeRTOS_GetNetworkRxPollStats(). */
+	typedef struct xNETWORK_RX_POLL_STATS
+	{
+		uint32_t ulInterrupts;				/* RX interrupts, each one starts a period of polling */
+		uint32_t ulPolls;					/* Passes over the DMA ring */
+		uint32_t ulPackets;					/* Packets read while polling */
+		uint32_t ulBudgetExhausted;			/* Passes that stopped because ipconfigNETWORK_RX_POLL_BUDGET was reached */
+	} NetworkRxPollStats_t;
+
+	void FreeRTOS_GetNetworkRxPollStats( NetworkRxPollStats_t *pxStats );
+#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+
 /*
  * Defined in FreeRTOS_Sockets.c
  * //_RB_ Don't think this comment is correct.  If this is for internal use only it should appear after all the public API functions and not start with FreeRTOS_.
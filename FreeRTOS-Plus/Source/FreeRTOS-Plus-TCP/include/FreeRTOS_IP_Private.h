@@ -231,6 +231,16 @@ typedef union XPROT_PACKET
 /* The maximum UDP payload length. */
 #define ipMAX_UDP_PAYLOAD_LENGTH ( ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER )
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* The maximum UDP payload length of a datagram that is sent in fragments. */
+	#define ipMAX_FRAGMENTED_UDP_PAYLOAD_LENGTH ( ( ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER )
+#endif
+
+/* The bits of the IP header field 'usFragmentOffset', in host-endian order. */
+#define ipFRAGMENT_OFFSET_MASK				( ( uint16_t ) 0x1fffu )	/* The offset, in units of 8 bytes. */
+#define ipFRAGMENT_FLAGS_MORE_FRAGMENTS		( ( uint16_t ) 0x2000u )
+#define ipFRAGMENT_FLAGS_DONT_FRAGMENT		( ( uint16_t ) 0x4000u )
+
 typedef enum
 {
 	eReleaseBuffer = 0,		/* Processing the frame did not find anything to do - just release the buffer. */
@@ -255,6 +265,7 @@ typedef enum
 	eSocketCloseEvent,		/*10: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*11: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*12: A socket must be signalled. */
+	eStackTxBatchEvent,		/*13: The software stack has queued a chain of packets to transmit. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -341,9 +352,15 @@ These values will be copied to 'xNetworkAddressing' in case DHCP is not used,
 and also in case DHCP does not lead to a confirmed request. */
 extern NetworkAddressingParameters_t xDefaultAddressing;
 
-/* True when BufferAllocation_1.c was included, false for BufferAllocation_2.c */
+/* True when BufferAllocation_1.c was included, false for BufferAllocation_2.c
+and BufferAllocation_3.c */
 extern const BaseType_t xBufferAllocFixedSize;
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* Defined in FreeRTOS_IP.c, only updated by the IP-task. */
+	extern IPFragmentStats_t xIPFragmentStats;
+#endif
+
 /* Defined in FreeRTOS_Sockets.c */
 #if ( ipconfigUSE_TCP == 1 )
 	extern List_t xBoundTCPSocketsList;
@@ -431,11 +448,109 @@ eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame );
  */
 eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer );
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/*
+	 * Used by network interfaces to pass received packets to the IP-task in
+	 * batches.  The packets are chained through pxNextBuffer and the chain is
+	 * sent as a single eNetworkRxEvent, so the event queue is accessed once
+	 * per batch in stead of once per packet.
+	 */
+	typedef struct xNETWORK_RX_BATCH
+	{
+		NetworkBufferDescriptor_t *pxHead;	/* The first packet of the chain, passed to the IP-task */
+		NetworkBufferDescriptor_t *pxTail;	/* The last packet of the chain, new packets are added here */
+		UBaseType_t uxCount;				/* The number of packets in the chain */
+	} NetworkRxBatch_t;
+
+	/*
+	 * Initialise an empty batch.
+	 */
+	void vNetworkRxBatchInit( NetworkRxBatch_t *pxBatch );
+
+	/*
+	 * Add a received packet to the batch.  When the batch contains
+	 * ipconfigNETWORK_RX_BATCH_SIZE packets, it will be sent to the IP-task
+	 * by calling xNetworkRxBatchSend().  Returns pdFAIL only if that send
+	 * failed, in which case the packets have been released.
+	 */
+	BaseType_t xNetworkRxBatchAdd( NetworkRxBatch_t *pxBatch, NetworkBufferDescriptor_t *pxNetworkBuffer, TickType_t xBlockTimeTicks );
+
+	/*
+	 * Send all packets in the batch to the IP-task.  Should be called when the
+	 * driver has no more packets to offer.  If the IP-task can not be reached,
+	 * the packets will be released.  The batch will be empty when the function
+	 * returns.
+	 */
+	BaseType_t xNetworkRxBatchSend( NetworkRxBatch_t *pxBatch, TickType_t xBlockTimeTicks );
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	/*
+	 * A lock-free ring of network buffers with exactly one producer and one
+	 * consumer.  'uxHead' is only written by the producer, 'uxTail' only by
+	 * the consumer.  Both are free-running counters, the slot is found by
+	 * masking them with 'uxMask'.
+	 */
+	typedef struct xNETWORK_RING
+	{
+		NetworkBufferDescriptor_t **ppxItems;	/* The slots, a power of 2 */
+		UBaseType_t uxMask;						/* The number of slots minus 1 */
+		volatile UBaseType_t uxHead;			/* Counts the packets that were added */
+		volatile UBaseType_t uxTail;			/* Counts the packets that were removed */
+		UBaseType_t uxMinimumSpace;				/* The lowest number of free slots seen by the producer */
+	} NetworkRing_t;
+
+	/*
+	 * Pass a received packet, or a chain of packets linked through
+	 * pxNextBuffer, to the IP-task through the RX ring.  Must always be called
+	 * from the same task, and not from an interrupt.  Returns pdFAIL if the
+	 * ring is full or if the IP-task is not running yet, in which case the
+	 * caller still owns the packet(s).
+	 */
+	BaseType_t xNetworkRxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * The TX ring may be used by a network interface to pass outgoing packets
+	 * from xNetworkInterfaceOutput(), which is called by the IP-task, to its
+	 * own transmit task.  xNetworkTxRingPush() returns pdFAIL if the ring is
+	 * full, pxNetworkTxRingPop() returns NULL if the ring is empty.  It is up to
+	 * the network interface to wake up its transmit task.
+	 */
+	BaseType_t xNetworkTxRingPush( NetworkBufferDescriptor_t *pxNetworkBuffer );
+	NetworkBufferDescriptor_t *pxNetworkTxRingPop( void );
+#endif /* ipconfigUSE_NETWORK_RINGS */
+
+#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	/*
+	 * Called from the RX interrupt of a network interface, after it has masked
+	 * the RX interrupt and before it wakes up its EMAC task.
+	 */
+	void vNetworkRxPollStartFromISR( void );
+
+	/*
+	 * Called by the EMAC task after each pass over the DMA ring, in which it
+	 * read 'uxPacketCount' packets, at most ipconfigNETWORK_RX_POLL_BUDGET.
+	 * When the budget was used up, the function sleeps for one clock tick and
+	 * returns pdTRUE: the task shall poll again, with the RX interrupt still
+	 * masked.  Otherwise it returns pdFALSE: the ring is empty, the task shall
+	 * enable the RX interrupt and look at the ring once more, because a packet
+	 * may have arrived in the mean time.
+	 */
+	BaseType_t xNetworkRxPollComplete( UBaseType_t uxPacketCount );
+#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+
 /*
  * Return the checksum generated over xDataLengthBytes from pucNextData.
  */
 uint16_t usGenerateChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes );
 
+/*
+ * Copy xDataLengthBytes from pucSource to pucDestination and return the same
+ * checksum as usGenerateChecksum() would return for pucDestination.  The data
+ * is only read once.
+ */
+uint16_t usGenerateChecksumCopy( uint32_t ulSum, uint8_t * pucDestination, const uint8_t * pucSource, size_t uxDataLengthBytes );
+
 /* Socket related private functions. */
 
 /* 
@@ -494,6 +609,46 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		} u;
 	} LastTCPPacket_t;
 
+	#if( ipconfigTCP_TX_REFERENCES != 0 )
+		/* A buffer of the application that was sent with FREERTOS_MSG_REFERENCE.
+		It occupies 'uxLength' bytes of the TX stream, starting at 'uxStart',
+		but the data itself is only read from 'pucData'.  An entry is written
+		by the application task before the stream head moves, and it is
+		released by the IP-task once all its bytes have been acknowledged. */
+		typedef struct xTCP_TX_REFERENCE
+		{
+			const uint8_t *pucData;
+			size_t uxStart;
+			size_t uxLength;
+			size_t uxAcked;		/* Number of bytes acknowledged so far, only used by the IP-task */
+		} TCPTxReference_t;
+
+		/* The references are stored in a circular array, of which one entry
+		always remains unused. */
+		#define ipTCP_TX_REFERENCE_SLOTS	( ( UBaseType_t ) ipconfigTCP_TX_REFERENCES + 1u )
+	#endif /* ipconfigTCP_TX_REFERENCES */
+
+	#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+		/* The state of the auto-tuning of the streams of a TCP socket.  The
+		byte counters are only used by the IP-task.  The busy counters are
+		incremented by the task that owns the socket while it accesses a
+		stream, the IP-task will not replace a stream that is busy. */
+		typedef struct xTCP_AUTO_TUNE
+		{
+			TickType_t xPeriodStart;	/* The time at which the current measurement started */
+			uint32_t ulRxBytes;			/* Number of bytes that were delivered to the RX stream in this period */
+			uint32_t ulTxBytes;			/* Number of bytes of the TX stream that were acknowledged in this period */
+			size_t uxRxBaseSize;		/* The configured size of the RX stream, it will not shrink below it */
+			size_t uxTxBaseSize;		/* The configured size of the TX stream */
+			volatile uint8_t ucRxBusy;	/* Non-zero while the owner is reading from the RX stream */
+			volatile uint8_t ucTxBusy;	/* Non-zero while the owner is writing to the TX stream */
+			uint8_t ucTxPinned;			/* FreeRTOS_get_tx_head() was used, the TX stream may not move any more */
+			uint8_t ucRxPinned;			/* FreeRTOS_get_rx_buf() was used, the RX stream may not move any more */
+			uint8_t ucRxFixed;			/* The size of the RX stream was set by the owner, don't tune it */
+			uint8_t ucTxFixed;			/* The size of the TX stream was set by the owner */
+		} TCPAutoTune_t;
+	#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
+
 	/*
 	 * Note that the values of all short and long integers in these structs
 	 * are being stored in the native-endian way
@@ -532,6 +687,10 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
 				bMallocError : 1,	/* There was an error allocating a stream */
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+					bTimeStamps : 1,	/* Both parties sent a time-stamp option in the SYN phase */
+					bTSReceived : 1,	/* The packet being processed carries a time-stamp option */
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
 		uint32_t ulHighestRxAllowed;
@@ -546,6 +705,14 @@ BaseType_t xIPIsNetworkTaskReady( void );
 								 * TCP win segments */
 		uint8_t ucTCPState;		/* TCP state: see eTCP_STATE */
 		struct xSOCKET *pxPeerSocket;	/* for server socket: child, for child socket: parent */
+		#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+			ListItem_t xHashListItem;	/* Used to reference the socket from the TCP lookup hash table. */
+		#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+		#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+			ListItem_t xTimerListItem;	/* Stores the socket in the timer wheel, the ItemValue holds the time of expiry. */
+			ListItem_t xEventListItem;	/* Stores the socket in the list of sockets with pending xEventBits. */
+			ListItem_t xKickListItem;	/* Stores the socket in the list of sockets that a user task has kicked. */
+		#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
 		#if( ipconfigTCP_KEEP_ALIVE == 1 )
 			uint8_t ucKeepRepCount;
 			TickType_t xLastAliveTime;
@@ -559,6 +726,15 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		size_t uxTxStreamSize;
 		StreamBuffer_t *rxStream;
 		StreamBuffer_t *txStream;
+		#if( ipconfigTCP_TX_REFERENCES != 0 )
+			TCPTxReference_t xTxReferences[ ipTCP_TX_REFERENCE_SLOTS ];
+			volatile UBaseType_t uxTxRefHead;	/* Next entry to be used, written by the application */
+			volatile UBaseType_t uxTxRefTail;	/* Oldest entry in use, written by the IP-task */
+			FOnTCPTxReference_t pxHandleTxReference;
+		#endif /* ipconfigTCP_TX_REFERENCES */
+		#if( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+			TCPAutoTune_t xAutoTune;
+		#endif /* ipconfigTCP_AUTO_TUNE_BUFFERS */
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
@@ -569,6 +745,11 @@ BaseType_t xIPIsNetworkTaskReady( void );
 			uint8_t ucMyWinScaleFactor;
 			uint8_t ucPeerWinScaleFactor;
 		#endif
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+			uint32_t ulTSRecent;	/* TS.Recent: the time-stamp of the peer which is echoed in every packet sent */
+			uint32_t ulTSValue;		/* TSval of the packet being processed */
+			uint32_t ulTSEcho;		/* TSecr of the packet being processed, or zero when absent */
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 		#if( ipconfigUSE_CALLBACKS == 1 )
 			FOnTCPReceive_t pxHandleReceive;	/*
 										 		 * In case of a TCP socket:
@@ -589,6 +770,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 typedef struct UDPSOCKET
 {
 	List_t xWaitingPacketsList;	/* Incoming packets */
+	#if( ipconfigUSE_UDP_HASH_LOOKUP == 1 )
+		ListItem_t xHashListItem;	/* Used to reference the socket from the UDP port hash table. */
+	#endif /* ipconfigUSE_UDP_HASH_LOOKUP */
 	#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
 		UBaseType_t uxMaxPackets; /* Protection: limits the number of packets buffered per socket */
 	#endif /* ipconfigUDP_MAX_RX_PACKETS */
@@ -662,6 +846,56 @@ typedef struct xSOCKET
 	 */
 	FreeRTOS_Socket_t *pxTCPSocketLookup( uint32_t ulLocalIP, UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort );
 
+	#if( ipconfigUSE_TCP_HASH_LOOKUP == 1 )
+		/*
+		 * Must be called after the state, the remote IP address or the remote
+		 * port of a bound TCP socket has changed, so it moves to the right
+		 * bucket of the lookup table.
+		 */
+		void vTCPSocketHashUpdate( FreeRTOS_Socket_t *pxSocket );
+	#endif /* ipconfigUSE_TCP_HASH_LOOKUP */
+
+	#if( ipconfigUSE_TCP_TIMER_WHEEL != 0 )
+		/*
+		 * Take a socket out of the timer wheel before its field 'usTimeout' may
+		 * change.  'usTimeout' will be set to the time that remains.  Only to be
+		 * called from the IP-task.
+		 */
+		void vTCPTimerSync( FreeRTOS_Socket_t *pxSocket );
+
+		/*
+		 * Store a socket in the timer wheel according to its field 'usTimeout',
+		 * and remember it if it has pending xEventBits.  Only to be called from
+		 * the IP-task, after vTCPTimerSync().
+		 */
+		void vTCPTimerUpdate( FreeRTOS_Socket_t *pxSocket );
+
+		/*
+		 * Remember that a socket has pending xEventBits, its owner will be
+		 * woken up before the IP-task goes asleep.
+		 */
+		void vTCPTimerEventPending( FreeRTOS_Socket_t *pxSocket );
+
+		/*
+		 * The IP-task asks for attention for a socket, as if 'usTimeout' had
+		 * been set to 1.
+		 */
+		void vTCPTimerKick( FreeRTOS_Socket_t *pxSocket );
+
+		/*
+		 * Kick the sockets that user tasks have asked attention for.  Called by
+		 * the IP-task on every loop, so a socket is not forgotten when its
+		 * eTCPTimerEvent could not be queued.  Returns pdTRUE when at least one
+		 * socket was kicked.
+		 */
+		BaseType_t xTCPTimerProcessKicks( void );
+
+		/*
+		 * Called when a socket gets closed.
+		 */
+		void vTCPTimerRemove( FreeRTOS_Socket_t *pxSocket );
+	#endif /* ipconfigUSE_TCP_TIMER_WHEEL */
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -683,6 +917,16 @@ void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuff
  */
 uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength, BaseType_t xOutgoingPacket );
 
+#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+	/*
+	 * Same as usGenerateProtocolChecksum() for an outgoing packet, but the
+	 * checksum of the last 'uxPayloadLength' bytes is already known.  When
+	 * 'uxPayloadLength' is zero, the whole packet will be summed.
+	 */
+	uint16_t usGenerateProtocolChecksumWithPayload( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength,
+		uint16_t usPayloadChecksum, size_t uxPayloadLength );
+#endif /* ipconfigUSE_CHECKSUM_COPY */
+
 /*
  * An Ethernet frame has been updated (maybe it was an ARP request or a PING
  * request?) and is to be sent back to its source.
@@ -778,6 +1022,24 @@ NetworkBufferDescriptor_t *pxUDPPayloadBuffer_to_NetworkBuffer( void *pvBuffer )
 	void vTCPStateChange( FreeRTOS_Socket_t *pxSocket, enum eTCP_STATE eTCPState );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_REFERENCES != 0 )
+	/*
+	 * Internal: return all buffers that a TCP socket holds by reference to
+	 * the application, as being not delivered.  Called when the socket is
+	 * closed.
+	 */
+	void vTCPTxReferencesRelease( FreeRTOS_Socket_t *pxSocket );
+#endif
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	/*
+	 * Internal: called by the IP-task when checking a TCP socket.  Once per
+	 * measurement period, see if its streams should grow or shrink, and
+	 * replace them if possible.
+	 */
+	void vTCPAutoTuneStreams( FreeRTOS_Socket_t *pxSocket );
+#endif
+
 /*_RB_ Should this be part of the public API? */
 void FreeRTOS_netstat( void );
 
@@ -803,6 +1065,10 @@ void vIPReloadDHCPTimer( uint32_t ulLeaseTime );
 	void vIPReloadDNSTimer( uint32_t ulCheckTime );
 	void vIPSetDnsTimerEnableState( BaseType_t xEnableState );
 #endif
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	void vIPReloadARPPendingTimer( uint32_t ulCheckTime );
+	void vIPSetARPPendingTimerEnableState( BaseType_t xEnableState );
+#endif
 
 /* Send the network-up event and start the ARP timer. */
 void vIPNetworkUpCalls( void );
@@ -132,6 +132,10 @@ FreeRTOS_setsockopt(). */
 
 #define FREERTOS_SO_SET_LOW_HIGH_WATER	( 18 )
 
+#if( ipconfigTCP_TX_REFERENCES != 0 )
+	#define FREERTOS_SO_TCP_TX_REF_HANDLER	( 19 )		/* Install a callback that returns buffers sent with FREERTOS_MSG_REFERENCE. Supply pointer to 'F_TCP_UDP_Handler_t' (see below) */
+#endif
+
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 
@@ -145,6 +149,7 @@ FreeRTOS_setsockopt(). */
 #define FREERTOS_MSG_PEEK				( 4 )		/* peek at incoming message */
 #define FREERTOS_MSG_DONTROUTE			( 8 )		/* send without using routing tables */
 #define FREERTOS_MSG_DONTWAIT			( 16 )		/* Can be used with recvfrom(), sendto(), recv(), and send(). */
+#define FREERTOS_MSG_REFERENCE			( 32 )		/* send() and sendv(): do not copy the data but refer to it, see ipconfigTCP_TX_REFERENCES. */
 
 typedef struct xWIN_PROPS {
 	/* Properties of the Tx buffer and Tx window */
@@ -231,6 +236,36 @@ int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLengt
 int32_t FreeRTOS_sendto( Socket_t xSocket, const void *pvBuffer, size_t xTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, socklen_t xDestinationAddressLength );
 BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength );
 
+#if( ipconfigSUPPORT_UDP_BATCH != 0 )
+	/* One element of the arrays passed to FreeRTOS_sendmmsg() and
+	FreeRTOS_recvmmsg(). */
+	typedef struct xFREERTOS_MMSG
+	{
+		void *pvBuffer;						/* The payload.  With FREERTOS_ZERO_COPY: a buffer from FreeRTOS_GetUDPPayloadBuffer() when sending, set by the stack when receiving. */
+		size_t uxLength;					/* The length of the payload.  When receiving: the size of 'pvBuffer', on return the number of bytes stored. */
+		struct freertos_sockaddr xAddress;	/* The destination when sending, the source when receiving. */
+	} FreeRTOS_mmsg_t;
+
+	/*
+	 * Send up to 'xMessageCount' datagrams with a single message to the
+	 * IP-task.  The send block time applies to the whole batch.  Returns the
+	 * number of datagrams that were passed to the IP-task, which is less than
+	 * 'xMessageCount' when a datagram is too long or when no network buffer
+	 * could be obtained.  With FREERTOS_ZERO_COPY, the buffers of the messages
+	 * that were not sent remain owned by the caller.
+	 */
+	BaseType_t FreeRTOS_sendmmsg( Socket_t xSocket, const FreeRTOS_mmsg_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags );
+
+	/*
+	 * Wait for datagrams like FreeRTOS_recvfrom(), and return up to
+	 * 'xMessageCount' of them at once.  Returns the number of datagrams
+	 * stored in 'pxMessages', or a negative error code.  FREERTOS_MSG_PEEK is
+	 * not supported.  With FREERTOS_ZERO_COPY, each 'pvBuffer' must be
+	 * released with FreeRTOS_ReleaseUDPPayloadBuffer().
+	 */
+	BaseType_t FreeRTOS_recvmmsg( Socket_t xSocket, FreeRTOS_mmsg_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags );
+#endif /* ipconfigSUPPORT_UDP_BATCH */
+
 /* function to get the local address and IP port */
 size_t FreeRTOS_GetLocalAddress( Socket_t xSocket, struct freertos_sockaddr *pxAddress );
 
@@ -296,6 +331,57 @@ FreeRTOS_rx_size(). */
  */
 uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength );
 
+/* One element of the array passed to FreeRTOS_sendv(). */
+typedef struct xFREERTOS_IOVEC
+{
+	const void *pvBase;		/* The data to be sent. */
+	size_t uxLength;		/* The number of bytes at 'pvBase'. */
+} FreeRTOS_iovec_t;
+
+/*
+ * Send the contents of 'xVectorCount' buffers as one stream of data, with a
+ * single call.  Blocking and the return value are the same as for
+ * FreeRTOS_send(): the number of bytes that were accepted in total.
+ *
+ * When ipconfigTCP_TX_REFERENCES is non-zero and 'xFlags' contains
+ * FREERTOS_MSG_REFERENCE, the data will not be copied into the socket.  The
+ * buffers are then owned by the socket until they are returned through the
+ * FREERTOS_SO_TCP_TX_REF_HANDLER call-back, and they may not be changed in
+ * the mean time.  A buffer that is accepted partially will be returned in
+ * more than one call.
+ */
+BaseType_t FreeRTOS_sendv( Socket_t xSocket, const FreeRTOS_iovec_t *pxVector, BaseType_t xVectorCount, BaseType_t xFlags );
+
+/*
+ * For advanced applications only:
+ * Zero-copy reception that returns all data in the circular receive buffer.
+ * 'pxSpans' must point to an array of 2 elements: the first one describes the
+ * data up to the end of the buffer, the second one the data that wrapped
+ * around to its start (or a length of zero).  The function blocks and returns
+ * the same as FreeRTOS_recv(), but the result is the total length of both
+ * spans.  No data is consumed until FreeRTOS_recv_consume() is called, which
+ * returns the number of bytes actually consumed.  Only the task that owns the
+ * socket may call these functions.
+ */
+BaseType_t FreeRTOS_recv_spans( Socket_t xSocket, FreeRTOS_iovec_t *pxSpans, BaseType_t xFlags );
+BaseType_t FreeRTOS_recv_consume( Socket_t xSocket, size_t uxCount );
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+	/* The congestion control state of a TCP socket, as returned by
+	FreeRTOS_GetTCPCongestionStats().  All sizes are in bytes. */
+	typedef struct xTCP_CONGESTION_STATS
+	{
+		uint32_t ulCongestionWindow;	/* The current congestion window (cwnd) */
+		uint32_t ulSlowStartThreshold;	/* The current slow start threshold (ssthresh) */
+		uint32_t ulMaxCongestionWindow;	/* The highest value that cwnd has reached */
+		uint32_t ulFastRecoveryCount;	/* Number of times that fast recovery was entered */
+		uint32_t ulTimeoutCount;		/* Number of retransmission time-outs */
+	} TCPCongestionStats_t;
+
+	/* Read the congestion control state of a TCP socket. */
+	BaseType_t FreeRTOS_GetTCPCongestionStats( Socket_t xSocket, TCPCongestionStats_t *pxStats );
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -326,6 +412,14 @@ typedef void (* FOnConnected_t )( Socket_t /* xSocket */, BaseType_t /* ulConnec
 typedef BaseType_t (* FOnTCPReceive_t )( Socket_t /* xSocket */, void * /* pData */, size_t /* xLength */ );
 typedef void (* FOnTCPSent_t )( Socket_t /* xSocket */, size_t /* xLength */ );
 
+/*
+ * Return a buffer that was passed with FREERTOS_MSG_REFERENCE, or a part of
+ * it.  'xDelivered' is pdTRUE when the peer has acknowledged all its data, and
+ * pdFALSE when the socket was closed before that.  The handler is called from
+ * the IP-task.
+ */
+typedef void (* FOnTCPTxReference_t )( Socket_t /* xSocket */, const void * /* pvBuffer */, size_t /* xLength */, BaseType_t /* xDelivered */ );
+
 /*
  * Reception handler for a UDP socket
  * A user-proved function will be called on reception of a message
@@ -341,6 +435,7 @@ typedef union xTCP_UDP_HANDLER
 	FOnConnected_t	pxOnTCPConnected;	/* FREERTOS_SO_TCP_CONN_HANDLER */
 	FOnTCPReceive_t	pxOnTCPReceive;		/* FREERTOS_SO_TCP_RECV_HANDLER */
 	FOnTCPSent_t	pxOnTCPSent;		/* FREERTOS_SO_TCP_SENT_HANDLER */
+	FOnTCPTxReference_t	pxOnTCPTxReference;	/* FREERTOS_SO_TCP_TX_REF_HANDLER */
 	FOnUDPReceive_t	pxOnUDPReceive;		/* FREERTOS_SO_UDP_RECV_HANDLER */
 	FOnUDPSent_t	pxOnUDPSent;		/* FREERTOS_SO_UDP_SENT_HANDLER */
 } F_TCP_UDP_Handler_t;
@@ -358,6 +453,30 @@ const struct xSTREAM_BUFFER *FreeRTOS_get_rx_buf( Socket_t xSocket );
 
 void FreeRTOS_netstat( void );
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+
+	/* Counters that describe how listening sockets handled connection
+	requests. */
+	typedef struct xTCP_LISTEN_STATISTICS
+	{
+		uint32_t ulSynReceived;		/* SYN's received by a listening socket. */
+		uint32_t ulSynRepeated;		/* Repeated SYN's, answered from the SYN cache. */
+		uint32_t ulSynDropped;		/* SYN's dropped because the socket had too many half-open connections. */
+		uint32_t ulSynEvictions;	/* Half-open connections overwritten by a newer one. */
+		uint32_t ulCookiesSent;		/* SYN+ACK's sent with a SYN cookie. */
+		uint32_t ulCookiesAccepted;	/* Final ACK's with a valid SYN cookie. */
+		uint32_t ulBadAcks;			/* ACK's that matched neither the cache nor a SYN cookie. */
+		uint32_t ulBacklogFull;		/* SYN's refused because the socket had reached its backlog. */
+		uint32_t ulAcceptQueueFull;	/* Final ACK's dropped because the socket had reached its backlog. */
+		uint32_t ulChildFailed;		/* Child sockets that could not be created. */
+		uint32_t ulConnections;		/* Child sockets created after a complete handshake. */
+	} TCPListenStatistics_t;
+
+	/* Obtain a copy of the counters of the listening sockets. */
+	void FreeRTOS_GetTCPListenStatistics( TCPListenStatistics_t *pxStatistics );
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
 #if ipconfigSUPPORT_SELECT_FUNCTION == 1
 
 	/* For FD_SET and FD_CLR, a combination of the following bits can be used: */
@@ -224,6 +224,17 @@ size_t uxStreamBufferAdd( StreamBuffer_t *pxBuffer, size_t uxOffset, const uint8
  */
 size_t uxStreamBufferGet( StreamBuffer_t *pxBuffer, size_t uxOffset, uint8_t *pucData, size_t uxMaxCount, BaseType_t xPeek );
 
+#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+	/*
+	 * Same as uxStreamBufferGet() in peek mode, but also calculate the
+	 * checksum of the bytes copied, as usGenerateChecksum() would return it
+	 * for 'pucData'.
+	 *
+	 * pusChecksum -	Receives the checksum.
+	 */
+	size_t uxStreamBufferGetChecksum( StreamBuffer_t *pxBuffer, size_t uxOffset, uint8_t *pucData, size_t uxMaxCount, uint16_t *pusChecksum );
+#endif /* ipconfigUSE_CHECKSUM_COPY */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
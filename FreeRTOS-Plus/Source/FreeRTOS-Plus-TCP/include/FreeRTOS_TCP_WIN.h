@@ -65,6 +65,11 @@ typedef struct xTCP_SEGMENT
 #if( ipconfigUSE_TCP_WIN != 0 )
 	struct xLIST_ITEM xQueueItem;	/* TX only: segments can be linked in one of three queues: xPriorityQueue, xTxQueue, and xWaitQueue */
 	struct xLIST_ITEM xListItem;	/* With this item the segment can be connected to a list, depending on who is owning it */
+	#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		struct xTCP_SEGMENT *pxRxLeft;	/* RX only: the subtree with lower sequence numbers */
+		struct xTCP_SEGMENT *pxRxRight;	/* RX only: the subtree with higher sequence numbers */
+		BaseType_t xRxHeight;			/* RX only: the height of the subtree of which this segment is the root */
+	#endif
 #endif
 } TCPSegment_t;
 
@@ -74,13 +79,42 @@ typedef struct xTCP_WINSIZE
 	uint32_t ulTxWindowLength;
 } TCPWinSize_t;
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+	/* Congestion control state, maintained by the IP-task. */
+	typedef struct xTCP_CONGESTION
+	{
+		uint32_t ulCongestionWindow;		/* cwnd: the number of bytes that may be outstanding */
+		uint32_t ulSlowStartThreshold;		/* ssthresh: below this value cwnd grows exponentially (slow start) */
+		uint32_t ulRecoverSequenceNumber;	/* The highest sequence number sent when the last loss was detected */
+		uint32_t ulBytesAcked;				/* Congestion avoidance: bytes acknowledged since cwnd was last increased */
+		BaseType_t xInRecovery;				/* pdTRUE while in fast recovery */
+	#if( ipconfigTCP_CONGESTION_ALGORITHM == 1 )
+		TCPTimer_t xEpochTimer;				/* CUBIC: started at the first ACK after a reduction */
+		BaseType_t xEpochStarted;			/* CUBIC: pdTRUE if xEpochTimer is running */
+		uint32_t ulLastMaxWindow;			/* CUBIC: W_max, cwnd just before the last reduction */
+		uint32_t ulOriginPoint;				/* CUBIC: the window at the plateau of the cubic function */
+		uint32_t ulCubicK;					/* CUBIC: msec needed to grow back to ulOriginPoint */
+		uint32_t ulRenoWindow;				/* CUBIC: the window that standard TCP would have (W_est) */
+	#endif
+		/* Statistics, see FreeRTOS_GetTCPCongestionStats(). */
+		uint32_t ulMaxCongestionWindow;		/* The highest value that cwnd has reached */
+		uint32_t ulFastRecoveryCount;		/* Number of times that fast recovery was entered */
+		uint32_t ulTimeoutCount;			/* Number of retransmission time-outs */
+	} TCPCongestion_t;
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 /*
  * If TCP time-stamps are being used, they will occupy 12 bytes in
  * each packet, and thus the message space will become smaller
  */
 /* Keep this as a multiple of 4 */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	#define ipSIZE_TCP_OPTIONS	16u
+	/* The maximum number of blocks in an outgoing SACK option.  4 blocks
+	occupy 2 + 4 * 8 = 34 bytes, which is padded to 36 with 2 NOP's.  When
+	time-stamps are used (12 bytes), only 3 blocks will fit in the 40 bytes
+	that the TCP header allows. */
+	#define ipTCP_MAX_SACK_BLOCKS	4u
+	#define ipSIZE_TCP_OPTIONS	40u
 #else
 	#define ipSIZE_TCP_OPTIONS   12u
 #endif
@@ -98,6 +132,9 @@ typedef struct xTCP_WINDOW
 			uint32_t
 				bHasInit : 1,		/* The window structure has been initialised */
 				bSendFullSize : 1,	/* May only send packets with a size equal to MSS (for optimisation) */
+			#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+				bRTTMeasured : 1,	/* At least one RTT sample was taken, lRTTVAR is valid */
+			#endif
 				bTimeStamps : 1;	/* Socket is supposed to use TCP time-stamps. This depends on the */
 		} bits;						/* party which opens the connection */
 		uint32_t ulFlags;
@@ -117,6 +154,10 @@ typedef struct xTCP_WINDOW
 	uint32_t ulUserDataLength;			/* Number of bytes in Rx buffer which may be passed to the user, after having received a 'missing packet' */
 	uint32_t ulNextTxSequenceNumber;	/* The sequence number given to the next byte to be added for transmission */
 	int32_t lSRTT;						/* Smoothed Round Trip Time, it may increment quickly and it decrements slower */
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	int32_t lRTTVAR;					/* The variation of the Round Trip Time (RFC 6298) */
+	int32_t lRTO;						/* Retransmission Time-Out in ms: SRTT + 4 * RTTVAR */
+#endif
 	uint8_t ucOptionLength;				/* Number of valid bytes in ulOptionsData[] */
 #if( ipconfigUSE_TCP_WIN == 1 )
 	List_t xPriorityQueue;				/* Priority queue: segments which must be sent immediately */
@@ -124,8 +165,17 @@ typedef struct xTCP_WINDOW
 	List_t xWaitQueue;					/* Waiting queue:  outstanding segments */
 	TCPSegment_t *pxHeadSegment;		/* points to a segment which has not been transmitted and it's size is still growing (user data being added) */
 	uint32_t ulOptionsData[ipSIZE_TCP_OPTIONS/sizeof(uint32_t)];	/* Contains the options we send out */
+	uint32_t ulSackBlocks[ 2 * ipTCP_MAX_SACK_BLOCKS ];	/* Rx: the blocks of the last SACK sent, pairs of first and last + 1, the most recent first */
+	uint8_t ucSackBlockCount;			/* Rx: number of valid pairs in ulSackBlocks[] */
+	uint32_t ulSackRecoveryCount;		/* Tx: number of times that lost segments were retransmitted based on SACK information */
 	List_t xTxSegments;					/* A linked list of all transmission segments, sorted on sequence number */
 	List_t xRxSegments;					/* A linked list of reception segments, order depends on sequence of arrival */
+	#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+		TCPSegment_t *pxRxTree;			/* The segments of xRxSegments in an AVL tree, sorted on sequence number */
+	#endif
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 1 )
+		TCPCongestion_t xCongestion;	/* Congestion window and its statistics */
+	#endif
 #else
 	/* For tiny TCP, there is only 1 outstanding TX segment */
 	TCPSegment_t xTxSegment;			/* Priority queue */
@@ -205,6 +255,25 @@ uint32_t ulTCPWindowTxAck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 /* Receive a SACK option */
 uint32_t ulTCPWindowTxSack( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast );
 
+/* To be called after all blocks of a SACK option have been passed to
+ * ulTCPWindowTxSack().  All segments that are considered lost will be queued
+ * for retransmission.  Returns the number of segments queued. */
+uint32_t ulTCPWindowTxSackComplete( TCPWindow_t *pxWindow );
+
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_AUTO_TUNE_BUFFERS != 0 )
+	/* The TX stream has been replaced by a larger or smaller one, to which its
+	 * contents were copied starting at 'lOldTail'.  Translate the stream
+	 * positions of all TX segments. */
+	void vTCPWindowTxRebase( TCPWindow_t *pxWindow, int32_t lOldTail, int32_t lOldLength );
+#endif
+
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	/* A new Round Trip Time was measured (in ms), either from an echoed
+	 * time-stamp or from the age of an ACK'd segment.  Update the smoothed RTT,
+	 * its variance and the RTO (RFC 6298). */
+	void vTCPWindowRTTSample( TCPWindow_t *pxWindow, uint32_t ulRTT );
+#endif
+
 
 #ifdef __cplusplus
 }	/* extern "C" */
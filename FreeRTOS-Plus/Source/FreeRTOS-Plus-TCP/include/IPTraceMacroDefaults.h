@@ -78,6 +78,26 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptracePACKET_DROPPED_TO_GENERATE_ARP( ulIPAddress )
 #endif
 
+#ifndef iptraceSENDING_FRAGMENTED_UDP_PACKET
+	#define iptraceSENDING_FRAGMENTED_UDP_PACKET( ulIPAddress, uxLength )
+#endif
+
+#ifndef iptraceIP_FRAGMENT_RECEIVED
+	#define iptraceIP_FRAGMENT_RECEIVED( ulIPAddress, usIdentification, uxOffset )
+#endif
+
+#ifndef iptraceIP_FRAGMENT_DROPPED
+	#define iptraceIP_FRAGMENT_DROPPED( ulIPAddress, usIdentification )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_COMPLETE
+	#define iptraceIP_REASSEMBLY_COMPLETE( ulIPAddress, usIdentification, uxLength )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_TIMEOUT
+	#define iptraceIP_REASSEMBLY_TIMEOUT( ulIPAddress, usIdentification )
+#endif
+
 #ifndef iptraceICMP_PACKET_RECEIVED
 	#define iptraceICMP_PACKET_RECEIVED()
 #endif
@@ -150,6 +170,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceNETWORK_INTERFACE_RECEIVE()
 #endif
 
+#ifndef iptraceNETWORK_INTERFACE_RX_BATCH
+	#define iptraceNETWORK_INTERFACE_RX_BATCH( uxCount )
+#endif
+
 #ifndef iptraceSENDING_DNS_REQUEST
 	#define iptraceSENDING_DNS_REQUEST()
 #endif
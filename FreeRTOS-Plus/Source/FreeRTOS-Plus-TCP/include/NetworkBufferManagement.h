@@ -54,6 +54,21 @@ In case BufferAllocation_2.c is used, the new space must be allocated. */
 NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer,
 	size_t xNewSizeBytes );
 
+/* Statistics of one slab of BufferAllocation_3.c. */
+typedef struct xNETWORK_BUFFER_SLAB_STATS
+{
+	size_t uxBlockSize;			/* The number of usable bytes in each block */
+	UBaseType_t uxBlockCount;	/* The number of blocks in the slab */
+	UBaseType_t uxInUse;		/* The number of blocks currently in use */
+	UBaseType_t uxMaxInUse;		/* The highest number of blocks that were in use at the same time */
+	UBaseType_t uxExhausted;	/* The number of times a request found the slab empty */
+} NetworkBufferSlabStats_t;
+
+/* Only implemented by BufferAllocation_3.c: get the statistics of the slab
+with index 'uxIndex', starting with the smallest blocks.  Returns pdFAIL when
+there is no slab with that index. */
+BaseType_t xGetNetworkBufferSlabStats( UBaseType_t uxIndex, NetworkBufferSlabStats_t *pxStats );
+
 #if ipconfigTCP_IP_SANITY
 	/*
 	 * Check if an address is a valid pointer to a network descriptor
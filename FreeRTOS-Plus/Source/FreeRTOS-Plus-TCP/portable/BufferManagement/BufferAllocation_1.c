@@ -280,6 +280,13 @@ UBaseType_t uxCount;
 					pxReturn->pxNextBuffer = NULL;
 				}
 				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+				#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+				{
+					/* No payload checksum has been calculated yet. */
+					pxReturn->usPayloadLength = 0u;
+				}
+				#endif /* ipconfigUSE_CHECKSUM_COPY */
 			}
 			iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
 		}
@@ -0,0 +1,742 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/******************************************************************************
+ *
+ * See the following web page for essential buffer allocation scheme usage and
+ * configuration details:
+ * http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/Embedded_Ethernet_Buffer_Management.html
+ *
+ ******************************************************************************/
+
+/* Like BufferAllocation_2.c, this scheme gives each network buffer storage of
+(about) the requested size.  The storage is not obtained from the heap, but from
+a static arena that is divided into slabs of fixed size blocks.  Each slab has
+its own free list, so allocation and release take a constant time and the arena
+can not become fragmented.  When a slab is exhausted, a block from the next
+larger slab will be used.  Buffers can be obtained and released from tasks and
+from interrupts. */
+
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_UDP_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* The obtained network buffer must be large enough to hold a packet that might
+replace the packet that was requested to be sent. */
+#if ipconfigUSE_TCP == 1
+	#define baMINIMAL_BUFFER_SIZE		sizeof( TCPPacket_t )
+#else
+	#define baMINIMAL_BUFFER_SIZE		sizeof( ARPPacket_t )
+#endif /* ipconfigUSE_TCP == 1 */
+
+/* For an Ethernet interrupt to be able to obtain a network buffer there must
+be at least this number of buffers available. */
+#define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
+
+/* The number of blocks in each slab.  The block sizes are 128, 256 and 512
+bytes, and a block that can hold a complete Ethernet frame. */
+#ifndef ipconfigBUFFER_SLAB_COUNT_128
+	#define ipconfigBUFFER_SLAB_COUNT_128		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 2 )
+#endif
+
+#ifndef ipconfigBUFFER_SLAB_COUNT_256
+	#define ipconfigBUFFER_SLAB_COUNT_256		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+#endif
+
+#ifndef ipconfigBUFFER_SLAB_COUNT_512
+	#define ipconfigBUFFER_SLAB_COUNT_512		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+#endif
+
+#ifndef ipconfigBUFFER_SLAB_COUNT_LARGE
+	#define ipconfigBUFFER_SLAB_COUNT_LARGE		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS )
+#endif
+
+/* The usable size of the largest block: a maximum size Ethernet frame plus the
+2 bytes that are added to each request, rounded up to a multiple of 32. */
+#define baLARGE_BLOCK_SIZE			( ( ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE + 2u + 31u ) & ~( ( size_t ) 31u ) )
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* Reassembled datagrams, and UDP datagrams that will be sent in fragments,
+	need a buffer of up to ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE bytes plus
+	an Ethernet header. */
+	#ifndef ipconfigBUFFER_SLAB_COUNT_JUMBO
+		#define ipconfigBUFFER_SLAB_COUNT_JUMBO		( 2 )
+	#endif
+
+	#define baJUMBO_BLOCK_SIZE		( ( ( size_t ) ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE + ipSIZE_OF_ETH_HEADER + 2u + 31u ) & ~( ( size_t ) 31u ) )
+	#define baSLAB_CLASS_COUNT		( 5 )
+#else
+	#define baSLAB_CLASS_COUNT		( 4 )
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
+/* The number of bytes that a block occupies in the arena: the usable size plus
+the space in which a pointer to the network buffer descriptor is stored.  Keep
+the blocks aligned to 8 bytes. */
+#define baSLAB_BLOCK_BYTES( xSize )	( ( ( size_t ) ( xSize ) + ipBUFFER_PADDING + 7u ) & ~( ( size_t ) 7u ) )
+
+#define baSLAB_ARENA_BYTES	\
+	( ( baSLAB_BLOCK_BYTES( 128u ) * ( size_t ) ipconfigBUFFER_SLAB_COUNT_128 ) + \
+	  ( baSLAB_BLOCK_BYTES( 256u ) * ( size_t ) ipconfigBUFFER_SLAB_COUNT_256 ) + \
+	  ( baSLAB_BLOCK_BYTES( 512u ) * ( size_t ) ipconfigBUFFER_SLAB_COUNT_512 ) + \
+	  ( baSLAB_BLOCK_BYTES( baLARGE_BLOCK_SIZE ) * ( size_t ) ipconfigBUFFER_SLAB_COUNT_LARGE ) + \
+	  baSLAB_ARENA_BYTES_JUMBO )
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	#define baSLAB_ARENA_BYTES_JUMBO	( baSLAB_BLOCK_BYTES( baJUMBO_BLOCK_SIZE ) * ( size_t ) ipconfigBUFFER_SLAB_COUNT_JUMBO )
+#else
+	#define baSLAB_ARENA_BYTES_JUMBO	( 0u )
+#endif
+
+/* The administration of one slab. */
+typedef struct xSLAB_CLASS
+{
+	uint8_t *pucFirst;			/* The first block of the slab */
+	uint8_t *pucLimit;			/* Points just beyond the last block of the slab */
+	size_t uxBlockSize;			/* The number of usable bytes in a block */
+	size_t uxBlockBytes;		/* The distance between two blocks */
+	void *pvFreeList;			/* Free blocks, linked through their first word */
+	UBaseType_t uxBlockCount;	/* The number of blocks in the slab */
+	UBaseType_t uxInUse;		/* The number of blocks currently allocated */
+	UBaseType_t uxMaxInUse;		/* The highest value of uxInUse: high-water mark */
+	UBaseType_t uxExhausted;	/* The number of requests that found the slab empty */
+} SlabClass_t;
+
+/* A list of free (available) NetworkBufferDescriptor_t structures. */
+static List_t xFreeBuffersList;
+
+/* Some statistics about the use of buffers. */
+static UBaseType_t uxMinimumFreeNetworkBuffers;
+
+/* Declares the pool of NetworkBufferDescriptor_t structures that are available
+to the system.  All the network buffers referenced from xFreeBuffersList exist
+in this array.  The array is not accessed directly except during initialisation,
+when the xFreeBuffersList is filled (as all the buffers are free when the system
+is booted). */
+static NetworkBufferDescriptor_t xNetworkBufferDescriptors[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* The memory from which all blocks are taken.  Declared as an array of
+'uint64_t' to make sure that it is properly aligned. */
+static uint64_t ullSlabArena[ ( baSLAB_ARENA_BYTES + 7u ) / 8u ];
+
+/* The slabs, sorted from small to large. */
+static SlabClass_t xSlabClasses[ baSLAB_CLASS_COUNT ];
+
+/* This constant is defined as false to let FreeRTOS_TCP_IP.c know that the
+network buffers have a variable size: resizing may be necessary */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+/* The semaphore used to obtain network buffers. */
+static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
+
+/* The user can define their own ipconfigBUFFER_ALLOC_LOCK() and
+ipconfigBUFFER_ALLOC_UNLOCK() macros, especially for use form an ISR.  If these
+are not defined then default them to call the normal enter/exit critical
+section macros. */
+#if !defined( ipconfigBUFFER_ALLOC_LOCK )
+
+	#define ipconfigBUFFER_ALLOC_INIT( ) do {} while (0)
+	#define ipconfigBUFFER_ALLOC_LOCK_FROM_ISR()		\
+		UBaseType_t uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR(); \
+		{
+
+	#define ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR()		\
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus ); \
+		}
+
+	#define ipconfigBUFFER_ALLOC_LOCK()					taskENTER_CRITICAL()
+	#define ipconfigBUFFER_ALLOC_UNLOCK()				taskEXIT_CRITICAL()
+
+#endif /* ipconfigBUFFER_ALLOC_LOCK */
+
+/*
+ * Divide the arena in slabs and link all blocks into the free lists.
+ */
+static void prvSlabInitialise( void );
+
+/*
+ * Take a block that has at least 'xSize' usable bytes.  Returns a pointer
+ * to the usable part, or NULL when no block is available.  Must be called
+ * while the structures are locked.
+ */
+static uint8_t *prvSlabAlloc( size_t xSize );
+
+/*
+ * Return a block to its slab.  'pucBuffer' points to the usable part of the
+ * block.  Must be called while the structures are locked.
+ */
+static void prvSlabFree( uint8_t *pucBuffer );
+
+/*
+ * Adjust a requested size in the same way as BufferAllocation_2.c does.
+ */
+static size_t prvRequestedSize( size_t xRequestedSizeBytes );
+
+/*
+ * Initialise a descriptor that was just taken from the free list and that got
+ * storage attached.
+ */
+static void prvPrepareDescriptor( NetworkBufferDescriptor_t *pxNetworkBuffer, uint8_t *pucBuffer, size_t xRequestedSizeBytes );
+
+/*-----------------------------------------------------------*/
+
+static void prvSlabInitialise( void )
+{
+static const size_t uxBlockSizes[ baSLAB_CLASS_COUNT ] =
+{
+	128u, 256u, 512u, baLARGE_BLOCK_SIZE,
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+		baJUMBO_BLOCK_SIZE
+	#endif
+};
+static const UBaseType_t uxBlockCounts[ baSLAB_CLASS_COUNT ] =
+{
+	ipconfigBUFFER_SLAB_COUNT_128, ipconfigBUFFER_SLAB_COUNT_256, ipconfigBUFFER_SLAB_COUNT_512, ipconfigBUFFER_SLAB_COUNT_LARGE,
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+		ipconfigBUFFER_SLAB_COUNT_JUMBO
+	#endif
+};
+uint8_t *pucBlock = ( uint8_t * ) ullSlabArena;
+SlabClass_t *pxClass;
+UBaseType_t uxClass, uxBlock;
+
+	for( uxClass = 0u; uxClass < ( UBaseType_t ) baSLAB_CLASS_COUNT; uxClass++ )
+	{
+		pxClass = &( xSlabClasses[ uxClass ] );
+		pxClass->uxBlockSize = uxBlockSizes[ uxClass ];
+		pxClass->uxBlockBytes = baSLAB_BLOCK_BYTES( uxBlockSizes[ uxClass ] );
+		pxClass->uxBlockCount = uxBlockCounts[ uxClass ];
+		pxClass->uxInUse = 0u;
+		pxClass->uxMaxInUse = 0u;
+		pxClass->uxExhausted = 0u;
+		pxClass->pvFreeList = NULL;
+		pxClass->pucFirst = pucBlock;
+
+		/* Link the blocks in the free list, the lowest address first. */
+		pucBlock += pxClass->uxBlockBytes * pxClass->uxBlockCount;
+		pxClass->pucLimit = pucBlock;
+
+		for( uxBlock = pxClass->uxBlockCount; uxBlock > 0u; uxBlock-- )
+		{
+		void **ppvBlock = ( void ** ) ( pxClass->pucFirst + ( ( uxBlock - 1u ) * pxClass->uxBlockBytes ) );
+
+			*ppvBlock = pxClass->pvFreeList;
+			pxClass->pvFreeList = ( void * ) ppvBlock;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t *prvSlabAlloc( size_t xSize )
+{
+uint8_t *pucReturn = NULL;
+SlabClass_t *pxClass;
+void **ppvBlock;
+UBaseType_t uxClass;
+
+	for( uxClass = 0u; uxClass < ( UBaseType_t ) baSLAB_CLASS_COUNT; uxClass++ )
+	{
+		pxClass = &( xSlabClasses[ uxClass ] );
+
+		if( pxClass->uxBlockSize < xSize )
+		{
+			/* Too small, try the next slab. */
+			continue;
+		}
+
+		if( pxClass->pvFreeList == NULL )
+		{
+			/* The slab is exhausted, the next slab has larger blocks. */
+			pxClass->uxExhausted++;
+			continue;
+		}
+
+		ppvBlock = ( void ** ) pxClass->pvFreeList;
+		pxClass->pvFreeList = *ppvBlock;
+
+		pxClass->uxInUse++;
+		if( pxClass->uxMaxInUse < pxClass->uxInUse )
+		{
+			pxClass->uxMaxInUse = pxClass->uxInUse;
+		}
+
+		/* The first ipBUFFER_PADDING bytes will hold a pointer to the network
+		buffer descriptor. */
+		pucReturn = ( ( uint8_t * ) ppvBlock ) + ipBUFFER_PADDING;
+		break;
+	}
+
+	return pucReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSlabFree( uint8_t *pucBuffer )
+{
+uint8_t *pucBlock = pucBuffer - ipBUFFER_PADDING;
+SlabClass_t *pxClass;
+UBaseType_t uxClass;
+
+	for( uxClass = 0u; uxClass < ( UBaseType_t ) baSLAB_CLASS_COUNT; uxClass++ )
+	{
+		pxClass = &( xSlabClasses[ uxClass ] );
+
+		if( ( pucBlock >= pxClass->pucFirst ) && ( pucBlock < pxClass->pucLimit ) )
+		{
+			/* The block must be the start of a block in this slab. */
+			configASSERT( ( ( size_t ) ( pucBlock - pxClass->pucFirst ) % pxClass->uxBlockBytes ) == 0u );
+
+			*( ( void ** ) pucBlock ) = pxClass->pvFreeList;
+			pxClass->pvFreeList = ( void * ) pucBlock;
+			pxClass->uxInUse--;
+			break;
+		}
+	}
+
+	/* The buffer must have been obtained from the arena. */
+	configASSERT( uxClass < ( UBaseType_t ) baSLAB_CLASS_COUNT );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvRequestedSize( size_t xRequestedSizeBytes )
+{
+	if( xRequestedSizeBytes < ( size_t ) baMINIMAL_BUFFER_SIZE )
+	{
+		/* ARP packets can replace application packets, so the storage must be
+		at least large enough to hold an ARP. */
+		xRequestedSizeBytes = baMINIMAL_BUFFER_SIZE;
+	}
+
+	/* Add 2 bytes to xRequestedSizeBytes and round up xRequestedSizeBytes
+	to the nearest multiple of N bytes, where N equals 'sizeof( size_t )'. */
+	xRequestedSizeBytes += 2u;
+	if( ( xRequestedSizeBytes & ( sizeof( size_t ) - 1u ) ) != 0u )
+	{
+		xRequestedSizeBytes = ( xRequestedSizeBytes | ( sizeof( size_t ) - 1u ) ) + 1u;
+	}
+
+	return xRequestedSizeBytes;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrepareDescriptor( NetworkBufferDescriptor_t *pxNetworkBuffer, uint8_t *pucBuffer, size_t xRequestedSizeBytes )
+{
+	if( pucBuffer != NULL )
+	{
+		/* Store a pointer to the network buffer structure in the space before
+		the usable part of the block. */
+		*( ( NetworkBufferDescriptor_t ** ) ( pucBuffer - ipBUFFER_PADDING ) ) = pxNetworkBuffer;
+	}
+
+	pxNetworkBuffer->pucEthernetBuffer = pucBuffer;
+	pxNetworkBuffer->xDataLength = xRequestedSizeBytes;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		/* make sure the buffer is not linked */
+		pxNetworkBuffer->pxNextBuffer = NULL;
+	}
+	#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+	#if( ipconfigUSE_CHECKSUM_COPY != 0 )
+	{
+		/* No payload checksum has been calculated yet. */
+		pxNetworkBuffer->usPayloadLength = 0u;
+	}
+	#endif /* ipconfigUSE_CHECKSUM_COPY */
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+BaseType_t xReturn, x;
+
+	/* Only initialise the buffers and their associated kernel objects if they
+	have not been initialised before. */
+	if( xNetworkBufferSemaphore == NULL )
+	{
+		/* In case alternative locking is used, the mutexes can be initialised
+		here */
+		ipconfigBUFFER_ALLOC_INIT();
+
+		xNetworkBufferSemaphore = xSemaphoreCreateCounting( ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS );
+		configASSERT( xNetworkBufferSemaphore );
+
+		if( xNetworkBufferSemaphore != NULL )
+		{
+			#if ( configQUEUE_REGISTRY_SIZE > 0 )
+			{
+				vQueueAddToRegistry( xNetworkBufferSemaphore, "NetBufSem" );
+			}
+			#endif /* configQUEUE_REGISTRY_SIZE */
+
+			vListInitialise( &xFreeBuffersList );
+			prvSlabInitialise();
+
+			/* Initialise all the network buffers.  No storage is attached to
+			the buffers yet. */
+			for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+			{
+				/* Initialise and set the owner of the buffer list items. */
+				xNetworkBufferDescriptors[ x ].pucEthernetBuffer = NULL;
+				vListInitialiseItem( &( xNetworkBufferDescriptors[ x ].xBufferListItem ) );
+				listSET_LIST_ITEM_OWNER( &( xNetworkBufferDescriptors[ x ].xBufferListItem ), &xNetworkBufferDescriptors[ x ] );
+
+				/* Currently, all buffers are available for use. */
+				vListInsert( &xFreeBuffersList, &( xNetworkBufferDescriptors[ x ].xBufferListItem ) );
+			}
+
+			uxMinimumFreeNetworkBuffers = ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+		}
+	}
+
+	if( xNetworkBufferSemaphore == NULL )
+	{
+		xReturn = pdFAIL;
+	}
+	else
+	{
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t *pucGetNetworkBuffer( size_t *pxRequestedSizeBytes )
+{
+uint8_t *pucEthernetBuffer;
+size_t xSize = *pxRequestedSizeBytes;
+
+	if( xSize < baMINIMAL_BUFFER_SIZE )
+	{
+		/* Buffers must be at least large enough to hold a TCP-packet with
+		headers, or an ARP packet, in case TCP is not included. */
+		xSize = baMINIMAL_BUFFER_SIZE;
+	}
+
+	/* Round up xSize to the nearest multiple of N bytes,
+	where N equals 'sizeof( size_t )'. */
+	if( ( xSize & ( sizeof( size_t ) - 1u ) ) != 0u )
+	{
+		xSize = ( xSize | ( sizeof( size_t ) - 1u ) ) + 1u;
+	}
+	*pxRequestedSizeBytes = xSize;
+
+	ipconfigBUFFER_ALLOC_LOCK();
+	{
+		pucEthernetBuffer = prvSlabAlloc( xSize );
+	}
+	ipconfigBUFFER_ALLOC_UNLOCK();
+
+	return pucEthernetBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBuffer( uint8_t *pucEthernetBuffer )
+{
+	if( pucEthernetBuffer != NULL )
+	{
+		ipconfigBUFFER_ALLOC_LOCK();
+		{
+			prvSlabFree( pucEthernetBuffer );
+		}
+		ipconfigBUFFER_ALLOC_UNLOCK();
+	}
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+uint8_t *pucBuffer = NULL;
+UBaseType_t uxCount;
+
+	if( xNetworkBufferSemaphore != NULL )
+	{
+		if( xRequestedSizeBytes != 0u )
+		{
+			xRequestedSizeBytes = prvRequestedSize( xRequestedSizeBytes );
+		}
+
+		/* If there is a semaphore available, there is a network buffer available. */
+		if( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS )
+		{
+			/* Protect the structures as they are accessed from tasks and
+			interrupts. */
+			ipconfigBUFFER_ALLOC_LOCK();
+			{
+				if( xRequestedSizeBytes != 0u )
+				{
+					pucBuffer = prvSlabAlloc( xRequestedSizeBytes );
+				}
+
+				if( ( pucBuffer != NULL ) || ( xRequestedSizeBytes == 0u ) )
+				{
+					pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+					uxListRemove( &( pxReturn->xBufferListItem ) );
+				}
+			}
+			ipconfigBUFFER_ALLOC_UNLOCK();
+
+			if( pxReturn == NULL )
+			{
+				/* No block of the requested size is available, so the network
+				buffer structure cannot be used and the semaphore is given back. */
+				xSemaphoreGive( xNetworkBufferSemaphore );
+			}
+			else
+			{
+				/* Reading UBaseType_t, no critical section needed. */
+				uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+
+				if( uxMinimumFreeNetworkBuffers > uxCount )
+				{
+					uxMinimumFreeNetworkBuffers = uxCount;
+				}
+
+				prvPrepareDescriptor( pxReturn, pucBuffer, xRequestedSizeBytes );
+			}
+		}
+	}
+
+	if( pxReturn == NULL )
+	{
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER();
+	}
+	else
+	{
+		iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+uint8_t *pucBuffer = NULL;
+
+	if( xRequestedSizeBytes != 0u )
+	{
+		xRequestedSizeBytes = prvRequestedSize( xRequestedSizeBytes );
+	}
+
+	/* If there is a semaphore available then there is a buffer available, but,
+	as this is called from an interrupt, only take a buffer if there are at
+	least baINTERRUPT_BUFFER_GET_THRESHOLD buffers remaining.  This prevents,
+	to a certain degree at least, a rapidly executing interrupt exhausting
+	buffer and in so doing preventing tasks from continuing. */
+	if( uxQueueMessagesWaitingFromISR( ( QueueHandle_t ) xNetworkBufferSemaphore ) > ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD )
+	{
+		if( xSemaphoreTakeFromISR( xNetworkBufferSemaphore, NULL ) == pdPASS )
+		{
+			/* Protect the structures as they are accessed from tasks and
+			interrupts. */
+			ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+			{
+				if( xRequestedSizeBytes != 0u )
+				{
+					pucBuffer = prvSlabAlloc( xRequestedSizeBytes );
+				}
+
+				if( ( pucBuffer != NULL ) || ( xRequestedSizeBytes == 0u ) )
+				{
+					pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+					uxListRemove( &( pxReturn->xBufferListItem ) );
+				}
+			}
+			ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+
+			if( pxReturn == NULL )
+			{
+				xSemaphoreGiveFromISR( xNetworkBufferSemaphore, NULL );
+			}
+			else
+			{
+				prvPrepareDescriptor( pxReturn, pucBuffer, xRequestedSizeBytes );
+				iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR( pxReturn );
+			}
+		}
+	}
+
+	if( pxReturn == NULL )
+	{
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER_FROM_ISR();
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	/* Ensure the buffer is returned to the list of free buffers before the
+	counting semaphore is 'given' to say a buffer is available. */
+	ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+	{
+		if( pxNetworkBuffer->pucEthernetBuffer != NULL )
+		{
+			prvSlabFree( pxNetworkBuffer->pucEthernetBuffer );
+			pxNetworkBuffer->pucEthernetBuffer = NULL;
+		}
+		vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+	}
+	ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+
+	xSemaphoreGiveFromISR( xNetworkBufferSemaphore, &xHigherPriorityTaskWoken );
+	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+
+	return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+BaseType_t xListItemAlreadyInFreeList;
+
+	/* Ensure the buffer is returned to the list of free buffers before the
+	counting semaphore is 'given' to say a buffer is available.  The storage
+	is returned to its slab at the same time. */
+	ipconfigBUFFER_ALLOC_LOCK();
+	{
+		xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+
+		if( xListItemAlreadyInFreeList == pdFALSE )
+		{
+			if( pxNetworkBuffer->pucEthernetBuffer != NULL )
+			{
+				prvSlabFree( pxNetworkBuffer->pucEthernetBuffer );
+				pxNetworkBuffer->pucEthernetBuffer = NULL;
+			}
+			vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		}
+	}
+	ipconfigBUFFER_ALLOC_UNLOCK();
+
+	if( xListItemAlreadyInFreeList == pdFALSE )
+	{
+		xSemaphoreGive( xNetworkBufferSemaphore );
+	}
+	else
+	{
+		FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: %p ALREADY RELEASED (now %lu)\n",
+			pxNetworkBuffer, uxGetNumberOfFreeNetworkBuffers( ) ) );
+	}
+	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the number of free network buffers
+ */
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+	return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
+{
+	return uxMinimumFreeNetworkBuffers;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
+{
+size_t xOriginalLength;
+uint8_t *pucBuffer;
+
+	xOriginalLength = pxNetworkBuffer->xDataLength + ipBUFFER_PADDING;
+	xNewSizeBytes = xNewSizeBytes + ipBUFFER_PADDING;
+
+	pucBuffer = pucGetNetworkBuffer( &( xNewSizeBytes ) );
+
+	if( pucBuffer == NULL )
+	{
+		/* In case the allocation fails, return NULL. */
+		pxNetworkBuffer = NULL;
+	}
+	else
+	{
+		pxNetworkBuffer->xDataLength = xNewSizeBytes;
+		if( xNewSizeBytes > xOriginalLength )
+		{
+			xNewSizeBytes = xOriginalLength;
+		}
+
+		/* Copy the data, including the pointer to the descriptor that is
+		stored in front of it. */
+		memcpy( pucBuffer - ipBUFFER_PADDING, pxNetworkBuffer->pucEthernetBuffer - ipBUFFER_PADDING, xNewSizeBytes );
+		vReleaseNetworkBuffer( pxNetworkBuffer->pucEthernetBuffer );
+		pxNetworkBuffer->pucEthernetBuffer = pucBuffer;
+	}
+
+	return pxNetworkBuffer;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetNetworkBufferSlabStats( UBaseType_t uxIndex, NetworkBufferSlabStats_t *pxStats )
+{
+BaseType_t xReturn = pdFAIL;
+SlabClass_t *pxClass;
+
+	if( uxIndex < ( UBaseType_t ) baSLAB_CLASS_COUNT )
+	{
+		pxClass = &( xSlabClasses[ uxIndex ] );
+
+		ipconfigBUFFER_ALLOC_LOCK();
+		{
+			pxStats->uxBlockSize = pxClass->uxBlockSize;
+			pxStats->uxBlockCount = pxClass->uxBlockCount;
+			pxStats->uxInUse = pxClass->uxInUse;
+			pxStats->uxMaxInUse = pxClass->uxMaxInUse;
+			pxStats->uxExhausted = pxClass->uxExhausted;
+		}
+		ipconfigBUFFER_ALLOC_UNLOCK();
+
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,386 @@
+/*
+ * Generic management of the RX and TX DMA descriptor rings of an EMAC,
+ * see dmaRing.h.
+ *
+ * RX: 'uxHead' follows the DMA, it points to the next descriptor that will
+ * receive a frame.  A received buffer is handed to the IP-task as it is, and
+ * the descriptor gets a new buffer in stead.  When no new buffer is available,
+ * the frame is dropped and the descriptor keeps its buffer, so the DMA never
+ * runs out of descriptors.  All processed descriptors are given back to the
+ * DMA at once at 'uxTail', after a batch of packets was read.  Only
+ * xDMARingRxStart() may leave descriptors without a buffer, they are not owned
+ * by the DMA and recognised by a NULL in 'ppxBuffers'.
+ *
+ * TX: packets are given to the DMA at 'uxHead'.  The buffers are only
+ * released at 'uxTail' when the ring is running out of free descriptors, or
+ * when the driver calls uxDMARingTxReclaim().
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+#include "dmaRing.h"
+
+/* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
+driver will filter incoming packets and only pass the stack those packets it
+considers need processing. */
+#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/* Round 'x' up to a multiple of the cache line size. */
+#define dmaCACHE_ROUND_UP( x )		( ( ( x ) + ( ipconfigDMA_CACHE_LINE_SIZE - 1u ) ) & ~( ( size_t ) ipconfigDMA_CACHE_LINE_SIZE - 1u ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Call a cache hook for all cache lines that contain a part of the region.
+ */
+static void prvCacheMaintenance( xDMACacheHook_t fnHook, const uint8_t *pucAddress, size_t uxLength );
+
+/*
+ * Give the processed RX descriptors back to the DMA, starting at 'uxTail'.
+ * Descriptors without a buffer get a new one.
+ */
+static void prvRxRefill( DMARing_t *pxRing );
+
+/*
+ * Pass a received packet to the IP-task.
+ */
+static void prvRxHandOver( DMARing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*-----------------------------------------------------------*/
+
+static void prvCacheMaintenance( xDMACacheHook_t fnHook, const uint8_t *pucAddress, size_t uxLength )
+{
+uintptr_t uxStart, uxEnd;
+
+	if( fnHook != NULL )
+	{
+		uxStart = ( ( uintptr_t ) pucAddress ) & ~( ( uintptr_t ) ipconfigDMA_CACHE_LINE_SIZE - 1u );
+		uxEnd = dmaCACHE_ROUND_UP( ( ( uintptr_t ) pucAddress ) + uxLength );
+		fnHook( ( void * ) uxStart, ( size_t ) ( uxEnd - uxStart ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vDMARingInitialise( DMARing_t *pxRing, NetworkBufferDescriptor_t **ppxBuffers, UBaseType_t uxCount,
+	xDMAIsOwnedHook_t fnIsOwned, xDMAGiveHook_t fnGive )
+{
+	configASSERT( ( ppxBuffers != NULL ) && ( uxCount > 0u ) );
+	configASSERT( ( fnIsOwned != NULL ) && ( fnGive != NULL ) );
+
+	memset( pxRing, '\0', sizeof( *pxRing ) );
+	memset( ppxBuffers, '\0', sizeof( *ppxBuffers ) * uxCount );
+
+	pxRing->fnIsOwned = fnIsOwned;
+	pxRing->fnGive = fnGive;
+	pxRing->ppxBuffers = ppxBuffers;
+	pxRing->uxCount = uxCount;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		vNetworkRxBatchInit( &( pxRing->xRxBatch ) );
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMARingRxStart( DMARing_t *pxRing, xDMARxLengthHook_t fnRxLength )
+{
+	configASSERT( fnRxLength != NULL );
+
+	pxRing->fnRxLength = fnRxLength;
+	pxRing->uxBufferSize = dmaCACHE_ROUND_UP( ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE );
+	pxRing->uxHead = 0u;
+	pxRing->uxTail = 0u;
+
+	/* All descriptors are empty.  Buffers that are still attached from a
+	previous start are kept. */
+	pxRing->uxBusy = pxRing->uxCount;
+	prvRxRefill( pxRing );
+
+	return ( pxRing->uxBusy == 0u ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxRefill( DMARing_t *pxRing )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+UBaseType_t uxTail = pxRing->uxTail;
+
+	while( pxRing->uxBusy > 0u )
+	{
+		pxNetworkBuffer = pxRing->ppxBuffers[ uxTail ];
+
+		if( pxNetworkBuffer == NULL )
+		{
+			/* Don't block, the next call will try again. */
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( pxRing->uxBufferSize, 0u );
+
+			if( pxNetworkBuffer == NULL )
+			{
+				pxRing->xStats.ulRxNoBuffer++;
+				break;
+			}
+
+			pxRing->ppxBuffers[ uxTail ] = pxNetworkBuffer;
+		}
+
+		/* The cache may not hold data of this buffer while the DMA writes to
+		it, an eviction would overwrite the new frame. */
+		prvCacheMaintenance( pxRing->fnCacheInvalidate, pxNetworkBuffer->pucEthernetBuffer, pxRing->uxBufferSize );
+		pxRing->fnGive( pxRing, uxTail, pxNetworkBuffer->pucEthernetBuffer, pxRing->uxBufferSize );
+
+		pxRing->uxBusy--;
+		if( ++uxTail == pxRing->uxCount )
+		{
+			uxTail = 0u;
+		}
+	}
+
+	pxRing->uxTail = uxTail;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxHandOver( DMARing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+	iptraceNETWORK_INTERFACE_RECEIVE();
+	pxRing->xStats.ulRxPackets++;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		/* The batch is sent when it is full, or at the end of
+		uxDMARingRxProcess(). */
+		xNetworkRxBatchAdd( &( pxRing->xRxBatch ), pxNetworkBuffer, ( TickType_t ) 0 );
+	}
+	#else
+	{
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+
+		xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+		if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			iptraceETHERNET_RX_EVENT_LOST();
+		}
+	}
+	#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMARingRxPending( DMARing_t *pxRing )
+{
+BaseType_t xReturn = pdFALSE;
+
+	if( ( pxRing->ppxBuffers[ pxRing->uxHead ] != NULL ) &&
+		( pxRing->fnIsOwned( pxRing, pxRing->uxHead ) == pdFALSE ) )
+	{
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxDMARingRxProcess( DMARing_t *pxRing, UBaseType_t uxBudget )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer, *pxNewBuffer;
+UBaseType_t uxHead = pxRing->uxHead;
+UBaseType_t uxCount = 0u;
+size_t uxLength;
+
+	/* Descriptors that were read are only given back after the loop, stop
+	before 'uxHead' reaches them again. */
+	while( ( ( uxBudget == 0u ) || ( uxCount < uxBudget ) ) &&
+		   ( pxRing->uxBusy < pxRing->uxCount ) &&
+		   ( pxRing->ppxBuffers[ uxHead ] != NULL ) &&
+		   ( pxRing->fnIsOwned( pxRing, uxHead ) == pdFALSE ) )
+	{
+		pxNetworkBuffer = pxRing->ppxBuffers[ uxHead ];
+		uxLength = pxRing->fnRxLength( pxRing, uxHead );
+
+		if( uxLength > pxRing->uxBufferSize )
+		{
+			uxLength = 0u;
+		}
+
+		if( uxLength != 0u )
+		{
+			/* Make sure that the CPU sees what the DMA has written. */
+			prvCacheMaintenance( pxRing->fnCacheInvalidate, pxNetworkBuffer->pucEthernetBuffer, uxLength );
+
+			if( ipCONSIDER_FRAME_FOR_PROCESSING( pxNetworkBuffer->pucEthernetBuffer ) != eProcessBuffer )
+			{
+				uxLength = 0u;
+			}
+		}
+
+		if( uxLength != 0u )
+		{
+			/* The buffer is passed to the IP-task as it is, the descriptor
+			gets a new buffer in stead.  Don't block: without a new buffer the
+			frame is dropped, and the old buffer is given back to the DMA.  A
+			ring without buffers would not receive anything any more. */
+			pxNewBuffer = pxGetNetworkBufferWithDescriptor( pxRing->uxBufferSize, 0u );
+
+			if( pxNewBuffer != NULL )
+			{
+				pxRing->ppxBuffers[ uxHead ] = pxNewBuffer;
+				pxNetworkBuffer->xDataLength = uxLength;
+				prvRxHandOver( pxRing, pxNetworkBuffer );
+			}
+			else
+			{
+				pxRing->xStats.ulRxNoBuffer++;
+			}
+		}
+		else
+		{
+			/* The buffer stays attached to the descriptor and is given back
+			to the DMA by prvRxRefill(). */
+			pxRing->xStats.ulRxDropped++;
+		}
+
+		pxRing->uxBusy++;
+		uxCount++;
+		if( ++uxHead == pxRing->uxCount )
+		{
+			uxHead = 0u;
+		}
+	}
+
+	pxRing->uxHead = uxHead;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		/* Pass the remaining packets, if any. */
+		xNetworkRxBatchSend( &( pxRing->xRxBatch ), ( TickType_t ) 0 );
+	}
+	#endif
+
+	if( pxRing->uxBusy != 0u )
+	{
+		/* Also when no frames were read: xDMARingRxStart() may not have
+		filled the whole ring. */
+		prvRxRefill( pxRing );
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+void vDMARingTxStart( DMARing_t *pxRing, xDMAKickHook_t fnKick )
+{
+	pxRing->fnKick = fnKick;
+	pxRing->uxHead = 0u;
+	pxRing->uxTail = 0u;
+	pxRing->uxBusy = 0u;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxDMARingTxReclaim( DMARing_t *pxRing )
+{
+UBaseType_t uxTail = pxRing->uxTail;
+UBaseType_t uxCount = 0u;
+
+	while( ( pxRing->uxBusy > 0u ) && ( pxRing->fnIsOwned( pxRing, uxTail ) == pdFALSE ) )
+	{
+		if( pxRing->ppxBuffers[ uxTail ] != NULL )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxRing->ppxBuffers[ uxTail ] );
+			pxRing->ppxBuffers[ uxTail ] = NULL;
+		}
+
+		pxRing->uxBusy--;
+		uxCount++;
+		if( ++uxTail == pxRing->uxCount )
+		{
+			uxTail = 0u;
+		}
+	}
+
+	pxRing->uxTail = uxTail;
+	pxRing->xStats.ulTxReclaimed += ( uint32_t ) uxCount;
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMARingTxSend( DMARing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxSendBuffer = NULL;
+BaseType_t xReturn = pdFAIL;
+
+	/* Lazy reclaim: only look at the sent packets when the ring is almost
+	full. */
+	if( ( pxRing->uxCount - pxRing->uxBusy ) < ( UBaseType_t ) ipconfigDMA_TX_RECLAIM_THRESHOLD )
+	{
+		( void ) uxDMARingTxReclaim( pxRing );
+	}
+
+	if( pxRing->uxBusy >= pxRing->uxCount )
+	{
+		pxRing->xStats.ulTxRingFull++;
+	}
+	else if( xReleaseAfterSend != pdFALSE )
+	{
+		/* The buffer is owned by the ring until the packet has been sent. */
+		pxSendBuffer = pxNetworkBuffer;
+	}
+	else
+	{
+		/* The caller keeps the original, send a copy. */
+		pxSendBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+
+		if( pxSendBuffer == NULL )
+		{
+			pxRing->xStats.ulTxRingFull++;
+		}
+	}
+
+	if( pxSendBuffer != NULL )
+	{
+		/* Make sure that the DMA reads the data as written by the CPU. */
+		prvCacheMaintenance( pxRing->fnCacheClean, pxSendBuffer->pucEthernetBuffer, pxSendBuffer->xDataLength );
+
+		pxRing->ppxBuffers[ pxRing->uxHead ] = pxSendBuffer;
+		pxRing->fnGive( pxRing, pxRing->uxHead, pxSendBuffer->pucEthernetBuffer, pxSendBuffer->xDataLength );
+
+		pxRing->uxBusy++;
+		if( ++pxRing->uxHead == pxRing->uxCount )
+		{
+			pxRing->uxHead = 0u;
+		}
+
+		if( pxRing->fnKick != NULL )
+		{
+			pxRing->fnKick( pxRing );
+		}
+
+		iptraceNETWORK_INTERFACE_TRANSMIT();
+		pxRing->xStats.ulTxPackets++;
+		xReturn = pdPASS;
+	}
+	else if( xReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
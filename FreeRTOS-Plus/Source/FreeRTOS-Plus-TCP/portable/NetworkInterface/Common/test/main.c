@@ -0,0 +1,570 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks dmaRing.c against a simulated EMAC.  The descriptors of the mock MAC
+ * only hold an ownership flag, a length and a buffer pointer.  The "hardware"
+ * is driven by the test: it fills RX descriptors with frames, and marks TX
+ * descriptors as sent.  The network buffers come from malloc(), so that every
+ * buffer that leaks or is released twice is found.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+#include "dmaRing.h"
+
+#define mockRING_SIZE		( 8 )
+
+/* Every network buffer has room for the largest frame, in whole cache lines. */
+#define mockBUFFER_SIZE		( ( ipTOTAL_ETHERNET_FRAME_SIZE + ipconfigDMA_CACHE_LINE_SIZE - 1u ) & ~( ipconfigDMA_CACHE_LINE_SIZE - 1u ) )
+
+/* The first byte of a frame that the driver filter rejects. */
+#define mockFILTERED		( 0xffu )
+
+typedef struct xMOCK_DESCRIPTOR
+{
+	BaseType_t xOwned;		/* Owned by the DMA */
+	size_t uxLength;		/* RX: the length of the frame, 0 for a frame with errors.  TX: the length to send */
+	uint8_t *pucBuffer;
+} MockDescriptor_t;
+
+static MockDescriptor_t xRxDescriptors[ mockRING_SIZE ];
+static MockDescriptor_t xTxDescriptors[ mockRING_SIZE ];
+static NetworkBufferDescriptor_t *pxRxBuffers[ mockRING_SIZE ];
+static NetworkBufferDescriptor_t *pxTxBuffers[ mockRING_SIZE ];
+
+/* The next RX descriptor that the mock MAC will fill. */
+static UBaseType_t uxMACRxIndex = 0u;
+
+/* Network buffers that are allocated, and the maximum. */
+static int iBuffersInUse = 0;
+static int iBufferLimit = 1000;
+
+/* The packets that reached the "IP-task", and the messages that were used. */
+static int iDelivered = 0;
+static int iRxEvents = 0;
+static int iLastTag = -1;
+static int iOutOfOrder = 0;
+
+/* When set, the IP-task keeps the received buffers. */
+static BaseType_t xHoldPackets = pdFALSE;
+static NetworkBufferDescriptor_t *pxHeld[ 64 ];
+static int iHeld = 0;
+
+static int iKicks = 0;
+static int iCacheCalls = 0;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define mockCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxBuffer = NULL;
+
+	( void ) xBlockTimeTicks;
+
+	if( iBuffersInUse < iBufferLimit )
+	{
+		iBuffersInUse++;
+		pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+		if( posix_memalign( ( void ** ) &( pxBuffer->pucEthernetBuffer ), ipconfigDMA_CACHE_LINE_SIZE, mockBUFFER_SIZE ) != 0 )
+		{
+			abort();
+		}
+		memset( pxBuffer->pucEthernetBuffer, 0, mockBUFFER_SIZE );
+		pxBuffer->xDataLength = xRequestedSizeBytes;
+	}
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxDuplicateNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer, size_t uxNewLength )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxGetNetworkBufferWithDescriptor( uxNewLength, 0u );
+
+	if( pxBuffer != NULL )
+	{
+		memcpy( pxBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, uxNewLength );
+	}
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	iBuffersInUse--;
+	free( pxNetworkBuffer->pucEthernetBuffer );
+	free( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
+{
+	return ( pucEthernetBuffer[ 0 ] == mockFILTERED ) ? eReleaseBuffer : eProcessBuffer;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer, *pxNextBuffer;
+
+	( void ) xTimeout;
+	mockCHECK( pxEvent->eEventType == eNetworkRxEvent );
+	iRxEvents++;
+
+	for( pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) pxEvent->pvData; pxNetworkBuffer != NULL; pxNetworkBuffer = pxNextBuffer )
+	{
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			pxNextBuffer = pxNetworkBuffer->pxNextBuffer;
+			pxNetworkBuffer->pxNextBuffer = NULL;
+		}
+		#else
+		{
+			pxNextBuffer = NULL;
+		}
+		#endif
+
+		/* The second byte holds a sequence number, the length tells the
+		same. */
+		mockCHECK( pxNetworkBuffer->xDataLength == ( size_t ) ( 60 + pxNetworkBuffer->pucEthernetBuffer[ 1 ] ) );
+		if( ( iLastTag >= 0 ) && ( pxNetworkBuffer->pucEthernetBuffer[ 1 ] != ( uint8_t ) ( iLastTag + 1 ) ) )
+		{
+			iOutOfOrder++;
+		}
+		iLastTag = pxNetworkBuffer->pucEthernetBuffer[ 1 ];
+		iDelivered++;
+
+		if( xHoldPackets != pdFALSE )
+		{
+			pxHeld[ iHeld++ ] = pxNetworkBuffer;
+		}
+		else
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	void vNetworkRxBatchInit( NetworkRxBatch_t *pxBatch )
+	{
+		memset( pxBatch, 0, sizeof( *pxBatch ) );
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xNetworkRxBatchAdd( NetworkRxBatch_t *pxBatch, NetworkBufferDescriptor_t *pxNetworkBuffer, TickType_t xBlockTimeTicks )
+	{
+		( void ) xBlockTimeTicks;
+
+		pxNetworkBuffer->pxNextBuffer = NULL;
+
+		if( pxBatch->pxHead == NULL )
+		{
+			pxBatch->pxHead = pxNetworkBuffer;
+		}
+		else
+		{
+			pxBatch->pxTail->pxNextBuffer = pxNetworkBuffer;
+		}
+
+		pxBatch->pxTail = pxNetworkBuffer;
+		pxBatch->uxCount++;
+
+		return pdPASS;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xNetworkRxBatchSend( NetworkRxBatch_t *pxBatch, TickType_t xBlockTimeTicks )
+	{
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+
+		if( pxBatch->pxHead != NULL )
+		{
+			xRxEvent.pvData = ( void * ) pxBatch->pxHead;
+			( void ) xSendEventStructToIPTask( &xRxEvent, xBlockTimeTicks );
+			vNetworkRxBatchInit( pxBatch );
+		}
+
+		return pdPASS;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+/* The hooks of the mock MAC. */
+
+static BaseType_t prvIsOwned( DMARing_t *pxRing, UBaseType_t uxIndex )
+{
+	return ( ( MockDescriptor_t * ) pxRing->pvDescriptors )[ uxIndex ].xOwned;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGive( DMARing_t *pxRing, UBaseType_t uxIndex, uint8_t *pucBuffer, size_t uxLength )
+{
+MockDescriptor_t *pxDescriptor = &( ( ( MockDescriptor_t * ) pxRing->pvDescriptors )[ uxIndex ] );
+
+	/* A descriptor that belongs to the DMA may not be touched. */
+	mockCHECK( pxDescriptor->xOwned == pdFALSE );
+
+	pxDescriptor->pucBuffer = pucBuffer;
+	pxDescriptor->uxLength = uxLength;
+	pxDescriptor->xOwned = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvRxLength( DMARing_t *pxRing, UBaseType_t uxIndex )
+{
+	return ( ( MockDescriptor_t * ) pxRing->pvDescriptors )[ uxIndex ].uxLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvKick( DMARing_t *pxRing )
+{
+	( void ) pxRing;
+	iKicks++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCache( void *pvAddress, size_t uxLength )
+{
+	/* Only whole cache lines. */
+	mockCHECK( ( ( ( uintptr_t ) pvAddress ) % ipconfigDMA_CACHE_LINE_SIZE ) == 0u );
+	mockCHECK( ( uxLength % ipconfigDMA_CACHE_LINE_SIZE ) == 0u );
+	iCacheCalls++;
+}
+/*-----------------------------------------------------------*/
+
+/* Let the mock MAC receive up to 'iCount' frames, as long as it owns the next
+descriptor.  'xBadFrame' simulates a frame with errors, its length is zero. */
+static int prvMACReceive( int iCount, uint8_t ucFirstByte, BaseType_t xBadFrame )
+{
+static uint8_t ucTag = 0u;
+MockDescriptor_t *pxDescriptor;
+int iReceived = 0;
+
+	while( ( iReceived < iCount ) && ( xRxDescriptors[ uxMACRxIndex ].xOwned != pdFALSE ) )
+	{
+		pxDescriptor = &( xRxDescriptors[ uxMACRxIndex ] );
+
+		if( ( xBadFrame == pdFALSE ) && ( ucFirstByte != mockFILTERED ) )
+		{
+			pxDescriptor->pucBuffer[ 1 ] = ucTag;
+			pxDescriptor->uxLength = 60u + ucTag;
+			ucTag++;
+		}
+		else
+		{
+			pxDescriptor->uxLength = ( xBadFrame != pdFALSE ) ? 0u : 60u;
+		}
+
+		pxDescriptor->pucBuffer[ 0 ] = ucFirstByte;
+		pxDescriptor->xOwned = pdFALSE;
+
+		if( ++uxMACRxIndex == mockRING_SIZE )
+		{
+			uxMACRxIndex = 0u;
+		}
+		iReceived++;
+	}
+
+	return iReceived;
+}
+/*-----------------------------------------------------------*/
+
+/* Let the mock MAC send up to 'iCount' packets. */
+static void prvMACTransmit( int iCount, UBaseType_t *puxIndex )
+{
+	while( ( iCount > 0 ) && ( xTxDescriptors[ *puxIndex ].xOwned != pdFALSE ) )
+	{
+		xTxDescriptors[ *puxIndex ].xOwned = pdFALSE;
+		if( ++( *puxIndex ) == mockRING_SIZE )
+		{
+			*puxIndex = 0u;
+		}
+		iCount--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( DMARing_t *pxRing, BaseType_t xReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxGetNetworkBufferWithDescriptor( 100u, 0u );
+BaseType_t xResult;
+
+	xResult = xDMARingTxSend( pxRing, pxBuffer, xReleaseAfterSend );
+
+	if( xReleaseAfterSend == pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvRxOwnedCount( void )
+{
+int iIndex, iOwned = 0;
+
+	for( iIndex = 0; iIndex < mockRING_SIZE; iIndex++ )
+	{
+		if( xRxDescriptors[ iIndex ].xOwned != pdFALSE )
+		{
+			iOwned++;
+		}
+	}
+
+	return iOwned;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRx( void )
+{
+DMARing_t xRing;
+int iEvents, iIndex;
+
+	vDMARingInitialise( &xRing, pxRxBuffers, mockRING_SIZE, prvIsOwned, prvGive );
+	xRing.pvDescriptors = xRxDescriptors;
+	xRing.fnCacheInvalidate = prvCache;
+
+	/* Every descriptor gets a buffer of whole cache lines. */
+	mockCHECK( xDMARingRxStart( &xRing, prvRxLength ) == pdPASS );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+	mockCHECK( iBuffersInUse == mockRING_SIZE );
+	mockCHECK( ( xRing.uxBufferSize % ipconfigDMA_CACHE_LINE_SIZE ) == 0u );
+	mockCHECK( xRing.uxBufferSize >= ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE );
+	mockCHECK( xDMARingRxPending( &xRing ) == pdFALSE );
+
+	/* The budget limits the number of packets per call. */
+	mockCHECK( prvMACReceive( 5, 0u, pdFALSE ) == 5 );
+	iEvents = iRxEvents;
+	mockCHECK( uxDMARingRxProcess( &xRing, 3u ) == 3u );
+	mockCHECK( iDelivered == 3 );
+	mockCHECK( xDMARingRxPending( &xRing ) == pdTRUE );
+	mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == 2u );
+	mockCHECK( iDelivered == 5 );
+	mockCHECK( xRing.uxBusy == 0u );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		/* One message per call. */
+		mockCHECK( iRxEvents - iEvents == 2 );
+	}
+	#else
+	{
+		mockCHECK( iRxEvents - iEvents == 5 );
+	}
+	#endif
+
+	/* A frame with errors, and a frame that is filtered, keep their buffer. */
+	mockCHECK( prvMACReceive( 1, 0u, pdTRUE ) == 1 );
+	#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES != 0 )
+	{
+		mockCHECK( prvMACReceive( 1, mockFILTERED, pdFALSE ) == 1 );
+	}
+	#endif
+	mockCHECK( prvMACReceive( 1, 0u, pdFALSE ) == 1 );
+	mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == ( ( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES != 0 ) ? 3u : 2u ) );
+	mockCHECK( iDelivered == 6 );
+	mockCHECK( xRing.xStats.ulRxDropped == ( ( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES != 0 ) ? 2u : 1u ) );
+	mockCHECK( iBuffersInUse == mockRING_SIZE );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+
+	/* The IP-task holds all buffers but three: three frames are delivered, the
+	others are dropped and their descriptors keep the old buffer.  The DMA
+	never runs out of descriptors. */
+	xHoldPackets = pdTRUE;
+	iBufferLimit = iBuffersInUse + 3;
+	mockCHECK( prvMACReceive( mockRING_SIZE, 0u, pdFALSE ) == mockRING_SIZE );
+	mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == mockRING_SIZE );
+	mockCHECK( iHeld == 3 );
+	mockCHECK( xRing.xStats.ulRxNoBuffer == ( uint32_t ) ( mockRING_SIZE - 3 ) );
+	mockCHECK( xRing.uxBusy == 0u );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+
+	/* Frames that arrive during the shortage are received and dropped. */
+	for( iIndex = 0; iIndex < 2; iIndex++ )
+	{
+		mockCHECK( prvMACReceive( mockRING_SIZE, 0u, pdFALSE ) == mockRING_SIZE );
+		mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == mockRING_SIZE );
+	}
+
+	mockCHECK( iHeld == 3 );
+	mockCHECK( xRing.xStats.ulRxNoBuffer == ( uint32_t ) ( ( 3 * mockRING_SIZE ) - 3 ) );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+
+	/* The buffers come back, the next frames are delivered without any help.
+	The dropped frames left a gap in the sequence numbers. */
+	xHoldPackets = pdFALSE;
+	while( iHeld > 0 )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxHeld[ --iHeld ] );
+	}
+	iBufferLimit = 1000;
+	iLastTag = -1;
+
+	/* A few rounds over the whole ring, in order. */
+	for( iIndex = 0; iIndex < 4; iIndex++ )
+	{
+		mockCHECK( prvMACReceive( mockRING_SIZE, 0u, pdFALSE ) == mockRING_SIZE );
+		mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == mockRING_SIZE );
+	}
+
+	mockCHECK( iOutOfOrder == 0 );
+	mockCHECK( iBuffersInUse == mockRING_SIZE );
+	mockCHECK( xRing.xStats.ulRxPackets == ( uint32_t ) iDelivered );
+	mockCHECK( iCacheCalls > 0 );
+
+	printf( "rx: %d packets in %d messages, %lu dropped, %lu dropped without a buffer\n", iDelivered, iRxEvents,
+		( unsigned long ) xRing.xStats.ulRxDropped, ( unsigned long ) xRing.xStats.ulRxNoBuffer );
+
+	for( iIndex = 0; iIndex < mockRING_SIZE; iIndex++ )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxRxBuffers[ iIndex ] );
+	}
+
+	/* A start with too few buffers: the descriptors that are left without a
+	buffer get one in a later call. */
+	vDMARingInitialise( &xRing, pxRxBuffers, mockRING_SIZE, prvIsOwned, prvGive );
+	xRing.pvDescriptors = xRxDescriptors;
+	memset( xRxDescriptors, 0, sizeof( xRxDescriptors ) );
+	uxMACRxIndex = 0u;
+	iBufferLimit = 5;
+	mockCHECK( xDMARingRxStart( &xRing, prvRxLength ) == pdFAIL );
+	mockCHECK( prvRxOwnedCount() == 5 );
+	mockCHECK( xDMARingRxPending( &xRing ) == pdFALSE );
+	iBufferLimit = 1000;
+	mockCHECK( uxDMARingRxProcess( &xRing, 0u ) == 0u );
+	mockCHECK( xRing.uxBusy == 0u );
+	mockCHECK( prvRxOwnedCount() == mockRING_SIZE );
+
+	for( iIndex = 0; iIndex < mockRING_SIZE; iIndex++ )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxRxBuffers[ iIndex ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTx( void )
+{
+DMARing_t xRing;
+UBaseType_t uxMACTxIndex = 0u;
+int iIndex, iPassed = 0;
+
+	vDMARingInitialise( &xRing, pxTxBuffers, mockRING_SIZE, prvIsOwned, prvGive );
+	xRing.pvDescriptors = xTxDescriptors;
+	xRing.fnCacheClean = prvCache;
+	vDMARingTxStart( &xRing, prvKick );
+	iCacheCalls = 0;
+
+	/* Nothing is sent by the MAC: the ring fills up, and the packets that do
+	not fit are released. */
+	for( iIndex = 0; iIndex < mockRING_SIZE + 2; iIndex++ )
+	{
+		if( prvSend( &xRing, pdTRUE ) == pdPASS )
+		{
+			iPassed++;
+		}
+	}
+
+	mockCHECK( iPassed == mockRING_SIZE );
+	mockCHECK( xRing.xStats.ulTxRingFull == 2u );
+	mockCHECK( iBuffersInUse == mockRING_SIZE );
+	mockCHECK( iKicks == mockRING_SIZE );
+	mockCHECK( iCacheCalls == mockRING_SIZE );
+
+	/* Sent packets are only reclaimed when the ring is almost full. */
+	prvMACTransmit( 3, &uxMACTxIndex );
+	iPassed = 0;
+	for( iIndex = 0; iIndex < 4; iIndex++ )
+	{
+		if( prvSend( &xRing, pdTRUE ) == pdPASS )
+		{
+			iPassed++;
+		}
+	}
+
+	mockCHECK( iPassed == 3 );
+	mockCHECK( xRing.xStats.ulTxReclaimed == 3u );
+	mockCHECK( iBuffersInUse == mockRING_SIZE );
+
+	/* With xReleaseAfterSend pdFALSE a copy is sent.  The ring was almost
+	full, so the packets that were sent are reclaimed first. */
+	prvMACTransmit( mockRING_SIZE, &uxMACTxIndex );
+	mockCHECK( prvSend( &xRing, pdFALSE ) == pdPASS );
+	mockCHECK( xRing.xStats.ulTxReclaimed == ( uint32_t ) ( mockRING_SIZE + 3 ) );
+	mockCHECK( iBuffersInUse == 1 );
+
+	/* All buffers are released once the packets are sent. */
+	prvMACTransmit( mockRING_SIZE, &uxMACTxIndex );
+	mockCHECK( uxDMARingTxReclaim( &xRing ) == 1u );
+	mockCHECK( xRing.uxBusy == 0u );
+	mockCHECK( iBuffersInUse == 0 );
+
+	printf( "tx: %lu packets, %lu dropped on a full ring, %lu reclaimed\n", ( unsigned long ) xRing.xStats.ulTxPackets,
+		( unsigned long ) xRing.xStats.ulTxRingFull, ( unsigned long ) xRing.xStats.ulTxReclaimed );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	prvTestRx();
+	prvTestTx();
+
+	mockCHECK( iBuffersInUse == 0 );
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -192,6 +192,12 @@ static volatile uint32_t ulISREvents;
 
 static EthernetPhy_t xPhyObject;
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/* Received packets are collected here while the DMA descriptors are being
+	emptied, and passed to the IP-task in batches. */
+	static NetworkRxBatch_t xRxBatch = { NULL, NULL, 0u };
+#endif
+
 /* Ethernet handle. */
 static ETH_HandleTypeDef xETH;
 
@@ -289,6 +295,16 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
 	/* Ethernet RX-Complete callback function, elsewhere declared as weak. */
     ulISREvents |= EMAC_IF_RX_EVENT;
+
+	#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	{
+		/* Mask the RX interrupt, prvEMACHandlerTask() will poll the DMA
+		descriptors until they're empty. */
+		__HAL_ETH_DMA_DISABLE_IT( heth, ETH_DMA_IT_R );
+		vNetworkRxPollStartFromISR();
+	}
+	#endif
+
 	/* Wakeup the prvEMACHandlerTask. */
 	if( xEMACTaskHandle != NULL )
 	{
@@ -773,7 +789,9 @@ NetworkBufferDescriptor_t *pxCurDescriptor;
 NetworkBufferDescriptor_t *pxNewDescriptor = NULL;
 BaseType_t xReceivedLength, xAccepted;
 __IO ETH_DMADescTypeDef *pxDMARxDescriptor;
-xIPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
+	xIPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
 const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( 250 );
 uint8_t *pucBuffer;
 
@@ -852,20 +870,33 @@ uint8_t *pucBuffer;
 		if( xAccepted != pdFALSE )
 		{
 			pxCurDescriptor->xDataLength = xReceivedLength;
-			xRxEvent.pvData = ( void * ) pxCurDescriptor;
 
-			/* Pass the data to the TCP/IP task for processing. */
-			if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 			{
-				/* Could not send the descriptor into the TCP/IP stack, it
-				must be released. */
-				vReleaseNetworkBufferAndDescriptor( pxCurDescriptor );
-				iptraceETHERNET_RX_EVENT_LOST();
+				/* Add the packet to the batch, it will be sent to the IP-task
+				when the batch is full, or when all DMA descriptors have been
+				emptied. */
+				iptraceNETWORK_INTERFACE_RECEIVE();
+				xNetworkRxBatchAdd( &xRxBatch, pxCurDescriptor, xDescriptorWaitTime );
 			}
-			else
+			#else
 			{
-				iptraceNETWORK_INTERFACE_RECEIVE();
+				xRxEvent.pvData = ( void * ) pxCurDescriptor;
+
+				/* Pass the data to the TCP/IP task for processing. */
+				if( xSendEventStructToIPTask( &xRxEvent, xDescriptorWaitTime ) == pdFALSE )
+				{
+					/* Could not send the descriptor into the TCP/IP stack, it
+					must be released. */
+					vReleaseNetworkBufferAndDescriptor( pxCurDescriptor );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+				else
+				{
+					iptraceNETWORK_INTERFACE_RECEIVE();
+				}
 			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 		}
 
 		/* Release descriptors to DMA */
@@ -1155,13 +1186,57 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 		{
 			ulISREvents &= ~EMAC_IF_RX_EVENT;
 
-			xResult = prvNetworkInterfaceInput();
-			if( xResult > 0 )
+			#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
 			{
-			  	while( prvNetworkInterfaceInput() > 0 )
+			UBaseType_t uxCount = 0u;
+
+				/* Read at most ipconfigNETWORK_RX_POLL_BUDGET packets. */
+				while( ( uxCount < ( UBaseType_t ) ipconfigNETWORK_RX_POLL_BUDGET ) && ( prvNetworkInterfaceInput() > 0 ) )
+				{
+					uxCount++;
+				}
+				xResult = ( BaseType_t ) uxCount;
+			}
+			#else
+			{
+				xResult = prvNetworkInterfaceInput();
+				if( xResult > 0 )
+				{
+				  	while( prvNetworkInterfaceInput() > 0 )
+					{
+					}
+				}
+			}
+			#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* Pass the remaining packets, if any. */
+				xNetworkRxBatchSend( &xRxBatch, pdMS_TO_TICKS( 250 ) );
+			}
+			#endif
+
+			#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+			{
+				if( xNetworkRxPollComplete( ( UBaseType_t ) xResult ) != pdFALSE )
+				{
+					/* The budget was used up, keep on polling. */
+					ulISREvents |= EMAC_IF_RX_EVENT;
+				}
+				else
 				{
+					/* All descriptors are empty, enable the RX interrupt again.
+					Check the next descriptor once more, a packet may have been
+					received before the interrupt was enabled. */
+					__HAL_ETH_DMA_ENABLE_IT( &xETH, ETH_DMA_IT_R );
+
+					if( ( xETH.RxDesc->Status & ETH_DMARXDESC_OWN ) == 0 )
+					{
+						ulISREvents |= EMAC_IF_RX_EVENT;
+					}
 				}
 			}
+			#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
 		}
 
 		if( ( ulISREvents & EMAC_IF_TX_EVENT ) != 0 )
@@ -505,12 +505,22 @@ static struct pcap_pkthdr *pxHeader;
 const uint8_t *pucPacketData;
 uint8_t ucRecvBuffer[ ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ];
 NetworkBufferDescriptor_t *pxNetworkBuffer;
-IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkRxBatch_t xRxBatch;
+#else
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
 eFrameProcessingResult_t eResult;
 
 	/* Remove compiler warnings about unused parameters. */
 	( void ) pvParameters;
 
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		vNetworkRxBatchInit( &xRxBatch );
+	}
+	#endif
+
 	for( ;; )
 	{
 		/* Does the circular buffer used to pass data from the Win32 thread that
@@ -560,22 +570,33 @@ eFrameProcessingResult_t eResult;
 
 						if( pxNetworkBuffer != NULL )
 						{
-							xRxEvent.pvData = ( void * ) pxNetworkBuffer;
-
-							/* Data was received and stored.  Send a message to
-							the IP task to let it know. */
-							if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+							#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 							{
-								/* The buffer could not be sent to the stack so
-								must be released again.  This is only an
-								interrupt simulator, not a real interrupt, so it
-								is ok to use the task level function here, but
-								note no all buffer implementations will allow
-								this function to be executed from a real
-								interrupt. */
-								vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
-								iptraceETHERNET_RX_EVENT_LOST();
+								/* Data was received and stored.  The batch is
+								passed to the IP task when it is full, or when
+								there are no more packets to read. */
+								xNetworkRxBatchAdd( &xRxBatch, pxNetworkBuffer, ( TickType_t ) 0 );
 							}
+							#else
+							{
+								xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+								/* Data was received and stored.  Send a message to
+								the IP task to let it know. */
+								if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+								{
+									/* The buffer could not be sent to the stack so
+									must be released again.  This is only an
+									interrupt simulator, not a real interrupt, so it
+									is ok to use the task level function here, but
+									note no all buffer implementations will allow
+									this function to be executed from a real
+									interrupt. */
+									vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+									iptraceETHERNET_RX_EVENT_LOST();
+								}
+							}
+							#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
 						}
 						else
 						{
@@ -598,6 +619,14 @@ eFrameProcessingResult_t eResult;
 		}
 		else
 		{
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* All packets have been read, pass the remaining ones to the
+				IP task. */
+				xNetworkRxBatchSend( &xRxBatch, ( TickType_t ) 0 );
+			}
+			#endif
+
 			/* There is no real way of simulating an interrupt.  Make sure
 			other tasks can run. */
 			vTaskDelay( configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY );
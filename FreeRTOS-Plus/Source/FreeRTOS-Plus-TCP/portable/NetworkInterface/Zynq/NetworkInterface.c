@@ -351,6 +351,28 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 		{
 			xEMACpsif.isr_events &= ~EMAC_IF_RX_EVENT;
 			xResult = emacps_check_rx( &xEMACpsif );
+
+			#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+			{
+				if( xNetworkRxPollComplete( ( UBaseType_t ) xResult ) != pdFALSE )
+				{
+					/* The budget was used up, keep on polling. */
+					xEMACpsif.isr_events |= EMAC_IF_RX_EVENT;
+				}
+				else
+				{
+					/* The DMA ring is empty, enable the RX interrupt again.
+					Check the ring once more, a packet may have been received
+					before the interrupt was enabled. */
+					XEmacPs_WriteReg( xEMACpsif.emacps.Config.BaseAddress, XEMACPS_IER_OFFSET, XEMACPS_IXR_FRAMERX_MASK );
+
+					if( ( xEMACpsif.rxSegments[ xEMACpsif.rxHead ].address & XEMACPS_RXBUF_NEW_MASK ) != 0 )
+					{
+						xEMACpsif.isr_events |= EMAC_IF_RX_EVENT;
+					}
+				}
+			}
+			#endif /* ipconfigNETWORK_RX_POLL_BUDGET */
 		}
 
 		if( ( xEMACpsif.isr_events & EMAC_IF_TX_EVENT ) != 0 )
@@ -306,6 +306,15 @@ void emacps_recv_handler(void *arg)
 	xemacpsif = (xemacpsif_s *)(arg);
 	xemacpsif->isr_events |= EMAC_IF_RX_EVENT;
 
+	#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+	{
+		/* Mask the RX interrupt, the EMAC task will poll the DMA ring until
+		it is empty. */
+		XEmacPs_WriteReg( xemacpsif->emacps.Config.BaseAddress, XEMACPS_IDR_OFFSET, XEMACPS_IXR_FRAMERX_MASK );
+		vNetworkRxPollStartFromISR();
+	}
+	#endif
+
 	if( xEMACTaskHandle != NULL )
 	{
 		vTaskNotifyGiveFromISR( xEMACTaskHandle, &xHigherPriorityTaskWoken );
@@ -314,34 +323,12 @@ void emacps_recv_handler(void *arg)
 	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
 
-static NetworkBufferDescriptor_t *ethMsg = NULL;
-static NetworkBufferDescriptor_t *ethLast = NULL;
-
-static void passEthMessages( void )
-{
-IPStackEvent_t xRxEvent;
-
-	xRxEvent.eEventType = eNetworkRxEvent;
-	xRxEvent.pvData = ( void * ) ethMsg;
-
-	if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 1000 ) != pdPASS )
-	{
-		/* The buffer could not be sent to the stack so	must be released again.
-		This is a deferred handler taskr, not a real interrupt, so it is ok to
-		use the task level function here. */
-		do
-		{
-			NetworkBufferDescriptor_t *xNext = ethMsg->pxNextBuffer;
-			vReleaseNetworkBufferAndDescriptor( ethMsg );
-			ethMsg = xNext;
-		} while( ethMsg != NULL );
-
-		iptraceETHERNET_RX_EVENT_LOST();
-		FreeRTOS_printf( ( "passEthMessages: Can not queue return packet!\n" ) );
-	}
+#if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
+	#error This driver must be compiled with ipconfigUSE_LINKED_RX_MESSAGES enabled
+#endif
 
-	ethMsg = ethLast = NULL;
-}
+/* Received packets are collected here and passed to the IP-task in batches. */
+static NetworkRxBatch_t xRxBatch = { NULL, NULL, 0u };
 
 int emacps_check_rx( xemacpsif_s *xemacpsif )
 {
@@ -364,6 +351,16 @@ int head = xemacpsif->rxHead;
 			break;
 		}
 
+		#if( ipconfigNETWORK_RX_POLL_BUDGET != 0 )
+		{
+			/* The remaining packets will be read in the next pass. */
+			if( msgCount >= ipconfigNETWORK_RX_POLL_BUDGET )
+			{
+				break;
+			}
+		}
+		#endif
+
 		pxNewBuffer = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE + RX_BUFFER_ALIGNMENT, ( TickType_t ) 0 );
 		if( pxNewBuffer == NULL )
 		{
@@ -394,20 +391,10 @@ int head = xemacpsif->rxHead;
 			/* store it in the receive queue, where it'll be processed by a
 			different handler. */
 			iptraceNETWORK_INTERFACE_RECEIVE();
-			pxBuffer->pxNextBuffer = NULL;
 
-			if( ethMsg == NULL )
-			{
-				// Becomes the first message
-				ethMsg = pxBuffer;
-			}
-			else if( ethLast != NULL )
-			{
-				// Add to the tail
-				ethLast->pxNextBuffer = pxBuffer;
-			}
-
-			ethLast = pxBuffer;
+			/* This is a deferred handler task, not a real interrupt, so it is
+			ok to block while a full batch is passed to the IP-task. */
+			xNetworkRxBatchAdd( &xRxBatch, pxBuffer, ( TickType_t ) 1000 );
 			msgCount++;
 		}
 		{
@@ -434,10 +421,8 @@ int head = xemacpsif->rxHead;
 		xemacpsif->rxHead = head;
 	}
 
-	if( ethMsg != NULL )
-	{
-		passEthMessages( );
-	}
+	/* Pass the remaining packets, if any. */
+	xNetworkRxBatchSend( &xRxBatch, ( TickType_t ) 1000 );
 
 	return msgCount;
 }
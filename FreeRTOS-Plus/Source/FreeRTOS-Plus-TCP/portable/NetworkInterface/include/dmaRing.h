@@ -0,0 +1,128 @@
+/*
+ * Generic management of the RX and TX DMA descriptor rings of an EMAC.
+ * The layout of a DMA descriptor is different for every EMAC, the driver
+ * provides a few small functions to access them.  This module takes care of
+ * the rest: handing received buffers to the IP-task without copying them,
+ * refilling the RX ring in batches, reclaiming the buffers of sent packets,
+ * and the cache maintenance of the buffers.
+ *
+ * All RX functions must be called from the same task, normally the EMAC task.
+ * All TX functions must be called from the same task, normally the IP-task
+ * from within xNetworkInterfaceOutput().
+ */
+
+#ifndef DMARING_H
+
+#define DMARING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ipconfigDMA_CACHE_LINE_SIZE
+	/* The size of a data cache line.  The length of the RX buffers, and the
+	regions that are cleaned or invalidated, are rounded up to a multiple of
+	it, so that a buffer never shares a cache line with other data. */
+	#define ipconfigDMA_CACHE_LINE_SIZE		32u
+#endif
+
+#ifndef ipconfigDMA_TX_RECLAIM_THRESHOLD
+	/* Sent packets are only released when fewer than this number of TX
+	descriptors is free.  Reclaiming several descriptors at once is cheaper
+	than taking a TX-complete interrupt for every packet. */
+	#define ipconfigDMA_TX_RECLAIM_THRESHOLD	4u
+#endif
+
+#if( ( ipconfigDMA_CACHE_LINE_SIZE & ( ipconfigDMA_CACHE_LINE_SIZE - 1u ) ) != 0 )
+	#error ipconfigDMA_CACHE_LINE_SIZE must be a power of 2
+#endif
+
+struct xDMA_RING;
+
+/* Return pdTRUE as long as the descriptor at 'uxIndex' is owned by the DMA. */
+typedef BaseType_t ( *xDMAIsOwnedHook_t )( struct xDMA_RING *pxRing, UBaseType_t uxIndex );
+
+/* Pass 'pucBuffer' to the DMA through the descriptor at 'uxIndex'.  For an RX
+descriptor, 'uxLength' is the size of the empty buffer, for a TX descriptor it
+is the length of the frame.  The ownership bit must be set last. */
+typedef void ( *xDMAGiveHook_t )( struct xDMA_RING *pxRing, UBaseType_t uxIndex, uint8_t *pucBuffer, size_t uxLength );
+
+/* Return the length of the frame received in the descriptor at 'uxIndex',
+or zero when the frame has errors and must be dropped. */
+typedef size_t ( *xDMARxLengthHook_t )( struct xDMA_RING *pxRing, UBaseType_t uxIndex );
+
+/* Tell the DMA that new TX descriptors are ready (poll demand). */
+typedef void ( *xDMAKickHook_t )( struct xDMA_RING *pxRing );
+
+/* Cache maintenance of a region that is a multiple of the cache line size.
+Leave NULL when the buffers are not cached, or when the DMA is coherent. */
+typedef void ( *xDMACacheHook_t )( void *pvAddress, size_t uxLength );
+
+typedef struct xDMA_RING_STATS
+{
+	uint32_t ulRxPackets;			/* Packets handed over to the IP-task */
+	uint32_t ulRxDropped;			/* Frames with errors, or frames that were not accepted */
+	uint32_t ulRxNoBuffer;			/* Frames dropped, or refills that failed, because no network buffer was available */
+	uint32_t ulTxPackets;			/* Packets given to the DMA */
+	uint32_t ulTxRingFull;			/* Packets dropped because no TX descriptor was free */
+	uint32_t ulTxReclaimed;			/* TX descriptors of which the buffer was released */
+} DMARingStats_t;
+
+typedef struct xDMA_RING
+{
+	xDMAIsOwnedHook_t fnIsOwned;
+	xDMAGiveHook_t fnGive;
+	xDMARxLengthHook_t fnRxLength;		/* Only used for an RX ring */
+	xDMAKickHook_t fnKick;				/* Only used for a TX ring, may be NULL */
+	xDMACacheHook_t fnCacheClean;		/* Write the cached data to memory before the DMA reads it, may be NULL */
+	xDMACacheHook_t fnCacheInvalidate;	/* Discard cached data after the DMA wrote to memory, may be NULL */
+	void *pvDescriptors;				/* For use by the hooks */
+	NetworkBufferDescriptor_t **ppxBuffers;	/* The buffer of each descriptor, 'uxCount' entries */
+	UBaseType_t uxCount;				/* The number of descriptors */
+	UBaseType_t uxHead;					/* RX: next descriptor to be read.  TX: next descriptor to be filled */
+	UBaseType_t uxTail;					/* RX: next descriptor to be refilled.  TX: oldest descriptor not yet reclaimed */
+	UBaseType_t uxBusy;					/* RX: descriptors not yet given back to the DMA.  TX: descriptors in use */
+	size_t uxBufferSize;				/* The size of the RX buffers */
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkRxBatch_t xRxBatch;
+#endif
+	DMARingStats_t xStats;
+} DMARing_t;
+
+/* Initialise the struct and assign the hooks.  'ppxBuffers' must point to an
+array of 'uxCount' pointers. */
+void vDMARingInitialise( DMARing_t *pxRing, NetworkBufferDescriptor_t **ppxBuffers, UBaseType_t uxCount,
+	xDMAIsOwnedHook_t fnIsOwned, xDMAGiveHook_t fnGive );
+
+/* Give a network buffer to every RX descriptor.  Returns pdFAIL when not all
+descriptors could get a buffer, the missing ones will be refilled later. */
+BaseType_t xDMARingRxStart( DMARing_t *pxRing, xDMARxLengthHook_t fnRxLength );
+
+/* Hand the received packets to the IP-task, at most 'uxBudget' packets, or
+all of them when 'uxBudget' is zero.  A packet is dropped when no network buffer
+is available to replace it, its descriptor keeps the old buffer.  The
+descriptors are given back to the DMA afterwards.  Returns the number of
+descriptors that were read. */
+UBaseType_t uxDMARingRxProcess( DMARing_t *pxRing, UBaseType_t uxBudget );
+
+/* Return pdTRUE when the next RX descriptor holds a received frame. */
+BaseType_t xDMARingRxPending( DMARing_t *pxRing );
+
+/* Prepare the ring for transmission, 'fnKick' may be NULL. */
+void vDMARingTxStart( DMARing_t *pxRing, xDMAKickHook_t fnKick );
+
+/* Give a packet to the DMA.  When 'xReleaseAfterSend' is pdFALSE, the
+caller keeps the buffer and a copy is sent.  Returns pdFAIL when the packet
+had to be dropped, in which case it has been released if 'xReleaseAfterSend'
+was pdTRUE. */
+BaseType_t xDMARingTxSend( DMARing_t *pxRing, NetworkBufferDescriptor_t *pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+/* Release the buffers of all packets that have been sent.  Returns the number
+of descriptors that were reclaimed. */
+UBaseType_t uxDMARingTxReclaim( DMARing_t *pxRing );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
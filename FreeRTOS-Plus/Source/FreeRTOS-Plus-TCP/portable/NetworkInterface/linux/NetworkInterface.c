@@ -0,0 +1,485 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* Linux includes. */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* This driver runs FreeRTOS+TCP inside the FreeRTOS POSIX (Linux) simulator.
+It opens an AF_PACKET socket on an existing host interface, normally a TAP
+device or one end of a veth pair, see ReadMe.txt.  Both the reception and the
+transmission use PACKET_MMAP rings, which are shared with the kernel: a packet
+is copied once between a ring slot and a network buffer, and no system call is
+needed to receive packets. */
+
+/* The name of the host interface to be opened.  The variable
+pcConfigNetworkInterfaceName may be changed by the application before
+FreeRTOS_IPInit() is called, e.g. to run two nodes from a single executable. */
+#ifndef configNETWORK_INTERFACE_NAME
+	#define configNETWORK_INTERFACE_NAME	"tap0"
+#endif
+
+/* The number of frames in each of the two rings. */
+#ifndef niRING_FRAME_COUNT
+	#define niRING_FRAME_COUNT				256u
+#endif
+
+/* The size of a single frame slot in a ring.  It must hold a tpacket2_hdr,
+a sockaddr_ll and a complete Ethernet frame, and be a multiple of
+TPACKET_ALIGNMENT. */
+#ifndef niRING_FRAME_SIZE
+	#define niRING_FRAME_SIZE				2048u
+#endif
+
+/* The size of a ring block, a multiple of the page size and of
+niRING_FRAME_SIZE. */
+#ifndef niRING_BLOCK_SIZE
+	#define niRING_BLOCK_SIZE				16384u
+#endif
+
+/* The number of ticks that the MAC_ISR task sleeps when the RX ring is empty.
+A value of zero makes the task yield in stead. */
+#ifndef configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY
+	#define configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY	( 1u )
+#endif
+
+#ifndef configMAC_ISR_SIMULATOR_PRIORITY
+	#define configMAC_ISR_SIMULATOR_PRIORITY	( configMAX_PRIORITIES - 1 )
+#endif
+
+#if( ( niRING_BLOCK_SIZE % niRING_FRAME_SIZE ) != 0 )
+	#error niRING_BLOCK_SIZE must be a multiple of niRING_FRAME_SIZE
+#endif
+
+#if( ( niRING_FRAME_COUNT % ( niRING_BLOCK_SIZE / niRING_FRAME_SIZE ) ) != 0 )
+	#error niRING_FRAME_COUNT must be a multiple of the number of frames per block
+#endif
+
+/* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
+driver will filter incoming packets and only pass the stack those packets it
+considers need processing. */
+#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/* The offset of the Ethernet frame within a TX ring slot. */
+#define niTX_DATA_OFFSET	( TPACKET2_HDRLEN - sizeof( struct sockaddr_ll ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Open the AF_PACKET socket, set-up and map both rings.
+ */
+static BaseType_t prvOpenInterface( void );
+
+/*
+ * A task that simulates Ethernet interrupts by polling the RX ring for new
+ * frames.
+ */
+static void prvInterruptSimulatorTask( void *pvParameters );
+
+/*
+ * Return the ring slot with the given index.
+ */
+static struct tpacket2_hdr *prvGetFrame( uint8_t *pucRing, uint32_t ulIndex );
+
+/*-----------------------------------------------------------*/
+
+/* The name of the host interface, see configNETWORK_INTERFACE_NAME. */
+const char *pcConfigNetworkInterfaceName = configNETWORK_INTERFACE_NAME;
+
+/* The AF_PACKET socket, or -1 when the interface has not been opened. */
+static int iPacketSocket = -1;
+
+/* The mapped memory: the RX ring followed by the TX ring. */
+static uint8_t *pucRxRing = NULL;
+static uint8_t *pucTxRing = NULL;
+
+/* The next slot to be inspected in each ring.  ulRxIndex is only used by the
+MAC_ISR task, ulTxIndex only by the IP-task. */
+static uint32_t ulRxIndex = 0u;
+static uint32_t ulTxIndex = 0u;
+
+/* Logs the number of frames that could not be sent because the TX ring was
+full, or because the kernel refused them, for viewing in the debugger only. */
+static volatile uint32_t ulLinuxSendFailures = 0u;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+BaseType_t xReturn = pdPASS;
+
+	/* This function may be called again after the network went down.  The
+	socket, the rings and the MAC_ISR task are only created once. */
+	if( iPacketSocket < 0 )
+	{
+		xReturn = prvOpenInterface();
+
+		if( xReturn == pdPASS )
+		{
+			/* Create a task that simulates an interrupt in a real system.
+			It polls the RX ring and sends a message to the IP task when data
+			is available. */
+			xTaskCreate( prvInterruptSimulatorTask, "MAC_ISR", configMINIMAL_STACK_SIZE, NULL, configMAC_ISR_SIMULATOR_PRIORITY, NULL );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetPhyLinkStatus( void )
+{
+struct ifreq xRequest;
+BaseType_t xReturn = pdFALSE;
+
+	if( iPacketSocket >= 0 )
+	{
+		memset( &xRequest, '\0', sizeof( xRequest ) );
+		strncpy( xRequest.ifr_name, pcConfigNetworkInterfaceName, sizeof( xRequest.ifr_name ) - 1u );
+
+		if( ( ioctl( iPacketSocket, SIOCGIFFLAGS, &xRequest ) == 0 ) &&
+			( ( xRequest.ifr_flags & IFF_RUNNING ) != 0 ) )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static struct tpacket2_hdr *prvGetFrame( uint8_t *pucRing, uint32_t ulIndex )
+{
+	return ( struct tpacket2_hdr * ) ( pucRing + ( ( size_t ) ulIndex * niRING_FRAME_SIZE ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvOpenInterface( void )
+{
+struct tpacket_req xRingRequest;
+struct sockaddr_ll xAddress;
+struct packet_mreq xMembership;
+int iVersion = TPACKET_V2;
+size_t uxRingSize;
+void *pvMemory;
+BaseType_t xReturn = pdFAIL;
+int iSocket;
+unsigned int uxIndex;
+
+	/* Each frame slot must be large enough to hold a maximum sized frame. */
+	configASSERT( ( TPACKET2_HDRLEN + ipTOTAL_ETHERNET_FRAME_SIZE ) <= niRING_FRAME_SIZE );
+
+	uxIndex = if_nametoindex( pcConfigNetworkInterfaceName );
+
+	if( uxIndex == 0u )
+	{
+		FreeRTOS_printf( ( "xNetworkInterfaceInitialise: interface '%s' not found\n", pcConfigNetworkInterfaceName ) );
+	}
+	else
+	{
+		/* Creating an AF_PACKET socket requires CAP_NET_RAW. */
+		iSocket = socket( AF_PACKET, SOCK_RAW, htons( ETH_P_ALL ) );
+
+		if( iSocket < 0 )
+		{
+			FreeRTOS_printf( ( "xNetworkInterfaceInitialise: socket() failed: %s\n", strerror( errno ) ) );
+		}
+		else
+		{
+			memset( &xRingRequest, '\0', sizeof( xRingRequest ) );
+			xRingRequest.tp_block_size = niRING_BLOCK_SIZE;
+			xRingRequest.tp_frame_size = niRING_FRAME_SIZE;
+			xRingRequest.tp_frame_nr = niRING_FRAME_COUNT;
+			xRingRequest.tp_block_nr = niRING_FRAME_COUNT / ( niRING_BLOCK_SIZE / niRING_FRAME_SIZE );
+			uxRingSize = ( size_t ) niRING_BLOCK_SIZE * xRingRequest.tp_block_nr;
+
+			/* The version must be set before the rings are created.  The rings
+			are mapped with a single mmap(): RX first, followed by TX. */
+			if( ( setsockopt( iSocket, SOL_PACKET, PACKET_VERSION, &iVersion, sizeof( iVersion ) ) != 0 ) ||
+				( setsockopt( iSocket, SOL_PACKET, PACKET_RX_RING, &xRingRequest, sizeof( xRingRequest ) ) != 0 ) ||
+				( setsockopt( iSocket, SOL_PACKET, PACKET_TX_RING, &xRingRequest, sizeof( xRingRequest ) ) != 0 ) )
+			{
+				FreeRTOS_printf( ( "xNetworkInterfaceInitialise: PACKET_MMAP set-up failed: %s\n", strerror( errno ) ) );
+			}
+			else
+			{
+				pvMemory = mmap( NULL, 2u * uxRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, iSocket, 0 );
+
+				if( pvMemory == MAP_FAILED )
+				{
+					FreeRTOS_printf( ( "xNetworkInterfaceInitialise: mmap() failed: %s\n", strerror( errno ) ) );
+				}
+				else
+				{
+					pucRxRing = ( uint8_t * ) pvMemory;
+					pucTxRing = pucRxRing + uxRingSize;
+
+					memset( &xAddress, '\0', sizeof( xAddress ) );
+					xAddress.sll_family = AF_PACKET;
+					xAddress.sll_protocol = htons( ETH_P_ALL );
+					xAddress.sll_ifindex = ( int ) uxIndex;
+
+					/* The MAC and IP address are "simulated", they are not
+					the addresses of the host interface.  The interface must be
+					put in promiscuous mode in order to receive the traffic for
+					the simulated MAC address. */
+					memset( &xMembership, '\0', sizeof( xMembership ) );
+					xMembership.mr_ifindex = ( int ) uxIndex;
+					xMembership.mr_type = PACKET_MR_PROMISC;
+
+					if( ( bind( iSocket, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) != 0 ) ||
+						( setsockopt( iSocket, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &xMembership, sizeof( xMembership ) ) != 0 ) )
+					{
+						FreeRTOS_printf( ( "xNetworkInterfaceInitialise: binding to '%s' failed: %s\n", pcConfigNetworkInterfaceName, strerror( errno ) ) );
+						munmap( pvMemory, 2u * uxRingSize );
+						pucRxRing = NULL;
+						pucTxRing = NULL;
+					}
+					else
+					{
+						#ifdef PACKET_QDISC_BYPASS
+						{
+						int iOne = 1;
+
+							/* Let the frames from the TX ring skip the
+							queueing discipline of the host.  This is an
+							optimisation only, errors are ignored. */
+							( void ) setsockopt( iSocket, SOL_PACKET, PACKET_QDISC_BYPASS, &iOne, sizeof( iOne ) );
+						}
+						#endif
+
+						FreeRTOS_printf( ( "xNetworkInterfaceInitialise: opened '%s' with %u frames per ring\n", pcConfigNetworkInterfaceName, ( unsigned ) niRING_FRAME_COUNT ) );
+						ulRxIndex = 0u;
+						ulTxIndex = 0u;
+						iPacketSocket = iSocket;
+						xReturn = pdPASS;
+					}
+				}
+			}
+
+			if( xReturn != pdPASS )
+			{
+				close( iSocket );
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+struct tpacket2_hdr *pxFrame;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	pxFrame = prvGetFrame( pucTxRing, ulTxIndex );
+
+	/* The kernel sets the status of a slot back to TP_STATUS_AVAILABLE once
+	the frame has been sent.  Drop the packet if the next slot is still in
+	use, like a real EMAC would do when it runs out of DMA descriptors. */
+	if( ( pxNetworkBuffer->xDataLength <= ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) &&
+		( pxFrame->tp_status == TP_STATUS_AVAILABLE ) )
+	{
+		memcpy( ( ( uint8_t * ) pxFrame ) + niTX_DATA_OFFSET, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+		pxFrame->tp_len = ( uint32_t ) pxNetworkBuffer->xDataLength;
+
+		/* The contents of the slot must be visible to the kernel before its
+		status is changed. */
+		__sync_synchronize();
+		pxFrame->tp_status = TP_STATUS_SEND_REQUEST;
+		ulTxIndex = ( ulTxIndex + 1u ) % niRING_FRAME_COUNT;
+
+		/* Ask the kernel to transmit all slots that are marked with
+		TP_STATUS_SEND_REQUEST.  MSG_DONTWAIT makes sure that the IP-task never
+		blocks here. */
+		if( ( sendto( iPacketSocket, NULL, 0, MSG_DONTWAIT, NULL, 0 ) < 0 ) &&
+			( errno != EAGAIN ) && ( errno != ENOBUFS ) )
+		{
+			ulLinuxSendFailures++;
+		}
+	}
+	else
+	{
+		ulLinuxSendFailures++;
+	}
+
+	/* The buffer has been copied to the ring so it can be released. */
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterruptSimulatorTask( void *pvParameters )
+{
+struct tpacket2_hdr *pxFrame;
+const struct sockaddr_ll *pxAddress;
+const uint8_t *pucPacketData;
+size_t uxLength;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkRxBatch_t xRxBatch;
+#else
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
+eFrameProcessingResult_t eResult;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		vNetworkRxBatchInit( &xRxBatch );
+	}
+	#endif
+
+	for( ;; )
+	{
+		pxFrame = prvGetFrame( pucRxRing, ulRxIndex );
+
+		/* Has the kernel passed the next slot of the RX ring to user space? */
+		if( ( pxFrame->tp_status & TP_STATUS_USER ) != 0u )
+		{
+			/* The slot must not be read before its status has been seen. */
+			__sync_synchronize();
+
+			pucPacketData = ( ( const uint8_t * ) pxFrame ) + pxFrame->tp_mac;
+			pxAddress = ( const struct sockaddr_ll * ) ( ( ( const uint8_t * ) pxFrame ) + TPACKET_ALIGN( sizeof( struct tpacket2_hdr ) ) );
+			uxLength = ( size_t ) pxFrame->tp_snaplen;
+
+			iptraceNETWORK_INTERFACE_RECEIVE();
+
+			/* The socket also sees the frames that were sent by this node.
+			Truncated frames and frames that are too short are dropped. */
+			if( ( pxAddress->sll_pkttype == PACKET_OUTGOING ) ||
+				( pxFrame->tp_snaplen != pxFrame->tp_len ) ||
+				( uxLength < sizeof( EthernetHeader_t ) ) ||
+				( uxLength > ipTOTAL_ETHERNET_FRAME_SIZE ) )
+			{
+				eResult = eReleaseBuffer;
+			}
+			else
+			{
+				eResult = ipCONSIDER_FRAME_FOR_PROCESSING( pucPacketData );
+			}
+
+			if( eResult == eProcessBuffer )
+			{
+				/* Obtain a buffer into which the data can be placed.  This is
+				only an interrupt simulator, not a real interrupt, so it is ok
+				to call the task level function here. */
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+
+				if( pxNetworkBuffer != NULL )
+				{
+					memcpy( pxNetworkBuffer->pucEthernetBuffer, pucPacketData, uxLength );
+					pxNetworkBuffer->xDataLength = uxLength;
+
+					#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+					{
+						/* The batch is passed to the IP task when it is full,
+						or when the RX ring is empty. */
+						xNetworkRxBatchAdd( &xRxBatch, pxNetworkBuffer, ( TickType_t ) 0 );
+					}
+					#else
+					{
+						xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+						/* Data was received and stored.  Send a message to the
+						IP task to let it know. */
+						if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+						{
+							vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+							iptraceETHERNET_RX_EVENT_LOST();
+						}
+					}
+					#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+				}
+				else
+				{
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+
+			/* The data has been copied, return the slot to the kernel. */
+			__sync_synchronize();
+			pxFrame->tp_status = TP_STATUS_KERNEL;
+			ulRxIndex = ( ulRxIndex + 1u ) % niRING_FRAME_COUNT;
+		}
+		else
+		{
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* The ring is empty, pass the remaining packets to the IP
+				task. */
+				xNetworkRxBatchSend( &xRxBatch, ( TickType_t ) 0 );
+			}
+			#endif
+
+			/* There is no real way of simulating an interrupt.  Make sure
+			other tasks can run. */
+			#if( configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY != 0 )
+			{
+				vTaskDelay( configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY );
+			}
+			#else
+			{
+				taskYIELD();
+			}
+			#endif
+		}
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,457 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* A network interface that does not need any hardware: every frame that the
+stack sends is received by the same stack again, after passing a simulated
+link.  It allows a TCP client and server that both run on the device to talk
+to each other over the device's own IP address, e.g. to measure the
+performance of the stack itself.
+
+The link has a configurable bandwidth, delay, loss and reordering.  The
+random numbers are produced from a fixed seed, so a run can be repeated with
+exactly the same sequence of faults.  See also WinPCap/FaultInjection.c.
+
+When ipconfigUSE_NETWORK_RINGS is enabled, xNetworkInterfaceOutput() only
+pushes the frames to the TX ring.  The loopback task pops them and puts them
+on the link. */
+
+/* The bandwidth of the link in kbit/s, or 0 for an unlimited bandwidth. */
+#ifndef niLOOPBACK_BANDWIDTH_KBPS
+	#define niLOOPBACK_BANDWIDTH_KBPS		0u
+#endif
+
+/* The one-way delay of the link in ms. */
+#ifndef niLOOPBACK_DELAY_MS
+	#define niLOOPBACK_DELAY_MS				0u
+#endif
+
+/* The number of frames, per 1000, that get lost. */
+#ifndef niLOOPBACK_LOSS_PER_MILLE
+	#define niLOOPBACK_LOSS_PER_MILLE		0u
+#endif
+
+/* The number of frames, per 1000, that are held back for an extra
+niLOOPBACK_REORDER_DELAY_MS, so that the next frames will overtake them. */
+#ifndef niLOOPBACK_REORDER_PER_MILLE
+	#define niLOOPBACK_REORDER_PER_MILLE	0u
+#endif
+
+#ifndef niLOOPBACK_REORDER_DELAY_MS
+	#define niLOOPBACK_REORDER_DELAY_MS		10u
+#endif
+
+/* The maximum number of frames on the link.  When the link is full, new
+frames are dropped, like a router would do. */
+#ifndef niLOOPBACK_QUEUE_LENGTH
+	#define niLOOPBACK_QUEUE_LENGTH			( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 2 )
+#endif
+
+/* The seed of the random generator that decides about loss and reordering. */
+#ifndef niLOOPBACK_RANDOM_SEED
+	#define niLOOPBACK_RANDOM_SEED			0x5A5A1234UL
+#endif
+
+#ifndef configLOOPBACK_TASK_PRIORITY
+	#define configLOOPBACK_TASK_PRIORITY	( configMAX_PRIORITIES - 1 )
+#endif
+
+/* The length of a clock tick in us. */
+#define niTICK_US	( 1000000UL / configTICK_RATE_HZ )
+
+#if( niLOOPBACK_LOSS_PER_MILLE > 1000u ) || ( niLOOPBACK_REORDER_PER_MILLE > 1000u )
+	#error niLOOPBACK_LOSS_PER_MILLE and niLOOPBACK_REORDER_PER_MILLE must be in the range 0 .. 1000
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that passes the frames to the IP-task at the moment that they
+ * leave the simulated link.
+ */
+static void prvLoopbackTask( void *pvParameters );
+
+/*
+ * ARP messages are not put on the link.  Returns pdTRUE when the frame is an
+ * ARP message, which has been handled locally.
+ */
+static BaseType_t prvHandleARPRequest( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * Returns the time, in clock ticks, that a frame of 'xLength' bytes will spend
+ * on the link.
+ */
+static TickType_t prvLinkDelay( size_t xLength );
+
+/*
+ * Apply the loss and queue limits of the link to a frame that is owned by the
+ * driver.  The frame is either put on the link, or released.
+ */
+static void prvPutOnLink( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * A simple linear congruential generator, returns a number in the range
+ * 0 .. 999.
+ */
+static uint32_t prvRandomPerMille( void );
+
+/*-----------------------------------------------------------*/
+
+/* The frames on the link, sorted by the time at which they will be received.
+The list is written by the IP-task, or by the loopback task when the TX ring
+is used, and read by the loopback task. */
+static List_t xLinkList;
+
+/* The task that delivers the frames. */
+static TaskHandle_t xLoopbackTaskHandle = NULL;
+
+#if( niLOOPBACK_BANDWIDTH_KBPS != 0 )
+	/* The amount of transmission time, in us, that was still queued at
+	xBacklogTime. */
+	static uint32_t ulBacklogUs = 0u;
+	static TickType_t xBacklogTime = 0u;
+#endif
+
+static uint32_t ulRandomState = niLOOPBACK_RANDOM_SEED;
+
+/* Counters for viewing in the debugger only. */
+static volatile uint32_t ulLoopbackSent = 0u;
+static volatile uint32_t ulLoopbackLost = 0u;
+static volatile uint32_t ulLoopbackReordered = 0u;
+static volatile uint32_t ulLoopbackQueueFull = 0u;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	/* This function may be called again after the network went down. */
+	if( xLoopbackTaskHandle == NULL )
+	{
+		vListInitialise( &xLinkList );
+		xTaskCreate( prvLoopbackTask, "Loopback", configMINIMAL_STACK_SIZE, NULL, configLOOPBACK_TASK_PRIORITY, &xLoopbackTaskHandle );
+	}
+
+	return ( xLoopbackTaskHandle != NULL ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetPhyLinkStatus( void )
+{
+	/* The simulated link is always up. */
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandomPerMille( void )
+{
+	ulRandomState = ( ulRandomState * 1103515245UL ) + 12345UL;
+
+	return ( ulRandomState >> 16 ) % 1000u;
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvLinkDelay( size_t xLength )
+{
+uint32_t ulDelayUs = niLOOPBACK_DELAY_MS * 1000u;
+
+	#if( niLOOPBACK_BANDWIDTH_KBPS != 0 )
+	{
+	TickType_t xElapsed;
+
+		/* The link transmits one frame at a time.  A new frame must wait until
+		the frames before it have been sent. */
+		xElapsed = xTaskGetTickCount() - xBacklogTime;
+		xBacklogTime += xElapsed;
+
+		if( xElapsed > ( TickType_t ) ( ulBacklogUs / niTICK_US ) )
+		{
+			ulBacklogUs = 0u;
+		}
+		else
+		{
+			ulBacklogUs -= ( uint32_t ) xElapsed * niTICK_US;
+		}
+
+		/* bits * 1000 / kbps gives the transmission time in us. */
+		ulBacklogUs += ( uint32_t ) ( ( ( uint64_t ) xLength * 8000u ) / niLOOPBACK_BANDWIDTH_KBPS );
+		ulDelayUs += ulBacklogUs;
+	}
+	#else
+	{
+		( void ) xLength;
+	}
+	#endif /* niLOOPBACK_BANDWIDTH_KBPS */
+
+	/* Round up to a whole number of clock ticks. */
+	return ( TickType_t ) ( ( ulDelayUs + niTICK_US - 1u ) / niTICK_US );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHandleARPRequest( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+const ARPPacket_t *pxARPFrame = ( const ARPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+BaseType_t xReturn = pdFALSE;
+
+	if( pxARPFrame->xEthernetHeader.usFrameType == ipARP_FRAME_TYPE )
+	{
+		/* There is no other node on this link.  When the stack asks for
+		its own IP address, the ARP cache is updated directly.  Looping the
+		request back would make the stack believe that another device uses
+		the same IP address.  Other ARP messages, like gratuitous ARP, are
+		dropped for the same reason. */
+		if( ( pxARPFrame->xARPHeader.usOperation == ( uint16_t ) ipARP_REQUEST ) &&
+			( pxARPFrame->xARPHeader.ulTargetProtocolAddress == *ipLOCAL_IP_ADDRESS_POINTER ) &&
+			( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) )
+		{
+			vARPRefreshCacheEntry( ( const MACAddress_t * ) ipLOCAL_MAC_ADDRESS, *ipLOCAL_IP_ADDRESS_POINTER );
+		}
+
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutOnLink( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+TickType_t xDelay;
+
+	if( ( niLOOPBACK_LOSS_PER_MILLE != 0u ) && ( prvRandomPerMille() < niLOOPBACK_LOSS_PER_MILLE ) )
+	{
+		ulLoopbackLost++;
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	else if( listCURRENT_LIST_LENGTH( &xLinkList ) >= ( UBaseType_t ) niLOOPBACK_QUEUE_LENGTH )
+	{
+		ulLoopbackQueueFull++;
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	else
+	{
+		xDelay = prvLinkDelay( pxNetworkBuffer->xDataLength );
+
+		if( ( niLOOPBACK_REORDER_PER_MILLE != 0u ) && ( prvRandomPerMille() < niLOOPBACK_REORDER_PER_MILLE ) )
+		{
+			xDelay += pdMS_TO_TICKS( niLOOPBACK_REORDER_DELAY_MS );
+			ulLoopbackReordered++;
+		}
+
+		/* The list is sorted on the time of arrival.  Frames that
+		arrive in the same clock tick keep their order. */
+		vListInitialiseItem( &( pxNetworkBuffer->xBufferListItem ) );
+		listSET_LIST_ITEM_OWNER( &( pxNetworkBuffer->xBufferListItem ), ( void * ) pxNetworkBuffer );
+		listSET_LIST_ITEM_VALUE( &( pxNetworkBuffer->xBufferListItem ), xTaskGetTickCount() + xDelay );
+
+		taskENTER_CRITICAL();
+		{
+			vListInsert( &xLinkList, &( pxNetworkBuffer->xBufferListItem ) );
+		}
+		taskEXIT_CRITICAL();
+
+		ulLoopbackSent++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxLinkBuffer = NULL;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	if( prvHandleARPRequest( pxNetworkBuffer ) != pdFALSE )
+	{
+		/* Nothing to send. */
+	}
+	else
+	{
+		if( bReleaseAfterSend != pdFALSE )
+		{
+			/* The buffer can be passed to the IP-task again. */
+			pxLinkBuffer = pxNetworkBuffer;
+			bReleaseAfterSend = pdFALSE;
+		}
+		else
+		{
+			/* The caller still owns the buffer, send a copy. */
+			pxLinkBuffer = pxGetNetworkBufferWithDescriptor( pxNetworkBuffer->xDataLength, 0 );
+
+			if( pxLinkBuffer != NULL )
+			{
+				memcpy( pxLinkBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+				pxLinkBuffer->xDataLength = pxNetworkBuffer->xDataLength;
+			}
+		}
+
+		if( pxLinkBuffer != NULL )
+		{
+			#if( ipconfigUSE_NETWORK_RINGS != 0 )
+			{
+				/* The loopback task will put the frame on the link. */
+				if( xNetworkTxRingPush( pxLinkBuffer ) == pdFAIL )
+				{
+					ulLoopbackQueueFull++;
+					vReleaseNetworkBufferAndDescriptor( pxLinkBuffer );
+				}
+			}
+			#else
+			{
+				prvPutOnLink( pxLinkBuffer );
+			}
+			#endif /* ipconfigUSE_NETWORK_RINGS */
+
+			xTaskNotifyGive( xLoopbackTaskHandle );
+		}
+	}
+
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoopbackTask( void *pvParameters )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+TickType_t xNow, xArrival, xSleepTime;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkRxBatch_t xRxBatch;
+#else
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		vNetworkRxBatchInit( &xRxBatch );
+	}
+	#endif
+
+	for( ;; )
+	{
+		#if( ipconfigUSE_NETWORK_RINGS != 0 )
+		{
+			/* Put the frames that were sent by the IP-task on the link. */
+			for( ;; )
+			{
+				pxNetworkBuffer = pxNetworkTxRingPop();
+
+				if( pxNetworkBuffer == NULL )
+				{
+					break;
+				}
+
+				prvPutOnLink( pxNetworkBuffer );
+			}
+		}
+		#endif /* ipconfigUSE_NETWORK_RINGS */
+
+		pxNetworkBuffer = NULL;
+		xSleepTime = portMAX_DELAY;
+		xNow = xTaskGetTickCount();
+
+		taskENTER_CRITICAL();
+		{
+			if( listLIST_IS_EMPTY( &xLinkList ) == pdFALSE )
+			{
+				xArrival = listGET_ITEM_VALUE_OF_HEAD_ENTRY( &xLinkList );
+
+				/* Has the frame at the head of the list arrived? */
+				if( ( TickType_t ) ( xArrival - xNow ) > ( TickType_t ) ( portMAX_DELAY / 2u ) )
+				{
+					xArrival = xNow;
+				}
+
+				if( xArrival == xNow )
+				{
+					pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xLinkList );
+					( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+				}
+				else
+				{
+					xSleepTime = xArrival - xNow;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( pxNetworkBuffer != NULL )
+		{
+			iptraceNETWORK_INTERFACE_RECEIVE();
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				xNetworkRxBatchAdd( &xRxBatch, pxNetworkBuffer, ( TickType_t ) 0 );
+			}
+			#else
+			{
+				xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+				if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					iptraceETHERNET_RX_EVENT_LOST();
+				}
+			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+		}
+		else
+		{
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* No more frames have arrived, pass the batch to the IP task. */
+				xNetworkRxBatchSend( &xRxBatch, ( TickType_t ) 0 );
+			}
+			#endif
+
+			/* Sleep until the next frame arrives, or until a new frame is put
+			on the link. */
+			( void ) ulTaskNotifyTake( pdTRUE, xSleepTime );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
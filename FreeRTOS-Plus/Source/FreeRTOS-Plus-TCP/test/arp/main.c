@@ -0,0 +1,520 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks the ageing of the ARP cache with ipconfigARP_REFRESH_AGE.
+ * FreeRTOS_ARP.c is included in this file, the rest of the IP-stack is replaced
+ * by a few stubs that record every ARP request that is sent.
+ *
+ * - Entries that are in use are refreshed with a unicast request when their
+ *   age drops to ipconfigARP_REFRESH_AGE, at most
+ *   ipconfigARP_MAX_REQUESTS_PER_PERIOD of them in one period.
+ * - Entries that are about to expire are all checked in the same period,
+ *   the limit does not apply to them.
+ * - The limit for refreshing entries is not used up by the entries that are
+ *   about to expire.
+ *
+ * With ipconfigARP_PENDING_QUEUE_LENGTH, also the packets that wait for an ARP
+ * reply are checked:
+ *
+ * - A reply releases the packets for its address in the order in which they
+ *   were queued, packets for other addresses keep waiting.
+ * - No more than ipconfigARP_PENDING_PER_DESTINATION packets wait for one
+ *   address, and no more than ipconfigARP_PENDING_QUEUE_LENGTH in total.
+ * - Packets that wait longer than ipconfigARP_PENDING_TIMEOUT_MS are dropped,
+ *   and their network buffers are released.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../FreeRTOS_ARP.c"
+
+#if( ipconfigARP_REFRESH_AGE == 0 )
+	#error This test needs ipconfigARP_REFRESH_AGE
+#endif
+
+#define arptestMAX_ENTRIES		( 6 )
+
+NetworkAddressingParameters_t xNetworkAddressing;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+const MACAddress_t xBroadcastMACAddress = { { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+
+/* The requests that were sent during the last call to vARPAgeCache(), not
+counting the gratuitous ARP of the own address. */
+static int iBroadcasts = 0;
+static int iUnicasts = 0;
+static int iUnicastsToWrongMAC = 0;
+static int iFailures = 0;
+
+/* The network buffers that are in use. */
+static int iBuffersInUse = 0;
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	/* The packets that were passed to vProcessGeneratedUDPPacket(), by
+	the number in their 'usPort'. */
+	static uint16_t usSent[ ipconfigARP_PENDING_QUEUE_LENGTH * 2 ];
+	static int iSent = 0;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define arptestCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+	( void ) eEvent;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout )
+{
+	( void ) pxEvent;
+	( void ) xTimeout;
+
+	/* All requests are sent from the IP-task. */
+	iFailures++;
+
+	return pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+
+	( void ) xBlockTimeTicks;
+	pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+	pxBuffer->xDataLength = xRequestedSizeBytes;
+	iBuffersInUse++;
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	free( pxNetworkBuffer->pucEthernetBuffer );
+	free( pxNetworkBuffer );
+	iBuffersInUse--;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	void vIPReloadARPPendingTimer( uint32_t ulCheckTime )
+	{
+		( void ) ulCheckTime;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+	uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
+	MACAddress_t xMACAddress;
+
+		/* A packet is only passed on when its destination has been resolved. */
+		arptestCHECK( eARPGetCacheEntry( &ulIPAddress, &xMACAddress ) == eARPCacheHit );
+
+		if( iSent < ( int ) ( sizeof( usSent ) / sizeof( usSent[ 0 ] ) ) )
+		{
+			usSent[ iSent ] = pxNetworkBuffer->usPort;
+		}
+
+		iSent++;
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+ARPPacket_t *pxARPPacket = ( ARPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+uint32_t ulTarget = pxARPPacket->xARPHeader.ulTargetProtocolAddress;
+BaseType_t x;
+
+	arptestCHECK( pxARPPacket->xARPHeader.usOperation == ipARP_REQUEST );
+
+	if( ulTarget != *ipLOCAL_IP_ADDRESS_POINTER )
+	{
+		if( memcmp( pxARPPacket->xEthernetHeader.xDestinationAddress.ucBytes, xBroadcastMACAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
+		{
+			iBroadcasts++;
+		}
+		else
+		{
+			iUnicasts++;
+
+			/* A refresh is sent to the MAC-address in the cache. */
+			for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+			{
+				if( xARPCache[ x ].ulIPAddress == ulTarget )
+				{
+					break;
+				}
+			}
+
+			if( ( x == ipconfigARP_CACHE_ENTRIES ) ||
+				( memcmp( pxARPPacket->xEthernetHeader.xDestinationAddress.ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) ) != 0 ) )
+			{
+				iUnicastsToWrongMAC++;
+			}
+		}
+	}
+
+	if( xReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAddress( int iHost )
+{
+	return FreeRTOS_inet_addr_quick( 192, 168, 1, 100 + iHost );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddEntries( int iFirst, int iCount )
+{
+MACAddress_t xMACAddress = { { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+int iHost;
+
+	for( iHost = iFirst; iHost < iFirst + iCount; iHost++ )
+	{
+		xMACAddress.ucBytes[ 5 ] = ( uint8_t ) iHost;
+		vARPRefreshCacheEntry( &xMACAddress, prvAddress( iHost ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvUseEntries( int iFirst, int iCount )
+{
+MACAddress_t xMACAddress;
+uint32_t ulIPAddress;
+int iHost;
+
+	memset( &xMACAddress, 0, sizeof( xMACAddress ) );
+
+	for( iHost = iFirst; iHost < iFirst + iCount; iHost++ )
+	{
+		ulIPAddress = prvAddress( iHost );
+		arptestCHECK( eARPGetCacheEntry( &ulIPAddress, &xMACAddress ) == eARPCacheHit );
+		arptestCHECK( xMACAddress.ucBytes[ 5 ] == ( uint8_t ) iHost );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvAgeCache( int iPeriods )
+{
+int iPeriod;
+
+	for( iPeriod = 0; iPeriod < iPeriods; iPeriod++ )
+	{
+		iBroadcasts = 0;
+		iUnicasts = 0;
+		vARPAgeCache();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestExpiry( void )
+{
+MACAddress_t xMACAddress;
+
+	/* Entries that are not used are not refreshed.  When they are about to
+	expire, all of them are checked at once with a broadcast. */
+	FreeRTOS_ClearARP();
+	prvAddEntries( 0, arptestMAX_ENTRIES );
+
+	prvAgeCache( ipconfigMAX_ARP_AGE - arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST - 1 );
+	arptestCHECK( iBroadcasts == 0 );
+	arptestCHECK( iUnicasts == 0 );
+
+	prvAgeCache( 1 );
+	arptestCHECK( iBroadcasts == arptestMAX_ENTRIES );
+	arptestCHECK( iUnicasts == 0 );
+	printf( "expiry:  %d entries checked in one period\n", iBroadcasts );
+
+	/* Without a reply, the entries are removed. */
+	prvAgeCache( arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST );
+	arptestCHECK( prvCacheLookup( prvAddress( 0 ), &xMACAddress ) == eARPCacheMiss );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRefresh( void )
+{
+int iPeriod, iRefreshed = 0;
+
+	/* Entries that are used are refreshed before they get old, spread over
+	several periods. */
+	FreeRTOS_ClearARP();
+	prvAddEntries( 0, arptestMAX_ENTRIES );
+	prvUseEntries( 0, arptestMAX_ENTRIES );
+
+	prvAgeCache( ipconfigMAX_ARP_AGE - ipconfigARP_REFRESH_AGE - 1 );
+	arptestCHECK( iUnicasts == 0 );
+
+	for( iPeriod = 0; iRefreshed < arptestMAX_ENTRIES; iPeriod++ )
+	{
+		prvAgeCache( 1 );
+		arptestCHECK( iBroadcasts == 0 );
+		arptestCHECK( iUnicasts > 0 );
+		arptestCHECK( iUnicasts <= ipconfigARP_MAX_REQUESTS_PER_PERIOD );
+		iRefreshed += iUnicasts;
+
+		if( iUnicasts == 0 )
+		{
+			break;
+		}
+	}
+
+	arptestCHECK( iRefreshed == arptestMAX_ENTRIES );
+	arptestCHECK( iUnicastsToWrongMAC == 0 );
+	printf( "refresh: %d entries refreshed in %d periods\n", iRefreshed, iPeriod );
+
+	/* The replies reset the age.  The entries are only refreshed again when
+	they have been used in the mean time. */
+	prvAddEntries( 0, arptestMAX_ENTRIES );
+	prvUseEntries( 0, 1 );
+	prvAgeCache( ipconfigMAX_ARP_AGE - ipconfigARP_REFRESH_AGE );
+	arptestCHECK( iUnicasts == 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRefreshWhileExpiring( void )
+{
+const int iExpiring = 4, iUsed = 2;
+
+	/* Entries that are about to expire, and entries that need a refresh, in
+	the same period.  The checks of the expiring entries may not use up the
+	requests that are allowed for refreshing. */
+	FreeRTOS_ClearARP();
+	prvAddEntries( 0, iExpiring );
+	prvAgeCache( ipconfigARP_REFRESH_AGE - arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST );
+	prvAddEntries( iExpiring, iUsed );
+	prvUseEntries( iExpiring, iUsed );
+
+	prvAgeCache( ipconfigMAX_ARP_AGE - ipconfigARP_REFRESH_AGE );
+	arptestCHECK( iBroadcasts == iExpiring );
+	arptestCHECK( iUnicasts == iUsed );
+	arptestCHECK( iUnicastsToWrongMAC == 0 );
+	printf( "mixed:   %d entries checked, %d refreshed in one period\n", iBroadcasts, iUnicasts );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+
+	static BaseType_t prvQueuePacket( int iHost, uint16_t usNumber )
+	{
+	NetworkBufferDescriptor_t *pxBuffer = pxGetNetworkBufferWithDescriptor( ipconfigNETWORK_MTU, 0u );
+	MACAddress_t xMACAddress;
+	uint32_t ulLookupAddress = prvAddress( iHost );
+	BaseType_t xQueued;
+
+		pxBuffer->ulIPAddress = prvAddress( iHost );
+		pxBuffer->usPort = usNumber;
+
+		/* Like vProcessGeneratedUDPPacket(): the first packet to an unknown
+		address causes an ARP request, which makes an entry that is not valid
+		yet. */
+		if( eARPGetCacheEntry( &ulLookupAddress, &xMACAddress ) == eARPCacheMiss )
+		{
+			vARPRefreshCacheEntry( NULL, ulLookupAddress );
+		}
+
+		xQueued = xARPPendingAdd( pxBuffer, ulLookupAddress );
+
+		if( xQueued == pdFALSE )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxBuffer );
+		}
+
+		return xQueued;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvReply( int iHost )
+	{
+	MACAddress_t xMACAddress = { { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+
+		xMACAddress.ucBytes[ 5 ] = ( uint8_t ) iHost;
+		vARPRefreshCacheEntry( &xMACAddress, prvAddress( iHost ) );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTestPendingOrder( void )
+	{
+	ARPPendingStats_t xStats;
+
+		/* Packets for hosts 1 and 2, interleaved.  The reply from host 1 only
+		releases its own packets, in the order in which they were queued. */
+		FreeRTOS_ClearARP();
+		iSent = 0;
+		arptestCHECK( prvQueuePacket( 1, 1u ) == pdTRUE );
+		arptestCHECK( prvQueuePacket( 2, 2u ) == pdTRUE );
+		arptestCHECK( prvQueuePacket( 1, 3u ) == pdTRUE );
+		arptestCHECK( prvQueuePacket( 2, 4u ) == pdTRUE );
+		arptestCHECK( prvQueuePacket( 1, 5u ) == pdTRUE );
+		arptestCHECK( iSent == 0 );
+
+		prvReply( 1 );
+		arptestCHECK( iSent == 3 );
+		arptestCHECK( ( usSent[ 0 ] == 1u ) && ( usSent[ 1 ] == 3u ) && ( usSent[ 2 ] == 5u ) );
+
+		prvReply( 2 );
+		arptestCHECK( iSent == 5 );
+		arptestCHECK( ( usSent[ 3 ] == 2u ) && ( usSent[ 4 ] == 4u ) );
+
+		FreeRTOS_GetARPPendingStats( &xStats );
+		arptestCHECK( xStats.uxPacketsWaiting == 0u );
+		arptestCHECK( iBuffersInUse == 0 );
+		printf( "pending: %d packets sent in order on reply\n", iSent );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTestPendingLimits( void )
+	{
+	ARPPendingStats_t xBefore, xAfter;
+	int iPacket, iHost;
+
+		FreeRTOS_ClearARP();
+		iSent = 0;
+		FreeRTOS_GetARPPendingStats( &xBefore );
+
+		/* One more than the limit for a single destination. */
+		for( iPacket = 0; iPacket < ipconfigARP_PENDING_PER_DESTINATION; iPacket++ )
+		{
+			arptestCHECK( prvQueuePacket( 1, ( uint16_t ) iPacket ) == pdTRUE );
+		}
+
+		arptestCHECK( prvQueuePacket( 1, 99u ) == pdFALSE );
+
+		/* Other destinations until the queue is full. */
+		for( iHost = 2; iPacket < ipconfigARP_PENDING_QUEUE_LENGTH; iPacket++, iHost++ )
+		{
+			arptestCHECK( prvQueuePacket( iHost, ( uint16_t ) iPacket ) == pdTRUE );
+		}
+
+		arptestCHECK( prvQueuePacket( iHost, 99u ) == pdFALSE );
+
+		FreeRTOS_GetARPPendingStats( &xAfter );
+		arptestCHECK( xAfter.uxPacketsWaiting == ( UBaseType_t ) ipconfigARP_PENDING_QUEUE_LENGTH );
+		arptestCHECK( xAfter.ulPacketsDropped - xBefore.ulPacketsDropped == 2u );
+		arptestCHECK( iBuffersInUse == ipconfigARP_PENDING_QUEUE_LENGTH );
+
+		/* A packet to an address that has no outstanding request is not
+		held. */
+		prvReply( 1 );
+		arptestCHECK( iSent == ipconfigARP_PENDING_PER_DESTINATION );
+		arptestCHECK( prvQueuePacket( 1, 99u ) == pdFALSE );
+		printf( "limits:  %d packets per destination, %d in total\n", ipconfigARP_PENDING_PER_DESTINATION, ipconfigARP_PENDING_QUEUE_LENGTH );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTestPendingTimeOut( void )
+	{
+	ARPPendingStats_t xBefore, xAfter;
+
+		/* Continues with the packets of prvTestPendingLimits() that are still
+		waiting.  Packets that are added later time out later. */
+		FreeRTOS_GetARPPendingStats( &xBefore );
+		arptestCHECK( xBefore.uxPacketsWaiting != 0u );
+
+		vTaskStepTick( pdMS_TO_TICKS( ipconfigARP_PENDING_TIMEOUT_MS ) - 1u );
+		arptestCHECK( prvQueuePacket( 20, 20u ) == pdTRUE );
+		arptestCHECK( xARPPendingAgeing() == pdTRUE );
+
+		vTaskStepTick( 1u );
+		arptestCHECK( xARPPendingAgeing() == pdTRUE );
+		FreeRTOS_GetARPPendingStats( &xAfter );
+		arptestCHECK( xAfter.uxPacketsWaiting == 1u );
+		arptestCHECK( xAfter.ulPacketsTimedOut - xBefore.ulPacketsTimedOut == xBefore.uxPacketsWaiting );
+		arptestCHECK( iBuffersInUse == 1 );
+
+		vTaskStepTick( pdMS_TO_TICKS( ipconfigARP_PENDING_TIMEOUT_MS ) );
+		arptestCHECK( xARPPendingAgeing() == pdFALSE );
+		arptestCHECK( iBuffersInUse == 0 );
+		printf( "timeout: %lu packets dropped, all buffers released\n", ( unsigned long ) ( xBefore.uxPacketsWaiting + 1u ) );
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigARP_PENDING_QUEUE_LENGTH */
+
+int main( void )
+{
+	*ipLOCAL_IP_ADDRESS_POINTER = FreeRTOS_inet_addr_quick( 192, 168, 1, 10 );
+	xNetworkAddressing.ulNetMask = FreeRTOS_inet_addr_quick( 255, 255, 255, 0 );
+	xNetworkAddressing.ulBroadcastAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 255 );
+
+	#if( ipconfigUSE_ARP_HASH_TABLE != 0 )
+	{
+		FreeRTOS_ClearARP();
+	}
+	#endif
+
+	#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	{
+		vARPPendingInit();
+	}
+	#endif
+
+	prvTestExpiry();
+	prvTestRefresh();
+	prvTestRefreshWhileExpiring();
+
+	#if( ipconfigARP_PENDING_QUEUE_LENGTH != 0 )
+	{
+		prvTestPendingOrder();
+		prvTestPendingLimits();
+		prvTestPendingTimeOut();
+	}
+	#endif
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,273 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A first-fit heap in a static array of configTOTAL_HEAP_SIZE bytes, that
+ * works like heap_4.c of the FreeRTOS kernel: the free blocks are kept in
+ * order of their address, and a block that is freed is merged with the free
+ * blocks around it.  It replaces the heap of the host kernel, which uses
+ * malloc() and therefore can not become fragmented.
+ */
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "heap.h"
+
+#define heapALIGNMENT			( ( size_t ) 8u )
+#define heapALIGNMENT_MASK		( heapALIGNMENT - 1u )
+
+/* A free block is only split when the remainder can hold a block of this
+size. */
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize << 1 ) )
+
+/* The most significant bit of xBlockSize marks an allocated block. */
+#define heapBLOCK_ALLOCATED		( ( size_t ) 1u << ( ( sizeof( size_t ) * 8u ) - 1u ) )
+
+typedef struct A_BLOCK_LINK
+{
+	struct A_BLOCK_LINK *pxNextFreeBlock;
+	size_t xBlockSize;
+} BlockLink_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Put the whole array in a single free block.
+ */
+static void prvHeapInit( void );
+
+/*
+ * Insert a block in the free list, and merge it with the blocks before and
+ * after it when they are adjacent.
+ */
+static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t ullHeap[ configTOTAL_HEAP_SIZE / sizeof( uint64_t ) ];
+
+static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + heapALIGNMENT_MASK ) & ~heapALIGNMENT_MASK;
+
+static BlockLink_t xStart;
+static BlockLink_t *pxEnd = NULL;
+
+static size_t xFreeBytesRemaining = 0u;
+static size_t xMinimumEverFreeBytesRemaining = 0u;
+
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+BlockLink_t *pxFirstFreeBlock;
+uint8_t *pucHeap = ( uint8_t * ) ullHeap;
+size_t xTotalHeapSize = sizeof( ullHeap );
+
+	xStart.pxNextFreeBlock = ( BlockLink_t * ) pucHeap;
+	xStart.xBlockSize = 0u;
+
+	/* The end marker is at the end of the array. */
+	pxEnd = ( BlockLink_t * ) ( pucHeap + xTotalHeapSize - xHeapStructSize );
+	pxEnd->xBlockSize = 0u;
+	pxEnd->pxNextFreeBlock = NULL;
+
+	pxFirstFreeBlock = ( BlockLink_t * ) pucHeap;
+	pxFirstFreeBlock->xBlockSize = ( size_t ) ( ( uint8_t * ) pxEnd - pucHeap );
+	pxFirstFreeBlock->pxNextFreeBlock = pxEnd;
+
+	xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
+{
+BlockLink_t *pxIterator;
+uint8_t *puc;
+
+	for( pxIterator = &xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+	{
+	}
+
+	puc = ( uint8_t * ) pxIterator;
+	if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+	{
+		pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+		pxBlockToInsert = pxIterator;
+	}
+
+	puc = ( uint8_t * ) pxBlockToInsert;
+	if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+	{
+		if( pxIterator->pxNextFreeBlock != pxEnd )
+		{
+			pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+			pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+		}
+		else
+		{
+			pxBlockToInsert->pxNextFreeBlock = pxEnd;
+		}
+	}
+	else
+	{
+		pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+	}
+
+	if( pxIterator != pxBlockToInsert )
+	{
+		pxIterator->pxNextFreeBlock = pxBlockToInsert;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
+void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		if( pxEnd == NULL )
+		{
+			prvHeapInit();
+		}
+
+		if( ( xWantedSize > 0u ) && ( ( xWantedSize & heapBLOCK_ALLOCATED ) == 0u ) )
+		{
+			xWantedSize += xHeapStructSize;
+			xWantedSize = ( xWantedSize + heapALIGNMENT_MASK ) & ~heapALIGNMENT_MASK;
+
+			if( xWantedSize <= xFreeBytesRemaining )
+			{
+				/* Walk the list from the lowest address until a block is found
+				that is large enough. */
+				pxPreviousBlock = &xStart;
+				pxBlock = xStart.pxNextFreeBlock;
+				while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+				{
+					pxPreviousBlock = pxBlock;
+					pxBlock = pxBlock->pxNextFreeBlock;
+				}
+
+				if( pxBlock != pxEnd )
+				{
+					pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+					pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+					if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+					{
+						pxNewBlockLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+						pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+						pxBlock->xBlockSize = xWantedSize;
+						prvInsertBlockIntoFreeList( pxNewBlockLink );
+					}
+
+					xFreeBytesRemaining -= pxBlock->xBlockSize;
+					if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+					{
+						xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+					}
+
+					pxBlock->xBlockSize |= heapBLOCK_ALLOCATED;
+					pxBlock->pxNextFreeBlock = NULL;
+				}
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+BlockLink_t *pxLink;
+
+	if( pv != NULL )
+	{
+		pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+		configASSERT( ( pxLink->xBlockSize & heapBLOCK_ALLOCATED ) != 0u );
+		configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+		pxLink->xBlockSize &= ~heapBLOCK_ALLOCATED;
+
+		vTaskSuspendAll();
+		{
+			xFreeBytesRemaining += pxLink->xBlockSize;
+			prvInsertBlockIntoFreeList( pxLink );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	if( pxEnd == NULL )
+	{
+		prvHeapInit();
+	}
+
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	if( pxEnd == NULL )
+	{
+		prvHeapInit();
+	}
+
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xHeapGetLargestFreeBlock( void )
+{
+BlockLink_t *pxBlock;
+size_t xLargest = 0u;
+
+	if( pxEnd == NULL )
+	{
+		prvHeapInit();
+	}
+
+	for( pxBlock = xStart.pxNextFreeBlock; ( pxBlock != NULL ) && ( pxBlock != pxEnd ); pxBlock = pxBlock->pxNextFreeBlock )
+	{
+		if( pxBlock->xBlockSize > xLargest )
+		{
+			xLargest = pxBlock->xBlockSize;
+		}
+	}
+
+	/* The number of bytes that one pvPortMalloc() call can obtain. */
+	return ( xLargest > xHeapStructSize ) ? xLargest - xHeapStructSize : 0u;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,506 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A long-running benchmark of the buffer allocation schemes.  The scheme is
+ * selected with buffersSCHEME, and its source file is included in this file.
+ *
+ * Every step gets or releases a network buffer, with the sizes of mixed
+ * traffic: TCP acknowledgements, small UDP datagrams and full frames.  Some
+ * buffers are resized, like the stack does when it turns a received packet
+ * into a reply.  Now and then, the application creates or deletes a socket
+ * stream, which competes with the packets for the heap.  The heap is a
+ * first-fit heap like heap_4.c, see heap.c.
+ *
+ * Reported are the CPU cycles of a get and of a release: the average, and the
+ * number of cycles within which 99.9% of the calls return.  The host's own
+ * interrupts make a single worst case meaningless.  Also reported are the
+ * requests that failed although the heap had enough free
+ * bytes, and the fragmentation of the heap: the part of the free heap that
+ * is not in the largest free block.  For BufferAllocation_3.c the high-water
+ * marks of its slabs are shown as well.
+ *
+ * Every buffer is filled with a pattern that is checked when it is released.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( buffersSCHEME == 1 )
+	#include "../../portable/BufferManagement/BufferAllocation_1.c"
+#elif( buffersSCHEME == 2 )
+	#include "../../portable/BufferManagement/BufferAllocation_2.c"
+#elif( buffersSCHEME == 3 )
+	#include "../../portable/BufferManagement/BufferAllocation_3.c"
+#else
+	#error Define buffersSCHEME as 1, 2 or 3
+#endif
+
+#include "heap.h"
+
+#ifndef buffersSTEPS
+	#define buffersSTEPS			( 2000000u )
+#endif
+
+/* The number of network buffers that are held at most.  Some descriptors
+are left for the stack. */
+#define buffersMAX_HELD				( ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * 3 ) / 4 )
+
+/* The application holds at most this many stream buffers, of at most
+buffersMAX_STREAM_BYTES together. */
+#define buffersMAX_STREAMS			( 12 )
+#define buffersMAX_STREAM_BYTES		( ( size_t ) ( configTOTAL_HEAP_SIZE / 2 ) )
+
+/* A socket is created or deleted once in this many steps. */
+#define buffersSTREAM_PERIOD		( 64u )
+
+/* The fragmentation of the heap is measured once in this many steps. */
+#define buffersSAMPLE_PERIOD		( 1024u )
+
+/* The size of a full frame, without the 4 bytes of the FCS. */
+#define buffersFULL_FRAME			( ( size_t ) ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) )
+
+/*-----------------------------------------------------------*/
+
+typedef struct xHELD_STREAM
+{
+	uint8_t *pucBuffer;
+	size_t uxSize;
+} HeldStream_t;
+
+static NetworkBufferDescriptor_t *pxHeld[ buffersMAX_HELD ];
+static uint8_t ucHeldPattern[ buffersMAX_HELD ];
+static UBaseType_t uxHeldCount = 0u;
+
+static HeldStream_t xStreams[ buffersMAX_STREAMS ];
+static UBaseType_t uxStreamCount = 0u;
+static size_t uxStreamBytes = 0u;
+
+static uint32_t ulRandomState = 0x12345678ul;
+
+/* The cost of the API calls, in the unit of ullHostRunTimeCounter(), in total
+and as a histogram: element n counts the calls that took less than 2^n. */
+#define buffersHISTOGRAM_SIZE		( 40 )
+
+static uint64_t ullGetCycles = 0u, ullReleaseCycles = 0u;
+static unsigned long ulGetHistogram[ buffersHISTOGRAM_SIZE ], ulReleaseHistogram[ buffersHISTOGRAM_SIZE ];
+static unsigned long ulGets = 0ul, ulReleases = 0ul, ulResizes = 0ul;
+
+/* Requests that failed, and those of them that failed although the heap had
+enough free bytes. */
+static unsigned long ulGetFailures = 0ul, ulGetFragmentFailures = 0ul;
+static unsigned long ulStreams = 0ul, ulStreamFailures = 0ul, ulStreamFragmentFailures = 0ul;
+
+/* The fragmentation of the heap in percent. */
+static unsigned uMaxFragmentation = 0u;
+static size_t uxMinLargestFreeBlock = ~( size_t ) 0u;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define buffersCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+#if( buffersSCHEME == 1 )
+
+	/* BufferAllocation_1.c gets its storage from the network interface. */
+	static uint8_t ucBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ][ ( ipTOTAL_ETHERNET_FRAME_SIZE + ipBUFFER_PADDING + 7u ) & ~7u ] __attribute__( ( aligned( 8 ) ) );
+
+	void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
+	{
+	BaseType_t x;
+
+		for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+		{
+			pxNetworkBuffers[ x ].pucEthernetBuffer = &( ucBuffers[ x ][ ipBUFFER_PADDING ] );
+			*( ( NetworkBufferDescriptor_t ** ) &( ucBuffers[ x ][ 0 ] ) ) = &( pxNetworkBuffers[ x ] );
+		}
+	}
+
+#endif /* buffersSCHEME == 1 */
+/*-----------------------------------------------------------*/
+
+static void prvCount( unsigned long *pulHistogram, uint64_t ullCycles )
+{
+BaseType_t xIndex = 0;
+
+	while( ( xIndex < buffersHISTOGRAM_SIZE - 1 ) && ( ullCycles >= ( ( uint64_t ) 1u << xIndex ) ) )
+	{
+		xIndex++;
+	}
+
+	pulHistogram[ xIndex ]++;
+}
+/*-----------------------------------------------------------*/
+
+/* The power of 2 below which 99.9% of the calls lie. */
+static unsigned long prvPercentile( const unsigned long *pulHistogram, unsigned long ulCount )
+{
+BaseType_t xIndex;
+unsigned long ulSum = 0ul;
+
+	for( xIndex = 0; xIndex < buffersHISTOGRAM_SIZE - 1; xIndex++ )
+	{
+		ulSum += pulHistogram[ xIndex ];
+		if( ulSum >= ulCount - ( ulCount / 1000ul ) )
+		{
+			break;
+		}
+	}
+
+	return 1ul << xIndex;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPacketSize( void )
+{
+uint32_t ulChoice = prvRandom() % 10u;
+size_t uxSize;
+
+	if( ulChoice < 4u )
+	{
+		/* A TCP acknowledgement. */
+		uxSize = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+	}
+	else if( ulChoice < 6u )
+	{
+		/* A small UDP datagram, e.g. DNS or DHCP. */
+		uxSize = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER + 1u + ( prvRandom() % 548u );
+	}
+	else
+	{
+		uxSize = buffersFULL_FRAME;
+	}
+
+	return uxSize;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFill( UBaseType_t uxIndex )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxHeld[ uxIndex ];
+
+	ucHeldPattern[ uxIndex ] = ( uint8_t ) prvRandom();
+	memset( pxBuffer->pucEthernetBuffer, ucHeldPattern[ uxIndex ], pxBuffer->xDataLength );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCheck( UBaseType_t uxHeldIndex, size_t uxLength )
+{
+const NetworkBufferDescriptor_t *pxBuffer = pxHeld[ uxHeldIndex ];
+size_t uxIndex;
+BaseType_t xResult = pdPASS;
+
+	/* The stack finds the descriptor of a buffer in front of its data. */
+	if( *( ( NetworkBufferDescriptor_t ** ) ( pxBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) ) != pxBuffer )
+	{
+		xResult = pdFAIL;
+	}
+
+	for( uxIndex = 0u; uxIndex < uxLength; uxIndex++ )
+	{
+		if( pxBuffer->pucEthernetBuffer[ uxIndex ] != ucHeldPattern[ uxHeldIndex ] )
+		{
+			xResult = pdFAIL;
+			break;
+		}
+	}
+
+	return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGet( void )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxSize = prvPacketSize();
+size_t uxFreeHeap = xPortGetFreeHeapSize();
+uint64_t ullStart, ullCycles;
+
+	ullStart = ullHostRunTimeCounter();
+	pxBuffer = pxGetNetworkBufferWithDescriptor( uxSize, 0u );
+	ullCycles = ullHostRunTimeCounter() - ullStart;
+
+	ulGets++;
+	ullGetCycles += ullCycles;
+	prvCount( ulGetHistogram, ullCycles );
+
+	if( pxBuffer == NULL )
+	{
+		ulGetFailures++;
+		if( uxFreeHeap >= uxSize + ipBUFFER_PADDING + 64u )
+		{
+			ulGetFragmentFailures++;
+		}
+	}
+	else
+	{
+		/* BufferAllocation_2.c rounds the size up. */
+		buffersCHECK( pxBuffer->xDataLength >= uxSize );
+		pxHeld[ uxHeldCount ] = pxBuffer;
+		prvFill( uxHeldCount );
+		uxHeldCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRelease( UBaseType_t uxIndex )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxHeld[ uxIndex ];
+uint64_t ullStart, ullCycles;
+
+	buffersCHECK( prvCheck( uxIndex, pxBuffer->xDataLength ) == pdPASS );
+
+	ullStart = ullHostRunTimeCounter();
+	vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	ullCycles = ullHostRunTimeCounter() - ullStart;
+
+	ulReleases++;
+	ullReleaseCycles += ullCycles;
+	prvCount( ulReleaseHistogram, ullCycles );
+
+	uxHeldCount--;
+	pxHeld[ uxIndex ] = pxHeld[ uxHeldCount ];
+	ucHeldPattern[ uxIndex ] = ucHeldPattern[ uxHeldCount ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvResize( UBaseType_t uxIndex )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxHeld[ uxIndex ];
+size_t uxOldLength = pxBuffer->xDataLength;
+
+	/* The buffer may be moved, but its contents must be kept, as far as they
+	fit in the new size. */
+	pxBuffer = pxResizeNetworkBufferWithDescriptor( pxBuffer, buffersFULL_FRAME );
+	ulResizes++;
+
+	if( pxBuffer == NULL )
+	{
+		/* The original buffer was released. */
+		ulGetFailures++;
+		uxHeldCount--;
+		pxHeld[ uxIndex ] = pxHeld[ uxHeldCount ];
+		ucHeldPattern[ uxIndex ] = ucHeldPattern[ uxHeldCount ];
+	}
+	else
+	{
+		pxHeld[ uxIndex ] = pxBuffer;
+		buffersCHECK( prvCheck( uxIndex, ( uxOldLength < buffersFULL_FRAME ) ? uxOldLength : buffersFULL_FRAME ) == pdPASS );
+		/* BufferAllocation_1.c does not change the length. */
+		pxBuffer->xDataLength = buffersFULL_FRAME;
+		prvFill( uxIndex );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamStep( void )
+{
+UBaseType_t uxIndex;
+size_t uxSize;
+
+	if( ( uxStreamCount > 0u ) && ( ( uxStreamCount == buffersMAX_STREAMS ) || ( ( prvRandom() % 2u ) == 0u ) ) )
+	{
+		uxIndex = ( UBaseType_t ) ( prvRandom() % uxStreamCount );
+		uxStreamBytes -= xStreams[ uxIndex ].uxSize;
+		vPortFree( xStreams[ uxIndex ].pucBuffer );
+		xStreams[ uxIndex ] = xStreams[ --uxStreamCount ];
+	}
+	else
+	{
+		/* A stream of 1 to 8 segments, plus the size of the header of a
+		StreamBuffer_t. */
+		uxSize = ( ( size_t ) 1u + ( prvRandom() % 8u ) ) * ipconfigTCP_MSS + 32u;
+
+		if( uxStreamBytes + uxSize <= buffersMAX_STREAM_BYTES )
+		{
+		size_t uxFreeHeap = xPortGetFreeHeapSize();
+		uint8_t *pucBuffer = ( uint8_t * ) pvPortMalloc( uxSize );
+
+			ulStreams++;
+
+			if( pucBuffer == NULL )
+			{
+				ulStreamFailures++;
+				if( uxFreeHeap >= uxSize + 64u )
+				{
+					ulStreamFragmentFailures++;
+				}
+			}
+			else
+			{
+				xStreams[ uxStreamCount ].pucBuffer = pucBuffer;
+				xStreams[ uxStreamCount ].uxSize = uxSize;
+				uxStreamCount++;
+				uxStreamBytes += uxSize;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSample( void )
+{
+size_t uxFree = xPortGetFreeHeapSize();
+size_t uxLargest = xHeapGetLargestFreeBlock();
+unsigned uFragmentation;
+
+	if( uxFree != 0u )
+	{
+		uFragmentation = ( unsigned ) ( ( 100u * ( uxFree - uxLargest ) ) / uxFree );
+		if( uMaxFragmentation < uFragmentation )
+		{
+			uMaxFragmentation = uFragmentation;
+		}
+	}
+
+	if( uxMinLargestFreeBlock > uxLargest )
+	{
+		uxMinLargestFreeBlock = uxLargest;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvShowSlabs( void )
+{
+	#if( buffersSCHEME == 3 )
+	{
+	NetworkBufferSlabStats_t xStats;
+	UBaseType_t uxIndex;
+
+		for( uxIndex = 0u; xGetNetworkBufferSlabStats( uxIndex, &xStats ) == pdPASS; uxIndex++ )
+		{
+			printf( "slab %4lu:   %lu blocks, high-water mark %lu, exhausted %lu times\n",
+				( unsigned long ) xStats.uxBlockSize, ( unsigned long ) xStats.uxBlockCount,
+				( unsigned long ) xStats.uxMaxInUse, ( unsigned long ) xStats.uxExhausted );
+			buffersCHECK( xStats.uxInUse == 0u );
+		}
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+unsigned long ulStep;
+size_t uxInitialFreeHeap;
+UBaseType_t uxIndex;
+
+	buffersCHECK( xNetworkBuffersInitialise() == pdPASS );
+	uxInitialFreeHeap = xPortGetFreeHeapSize();
+
+	for( ulStep = 0ul; ulStep < buffersSTEPS; ulStep++ )
+	{
+		if( ( ulStep % buffersSTREAM_PERIOD ) == 0u )
+		{
+			prvStreamStep();
+		}
+
+		if( ( uxHeldCount > 0u ) && ( ( uxHeldCount == buffersMAX_HELD ) || ( ( prvRandom() % 2u ) == 0u ) ) )
+		{
+			uxIndex = ( UBaseType_t ) ( prvRandom() % uxHeldCount );
+
+			if( ( prvRandom() % 16u ) == 0u )
+			{
+				prvResize( uxIndex );
+			}
+			else
+			{
+				prvRelease( uxIndex );
+			}
+		}
+		else
+		{
+			prvGet();
+		}
+
+		if( ( ulStep % buffersSAMPLE_PERIOD ) == 0u )
+		{
+			prvSample();
+		}
+	}
+
+	prvSample();
+	printf( "heap:        %lu bytes free at the end, largest free block at least %lu, fragmentation up to %u%%\n",
+		( unsigned long ) xPortGetFreeHeapSize(), ( unsigned long ) uxMinLargestFreeBlock, uMaxFragmentation );
+
+	while( uxHeldCount > 0u )
+	{
+		prvRelease( uxHeldCount - 1u );
+	}
+
+	while( uxStreamCount > 0u )
+	{
+		vPortFree( xStreams[ --uxStreamCount ].pucBuffer );
+	}
+
+	printf( "scheme %d:    %lu steps, get %lu cycles (99.9%% < %lu), release %lu cycles (99.9%% < %lu)\n", buffersSCHEME, ( unsigned long ) buffersSTEPS,
+		( unsigned long ) ( ullGetCycles / ulGets ), prvPercentile( ulGetHistogram, ulGets ),
+		( unsigned long ) ( ullReleaseCycles / ulReleases ), prvPercentile( ulReleaseHistogram, ulReleases ) );
+	printf( "packets:     %lu gets, %lu resizes, %lu failed, %lu of them with enough free heap\n",
+		ulGets, ulResizes, ulGetFailures, ulGetFragmentFailures );
+	printf( "streams:     %lu created, %lu failed, %lu of them with enough free heap\n",
+		ulStreams, ulStreamFailures, ulStreamFragmentFailures );
+	prvShowSlabs();
+
+	/* Everything is returned. */
+	buffersCHECK( uxGetNumberOfFreeNetworkBuffers() == ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS );
+	buffersCHECK( xPortGetFreeHeapSize() == uxInitialFreeHeap );
+
+	#if( buffersSCHEME != 2 )
+	{
+		/* The packets do not use the heap, and they always find a buffer. */
+		buffersCHECK( ulGetFailures == 0ul );
+	}
+	#endif
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
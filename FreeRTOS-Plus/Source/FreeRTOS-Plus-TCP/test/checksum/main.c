@@ -0,0 +1,424 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks usGenerateChecksum() and usGenerateChecksumCopy() against the
+ * implementation of usGenerateChecksum() that they replaced, for every length
+ * up to 1600 bytes, at every alignment of the source and the destination, and
+ * with several initial sums.  At even addresses, the result must also equal a
+ * plain RFC 1071 sum of 16-bit words.  usGenerateChecksumCopy() must copy the
+ * data exactly, without touching the bytes around the destination.
+ *
+ * Then it measures the speed over a payload of ipconfigTCP_MSS bytes, in bytes
+ * per cycle of the time stamp counter on x86, or in bytes per ns on other
+ * hosts:
+ *
+ *   previous   the replaced implementation
+ *   checksum   usGenerateChecksum()
+ *   memcpy+sum memcpy() followed by usGenerateChecksum()
+ *   copy+sum   usGenerateChecksumCopy()
+ *
+ * The stack is not started, the functions are called from main().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#define checksumCOST_UNIT		"cycle"
+#else
+	#define checksumCOST_UNIT		"ns"
+#endif
+
+#define checksumMAX_LENGTH		( 1600u )
+#define checksumMAX_OFFSET		( 8u )
+#define checksumGUARD			( 16u )
+#define checksumGUARD_BYTE		( 0xa5u )
+
+/* The number of times the payload is summed per measurement. */
+#define checksumREPEAT			( 100000u )
+
+/* Used by prvPreviousChecksum(). */
+typedef union _xUnion32
+{
+	uint32_t u32;
+	uint16_t u16[ 2 ];
+	uint8_t u8[ 4 ];
+} xUnion32;
+
+typedef union _xUnionPtr
+{
+	uint32_t *u32ptr;
+	uint16_t *u16ptr;
+	uint8_t *u8ptr;
+} xUnionPtr;
+
+static uint8_t ucSource[ checksumMAX_LENGTH + checksumMAX_OFFSET ] __attribute__( ( aligned( 16 ) ) );
+static uint8_t ucDestination[ checksumGUARD + checksumMAX_LENGTH + checksumMAX_OFFSET + checksumGUARD ] __attribute__( ( aligned( 16 ) ) );
+
+static uint32_t ulRandomState = 0x2545f491ul;
+
+static int iFailures = 0;
+
+/* Keeps the compiler from dropping the sums that are measured. */
+volatile uint16_t usChecksumSink;
+
+/*-----------------------------------------------------------*/
+
+#define checksumCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvPreviousChecksum( uint32_t ulSum, const uint8_t * pucNextData, size_t uxDataLengthBytes )
+{
+xUnion32 xSum2, xSum, xTerm;
+xUnionPtr xSource;		/* Points to first byte */
+xUnionPtr xLastSource;	/* Points to last byte plus one */
+uint32_t ulAlignBits, ulCarry = 0ul;
+
+	/* The implementation of usGenerateChecksum() before the 64-bit
+	accumulator was introduced, unchanged.  Note that at an odd address, the
+	bytes of the initial sum are swapped as well. */
+
+	/* Swap the input (little endian platform only). */
+	xSum.u32 = FreeRTOS_ntohs( ulSum );
+	xTerm.u32 = 0ul;
+
+	xSource.u8ptr = ( uint8_t * ) pucNextData;
+	ulAlignBits = ( ( ( uint32_t ) pucNextData ) & 0x03u ); /* gives 0, 1, 2, or 3 */
+
+	/* If byte (8-bit) aligned... */
+	if( ( ( ulAlignBits & 1ul ) != 0ul ) && ( uxDataLengthBytes >= ( size_t ) 1 ) )
+	{
+		xTerm.u8[ 1 ] = *( xSource.u8ptr );
+		( xSource.u8ptr )++;
+		uxDataLengthBytes--;
+		/* Now xSource is word (16-bit) aligned. */
+	}
+
+	/* If half-word (16-bit) aligned... */
+	if( ( ( ulAlignBits == 1u ) || ( ulAlignBits == 2u ) ) && ( uxDataLengthBytes >= 2u ) )
+	{
+		xSum.u32 += *(xSource.u16ptr);
+		( xSource.u16ptr )++;
+		uxDataLengthBytes -= 2u;
+		/* Now xSource is word (32-bit) aligned. */
+	}
+
+	/* Word (32-bit) aligned, do the most part. */
+	xLastSource.u32ptr = ( xSource.u32ptr + ( uxDataLengthBytes / 4u ) ) - 3u;
+
+	/* In this loop, four 32-bit additions will be done, in total 16 bytes.
+	Indexing with constants (0,1,2,3) gives faster code than using
+	post-increments. */
+	while( xSource.u32ptr < xLastSource.u32ptr )
+	{
+		/* Use a secondary Sum2, just to see if the addition produced an
+		overflow. */
+		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 0 ];
+		if( xSum2.u32 < xSum.u32 )
+		{
+			ulCarry++;
+		}
+
+		/* Now add the secondary sum to the major sum, and remember if there was
+		a carry. */
+		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 1 ];
+		if( xSum2.u32 > xSum.u32 )
+		{
+			ulCarry++;
+		}
+
+		/* And do the same trick once again for indexes 2 and 3 */
+		xSum2.u32 = xSum.u32 + xSource.u32ptr[ 2 ];
+		if( xSum2.u32 < xSum.u32 )
+		{
+			ulCarry++;
+		}
+
+		xSum.u32 = xSum2.u32 + xSource.u32ptr[ 3 ];
+
+		if( xSum2.u32 > xSum.u32 )
+		{
+			ulCarry++;
+		}
+
+		/* And finally advance the pointer 4 * 4 = 16 bytes. */
+		xSource.u32ptr += 4;
+	}
+
+	/* Now add all carries. */
+	xSum.u32 = ( uint32_t )xSum.u16[ 0 ] + xSum.u16[ 1 ] + ulCarry;
+
+	uxDataLengthBytes %= 16u;
+	xLastSource.u8ptr = ( uint8_t * ) ( xSource.u8ptr + ( uxDataLengthBytes & ~( ( size_t ) 1 ) ) );
+
+	/* Half-word aligned. */
+	while( xSource.u16ptr < xLastSource.u16ptr )
+	{
+		/* At least one more short. */
+		xSum.u32 += xSource.u16ptr[ 0 ];
+		xSource.u16ptr++;
+	}
+
+	if( ( uxDataLengthBytes & ( size_t ) 1 ) != 0u )	/* Maybe one more ? */
+	{
+		xTerm.u8[ 0 ] = xSource.u8ptr[ 0 ];
+	}
+	xSum.u32 += xTerm.u32;
+
+	/* Now add all carries again. */
+	xSum.u32 = ( uint32_t ) xSum.u16[ 0 ] + xSum.u16[ 1 ];
+
+	/* The previous summation might have given a 16-bit carry. */
+	xSum.u32 = ( uint32_t ) xSum.u16[ 0 ] + xSum.u16[ 1 ];
+
+	if( ( ulAlignBits & 1u ) != 0u )
+	{
+		/* Quite unlikely, but pucNextData might be non-aligned, which would
+		 mean that a checksum is calculated starting at an odd position. */
+		xSum.u32 = ( ( xSum.u32 & 0xffu ) << 8 ) | ( ( xSum.u32 & 0xff00u ) >> 8 );
+	}
+
+	/* swap the output (little endian platform only). */
+	return FreeRTOS_htons( ( (uint16_t) xSum.u32 ) );
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvReferenceChecksum( uint32_t ulSum, const uint8_t *pucData, size_t uxLength )
+{
+uint32_t ulTotal;
+size_t uxIndex;
+
+	/* The data is summed as big-endian words from its first byte on.  The
+	initial sum and the result are plain 16-bit numbers. */
+	ulTotal = ulSum & 0xffffu;
+
+	for( uxIndex = 0u; uxIndex + 1u < uxLength; uxIndex += 2u )
+	{
+		ulTotal += ( ( uint32_t ) pucData[ uxIndex ] << 8 ) | pucData[ uxIndex + 1u ];
+	}
+
+	if( uxIndex < uxLength )
+	{
+		ulTotal += ( uint32_t ) pucData[ uxIndex ] << 8;
+	}
+
+	while( ( ulTotal >> 16 ) != 0u )
+	{
+		ulTotal = ( ulTotal & 0xffffu ) + ( ulTotal >> 16 );
+	}
+
+	return ( uint16_t ) ulTotal;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestKnownHeader( void )
+{
+/* An IPv4 header with a correct checksum, summing it gives 0xffff. */
+static const uint8_t ucHeader[ ipSIZE_OF_IPv4_HEADER ] =
+{
+	0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+	0xb8, 0x61, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+};
+
+	checksumCHECK( prvPreviousChecksum( 0u, ucHeader, sizeof( ucHeader ) ) == 0xffffu );
+	checksumCHECK( usGenerateChecksum( 0u, ucHeader, sizeof( ucHeader ) ) == 0xffffu );
+	checksumCHECK( prvReferenceChecksum( 0u, ucHeader, sizeof( ucHeader ) ) == 0xffffu );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestAllLengths( void )
+{
+static const uint32_t ulInitialSums[] = { 0u, 0xffffu, 0x0100u, 0x1234u };
+size_t uxLength, uxOffset, uxSum, uxIndex;
+uint8_t *pucSource, *pucDestination;
+uint16_t usExpected, usResult;
+uint32_t ulSum;
+int iChecks = 0;
+
+	for( uxIndex = 0u; uxIndex < sizeof( ucSource ); uxIndex++ )
+	{
+		ucSource[ uxIndex ] = ( uint8_t ) prvRandom();
+	}
+
+	/* A block of 0xff bytes, which gives the most carries. */
+	memset( &( ucSource[ checksumMAX_LENGTH / 2u ] ), 0xff, 256u );
+
+	for( uxLength = 0u; uxLength <= checksumMAX_LENGTH; uxLength++ )
+	{
+		for( uxOffset = 0u; uxOffset < checksumMAX_OFFSET; uxOffset++ )
+		{
+			for( uxSum = 0u; uxSum <= sizeof( ulInitialSums ) / sizeof( ulInitialSums[ 0 ] ); uxSum++ )
+			{
+				if( uxSum < sizeof( ulInitialSums ) / sizeof( ulInitialSums[ 0 ] ) )
+				{
+					ulSum = ulInitialSums[ uxSum ];
+				}
+				else
+				{
+					ulSum = prvRandom() & 0xffffu;
+				}
+
+				pucSource = &( ucSource[ uxOffset ] );
+				usExpected = prvPreviousChecksum( ulSum, pucSource, uxLength );
+				checksumCHECK( usGenerateChecksum( ulSum, pucSource, uxLength ) == usExpected );
+
+				if( ( uxOffset & 1u ) == 0u )
+				{
+					checksumCHECK( prvReferenceChecksum( ulSum, pucSource, uxLength ) == usExpected );
+				}
+
+				/* The destination has another alignment than the source, the
+				result is that of the destination. */
+				memset( ucDestination, checksumGUARD_BYTE, sizeof( ucDestination ) );
+				pucDestination = &( ucDestination[ checksumGUARD + ( ( uxOffset + 3u ) % checksumMAX_OFFSET ) ] );
+				usResult = usGenerateChecksumCopy( ulSum, pucDestination, pucSource, uxLength );
+				checksumCHECK( memcmp( pucDestination, pucSource, uxLength ) == 0 );
+				checksumCHECK( usResult == prvPreviousChecksum( ulSum, pucDestination, uxLength ) );
+
+				for( uxIndex = 0u; uxIndex < checksumGUARD; uxIndex++ )
+				{
+					checksumCHECK( pucDestination[ uxLength + uxIndex ] == checksumGUARD_BYTE );
+					checksumCHECK( ucDestination[ uxIndex ] == checksumGUARD_BYTE );
+				}
+
+				iChecks++;
+
+				if( iFailures > 10 )
+				{
+					printf( "checks:     stopped at length %lu offset %lu sum %04lx\n",
+						( unsigned long ) uxLength, ( unsigned long ) uxOffset, ( unsigned long ) ulSum );
+					return;
+				}
+			}
+		}
+	}
+
+	printf( "checks:     %d sums of 0 to %u bytes\n", iChecks, checksumMAX_LENGTH );
+}
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+	ePrevious,
+	eChecksum,
+	eMemcpyChecksum,
+	eChecksumCopy,
+	eModeCount
+} BenchmarkMode_t;
+
+static const char * const pcModeNames[ eModeCount ] = { "previous", "checksum", "memcpy+sum", "copy+sum" };
+
+static void prvBenchmark( BenchmarkMode_t eMode )
+{
+const size_t uxLength = ipconfigTCP_MSS;
+uint64_t ullStart, ullCost, ullBest = 0u;
+uint32_t ulCount;
+int iRun;
+
+	/* The best of 15 runs, the host may be busy. */
+	for( iRun = 0; iRun < 15; iRun++ )
+	{
+		ullStart = ullHostRunTimeCounter();
+
+		for( ulCount = 0u; ulCount < checksumREPEAT; ulCount++ )
+		{
+			switch( eMode )
+			{
+				case ePrevious:
+					usChecksumSink = prvPreviousChecksum( ulCount, ucSource, uxLength );
+					break;
+
+				case eChecksum:
+					usChecksumSink = usGenerateChecksum( ulCount, ucSource, uxLength );
+					break;
+
+				case eMemcpyChecksum:
+					memcpy( &( ucDestination[ checksumGUARD ] ), ucSource, uxLength );
+					usChecksumSink = usGenerateChecksum( ulCount, &( ucDestination[ checksumGUARD ] ), uxLength );
+					break;
+
+				default:
+					usChecksumSink = usGenerateChecksumCopy( ulCount, &( ucDestination[ checksumGUARD ] ), ucSource, uxLength );
+					break;
+			}
+		}
+
+		ullCost = ullHostRunTimeCounter() - ullStart;
+
+		if( ( iRun == 0 ) || ( ullCost < ullBest ) )
+		{
+			ullBest = ullCost;
+		}
+	}
+
+	printf( "%-11s %.3f bytes per " checksumCOST_UNIT "\n", pcModeNames[ eMode ],
+		( double ) uxLength * checksumREPEAT / ( double ) ( ullBest != 0u ? ullBest : 1u ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+BenchmarkMode_t eMode;
+
+	prvTestKnownHeader();
+	prvTestAllLengths();
+
+	for( eMode = ePrevious; eMode < eModeCount; eMode++ )
+	{
+		prvBenchmark( eMode );
+	}
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,68 @@
+# Shared rules of the host test and benchmark programs, see ReadMe.txt.
+#
+# The Makefile of a program sets:
+#   PROGRAM     the name of the program
+#   SOURCES     its own source files
+#   VARIANTS    the builds of the program, 'default' when not set
+#   CFLAGS_<v>  the extra flags of variant <v>, e.g. to enable an ipconfig option
+#   IP_SOURCES  the FreeRTOS+TCP sources that are needed, all of them when not set
+#   RUN_ARGS    the command line arguments of the program
+# and then includes this file.  'make' builds all variants, 'make run' builds
+# and runs them.  Set SANITIZE=1 to build with the address and undefined
+# behaviour sanitizers.
+
+TCP_DIR := $(abspath $(dir $(lastword $(MAKEFILE_LIST)))/..)
+HOST_DIR := $(TCP_DIR)/test/host
+BUILD_DIR := build
+
+CC ?= gcc
+OPTIMISATION ?= -O2
+# The stack is written for 32-bit targets, some of its alignment checks cast a
+# pointer to a uint32_t.
+CFLAGS += -std=gnu99 $(OPTIMISATION) -g -Wall -Wextra -Wno-unused-parameter -Wno-address-of-packed-member -Wno-type-limits -Wno-pointer-to-int-cast
+CPPFLAGS += -I. -I$(HOST_DIR) -I$(TCP_DIR)/include -I$(TCP_DIR)/portable/Compiler/GCC -I$(TCP_DIR)/portable/NetworkInterface/include
+LDLIBS += -lpthread
+
+ifeq ($(SANITIZE),1)
+	CFLAGS += -fsanitize=address,undefined -fno-omit-frame-pointer
+	LDFLAGS += -fsanitize=address,undefined
+endif
+
+IP_SOURCES ?= \
+	$(TCP_DIR)/FreeRTOS_ARP.c \
+	$(TCP_DIR)/FreeRTOS_DHCP.c \
+	$(TCP_DIR)/FreeRTOS_DNS.c \
+	$(TCP_DIR)/FreeRTOS_IP.c \
+	$(TCP_DIR)/FreeRTOS_Sockets.c \
+	$(TCP_DIR)/FreeRTOS_Stream_Buffer.c \
+	$(TCP_DIR)/FreeRTOS_TCP_IP.c \
+	$(TCP_DIR)/FreeRTOS_TCP_WIN.c \
+	$(TCP_DIR)/FreeRTOS_UDP_IP.c \
+	$(TCP_DIR)/portable/BufferManagement/BufferAllocation_2.c
+
+HOST_SOURCES := \
+	$(HOST_DIR)/host_kernel.c \
+	$(HOST_DIR)/list.c \
+	$(HOST_DIR)/host_hooks.c
+
+VARIANTS ?= default
+BINARIES := $(addprefix $(BUILD_DIR)/$(PROGRAM)_,$(VARIANTS))
+
+.PHONY: all run clean
+
+all: $(BINARIES)
+
+# Every variant is compiled from scratch, because the ipconfig options change
+# the layout of the structs in all files.
+$(BUILD_DIR)/$(PROGRAM)_%: $(SOURCES) $(IP_SOURCES) $(HOST_SOURCES) $(wildcard $(HOST_DIR)/*.h $(TCP_DIR)/include/*.h) Makefile
+	@mkdir -p $(BUILD_DIR)
+	$(CC) $(CPPFLAGS) $(CFLAGS) $(CFLAGS_$*) $(LDFLAGS) -o $@ $(SOURCES) $(IP_SOURCES) $(HOST_SOURCES) $(LDLIBS)
+
+run: $(BINARIES)
+	@set -e; for binary in $(BINARIES); do \
+		echo "=== $$binary"; \
+		./$$binary $(RUN_ARGS); \
+	done
+
+clean:
+	rm -rf $(BUILD_DIR)
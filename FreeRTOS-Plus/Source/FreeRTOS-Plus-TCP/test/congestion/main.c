@@ -0,0 +1,264 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the goodput of a bulk TCP transfer over a simulated link with a
+ * bottleneck, see ipconfigUSE_TCP_CONGESTION_CONTROL.
+ *
+ * A client and a sink server run in this process and talk over the loopback
+ * network interface, which is included in this file.  The link has a limited
+ * bandwidth and a delay, and holds at most niLOOPBACK_QUEUE_LENGTH frames:
+ * frames that are sent while it is full are dropped, like in the queue of a
+ * router.  The windows of both sockets are larger than the link can hold, so
+ * without congestion control the sender overflows the queue.  Some variants
+ * also lose frames at random.
+ *
+ * The program prints the goodput, the frames that were dropped by the link,
+ * and, with congestion control, the statistics of the congestion window.  All
+ * data must arrive intact.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../portable/NetworkInterface/loopback/NetworkInterface.c"
+
+#include "FreeRTOS_Sockets.h"
+
+#define congestionPORT				( 5020u )
+
+#ifndef congestionTOTAL_BYTES
+	#define congestionTOTAL_BYTES	( 2u * 1024u * 1024u )
+#endif
+
+/* The windows, in segments, and the buffers of both sockets. */
+#define congestionWINDOW_SEGMENTS	( 40 )
+#define congestionBUFFER_BYTES		( congestionWINDOW_SEGMENTS * ipconfigTCP_MSS )
+
+/* The contents of the stream: byte 'n' has the value n % congestionPATTERN_PERIOD. */
+#define congestionPATTERN_PERIOD	( 251u )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static uint8_t ucPattern[ ipconfigTCP_MSS + congestionPATTERN_PERIOD ];
+
+/* Corrupted bytes seen by the sink. */
+static size_t uxSinkErrors = 0u;
+static size_t uxSinkBytes = 0u;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define congestionCHECK( x )											\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static void prvSetWindow( Socket_t xSocket )
+{
+WinProperties_t xWinProperties;
+
+	xWinProperties.lTxBufSize = congestionBUFFER_BYTES;
+	xWinProperties.lTxWinSize = congestionWINDOW_SEGMENTS;
+	xWinProperties.lRxBufSize = congestionBUFFER_BYTES;
+	xWinProperties.lRxWinSize = congestionWINDOW_SEGMENTS;
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProperties, sizeof( xWinProperties ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSinkTask( void *pvParameters )
+{
+Socket_t xListener, xClient;
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+static uint8_t ucBuffer[ 8192 ];
+size_t uxReceived, uxIndex;
+BaseType_t xCount;
+
+	( void ) pvParameters;
+
+	xListener = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListener != FREERTOS_INVALID_SOCKET );
+	/* A child socket inherits the window properties of its parent. */
+	prvSetWindow( xListener );
+	xAddress.sin_port = FreeRTOS_htons( congestionPORT );
+	FreeRTOS_bind( xListener, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListener, 2 );
+
+	for( ;; )
+	{
+		xClient = FreeRTOS_accept( xListener, &xAddress, &xSize );
+		if( ( xClient == NULL ) || ( xClient == FREERTOS_INVALID_SOCKET ) )
+		{
+			continue;
+		}
+
+		uxReceived = 0u;
+		for( ;; )
+		{
+			xCount = FreeRTOS_recv( xClient, ucBuffer, sizeof( ucBuffer ), 0 );
+			if( xCount < 0 )
+			{
+				break;
+			}
+
+			for( uxIndex = 0u; uxIndex < ( size_t ) xCount; uxIndex++ )
+			{
+				if( ucBuffer[ uxIndex ] != ( uint8_t ) ( ( uxReceived + uxIndex ) % congestionPATTERN_PERIOD ) )
+				{
+					uxSinkErrors++;
+				}
+			}
+			uxReceived += ( size_t ) xCount;
+		}
+
+		uxSinkBytes = uxReceived;
+		FreeRTOS_closesocket( xClient );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void *pvParameters )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+TickType_t xTimeOut = pdMS_TO_TICKS( 60000u );
+TickType_t xStartTime, xTime;
+size_t uxSent = 0u, uxLength;
+BaseType_t xResult;
+uint8_t ucByte;
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	TCPCongestionStats_t xStats;
+#endif
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	prvSetWindow( xSocket );
+
+	xAddress.sin_addr = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
+	xAddress.sin_port = FreeRTOS_htons( congestionPORT );
+	congestionCHECK( FreeRTOS_connect( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	xStartTime = xTaskGetTickCount();
+
+	while( uxSent < congestionTOTAL_BYTES )
+	{
+		uxLength = congestionTOTAL_BYTES - uxSent;
+		if( uxLength > ipconfigTCP_MSS )
+		{
+			uxLength = ipconfigTCP_MSS;
+		}
+
+		xResult = FreeRTOS_send( xSocket, &( ucPattern[ uxSent % congestionPATTERN_PERIOD ] ), uxLength, 0 );
+		if( xResult <= 0 )
+		{
+			break;
+		}
+		uxSent += ( size_t ) xResult;
+	}
+
+	/* The transfer is complete when the peer has received all data and has
+	closed the connection. */
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+	while( FreeRTOS_recv( xSocket, &ucByte, 1, 0 ) >= 0 )
+	{
+	}
+
+	xTime = xTaskGetTickCount() - xStartTime;
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		congestionCHECK( FreeRTOS_GetTCPCongestionStats( xSocket, &xStats ) == 0 );
+	}
+	#endif
+
+	FreeRTOS_closesocket( xSocket );
+
+	/* Let the sink close its socket. */
+	vTaskDelay( pdMS_TO_TICKS( 100u ) );
+
+	printf( "%lu bytes in %lu ms, %lu kbit/s, %lu of %lu frames dropped by the link (%lu when it was full)\n",
+		( unsigned long ) uxSinkBytes, ( unsigned long ) xTime,
+		( xTime != 0u ) ? ( unsigned long ) ( ( ( uint64_t ) uxSinkBytes * 8u ) / xTime ) : 0ul,
+		( unsigned long ) ( ulLoopbackLost + ulLoopbackQueueFull ),
+		( unsigned long ) ( ulLoopbackSent + ulLoopbackLost + ulLoopbackQueueFull ),
+		( unsigned long ) ulLoopbackQueueFull );
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		printf( "cwnd peak %lu bytes, %lu fast recoveries, %lu time-outs\n",
+			( unsigned long ) xStats.ulMaxCongestionWindow,
+			( unsigned long ) xStats.ulFastRecoveryCount,
+			( unsigned long ) xStats.ulTimeoutCount );
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+	congestionCHECK( uxSent == congestionTOTAL_BYTES );
+	congestionCHECK( uxSinkBytes == congestionTOTAL_BYTES );
+	congestionCHECK( uxSinkErrors == 0u );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0u; uxIndex < sizeof( ucPattern ); uxIndex++ )
+	{
+		ucPattern[ uxIndex ] = ( uint8_t ) ( uxIndex % congestionPATTERN_PERIOD );
+	}
+
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvSinkTask, "Sink", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	xTaskCreate( prvClientTask, "Client", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,447 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks the DNS cache.  FreeRTOS_DNS.c is included in this file, the rest of
+ * the IP-stack is replaced by a few stubs.  The clock is moved with
+ * vTaskStepTick(), the scheduler is not started.
+ *
+ * - Names are found regardless of the case of their characters.
+ * - The expiry heap keeps its order after updates and removals, and the
+ *   entries expire in the order of their TTL.
+ * - When the cache is full, the entry that would expire first is evicted.
+ * - A name that does not exist is remembered for ipconfigDNS_CACHE_NEGATIVE_TTL
+ *   seconds.
+ * - FreeRTOS_dnsclear() empties the cache.
+ * - Entries expire on time when the tick count wraps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../FreeRTOS_DNS.c"
+
+#if( ipconfigUSE_DNS_CACHE == 0 ) || ( ipconfigDNS_CACHE_NEGATIVE_TTL == 0 )
+	#error This test needs ipconfigUSE_DNS_CACHE and ipconfigDNS_CACHE_NEGATIVE_TTL
+#endif
+
+NetworkAddressingParameters_t xNetworkAddressing;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define dnstestCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+/* The socket API is used by FreeRTOS_gethostbyname(), which is not called
+by this test. */
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol )
+{
+	iFailures++;
+
+	return FREERTOS_INVALID_SOCKET;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength )
+{
+	iFailures++;
+
+	return -pdFREERTOS_ERRNO_EINVAL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket, int32_t lLevel, int32_t lOptionName, const void *pvOptionValue, size_t uxOptionLength )
+{
+	iFailures++;
+
+	return -pdFREERTOS_ERRNO_EINVAL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+	iFailures++;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_sendto( Socket_t xSocket, const void *pvBuffer, size_t uxTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, socklen_t xDestinationAddressLength )
+{
+	iFailures++;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t uxBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+{
+	iFailures++;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void *FreeRTOS_GetUDPPayloadBuffer( size_t uxRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+	iFailures++;
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_ReleaseUDPPayloadBuffer( void *pvBuffer )
+{
+	iFailures++;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_GetAddressConfiguration( uint32_t *pulIPAddress, uint32_t *pulNetMask, uint32_t *pulGatewayAddress, uint32_t *pulDNSServerAddress )
+{
+	iFailures++;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t FreeRTOS_inet_addr( const char * pcIPAddress )
+{
+	/* FreeRTOS_gethostbyname() first checks for a dotted address. */
+	return 0u;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAddress( int iHost )
+{
+	return FreeRTOS_inet_addr_quick( 10, 0, 0, iHost );
+}
+/*-----------------------------------------------------------*/
+
+static void prvName( char *pcName, int iHost )
+{
+	sprintf( pcName, "host%d.example.com", iHost );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdd( const char *pcName, uint32_t ulAddress, uint32_t ulTTL )
+{
+	( void ) prvProcessDNSCache( pcName, &ulAddress, 1u, FreeRTOS_htonl( ulTTL ), pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStepSeconds( uint32_t ulSeconds )
+{
+	vTaskStepTick( ( TickType_t ) ( ulSeconds * configTICK_RATE_HZ ) );
+}
+/*-----------------------------------------------------------*/
+
+static DNSCacheStatistics_t prvStatistics( void )
+{
+DNSCacheStatistics_t xStatistics;
+
+	FreeRTOS_dnsGetCacheStatistics( &xStatistics );
+
+	return xStatistics;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckHeap( void )
+{
+UBaseType_t uxPosition;
+BaseType_t xEntry, xUsed = 0;
+
+	/* Every row in use is in the heap exactly once, and no row expires before
+	its parent. */
+	for( xEntry = 0; xEntry < ipconfigDNS_CACHE_ENTRIES; xEntry++ )
+	{
+		if( xDNSCache[ xEntry ].pcName[ 0 ] != '\0' )
+		{
+			xUsed++;
+			uxPosition = xDNSCache[ xEntry ].usHeapPosition;
+			dnstestCHECK( uxPosition < uxDNSHeapCount );
+			dnstestCHECK( usDNSExpiryHeap[ uxPosition ] == ( uint16_t ) xEntry );
+		}
+	}
+
+	dnstestCHECK( ( UBaseType_t ) xUsed == uxDNSHeapCount );
+
+	for( uxPosition = 1u; uxPosition < uxDNSHeapCount; uxPosition++ )
+	{
+		dnstestCHECK( !dnsHEAP_EXPIRES_BEFORE( uxPosition, ( uxPosition - 1u ) / 2u ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestCase( void )
+{
+uint32_t ulAddresses[ 2 ] = { prvAddress( 1 ), prvAddress( 2 ) };
+DNSCacheStatistics_t xBefore = prvStatistics(), xAfter;
+
+	FreeRTOS_dnsclear();
+	( void ) prvProcessDNSCache( "www.Example.COM", ulAddresses, 2u, FreeRTOS_htonl( 60u ), pdFALSE );
+
+	/* The addresses are returned in turn, whatever the case of the name. */
+	dnstestCHECK( FreeRTOS_dnslookup( "WWW.example.com" ) == prvAddress( 1 ) );
+	dnstestCHECK( FreeRTOS_dnslookup( "www.example.com" ) == prvAddress( 2 ) );
+	dnstestCHECK( FreeRTOS_dnslookup( "www.EXAMPLE.com" ) == prvAddress( 1 ) );
+	dnstestCHECK( FreeRTOS_dnslookup( "www.example.co" ) == 0u );
+	dnstestCHECK( FreeRTOS_dnslookup( "www.example.comm" ) == 0u );
+
+	xAfter = prvStatistics();
+	dnstestCHECK( xAfter.ulHits - xBefore.ulHits == 3u );
+	dnstestCHECK( xAfter.ulMisses - xBefore.ulMisses == 2u );
+	prvCheckHeap();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestHeapOrder( void )
+{
+/* TTL's that are added, and then changed, in seconds. */
+static const uint32_t ulFirstTTL[ ipconfigDNS_CACHE_ENTRIES ] = { 50, 20, 70, 10, 80, 30, 60, 40 };
+static const uint32_t ulSecondTTL[ ipconfigDNS_CACHE_ENTRIES ] = { 15, 90, 35, 55, 5, 75, 25, 65 };
+char pcName[ 32 ];
+int iHost, iAlive, iPrevious;
+uint32_t ulSeconds;
+
+	FreeRTOS_dnsclear();
+
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		prvAdd( pcName, prvAddress( iHost ), ulFirstTTL[ iHost ] );
+		prvCheckHeap();
+	}
+
+	/* Updates move the entries up and down in the heap. */
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		prvAdd( pcName, prvAddress( iHost + 100 ), ulSecondTTL[ iHost ] );
+		prvCheckHeap();
+	}
+
+	dnstestCHECK( uxDNSHeapCount == ( UBaseType_t ) ipconfigDNS_CACHE_ENTRIES );
+
+	/* Every second, exactly the entries with a TTL that has not ended yet are
+	still there, with the address of the update.  Each expiry is a removal
+	from the middle or the top of the heap. */
+	iPrevious = ipconfigDNS_CACHE_ENTRIES;
+
+	for( ulSeconds = 1u; ulSeconds <= 100u; ulSeconds++ )
+	{
+		prvStepSeconds( 1u );
+		iAlive = 0;
+
+		for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+		{
+			prvName( pcName, iHost );
+
+			if( ulSecondTTL[ iHost ] > ulSeconds )
+			{
+				dnstestCHECK( FreeRTOS_dnslookup( pcName ) == prvAddress( iHost + 100 ) );
+				iAlive++;
+			}
+			else
+			{
+				dnstestCHECK( FreeRTOS_dnslookup( pcName ) == 0u );
+			}
+		}
+
+		prvCheckHeap();
+		dnstestCHECK( iAlive <= iPrevious );
+		iPrevious = iAlive;
+	}
+
+	dnstestCHECK( uxDNSHeapCount == 0u );
+	printf( "heap:     %d entries updated and expired in order\n", ipconfigDNS_CACHE_ENTRIES );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestEviction( void )
+{
+char pcName[ ipconfigDNS_CACHE_NAME_LENGTH + 1 ];
+int iHost;
+DNSCacheStatistics_t xBefore, xAfter;
+
+	FreeRTOS_dnsclear();
+
+	/* Host 3 has the shortest TTL. */
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		prvAdd( pcName, prvAddress( iHost ), ( iHost == 3 ) ? 100u : 200u + ( uint32_t ) iHost );
+	}
+
+	xBefore = prvStatistics();
+	prvName( pcName, ipconfigDNS_CACHE_ENTRIES );
+	prvAdd( pcName, prvAddress( ipconfigDNS_CACHE_ENTRIES ), 300u );
+	xAfter = prvStatistics();
+
+	dnstestCHECK( xAfter.ulEvictions - xBefore.ulEvictions == 1u );
+	dnstestCHECK( FreeRTOS_dnslookup( pcName ) == prvAddress( ipconfigDNS_CACHE_ENTRIES ) );
+
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		dnstestCHECK( FreeRTOS_dnslookup( pcName ) == ( ( iHost == 3 ) ? 0u : prvAddress( iHost ) ) );
+	}
+
+	/* A name that is too long is not stored, and does not evict anything. */
+	memset( pcName, 'x', ipconfigDNS_CACHE_NAME_LENGTH );
+	pcName[ ipconfigDNS_CACHE_NAME_LENGTH ] = '\0';
+	xBefore = prvStatistics();
+	prvAdd( pcName, prvAddress( 99 ), 300u );
+	xAfter = prvStatistics();
+	dnstestCHECK( xAfter.ulEvictions == xBefore.ulEvictions );
+	dnstestCHECK( FreeRTOS_dnslookup( pcName ) == 0u );
+
+	prvCheckHeap();
+	printf( "eviction: the entry with the shortest TTL was dropped\n" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestNegative( void )
+{
+uint32_t ulAddress = 0u;
+DNSCacheStatistics_t xBefore, xAfter;
+
+	FreeRTOS_dnsclear();
+
+	/* The way prvParseDNSReply() stores an NXDOMAIN answer. */
+	( void ) prvProcessDNSCache( "nx.example.com", NULL, 0u, FreeRTOS_htonl( ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL ), pdFALSE );
+
+	xBefore = prvStatistics();
+	dnstestCHECK( prvProcessDNSCache( "NX.example.com", &ulAddress, 0u, 0u, pdTRUE ) == pdTRUE );
+	dnstestCHECK( ulAddress == 0u );
+	xAfter = prvStatistics();
+	dnstestCHECK( xAfter.ulNegativeHits - xBefore.ulNegativeHits == 1u );
+	dnstestCHECK( xAfter.ulHits == xBefore.ulHits );
+
+	prvStepSeconds( ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL - 1u );
+	dnstestCHECK( prvProcessDNSCache( "nx.example.com", &ulAddress, 0u, 0u, pdTRUE ) == pdTRUE );
+
+	/* After the negative TTL, the name must be asked again. */
+	prvStepSeconds( 1u );
+	xBefore = prvStatistics();
+	dnstestCHECK( prvProcessDNSCache( "nx.example.com", &ulAddress, 0u, 0u, pdTRUE ) == pdFALSE );
+	xAfter = prvStatistics();
+	dnstestCHECK( xAfter.ulExpirations - xBefore.ulExpirations == 1u );
+	dnstestCHECK( xAfter.ulMisses - xBefore.ulMisses == 1u );
+
+	/* An answer replaces the negative entry. */
+	( void ) prvProcessDNSCache( "nx.example.com", NULL, 0u, FreeRTOS_htonl( ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL ), pdFALSE );
+	prvAdd( "nx.example.com", prvAddress( 7 ), 60u );
+	dnstestCHECK( FreeRTOS_dnslookup( "nx.example.com" ) == prvAddress( 7 ) );
+	prvCheckHeap();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestClear( void )
+{
+char pcName[ 32 ];
+int iHost;
+DNSCacheStatistics_t xBefore, xAfter;
+
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		prvAdd( pcName, prvAddress( iHost ), 100u );
+	}
+
+	FreeRTOS_dnsclear();
+	dnstestCHECK( uxDNSHeapCount == 0u );
+
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost );
+		dnstestCHECK( FreeRTOS_dnslookup( pcName ) == 0u );
+	}
+
+	/* All rows are free again. */
+	xBefore = prvStatistics();
+
+	for( iHost = 0; iHost < ipconfigDNS_CACHE_ENTRIES; iHost++ )
+	{
+		prvName( pcName, iHost + 50 );
+		prvAdd( pcName, prvAddress( iHost + 50 ), 100u );
+	}
+
+	xAfter = prvStatistics();
+	dnstestCHECK( xAfter.ulEvictions == xBefore.ulEvictions );
+	dnstestCHECK( uxDNSHeapCount == ( UBaseType_t ) ipconfigDNS_CACHE_ENTRIES );
+	prvCheckHeap();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTickWrap( void )
+{
+	/* Add an entry 5 seconds before the tick count wraps.  The entry must
+	expire after its TTL, not when the clock of the cache would wrap. */
+	FreeRTOS_dnsclear();
+	vTaskStepTick( ( TickType_t ) ( 0u - ( 5u * configTICK_RATE_HZ ) ) - xTaskGetTickCount() );
+	prvAdd( "wrap.example.com", prvAddress( 9 ), 60u );
+
+	prvStepSeconds( 30u );
+	dnstestCHECK( xTaskGetTickCount() < ( TickType_t ) ( 30u * configTICK_RATE_HZ ) );
+	dnstestCHECK( FreeRTOS_dnslookup( "wrap.example.com" ) == prvAddress( 9 ) );
+
+	prvStepSeconds( 30u );
+	dnstestCHECK( FreeRTOS_dnslookup( "wrap.example.com" ) == 0u );
+	dnstestCHECK( uxDNSHeapCount == 0u );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+DNSCacheStatistics_t xStatistics;
+
+	prvTestCase();
+	prvTestHeapOrder();
+	prvTestEviction();
+	prvTestNegative();
+	prvTestClear();
+	prvTestTickWrap();
+
+	xStatistics = prvStatistics();
+	printf( "counters: %lu hits, %lu negative, %lu misses, %lu insertions, %lu expirations, %lu evictions\n",
+		( unsigned long ) xStatistics.ulHits, ( unsigned long ) xStatistics.ulNegativeHits,
+		( unsigned long ) xStatistics.ulMisses, ( unsigned long ) xStatistics.ulInsertions,
+		( unsigned long ) xStatistics.ulExpirations, ( unsigned long ) xStatistics.ulEvictions );
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
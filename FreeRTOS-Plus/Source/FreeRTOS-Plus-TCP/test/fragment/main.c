@@ -0,0 +1,268 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks the fragmentation of outgoing UDP datagrams and the reassembly of
+ * incoming ones (ipconfigUSE_IP_FRAGMENTATION).  A single task sends UDP
+ * datagrams to a socket of its own, over the loopback network interface.
+ *
+ * Without loss, datagrams of 1 byte up to the largest payload are sent.  Every
+ * datagram must arrive once and intact, and the statistics must show one
+ * fragmented send and one reassembly for each datagram that does not fit in a
+ * single frame.  A payload that is one byte too large must be refused.
+ *
+ * With loss and reordering, 200 datagrams of 3 fragments are sent.  The
+ * datagrams that arrive must be intact.  The incomplete ones must be dropped,
+ * either because newer datagrams need their slot, or after
+ * ipconfigIP_REASSEMBLY_TIMEOUT_MS, and in the end the fragment cache must be
+ * empty.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#ifndef fragmentLOSSY
+	#define fragmentLOSSY				0
+#endif
+
+#define fragmentPORT					( 5050u )
+
+/* The largest UDP payload that can be sent in fragments. */
+#define fragmentMAX_PAYLOAD				( ipconfigIP_FRAGMENTATION_MAX_DATAGRAM_SIZE - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_UDP_HEADER )
+
+/* The largest UDP payload that fits in a single frame. */
+#define fragmentFRAME_PAYLOAD			( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_UDP_HEADER )
+
+/* The datagrams sent over the lossy link, each one needs 3 fragments. */
+#define fragmentLOSSY_COUNT				( 200u )
+#define fragmentLOSSY_PAYLOAD			( 2u * ipconfigNETWORK_MTU )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static uint8_t ucSendBuffer[ fragmentMAX_PAYLOAD + 1u ];
+static uint8_t ucReceiveBuffer[ fragmentMAX_PAYLOAD + 1u ];
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define fragmentCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static void prvFillPayload( size_t uxLength, uint32_t ulNumber )
+{
+size_t uxIndex;
+
+	/* The payload starts with the number of the datagram, the rest depends on
+	the number as well, so that fragments of different datagrams differ. */
+	memcpy( ucSendBuffer, &ulNumber, sizeof( ulNumber ) );
+
+	for( uxIndex = sizeof( ulNumber ); uxIndex < uxLength; uxIndex++ )
+	{
+		ucSendBuffer[ uxIndex ] = ( uint8_t ) ( ( uxIndex * 7u ) + ulNumber );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( Socket_t xSocket, size_t uxLength, uint32_t ulNumber )
+{
+struct freertos_sockaddr xAddress;
+
+	prvFillPayload( uxLength, ulNumber );
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	xAddress.sin_port = FreeRTOS_htons( fragmentPORT );
+
+	return ( FreeRTOS_sendto( xSocket, ucSendBuffer, uxLength, 0, &xAddress, sizeof( xAddress ) ) == ( int32_t ) uxLength ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the length of the datagram received, or 0 after a time-out. */
+static size_t prvReceive( Socket_t xSocket )
+{
+int32_t lReceived;
+
+	lReceived = FreeRTOS_recvfrom( xSocket, ucReceiveBuffer, sizeof( ucReceiveBuffer ), 0, NULL, NULL );
+
+	return ( lReceived > 0 ) ? ( size_t ) lReceived : 0u;
+}
+/*-----------------------------------------------------------*/
+
+#if( fragmentLOSSY == 0 )
+
+static void prvTestSizes( Socket_t xSocket )
+{
+static const size_t uxLengths[] =
+{
+	1u, 100u, fragmentFRAME_PAYLOAD, fragmentFRAME_PAYLOAD + 1u, 2000u,
+	2u * ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER, 4000u, fragmentMAX_PAYLOAD
+};
+IPFragmentStats_t xBefore, xAfter;
+uint32_t ulFragmented = 0u;
+size_t uxIndex, uxLength;
+
+	FreeRTOS_GetIPFragmentStats( &xBefore );
+
+	for( uxIndex = 0u; uxIndex < sizeof( uxLengths ) / sizeof( uxLengths[ 0 ] ); uxIndex++ )
+	{
+		uxLength = uxLengths[ uxIndex ];
+		fragmentCHECK( prvSend( xSocket, uxLength, ( uint32_t ) uxIndex ) == pdPASS );
+		fragmentCHECK( prvReceive( xSocket ) == uxLength );
+		fragmentCHECK( memcmp( ucReceiveBuffer, ucSendBuffer, uxLength ) == 0 );
+
+		if( uxLength > fragmentFRAME_PAYLOAD )
+		{
+			ulFragmented++;
+		}
+	}
+
+	/* One byte too many. */
+	prvFillPayload( fragmentMAX_PAYLOAD + 1u, 0u );
+	fragmentCHECK( prvSend( xSocket, fragmentMAX_PAYLOAD + 1u, 0u ) == pdFAIL );
+
+	FreeRTOS_GetIPFragmentStats( &xAfter );
+	fragmentCHECK( xAfter.ulDatagramsFragmented - xBefore.ulDatagramsFragmented == ulFragmented );
+	fragmentCHECK( xAfter.ulDatagramsReassembled - xBefore.ulDatagramsReassembled == ulFragmented );
+	fragmentCHECK( xAfter.ulFragmentsReceived - xBefore.ulFragmentsReceived == xAfter.ulFragmentsSent - xBefore.ulFragmentsSent );
+	fragmentCHECK( xAfter.ulFragmentsDropped == 0u );
+	fragmentCHECK( xAfter.uxBuffersInUse == 0u );
+
+	printf( "sizes:     %lu datagrams of 1 to %u bytes, %lu in %lu fragments, max. %lu buffers and %lu bytes in the cache\n",
+		( unsigned long ) ( sizeof( uxLengths ) / sizeof( uxLengths[ 0 ] ) ), ( unsigned ) fragmentMAX_PAYLOAD,
+		( unsigned long ) ulFragmented, ( unsigned long ) ( xAfter.ulFragmentsSent - xBefore.ulFragmentsSent ),
+		( unsigned long ) xAfter.uxBuffersInUseMax, ( unsigned long ) xAfter.uxBytesInUseMax );
+}
+
+#else /* fragmentLOSSY */
+
+static void prvTestLoss( Socket_t xSocket )
+{
+IPFragmentStats_t xStats;
+uint32_t ulNumber, ulReceived = 0u, ulFirst;
+size_t uxLength;
+
+	for( ulNumber = 0u; ulNumber < fragmentLOSSY_COUNT; ulNumber++ )
+	{
+		fragmentCHECK( prvSend( xSocket, fragmentLOSSY_PAYLOAD, ulNumber ) == pdPASS );
+
+		/* Delayed fragments may complete an older datagram. */
+		while( ( uxLength = prvReceive( xSocket ) ) != 0u )
+		{
+			fragmentCHECK( uxLength == fragmentLOSSY_PAYLOAD );
+			memcpy( &ulFirst, ucReceiveBuffer, sizeof( ulFirst ) );
+			prvFillPayload( fragmentLOSSY_PAYLOAD, ulFirst );
+			fragmentCHECK( memcmp( ucReceiveBuffer, ucSendBuffer, uxLength ) == 0 );
+			ulReceived++;
+		}
+	}
+
+	/* Let the incomplete datagrams time out. */
+	vTaskDelay( pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS + 1000u ) );
+
+	FreeRTOS_GetIPFragmentStats( &xStats );
+	fragmentCHECK( xStats.ulDatagramsReassembled == ulReceived );
+	fragmentCHECK( ulReceived < fragmentLOSSY_COUNT );
+	fragmentCHECK( xStats.ulDatagramsDropped + xStats.ulReassemblyTimeouts > 0u );
+	fragmentCHECK( xStats.uxBuffersInUse == 0u );
+	fragmentCHECK( xStats.uxBytesInUse == 0u );
+
+	printf( "loss:      %lu of %u datagrams reassembled, %lu fragments received, %lu incomplete datagrams dropped, %lu timed out\n",
+		( unsigned long ) ulReceived, ( unsigned ) fragmentLOSSY_COUNT, ( unsigned long ) xStats.ulFragmentsReceived,
+		( unsigned long ) xStats.ulDatagramsDropped, ( unsigned long ) xStats.ulReassemblyTimeouts );
+}
+
+#endif /* fragmentLOSSY */
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+TickType_t xTimeOut = pdMS_TO_TICKS( 100u );
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	xAddress.sin_port = FreeRTOS_htons( fragmentPORT );
+	fragmentCHECK( FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	/* The first datagram to the own address is replaced by an ARP request,
+	after which the ARP cache has an entry for it. */
+	prvSend( xSocket, 1u, 0u );
+	while( prvReceive( xSocket ) != 0u )
+	{
+	}
+
+	#if( fragmentLOSSY == 0 )
+	{
+		prvTestSizes( xSocket );
+	}
+	#else
+	{
+		prvTestLoss( xSocket );
+	}
+	#endif
+
+	FreeRTOS_closesocket( xSocket );
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,348 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks corner cases of the TCP handshake of a listening socket.  The peer
+ * is simulated in this file: it injects TCP segments as received packets,
+ * and the network interface records the segments that the stack sends.
+ *
+ * prvTestFinAck(): the peer answers the SYN+ACK with a FIN+ACK, as it does
+ * when its last ACK of the handshake got lost and it has closed already.  The
+ * ACK establishes the connection, the child socket can be accepted, and the
+ * FIN is acknowledged.
+ *
+ * prvTestOrphan(): the peer answers the SYN+ACK with a bare FIN.  The child
+ * socket answers with a RST, and is never connected.  Nobody can accept() it,
+ * so the hang protection must delete it, and free its place in the backlog of
+ * the listening socket.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_ARP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#define handshakePORT				( 7000u )
+#define handshakeSEGMENT_LENGTH		( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER )
+
+/* The TCP flags, as in FreeRTOS_TCP_IP.c. */
+#define handshakeFIN				( 0x01u )
+#define handshakeSYN				( 0x02u )
+#define handshakeRST				( 0x04u )
+#define handshakeACK				( 0x10u )
+
+/* The number of segments that the simulated interface remembers. */
+#define handshakeSEGMENTS			( 16 )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const MACAddress_t xPeerMACAddress = { { 0x00, 0x11, 0x22, 0x33, 0x44, 0x66 } };
+
+/* A TCP segment that the stack has sent to the peer. */
+typedef struct xSENT_SEGMENT
+{
+	uint16_t usPeerPort;
+	uint8_t ucFlags;
+	uint32_t ulSequenceNumber;
+	uint32_t ulAckNumber;
+} SentSegment_t;
+
+static SentSegment_t xSent[ handshakeSEGMENTS ];
+static volatile int iSentCount = 0;
+
+static uint32_t ulPeerIPAddress;
+static Socket_t xServer;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define handshakeCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+const TCPPacket_t *pxPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+SentSegment_t *pxSegment;
+
+	/* Only the TCP segments to the peer are recorded, the ARP packets are
+	ignored. */
+	if( ( pxPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+		( pxPacket->xIPHeader.ucProtocol == ipPROTOCOL_TCP ) &&
+		( pxPacket->xIPHeader.ulDestinationIPAddress == ulPeerIPAddress ) &&
+		( iSentCount < handshakeSEGMENTS ) )
+	{
+		pxSegment = &( xSent[ iSentCount++ ] );
+		pxSegment->usPeerPort = FreeRTOS_ntohs( pxPacket->xTCPHeader.usDestinationPort );
+		pxSegment->ucFlags = pxPacket->xTCPHeader.ucTCPFlags;
+		pxSegment->ulSequenceNumber = FreeRTOS_ntohl( pxPacket->xTCPHeader.ulSequenceNumber );
+		pxSegment->ulAckNumber = FreeRTOS_ntohl( pxPacket->xTCPHeader.ulAckNr );
+	}
+
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/* Let the stack receive a segment from the peer, and give the IP-task the
+time to handle it. */
+static void prvInject( uint16_t usPeerPort, uint8_t ucFlags, uint32_t ulSequenceNumber, uint32_t ulAckNumber )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+TCPPacket_t *pxPacket;
+IPStackEvent_t xRxEvent;
+
+	pxBuffer = pxGetNetworkBufferWithDescriptor( handshakeSEGMENT_LENGTH, 0u );
+	configASSERT( pxBuffer != NULL );
+
+	memset( pxBuffer->pucEthernetBuffer, 0, handshakeSEGMENT_LENGTH );
+	pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+
+	memcpy( pxPacket->xEthernetHeader.xDestinationAddress.ucBytes, ucMACAddress, sizeof( ucMACAddress ) );
+	memcpy( pxPacket->xEthernetHeader.xSourceAddress.ucBytes, xPeerMACAddress.ucBytes, sizeof( xPeerMACAddress ) );
+	pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+	pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+	pxPacket->xIPHeader.usLength = FreeRTOS_htons( handshakeSEGMENT_LENGTH - ipSIZE_OF_ETH_HEADER );
+	pxPacket->xIPHeader.ucTimeToLive = ipconfigTCP_TIME_TO_LIVE;
+	pxPacket->xIPHeader.ucProtocol = ipPROTOCOL_TCP;
+	pxPacket->xIPHeader.ulSourceIPAddress = ulPeerIPAddress;
+	pxPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_GetIPAddress();
+	pxPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxPacket->xIPHeader.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+	pxPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxPacket->xIPHeader.usHeaderChecksum );
+
+	pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( usPeerPort );
+	pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( handshakePORT );
+	pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+	pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNumber );
+	pxPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER / 4u ) << 4 );
+	pxPacket->xTCPHeader.ucTCPFlags = ucFlags;
+	pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 8192u );
+
+	( void ) usGenerateProtocolChecksum( pxBuffer->pucEthernetBuffer, handshakeSEGMENT_LENGTH, pdTRUE );
+
+	xRxEvent.eEventType = eNetworkRxEvent;
+	xRxEvent.pvData = ( void * ) pxBuffer;
+	configASSERT( xSendEventStructToIPTask( &xRxEvent, 0u ) == pdPASS );
+
+	vTaskDelay( pdMS_TO_TICKS( 10u ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Return the last segment that was sent to a port of the peer, or NULL. */
+static const SentSegment_t *prvLastSent( uint16_t usPeerPort )
+{
+const SentSegment_t *pxSegment = NULL;
+int iIndex;
+
+	for( iIndex = 0; iIndex < iSentCount; iIndex++ )
+	{
+		if( xSent[ iIndex ].usPeerPort == usPeerPort )
+		{
+			pxSegment = &( xSent[ iIndex ] );
+		}
+	}
+
+	return pxSegment;
+}
+/*-----------------------------------------------------------*/
+
+/* Send a SYN, and return the sequence number of the SYN+ACK, or 0. */
+static uint32_t prvOpen( uint16_t usPeerPort, uint32_t ulPeerSequence )
+{
+const SentSegment_t *pxSegment;
+uint32_t ulSequenceNumber = 0ul;
+
+	prvInject( usPeerPort, handshakeSYN, ulPeerSequence, 0ul );
+	pxSegment = prvLastSent( usPeerPort );
+
+	if( ( pxSegment != NULL ) &&
+		( pxSegment->ucFlags == ( handshakeSYN | handshakeACK ) ) &&
+		( pxSegment->ulAckNumber == ulPeerSequence + 1ul ) )
+	{
+		ulSequenceNumber = pxSegment->ulSequenceNumber;
+	}
+
+	return ulSequenceNumber;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFinAck( void )
+{
+const uint16_t usPeerPort = 40001u;
+const uint32_t ulPeerSequence = 1000ul;
+uint32_t ulSequenceNumber;
+const SentSegment_t *pxSegment;
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+Socket_t xChild;
+
+	ulSequenceNumber = prvOpen( usPeerPort, ulPeerSequence );
+	handshakeCHECK( ulSequenceNumber != 0ul );
+
+	/* The FIN+ACK in stead of the last ACK of the handshake. */
+	prvInject( usPeerPort, handshakeFIN | handshakeACK, ulPeerSequence + 1ul, ulSequenceNumber + 1ul );
+
+	/* The FIN is acknowledged, there is no RST. */
+	pxSegment = prvLastSent( usPeerPort );
+	handshakeCHECK( pxSegment != NULL );
+	if( pxSegment != NULL )
+	{
+		handshakeCHECK( ( pxSegment->ucFlags & handshakeRST ) == 0u );
+		handshakeCHECK( ( pxSegment->ucFlags & handshakeACK ) != 0u );
+		handshakeCHECK( pxSegment->ulAckNumber == ulPeerSequence + 2ul );
+	}
+
+	/* The connection was established, and was closed by the peer. */
+	xChild = FreeRTOS_accept( xServer, &xAddress, &xSize );
+	handshakeCHECK( ( xChild != NULL ) && ( xChild != FREERTOS_INVALID_SOCKET ) );
+
+	if( ( xChild != NULL ) && ( xChild != FREERTOS_INVALID_SOCKET ) )
+	{
+		handshakeCHECK( xAddress.sin_port == FreeRTOS_htons( usPeerPort ) );
+		handshakeCHECK( FreeRTOS_issocketconnected( xChild ) == pdFALSE );
+		FreeRTOS_closesocket( xChild );
+	}
+
+	printf( "FIN+ACK: last segment flags %02x ack %lu\n",
+		( pxSegment != NULL ) ? pxSegment->ucFlags : 0u,
+		( pxSegment != NULL ) ? ( unsigned long ) ( pxSegment->ulAckNumber - ulPeerSequence ) : 0ul );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestOrphan( void )
+{
+const uint16_t usPeerPort = 40002u;
+const uint32_t ulPeerSequence = 2000ul;
+FreeRTOS_Socket_t *pxServer = ( FreeRTOS_Socket_t * ) xServer;
+uint32_t ulSequenceNumber;
+const SentSegment_t *pxSegment;
+TickType_t xStartTime;
+
+	ulSequenceNumber = prvOpen( usPeerPort, ulPeerSequence );
+	handshakeCHECK( ulSequenceNumber != 0ul );
+	handshakeCHECK( pxServer->u.xTCP.usChildCount == 1u );
+
+	/* A FIN without an ACK can not complete the handshake. */
+	prvInject( usPeerPort, handshakeFIN, ulPeerSequence + 1ul, 0ul );
+
+	pxSegment = prvLastSent( usPeerPort );
+	handshakeCHECK( ( pxSegment != NULL ) && ( ( pxSegment->ucFlags & handshakeRST ) != 0u ) );
+
+	/* The child still holds its place in the backlog.  A new SYN is refused,
+	the backlog has room for one child. */
+	handshakeCHECK( pxServer->u.xTCP.usChildCount == 1u );
+	handshakeCHECK( prvOpen( usPeerPort + 1u, ulPeerSequence ) == 0ul );
+
+	/* The hang protection deletes the child. */
+	xStartTime = xTaskGetTickCount();
+	while( ( pxServer->u.xTCP.usChildCount != 0u ) &&
+		   ( ( xTaskGetTickCount() - xStartTime ) < pdMS_TO_TICKS( 2u * 1000u * ipconfigTCP_HANG_PROTECTION_TIME ) ) )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 100u ) );
+	}
+
+	handshakeCHECK( pxServer->u.xTCP.usChildCount == 0u );
+	handshakeCHECK( ( xTaskGetTickCount() - xStartTime ) > pdMS_TO_TICKS( 1000u * ipconfigTCP_HANG_PROTECTION_TIME ) );
+
+	/* The backlog has room again. */
+	handshakeCHECK( prvOpen( usPeerPort + 2u, ulPeerSequence ) != 0ul );
+
+	printf( "orphan: deleted after %lu ms\n", ( unsigned long ) ( xTaskGetTickCount() - xStartTime ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+const TickType_t xTimeOut = pdMS_TO_TICKS( 1000u );
+struct freertos_sockaddr xAddress;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	/* The peer is on the local network, its MAC address is known. */
+	ulPeerIPAddress = FreeRTOS_inet_addr_quick( 192u, 168u, 1u, 20u );
+	vARPRefreshCacheEntry( &xPeerMACAddress, ulPeerIPAddress );
+
+	xServer = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xServer != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xServer, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	xAddress.sin_port = FreeRTOS_htons( handshakePORT );
+	FreeRTOS_bind( xServer, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xServer, 1 );
+
+	prvTestFinAck();
+	prvTestOrphan();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,64 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Kernel configuration of the host build, see FreeRTOS.h.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configTICK_RATE_HZ				( 1000 )
+#define configMAX_PRIORITIES			( 8 )
+#define configMINIMAL_STACK_SIZE		( 1024 )
+#define configMAX_TASK_NAME_LEN			( 16 )
+#define configUSE_16_BIT_TICKS			0
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#define configSUPPORT_STATIC_ALLOCATION	0
+#define configUSE_TRACE_FACILITY		0
+#define configQUEUE_REGISTRY_SIZE		0
+
+/* The run time of a task is counted in cycles of the time stamp counter on
+x86, or in ns on other hosts.  It only counts the time in which the task
+itself runs, not the time in which the threads hand over to each other. */
+#define configGENERATE_RUN_TIME_STATS	1
+#define configRUN_TIME_COUNTER_TYPE		uint64_t
+#define portGET_RUN_TIME_COUNTER_VALUE()	ullHostRunTimeCounter()
+
+#define INCLUDE_vTaskDelete				1
+#define INCLUDE_vTaskDelay				1
+#define INCLUDE_vTaskSuspend			1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
+#define INCLUDE_xTaskGetHandle			1
+
+/* The amount of memory that pvPortMalloc() may hand out.  A test can lower it
+to see how the stack behaves when the heap is nearly exhausted. */
+#ifndef configTOTAL_HEAP_SIZE
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 16u * 1024u * 1024u ) )
+#endif
+
+#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+#endif /* FREERTOS_CONFIG_H */
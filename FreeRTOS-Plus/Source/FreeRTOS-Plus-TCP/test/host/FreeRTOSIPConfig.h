@@ -0,0 +1,112 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The FreeRTOS+TCP configuration of the test and benchmark programs.  Every
+ * setting can be overridden from the command line, e.g. with
+ * -DipconfigUSE_TCP_HASH_LOOKUP=1 in the CFLAGS of a test.
+ */
+
+#ifndef FREERTOS_IP_CONFIG_H
+#define FREERTOS_IP_CONFIG_H
+
+#include <stdio.h>
+
+#ifndef ipconfigHAS_PRINTF
+	#define ipconfigHAS_PRINTF				0
+#endif
+#if( ipconfigHAS_PRINTF != 0 )
+	#define FreeRTOS_printf( X )			printf X
+#endif
+
+#ifndef ipconfigHAS_DEBUG_PRINTF
+	#define ipconfigHAS_DEBUG_PRINTF		0
+#endif
+#if( ipconfigHAS_DEBUG_PRINTF != 0 )
+	#define FreeRTOS_debug_printf( X )		printf X
+#endif
+
+#define ipconfigBYTE_ORDER					pdFREERTOS_LITTLE_ENDIAN
+
+#ifndef ipconfigIP_TASK_PRIORITY
+	#define ipconfigIP_TASK_PRIORITY		( configMAX_PRIORITIES - 2 )
+#endif
+#define ipconfigIP_TASK_STACK_SIZE_WORDS	( configMINIMAL_STACK_SIZE * 5 )
+
+#define ipconfigUSE_NETWORK_EVENT_HOOK		1
+#define ipconfigUSE_DHCP					0
+#define ipconfigUSE_LLMNR					0
+#define ipconfigUSE_NBNS					0
+#define ipconfigSUPPORT_OUTGOING_PINGS		0
+
+#ifndef ipconfigUSE_DNS
+	#define ipconfigUSE_DNS					0
+#endif
+
+#ifndef ipconfigUSE_TCP
+	#define ipconfigUSE_TCP					1
+#endif
+#ifndef ipconfigUSE_TCP_WIN
+	#define ipconfigUSE_TCP_WIN				1
+#endif
+
+#ifndef ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS
+	#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS	64
+#endif
+#ifndef ipconfigEVENT_QUEUE_LENGTH
+	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
+#endif
+
+#ifndef ipconfigNETWORK_MTU
+	#define ipconfigNETWORK_MTU				1500
+#endif
+#ifndef ipconfigTCP_MSS
+	#define ipconfigTCP_MSS					1460
+#endif
+#ifndef ipconfigTCP_RX_BUFFER_LENGTH
+	#define ipconfigTCP_RX_BUFFER_LENGTH	( 8 * ipconfigTCP_MSS )
+#endif
+#ifndef ipconfigTCP_TX_BUFFER_LENGTH
+	#define ipconfigTCP_TX_BUFFER_LENGTH	( 8 * ipconfigTCP_MSS )
+#endif
+
+#define ipconfigZERO_COPY_RX_DRIVER			1
+#define ipconfigZERO_COPY_TX_DRIVER			1
+#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND	1
+#define ipconfigSUPPORT_SELECT_FUNCTION		1
+#define ipconfigUSE_CALLBACKS				0
+#define ipconfigCHECK_IP_QUEUE_SPACE		1
+#define ipconfigUDP_MAX_RX_PACKETS			0
+#define ipconfigMAX_ARP_AGE					150
+#define ipconfigARP_CACHE_ENTRIES			16
+
+#define ipconfigSOCK_DEFAULT_RECEIVE_BLOCK_TIME	pdMS_TO_TICKS( 5000 )
+#define ipconfigSOCK_DEFAULT_SEND_BLOCK_TIME	pdMS_TO_TICKS( 5000 )
+
+/* The programs use a fixed sequence of random numbers. */
+#define ipconfigRAND32()					( ( uint32_t ) ulHostRand32() )
+extern uint32_t ulHostRand32( void );
+
+#endif /* FREERTOS_IP_CONFIG_H */
@@ -0,0 +1,95 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Default application hooks for the test and benchmark programs.  They are
+ * weak, a program can provide its own version.
+ */
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Set by vApplicationIPNetworkEventHook(). */
+volatile BaseType_t xHostNetworkUp = pdFALSE;
+
+static uint32_t ulRandomState = 0x12345678UL;
+
+/*-----------------------------------------------------------*/
+
+uint32_t ulHostRand32( void )
+{
+	/* A 32-bit xorshift generator, the same sequence on every run. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) BaseType_t xApplicationGetRandomNumber( uint32_t *pulNumber )
+{
+	*pulNumber = ulHostRand32();
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+	uint16_t usSourcePort, uint32_t ulDestinationAddress, uint16_t usDestinationPort )
+{
+	( void ) ulSourceAddress;
+	( void ) usSourcePort;
+	( void ) ulDestinationAddress;
+	( void ) usDestinationPort;
+
+	return ulHostRand32();
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) void vApplicationIPNetworkEventHook( eIPCallbackEvent_t eNetworkEvent )
+{
+	xHostNetworkUp = ( eNetworkEvent == eNetworkUp ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) const char *pcApplicationHostnameHook( void )
+{
+	return "host";
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) BaseType_t xApplicationDNSQueryHook( const char *pcName )
+{
+	( void ) pcName;
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,1057 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The kernel of the host build, see FreeRTOS.h.
+ *
+ * Every task is a POSIX thread, but only one of them runs at any time: the
+ * running task owns xKernelMutex, and it only gives it up when it blocks, or
+ * when it is preempted by a task of a higher priority that it made ready.
+ * Task switches therefore only happen inside API calls, like on a single core
+ * without time slicing.
+ *
+ * The clock is virtual.  When all tasks are blocked, the tick count jumps to
+ * the first time-out.  A program gives the same results on every run and on
+ * every host, independent of the speed of the host.
+ *
+ * Functions with a FromISR suffix behave like their task versions and must
+ * also be called from a task.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#include <x86intrin.h>
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+/* The stack of the thread that runs a task. */
+#define hostTHREAD_STACK_SIZE	( ( size_t ) ( 1024u * 1024u ) )
+
+/* Room in front of every block from pvPortMalloc() to remember its size. */
+#define hostHEAP_HEADER_SIZE	( ( size_t ) 16u )
+
+typedef enum
+{
+	eTaskReady = 0,		/* Ready to run, or running */
+	eTaskBlocked,		/* Waiting for an object or for a time-out */
+	eTaskDeleted
+} eHostTaskState_t;
+
+struct tskTaskControlBlock
+{
+	pthread_t xThread;
+	pthread_cond_t xRunCondition;		/* Signalled when the task becomes pxCurrentTCB */
+	TaskFunction_t pxTaskCode;
+	void *pvParameters;
+	char pcTaskName[ configMAX_TASK_NAME_LEN ];
+	UBaseType_t uxPriority;
+	eHostTaskState_t eState;
+	uint64_t ullReadyOrder;				/* Tasks of equal priority run in the order in which they became ready */
+	const void *pvWaitObject;			/* The object that a blocked task waits for, or NULL */
+	BaseType_t xHasTimeOut;
+	TickType_t xWakeTime;
+	volatile uint32_t ulNotifiedValue;
+	configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;	/* The time that the task has been running */
+	configRUN_TIME_COUNTER_TYPE ulSwitchedInTime;
+	struct tskTaskControlBlock *pxNextTask;
+};
+
+struct QueueDefinition
+{
+	uint8_t *pucStorage;
+	UBaseType_t uxLength;
+	UBaseType_t uxItemSize;
+	UBaseType_t uxMessagesWaiting;
+	UBaseType_t uxReadIndex;
+};
+
+struct EventGroupDef_t
+{
+	EventBits_t uxEventBits;
+};
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Return the ready task that should run next.  When all tasks are blocked,
+ * the clock is moved to the first time-out.
+ */
+static TaskHandle_t prvSelectTask( void );
+
+/*
+ * Let 'pxTask' run in stead of the calling task.  The caller continues when
+ * it is selected again.
+ */
+static void prvSwitchTo( TaskHandle_t pxTask );
+
+/*
+ * Switch to a task of a higher priority, if one is ready.
+ */
+static void prvYieldIfNeeded( void );
+
+/*
+ * Wait until 'pvObject' changes, or until the time-out.  Called from main()
+ * in stead of a task, the clock is advanced by the time-out.
+ */
+static void prvWait( const void *pvObject, TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait );
+
+/*
+ * Make all tasks that wait for 'pvObject' ready again.  They will check the
+ * object again when they run.
+ */
+static void prvWakeWaiters( const void *pvObject );
+
+static void prvMakeReady( TaskHandle_t pxTask );
+static void *prvTaskThread( void *pvParameters );
+
+/*-----------------------------------------------------------*/
+
+static pthread_mutex_t xKernelMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xSchedulerEndCondition = PTHREAD_COND_INITIALIZER;
+
+/* The task that owns xKernelMutex, or NULL when main() owns it. */
+static TaskHandle_t volatile pxCurrentTCB = NULL;
+static TaskHandle_t pxTaskList = NULL;
+
+static BaseType_t xSchedulerRunning = pdFALSE;
+static BaseType_t xSchedulerEnded = pdFALSE;
+static UBaseType_t uxSchedulerSuspended = 0u;
+static BaseType_t xYieldPending = pdFALSE;
+
+static volatile TickType_t xTickCount = 0u;
+static uint64_t ullReadyCounter = 0u;
+
+static size_t xHeapUsed = 0u;
+static size_t xHeapMaximumUsed = 0u;
+
+/*-----------------------------------------------------------*/
+
+/* main() owns the kernel until it starts the scheduler. */
+static void prvLockKernel( void ) __attribute__( ( constructor ) );
+static void prvLockKernel( void )
+{
+	pthread_mutex_lock( &xKernelMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine )
+{
+	fprintf( stderr, "Assertion failed at %s:%lu, tick %lu\n", pcFile, ulLine, ( unsigned long ) xTickCount );
+	fflush( stdout );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+/* The heap functions are weak: a program can link its own heap, like the
+first-fit heap of buffers/heap.c. */
+__attribute__( ( weak ) ) void *pvPortMalloc( size_t xSize )
+{
+uint8_t *pucBlock = NULL;
+
+	if( xHeapUsed + xSize <= configTOTAL_HEAP_SIZE )
+	{
+		pucBlock = ( uint8_t * ) malloc( xSize + hostHEAP_HEADER_SIZE );
+	}
+
+	if( pucBlock != NULL )
+	{
+		memcpy( pucBlock, &xSize, sizeof( xSize ) );
+		xHeapUsed += xSize;
+
+		if( xHeapMaximumUsed < xHeapUsed )
+		{
+			xHeapMaximumUsed = xHeapUsed;
+		}
+
+		pucBlock += hostHEAP_HEADER_SIZE;
+	}
+
+	return ( void * ) pucBlock;
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) void vPortFree( void *pv )
+{
+uint8_t *pucBlock = ( uint8_t * ) pv;
+size_t xSize;
+
+	if( pucBlock != NULL )
+	{
+		pucBlock -= hostHEAP_HEADER_SIZE;
+		memcpy( &xSize, pucBlock, sizeof( xSize ) );
+		xHeapUsed -= xSize;
+		free( pucBlock );
+	}
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) size_t xPortGetFreeHeapSize( void )
+{
+	return configTOTAL_HEAP_SIZE - xHeapUsed;
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return configTOTAL_HEAP_SIZE - xHeapMaximumUsed;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	uxSchedulerSuspended++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvMakeReady( TaskHandle_t pxTask )
+{
+	pxTask->eState = eTaskReady;
+	pxTask->pvWaitObject = NULL;
+	pxTask->ullReadyOrder = ++ullReadyCounter;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWakeWaiters( const void *pvObject )
+{
+TaskHandle_t pxTask;
+
+	for( pxTask = pxTaskList; pxTask != NULL; pxTask = pxTask->pxNextTask )
+	{
+		if( ( pxTask->eState == eTaskBlocked ) && ( pxTask->pvWaitObject == pvObject ) && ( pvObject != NULL ) )
+		{
+			prvMakeReady( pxTask );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TaskHandle_t prvSelectTask( void )
+{
+TaskHandle_t pxTask, pxBest, pxFirstTimeOut;
+
+	for( ;; )
+	{
+		pxBest = NULL;
+		pxFirstTimeOut = NULL;
+
+		for( pxTask = pxTaskList; pxTask != NULL; pxTask = pxTask->pxNextTask )
+		{
+			if( pxTask->eState == eTaskReady )
+			{
+				if( ( pxBest == NULL ) ||
+					( pxTask->uxPriority > pxBest->uxPriority ) ||
+					( ( pxTask->uxPriority == pxBest->uxPriority ) && ( pxTask->ullReadyOrder < pxBest->ullReadyOrder ) ) )
+				{
+					pxBest = pxTask;
+				}
+			}
+			else if( ( pxTask->eState == eTaskBlocked ) && ( pxTask->xHasTimeOut != pdFALSE ) )
+			{
+				if( ( pxFirstTimeOut == NULL ) ||
+					( ( int32_t ) ( pxTask->xWakeTime - pxFirstTimeOut->xWakeTime ) < 0 ) )
+				{
+					pxFirstTimeOut = pxTask;
+				}
+			}
+		}
+
+		if( pxBest != NULL )
+		{
+			break;
+		}
+
+		if( pxFirstTimeOut == NULL )
+		{
+			fprintf( stderr, "All tasks are blocked without a time-out at tick %lu\n", ( unsigned long ) xTickCount );
+			fflush( stdout );
+			exit( EXIT_FAILURE );
+		}
+
+		/* Nothing to do until the first time-out, let the time jump. */
+		if( ( int32_t ) ( pxFirstTimeOut->xWakeTime - xTickCount ) > 0 )
+		{
+			xTickCount = pxFirstTimeOut->xWakeTime;
+		}
+
+		for( pxTask = pxTaskList; pxTask != NULL; pxTask = pxTask->pxNextTask )
+		{
+			if( ( pxTask->eState == eTaskBlocked ) && ( pxTask->xHasTimeOut != pdFALSE ) &&
+				( ( int32_t ) ( pxTask->xWakeTime - xTickCount ) <= 0 ) )
+			{
+				prvMakeReady( pxTask );
+			}
+		}
+	}
+
+	return pxBest;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchTo( TaskHandle_t pxTask )
+{
+TaskHandle_t pxSelf = pxCurrentTCB;
+
+	if( pxTask != pxSelf )
+	{
+		/* The time in which the other tasks run, and the hand-over between
+		the threads, is not counted. */
+		pxSelf->ulRunTimeCounter += portGET_RUN_TIME_COUNTER_VALUE() - pxSelf->ulSwitchedInTime;
+
+		pxCurrentTCB = pxTask;
+		pthread_cond_signal( &( pxTask->xRunCondition ) );
+
+		if( pxSelf->eState == eTaskDeleted )
+		{
+			pthread_mutex_unlock( &xKernelMutex );
+			pthread_exit( NULL );
+		}
+
+		while( pxCurrentTCB != pxSelf )
+		{
+			pthread_cond_wait( &( pxSelf->xRunCondition ), &xKernelMutex );
+		}
+		pxSelf->ulSwitchedInTime = portGET_RUN_TIME_COUNTER_VALUE();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvYieldIfNeeded( void )
+{
+TaskHandle_t pxTask;
+
+	if( ( pxCurrentTCB != NULL ) && ( xSchedulerRunning != pdFALSE ) )
+	{
+		if( uxSchedulerSuspended != 0u )
+		{
+			xYieldPending = pdTRUE;
+		}
+		else
+		{
+			pxTask = prvSelectTask();
+
+			if( pxTask->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				prvSwitchTo( pxTask );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWait( const void *pvObject, TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait )
+{
+TaskHandle_t pxSelf = pxCurrentTCB;
+
+	if( pxSelf == NULL )
+	{
+		/* main() waits: nobody else can change the object. */
+		configASSERT( *pxTicksToWait != portMAX_DELAY );
+		xTickCount += *pxTicksToWait;
+		*pxTicksToWait = 0u;
+	}
+	else
+	{
+		configASSERT( uxSchedulerSuspended == 0u );
+
+		pxSelf->eState = eTaskBlocked;
+		pxSelf->pvWaitObject = pvObject;
+		pxSelf->xHasTimeOut = ( *pxTicksToWait != portMAX_DELAY ) ? pdTRUE : pdFALSE;
+		pxSelf->xWakeTime = xTickCount + *pxTicksToWait;
+
+		prvSwitchTo( prvSelectTask() );
+
+		( void ) xTaskCheckForTimeOut( pxTimeOut, pxTicksToWait );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void *prvTaskThread( void *pvParameters )
+{
+TaskHandle_t pxSelf = ( TaskHandle_t ) pvParameters;
+
+	pthread_mutex_lock( &xKernelMutex );
+
+	while( pxCurrentTCB != pxSelf )
+	{
+		pthread_cond_wait( &( pxSelf->xRunCondition ), &xKernelMutex );
+	}
+
+	pxSelf->ulSwitchedInTime = portGET_RUN_TIME_COUNTER_VALUE();
+	pxSelf->pxTaskCode( pxSelf->pvParameters );
+
+	/* A task should not return, but it is harmless here. */
+	vTaskDelete( NULL );
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth,
+	void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask )
+{
+TaskHandle_t pxTask;
+pthread_attr_t xAttributes;
+BaseType_t xReturn = pdFAIL;
+
+	( void ) usStackDepth;
+
+	pxTask = ( TaskHandle_t ) calloc( 1u, sizeof( *pxTask ) );
+
+	if( pxTask != NULL )
+	{
+		pthread_cond_init( &( pxTask->xRunCondition ), NULL );
+		pxTask->pxTaskCode = pxTaskCode;
+		pxTask->pvParameters = pvParameters;
+		snprintf( pxTask->pcTaskName, sizeof( pxTask->pcTaskName ), "%s", pcName );
+		pxTask->uxPriority = ( uxPriority < configMAX_PRIORITIES ) ? uxPriority : ( configMAX_PRIORITIES - 1 );
+		prvMakeReady( pxTask );
+
+		pthread_attr_init( &xAttributes );
+		pthread_attr_setstacksize( &xAttributes, hostTHREAD_STACK_SIZE );
+		pthread_attr_setdetachstate( &xAttributes, PTHREAD_CREATE_DETACHED );
+
+		if( pthread_create( &( pxTask->xThread ), &xAttributes, prvTaskThread, pxTask ) == 0 )
+		{
+			pxTask->pxNextTask = pxTaskList;
+			pxTaskList = pxTask;
+			xReturn = pdPASS;
+		}
+		else
+		{
+			free( pxTask );
+			pxTask = NULL;
+		}
+
+		pthread_attr_destroy( &xAttributes );
+	}
+
+	if( pxCreatedTask != NULL )
+	{
+		*pxCreatedTask = pxTask;
+	}
+
+	if( xReturn != pdFAIL )
+	{
+		prvYieldIfNeeded();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+TaskHandle_t pxTask = ( xTaskToDelete != NULL ) ? xTaskToDelete : pxCurrentTCB;
+
+	configASSERT( pxTask != NULL );
+	pxTask->eState = eTaskDeleted;
+
+	if( pxTask == pxCurrentTCB )
+	{
+		/* Does not return. */
+		prvSwitchTo( prvSelectTask() );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskStartScheduler( void )
+{
+	xSchedulerRunning = pdTRUE;
+	pxCurrentTCB = prvSelectTask();
+	pthread_cond_signal( &( pxCurrentTCB->xRunCondition ) );
+
+	while( xSchedulerEnded == pdFALSE )
+	{
+		pthread_cond_wait( &xSchedulerEndCondition, &xKernelMutex );
+	}
+
+	/* main() owns the kernel again, the tasks will not run anymore. */
+	xSchedulerRunning = pdFALSE;
+	pxCurrentTCB = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskEndScheduler( void )
+{
+TaskHandle_t pxSelf = pxCurrentTCB;
+
+	configASSERT( pxSelf != NULL );
+
+	xSchedulerEnded = pdTRUE;
+	pxCurrentTCB = NULL;
+	pthread_cond_signal( &xSchedulerEndCondition );
+
+	for( ;; )
+	{
+		pthread_cond_wait( &( pxSelf->xRunCondition ), &xKernelMutex );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+TimeOut_t xTimeOut;
+TickType_t xTicksToWait = xTicksToDelay;
+
+	if( xTicksToWait == 0u )
+	{
+		vTaskYield();
+	}
+	else
+	{
+		vTaskSetTimeOutState( &xTimeOut );
+
+		while( xTicksToWait != 0u )
+		{
+			prvWait( NULL, &xTimeOut, &xTicksToWait );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement )
+{
+TickType_t xWakeTime = *pxPreviousWakeTime + xTimeIncrement;
+
+	*pxPreviousWakeTime = xWakeTime;
+
+	if( ( int32_t ) ( xWakeTime - xTickCount ) > 0 )
+	{
+		vTaskDelay( xWakeTime - xTickCount );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskYield( void )
+{
+	if( ( pxCurrentTCB != NULL ) && ( xSchedulerRunning != pdFALSE ) )
+	{
+		/* Go behind the other ready tasks of the same priority. */
+		pxCurrentTCB->ullReadyOrder = ++ullReadyCounter;
+		prvSwitchTo( prvSelectTask() );
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxTaskPriorityGet( TaskHandle_t xTask )
+{
+TaskHandle_t pxTask = ( xTask != NULL ) ? xTask : pxCurrentTCB;
+
+	return ( pxTask != NULL ) ? pxTask->uxPriority : tskIDLE_PRIORITY;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskPrioritySet( TaskHandle_t xTask, UBaseType_t uxNewPriority )
+{
+TaskHandle_t pxTask = ( xTask != NULL ) ? xTask : pxCurrentTCB;
+
+	if( pxTask != NULL )
+	{
+		pxTask->uxPriority = ( uxNewPriority < configMAX_PRIORITIES ) ? uxNewPriority : ( configMAX_PRIORITIES - 1 );
+
+		if( pxTask == pxCurrentTCB )
+		{
+			prvYieldIfNeeded();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+	return pxCurrentTCB;
+}
+/*-----------------------------------------------------------*/
+
+char *pcTaskGetName( TaskHandle_t xTaskToQuery )
+{
+static char pcMainName[] = "main";
+TaskHandle_t pxTask = ( xTaskToQuery != NULL ) ? xTaskToQuery : pxCurrentTCB;
+
+	return ( pxTask != NULL ) ? pxTask->pcTaskName : pcMainName;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskGetHandle( const char *pcNameToQuery )
+{
+TaskHandle_t pxTask;
+
+	for( pxTask = pxTaskList; pxTask != NULL; pxTask = pxTask->pxNextTask )
+	{
+		if( ( pxTask->eState != eTaskDeleted ) && ( strcmp( pxTask->pcTaskName, pcNameToQuery ) == 0 ) )
+		{
+			break;
+		}
+	}
+
+	return pxTask;
+}
+/*-----------------------------------------------------------*/
+
+configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter( const TaskHandle_t xTask )
+{
+TaskHandle_t pxTask = ( xTask != NULL ) ? xTask : pxCurrentTCB;
+configRUN_TIME_COUNTER_TYPE ulReturn;
+
+	configASSERT( pxTask != NULL );
+	ulReturn = pxTask->ulRunTimeCounter;
+
+	if( pxTask == pxCurrentTCB )
+	{
+		ulReturn += portGET_RUN_TIME_COUNTER_VALUE() - pxTask->ulSwitchedInTime;
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+configRUN_TIME_COUNTER_TYPE ullHostRunTimeCounter( void )
+{
+	#if defined( __x86_64__ ) || defined( __i386__ )
+	{
+		return ( configRUN_TIME_COUNTER_TYPE ) __rdtsc();
+	}
+	#else
+	{
+	struct timespec xNow;
+
+		clock_gettime( CLOCK_MONOTONIC, &xNow );
+		return ( ( configRUN_TIME_COUNTER_TYPE ) xNow.tv_sec * 1000000000u ) + ( configRUN_TIME_COUNTER_TYPE ) xNow.tv_nsec;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+	return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+	return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskStepTick( const TickType_t xTicksToJump )
+{
+	xTickCount += xTicksToJump;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+	pxTimeOut->xOverflowCount = 0;
+	pxTimeOut->xTimeOnEntering = xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait )
+{
+TickType_t xElapsed = xTickCount - pxTimeOut->xTimeOnEntering;
+BaseType_t xReturn;
+
+	if( *pxTicksToWait == portMAX_DELAY )
+	{
+		xReturn = pdFALSE;
+	}
+	else if( xElapsed < *pxTicksToWait )
+	{
+		*pxTicksToWait -= xElapsed;
+		vTaskSetTimeOutState( pxTimeOut );
+		xReturn = pdFALSE;
+	}
+	else
+	{
+		*pxTicksToWait = 0u;
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSuspendAll( void )
+{
+	uxSchedulerSuspended++;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskResumeAll( void )
+{
+BaseType_t xYielded = pdFALSE;
+
+	configASSERT( uxSchedulerSuspended != 0u );
+	uxSchedulerSuspended--;
+
+	if( ( uxSchedulerSuspended == 0u ) && ( xYieldPending != pdFALSE ) )
+	{
+		xYieldPending = pdFALSE;
+		prvYieldIfNeeded();
+		xYielded = pdTRUE;
+	}
+
+	return xYielded;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify )
+{
+	xTaskToNotify->ulNotifiedValue++;
+	prvWakeWaiters( ( const void * ) &( xTaskToNotify->ulNotifiedValue ) );
+	prvYieldIfNeeded();
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	( void ) xTaskNotifyGive( xTaskToNotify );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+TaskHandle_t pxSelf = pxCurrentTCB;
+TimeOut_t xTimeOut;
+uint32_t ulReturn = 0u;
+
+	configASSERT( pxSelf != NULL );
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		if( pxSelf->ulNotifiedValue != 0u )
+		{
+			ulReturn = pxSelf->ulNotifiedValue;
+			pxSelf->ulNotifiedValue = ( xClearCountOnExit != pdFALSE ) ? 0u : ( ulReturn - 1u );
+			break;
+		}
+
+		if( xTicksToWait == 0u )
+		{
+			break;
+		}
+
+		prvWait( ( const void * ) &( pxSelf->ulNotifiedValue ), &xTimeOut, &xTicksToWait );
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize )
+{
+QueueHandle_t xQueue;
+
+	configASSERT( uxQueueLength > 0u );
+
+	xQueue = ( QueueHandle_t ) calloc( 1u, sizeof( *xQueue ) );
+
+	if( xQueue != NULL )
+	{
+		xQueue->uxLength = uxQueueLength;
+		xQueue->uxItemSize = uxItemSize;
+
+		if( uxItemSize != 0u )
+		{
+			xQueue->pucStorage = ( uint8_t * ) calloc( uxQueueLength, uxItemSize );
+			configASSERT( xQueue->pucStorage != NULL );
+		}
+	}
+
+	return xQueue;
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount )
+{
+QueueHandle_t xQueue = xQueueCreate( uxMaxCount, ( UBaseType_t ) 0u );
+
+	if( xQueue != NULL )
+	{
+		xQueue->uxMessagesWaiting = uxInitialCount;
+	}
+
+	return xQueue;
+}
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+	free( xQueue->pucStorage );
+	free( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+TimeOut_t xTimeOut;
+UBaseType_t uxIndex;
+BaseType_t xReturn = pdFAIL;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		if( ( xQueue->uxMessagesWaiting < xQueue->uxLength ) || ( xCopyPosition == queueOVERWRITE ) )
+		{
+			if( xCopyPosition == queueSEND_TO_FRONT )
+			{
+				xQueue->uxReadIndex = ( xQueue->uxReadIndex + xQueue->uxLength - 1u ) % xQueue->uxLength;
+				uxIndex = xQueue->uxReadIndex;
+			}
+			else if( ( xCopyPosition == queueOVERWRITE ) && ( xQueue->uxMessagesWaiting != 0u ) )
+			{
+				uxIndex = xQueue->uxReadIndex;
+				xQueue->uxMessagesWaiting--;
+			}
+			else
+			{
+				uxIndex = ( xQueue->uxReadIndex + xQueue->uxMessagesWaiting ) % xQueue->uxLength;
+			}
+
+			if( xQueue->uxItemSize != 0u )
+			{
+				memcpy( xQueue->pucStorage + ( uxIndex * xQueue->uxItemSize ), pvItemToQueue, xQueue->uxItemSize );
+			}
+
+			xQueue->uxMessagesWaiting++;
+			prvWakeWaiters( xQueue );
+			prvYieldIfNeeded();
+			xReturn = pdPASS;
+			break;
+		}
+
+		if( xTicksToWait == 0u )
+		{
+			break;
+		}
+
+		prvWait( xQueue, &xTimeOut, &xTicksToWait );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	return xQueueGenericSend( xQueue, pvItemToQueue, ( TickType_t ) 0u, xCopyPosition );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvQueueRead( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, BaseType_t xRemove )
+{
+TimeOut_t xTimeOut;
+BaseType_t xReturn = pdFAIL;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		if( xQueue->uxMessagesWaiting != 0u )
+		{
+			if( ( xQueue->uxItemSize != 0u ) && ( pvBuffer != NULL ) )
+			{
+				memcpy( pvBuffer, xQueue->pucStorage + ( xQueue->uxReadIndex * xQueue->uxItemSize ), xQueue->uxItemSize );
+			}
+
+			if( xRemove != pdFALSE )
+			{
+				xQueue->uxReadIndex = ( xQueue->uxReadIndex + 1u ) % xQueue->uxLength;
+				xQueue->uxMessagesWaiting--;
+				prvWakeWaiters( xQueue );
+				prvYieldIfNeeded();
+			}
+
+			xReturn = pdPASS;
+			break;
+		}
+
+		if( xTicksToWait == 0u )
+		{
+			break;
+		}
+
+		prvWait( xQueue, &xTimeOut, &xTicksToWait );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	return prvQueueRead( xQueue, pvBuffer, xTicksToWait, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	return prvQueueRead( xQueue, pvBuffer, ( TickType_t ) 0u, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	return prvQueueRead( xQueue, pvBuffer, xTicksToWait, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+	return xQueue->uxMessagesWaiting;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+	return xQueue->uxLength - xQueue->uxMessagesWaiting;
+}
+/*-----------------------------------------------------------*/
+
+EventGroupHandle_t xEventGroupCreate( void )
+{
+	return ( EventGroupHandle_t ) calloc( 1u, sizeof( struct EventGroupDef_t ) );
+}
+/*-----------------------------------------------------------*/
+
+void vEventGroupDelete( EventGroupHandle_t xEventGroup )
+{
+	/* Tasks that still wait for the group time out. */
+	free( xEventGroup );
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+	const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits, TickType_t xTicksToWait )
+{
+TimeOut_t xTimeOut;
+EventBits_t uxReturn;
+BaseType_t xMatch;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		uxReturn = xEventGroup->uxEventBits;
+
+		if( xWaitForAllBits != pdFALSE )
+		{
+			xMatch = ( ( uxReturn & uxBitsToWaitFor ) == uxBitsToWaitFor ) ? pdTRUE : pdFALSE;
+		}
+		else
+		{
+			xMatch = ( ( uxReturn & uxBitsToWaitFor ) != 0u ) ? pdTRUE : pdFALSE;
+		}
+
+		if( xMatch != pdFALSE )
+		{
+			if( xClearOnExit != pdFALSE )
+			{
+				xEventGroup->uxEventBits &= ~uxBitsToWaitFor;
+			}
+
+			break;
+		}
+
+		if( xTicksToWait == 0u )
+		{
+			break;
+		}
+
+		prvWait( xEventGroup, &xTimeOut, &xTicksToWait );
+	}
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet )
+{
+	xEventGroup->uxEventBits |= uxBitsToSet;
+	prvWakeWaiters( xEventGroup );
+	prvYieldIfNeeded();
+
+	return xEventGroup->uxEventBits;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEventGroupSetBitsFromISR( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+
+	( void ) xEventGroupSetBits( xEventGroup, uxBitsToSet );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+EventBits_t xEventGroupClearBits( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear )
+{
+EventBits_t uxReturn = xEventGroup->uxEventBits;
+
+	xEventGroup->uxEventBits &= ~uxBitsToClear;
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,84 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The doubly linked lists of the FreeRTOS kernel, for the host build.  The
+ * layout and the semantics are the same as those of the kernel's list.h.
+ */
+
+#ifndef INC_LIST_H
+#define INC_LIST_H
+
+#define configLIST_VOLATILE
+
+struct xLIST;
+
+struct xLIST_ITEM
+{
+	configLIST_VOLATILE TickType_t xItemValue;
+	struct xLIST_ITEM * configLIST_VOLATILE pxNext;
+	struct xLIST_ITEM * configLIST_VOLATILE pxPrevious;
+	void * pvOwner;
+	struct xLIST * configLIST_VOLATILE pvContainer;
+};
+typedef struct xLIST_ITEM ListItem_t;
+
+struct xMINI_LIST_ITEM
+{
+	configLIST_VOLATILE TickType_t xItemValue;
+	struct xLIST_ITEM * configLIST_VOLATILE pxNext;
+	struct xLIST_ITEM * configLIST_VOLATILE pxPrevious;
+};
+typedef struct xMINI_LIST_ITEM MiniListItem_t;
+
+typedef struct xLIST
+{
+	volatile UBaseType_t uxNumberOfItems;
+	ListItem_t * configLIST_VOLATILE pxIndex;
+	MiniListItem_t xListEnd;
+} List_t;
+
+#define listSET_LIST_ITEM_OWNER( pxListItem, pxOwner )		( ( pxListItem )->pvOwner = ( void * ) ( pxOwner ) )
+#define listGET_LIST_ITEM_OWNER( pxListItem )				( ( pxListItem )->pvOwner )
+#define listSET_LIST_ITEM_VALUE( pxListItem, xValue )		( ( pxListItem )->xItemValue = ( xValue ) )
+#define listGET_LIST_ITEM_VALUE( pxListItem )				( ( pxListItem )->xItemValue )
+#define listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxList )			( ( ( pxList )->xListEnd ).pxNext->xItemValue )
+#define listGET_HEAD_ENTRY( pxList )						( ( ( pxList )->xListEnd ).pxNext )
+#define listGET_NEXT( pxListItem )							( ( pxListItem )->pxNext )
+#define listGET_END_MARKER( pxList )						( ( ListItem_t const * ) ( &( ( pxList )->xListEnd ) ) )
+#define listLIST_IS_EMPTY( pxList )							( ( ( pxList )->uxNumberOfItems == ( UBaseType_t ) 0 ) ? pdTRUE : pdFALSE )
+#define listCURRENT_LIST_LENGTH( pxList )					( ( pxList )->uxNumberOfItems )
+#define listGET_OWNER_OF_HEAD_ENTRY( pxList )				( ( &( ( pxList )->xListEnd ) )->pxNext->pvOwner )
+#define listIS_CONTAINED_WITHIN( pxList, pxListItem )		( ( ( pxListItem )->pvContainer == ( pxList ) ) ? ( pdTRUE ) : ( pdFALSE ) )
+#define listLIST_ITEM_CONTAINER( pxListItem )				( ( pxListItem )->pvContainer )
+#define listLIST_IS_INITIALISED( pxList )					( ( pxList )->xListEnd.xItemValue == portMAX_DELAY )
+
+void vListInitialise( List_t * const pxList );
+void vListInitialiseItem( ListItem_t * const pxItem );
+void vListInsert( List_t * const pxList, ListItem_t * const pxNewListItem );
+void vListInsertEnd( List_t * const pxList, ListItem_t * const pxNewListItem );
+UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove );
+
+#endif /* INC_LIST_H */
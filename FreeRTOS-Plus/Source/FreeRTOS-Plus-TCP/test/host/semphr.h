@@ -0,0 +1,49 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The semaphore API of the host build, see FreeRTOS.h.  As in the kernel, a
+ * semaphore is a queue with items of zero bytes.  A mutex is a binary
+ * semaphore that is created 'given', there is no priority inheritance.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreCreateBinary()							xQueueCreate( ( UBaseType_t ) 1, ( UBaseType_t ) 0 )
+#define xSemaphoreCreateCounting( uxMaxCount, uxInitialCount )	xQueueCreateCountingSemaphore( ( uxMaxCount ), ( uxInitialCount ) )
+#define xSemaphoreCreateMutex()								xQueueCreateCountingSemaphore( ( UBaseType_t ) 1, ( UBaseType_t ) 1 )
+#define vSemaphoreDelete( xSemaphore )						vQueueDelete( ( xSemaphore ) )
+#define xSemaphoreTake( xSemaphore, xBlockTime )			xQueueReceive( ( xSemaphore ), NULL, ( xBlockTime ) )
+#define xSemaphoreTakeFromISR( xSemaphore, pxWoken )		xQueueReceiveFromISR( ( xSemaphore ), NULL, ( pxWoken ) )
+#define xSemaphoreGive( xSemaphore )						xQueueGenericSend( ( xSemaphore ), NULL, ( TickType_t ) 0, queueSEND_TO_BACK )
+#define xSemaphoreGiveFromISR( xSemaphore, pxWoken )		xQueueGenericSendFromISR( ( xSemaphore ), NULL, ( pxWoken ), queueSEND_TO_BACK )
+#define uxSemaphoreGetCount( xSemaphore )					uxQueueMessagesWaiting( ( xSemaphore ) )
+
+#endif /* SEMAPHORE_H */
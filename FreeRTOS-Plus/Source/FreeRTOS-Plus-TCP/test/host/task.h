@@ -0,0 +1,90 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The task API of the host build, see FreeRTOS.h.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "list.h"
+
+struct tskTaskControlBlock;
+typedef struct tskTaskControlBlock * TaskHandle_t;
+
+typedef void ( *TaskFunction_t )( void * );
+
+typedef struct xTIME_OUT
+{
+	BaseType_t xOverflowCount;
+	TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+#define tskIDLE_PRIORITY			( ( UBaseType_t ) 0U )
+
+#define taskYIELD()					vTaskYield()
+#define taskENTER_CRITICAL()		portENTER_CRITICAL()
+#define taskEXIT_CRITICAL()			portEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()		portSET_INTERRUPT_MASK_FROM_ISR()
+#define taskEXIT_CRITICAL_FROM_ISR( x )		portCLEAR_INTERRUPT_MASK_FROM_ISR( x )
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth,
+	void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask );
+void vTaskDelete( TaskHandle_t xTaskToDelete );
+void vTaskDelay( const TickType_t xTicksToDelay );
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement );
+void vTaskYield( void );
+UBaseType_t uxTaskPriorityGet( TaskHandle_t xTask );
+void vTaskPrioritySet( TaskHandle_t xTask, UBaseType_t uxNewPriority );
+TaskHandle_t xTaskGetCurrentTaskHandle( void );
+char *pcTaskGetName( TaskHandle_t xTaskToQuery );
+TaskHandle_t xTaskGetHandle( const char *pcNameToQuery );
+
+/* The time that a task has been running, see configGENERATE_RUN_TIME_STATS. */
+configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter( const TaskHandle_t xTask );
+configRUN_TIME_COUNTER_TYPE ullHostRunTimeCounter( void );
+
+TickType_t xTaskGetTickCount( void );
+TickType_t xTaskGetTickCountFromISR( void );
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut );
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait );
+
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+
+BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify );
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken );
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait );
+
+void vTaskStartScheduler( void );
+void vTaskEndScheduler( void );
+
+/* The clock only advances when all tasks are blocked: it jumps to the first
+time-out.  A program that does not start the scheduler can move the clock
+with vTaskStepTick(). */
+void vTaskStepTick( const TickType_t xTicksToJump );
+
+#endif /* INC_TASK_H */
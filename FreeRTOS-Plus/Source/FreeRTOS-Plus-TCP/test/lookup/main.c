@@ -0,0 +1,373 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the cost of pxTCPSocketLookup() and pxUDPSocketLookup(), which
+ * find the socket of every received TCP packet and UDP datagram, with 10, 100
+ * and 1000 bound sockets.
+ *
+ * The sockets are those of a busy server: one socket listens to port 80, half
+ * of the others are connections that it has accepted, from many clients, and
+ * the other half are connections that were made to other servers, each from
+ * its own local port.  The connected sockets are not really connected: their
+ * state and remote address are set, and they are bound the way the IP-task
+ * binds a child socket.  Nothing is ever sent to them.
+ *
+ * Of the packets that are looked up, 1 in 8 is a SYN from a new client, which
+ * must find the listening socket, the others belong to a random connection.
+ *
+ * The UDP sockets are bound to ports all over the range.  1 in 8 datagrams is
+ * sent to a port without socket, the others to a random bound socket.
+ *
+ * Every lookup must find the right socket.  The cost is reported in cycles
+ * of the time stamp counter per packet on x86, or in ns on other hosts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#define lookupCOST_UNIT		"cycles"
+#else
+	#define lookupCOST_UNIT		"ns"
+#endif
+
+#define lookupSERVER_PORT		( 80u )
+#define lookupUDP_PORT_STEP		( 61u )
+#define lookupMAX_SOCKETS		( 1000 )
+
+/* The number of lookups per measurement. */
+#ifndef lookupPACKETS
+	#define lookupPACKETS		( 200000 )
+#endif
+
+/* The packets are drawn from a table of this size, so that the random
+generator is not measured. */
+#define lookupTABLE_SIZE		( 4096 )
+
+typedef struct xLOOKUP_PACKET
+{
+	uint32_t ulRemoteIP;
+	UBaseType_t uxLocalPort;
+	UBaseType_t uxRemotePort;
+	FreeRTOS_Socket_t *pxExpected;
+} LookupPacket_t;
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static const BaseType_t xSocketCounts[] = { 10, 100, lookupMAX_SOCKETS };
+
+static FreeRTOS_Socket_t *pxSockets[ lookupMAX_SOCKETS ];
+static LookupPacket_t xPackets[ lookupTABLE_SIZE ];
+
+static uint32_t ulRandomState = 0x2545f491ul;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define lookupCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static FreeRTOS_Socket_t *prvCreateTCPSocket( void )
+{
+Socket_t xSocket;
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+	return ( FreeRTOS_Socket_t * ) xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCreateTCPSockets( BaseType_t xCount )
+{
+FreeRTOS_Socket_t *pxSocket;
+struct freertos_sockaddr xAddress;
+BaseType_t xIndex;
+
+	/* The listening socket, created with the normal API. */
+	pxSockets[ 0 ] = prvCreateTCPSocket();
+	xAddress.sin_port = FreeRTOS_htons( lookupSERVER_PORT );
+	lookupCHECK( FreeRTOS_bind( pxSockets[ 0 ], &xAddress, sizeof( xAddress ) ) == 0 );
+	lookupCHECK( FreeRTOS_listen( pxSockets[ 0 ], 8 ) == 0 );
+
+	for( xIndex = 1; xIndex < xCount; xIndex++ )
+	{
+		pxSocket = prvCreateTCPSocket();
+		pxSocket->u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+
+		if( ( xIndex & 1 ) != 0 )
+		{
+			/* Accepted from client 10.0.x.y. */
+			pxSocket->u.xTCP.ulRemoteIP = 0x0a000000ul + ( uint32_t ) xIndex;
+			pxSocket->u.xTCP.usRemotePort = ( uint16_t ) ( 1024u + ( prvRandom() % 60000u ) );
+			xAddress.sin_port = FreeRTOS_htons( lookupSERVER_PORT );
+		}
+		else
+		{
+			/* Connected to server 172.16.0.1:443 from a local port of its own. */
+			pxSocket->u.xTCP.ulRemoteIP = 0xac100001ul;
+			pxSocket->u.xTCP.usRemotePort = 443u;
+			xAddress.sin_port = FreeRTOS_htons( ( uint16_t ) ( 49152 + xIndex ) );
+		}
+
+		lookupCHECK( vSocketBind( pxSocket, &xAddress, sizeof( xAddress ), pdTRUE ) == 0 );
+		pxSockets[ xIndex ] = pxSocket;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseSockets( BaseType_t xCount )
+{
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < xCount; xIndex++ )
+	{
+		if( pxSockets[ xIndex ]->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		{
+			/* Nothing has to be sent when it closes. */
+			pxSockets[ xIndex ]->u.xTCP.ucTCPState = ( uint8_t ) eCLOSED;
+		}
+		FreeRTOS_closesocket( pxSockets[ xIndex ] );
+		pxSockets[ xIndex ] = NULL;
+	}
+
+	/* Let the IP-task free them. */
+	vTaskDelay( pdMS_TO_TICKS( 10u ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCreateUDPSockets( BaseType_t xCount )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < xCount; xIndex++ )
+	{
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+		configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+		/* Ports 1024, 1085, 1146, ..., the ports in between stay free. */
+		xAddress.sin_port = FreeRTOS_htons( ( uint16_t ) ( 1024u + ( lookupUDP_PORT_STEP * ( uint32_t ) xIndex ) ) );
+		lookupCHECK( FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+		pxSockets[ xIndex ] = ( FreeRTOS_Socket_t * ) xSocket;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMakeTCPPackets( BaseType_t xCount )
+{
+LookupPacket_t *pxPacket;
+FreeRTOS_Socket_t *pxSocket;
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < lookupTABLE_SIZE; xIndex++ )
+	{
+		pxPacket = &( xPackets[ xIndex ] );
+
+		if( ( ( prvRandom() % 8u ) == 0u ) || ( xCount < 2 ) )
+		{
+			/* A SYN from a client that is not connected. */
+			pxPacket->ulRemoteIP = 0x0b000000ul + ( prvRandom() % 0x10000ul );
+			pxPacket->uxLocalPort = lookupSERVER_PORT;
+			pxPacket->uxRemotePort = 1024u + ( prvRandom() % 60000u );
+			pxPacket->pxExpected = pxSockets[ 0 ];
+		}
+		else
+		{
+			pxSocket = pxSockets[ 1 + ( BaseType_t ) ( prvRandom() % ( uint32_t ) ( xCount - 1 ) ) ];
+			pxPacket->ulRemoteIP = pxSocket->u.xTCP.ulRemoteIP;
+			pxPacket->uxLocalPort = pxSocket->usLocalPort;
+			pxPacket->uxRemotePort = pxSocket->u.xTCP.usRemotePort;
+			pxPacket->pxExpected = pxSocket;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMakeUDPPackets( BaseType_t xCount )
+{
+LookupPacket_t *pxPacket;
+BaseType_t xIndex;
+uint32_t ulSlot;
+
+	for( xIndex = 0; xIndex < lookupTABLE_SIZE; xIndex++ )
+	{
+		pxPacket = &( xPackets[ xIndex ] );
+		ulSlot = prvRandom() % ( uint32_t ) xCount;
+		pxPacket->ulRemoteIP = 0ul;
+		pxPacket->uxRemotePort = 0u;
+
+		if( ( prvRandom() % 8u ) == 0u )
+		{
+			/* A port without socket. */
+			pxPacket->uxLocalPort = FreeRTOS_htons( ( uint16_t ) ( 1025u + ( lookupUDP_PORT_STEP * ulSlot ) ) );
+			pxPacket->pxExpected = NULL;
+		}
+		else
+		{
+			/* The port in network byte order, as it is found in the packet. */
+			pxPacket->uxLocalPort = FreeRTOS_htons( ( uint16_t ) ( 1024u + ( lookupUDP_PORT_STEP * ulSlot ) ) );
+			pxPacket->pxExpected = pxSockets[ ulSlot ];
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasureTCP( BaseType_t xCount )
+{
+const LookupPacket_t *pxPacket;
+FreeRTOS_Socket_t *pxFound;
+uint64_t ullStart, ullCost;
+unsigned long ulWrong = 0ul;
+BaseType_t xIndex;
+
+	prvCreateTCPSockets( xCount );
+	prvMakeTCPPackets( xCount );
+
+	/* FreeRTOS_listen() may have asked for the lookup table to be rebuilt,
+	which happens during the first lookup. */
+	( void ) pxTCPSocketLookup( 0ul, lookupSERVER_PORT, 0ul, 0u );
+
+	/* The scheduler cannot switch tasks during the lookups. */
+	ullStart = ullHostRunTimeCounter();
+	for( xIndex = 0; xIndex < lookupPACKETS; xIndex++ )
+	{
+		pxPacket = &( xPackets[ xIndex % lookupTABLE_SIZE ] );
+		pxFound = pxTCPSocketLookup( 0ul, pxPacket->uxLocalPort, pxPacket->ulRemoteIP, pxPacket->uxRemotePort );
+		if( pxFound != pxPacket->pxExpected )
+		{
+			ulWrong++;
+		}
+	}
+	ullCost = ullHostRunTimeCounter() - ullStart;
+
+	lookupCHECK( ulWrong == 0ul );
+	printf( "TCP %4ld sockets: %8.1f " lookupCOST_UNIT " per packet\n", ( long ) xCount,
+		( double ) ullCost / ( double ) lookupPACKETS );
+
+	prvCloseSockets( xCount );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasureUDP( BaseType_t xCount )
+{
+const LookupPacket_t *pxPacket;
+FreeRTOS_Socket_t *pxFound;
+uint64_t ullStart, ullCost;
+unsigned long ulWrong = 0ul;
+BaseType_t xIndex;
+
+	prvCreateUDPSockets( xCount );
+	prvMakeUDPPackets( xCount );
+
+	ullStart = ullHostRunTimeCounter();
+	for( xIndex = 0; xIndex < lookupPACKETS; xIndex++ )
+	{
+		pxPacket = &( xPackets[ xIndex % lookupTABLE_SIZE ] );
+		pxFound = pxUDPSocketLookup( pxPacket->uxLocalPort );
+		if( pxFound != pxPacket->pxExpected )
+		{
+			ulWrong++;
+		}
+	}
+	ullCost = ullHostRunTimeCounter() - ullStart;
+
+	lookupCHECK( ulWrong == 0ul );
+	printf( "UDP %4ld sockets: %8.1f " lookupCOST_UNIT " per packet\n", ( long ) xCount,
+		( double ) ullCost / ( double ) lookupPACKETS );
+
+	prvCloseSockets( xCount );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTask( void *pvParameters )
+{
+size_t uxIndex;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	for( uxIndex = 0u; uxIndex < sizeof( xSocketCounts ) / sizeof( xSocketCounts[ 0 ] ); uxIndex++ )
+	{
+		prvMeasureTCP( xSocketCounts[ uxIndex ] );
+	}
+
+	for( uxIndex = 0u; uxIndex < sizeof( xSocketCounts ) / sizeof( xSocketCounts[ 0 ] ); uxIndex++ )
+	{
+		prvMeasureUDP( xSocketCounts[ uxIndex ] );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvBenchmarkTask, "Benchmark", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,274 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks the simulated link of the loopback network interface.  The driver is
+ * included in this file, the IP-stack is replaced by a few stubs that record
+ * the clock tick at which every frame is received.
+ *
+ * Built with a bandwidth of 1 Mbit/s and a delay of 5 ms: a 1500-byte frame
+ * takes 12 ms to transmit, so a burst of frames sent at tick 0 must arrive at
+ * ticks 17, 29, 41, ...
+ *
+ * Built with niLOOPBACK_LOSS_PER_MILLE and niLOOPBACK_REORDER_PER_MILLE: every
+ * frame that was not lost must arrive, and the reordered frames must be
+ * overtaken by later frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../portable/NetworkInterface/loopback/NetworkInterface.c"
+
+#define linkNUM_FRAMES		( 200 )
+
+/* The byte of the frame that holds its sequence number. */
+#define linkTAG_OFFSET		( 20 )
+
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+
+static int iReceived = 0;
+static int iTags[ linkNUM_FRAMES ];
+static TickType_t xTicks[ linkNUM_FRAMES ];
+static int iARPRefreshed = 0;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define linkCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+
+	( void ) xBlockTimeTicks;
+	pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+	pxBuffer->xDataLength = xRequestedSizeBytes;
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	free( pxNetworkBuffer->pucEthernetBuffer );
+	free( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceive( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+	if( iReceived < linkNUM_FRAMES )
+	{
+		iTags[ iReceived ] = pxNetworkBuffer->pucEthernetBuffer[ linkTAG_OFFSET ];
+		xTicks[ iReceived ] = xTaskGetTickCount();
+		iReceived++;
+	}
+
+	vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout )
+{
+	( void ) xTimeout;
+	prvReceive( ( NetworkBufferDescriptor_t * ) pxEvent->pvData );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	void vNetworkRxBatchInit( NetworkRxBatch_t *pxBatch )
+	{
+		memset( pxBatch, 0, sizeof( *pxBatch ) );
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xNetworkRxBatchAdd( NetworkRxBatch_t *pxBatch, NetworkBufferDescriptor_t *pxNetworkBuffer, TickType_t xTimeout )
+	{
+		( void ) pxBatch;
+		( void ) xTimeout;
+		prvReceive( pxNetworkBuffer );
+
+		return pdPASS;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xNetworkRxBatchSend( NetworkRxBatch_t *pxBatch, TickType_t xTimeout )
+	{
+		( void ) pxBatch;
+		( void ) xTimeout;
+
+		return pdPASS;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress )
+{
+	( void ) pxMACAddress;
+	linkCHECK( ulIPAddress == *ipLOCAL_IP_ADDRESS_POINTER );
+	iARPRefreshed++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendFrame( size_t xLength, int iTag )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxGetNetworkBufferWithDescriptor( xLength, 0 );
+
+	pxBuffer->pucEthernetBuffer[ 12 ] = 0x08;
+	pxBuffer->pucEthernetBuffer[ linkTAG_OFFSET ] = ( uint8_t ) iTag;
+	xNetworkInterfaceOutput( pxBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestARP( void )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxGetNetworkBufferWithDescriptor( 60, 0 );
+ARPPacket_t *pxARPFrame = ( ARPPacket_t * ) pxBuffer->pucEthernetBuffer;
+
+	/* An ARP request for the own IP address is answered directly, and never
+	put on the link. */
+	pxARPFrame->xEthernetHeader.usFrameType = ipARP_FRAME_TYPE;
+	pxARPFrame->xARPHeader.usOperation = ipARP_REQUEST;
+	pxARPFrame->xARPHeader.ulTargetProtocolAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+	xNetworkInterfaceOutput( pxBuffer, pdTRUE );
+
+	linkCHECK( iARPRefreshed == 1 );
+	linkCHECK( ulLoopbackSent == 0u );
+}
+/*-----------------------------------------------------------*/
+
+#if( niLOOPBACK_LOSS_PER_MILLE == 0 ) && ( niLOOPBACK_REORDER_PER_MILLE == 0 )
+
+	static void prvTestLink( void )
+	{
+	int iIndex;
+	const int iBurst = 20;
+
+		for( iIndex = 0; iIndex < iBurst; iIndex++ )
+		{
+			prvSendFrame( 1500u, iIndex );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 1000u ) );
+
+		linkCHECK( iReceived == iBurst );
+
+		for( iIndex = 0; iIndex < iReceived; iIndex++ )
+		{
+			/* 5 ms of delay plus 12 ms of transmission time for every frame up to
+			and including this one. */
+			linkCHECK( iTags[ iIndex ] == iIndex );
+			linkCHECK( xTicks[ iIndex ] == ( TickType_t ) ( 5 + ( 12 * ( iIndex + 1 ) ) ) );
+		}
+
+		printf( "%d frames of 1500 bytes, the last one arrived at tick %lu\n", iReceived, ( unsigned long ) xTicks[ iReceived - 1 ] );
+	}
+
+#else
+
+	static void prvTestLink( void )
+	{
+	int iIndex, iMaximum = -1, iOvertaken = 0;
+
+		/* Small frames, one every clock tick, so that a reordered frame is
+		overtaken by the frames sent after it. */
+		for( iIndex = 0; iIndex < linkNUM_FRAMES; iIndex++ )
+		{
+			prvSendFrame( 60u, iIndex );
+			vTaskDelay( 1 );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 1000u ) );
+
+		linkCHECK( ulLoopbackLost > 0u );
+		linkCHECK( ulLoopbackReordered > 0u );
+		linkCHECK( ulLoopbackQueueFull == 0u );
+		linkCHECK( ( uint32_t ) iReceived == ulLoopbackSent );
+		linkCHECK( ( uint32_t ) iReceived + ulLoopbackLost == linkNUM_FRAMES );
+
+		for( iIndex = 0; iIndex < iReceived; iIndex++ )
+		{
+			if( iTags[ iIndex ] < iMaximum )
+			{
+				iOvertaken++;
+			}
+			else
+			{
+				iMaximum = iTags[ iIndex ];
+			}
+		}
+
+		linkCHECK( iOvertaken > 0 );
+
+		printf( "%d frames sent, %lu lost, %lu reordered, %d overtaken\n", linkNUM_FRAMES,
+			( unsigned long ) ulLoopbackLost, ( unsigned long ) ulLoopbackReordered, iOvertaken );
+	}
+
+#endif
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	prvTestARP();
+	prvTestLink();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	*ipLOCAL_IP_ADDRESS_POINTER = FreeRTOS_inet_addr_quick( 192, 168, 1, 10 );
+
+	xNetworkInterfaceInitialise();
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
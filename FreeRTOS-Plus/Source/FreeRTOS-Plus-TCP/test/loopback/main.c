@@ -0,0 +1,84 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Runs the TCP benchmark suite of the demos (TCPBenchmark.c) against the
+ * loopback network interface.  The client and the servers all run in this
+ * process, and talk to each other through the simulated link.  The program
+ * exits with a failure when the suite reports errors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "TCPBenchmark.h"
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static TCPBenchmarkResults_t xResults;
+
+/*-----------------------------------------------------------*/
+
+void vApplicationTCPBenchmarkHook( const TCPBenchmarkResults_t *pxResults )
+{
+	xResults = *pxResults;
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	vStartTCPBenchmarkTasks( configMINIMAL_STACK_SIZE * 4, tskIDLE_PRIORITY + 1 );
+	vTaskStartScheduler();
+
+	printf( "bulk:        %lu bytes in %lu ms, %lu kbit/s\n",
+		( unsigned long ) xResults.ulBulkBytes, ( unsigned long ) xResults.ulBulkTimeMs, ( unsigned long ) xResults.ulBulkKbps );
+	printf( "latency:     %lu transactions in %lu ms, %lu us each\n",
+		( unsigned long ) xResults.ulTransactions, ( unsigned long ) xResults.ulTransactionTimeMs, ( unsigned long ) xResults.ulLatencyUs );
+	printf( "connections: %lu in %lu ms, %lu per second\n",
+		( unsigned long ) xResults.ulConnections, ( unsigned long ) xResults.ulConnectionTimeMs, ( unsigned long ) xResults.ulConnectionsPerSecond );
+	printf( "errors:      %lu\n", ( unsigned long ) xResults.ulErrors );
+	printf( "min. space:  event queue %lu", ( unsigned long ) uxGetMinimumIPQueueSpace() );
+	#if( ipconfigUSE_NETWORK_RINGS != 0 )
+	{
+		printf( ", RX ring %lu, TX ring %lu", ( unsigned long ) uxGetMinimumRxRingSpace(), ( unsigned long ) uxGetMinimumTxRingSpace() );
+	}
+	#endif
+	printf( "\n" );
+
+	return ( xResults.ulErrors == 0u ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
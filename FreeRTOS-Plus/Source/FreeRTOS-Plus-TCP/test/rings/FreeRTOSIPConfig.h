@@ -0,0 +1,50 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * The configuration of the ring test: the settings of ../host, with the RX and
+ * TX rings enabled, and a trace macro that counts lost events.
+ */
+
+#ifndef RINGS_TEST_IP_CONFIG_H
+#define RINGS_TEST_IP_CONFIG_H
+
+#define ipconfigUSE_NETWORK_RINGS			1
+#define ipconfigUSE_LINKED_RX_MESSAGES		1
+
+/* The test task must run before the loopback task, and the loopback task
+before the IP-task. */
+#define ipconfigIP_TASK_PRIORITY			( configMAX_PRIORITIES - 3 )
+#define configLOOPBACK_TASK_PRIORITY		( configMAX_PRIORITIES - 2 )
+
+/* A fixed delay, so that the test knows when a frame arrives. */
+#define niLOOPBACK_DELAY_MS					10u
+
+extern void vTestEventLost( int xEventType );
+#define iptraceSTACK_TX_EVENT_LOST( xEventType )	vTestEventLost( ( int ) ( xEventType ) )
+
+#include "../host/FreeRTOSIPConfig.h"
+
+#endif /* RINGS_TEST_IP_CONFIG_H */
@@ -0,0 +1,214 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Tests the RX and TX rings between the IP-task and the loopback network
+ * interface (ipconfigUSE_NETWORK_RINGS).
+ *
+ * prvTestLostWakeUp(): a frame arrives while the event queue of the IP-task is
+ * full, so the eNetworkRxEvent that should wake up the IP-task is lost.  The
+ * IP-task must still find the packet in the RX ring.
+ *
+ * prvTestBurst(): a burst of datagrams passes through the TX ring and the RX
+ * ring, all of them must arrive.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+
+#define testPORT			( 7000u )
+#define testBURST			( 12 )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static Socket_t xSocket;
+static struct freertos_sockaddr xAddress;
+static int iRxEventsLost = 0;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define testCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+void vTestEventLost( int xEventType )
+{
+	if( xEventType == ( int ) eNetworkRxEvent )
+	{
+		iRxEventsLost++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( uint8_t ucTag )
+{
+	return FreeRTOS_sendto( xSocket, &ucTag, sizeof( ucTag ), 0, &xAddress, sizeof( xAddress ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReceive( void )
+{
+uint8_t ucTag;
+BaseType_t xResult;
+
+	xResult = FreeRTOS_recvfrom( xSocket, &ucTag, sizeof( ucTag ), 0, NULL, NULL );
+
+	return ( xResult == ( BaseType_t ) sizeof( ucTag ) ) ? ( BaseType_t ) ucTag : -1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestLostWakeUp( void )
+{
+const IPStackEvent_t xEvent = { eNoEvent, NULL };
+TickType_t xStartTime;
+BaseType_t xQueued = 0;
+
+	prvSend( 1 );
+
+	/* The IP-task sends the frame while this task sleeps.  The frame arrives
+	exactly when this task wakes up again, but this task runs first. */
+	vTaskDelay( pdMS_TO_TICKS( niLOOPBACK_DELAY_MS ) );
+
+	/* Fill the event queue. */
+	while( xSendEventStructToIPTask( &xEvent, 0 ) == pdPASS )
+	{
+		xQueued++;
+	}
+
+	testCHECK( xQueued > 0 );
+
+	/* Now the loopback task puts the frame in the RX ring, and can not wake
+	up the IP-task. */
+	xStartTime = xTaskGetTickCount();
+	testCHECK( prvReceive() == 1 );
+	testCHECK( iRxEventsLost == 1 );
+
+	/* The IP-task found the packet while handling the other events. */
+	testCHECK( xTaskGetTickCount() == xStartTime );
+
+	printf( "lost wake-up: %ld events queued, %d RX event lost, received after %lu ms\n",
+		( long ) xQueued, iRxEventsLost, ( unsigned long ) ( xTaskGetTickCount() - xStartTime ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestBurst( void )
+{
+BaseType_t xIndex, xReceived = 0;
+
+	for( xIndex = 0; xIndex < testBURST; xIndex++ )
+	{
+		prvSend( ( uint8_t ) xIndex );
+	}
+
+	for( xIndex = 0; xIndex < testBURST; xIndex++ )
+	{
+		if( prvReceive() == xIndex )
+		{
+			xReceived++;
+		}
+	}
+
+	testCHECK( xReceived == testBURST );
+
+	/* The frames went through the TX ring. */
+	testCHECK( uxGetMinimumTxRingSpace() < ( UBaseType_t ) ipconfigNETWORK_TX_RING_LENGTH );
+
+	printf( "burst: %ld of %d datagrams received, minimum space: event queue %lu, RX ring %lu, TX ring %lu\n",
+		( long ) xReceived, testBURST, ( unsigned long ) uxGetMinimumIPQueueSpace(),
+		( unsigned long ) uxGetMinimumRxRingSpace(), ( unsigned long ) uxGetMinimumTxRingSpace() );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+const TickType_t xTimeOut = pdMS_TO_TICKS( 1000u );
+BaseType_t xTry;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	xAddress.sin_port = FreeRTOS_htons( testPORT );
+	FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) );
+
+	/* The first datagram may be replaced by an ARP request. */
+	for( xTry = 0; xTry < 3; xTry++ )
+	{
+		prvSend( 0 );
+
+		if( prvReceive() == 0 )
+		{
+			break;
+		}
+	}
+
+	testCHECK( xTry < 3 );
+
+	prvTestLostWakeUp();
+	prvTestBurst();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
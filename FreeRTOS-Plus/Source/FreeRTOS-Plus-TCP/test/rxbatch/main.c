@@ -0,0 +1,313 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the packet rate of the IP-task when a network interface passes
+ * the received packets one by one, or in batches with vNetworkRxBatchInit(),
+ * xNetworkRxBatchAdd() and xNetworkRxBatchSend().
+ *
+ * The network interface is simulated in this file.  Its task wakes up every
+ * clock tick, like after an interrupt, and delivers a burst of UDP packets,
+ * like when it drains its DMA descriptors.  An application task receives
+ * them with FreeRTOS_recvfrom() in zero-copy mode, and checks that every
+ * packet arrives once, in the right order.
+ *
+ * The program prints the messages that were sent to the IP-task per packet,
+ * and the run time of the interface task plus that of the IP-task per
+ * packet, in cycles of the time stamp counter on x86, or in ns on other
+ * hosts.  The run time of the application task is not counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#define rxbatchCOST_UNIT		"cycles"
+#else
+	#define rxbatchCOST_UNIT		"ns"
+#endif
+
+#define rxbatchPORT					( 5030u )
+#define rxbatchPAYLOAD_LENGTH		( 64u )
+#define rxbatchPACKET_LENGTH		( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER + rxbatchPAYLOAD_LENGTH )
+
+#ifndef rxbatchPACKETS
+	#define rxbatchPACKETS			( 200000ul )
+#endif
+
+/* The number of packets that the interface delivers per clock tick. */
+#define rxbatchBURST				( 32u )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t ucPeerMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x66 };
+
+/* Counted by iptraceNETWORK_INTERFACE_RX_BATCH(), see FreeRTOSIPConfig.h. */
+volatile uint32_t ulRxBatchMessages = 0ul;
+
+/* The messages that were sent to the IP-task one by one. */
+static uint32_t ulRxSingleMessages = 0ul;
+
+static uint32_t ulPacketsDelivered = 0ul;
+static uint32_t ulPacketsNotDelivered = 0ul;
+static uint32_t ulPacketsReceived = 0ul;
+static uint32_t ulPacketsOutOfOrder = 0ul;
+
+static TaskHandle_t xInterfaceTaskHandle = NULL;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define rxbatchCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+	/* Nothing is sent in this test, except for a gratuitous ARP. */
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkBufferDescriptor_t *prvMakePacket( uint32_t ulNumber )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+UDPPacket_t *pxPacket;
+
+	pxBuffer = pxGetNetworkBufferWithDescriptor( rxbatchPACKET_LENGTH, 0u );
+	if( pxBuffer != NULL )
+	{
+		memset( pxBuffer->pucEthernetBuffer, 0, rxbatchPACKET_LENGTH );
+		pxPacket = ( UDPPacket_t * ) pxBuffer->pucEthernetBuffer;
+
+		memcpy( pxPacket->xEthernetHeader.xDestinationAddress.ucBytes, ucMACAddress, sizeof( ucMACAddress ) );
+		memcpy( pxPacket->xEthernetHeader.xSourceAddress.ucBytes, ucPeerMACAddress, sizeof( ucPeerMACAddress ) );
+		pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+		pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+		pxPacket->xIPHeader.usLength = FreeRTOS_htons( rxbatchPACKET_LENGTH - ipSIZE_OF_ETH_HEADER );
+		pxPacket->xIPHeader.ucTimeToLive = ipconfigUDP_TIME_TO_LIVE;
+		pxPacket->xIPHeader.ucProtocol = ipPROTOCOL_UDP;
+		pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_inet_addr_quick( 192u, 168u, 1u, 20u );
+		pxPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_GetIPAddress();
+		pxPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxPacket->xIPHeader.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+		pxPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxPacket->xIPHeader.usHeaderChecksum );
+
+		pxPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( rxbatchPORT );
+		pxPacket->xUDPHeader.usDestinationPort = FreeRTOS_htons( rxbatchPORT );
+		pxPacket->xUDPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_UDP_HEADER + rxbatchPAYLOAD_LENGTH );
+
+		/* The payload starts with the number of the packet. */
+		memcpy( &( pxBuffer->pucEthernetBuffer[ rxbatchPACKET_LENGTH - rxbatchPAYLOAD_LENGTH ] ), &ulNumber, sizeof( ulNumber ) );
+
+		( void ) usGenerateProtocolChecksum( pxBuffer->pucEthernetBuffer, rxbatchPACKET_LENGTH, pdTRUE );
+	}
+
+	return pxBuffer;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterfaceTask( void *pvParameters )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+uint32_t ulCount;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkRxBatch_t xRxBatch;
+#else
+	IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+#endif
+
+	( void ) pvParameters;
+
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		vNetworkRxBatchInit( &xRxBatch );
+	}
+	#endif
+
+	/* Wait until the socket has been bound. */
+	( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+	while( ulPacketsDelivered + ulPacketsNotDelivered < rxbatchPACKETS )
+	{
+		/* Wait for the next 'interrupt'. */
+		vTaskDelay( 1u );
+
+		for( ulCount = 0u; ( ulCount < rxbatchBURST ) && ( ulPacketsDelivered + ulPacketsNotDelivered < rxbatchPACKETS ); ulCount++ )
+		{
+			pxBuffer = prvMakePacket( ulPacketsDelivered + ulPacketsNotDelivered );
+			if( pxBuffer == NULL )
+			{
+				ulPacketsNotDelivered++;
+				continue;
+			}
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* A failing batch releases its buffers and is counted by the
+				application as missing packets. */
+				( void ) xNetworkRxBatchAdd( &xRxBatch, pxBuffer, 0u );
+			}
+			#else
+			{
+				xRxEvent.pvData = ( void * ) pxBuffer;
+				if( xSendEventStructToIPTask( &xRxEvent, 0u ) == pdPASS )
+				{
+					ulRxSingleMessages++;
+				}
+				else
+				{
+					vReleaseNetworkBufferAndDescriptor( pxBuffer );
+				}
+			}
+			#endif
+			ulPacketsDelivered++;
+		}
+
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			( void ) xNetworkRxBatchSend( &xRxBatch, 0u );
+		}
+		#endif
+	}
+
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvApplicationTask( void *pvParameters )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+TickType_t xTimeOut = pdMS_TO_TICKS( 100u );
+uint64_t ullStart, ullCost;
+uint8_t *pucPayload;
+uint32_t ulNumber, ulExpected = 0ul;
+TaskHandle_t xIPTaskHandle;
+int32_t lLength;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	xAddress.sin_port = FreeRTOS_htons( rxbatchPORT );
+	rxbatchCHECK( FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	xIPTaskHandle = xTaskGetHandle( "IP-task" );
+	ullStart = ulTaskGetRunTimeCounter( xIPTaskHandle ) + ulTaskGetRunTimeCounter( xInterfaceTaskHandle );
+	xTaskNotifyGive( xInterfaceTaskHandle );
+
+	for( ;; )
+	{
+		lLength = FreeRTOS_recvfrom( xSocket, &pucPayload, 0, FREERTOS_ZERO_COPY, &xAddress, &xSize );
+		if( lLength <= 0 )
+		{
+			/* The interface has stopped. */
+			break;
+		}
+
+		rxbatchCHECK( lLength == ( int32_t ) rxbatchPAYLOAD_LENGTH );
+		memcpy( &ulNumber, pucPayload, sizeof( ulNumber ) );
+		if( ulNumber != ulExpected )
+		{
+			ulPacketsOutOfOrder++;
+		}
+		ulExpected = ulNumber + 1u;
+		ulPacketsReceived++;
+
+		FreeRTOS_ReleaseUDPPayloadBuffer( pucPayload );
+	}
+
+	ullCost = ulTaskGetRunTimeCounter( xIPTaskHandle ) + ulTaskGetRunTimeCounter( xInterfaceTaskHandle ) - ullStart;
+
+	rxbatchCHECK( ulPacketsDelivered == rxbatchPACKETS );
+	rxbatchCHECK( ulPacketsReceived == rxbatchPACKETS );
+	rxbatchCHECK( ulPacketsOutOfOrder == 0ul );
+
+	printf( "%lu packets, %lu messages to the IP-task, %.3f messages and %.1f " rxbatchCOST_UNIT " per packet\n",
+		( unsigned long ) ulPacketsReceived,
+		( unsigned long ) ( ulRxSingleMessages + ulRxBatchMessages ),
+		( double ) ( ulRxSingleMessages + ulRxBatchMessages ) / ( double ) rxbatchPACKETS,
+		( double ) ullCost / ( double ) rxbatchPACKETS );
+
+	FreeRTOS_closesocket( xSocket );
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+
+	/* The interface task runs above the IP-task, like the deferred interrupt
+	handler of a driver. */
+	xTaskCreate( prvInterfaceTask, "Interface", configMINIMAL_STACK_SIZE * 4, NULL, configMAX_PRIORITIES - 1, &xInterfaceTaskHandle );
+	xTaskCreate( prvApplicationTask, "Application", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,232 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A reordering stress test and benchmark of the TCP receive window.
+ * FreeRTOS_TCP_WIN.c is included in this file.
+ *
+ * Many connections receive segments in a heavily shuffled order: most arrive
+ * up to 300 segments ahead of the first missing byte, a few are duplicates
+ * of older data, and some are longer than one MSS.  Every result of
+ * lTCPWindowRxCheck(), the expected sequence number and the SACK option are
+ * folded into a digest, which must be the same with and without
+ * ipconfigUSE_TCP_RX_SEGMENT_TREE (see the Makefile).  With the tree, its
+ * order, balance and heights are checked after every segment, and it must
+ * hold the same segments as xRxSegments.
+ *
+ * Reported are the CPU cycles per segment, see ullHostRunTimeCounter(), and
+ * the average number of segments that the window holds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../FreeRTOS_TCP_WIN.c"
+
+#define rxwindowCONNECTIONS		( 200 )
+#define rxwindowSEGMENTS		( 3000 )
+#define rxwindowMSS				( 1000u )
+#define rxwindowWINDOW			( 1000000ul )
+
+/* The farthest a segment may arrive ahead of the first missing byte. */
+#define rxwindowMAX_AHEAD		( 300u )
+
+static uint32_t ulRandomState = 0x2545f491ul;
+
+static uint64_t ullCycles = 0u;
+static unsigned long ulSegments = 0ul;
+static unsigned long ulStoredTotal = 0ul;
+static uint32_t ulDigest = 0ul;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define rxwindowCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDigest( uint32_t ulValue )
+{
+	/* FNV-1a, one word at a time. */
+	ulDigest = ( ulDigest ^ ulValue ) * 16777619ul;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+
+	/* Returns the height of the subtree, or -1 when it is not a valid AVL
+	tree with all sequence numbers after ulLow (when xHasLow) and before
+	ulHigh (when xHasHigh). */
+	static BaseType_t prvCheckTree( const TCPSegment_t *pxSegment, uint32_t ulLow, BaseType_t xHasLow,
+		uint32_t ulHigh, BaseType_t xHasHigh, UBaseType_t *puxCount )
+	{
+	BaseType_t xLeft, xRight, xHeight;
+
+		if( pxSegment == NULL )
+		{
+			return 0;
+		}
+
+		if( ( ( xHasLow != pdFALSE ) && ( xSequenceGreaterThan( pxSegment->ulSequenceNumber, ulLow ) == pdFALSE ) ) ||
+			( ( xHasHigh != pdFALSE ) && ( xSequenceLessThan( pxSegment->ulSequenceNumber, ulHigh ) == pdFALSE ) ) )
+		{
+			return -1;
+		}
+
+		( *puxCount )++;
+		xLeft = prvCheckTree( pxSegment->pxRxLeft, ulLow, xHasLow, pxSegment->ulSequenceNumber, pdTRUE, puxCount );
+		xRight = prvCheckTree( pxSegment->pxRxRight, pxSegment->ulSequenceNumber, pdTRUE, ulHigh, xHasHigh, puxCount );
+
+		if( ( xLeft < 0 ) || ( xRight < 0 ) || ( xLeft - xRight > 1 ) || ( xRight - xLeft > 1 ) )
+		{
+			return -1;
+		}
+
+		xHeight = ( ( xLeft > xRight ) ? xLeft : xRight ) + 1;
+
+		return ( pxSegment->xRxHeight == xHeight ) ? xHeight : -1;
+	}
+
+#endif /* ipconfigUSE_TCP_RX_SEGMENT_TREE */
+/*-----------------------------------------------------------*/
+
+static void prvCheckWindow( TCPWindow_t *pxWindow )
+{
+	#if( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 )
+	{
+	UBaseType_t uxCount = 0u;
+
+		rxwindowCHECK( prvCheckTree( pxWindow->pxRxTree, 0u, pdFALSE, 0u, pdFALSE, &uxCount ) >= 0 );
+		rxwindowCHECK( uxCount == listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ) );
+	}
+	#else
+	{
+		( void ) pxWindow;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunConnection( void )
+{
+static TCPWindow_t xWindow;
+uint32_t ulISN = prvRandom();
+uint32_t ulSequenceNumber, ulLength, ulChoice;
+int32_t lAhead;
+int32_t lResult;
+uint64_t ullStart;
+uint8_t ucIndex;
+int iSegment;
+
+	memset( &xWindow, 0, sizeof( xWindow ) );
+	vTCPWindowCreate( &xWindow, rxwindowWINDOW, rxwindowWINDOW / 10u, ulISN, 1u, rxwindowMSS );
+
+	for( iSegment = 0; iSegment < rxwindowSEGMENTS; iSegment++ )
+	{
+		ulChoice = prvRandom() % 10u;
+		if( ulChoice < 3u )
+		{
+			/* The expected segment. */
+			lAhead = 0;
+		}
+		else if( ulChoice < 9u )
+		{
+			lAhead = ( int32_t ) ( prvRandom() % rxwindowMAX_AHEAD );
+		}
+		else
+		{
+			/* A retransmission of data that was already received. */
+			lAhead = -( int32_t ) ( prvRandom() % 5u );
+		}
+
+		ulSequenceNumber = xWindow.rx.ulCurrentSequenceNumber + ( uint32_t ) ( lAhead * ( int32_t ) rxwindowMSS );
+		ulLength = rxwindowMSS;
+		if( ( prvRandom() % 20u ) == 0u )
+		{
+			ulLength *= 1u + ( prvRandom() % 3u );
+		}
+
+		ullStart = ullHostRunTimeCounter();
+		lResult = lTCPWindowRxCheck( &xWindow, ulSequenceNumber, ulLength, rxwindowWINDOW - ( rxwindowWINDOW / 5u ) );
+		ullCycles += ullHostRunTimeCounter() - ullStart;
+		ulSegments++;
+		ulStoredTotal += ( unsigned long ) listCURRENT_LIST_LENGTH( &( xWindow.xRxSegments ) );
+
+		prvDigest( ( uint32_t ) lResult );
+		prvDigest( xWindow.rx.ulCurrentSequenceNumber - ulISN );
+		prvDigest( xWindow.ulUserDataLength );
+		prvDigest( xWindow.ucOptionLength );
+		for( ucIndex = 0u; ucIndex < xWindow.ucOptionLength / sizeof( uint32_t ); ucIndex++ )
+		{
+			prvDigest( xWindow.ulOptionsData[ ucIndex ] );
+		}
+
+		prvCheckWindow( &xWindow );
+	}
+
+	vTCPWindowDestroy( &xWindow );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+int iConnection;
+
+	for( iConnection = 0; iConnection < rxwindowCONNECTIONS; iConnection++ )
+	{
+		prvRunConnection();
+	}
+
+	/* All segment descriptors are free again. */
+	rxwindowCHECK( listCURRENT_LIST_LENGTH( &xSegmentList ) == ipconfigTCP_WIN_SEG_COUNT );
+
+	printf( "%s: %lu segments, %lu stored on average, %lu cycles per segment\n",
+		( ipconfigUSE_TCP_RX_SEGMENT_TREE != 0 ) ? "tree" : "list", ulSegments,
+		ulStoredTotal / ulSegments, ( unsigned long ) ( ullCycles / ulSegments ) );
+	printf( "digest: %08lx\n", ( unsigned long ) ulDigest );
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
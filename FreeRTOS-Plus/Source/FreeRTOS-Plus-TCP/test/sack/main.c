@@ -0,0 +1,257 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Checks the SACK blocks of the TCP window.  FreeRTOS_TCP_WIN.c is included
+ * in this file.
+ *
+ * Receive side: segments arrive in a shuffled order, with and without
+ * time-stamps.  Every SACK option must have 1 to 4 blocks (3 with
+ * time-stamps), all blocks must lie beyond the first missing byte, must be
+ * covered by stored segments and may not overlap.  When a segment was
+ * stored out of order, the first block must contain it (RFC 2018).
+ *
+ * Transmit side: 10 segments are outstanding and 3 SACK blocks leave 4
+ * holes.  All holes must be retransmitted after a single call to
+ * ulTCPWindowTxSackComplete(), and only once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../FreeRTOS_TCP_WIN.c"
+
+#define sackCONNECTIONS		( 100 )
+#define sackSEGMENTS		( 3000 )
+#define sackMSS				( 1000u )
+
+static uint32_t ulRandomState = 0x9e3779b9ul;
+
+/* The number of SACK options with 1 to ipTCP_MAX_SACK_BLOCKS blocks. */
+static unsigned long ulBlockCounts[ ipTCP_MAX_SACK_BLOCKS + 1 ];
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define sackCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns pdTRUE when the stored segments cover [ulFirst, ulLast). */
+static BaseType_t prvIsCovered( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast )
+{
+TCPSegment_t *pxSegment;
+
+	while( xSequenceLessThan( ulFirst, ulLast ) != pdFALSE )
+	{
+		pxSegment = xTCPWindowRxFind( pxWindow, ulFirst );
+		if( pxSegment == NULL )
+		{
+			return pdFALSE;
+		}
+		ulFirst += ( uint32_t ) pxSegment->lDataLength;
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckOption( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, int32_t lResult )
+{
+const uint8_t *pucOption = ( const uint8_t * ) pxWindow->ulOptionsData;
+BaseType_t xBlocks, xIndex, xOther;
+uint32_t ulFirst, ulLast, ulOtherFirst, ulOtherLast;
+
+	if( pxWindow->ucOptionLength == 0u )
+	{
+		/* Without SACK, the segment must have been in order or rejected. */
+		sackCHECK( lResult <= 0 );
+		return;
+	}
+
+	xBlocks = ( BaseType_t ) ( ( pxWindow->ucOptionLength - 4u ) / 8u );
+	sackCHECK( ( xBlocks >= 1 ) && ( xBlocks <= ( BaseType_t ) winSACK_MAX_BLOCKS( pxWindow ) ) );
+	sackCHECK( pxWindow->ucOptionLength == 4u + ( 8u * ( uint32_t ) xBlocks ) );
+	/* NOP, NOP, SACK (kind 5) and the length of the SACK option. */
+	sackCHECK( ( pucOption[ 0 ] == 1u ) && ( pucOption[ 1 ] == 1u ) && ( pucOption[ 2 ] == 5u ) );
+	sackCHECK( pucOption[ 3 ] == 2u + ( 8u * ( uint32_t ) xBlocks ) );
+
+	if( ( xBlocks < 1 ) || ( xBlocks > ipTCP_MAX_SACK_BLOCKS ) )
+	{
+		return;
+	}
+
+	ulBlockCounts[ xBlocks ]++;
+
+	for( xIndex = 0; xIndex < xBlocks; xIndex++ )
+	{
+		ulFirst = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 1 + ( 2 * xIndex ) ] );
+		ulLast = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 2 + ( 2 * xIndex ) ] );
+
+		sackCHECK( xSequenceLessThan( pxWindow->rx.ulCurrentSequenceNumber, ulFirst ) != pdFALSE );
+		sackCHECK( xSequenceLessThan( ulFirst, ulLast ) != pdFALSE );
+		sackCHECK( prvIsCovered( pxWindow, ulFirst, ulLast ) != pdFALSE );
+
+		for( xOther = 0; xOther < xIndex; xOther++ )
+		{
+			ulOtherFirst = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 1 + ( 2 * xOther ) ] );
+			ulOtherLast = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 2 + ( 2 * xOther ) ] );
+			sackCHECK( ( xSequenceLessThan( ulFirst, ulOtherLast ) == pdFALSE ) ||
+				( xSequenceLessThan( ulOtherFirst, ulLast ) == pdFALSE ) );
+		}
+	}
+
+	if( lResult > 0 )
+	{
+		ulFirst = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 1 ] );
+		ulLast = FreeRTOS_ntohl( pxWindow->ulOptionsData[ 2 ] );
+		sackCHECK( ( xSequenceLessThanOrEqual( ulFirst, ulSequenceNumber ) != pdFALSE ) &&
+			( xSequenceLessThan( ulSequenceNumber, ulLast ) != pdFALSE ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestReceive( BaseType_t xTimeStamps )
+{
+static TCPWindow_t xWindow;
+uint32_t ulSequenceNumber, ulChoice;
+int32_t lAhead, lResult;
+int iConnection, iSegment;
+
+	for( iConnection = 0; iConnection < sackCONNECTIONS; iConnection++ )
+	{
+		memset( &xWindow, 0, sizeof( xWindow ) );
+		vTCPWindowCreate( &xWindow, 1000000ul, 100000ul, prvRandom(), 1u, sackMSS );
+		xWindow.u.bits.bTimeStamps = ( xTimeStamps != pdFALSE ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+
+		for( iSegment = 0; iSegment < sackSEGMENTS; iSegment++ )
+		{
+			ulChoice = prvRandom() % 10u;
+			if( ulChoice < 3u )
+			{
+				lAhead = 0;
+			}
+			else if( ulChoice < 9u )
+			{
+				lAhead = ( int32_t ) ( prvRandom() % 60u );
+			}
+			else
+			{
+				lAhead = -( int32_t ) ( prvRandom() % 5u );
+			}
+
+			ulSequenceNumber = xWindow.rx.ulCurrentSequenceNumber + ( uint32_t ) ( lAhead * ( int32_t ) sackMSS );
+			lResult = lTCPWindowRxCheck( &xWindow, ulSequenceNumber, sackMSS, 400000ul );
+			prvCheckOption( &xWindow, ulSequenceNumber, lResult );
+		}
+
+		vTCPWindowDestroy( &xWindow );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTransmit( void )
+{
+static TCPWindow_t xWindow;
+const uint32_t ulFirst = 1000u;
+uint32_t ulLength, ulIndex;
+int32_t lPosition;
+/* The holes that are left by the SACK blocks, relative to ulFirst. */
+static const int32_t lHoles[] = { 0, 1000, 3000, 6000 };
+
+	memset( &xWindow, 0, sizeof( xWindow ) );
+	vTCPWindowCreate( &xWindow, 100000ul, 100000ul, 1u, ulFirst, sackMSS );
+	( void ) lTCPWindowTxAdd( &xWindow, 10u * sackMSS, 0, 100000 );
+
+	for( ulIndex = 0u; ulIndex < 10u; ulIndex++ )
+	{
+		sackCHECK( ulTCPWindowTxGet( &xWindow, 100000ul, &lPosition ) == sackMSS );
+	}
+
+	/* Segments 2, 4 to 5, and 7 to 9 arrived. */
+	( void ) ulTCPWindowTxSack( &xWindow, ulFirst + 2000u, ulFirst + 3000u );
+	( void ) ulTCPWindowTxSack( &xWindow, ulFirst + 4000u, ulFirst + 6000u );
+	( void ) ulTCPWindowTxSack( &xWindow, ulFirst + 7000u, ulFirst + 10000u );
+
+	sackCHECK( ulTCPWindowTxSackComplete( &xWindow ) == 4u );
+	sackCHECK( xWindow.ulSackRecoveryCount == 1u );
+	sackCHECK( listCURRENT_LIST_LENGTH( &( xWindow.xPriorityQueue ) ) == 4u );
+
+	/* A hole is only retransmitted once, until it times out. */
+	sackCHECK( ulTCPWindowTxSackComplete( &xWindow ) == 0u );
+
+	for( ulIndex = 0u; ulIndex < sizeof( lHoles ) / sizeof( lHoles[ 0 ] ); ulIndex++ )
+	{
+		ulLength = ulTCPWindowTxGet( &xWindow, 100000ul, &lPosition );
+		sackCHECK( ulLength == sackMSS );
+		sackCHECK( lPosition == lHoles[ ulIndex ] );
+	}
+
+	sackCHECK( ulTCPWindowTxGet( &xWindow, 100000ul, &lPosition ) == 0u );
+
+	vTCPWindowDestroy( &xWindow );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+BaseType_t xBlocks;
+
+	prvTestReceive( pdFALSE );
+	prvTestReceive( pdTRUE );
+	prvTestTransmit();
+
+	/* All segment descriptors are free again. */
+	sackCHECK( listCURRENT_LIST_LENGTH( &xSegmentList ) == ipconfigTCP_WIN_SEG_COUNT );
+
+	printf( "SACK options with 1 to %d blocks:", ipTCP_MAX_SACK_BLOCKS );
+	for( xBlocks = 1; xBlocks <= ipTCP_MAX_SACK_BLOCKS; xBlocks++ )
+	{
+		printf( " %lu", ulBlockCounts[ xBlocks ] );
+	}
+	printf( "\n%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,361 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the CPU cost of sending TCP data in three ways:
+ *
+ *   send       FreeRTOS_send(): the data is copied into the TX stream.
+ *   sendv      FreeRTOS_sendv() with 4 elements per call, also copied.
+ *   reference  FreeRTOS_sendv() with FREERTOS_MSG_REFERENCE: the data is not
+ *              copied into the TX stream, but directly from the application
+ *              buffer into the packets (ipconfigTCP_TX_REFERENCES).
+ *
+ * A client and a sink server run in this process and talk over the loopback
+ * network interface, built without bandwidth limit or delay, so that the
+ * transfer only costs CPU time.  The cost is the run time of the client task,
+ * which copies the data into the TX stream, plus that of the IP-task, which
+ * copies it into the packets, see ulTaskGetRunTimeCounter().  It is reported
+ * in bytes per cycle of the time stamp counter on x86, or in bytes per ns on
+ * other hosts.  The run time of the sink, and the hand-over between the
+ * threads of the host kernel, are not counted.
+ *
+ * The sink checks every byte that arrives, and all buffers that were sent by
+ * reference must be returned as delivered.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#define sendvCOST_UNIT		"cycle"
+#else
+	#define sendvCOST_UNIT		"ns"
+#endif
+
+#define sendvPORT				( 5010u )
+
+#ifndef sendvTOTAL_BYTES
+	#define sendvTOTAL_BYTES	( 16u * 1024u * 1024u )
+#endif
+
+/* The number of bytes passed in one call, in sendvVECTOR_COUNT elements. */
+#define sendvCALL_BYTES			( 4u * ipconfigTCP_MSS )
+#define sendvVECTOR_COUNT		( 4 )
+
+/* The contents of the stream: byte 'n' has the value n % sendvPATTERN_PERIOD. */
+#define sendvPATTERN_PERIOD		( 251u )
+
+typedef enum
+{
+	eModeSend,
+	eModeSendv,
+	eModeReference,
+	eModeCount
+} SendMode_t;
+
+static const char *pcModeNames[ eModeCount ] = { "send", "sendv", "reference" };
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+/* The data to be sent, never changed after start-up, so that it can be sent
+by reference many times. */
+static uint8_t ucPattern[ sendvCALL_BYTES + sendvPATTERN_PERIOD ];
+
+/* The bytes returned by the FREERTOS_SO_TCP_TX_REF_HANDLER call-back. */
+static size_t uxReturnedBytes = 0u;
+static size_t uxUndeliveredBytes = 0u;
+
+/* Corrupted bytes seen by the sink. */
+static size_t uxSinkErrors = 0u;
+static size_t uxSinkBytes = 0u;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define sendvCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvCPUCount( void )
+{
+	return ulTaskGetRunTimeCounter( NULL ) + ulTaskGetRunTimeCounter( xTaskGetHandle( "IP-task" ) );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_TX_REFERENCES != 0 )
+
+	static void prvOnTxReference( Socket_t xSocket, const void *pvBuffer, size_t xLength, BaseType_t xDelivered )
+	{
+		( void ) xSocket;
+		( void ) pvBuffer;
+
+		uxReturnedBytes += xLength;
+		if( xDelivered == pdFALSE )
+		{
+			uxUndeliveredBytes += xLength;
+		}
+	}
+
+#endif /* ipconfigTCP_TX_REFERENCES */
+/*-----------------------------------------------------------*/
+
+static void prvSinkTask( void *pvParameters )
+{
+Socket_t xListener, xClient;
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+static uint8_t ucBuffer[ 8192 ];
+size_t uxReceived, uxIndex;
+BaseType_t xCount;
+
+	( void ) pvParameters;
+
+	xListener = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListener != FREERTOS_INVALID_SOCKET );
+	xAddress.sin_port = FreeRTOS_htons( sendvPORT );
+	FreeRTOS_bind( xListener, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListener, 2 );
+
+	for( ;; )
+	{
+		xClient = FreeRTOS_accept( xListener, &xAddress, &xSize );
+		if( ( xClient == NULL ) || ( xClient == FREERTOS_INVALID_SOCKET ) )
+		{
+			continue;
+		}
+
+		uxReceived = 0u;
+		for( ;; )
+		{
+			xCount = FreeRTOS_recv( xClient, ucBuffer, sizeof( ucBuffer ), 0 );
+			if( xCount < 0 )
+			{
+				break;
+			}
+
+			for( uxIndex = 0u; uxIndex < ( size_t ) xCount; uxIndex++ )
+			{
+				if( ucBuffer[ uxIndex ] != ( uint8_t ) ( ( uxReceived + uxIndex ) % sendvPATTERN_PERIOD ) )
+				{
+					uxSinkErrors++;
+				}
+			}
+			uxReceived += ( size_t ) xCount;
+		}
+
+		uxSinkBytes = uxReceived;
+		FreeRTOS_closesocket( xClient );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( Socket_t xSocket, SendMode_t eMode, size_t uxOffset, size_t uxLength )
+{
+FreeRTOS_iovec_t xVector[ sendvVECTOR_COUNT ];
+const uint8_t *pucData = &( ucPattern[ uxOffset % sendvPATTERN_PERIOD ] );
+size_t uxPart = uxLength / sendvVECTOR_COUNT;
+BaseType_t xIndex, xFlags = 0;
+
+	if( eMode == eModeSend )
+	{
+		return FreeRTOS_send( xSocket, pucData, uxLength, 0 );
+	}
+
+	for( xIndex = 0; xIndex < sendvVECTOR_COUNT; xIndex++ )
+	{
+		xVector[ xIndex ].pvBase = pucData + ( ( size_t ) xIndex * uxPart );
+		xVector[ xIndex ].uxLength = ( xIndex < sendvVECTOR_COUNT - 1 ) ? uxPart : uxLength - ( ( size_t ) xIndex * uxPart );
+	}
+
+	#if( ipconfigTCP_TX_REFERENCES != 0 )
+	{
+		if( eMode == eModeReference )
+		{
+			xFlags = FREERTOS_MSG_REFERENCE;
+		}
+	}
+	#endif
+
+	return FreeRTOS_sendv( xSocket, xVector, sendvVECTOR_COUNT, xFlags );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunMode( SendMode_t eMode )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+TickType_t xTimeOut = pdMS_TO_TICKS( 10000u );
+size_t uxSent = 0u, uxLength;
+uint64_t ullStart, ullSendStart, ullSendCost, ullCost;
+TickType_t xStartTime, xTime;
+BaseType_t xResult;
+uint8_t ucByte;
+
+	uxReturnedBytes = 0u;
+	uxUndeliveredBytes = 0u;
+	uxSinkErrors = 0u;
+	uxSinkBytes = 0u;
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+	#if( ipconfigTCP_TX_REFERENCES != 0 )
+	{
+	F_TCP_UDP_Handler_t xHandler;
+
+		memset( &xHandler, 0, sizeof( xHandler ) );
+		xHandler.pxOnTCPTxReference = prvOnTxReference;
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_TCP_TX_REF_HANDLER, &xHandler, sizeof( xHandler ) );
+	}
+	#endif
+
+	xAddress.sin_addr = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
+	xAddress.sin_port = FreeRTOS_htons( sendvPORT );
+	sendvCHECK( FreeRTOS_connect( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	xStartTime = xTaskGetTickCount();
+	ullStart = prvCPUCount();
+	ullSendCost = 0u;
+
+	while( uxSent < sendvTOTAL_BYTES )
+	{
+		uxLength = sendvTOTAL_BYTES - uxSent;
+		if( uxLength > sendvCALL_BYTES )
+		{
+			uxLength = sendvCALL_BYTES;
+		}
+
+		ullSendStart = ulTaskGetRunTimeCounter( NULL );
+		xResult = prvSend( xSocket, eMode, uxSent, uxLength );
+		ullSendCost += ulTaskGetRunTimeCounter( NULL ) - ullSendStart;
+
+		if( xResult <= 0 )
+		{
+			break;
+		}
+		uxSent += ( size_t ) xResult;
+	}
+
+	/* The transfer is complete when the peer has acknowledged all data and
+	has closed the connection. */
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+	while( FreeRTOS_recv( xSocket, &ucByte, 1, 0 ) >= 0 )
+	{
+	}
+
+	ullCost = prvCPUCount() - ullStart;
+	xTime = xTaskGetTickCount() - xStartTime;
+	FreeRTOS_closesocket( xSocket );
+
+	/* Let the sink close its socket. */
+	vTaskDelay( pdMS_TO_TICKS( 100u ) );
+
+	sendvCHECK( uxSent == sendvTOTAL_BYTES );
+	sendvCHECK( uxSinkBytes == sendvTOTAL_BYTES );
+	sendvCHECK( uxSinkErrors == 0u );
+	if( eMode == eModeReference )
+	{
+		sendvCHECK( uxReturnedBytes == sendvTOTAL_BYTES );
+		sendvCHECK( uxUndeliveredBytes == 0u );
+	}
+
+	/* The first figure is the whole cost of sending, the second only the
+	part of it that the client task spends inside the API calls. */
+	printf( "%-10s %lu bytes in %lu ms, %.3f bytes per " sendvCOST_UNIT ", %.3f in the calls\n", pcModeNames[ eMode ],
+		( unsigned long ) uxSent, ( unsigned long ) xTime,
+		( ullCost != 0u ) ? ( double ) uxSent / ( double ) ullCost : 0.0,
+		( ullSendCost != 0u ) ? ( double ) uxSent / ( double ) ullSendCost : 0.0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void *pvParameters )
+{
+SendMode_t eMode;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	for( eMode = eModeSend; eMode < eModeCount; eMode++ )
+	{
+		#if( ipconfigTCP_TX_REFERENCES == 0 )
+		{
+			if( eMode == eModeReference )
+			{
+				continue;
+			}
+		}
+		#endif
+
+		prvRunMode( eMode );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+size_t uxIndex;
+
+	for( uxIndex = 0u; uxIndex < sizeof( ucPattern ); uxIndex++ )
+	{
+		ucPattern[ uxIndex ] = ( uint8_t ) ( uxIndex % sendvPATTERN_PERIOD );
+	}
+
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvSinkTask, "Sink", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	xTaskCreate( prvClientTask, "Client", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,352 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the connections per second that a listening socket accepts while
+ * it receives a flood of SYNs, see ipconfigTCP_SYN_CACHE_SIZE and
+ * ipconfigTCP_SYN_COOKIES.
+ *
+ * A client connects to a server in the same process, over the loopback
+ * network interface, and closes the connection again, as often as it can.
+ * This is done for a while without flood, and then while a flood task
+ * injects SYNs from addresses that do not exist.  They come from random
+ * addresses outside the local subnet, through a gateway whose MAC address is
+ * not on the link, so the SYN+ACKs that the stack sends back are never
+ * answered.
+ *
+ * The program prints the connections per second with and without the flood,
+ * the connections that failed, and the counters of the listening sockets.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_ARP.h"
+#include "NetworkBufferManagement.h"
+
+#define synfloodPORT				( 7000u )
+#define synfloodBACKLOG				( 8 )
+
+/* The length of each phase of the test. */
+#ifndef synfloodPHASE_MS
+	#define synfloodPHASE_MS		( 3000u )
+#endif
+
+/* The number of SYNs that the flood task injects per clock tick. */
+#ifndef synfloodSYNS_PER_TICK
+	#define synfloodSYNS_PER_TICK	( 2u )
+#endif
+
+/* The time that a connect() or a close may take. */
+#define synfloodTIME_OUT_MS			( 1000u )
+
+#define synfloodSYN_LENGTH			( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 4u )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const MACAddress_t xGatewayMACAddress = { { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 } };
+
+static volatile BaseType_t xFlooding = pdFALSE;
+static uint32_t ulSynsInjected = 0ul;
+static uint32_t ulSynsNotInjected = 0ul;
+
+static uint32_t ulRandomState = 0x6b43a9b5ul;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define synfloodCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* xorshift32: the same sequence on every host. */
+	ulRandomState ^= ulRandomState << 13;
+	ulRandomState ^= ulRandomState >> 17;
+	ulRandomState ^= ulRandomState << 5;
+
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInjectSyn( void )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+TCPPacket_t *pxPacket;
+IPStackEvent_t xRxEvent;
+uint32_t ulRandom = prvRandom();
+
+	pxBuffer = pxGetNetworkBufferWithDescriptor( synfloodSYN_LENGTH, 0u );
+	if( pxBuffer == NULL )
+	{
+		ulSynsNotInjected++;
+		return;
+	}
+
+	memset( pxBuffer->pucEthernetBuffer, 0, synfloodSYN_LENGTH );
+	pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+
+	memcpy( pxPacket->xEthernetHeader.xDestinationAddress.ucBytes, ucMACAddress, sizeof( ucMACAddress ) );
+	memcpy( pxPacket->xEthernetHeader.xSourceAddress.ucBytes, xGatewayMACAddress.ucBytes, sizeof( xGatewayMACAddress ) );
+	pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+
+	pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+	pxPacket->xIPHeader.usLength = FreeRTOS_htons( synfloodSYN_LENGTH - ipSIZE_OF_ETH_HEADER );
+	pxPacket->xIPHeader.ucTimeToLive = ipconfigTCP_TIME_TO_LIVE;
+	pxPacket->xIPHeader.ucProtocol = ipPROTOCOL_TCP;
+	pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_inet_addr_quick( 10u, ( uint8_t ) ( ulRandom >> 24 ), ( uint8_t ) ( ulRandom >> 16 ), ( uint8_t ) ( 1u + ( ulRandom % 254u ) ) );
+	pxPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_GetIPAddress();
+	pxPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxPacket->xIPHeader.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+	pxPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxPacket->xIPHeader.usHeaderChecksum );
+
+	pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( ( uint16_t ) ( 1024u + ( ( ulRandom >> 8 ) % 60000u ) ) );
+	pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( synfloodPORT );
+	pxPacket->xTCPHeader.ulSequenceNumber = prvRandom();
+	pxPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ( ipSIZE_OF_TCP_HEADER + 4u ) / 4u ) << 4 );
+	pxPacket->xTCPHeader.ucTCPFlags = 0x02u;	/* SYN */
+	pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 8192u );
+
+	/* MSS option. */
+	pxPacket->xTCPHeader.ucOptdata[ 0 ] = 2u;
+	pxPacket->xTCPHeader.ucOptdata[ 1 ] = 4u;
+	pxPacket->xTCPHeader.ucOptdata[ 2 ] = ( uint8_t ) ( ipconfigTCP_MSS >> 8 );
+	pxPacket->xTCPHeader.ucOptdata[ 3 ] = ( uint8_t ) ( ipconfigTCP_MSS & 0xffu );
+
+	( void ) usGenerateProtocolChecksum( pxBuffer->pucEthernetBuffer, synfloodSYN_LENGTH, pdTRUE );
+
+	xRxEvent.eEventType = eNetworkRxEvent;
+	xRxEvent.pvData = ( void * ) pxBuffer;
+
+	if( xSendEventStructToIPTask( &xRxEvent, 0u ) == pdPASS )
+	{
+		ulSynsInjected++;
+	}
+	else
+	{
+		ulSynsNotInjected++;
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFloodTask( void *pvParameters )
+{
+UBaseType_t uxCount;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		if( xFlooding != pdFALSE )
+		{
+			for( uxCount = 0u; uxCount < synfloodSYNS_PER_TICK; uxCount++ )
+			{
+				prvInjectSyn();
+			}
+		}
+
+		vTaskDelay( 1u );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvClose( Socket_t xSocket )
+{
+char cDummy[ 16 ];
+
+	/* FreeRTOS_recv() returns a negative value once the peer has closed the
+	connection as well, or after the time-out. */
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+	while( FreeRTOS_recv( xSocket, cDummy, sizeof( cDummy ), 0 ) >= 0 )
+	{
+	}
+
+	FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvServerTask( void *pvParameters )
+{
+Socket_t xListener, xClient;
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+const TickType_t xTimeOut = pdMS_TO_TICKS( synfloodTIME_OUT_MS );
+char cDummy[ 16 ];
+
+	( void ) pvParameters;
+
+	xListener = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListener != FREERTOS_INVALID_SOCKET );
+	memset( &xAddress, 0, sizeof( xAddress ) );
+	xAddress.sin_port = FreeRTOS_htons( synfloodPORT );
+	FreeRTOS_bind( xListener, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListener, synfloodBACKLOG );
+
+	for( ;; )
+	{
+		xClient = FreeRTOS_accept( xListener, &xAddress, &xSize );
+		if( ( xClient == NULL ) || ( xClient == FREERTOS_INVALID_SOCKET ) )
+		{
+			continue;
+		}
+
+		/* Wait until the client closes the connection. */
+		FreeRTOS_setsockopt( xClient, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		while( FreeRTOS_recv( xClient, cDummy, sizeof( cDummy ), 0 ) >= 0 )
+		{
+		}
+
+		prvClose( xClient );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Connect and close as often as possible during one phase.  Returns the
+number of connections per second, and counts the failed attempts. */
+static uint32_t prvConnectionPhase( uint32_t *pulFailed )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+const TickType_t xTimeOut = pdMS_TO_TICKS( synfloodTIME_OUT_MS );
+TickType_t xStart = xTaskGetTickCount();
+uint32_t ulCount = 0ul;
+
+	*pulFailed = 0ul;
+
+	while( ( xTaskGetTickCount() - xStart ) < pdMS_TO_TICKS( synfloodPHASE_MS ) )
+	{
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			( *pulFailed )++;
+			vTaskDelay( pdMS_TO_TICKS( 10u ) );
+			continue;
+		}
+
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		xAddress.sin_addr = FreeRTOS_GetIPAddress();
+		xAddress.sin_port = FreeRTOS_htons( synfloodPORT );
+
+		if( FreeRTOS_connect( xSocket, &xAddress, sizeof( xAddress ) ) == 0 )
+		{
+			ulCount++;
+			prvClose( xSocket );
+		}
+		else
+		{
+			( *pulFailed )++;
+			FreeRTOS_closesocket( xSocket );
+		}
+	}
+
+	return ( uint32_t ) ( ( ( uint64_t ) ulCount * 1000u ) / synfloodPHASE_MS );
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void *pvParameters )
+{
+uint32_t ulQuietRate, ulFloodRate, ulQuietFailed, ulFloodFailed;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	/* The gateway does not exist, the SYN+ACKs to it are lost. */
+	vARPRefreshCacheEntry( &xGatewayMACAddress, FreeRTOS_inet_addr_quick( ucGatewayAddress[ 0 ], ucGatewayAddress[ 1 ], ucGatewayAddress[ 2 ], ucGatewayAddress[ 3 ] ) );
+
+	ulQuietRate = prvConnectionPhase( &ulQuietFailed );
+
+	xFlooding = pdTRUE;
+	ulFloodRate = prvConnectionPhase( &ulFloodFailed );
+	xFlooding = pdFALSE;
+
+	printf( "without flood: %lu connections per second, %lu failed\n", ( unsigned long ) ulQuietRate, ( unsigned long ) ulQuietFailed );
+	printf( "with flood:    %lu connections per second, %lu failed, %lu SYNs injected (%lu per second), %lu not injected\n",
+		( unsigned long ) ulFloodRate, ( unsigned long ) ulFloodFailed, ( unsigned long ) ulSynsInjected,
+		( unsigned long ) ( ( ( uint64_t ) ulSynsInjected * 1000u ) / synfloodPHASE_MS ), ( unsigned long ) ulSynsNotInjected );
+
+	#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	{
+	TCPListenStatistics_t xStatistics;
+
+		FreeRTOS_GetTCPListenStatistics( &xStatistics );
+		printf( "listen:        %lu SYNs, %lu dropped, %lu evicted, %lu cookies sent, %lu accepted, %lu connections\n",
+			( unsigned long ) xStatistics.ulSynReceived, ( unsigned long ) xStatistics.ulSynDropped,
+			( unsigned long ) xStatistics.ulSynEvictions, ( unsigned long ) xStatistics.ulCookiesSent,
+			( unsigned long ) xStatistics.ulCookiesAccepted, ( unsigned long ) xStatistics.ulConnections );
+	}
+	#endif
+
+	synfloodCHECK( ulQuietFailed == 0ul );
+	synfloodCHECK( ulQuietRate > 0ul );
+
+	#if( ipconfigTCP_SYN_CACHE_SIZE != 0 )
+	{
+		/* The flood may not stop the real clients.  Without the SYN cache,
+		it does: the backlog is full of half-open connections. */
+		synfloodCHECK( ulFloodFailed == 0ul );
+		synfloodCHECK( ulFloodRate >= ulQuietRate / 2u );
+	}
+	#endif
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvServerTask, "Server", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	xTaskCreate( prvClientTask, "Client", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	xTaskCreate( prvFloodTask, "Flood", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,197 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Tests the TCP timer wheel (ipconfigUSE_TCP_TIMER_WHEEL) over the loopback
+ * network interface.  A TCP connection is made to the own address.
+ *
+ * A user task asks the IP-task for attention for a socket while the event
+ * queue of the IP-task is full, so the eTCPTimerEvent can not be queued.  Only
+ * sockets that are stored in the timer wheel get checked, but the IP-task must
+ * still find the socket:
+ *
+ * prvTestSend(): data passed to FreeRTOS_send() must be sent.
+ *
+ * prvTestShutdown(): FreeRTOS_shutdown() must close the connection.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+
+#define testPORT			( 7000u )
+
+/* Much longer than the time that the tests need. */
+#define testTIME_OUT_MS		( 5000u )
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+static Socket_t xClient, xChild;
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define testCHECK( x )													\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFillEventQueue( void )
+{
+const IPStackEvent_t xEvent = { eNoEvent, NULL };
+BaseType_t xQueued = 0;
+
+	/* Let the connection become idle first: the sockets are not in the timer
+	wheel for a time-out that is about to expire. */
+	vTaskDelay( pdMS_TO_TICKS( 100u ) );
+
+	/* The IP-task has a lower priority, it won't run before this task
+	blocks. */
+	while( xSendEventStructToIPTask( &xEvent, 0 ) == pdPASS )
+	{
+		xQueued++;
+	}
+
+	return xQueued;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestSend( void )
+{
+static const char pcMessage[] = "timer wheel";
+char pcBuffer[ sizeof( pcMessage ) ];
+TickType_t xStartTime;
+BaseType_t xQueued, xReceived;
+
+	xQueued = prvFillEventQueue();
+	testCHECK( xQueued > 0 );
+
+	testCHECK( FreeRTOS_send( xClient, pcMessage, sizeof( pcMessage ), 0 ) == ( BaseType_t ) sizeof( pcMessage ) );
+
+	/* The data is sent at once, not after a time-out. */
+	xStartTime = xTaskGetTickCount();
+	xReceived = FreeRTOS_recv( xChild, pcBuffer, sizeof( pcBuffer ), 0 );
+	testCHECK( xReceived == ( BaseType_t ) sizeof( pcMessage ) );
+	testCHECK( memcmp( pcBuffer, pcMessage, sizeof( pcMessage ) ) == 0 );
+	testCHECK( ( xTaskGetTickCount() - xStartTime ) < pdMS_TO_TICKS( 10u * niLOOPBACK_DELAY_MS ) );
+
+	printf( "send: %ld events queued, %ld bytes received after %lu ms\n",
+		( long ) xQueued, ( long ) xReceived, ( unsigned long ) ( xTaskGetTickCount() - xStartTime ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestShutdown( void )
+{
+char cByte;
+TickType_t xStartTime;
+BaseType_t xQueued, xResult;
+
+	xQueued = prvFillEventQueue();
+	testCHECK( xQueued > 0 );
+
+	testCHECK( FreeRTOS_shutdown( xClient, FREERTOS_SHUT_RDWR ) == 0 );
+
+	/* The FIN is sent at once, not after a time-out. */
+	xStartTime = xTaskGetTickCount();
+	xResult = FreeRTOS_recv( xChild, &cByte, sizeof( cByte ), 0 );
+	testCHECK( xResult == -pdFREERTOS_ERRNO_ENOTCONN );
+	testCHECK( ( xTaskGetTickCount() - xStartTime ) < pdMS_TO_TICKS( 10u * niLOOPBACK_DELAY_MS ) );
+
+	printf( "shutdown: %ld events queued, recv() returned %ld after %lu ms\n",
+		( long ) xQueued, ( long ) xResult, ( unsigned long ) ( xTaskGetTickCount() - xStartTime ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+const TickType_t xTimeOut = pdMS_TO_TICKS( testTIME_OUT_MS );
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+Socket_t xServer;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	xAddress.sin_port = FreeRTOS_htons( testPORT );
+
+	xServer = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xServer != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xServer, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	FreeRTOS_bind( xServer, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xServer, 1 );
+
+	xClient = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xClient != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xClient, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	FreeRTOS_setsockopt( xClient, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	testCHECK( FreeRTOS_connect( xClient, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	xChild = FreeRTOS_accept( xServer, &xAddress, &xSize );
+	testCHECK( ( xChild != NULL ) && ( xChild != FREERTOS_INVALID_SOCKET ) );
+
+	if( iFailures == 0 )
+	{
+		FreeRTOS_setsockopt( xChild, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		prvTestSend();
+		prvTestShutdown();
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
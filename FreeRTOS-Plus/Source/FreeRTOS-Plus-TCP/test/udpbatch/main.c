@@ -0,0 +1,316 @@
+/*
+ * FreeRTOS+TCP V2.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Measures the CPU cost of sending and receiving UDP datagrams one by one,
+ * with FreeRTOS_sendto() and FreeRTOS_recvfrom(), and in batches of 1 to 32
+ * datagrams, with FreeRTOS_sendmmsg() and FreeRTOS_recvmmsg().
+ *
+ * A single task sends rounds of 32 datagrams of 64 bytes to a socket of its
+ * own, over the loopback network interface without bandwidth limit or delay,
+ * and then receives them.  Every datagram must arrive once, in order.  The
+ * cost is the run time of this task, the IP-task and the loopback task,
+ * see ulTaskGetRunTimeCounter().  It is printed per datagram, in cycles of
+ * the time stamp counter on x86 or in ns on other hosts, and converted to
+ * datagrams per second of CPU time.  The lowest of 3 measurements is taken,
+ * to filter out the noise of the host.  The calls per datagram show how many
+ * datagrams FreeRTOS_recvmmsg() found at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#define udpbatchCOST_UNIT		"cycles"
+#else
+	#define udpbatchCOST_UNIT		"ns"
+#endif
+
+#define udpbatchPORT				( 5040u )
+#define udpbatchPAYLOAD_LENGTH		( 64u )
+#define udpbatchROUND				( 32 )
+
+#ifndef udpbatchROUNDS
+	#define udpbatchROUNDS			( 2000 )
+#endif
+
+/* Every mode is measured this many times, the lowest cost is printed. */
+#define udpbatchREPEATS				( 3 )
+
+typedef struct xUDP_BATCH_MODE
+{
+	const char *pcName;
+	BaseType_t xBatchSize;		/* 0: FreeRTOS_sendto() and FreeRTOS_recvfrom(). */
+} UDPBatchMode_t;
+
+static const UDPBatchMode_t xModes[] =
+{
+	{ "sendto/recvfrom", 0 },
+	{ "mmsg batch 1", 1 },
+	{ "mmsg batch 4", 4 },
+	{ "mmsg batch 8", 8 },
+	{ "mmsg batch 16", 16 },
+	{ "mmsg batch 32", 32 }
+};
+
+static const uint8_t ucIPAddress[ 4 ] = { 192, 168, 1, 10 };
+static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+static const uint8_t ucGatewayAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucDNSServerAddress[ 4 ] = { 192, 168, 1, 1 };
+static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+/* Counts of the run time counter per second. */
+static double dCountsPerSecond = 1.0e9;
+
+static int iFailures = 0;
+
+/*-----------------------------------------------------------*/
+
+#define udpbatchCHECK( x )												\
+	do {																\
+		if( !( x ) )													\
+		{																\
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x );	\
+			iFailures++;												\
+		}																\
+	} while( 0 )
+
+/*-----------------------------------------------------------*/
+
+static double prvCalibrate( void )
+{
+struct timespec xStart, xNow;
+uint64_t ullStart;
+double dSeconds;
+
+	clock_gettime( CLOCK_MONOTONIC, &xStart );
+	ullStart = ullHostRunTimeCounter();
+
+	do
+	{
+		clock_gettime( CLOCK_MONOTONIC, &xNow );
+		dSeconds = ( double ) ( xNow.tv_sec - xStart.tv_sec ) + ( ( double ) ( xNow.tv_nsec - xStart.tv_nsec ) / 1.0e9 );
+	} while( dSeconds < 0.05 );
+
+	return ( double ) ( ullHostRunTimeCounter() - ullStart ) / dSeconds;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvCPUCount( void )
+{
+	return ulTaskGetRunTimeCounter( NULL ) +
+		ulTaskGetRunTimeCounter( xTaskGetHandle( "IP-task" ) ) +
+		ulTaskGetRunTimeCounter( xTaskGetHandle( "Loopback" ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendRound( Socket_t xSocket, const UDPBatchMode_t *pxMode, uint32_t ulFirst )
+{
+static uint32_t ulPayloads[ udpbatchROUND ][ udpbatchPAYLOAD_LENGTH / sizeof( uint32_t ) ];
+FreeRTOS_mmsg_t xMessages[ udpbatchROUND ];
+struct freertos_sockaddr xAddress;
+BaseType_t xIndex, xSent, xResult;
+
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	xAddress.sin_port = FreeRTOS_htons( udpbatchPORT );
+
+	for( xIndex = 0; xIndex < udpbatchROUND; xIndex++ )
+	{
+		/* The payload starts with the number of the datagram. */
+		ulPayloads[ xIndex ][ 0 ] = ulFirst + ( uint32_t ) xIndex;
+		xMessages[ xIndex ].pvBuffer = ulPayloads[ xIndex ];
+		xMessages[ xIndex ].uxLength = udpbatchPAYLOAD_LENGTH;
+		xMessages[ xIndex ].xAddress = xAddress;
+	}
+
+	for( xSent = 0; xSent < udpbatchROUND; xSent += xResult )
+	{
+		if( pxMode->xBatchSize == 0 )
+		{
+			xResult = ( FreeRTOS_sendto( xSocket, ulPayloads[ xSent ], udpbatchPAYLOAD_LENGTH, 0, &xAddress, sizeof( xAddress ) ) > 0 ) ? 1 : 0;
+		}
+		else
+		{
+			xResult = FreeRTOS_sendmmsg( xSocket, &( xMessages[ xSent ] ), FreeRTOS_min_BaseType( pxMode->xBatchSize, udpbatchROUND - xSent ), 0 );
+		}
+
+		if( xResult <= 0 )
+		{
+			udpbatchCHECK( xResult > 0 );
+			break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the number of receive calls. */
+static uint32_t prvReceiveRound( Socket_t xSocket, const UDPBatchMode_t *pxMode, uint32_t *pulExpected )
+{
+static uint32_t ulPayloads[ udpbatchROUND ][ udpbatchPAYLOAD_LENGTH / sizeof( uint32_t ) ];
+FreeRTOS_mmsg_t xMessages[ udpbatchROUND ];
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+BaseType_t xIndex, xReceived, xResult;
+uint32_t ulCalls = 0u;
+
+	for( xReceived = 0; xReceived < udpbatchROUND; xReceived += xResult )
+	{
+		ulCalls++;
+
+		if( pxMode->xBatchSize == 0 )
+		{
+			xResult = ( FreeRTOS_recvfrom( xSocket, ulPayloads[ 0 ], udpbatchPAYLOAD_LENGTH, 0, &xAddress, &xSize ) == ( int32_t ) udpbatchPAYLOAD_LENGTH ) ? 1 : 0;
+		}
+		else
+		{
+			for( xIndex = 0; xIndex < pxMode->xBatchSize; xIndex++ )
+			{
+				xMessages[ xIndex ].pvBuffer = ulPayloads[ xIndex ];
+				xMessages[ xIndex ].uxLength = udpbatchPAYLOAD_LENGTH;
+			}
+
+			xResult = FreeRTOS_recvmmsg( xSocket, xMessages, FreeRTOS_min_BaseType( pxMode->xBatchSize, udpbatchROUND - xReceived ), 0 );
+		}
+
+		if( xResult <= 0 )
+		{
+			udpbatchCHECK( xResult > 0 );
+			break;
+		}
+
+		for( xIndex = 0; xIndex < xResult; xIndex++ )
+		{
+			if( pxMode->xBatchSize != 0 )
+			{
+				udpbatchCHECK( xMessages[ xIndex ].uxLength == udpbatchPAYLOAD_LENGTH );
+			}
+			udpbatchCHECK( ulPayloads[ xIndex ][ 0 ] == *pulExpected );
+			( *pulExpected )++;
+		}
+	}
+
+	return ulCalls;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunMode( Socket_t xSocket, const UDPBatchMode_t *pxMode )
+{
+uint64_t ullStart, ullCost, ullLowestCost = UINT64_MAX;
+uint32_t ulNext = 0u, ulExpected = 0u, ulCalls = 0u;
+BaseType_t xRepeat, xRound;
+double dCost;
+
+	for( xRepeat = 0; xRepeat < udpbatchREPEATS; xRepeat++ )
+	{
+		ullStart = prvCPUCount();
+
+		for( xRound = 0; xRound < udpbatchROUNDS; xRound++ )
+		{
+			prvSendRound( xSocket, pxMode, ulNext );
+			ulNext += udpbatchROUND;
+			ulCalls += prvReceiveRound( xSocket, pxMode, &ulExpected );
+		}
+
+		ullCost = prvCPUCount() - ullStart;
+		if( ullLowestCost > ullCost )
+		{
+			ullLowestCost = ullCost;
+		}
+	}
+
+	dCost = ( double ) ullLowestCost / ( double ) ( udpbatchROUNDS * udpbatchROUND );
+
+	udpbatchCHECK( ulExpected == ulNext );
+	printf( "%-16s %7.1f " udpbatchCOST_UNIT " per datagram, %8.0f datagrams/s, %.3f receive calls per datagram\n",
+		pxMode->pcName, dCost, dCountsPerSecond / dCost, ( double ) ulCalls / ( double ) ulNext );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTask( void *pvParameters )
+{
+Socket_t xSocket;
+struct freertos_sockaddr xAddress;
+TickType_t xTimeOut = pdMS_TO_TICKS( 1000u );
+size_t uxIndex;
+
+	( void ) pvParameters;
+
+	while( FreeRTOS_IsNetworkUp() == pdFALSE )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	}
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+	configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+	xAddress.sin_port = FreeRTOS_htons( udpbatchPORT );
+	udpbatchCHECK( FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) ) == 0 );
+
+	/* The first datagram to the own address is replaced by an ARP request,
+	after which the ARP cache has an entry for it. */
+	xAddress.sin_addr = FreeRTOS_GetIPAddress();
+	FreeRTOS_sendto( xSocket, &xAddress, sizeof( xAddress ), 0, &xAddress, sizeof( xAddress ) );
+	vTaskDelay( pdMS_TO_TICKS( 10u ) );
+	while( FreeRTOS_recvfrom( xSocket, &xAddress, sizeof( xAddress ), FREERTOS_MSG_DONTWAIT, NULL, NULL ) > 0 )
+	{
+	}
+
+	for( uxIndex = 0u; uxIndex < sizeof( xModes ) / sizeof( xModes[ 0 ] ); uxIndex++ )
+	{
+		prvRunMode( xSocket, &( xModes[ uxIndex ] ) );
+	}
+
+	FreeRTOS_closesocket( xSocket );
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	#if defined( __x86_64__ ) || defined( __i386__ )
+	{
+		dCountsPerSecond = prvCalibrate();
+	}
+	#endif
+
+	FreeRTOS_IPInit( ucIPAddress, ucNetMask, ucGatewayAddress, ucDNSServerAddress, ucMACAddress );
+	xTaskCreate( prvBenchmarkTask, "Benchmark", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL );
+	vTaskStartScheduler();
+
+	printf( "%s\n", ( iFailures == 0 ) ? "PASS" : "FAIL" );
+
+	return ( iFailures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/